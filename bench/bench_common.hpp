@@ -0,0 +1,62 @@
+#pragma once
+
+#include <tf/math/random.hpp>
+#include <tf/utils/memory.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Library calls are timed in real time: they run on the library's thread
+// pool, whose work the calling thread's CPU time does not include.
+
+namespace bench
+{
+  /**
+   * @brief Cache-line aligned array of random values in [-1, 1]
+   *
+   * Values are drawn once per buffer, outside the timed loops.
+   *
+   * @tparam T Element type
+   */
+  template <typename T>
+  class Buffer
+  {
+  public:
+    explicit Buffer(size_t size)
+        : m_data(new (std::align_val_t{tf::utils::DEFAULT_ALIGNMENT}) T[size > 0 ? size : 1]),
+          m_size(size)
+    {
+      tf::math::RandomGenerator::instance().fill_uniform(m_data.get(), size, T(-1), T(1));
+    }
+
+    T *data() { return m_data.get(); }
+    const T *data() const { return m_data.get(); }
+    size_t size() const { return m_size; }
+
+  private:
+    struct Deleter
+    {
+      void operator()(T *ptr) const { ::operator delete[](ptr, std::align_val_t{tf::utils::DEFAULT_ALIGNMENT}); }
+    };
+
+    std::unique_ptr<T[], Deleter> m_data;
+    size_t m_size;
+  };
+
+  /**
+   * @brief Counter of floating-point operations per second
+   *
+   * Reported with decimal prefixes, so 2 m n k per GEMM reads as G/s.
+   *
+   * @param per_iteration Operations of one iteration
+   * @return benchmark::Counter Rate counter
+   */
+  inline benchmark::Counter flops(double per_iteration)
+  {
+    return benchmark::Counter(per_iteration, benchmark::Counter::kIsIterationInvariantRate,
+                              benchmark::Counter::kIs1000);
+  }
+} // namespace bench
@@ -0,0 +1,25 @@
+#include <tf/core/config.hpp>
+#include <tf/core/cpu.hpp>
+#include <tf/math/blas.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+int main(int argc, char **argv)
+{
+  // Recorded in the JSON context, so that compare_bench.py can tell runs
+  // of different builds or hosts apart
+  const char *backend = tf::math::Blas::backend_name();
+  benchmark::AddCustomContext("tf_cpu_isa", tf::core::isa_name(tf::core::cpu_isa()));
+  benchmark::AddCustomContext("tf_blas_backend", backend ? backend : "builtin");
+  benchmark::AddCustomContext("tf_num_threads", std::to_string(tf::core::config().num_threads()));
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include "bench_common.hpp"
+
+#include <tf/utils/memory.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+using tf::utils::MemoryPool;
+using tf::utils::MemoryTracker;
+
+namespace bench
+{
+  namespace
+  {
+    constexpr size_t BATCH = 64; ///< Blocks held at once by each thread
+
+    /**
+     * @brief Pool shared by every thread of a run, so that threads contend
+     * for its free lists like the library's own users do
+     */
+    MemoryPool &shared_pool()
+    {
+      static MemoryPool pool(64 << 20);
+      return pool;
+    }
+
+    /**
+     * @brief Request sizes of a mixed workload, 64 bytes to 128 KB
+     */
+    std::array<size_t, BATCH> mixed_sizes()
+    {
+      std::array<size_t, BATCH> sizes{};
+      std::uint32_t state = 0x9e3779b9u;
+      for (size_t &size : sizes)
+      {
+        state = state * 1664525u + 1013904223u;
+        size = size_t{64} << ((state >> 24) % 12);
+      }
+      return sizes;
+    }
+
+    /**
+     * @brief Allocates and frees BATCH blocks of one size per iteration; the
+     * arg is the size in bytes
+     */
+    void BM_PoolFixed(benchmark::State &state)
+    {
+      MemoryPool &pool = shared_pool();
+      const size_t size = static_cast<size_t>(state.range(0));
+
+      std::array<void *, BATCH> blocks{};
+      for (auto _ : state)
+      {
+        for (void *&block : blocks)
+          block = pool.allocate(size);
+        benchmark::DoNotOptimize(blocks.data());
+        for (void *block : blocks)
+          pool.deallocate(block);
+      }
+
+      // One allocation and one deallocation per block
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 2 * BATCH));
+    }
+
+    void BM_PoolMixed(benchmark::State &state)
+    {
+      MemoryPool &pool = shared_pool();
+      const std::array<size_t, BATCH> sizes = mixed_sizes();
+
+      std::array<void *, BATCH> blocks{};
+      for (auto _ : state)
+      {
+        for (size_t i = 0; i < BATCH; ++i)
+          blocks[i] = pool.allocate(sizes[i]);
+        benchmark::DoNotOptimize(blocks.data());
+        for (void *block : blocks)
+          pool.deallocate(block);
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 2 * BATCH));
+    }
+
+    /**
+     * @brief The mixed workload on the system allocator, as a baseline
+     */
+    void BM_MallocMixed(benchmark::State &state)
+    {
+      const std::array<size_t, BATCH> sizes = mixed_sizes();
+
+      std::array<void *, BATCH> blocks{};
+      for (auto _ : state)
+      {
+        for (size_t i = 0; i < BATCH; ++i)
+          blocks[i] = std::malloc(sizes[i]);
+        benchmark::DoNotOptimize(blocks.data());
+        for (void *block : blocks)
+          std::free(block);
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 2 * BATCH));
+    }
+
+    /**
+     * @brief Tracks and releases BATCH allocations per iteration; the arg
+     * is the sample rate
+     *
+     * Pointers are never dereferenced, so each thread uses addresses of its
+     * own that no other thread tracks.
+     */
+    void BM_Tracker(benchmark::State &state)
+    {
+      MemoryTracker &tracker = MemoryTracker::instance();
+      if (state.thread_index() == 0)
+        tracker.set_sample_rate(static_cast<size_t>(state.range(0)));
+
+      const std::uintptr_t base = (static_cast<std::uintptr_t>(state.thread_index()) + 1) << 32;
+      const std::array<size_t, BATCH> sizes = mixed_sizes();
+
+      for (auto _ : state)
+      {
+        for (size_t i = 0; i < BATCH; ++i)
+          tracker.track_allocation(reinterpret_cast<void *>(base + i * 64), sizes[i]);
+        for (size_t i = 0; i < BATCH; ++i)
+          tracker.track_deallocation(reinterpret_cast<void *>(base + i * 64));
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 2 * BATCH));
+      if (state.thread_index() == 0)
+        tracker.set_sample_rate(1);
+    }
+  } // namespace
+
+  BENCHMARK(BM_PoolFixed)->Arg(64)->Arg(4096)->Arg(65536)->ThreadRange(1, 64)->UseRealTime();
+  BENCHMARK(BM_PoolMixed)->ThreadRange(1, 64)->UseRealTime();
+  BENCHMARK(BM_MallocMixed)->ThreadRange(1, 64)->UseRealTime();
+  BENCHMARK(BM_Tracker)->ArgName("sample_rate")->Arg(1)->Arg(64)->ThreadRange(1, 64)->UseRealTime();
+} // namespace bench
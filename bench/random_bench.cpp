@@ -0,0 +1,51 @@
+#include "bench_common.hpp"
+
+#include <tf/math/random.hpp>
+
+#include <cstdint>
+
+using tf::math::RandomGenerator;
+
+namespace bench
+{
+  namespace
+  {
+    template <typename T>
+    void BM_FillUniform(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      Buffer<T> out(n);
+      for (auto _ : state)
+      {
+        RandomGenerator::instance().fill_uniform(out.data(), n, T(-1), T(1));
+        benchmark::ClobberMemory();
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(n));
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(n * sizeof(T)));
+    }
+
+    template <typename T>
+    void BM_FillNormal(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      Buffer<T> out(n);
+      for (auto _ : state)
+      {
+        RandomGenerator::instance().fill_normal(out.data(), n, T(0), T(1));
+        benchmark::ClobberMemory();
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(n));
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(n * sizeof(T)));
+    }
+  } // namespace
+
+  BENCHMARK_TEMPLATE(BM_FillUniform, float)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_FillUniform, double)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_FillUniform, std::int32_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_FillNormal, float)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_FillNormal, double)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+} // namespace bench
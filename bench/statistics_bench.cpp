@@ -0,0 +1,81 @@
+#include "bench_common.hpp"
+
+#include <tf/math/utils.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    template <typename T>
+    void BM_Moments(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      Buffer<T> x(n);
+      for (auto _ : state)
+        benchmark::DoNotOptimize(tf::math::moments(x.data(), n));
+
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(n * sizeof(T)));
+    }
+
+    template <typename T>
+    void BM_CoMoments(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      Buffer<T> x(n), y(n);
+      for (auto _ : state)
+        benchmark::DoNotOptimize(tf::math::comoments(x.data(), y.data(), n));
+
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(2 * n * sizeof(T)));
+    }
+
+    /**
+     * @brief Moments of every column (arg 2 = 0) or every row (arg 2 = 1)
+     * of a rows x cols matrix
+     */
+    template <typename T>
+    void BM_AxisMoments(benchmark::State &state)
+    {
+      const size_t rows = static_cast<size_t>(state.range(0));
+      const size_t cols = static_cast<size_t>(state.range(1));
+      const bool along_rows = state.range(2) != 0;
+
+      Buffer<T> x(rows * cols);
+      std::vector<tf::math::Moments<T>> out(along_rows ? rows : cols);
+      for (auto _ : state)
+      {
+        if (along_rows)
+          tf::math::axis_moments(cols, 1, rows, cols, x.data(), out.data());
+        else
+          tf::math::axis_moments(rows, cols, cols, 1, x.data(), out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+      }
+
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                              static_cast<int64_t>(rows * cols * sizeof(T)));
+    }
+
+    void axis_shapes(benchmark::internal::Benchmark *b)
+    {
+      b->ArgNames({"rows", "cols", "last_axis"});
+      for (int64_t last_axis : {0, 1})
+      {
+        b->Args({4096, 64, last_axis});
+        b->Args({1024, 1024, last_axis});
+        b->Args({64, 4096, last_axis});
+      }
+    }
+  } // namespace
+
+  BENCHMARK_TEMPLATE(BM_Moments, float)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Moments, double)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_CoMoments, float)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_CoMoments, double)->RangeMultiplier(16)->Range(1 << 8, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_AxisMoments, float)->Apply(axis_shapes)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_AxisMoments, double)->Apply(axis_shapes)->UseRealTime();
+} // namespace bench
@@ -0,0 +1,157 @@
+#include "bench_common.hpp"
+
+#include <tf/math/blas.hpp>
+
+#include <cstdint>
+
+using tf::math::Blas;
+using tf::math::BlasOperation;
+
+namespace bench
+{
+  namespace
+  {
+    BlasOperation operation(int64_t transpose)
+    {
+      return transpose ? BlasOperation::Trans : BlasOperation::NoTrans;
+    }
+
+    /**
+     * @brief C = A B over row-major operands; args are m, n, k and whether
+     * A and B are transposed
+     */
+    template <typename T>
+    void BM_Gemm(benchmark::State &state)
+    {
+      const size_t m = static_cast<size_t>(state.range(0));
+      const size_t n = static_cast<size_t>(state.range(1));
+      const size_t k = static_cast<size_t>(state.range(2));
+      const BlasOperation transa = operation(state.range(3));
+      const BlasOperation transb = operation(state.range(4));
+
+      // Leading dimensions of the stored (possibly transposed) matrices
+      const size_t lda = transa == BlasOperation::NoTrans ? k : m;
+      const size_t ldb = transb == BlasOperation::NoTrans ? n : k;
+
+      Buffer<T> A(m * k), B(k * n), C(m * n);
+      for (auto _ : state)
+      {
+        Blas::gemm(transa, transb, m, n, k, T(1), A.data(), lda, B.data(), ldb, T(0), C.data(), n);
+        benchmark::DoNotOptimize(C.data());
+        benchmark::ClobberMemory();
+      }
+
+      state.counters["FLOP/s"] = flops(2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k));
+    }
+
+    void gemm_shapes(benchmark::internal::Benchmark *b)
+    {
+      b->ArgNames({"m", "n", "k", "ta", "tb"});
+
+      // Square problems in every transpose combination
+      for (int64_t size : {64, 128, 256, 512, 1024})
+        for (int64_t ta : {0, 1})
+          for (int64_t tb : {0, 1})
+            b->Args({size, size, size, ta, tb});
+
+      // Skinny shapes of dense layers: small batches, wide outputs, deep
+      // reductions
+      b->Args({16, 1024, 1024, 0, 0});
+      b->Args({1024, 16, 1024, 0, 0});
+      b->Args({64, 4096, 256, 0, 1});
+      b->Args({256, 256, 8192, 1, 0});
+    }
+
+    /**
+     * @brief y = A x; args are m and n
+     */
+    template <typename T>
+    void BM_Gemv(benchmark::State &state)
+    {
+      const size_t m = static_cast<size_t>(state.range(0));
+      const size_t n = static_cast<size_t>(state.range(1));
+
+      Buffer<T> A(m * n), x(n), y(m);
+      for (auto _ : state)
+      {
+        Blas::gemv(m, n, T(1), A.data(), n, x.data(), 1, T(0), y.data(), 1);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+      }
+
+      state.counters["FLOP/s"] = flops(2.0 * static_cast<double>(m) * static_cast<double>(n));
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                              static_cast<int64_t>((m * n + n + m) * sizeof(T)));
+    }
+
+    void gemv_shapes(benchmark::internal::Benchmark *b)
+    {
+      b->ArgNames({"m", "n"});
+      for (int64_t size : {256, 1024, 4096})
+        b->Args({size, size});
+      b->Args({16384, 256});
+      b->Args({256, 16384});
+    }
+
+    template <typename T>
+    void BM_Dot(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      Buffer<T> x(n), y(n);
+      for (auto _ : state)
+        benchmark::DoNotOptimize(Blas::dot(n, x.data(), 1, y.data(), 1));
+
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(2 * n * sizeof(T)));
+    }
+
+    template <typename T>
+    void BM_Axpy(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      // Alternating signs keep y bounded over millions of iterations
+      Buffer<T> x(n), y(n);
+      T alpha = T(0.5);
+      for (auto _ : state)
+      {
+        Blas::axpy(n, alpha, x.data(), 1, y.data(), 1);
+        alpha = -alpha;
+        benchmark::ClobberMemory();
+      }
+
+      // Reads x and y, writes y
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(3 * n * sizeof(T)));
+    }
+
+    template <typename T>
+    void BM_Scal(benchmark::State &state)
+    {
+      const size_t n = static_cast<size_t>(state.range(0));
+
+      // Scaling by -1 keeps the values unchanged in magnitude
+      Buffer<T> x(n);
+      for (auto _ : state)
+      {
+        Blas::scal(n, T(-1), x.data(), 1);
+        benchmark::ClobberMemory();
+      }
+
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(2 * n * sizeof(T)));
+    }
+  } // namespace
+
+  BENCHMARK_TEMPLATE(BM_Gemm, float)->Apply(gemm_shapes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+  BENCHMARK_TEMPLATE(BM_Gemm, double)->Apply(gemm_shapes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+  BENCHMARK_TEMPLATE(BM_Gemv, float)->Apply(gemv_shapes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+  BENCHMARK_TEMPLATE(BM_Gemv, double)->Apply(gemv_shapes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+  // From L1-resident to well past the last-level cache
+  BENCHMARK_TEMPLATE(BM_Dot, float)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Dot, double)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Axpy, float)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Axpy, double)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Scal, float)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+  BENCHMARK_TEMPLATE(BM_Scal, double)->RangeMultiplier(8)->Range(1 << 10, 1 << 24)->UseRealTime();
+} // namespace bench
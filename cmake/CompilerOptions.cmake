@@ -33,7 +33,6 @@ function(tf_set_compiler_options target)
             -Wno-unused-parameter
             -Wno-missing-field-initializers
             -fPIC
-            -march=native
         )
 
         if(TF_CUDA_SUPPORT)
@@ -2,6 +2,9 @@
 
 #include <tf/core/types.hpp>
 #include <tf/core/error.hpp>
+#include <tf/core/macros.hpp>
+#include <tf/utils/page_allocator.hpp>
+#include <tf/utils/arena.hpp>
 #include <cstddef>
 #include <vector>
 #include <string>
@@ -9,69 +12,126 @@
 #include <functional>
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <initializer_list>
 #include <numeric>
+#include <type_traits>
+#include <cstdint>
 
 namespace tf
 {
   namespace core
   {
+    /**
+     * @class Shape
+     * @brief Dimensions of a tensor
+     *
+     * Up to INLINE_RANK dimensions are stored inline, so building, copying
+     * and comparing the shapes of ordinary tensors never touches the heap;
+     * higher ranks spill to a heap array. The element count is computed
+     * once, when the dimensions are set.
+     */
     class Shape
     {
     public:
       using value_type = index_t;
       using container_type = std::vector<value_type>;
-      using iterator = container_type::iterator;
-      using const_iterator = container_type::const_iterator;
+      using iterator = const value_type *;
+      using const_iterator = const value_type *;
+
+      /**
+       * @brief Largest rank stored without a heap allocation
+       */
+      static constexpr size_t INLINE_RANK = 8;
 
       Shape() = default;
-      Shape(std::initializer_list<value_type> dims) : m_dims(dims) {}
-      explicit Shape(const container_type &dims) : m_dims(dims) {}
+      Shape(std::initializer_list<value_type> dims) { assign(dims.begin(), dims.size()); }
+      explicit Shape(const container_type &dims) { assign(dims.data(), dims.size()); }
 
-      // Access
       /**
-       * @brief Operator [] to access the shape dimensions
+       * @brief Constructs a shape from a range of dimensions
        *
-       * @param idx Index of the dimension
-       * @return value_type Dimension value
+       * @param dims First dimension
+       * @param rank Number of dimensions
        */
-      value_type &operator[](size_t idx) { return m_dims[idx]; }
+      Shape(const value_type *dims, size_t rank) { assign(dims, rank); }
+
+      Shape(const Shape &other) { assign(other.data(), other.m_rank); }
 
+      Shape(Shape &&other) noexcept
+          : m_heap(std::move(other.m_heap)), m_rank(other.m_rank), m_count(other.m_count)
+      {
+        std::copy_n(other.m_inline, INLINE_RANK, m_inline);
+        other.m_rank = 0;
+        other.m_count = 1;
+      }
+
+      Shape &operator=(const Shape &other)
+      {
+        if (this != &other)
+          assign(other.data(), other.m_rank);
+        return *this;
+      }
+
+      Shape &operator=(Shape &&other) noexcept
+      {
+        if (this != &other)
+        {
+          m_heap = std::move(other.m_heap);
+          std::copy_n(other.m_inline, INLINE_RANK, m_inline);
+          m_rank = other.m_rank;
+          m_count = other.m_count;
+          other.m_rank = 0;
+          other.m_count = 1;
+        }
+        return *this;
+      }
+
+      // Access
       /**
        * @brief Operator [] to access the shape dimensions
        *
        * @param idx Index of the dimension
        * @return value_type Dimension value
        */
-      const value_type &operator[](size_t idx) const { return m_dims[idx]; }
+      const value_type &operator[](size_t idx) const { return data()[idx]; }
 
-      // Iterators
       /**
-       * @brief Get the begin iterator of the shape dimensions
+       * @brief Sets one dimension
        *
-       * @return const_iterator Begin iterator
+       * Dimensions are only changed through here, so the cached element
+       * count stays valid.
+       *
+       * @param idx Index of the dimension
+       * @param value New dimension value
        */
-      iterator begin() { return m_dims.begin(); }
+      void set(size_t idx, value_type value)
+      {
+        data()[idx] = value;
+        m_count = product(data(), m_rank);
+      }
 
       /**
-       * @brief Get the end iterator of the shape dimensions
+       * @brief Gets the dimensions as a vector
        *
-       * @return const_iterator End iterator
+       * @return container_type Copy of the dimensions
        */
-      iterator end() { return m_dims.end(); }
+      container_type dims() const { return container_type(begin(), end()); }
 
+      // Iterators
       /**
        * @brief Get the begin iterator of the shape dimensions
        *
        * @return const_iterator Begin iterator
        */
-      const_iterator begin() const { return m_dims.begin(); }
+      const_iterator begin() const { return data(); }
 
       /**
        * @brief Get the end iterator of the shape dimensions
        *
        * @return const_iterator End iterator
        */
-      const_iterator end() const { return m_dims.end(); }
+      const_iterator end() const { return data() + m_rank; }
 
       // Properties
       /**
@@ -79,26 +139,21 @@ namespace tf
        *
        * @return size_t Number of dimensions
        */
-      size_t rank() const { return m_dims.size(); }
+      size_t rank() const { return m_rank; }
 
       /**
        * @brief Returns true if the shape is empty
        *
        * @return true If the shape is empty, false otherwise
        */
-      bool empty() const { return m_dims.empty(); }
+      bool empty() const { return m_rank == 0; }
 
       /**
        * @brief Get the total number of elements in the shape
        *
-       * @return size_t Total number of elements
+       * @return size_t Total number of elements (cached)
        */
-      value_type num_elements() const
-      {
-        return std::accumulate(m_dims.begin(), m_dims.end(),
-                               value_type{1},
-                               std::multiplies<value_type>());
-      }
+      value_type num_elements() const { return m_count; }
 
       /**
        * @brief String representation of the shape
@@ -107,19 +162,17 @@ namespace tf
        */
       std::string to_string() const
       {
-        std::ostringstream oss;
-
-        oss << "(";
-        for (size_t i = 0; i < m_dims.size(); ++i)
+        std::string result = "(";
+        for (size_t i = 0; i < m_rank; ++i)
         {
           if (i > 0)
-            oss << ", ";
+            result += ", ";
 
-          oss << m_dims[i];
+          result += std::to_string(data()[i]);
         }
 
-        oss << ")";
-        return oss.str();
+        result += ")";
+        return result;
       }
 
       // Comparison
@@ -131,7 +184,8 @@ namespace tf
        */
       bool operator==(const Shape &other) const
       {
-        return m_dims == other.m_dims;
+        return m_rank == other.m_rank && m_count == other.m_count &&
+               std::equal(begin(), end(), other.begin());
       }
 
       /**
@@ -157,25 +211,199 @@ namespace tf
         if (rank() > other.rank())
           return false;
 
-        auto it1 = m_dims.rbegin();
-        auto it2 = other.m_dims.rbegin();
-
-        while (it1 != m_dims.rend() && it2 != other.m_dims.rend())
+        const size_t lead = other.rank() - rank();
+        for (size_t i = 0; i < rank(); ++i)
         {
-          if (*it1 != 1 && *it1 != *it2)
+          const value_type dim = (*this)[i];
+          if (dim != 1 && dim != other[lead + i])
             return false;
+        }
+
+        return true;
+      }
+
+    private:
+      value_type m_inline[INLINE_RANK] = {};
+      std::unique_ptr<value_type[]> m_heap;
+      size_t m_rank = 0;
+      value_type m_count = 1;
 
-          ++it1;
-          ++it2;
+      value_type *data() { return m_heap ? m_heap.get() : m_inline; }
+      const value_type *data() const { return m_heap ? m_heap.get() : m_inline; }
+
+      static value_type product(const value_type *dims, size_t rank)
+      {
+        value_type count = 1;
+        for (size_t i = 0; i < rank; ++i)
+          count *= dims[i];
+        return count;
+      }
+
+      void assign(const value_type *dims, size_t rank)
+      {
+        if (rank > INLINE_RANK)
+        {
+          // Copy first: dims may point into the current heap array
+          std::unique_ptr<value_type[]> heap(new value_type[rank]);
+          std::copy_n(dims, rank, heap.get());
+          m_heap = std::move(heap);
+        }
+        else
+        {
+          std::copy_n(dims, rank, m_inline);
+          m_heap.reset();
         }
 
+        m_rank = rank;
+        m_count = product(data(), rank);
+      }
+    };
+
+    /**
+     * @class StaticShape
+     * @brief Shape whose rank is known at compile time
+     *
+     * A plain array of N dimensions: everything is constexpr, and loops
+     * over the dimensions unroll. Converts to Shape where a dynamic shape
+     * is needed.
+     *
+     * @tparam N Rank
+     */
+    template <size_t N>
+    class StaticShape
+    {
+    public:
+      using value_type = index_t;
+      using const_iterator = const value_type *;
+
+      constexpr StaticShape() = default;
+
+      /**
+       * @brief Constructs a shape from its N dimensions
+       *
+       * @param dims Dimensions
+       */
+      template <typename... Dims>
+        requires(sizeof...(Dims) == N && (std::is_integral_v<Dims> && ...))
+      constexpr StaticShape(Dims... dims) : m_dims{static_cast<value_type>(dims)...} {}
+
+      constexpr value_type operator[](size_t idx) const { return m_dims[idx]; }
+      constexpr value_type &operator[](size_t idx) { return m_dims[idx]; }
+
+      constexpr const_iterator begin() const { return m_dims; }
+      constexpr const_iterator end() const { return m_dims + N; }
+
+      static constexpr size_t rank() { return N; }
+
+      /**
+       * @brief Get the total number of elements in the shape
+       *
+       * @return value_type Product of the dimensions
+       */
+      constexpr value_type num_elements() const
+      {
+        value_type count = 1;
+        for (size_t i = 0; i < N; ++i)
+          count *= m_dims[i];
+        return count;
+      }
+
+      /**
+       * @brief Gets the row-major strides
+       *
+       * @return std::array<value_type, N> Strides in elements
+       */
+      constexpr std::array<value_type, N> strides() const
+      {
+        std::array<value_type, N> result{};
+        value_type stride = 1;
+        for (size_t i = N; i-- > 0;)
+        {
+          result[i] = stride;
+          stride *= m_dims[i];
+        }
+        return result;
+      }
+
+      constexpr bool operator==(const StaticShape &other) const
+      {
+        for (size_t i = 0; i < N; ++i)
+          if (m_dims[i] != other.m_dims[i])
+            return false;
         return true;
       }
 
+      constexpr bool operator!=(const StaticShape &other) const { return !(*this == other); }
+
+      Shape to_shape() const { return Shape(m_dims, N); }
+      operator Shape() const { return to_shape(); }
+
+      std::string to_string() const { return to_shape().to_string(); }
+
     private:
-      container_type m_dims;
+      // One slot even for rank 0, so the array is never zero-sized
+      value_type m_dims[N > 0 ? N : 1] = {};
     };
 
+    /**
+     * @brief Computes the shape two shapes broadcast to
+     *
+     * Dimensions are matched from the last one; a dimension of 1, or a
+     * missing leading dimension, is repeated to match the other shape.
+     *
+     * @param a First shape
+     * @param b Second shape
+     * @return Shape Broadcast shape
+     * @throw ShapeError if the shapes are not compatible
+     */
+    inline Shape broadcast_shapes(const Shape &a, const Shape &b)
+    {
+      const size_t rank = std::max(a.rank(), b.rank());
+      Shape::container_type dims(rank);
+
+      for (size_t i = 0; i < rank; ++i)
+      {
+        const Shape::value_type da = i < a.rank() ? a[a.rank() - 1 - i] : 1;
+        const Shape::value_type db = i < b.rank() ? b[b.rank() - 1 - i] : 1;
+
+        TF_CHECK(da == db || da == 1 || db == 1, ShapeError,
+                 "Shapes " + a.to_string() + " and " + b.to_string() + " do not broadcast");
+        dims[rank - 1 - i] = da == 1 ? db : da;
+      }
+
+      return Shape(dims);
+    }
+
+    namespace detail
+    {
+      /**
+       * @brief Buffers at least this large bypass the cache when copied or
+       * filled (the size of the last-level cache)
+       *
+       * @return size_t Threshold in bytes
+       */
+      size_t streaming_threshold();
+
+      /**
+       * @brief Copies non-overlapping memory in parallel with streaming stores
+       *
+       * @param dst Destination
+       * @param src Source
+       * @param bytes Number of bytes
+       */
+      void stream_copy(void *dst, const void *src, size_t bytes);
+
+      /**
+       * @brief Fills memory in parallel with streaming stores
+       *
+       * @param dst Destination, aligned to value_size
+       * @param value Pattern of value_size bytes
+       * @param value_size Pattern size: 1, 2, 4, 8 or 16
+       * @param count Number of patterns to write
+       */
+      void stream_fill(void *dst, const void *value, size_t value_size, size_t count);
+    } // namespace detail
+
     template <typename T>
     class Memory
     {
@@ -183,35 +411,170 @@ namespace tf
       /**
        * @brief Allocates memory of a given size
        *
+       * Inside a utils::ArenaScope the memory (control block included) is
+       * bump-allocated from the scope's arena and must not outlive the
+       * scope.
+       *
        * @param size Size of the memory to allocate
        * @return std::shared_ptr<T[]> Shared pointer to the allocated memory
        */
       static std::shared_ptr<T[]> allocate(size_t size)
       {
+        TF_PROFILE_ALLOCATION(size * sizeof(T));
+        if (utils::Arena *arena = utils::current_arena())
+          return std::allocate_shared<T[]>(utils::ArenaAllocator<T>(*arena), size);
+
         return std::make_shared<T[]>(size);
       }
 
+      /**
+       * @brief Allocates memory of a given size with an allocation policy
+       *
+       * With a non-default policy the elements live in their own page
+       * mapping (huge pages, NUMA placement). Trivial types rely on the
+       * mapping being zero-filled and are not touched, so pages are placed
+       * by whichever thread first writes them. Such mappings never come
+       * from an ArenaScope.
+       *
+       * @param size Number of elements to allocate
+       * @param policy Page size and NUMA placement
+       * @return std::shared_ptr<T[]> Shared pointer to the allocated memory
+       */
+      static std::shared_ptr<T[]> allocate(size_t size, const utils::AllocationPolicy &policy)
+      {
+        if (policy.is_default())
+          return allocate(size);
+
+        TF_PROFILE_ALLOCATION(size * sizeof(T));
+        utils::PageAllocation pages = utils::allocate_pages(size * sizeof(T), policy);
+        T *data = static_cast<T *>(pages.ptr);
+
+        if constexpr (!std::is_trivially_default_constructible_v<T>)
+        {
+          try
+          {
+            std::uninitialized_value_construct_n(data, size);
+          }
+          catch (...)
+          {
+            utils::free_pages(pages);
+            throw;
+          }
+        }
+
+        return std::shared_ptr<T[]>(data, [pages, size](T *ptr)
+                                    {
+                                      std::destroy_n(ptr, size);
+                                      utils::free_pages(pages); });
+      }
+
+      /**
+       * @brief Allocates memory without initializing trivial elements
+       *
+       * Like std::make_shared_for_overwrite: trivially default-constructible
+       * elements are left indeterminate instead of zeroed, which saves a
+       * pass over buffers that are overwritten right away. Inside a
+       * utils::ArenaScope the memory comes from the scope's arena.
+       *
+       * @param size Number of elements to allocate
+       * @return std::shared_ptr<T[]> Shared pointer to the allocated memory
+       */
+      static std::shared_ptr<T[]> allocate_uninitialized(size_t size)
+      {
+        TF_PROFILE_ALLOCATION(size * sizeof(T));
+        if (utils::Arena *arena = utils::current_arena())
+          return std::allocate_shared_for_overwrite<T[]>(utils::ArenaAllocator<T>(*arena), size);
+
+        return std::make_shared_for_overwrite<T[]>(size);
+      }
+
+      /**
+       * @brief Allocates uninitialized memory from a memory pool
+       *
+       * The buffer is cache-line aligned and returned to the pool when the
+       * last reference goes away, so the pool must outlive it.
+       *
+       * @param size Number of elements to allocate
+       * @param pool Pool backing the buffer
+       * @return std::shared_ptr<T[]> Shared pointer to the allocated memory
+       */
+      static std::shared_ptr<T[]> allocate_uninitialized(size_t size, utils::MemoryPool &pool)
+      {
+        TF_PROFILE_ALLOCATION(size * sizeof(T));
+        T *data = static_cast<T *>(pool.allocate(std::max<size_t>(size * sizeof(T), 1),
+                                                 std::max(alignof(T), utils::CACHE_LINE_ALIGNMENT)));
+
+        if constexpr (!std::is_trivially_default_constructible_v<T>)
+        {
+          try
+          {
+            std::uninitialized_default_construct_n(data, size);
+          }
+          catch (...)
+          {
+            pool.deallocate(data);
+            throw;
+          }
+        }
+
+        return std::shared_ptr<T[]>(data, [&pool, size](T *ptr)
+                                    {
+                                      std::destroy_n(ptr, size);
+                                      pool.deallocate(ptr); });
+      }
+
       /**
        * @brief Copies memory from one location to another
        *
+       * Trivially copyable buffers larger than the last-level cache are
+       * copied in parallel with streaming stores, which do not evict the
+       * working set and skip reading the destination.
+       *
        * @param dst Destination memory location
        * @param src Source memory location
        * @param size Size of the memory to copy
        */
       static void copy(T *dst, const T *src, size_t size)
       {
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+          const size_t bytes = size * sizeof(T);
+          const std::uintptr_t d = reinterpret_cast<std::uintptr_t>(dst);
+          const std::uintptr_t s = reinterpret_cast<std::uintptr_t>(src);
+          const bool overlap = d < s + bytes && s < d + bytes;
+
+          if (bytes >= detail::streaming_threshold() && !overlap)
+          {
+            detail::stream_copy(dst, src, bytes);
+            return;
+          }
+        }
+
         std::copy_n(src, size, dst);
       }
 
       /**
        * @brief Fills memory with a given value
        *
+       * Trivially copyable buffers larger than the last-level cache are
+       * filled in parallel with streaming stores.
+       *
        * @param ptr Memory location
        * @param size Size of the memory to fill
        * @param value Value to fill the memory with
        */
       static void fill(T *ptr, size_t size, const T &value)
       {
+        if constexpr (std::is_trivially_copyable_v<T> && 16 % sizeof(T) == 0)
+        {
+          if (size * sizeof(T) >= detail::streaming_threshold() &&
+              reinterpret_cast<std::uintptr_t>(ptr) % sizeof(T) == 0)
+          {
+            detail::stream_fill(ptr, &value, sizeof(T), size);
+            return;
+          }
+        }
+
         std::fill_n(ptr, size, value);
       }
     };
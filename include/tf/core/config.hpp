@@ -2,22 +2,320 @@
 
 #include <tf/core/types.hpp>
 #include <tf/core/error.hpp>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <iterator>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 namespace tf
 {
   namespace core
   {
-    // Forward declaration
-    class ConfigOption;
+    // Forward declarations
     class Configuration;
+    template <typename T>
+    class ConfigGuard;
+
+    namespace detail
+    {
+      /**
+       * @brief Whether an option of type T is stored in a lock-free atomic
+       */
+      template <typename T, typename = void>
+      struct lock_free_option : std::false_type
+      {
+      };
+
+      template <typename T>
+      struct lock_free_option<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+          : std::bool_constant<std::atomic<T>::is_always_lock_free>
+      {
+      };
+
+      /**
+       * @struct RcuReader
+       * @brief Read-side state of one thread, on its own cache line
+       *
+       * epoch is 0 while the thread reads no RcuCell, otherwise the global
+       * epoch at the start of its outermost read.
+       */
+      struct alignas(64) RcuReader
+      {
+        std::atomic<std::uint64_t> epoch{0};
+        std::uint32_t depth = 0; ///< Nested reads, touched by the owner only
+        bool in_use = true;      ///< Guarded by the registry's mutex
+      };
+
+      /**
+       * @brief Epoch of the next retirement; a reader that started in a later
+       * epoch can no longer see what was retired
+       */
+      inline std::atomic<std::uint64_t> rcu_epoch{1};
+      inline thread_local RcuReader *rcu_thread_reader = nullptr;
+
+      /**
+       * @brief Gives the calling thread a reader slot, reused after its
+       * thread exits
+       */
+      RcuReader &register_rcu_reader();
+
+      /**
+       * @brief Gets the oldest epoch an active reader started in
+       *
+       * @return std::uint64_t Smallest active epoch, UINT64_MAX without
+       * active readers
+       */
+      std::uint64_t oldest_rcu_reader();
+
+      /**
+       * @class RcuReadGuard
+       * @brief Marks the calling thread as reading RcuCells
+       */
+      class RcuReadGuard
+      {
+      public:
+        RcuReadGuard()
+            : m_reader(rcu_thread_reader ? *rcu_thread_reader : register_rcu_reader())
+        {
+          if (m_reader.depth++ == 0)
+            m_reader.epoch.store(rcu_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+
+        ~RcuReadGuard()
+        {
+          if (--m_reader.depth == 0)
+            m_reader.epoch.store(0, std::memory_order_release);
+        }
+
+        RcuReadGuard(const RcuReadGuard &) = delete;
+        RcuReadGuard &operator=(const RcuReadGuard &) = delete;
+
+      private:
+        RcuReader &m_reader;
+      };
+
+      /**
+       * @class RcuCell
+       * @brief Immutable value replaced by writers while readers use it
+       *
+       * Readers only publish their epoch in their own RcuReader and load the
+       * current version, so they never wait and never share a written cache
+       * line. A writer swaps in a new version and tags the old one with the
+       * epoch it retired in; it is freed by a later publish once every
+       * reader active at that moment started after it, so the retired list
+       * is bounded by the versions published during the longest read.
+       *
+       * @tparam T Type of the value
+       */
+      template <typename T>
+      class RcuCell
+      {
+      public:
+        explicit RcuCell(std::unique_ptr<const T> initial = nullptr)
+            : m_current(initial.release()) {}
+
+        ~RcuCell() { delete m_current.load(std::memory_order_relaxed); }
+
+        RcuCell(const RcuCell &) = delete;
+        RcuCell &operator=(const RcuCell &) = delete;
+
+        /**
+         * @brief Calls f with the current version, or nullptr if none
+         */
+        template <typename F>
+        decltype(auto) read(F &&f) const
+        {
+          RcuReadGuard guard;
+          return f(m_current.load(std::memory_order_seq_cst));
+        }
+
+        /**
+         * @brief Replaces the current version, freeing the retired versions
+         * no reader can still see
+         */
+        void publish(std::unique_ptr<const T> next)
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          if (const T *old = m_current.exchange(next.release(), std::memory_order_seq_cst))
+            m_retired.push_back({std::unique_ptr<const T>(old), rcu_epoch.fetch_add(1, std::memory_order_seq_cst)});
+
+          const std::uint64_t oldest = oldest_rcu_reader();
+          std::erase_if(m_retired, [oldest](const Retired &retired)
+                        { return retired.epoch < oldest; });
+        }
+
+        /**
+         * @brief Gets the number of replaced versions not yet freed
+         *
+         * @return size_t Retired versions
+         */
+        size_t retired() const
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          return m_retired.size();
+        }
+
+      private:
+        struct Retired
+        {
+          std::unique_ptr<const T> value;
+          std::uint64_t epoch;
+        };
+
+        std::atomic<const T *> m_current;
+        mutable std::mutex m_mutex;
+        std::vector<Retired> m_retired;
+      };
+
+      /**
+       * @class OptionSlotBase
+       * @brief Storage of one named option
+       *
+       * Slots are created on first use of their name and live as long as
+       * the configuration, so handles to them never dangle.
+       */
+      class OptionSlotBase
+      {
+      public:
+        OptionSlotBase(std::string name, std::type_index type)
+            : m_name(std::move(name)), m_type(type) {}
+        virtual ~OptionSlotBase() = default;
+
+        const std::string &name() const { return m_name; }
+        std::type_index type() const { return m_type; }
+
+      private:
+        std::string m_name;
+        std::type_index m_type;
+      };
+
+      /**
+       * @struct OptionOverride
+       * @brief Value of an option for the calling thread only, set by a
+       * ConfigGuard
+       */
+      struct OptionOverride
+      {
+        const OptionSlotBase *slot;
+        std::shared_ptr<const void> value;
+      };
+
+      // Overrides of the calling thread, innermost last; the count is read
+      // first so that threads without guards never touch the vector
+      inline thread_local size_t override_count = 0;
+      inline thread_local std::vector<OptionOverride> overrides;
+
+      /**
+       * @class OptionSlot
+       * @brief Storage of one named option of type T
+       *
+       * Small trivially copyable values live in a lock-free atomic, so a
+       * read is a plain load; other values live in an RcuCell, so a read
+       * never waits for a writer.
+       */
+      template <typename T>
+      class OptionSlot : public OptionSlotBase
+      {
+      public:
+        explicit OptionSlot(std::string name)
+            : OptionSlotBase(std::move(name), std::type_index(typeid(T))) {}
+
+        void store(const T &value)
+        {
+          if constexpr (lock_free_option<T>::value)
+            m_value.store(value, std::memory_order_relaxed);
+          else
+            m_value.publish(std::make_unique<const T>(value));
+          m_set.store(true, std::memory_order_release);
+        }
+
+        T load(const T &default_value) const
+        {
+          if (override_count > 0)
+            for (auto it = overrides.rbegin(); it != overrides.rend(); ++it)
+              if (it->slot == this)
+                return *static_cast<const T *>(it->value.get());
+
+          if (!m_set.load(std::memory_order_acquire))
+            return default_value;
+
+          if constexpr (lock_free_option<T>::value)
+            return m_value.load(std::memory_order_relaxed);
+          else
+            return m_value.read([](const T *value)
+                                { return *value; });
+        }
+
+        bool is_set() const { return m_set.load(std::memory_order_acquire); }
+
+      private:
+        std::conditional_t<lock_free_option<T>::value, std::atomic<T>, RcuCell<T>> m_value{};
+        std::atomic<bool> m_set{false};
+      };
+    } // namespace detail
+
+    /**
+     * @class OptionHandle
+     * @brief Named option resolved once, then read without hashing or
+     * locking
+     *
+     * @tparam T Type of the option
+     */
+    template <typename T>
+    class OptionHandle
+    {
+    public:
+      /**
+       * @brief Gets the value of the option
+       *
+       * @param default_value Value returned while the option is unset
+       * @return T The calling thread's ConfigGuard value if any, else the
+       * global value
+       */
+      T get(const T &default_value) const { return m_slot->load(default_value); }
+
+      /**
+       * @brief Sets the global value of the option
+       *
+       * @param value New value
+       */
+      void set(const T &value) const { m_slot->store(value); }
+
+      /**
+       * @brief Checks whether a global value was ever set
+       *
+       * @return bool True once set() or Configuration::set_option() ran
+       */
+      bool is_set() const { return m_slot->is_set(); }
+
+      const std::string &name() const { return m_slot->name(); }
+
+    private:
+      explicit OptionHandle(detail::OptionSlot<T> *slot) : m_slot(slot) {}
+
+      detail::OptionSlot<T> *m_slot;
+
+      friend class Configuration;
+      template <typename>
+      friend class ConfigGuard;
+    };
 
     /**
      * @class Configuration
      * @brief Global configuration singleton class
+     *
+     * Reads never lock: the built-in settings are atomics, and named
+     * options are found through an immutable index replaced whenever a new
+     * name appears. Only the first use of a name takes the mutex. Hot paths
+     * should still resolve an OptionHandle once instead of reading by name.
      */
     class Configuration
     {
@@ -41,8 +339,7 @@ namespace tf
        */
       void set_default_device(DeviceType device)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_default_device = device;
+        m_default_device.store(device, std::memory_order_relaxed);
       }
 
       /**
@@ -52,8 +349,7 @@ namespace tf
        */
       DeviceType default_device() const
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_default_device;
+        return m_default_device.load(std::memory_order_relaxed);
       }
 
       // Memory configuration
@@ -65,12 +361,10 @@ namespace tf
        */
       void set_memory_fraction(float fraction)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
         TF_CHECK(fraction > 0.0f && fraction <= 1.0f, ValueError,
                  "Memory fraction must be in the range (0, 1]");
 
-        m_memory_fraction = fraction;
+        m_memory_fraction.store(fraction, std::memory_order_relaxed);
       }
 
       /**
@@ -80,8 +374,7 @@ namespace tf
        */
       float memory_fraction() const
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_memory_fraction;
+        return m_memory_fraction.load(std::memory_order_relaxed);
       }
 
       // Threading configuration
@@ -93,12 +386,10 @@ namespace tf
        */
       void set_num_threads(int num_threads)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
         TF_CHECK(num_threads > 0, ValueError,
                  "Number of threads must be positive");
 
-        m_num_threads = num_threads;
+        m_num_threads.store(num_threads, std::memory_order_relaxed);
       }
 
       /**
@@ -108,8 +399,7 @@ namespace tf
        */
       int num_threads() const
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_num_threads;
+        return m_num_threads.load(std::memory_order_relaxed);
       }
 
       // Debug configuration
@@ -120,8 +410,7 @@ namespace tf
        */
       void set_debug_mode(bool debug_mode)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_debug_mode = debug_mode;
+        m_debug_mode.store(debug_mode, std::memory_order_relaxed);
       }
 
       /**
@@ -131,24 +420,36 @@ namespace tf
        */
       bool debug_mode() const
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_debug_mode;
+        return m_debug_mode.load(std::memory_order_relaxed);
       }
 
       // Custom options
+      /**
+       * @brief Gets a handle to a custom option, creating it unset
+       *
+       * @tparam T Type of the option
+       * @param name Name of the option
+       * @return OptionHandle<T> Handle, valid as long as the configuration
+       * @throw TypeError if the option exists with another type
+       */
+      template <typename T>
+      OptionHandle<T> option(const std::string &name)
+      {
+        return OptionHandle<T>(resolve<T>(name));
+      }
+
       /**
        * @brief Sets a custom option value by name
        *
        * @tparam T Type of the option
        * @param name Name of the option
-       * @param default_value Default value of the option
-       * @return T Value of the option
+       * @param value Value of the option
+       * @throw TypeError if the option exists with another type
        */
       template <typename T>
       void set_option(const std::string &name, const T &value)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_options[name] = std::make_shared<ConfigOptionsImpl<T>>(value);
+        resolve<T>(name)->store(value);
       }
 
       /**
@@ -158,60 +459,83 @@ namespace tf
        * @param name Name of the option
        * @param default_value Default value of the option
        * @return T Value of the option
+       * @throw TypeError if the option exists with another type
        */
       template <typename T>
       T get_option(const std::string &name, const T &default_value) const
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_options.find(name);
-
-        if (it == m_options.end())
+        detail::OptionSlotBase *slot = find(name);
+        if (!slot)
           return default_value;
 
-        auto option = std::dynamic_pointer_cast<ConfigOptionsImpl<T>>(it->second);
-        if (!option)
-          throw TypeError("Invalid option type");
-
-        return option->value();
+        return typed<T>(slot)->load(default_value);
       }
 
     private:
-      mutable std::mutex m_mutex;
-      DeviceType m_default_device;
-      float m_memory_fraction;
-      int m_num_threads;
-      bool m_debug_mode;
+      using OptionIndex = std::unordered_map<std::string, detail::OptionSlotBase *>;
+
+      std::atomic<DeviceType> m_default_device;
+      std::atomic<float> m_memory_fraction;
+      std::atomic<int> m_num_threads;
+      std::atomic<bool> m_debug_mode;
+
+      mutable std::mutex m_mutex; ///< Serializes new names
+      std::vector<std::unique_ptr<detail::OptionSlotBase>> m_slots;
+      detail::RcuCell<OptionIndex> m_index;
 
       // Constructor
       Configuration()
           : m_default_device(DeviceType::CPU), m_memory_fraction(0.9f),
-            m_num_threads(4), m_debug_mode(false) {}
+            m_num_threads(4), m_debug_mode(false),
+            m_index(std::make_unique<const OptionIndex>()) {}
 
       Configuration(const Configuration &) = delete;
       Configuration &operator=(const Configuration &) = delete;
       Configuration(Configuration &&) = delete;
       Configuration &operator=(Configuration &&) = delete;
 
-      // Base class for configuration options
-      class ConfigOption
+      detail::OptionSlotBase *find(const std::string &name) const
       {
-      public:
-        virtual ~ConfigOption() = default;
-      };
+        return m_index.read([&](const OptionIndex *index) -> detail::OptionSlotBase *
+                            {
+                              auto it = index->find(name);
+                              return it == index->end() ? nullptr : it->second; });
+      }
 
-      // Templated implementation for configuration options
       template <typename T>
-      class ConfigOptionsImpl : public ConfigOption
+      static detail::OptionSlot<T> *typed(detail::OptionSlotBase *slot)
       {
-      public:
-        explicit ConfigOptionsImpl(const T &value) : m_value(value) {}
-        T value() const { return m_value; }
+        if (slot->type() != std::type_index(typeid(T)))
+          throw TypeError("Invalid option type");
 
-      private:
-        T m_value;
-      };
+        return static_cast<detail::OptionSlot<T> *>(slot);
+      }
 
-      std::unordered_map<std::string, std::shared_ptr<ConfigOption>> m_options;
+      /**
+       * @brief Finds the slot of a name, publishing a new index with a new
+       * slot if there is none
+       */
+      template <typename T>
+      detail::OptionSlot<T> *resolve(const std::string &name)
+      {
+        if (detail::OptionSlotBase *slot = find(name))
+          return typed<T>(slot);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (detail::OptionSlotBase *slot = find(name))
+          return typed<T>(slot);
+
+        auto slot = std::make_unique<detail::OptionSlot<T>>(name);
+        detail::OptionSlot<T> *result = slot.get();
+
+        // Writers are serialized here, so the index read is the latest one
+        auto next = m_index.read([](const OptionIndex *index)
+                                 { return std::make_unique<OptionIndex>(*index); });
+        next->emplace(name, result);
+        m_slots.push_back(std::move(slot));
+        m_index.publish(std::move(next));
+        return result;
+      }
     };
 
     /**
@@ -226,38 +550,54 @@ namespace tf
 
     /**
      * @class ConfigGuard
-     * @brief RAII guard for configuration changes
+     * @brief RAII override of an option for the calling thread
+     *
+     * Other threads, including thread pool workers, keep seeing the global
+     * value. Guards nest; the innermost one on a thread wins.
      */
     template <typename T>
     class ConfigGuard
     {
     public:
+      /**
+       * @brief Overrides an option until the guard goes away
+       *
+       * @param name Name of the option
+       * @param value Value seen by the calling thread
+       * @throw TypeError if the option exists with another type
+       */
       ConfigGuard(const std::string &name, const T &value)
-          : m_name(name), m_old_value(config().get_option<T>(name, value))
+          : m_value(std::make_shared<const T>(value))
       {
-        config().set_option(name, value);
+        const OptionHandle<T> handle = config().option<T>(name);
+        detail::overrides.push_back({handle.m_slot, m_value});
+        ++detail::override_count;
       }
 
       ~ConfigGuard()
       {
-        try
-        {
-          config().set_option(m_name, m_old_value);
-        }
-        catch (...)
-        {
-        }
+        for (auto it = detail::overrides.rbegin(); it != detail::overrides.rend(); ++it)
+          if (it->value == m_value)
+          {
+            detail::overrides.erase(std::next(it).base());
+            --detail::override_count;
+            break;
+          }
       }
 
+      ConfigGuard(const ConfigGuard &) = delete;
+      ConfigGuard &operator=(const ConfigGuard &) = delete;
+
     private:
-      std::string m_name;
-      T m_old_value;
+      std::shared_ptr<const void> m_value;
     };
 
 // Macros
 #define TF_CONFIG Configuration::instance()
+#define TF_CONFIG_GUARD_NAME_IMPL(line) _config_guard_##line
+#define TF_CONFIG_GUARD_NAME(line) TF_CONFIG_GUARD_NAME_IMPL(line)
 #define TF_WITH_CONFIG(name, value) \
-  auto _config_guard##__LINE__ = ConfigGuard(name, value)
+  auto TF_CONFIG_GUARD_NAME(__LINE__) = ConfigGuard(name, value)
 
   } // namespace core
-} // namespace tf
\ No newline at end of file
+} // namespace tf
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+
+namespace tf
+{
+  namespace core
+  {
+    /**
+     * @enum CpuIsa
+     * @brief Instruction set levels that kernels are compiled for
+     */
+    enum class CpuIsa
+    {
+      Generic,
+      SSE4,
+      AVX2,
+      AVX512,
+      NEON
+    };
+
+    /**
+     * @struct CpuFeatures
+     * @brief Host CPU capabilities, detected once at startup
+     */
+    struct CpuFeatures
+    {
+      bool sse4_2 = false;
+      bool avx = false;
+      bool avx2 = false;
+      bool fma = false;
+      bool f16c = false;
+      bool avx512f = false;
+      bool avx512dq = false;
+      bool avx512bw = false;
+      bool avx512vl = false;
+      bool avx512_vnni = false;
+      bool avx512_bf16 = false;
+      bool amx_tile = false;
+      bool amx_bf16 = false;
+      bool amx_int8 = false;
+      bool neon = false;
+
+      size_t l1d_cache_size = 32 * 1024;
+      size_t l2_cache_size = 1024 * 1024;
+      size_t l3_cache_size = 8 * 1024 * 1024;
+    };
+
+    /**
+     * @brief Gets the features of the host CPU
+     *
+     * The CPU is queried (cpuid and OS register-state support) on first use
+     * and the result is cached for the lifetime of the process.
+     *
+     * @return const CpuFeatures& Detected CPU features
+     */
+    const CpuFeatures &cpu_features();
+
+    /**
+     * @brief Gets the instruction set used by dispatched kernels
+     *
+     * This is the widest ISA supported by the host. It can be lowered (never
+     * raised) by setting the TF_CPU_ISA environment variable to one of
+     * "generic", "sse4", "avx2" or "avx512" before the first kernel call.
+     *
+     * @return CpuIsa Selected instruction set
+     */
+    CpuIsa cpu_isa();
+
+    /**
+     * @brief Gets the name of an instruction set
+     *
+     * @param isa Instruction set
+     * @return const char* Lower-case name of the instruction set
+     */
+    const char *isa_name(CpuIsa isa);
+  } // namespace core
+} // namespace tf
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/tensor_view.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace tf
+{
+  namespace core
+  {
+    /**
+     * @brief CUDA devices, streams, device memory and host/device copies
+     *
+     * Everything here is declared in every build; without TF_USE_CUDA,
+     * available() is false and any call that needs a device throws
+     * DeviceError. CUDA types are kept out of the interface, so including
+     * this header never requires the CUDA toolkit.
+     */
+    namespace cuda
+    {
+      /**
+       * @brief Checks whether CUDA support is built in and a device is present
+       *
+       * @return bool True if at least one device can be used
+       */
+      bool available();
+
+      /**
+       * @brief Gets the number of CUDA devices
+       *
+       * @return int Number of devices, 0 without CUDA support
+       */
+      int device_count();
+
+      /**
+       * @brief Gets the device used by the calling thread
+       *
+       * @return int Device index
+       * @throw DeviceError if CUDA is not available
+       */
+      int current_device();
+
+      /**
+       * @brief Selects the device used by the calling thread
+       *
+       * @param device Device index
+       * @throw DeviceError if the device does not exist
+       */
+      void set_device(int device);
+
+      /**
+       * @brief Waits for all work queued on the current device
+       *
+       * @throw DeviceError if CUDA is not available or queued work failed
+       */
+      void synchronize();
+
+      /**
+       * @brief Checks whether a pointer refers to device memory
+       *
+       * @param ptr Pointer to check
+       * @return bool True for device (or managed) memory, false for host
+       * memory and without CUDA support
+       */
+      bool is_device_pointer(const void *ptr);
+
+      /**
+       * @class Stream
+       * @brief Queue of device work executed in order
+       *
+       * Copies and device GEMMs are queued on the calling thread's current
+       * stream (see current() and StreamGuard) and return before the device
+       * has finished; work on different streams may overlap.
+       */
+      class Stream
+      {
+      public:
+        /**
+         * @brief Creates a stream on the current device
+         *
+         * The stream does not synchronize with the legacy default stream.
+         *
+         * @throw DeviceError if CUDA is not available
+         */
+        Stream();
+
+        /**
+         * @brief Waits for the stream's work, then destroys it
+         *
+         * Waiting lets the allocator hand the stream's cached blocks to a
+         * later stream with the same handle.
+         */
+        ~Stream();
+
+        Stream(Stream &&other) noexcept;
+        Stream &operator=(Stream &&other) noexcept;
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        /**
+         * @brief Waits for all work queued on the stream
+         *
+         * @throw DeviceError if queued work failed
+         */
+        void synchronize() const;
+
+        /**
+         * @brief Checks whether all work queued on the stream has finished
+         *
+         * @return bool True if the stream is idle
+         */
+        bool query() const;
+
+        /**
+         * @brief Gets the stream used by the calling thread
+         *
+         * @return Stream& Stream set by the innermost StreamGuard, or the
+         * thread's per-thread default stream
+         */
+        static Stream &current();
+
+        // Properties
+        void *handle() const { return m_handle; } ///< cudaStream_t
+        int device() const;                       ///< The current device for a per-thread stream
+
+      private:
+        struct PerThread
+        {
+        };
+        explicit Stream(PerThread);
+
+        /**
+         * @brief Identifies the stream among live streams, for the caching
+         * allocator; every per-thread stream has the same handle
+         */
+        const void *order_key() const { return m_owned ? m_handle : static_cast<const void *>(this); }
+
+        void *m_handle = nullptr;
+        int m_device = 0;
+        bool m_owned = false;
+
+        friend class DeviceAllocator;
+      };
+
+      /**
+       * @class StreamGuard
+       * @brief Makes a stream the calling thread's current stream for its
+       * lifetime
+       */
+      class StreamGuard
+      {
+      public:
+        explicit StreamGuard(Stream &stream);
+        ~StreamGuard();
+
+        StreamGuard(const StreamGuard &) = delete;
+        StreamGuard &operator=(const StreamGuard &) = delete;
+
+      private:
+        Stream *m_previous;
+      };
+
+      /**
+       * @class DeviceAllocator
+       * @brief Caching, stream-ordered allocator of device memory
+       *
+       * cudaMalloc and cudaFree synchronize the whole device, so freed
+       * blocks are kept and handed out again instead. A block returns to
+       * the cache of the stream it was allocated on and is only reused by
+       * that stream: work queued before the free runs before any work
+       * queued after the reuse, so a block may be freed while the device is
+       * still using it. Memory used on another stream must be synchronized
+       * before it is freed.
+       *
+       * The memory reserved from a device (in use or cached) stays within
+       * Configuration::memory_fraction of the device's total memory; when a
+       * new block would exceed it, or cudaMalloc fails, the cache of that
+       * device is released first.
+       */
+      class DeviceAllocator
+      {
+      public:
+        /**
+         * @brief Gets the process-wide allocator
+         *
+         * @return DeviceAllocator& Allocator, never destroyed
+         */
+        static DeviceAllocator &instance();
+
+        /**
+         * @brief Allocates device memory on the stream's device
+         *
+         * @param bytes Size in bytes; 0 returns nullptr
+         * @param stream Stream the memory is used on
+         * @return void* Device memory, aligned to at least 256 bytes
+         * @throw DeviceError if CUDA is not available
+         * @throw MemoryError if the memory fraction or the device is exhausted
+         */
+        void *allocate(size_t bytes, const Stream &stream = Stream::current());
+
+        /**
+         * @brief Returns memory to the cache of the stream it was allocated on
+         *
+         * @param ptr Memory from allocate(), or nullptr
+         * @throw ValueError if ptr was not allocated here
+         */
+        void deallocate(void *ptr);
+
+        /**
+         * @brief Gives every cached block back to the devices
+         */
+        void empty_cache();
+
+        /**
+         * @brief Gets the memory handed out and not yet freed
+         *
+         * @return size_t Bytes in use on the current device
+         */
+        size_t allocated_bytes() const;
+
+        /**
+         * @brief Gets the memory obtained from the device
+         *
+         * @return size_t Bytes in use or cached on the current device
+         */
+        size_t reserved_bytes() const;
+
+        /**
+         * @brief Gets the most memory the allocator reserves on the current
+         * device
+         *
+         * @return size_t memory_fraction times the device's total memory
+         * @throw DeviceError if CUDA is not available
+         */
+        size_t limit() const;
+
+        /**
+         * @brief Checks whether any device memory is handed out
+         *
+         * @return bool True while at least one block is in use
+         */
+        bool in_use() const { return m_live.load(std::memory_order_relaxed) > 0; }
+
+      private:
+        struct Block
+        {
+          void *ptr = nullptr;
+          size_t size = 0;
+          int device = 0;
+          const void *stream = nullptr; ///< Stream::order_key() of its stream
+        };
+
+        DeviceAllocator() = default;
+        DeviceAllocator(const DeviceAllocator &) = delete;
+        DeviceAllocator &operator=(const DeviceAllocator &) = delete;
+
+        void release_cache(int device);
+
+        mutable std::mutex m_mutex;
+        std::unordered_map<void *, Block> m_allocated;
+        std::multimap<size_t, Block> m_cached; ///< Free blocks by size
+        std::vector<size_t> m_in_use;          ///< Bytes per device
+        std::vector<size_t> m_reserved;        ///< Bytes per device
+        std::atomic<size_t> m_live{0};
+      };
+
+      /**
+       * @brief Copies host memory to the device
+       *
+       * Pageable memory is staged through pinned buffers, so the copy is
+       * asynchronous either way: the call returns once src may be reused,
+       * with the transfer still queued on the stream.
+       *
+       * @param dst Device memory
+       * @param src Host memory
+       * @param bytes Size in bytes
+       * @param stream Stream to queue the transfer on
+       * @throw DeviceError if CUDA is not available or the copy fails
+       */
+      void copy_to_device(void *dst, const void *src, size_t bytes,
+                          const Stream &stream = Stream::current());
+
+      /**
+       * @brief Copies device memory to the host
+       *
+       * Waits for the work queued before it on the stream, then for the
+       * transfer itself; pageable memory is staged through pinned buffers,
+       * chunk by chunk, the next transfer overlapping the last host copy.
+       *
+       * @param dst Host memory
+       * @param src Device memory
+       * @param bytes Size in bytes
+       * @param stream Stream to queue the transfer on
+       * @throw DeviceError if CUDA is not available or the copy fails
+       */
+      void copy_to_host(void *dst, const void *src, size_t bytes,
+                        const Stream &stream = Stream::current());
+
+      /**
+       * @brief Copies a tensor to new device memory
+       *
+       * The buffer of the result is device memory returned to the
+       * DeviceAllocator when the last view of it goes away. Device views
+       * are only understood by to_host() and math::Blas::gemm; the rest of
+       * the library reads their elements on the host.
+       *
+       * @tparam T Element type
+       * @param host Host tensor, of any layout
+       * @param stream Stream to queue the transfer on
+       * @return TensorView<T> Dense device tensor of the same shape
+       * @throw DeviceError if CUDA is not available
+       * @throw MemoryError if the device memory is exhausted
+       */
+      template <typename T>
+      TensorView<T> to_device(const TensorView<T> &host, const Stream &stream = Stream::current())
+      {
+        static_assert(std::is_trivially_copyable_v<T>, "Device tensors must be trivially copyable");
+
+        const TensorView<T> dense = host.contiguous();
+        const size_t count = static_cast<size_t>(std::max<index_t>(dense.num_elements(), 0));
+
+        DeviceAllocator &allocator = DeviceAllocator::instance();
+        std::shared_ptr<T[]> buffer(static_cast<T *>(allocator.allocate(count * sizeof(T), stream)),
+                                    [](T *ptr)
+                                    { DeviceAllocator::instance().deallocate(ptr); });
+
+        copy_to_device(buffer.get(), dense.data(), count * sizeof(T), stream);
+        return TensorView<T>(std::move(buffer), dense.shape());
+      }
+
+      /**
+       * @brief Copies a device tensor to new host memory
+       *
+       * @tparam T Element type
+       * @param device Dense device tensor
+       * @param stream Stream the tensor was written on
+       * @return TensorView<T> Dense host tensor, ready when the call returns
+       * @throw ShapeError if the device tensor is not dense
+       * @throw DeviceError if CUDA is not available or the copy fails
+       */
+      template <typename T>
+      TensorView<T> to_host(const TensorView<T> &device, const Stream &stream = Stream::current())
+      {
+        TF_CHECK(device.is_contiguous(), ShapeError, "Only dense device tensors can be copied to the host");
+
+        TensorView<T> host = TensorView<T>::allocate(device.shape());
+        const size_t count = static_cast<size_t>(std::max<index_t>(device.num_elements(), 0));
+        copy_to_host(host.data(), device.data(), count * sizeof(T), stream);
+        return host;
+      }
+    } // namespace cuda
+  } // namespace core
+} // namespace tf
@@ -147,6 +147,16 @@ namespace tf
       using Exception::Exception;
     };
 
+    /**
+     * @class IOError
+     * @brief Exception thrown when a file cannot be read, written or parsed
+     */
+    class IOError : public Exception
+    {
+    public:
+      using Exception::Exception;
+    };
+
     // Macros
     /**
      * @brief Checks a condition and throws an exception if it is false
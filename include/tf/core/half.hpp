@@ -0,0 +1,140 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+namespace tf
+{
+  namespace core
+  {
+    namespace detail
+    {
+      /**
+       * @brief Rounds a float to the bits of the nearest bfloat16 (ties to
+       * even); NaNs stay NaN
+       */
+      constexpr std::uint16_t float_to_bfloat16_bits(float value)
+      {
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        if ((bits & 0x7fffffffu) > 0x7f800000u)
+          return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+
+        const std::uint32_t rounding = 0x7fffu + ((bits >> 16) & 1u);
+        return static_cast<std::uint16_t>((bits + rounding) >> 16);
+      }
+
+      /**
+       * @brief Widens the bits of a bfloat16 to a float (exact)
+       */
+      constexpr float bfloat16_bits_to_float(std::uint16_t bits)
+      {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+      }
+
+      /**
+       * @brief Rounds a float to the bits of the nearest IEEE half (ties to
+       * even), with overflow to infinity and gradual underflow
+       */
+      constexpr std::uint16_t float_to_half_bits(float value)
+      {
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        const std::uint32_t sign = (bits >> 16) & 0x8000u;
+        const std::uint32_t magnitude = bits & 0x7fffffffu;
+
+        std::uint32_t half;
+        if (magnitude > 0x7f800000u)
+          half = 0x7e00u;
+        else if (magnitude >= 0x477ff000u)
+          half = 0x7c00u; // 65520 and above round to infinity
+        else if (magnitude < 0x38800000u)
+        {
+          // Subnormal: adding 0.5 lines the value up with the 2^-24 units
+          // of a half subnormal in the low mantissa bits, rounded by the FPU
+          const float shifted = std::bit_cast<float>(magnitude) + 0.5f;
+          half = std::bit_cast<std::uint32_t>(shifted) - 0x3f000000u;
+        }
+        else
+        {
+          // Rebias the exponent (127 -> 15) and round off 13 mantissa bits
+          const std::uint32_t odd = (magnitude >> 13) & 1u;
+          half = (magnitude + 0xc8000fffu + odd) >> 13;
+        }
+
+        return static_cast<std::uint16_t>(sign | half);
+      }
+
+      /**
+       * @brief Widens the bits of an IEEE half to a float (exact)
+       */
+      constexpr float half_bits_to_float(std::uint16_t bits)
+      {
+        const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+        const std::uint32_t exponent = (bits >> 10) & 0x1fu;
+        const std::uint32_t mantissa = bits & 0x3ffu;
+
+        if (exponent == 0x1fu)
+          return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+
+        if (exponent == 0)
+        {
+          const float value = static_cast<float>(mantissa) * 0x1p-24f;
+          return std::bit_cast<float>(sign | std::bit_cast<std::uint32_t>(value));
+        }
+
+        return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+      }
+    } // namespace detail
+
+    /**
+     * @struct BFloat16
+     * @brief Brain floating point: the upper half of an IEEE float (8
+     * exponent and 7 mantissa bits)
+     *
+     * It has the range of float at a quarter of its precision, so weights
+     * can be stored in half the bytes without rescaling. Arithmetic goes
+     * through float.
+     */
+    struct BFloat16
+    {
+      std::uint16_t bits = 0;
+
+      constexpr BFloat16() = default;
+      explicit constexpr BFloat16(float value) : bits(detail::float_to_bfloat16_bits(value)) {}
+
+      constexpr operator float() const { return detail::bfloat16_bits_to_float(bits); }
+
+      static constexpr BFloat16 from_bits(std::uint16_t bits)
+      {
+        BFloat16 value;
+        value.bits = bits;
+        return value;
+      }
+    };
+
+    /**
+     * @struct Float16
+     * @brief IEEE 754 half precision (5 exponent and 10 mantissa bits)
+     *
+     * More precise than BFloat16 but limited to magnitudes below 65520.
+     * Arithmetic goes through float.
+     */
+    struct Float16
+    {
+      std::uint16_t bits = 0;
+
+      constexpr Float16() = default;
+      explicit constexpr Float16(float value) : bits(detail::float_to_half_bits(value)) {}
+
+      constexpr operator float() const { return detail::half_bits_to_float(bits); }
+
+      static constexpr Float16 from_bits(std::uint16_t bits)
+      {
+        Float16 value;
+        value.bits = bits;
+        return value;
+      }
+    };
+
+    static_assert(sizeof(BFloat16) == 2 && sizeof(Float16) == 2);
+  } // namespace core
+} // namespace tf
@@ -80,8 +80,9 @@
 #define TF_ALIGNMENT 16
 #define TF_ALIGNED alignas(TF_ALIGNMENT)
 
-// CUDA support
-#if defined(TF_USE_CUDA)
+// CUDA support: only nvcc understands the qualifiers, whatever the build
+// options
+#if defined(__CUDACC__)
 #define TF_CUDA_CALLABLE __host__ __device__
 #else
 #define TF_CUDA_CALLABLE
@@ -101,6 +102,8 @@
 // String manipulation
 #define TF_STRINGIFY(x) #x
 #define TF_STRINGIFY_MACRO(x) TF_STRINGIFY(x)
+#define TF_CONCAT_IMPL(a, b) a##b
+#define TF_CONCAT(a, b) TF_CONCAT_IMPL(a, b)
 
 // Version string
 #define TF_VERSION_STRING              \
@@ -142,4 +145,24 @@ private:                            \
 
 // Scope guard helper
 #define TF_SCOPE_EXIT(x) \
-  auto TF_MAYBE_UNUSED _scope_exit##__LINE__ = tf::core::ScopeGuard([&]() { x; })
\ No newline at end of file
+  TF_MAYBE_UNUSED auto TF_CONCAT(_scope_exit_, __LINE__) = tf::core::ScopeGuard([&]() { x; })
+
+// Profiling: a scope records its wall time, FLOPs, bytes and allocations
+// into the thread's ring of tf::core::Profiler while it is enabled. Without
+// TF_PROFILING (the TF_ENABLE_PROFILING option) nothing is compiled, not
+// even the arguments
+#if defined(TF_PROFILING)
+#include <tf/core/profiler.hpp>
+
+#define TF_PROFILE_SCOPE(name) \
+  tf::core::ProfileScope TF_CONCAT(_profile_scope_, __LINE__)(name, "op")
+#define TF_PROFILE_KERNEL(name, flops, bytes) \
+  tf::core::ProfileScope TF_CONCAT(_profile_scope_, __LINE__)( \
+      name, "kernel", static_cast<uint64_t>(flops), static_cast<uint64_t>(bytes))
+#define TF_PROFILE_ALLOCATION(bytes) \
+  tf::core::Profiler::record_allocation(static_cast<size_t>(bytes))
+#else
+#define TF_PROFILE_SCOPE(name) static_cast<void>(0)
+#define TF_PROFILE_KERNEL(name, flops, bytes) static_cast<void>(0)
+#define TF_PROFILE_ALLOCATION(bytes) static_cast<void>(0)
+#endif
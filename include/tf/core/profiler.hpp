@@ -0,0 +1,356 @@
+#pragma once
+
+#include <tf/core/error.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tf
+{
+  namespace core
+  {
+    /**
+     * @struct ProfileEvent
+     * @brief One completed profiling scope
+     */
+    struct ProfileEvent
+    {
+      const char *name = nullptr;     ///< String literal
+      const char *category = nullptr; ///< "op" or "kernel"
+      uint64_t start_ns = 0;          ///< Since the profiler's epoch
+      uint64_t duration_ns = 0;
+      uint64_t flops = 0;
+      uint64_t bytes = 0;           ///< Bytes read and written
+      uint64_t allocations = 0;     ///< Allocations made inside the scope, nested scopes included
+      uint64_t allocated_bytes = 0;
+      uint32_t thread = 0; ///< Index of the recording thread, in order of first use
+      uint32_t depth = 0;  ///< Number of enclosing scopes on that thread
+    };
+
+    /**
+     * @struct ProfileSummary
+     * @brief Totals of the events of one name
+     */
+    struct ProfileSummary
+    {
+      const char *name = nullptr;
+      const char *category = nullptr;
+      uint64_t count = 0;
+      uint64_t total_ns = 0;
+      uint64_t flops = 0;
+      uint64_t bytes = 0;
+      uint64_t allocations = 0;
+    };
+
+    namespace detail
+    {
+      /**
+       * @brief Whether scopes record, read on every scope entry
+       */
+      inline std::atomic<bool> profiling_enabled{false};
+
+      /**
+       * @class ProfileRing
+       * @brief Ring buffer of the events of one thread
+       *
+       * Only the owning thread pushes, without locks or waiting; the oldest
+       * events are overwritten once the ring is full. Any thread may take a
+       * snapshot concurrently: every slot carries a sequence number (a
+       * seqlock), and slots overwritten while being read are skipped.
+       *
+       * When its thread exits the ring is released; the profiler hands it
+       * to a new thread once its events are cleared, or drops it on
+       * clear().
+       */
+      class ProfileRing
+      {
+      public:
+        ProfileRing(size_t capacity, uint32_t thread);
+
+        /**
+         * @brief Appends an event; owning thread only
+         */
+        void push(const ProfileEvent &event);
+
+        /**
+         * @brief Appends the events still in the ring to out, oldest first
+         */
+        void snapshot(std::vector<ProfileEvent> &out) const;
+
+        /**
+         * @brief Hides the events pushed so far from later snapshots
+         */
+        void clear() { m_floor.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+        /**
+         * @brief Whether no event is visible to snapshots
+         */
+        bool empty() const
+        {
+          return m_floor.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+        }
+
+        uint32_t thread() const { return m_thread; }
+        size_t capacity() const { return m_capacity; }
+
+        /**
+         * @brief Whether a live thread owns the ring
+         *
+         * Cleared by the owning thread as it exits; set again, under the
+         * profiler's mutex, when the ring is handed to a new thread.
+         */
+        std::atomic<bool> in_use{true};
+
+        // State of the owning thread's open scopes, touched by it only
+        uint32_t depth = 0;
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+
+      private:
+        struct Slot
+        {
+          std::atomic<uint64_t> sequence{0}; ///< 2 i + 2 once event i is written, odd while writing
+          std::atomic<const char *> name{nullptr};
+          std::atomic<const char *> category{nullptr};
+          std::atomic<uint64_t> start_ns{0};
+          std::atomic<uint64_t> duration_ns{0};
+          std::atomic<uint64_t> flops{0};
+          std::atomic<uint64_t> bytes{0};
+          std::atomic<uint64_t> allocations{0};
+          std::atomic<uint64_t> allocated_bytes{0};
+          std::atomic<uint32_t> depth{0};
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_capacity;
+        uint32_t m_thread;
+        std::atomic<uint64_t> m_head{0};  ///< Events pushed
+        std::atomic<uint64_t> m_floor{0}; ///< Events hidden by clear()
+      };
+
+      /**
+       * @brief Gets the calling thread's ring, registering it on first use
+       *
+       * @return ProfileRing& Ring, kept by the profiler after the thread exits
+       */
+      ProfileRing &profile_ring();
+    } // namespace detail
+
+    /**
+     * @class Profiler
+     * @brief Collects the events of profiling scopes
+     *
+     * Scopes are opened with the TF_PROFILE_SCOPE and TF_PROFILE_KERNEL
+     * macros of tf/core/macros.hpp, which the library uses around its ops
+     * and kernels when built with TF_ENABLE_PROFILING; otherwise they
+     * compile to nothing. Even then nothing is recorded until enable() is
+     * called, and a disabled scope costs one relaxed load.
+     */
+    class Profiler
+    {
+    public:
+      /**
+       * @brief Gets the process-wide profiler
+       *
+       * @return Profiler& Profiler, never destroyed
+       */
+      static Profiler &instance();
+
+      /**
+       * @brief Starts or stops recording
+       */
+      void enable() { detail::profiling_enabled.store(true, std::memory_order_relaxed); }
+      void disable() { detail::profiling_enabled.store(false, std::memory_order_relaxed); }
+      static bool enabled() { return detail::profiling_enabled.load(std::memory_order_relaxed); }
+
+      /**
+       * @brief Sets the number of events kept per thread
+       *
+       * Applies to threads that record their first event afterwards.
+       *
+       * @param events Ring capacity
+       * @throw ValueError if events is 0
+       */
+      void set_capacity(size_t events);
+      size_t capacity() const;
+
+      /**
+       * @brief Gets the number of per-thread rings held
+       *
+       * @return size_t Rings of live threads and of exited threads whose
+       * events were not cleared yet
+       */
+      size_t ring_count() const;
+
+      /**
+       * @brief Forgets every event recorded so far
+       *
+       * Also frees the rings of threads that have exited.
+       */
+      void clear();
+
+      /**
+       * @brief Gets the recorded events
+       *
+       * Safe while other threads record; events they are writing at that
+       * moment may be missing.
+       *
+       * @return std::vector<ProfileEvent> Events of every thread, by start
+       * time
+       */
+      std::vector<ProfileEvent> events() const;
+
+      /**
+       * @brief Gets the totals of the recorded events per name
+       *
+       * @return std::vector<ProfileSummary> One entry per name and
+       * category, the longest total time first
+       */
+      std::vector<ProfileSummary> summary() const;
+
+      /**
+       * @brief Writes the recorded events as a Chrome trace
+       *
+       * The JSON object format is read by chrome://tracing and
+       * ui.perfetto.dev: one complete ("X") event per scope, with its
+       * FLOPs, bytes and allocations as arguments, and one track per
+       * thread.
+       *
+       * @param out Stream to write to
+       */
+      void write_chrome_trace(std::ostream &out) const;
+
+      /**
+       * @brief Writes the recorded events as a Chrome trace file
+       *
+       * @param path File to create or overwrite
+       * @throw IOError if the file cannot be written
+       */
+      void write_chrome_trace(const std::string &path) const;
+
+      /**
+       * @brief Counts an allocation towards the calling thread's open scopes
+       *
+       * @param bytes Size of the allocation
+       */
+      static void record_allocation(size_t bytes)
+      {
+        if (!enabled())
+          return;
+
+        detail::ProfileRing &ring = detail::profile_ring();
+        ++ring.allocations;
+        ring.allocated_bytes += bytes;
+      }
+
+      /**
+       * @brief Gets the time on the profiler's clock
+       *
+       * @return uint64_t Nanoseconds since the profiler's epoch
+       */
+      static uint64_t now();
+
+    private:
+      Profiler() = default;
+      Profiler(const Profiler &) = delete;
+      Profiler &operator=(const Profiler &) = delete;
+
+      std::shared_ptr<detail::ProfileRing> register_thread();
+
+      mutable std::mutex m_mutex;
+      std::vector<std::shared_ptr<detail::ProfileRing>> m_rings; ///< Live threads, and exited ones not yet cleared
+      size_t m_capacity = 1 << 16;
+      uint32_t m_next_thread = 0;
+
+      friend detail::ProfileRing &detail::profile_ring();
+    };
+
+    /**
+     * @class ProfileScope
+     * @brief Records the wall time of its lifetime as a ProfileEvent
+     *
+     * Nothing is recorded if profiling was disabled when the scope opened.
+     */
+    class ProfileScope
+    {
+    public:
+      /**
+       * @brief Opens a scope
+       *
+       * @param name Name of the op or kernel; must outlive the profiler's
+       * events, as a string literal does
+       * @param category "op" or "kernel"
+       * @param flops Floating-point operations of the scope
+       * @param bytes Bytes the scope reads and writes
+       */
+      ProfileScope(const char *name, const char *category, uint64_t flops = 0, uint64_t bytes = 0)
+      {
+        if (!Profiler::enabled())
+          return;
+
+        m_ring = &detail::profile_ring();
+        m_name = name;
+        m_category = category;
+        m_flops = flops;
+        m_bytes = bytes;
+        m_allocations = m_ring->allocations;
+        m_allocated_bytes = m_ring->allocated_bytes;
+        m_depth = m_ring->depth++;
+        m_start = Profiler::now();
+      }
+
+      ~ProfileScope()
+      {
+        if (!m_ring)
+          return;
+
+        ProfileEvent event;
+        event.name = m_name;
+        event.category = m_category;
+        event.start_ns = m_start;
+        event.duration_ns = Profiler::now() - m_start;
+        event.flops = m_flops;
+        event.bytes = m_bytes;
+        event.allocations = m_ring->allocations - m_allocations;
+        event.allocated_bytes = m_ring->allocated_bytes - m_allocated_bytes;
+        event.thread = m_ring->thread();
+        event.depth = m_depth;
+
+        --m_ring->depth;
+        m_ring->push(event);
+      }
+
+      ProfileScope(const ProfileScope &) = delete;
+      ProfileScope &operator=(const ProfileScope &) = delete;
+
+      /**
+       * @brief Adds work known only once the scope is open
+       *
+       * @param flops Floating-point operations
+       * @param bytes Bytes read and written
+       */
+      void add(uint64_t flops, uint64_t bytes)
+      {
+        m_flops += flops;
+        m_bytes += bytes;
+      }
+
+    private:
+      detail::ProfileRing *m_ring = nullptr; ///< Null when not recording
+      const char *m_name = nullptr;
+      const char *m_category = nullptr;
+      uint64_t m_start = 0;
+      uint64_t m_flops = 0;
+      uint64_t m_bytes = 0;
+      uint64_t m_allocations = 0;
+      uint64_t m_allocated_bytes = 0;
+      uint32_t m_depth = 0;
+    };
+  } // namespace core
+} // namespace tf
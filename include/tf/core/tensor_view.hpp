@@ -0,0 +1,572 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tf
+{
+  namespace core
+  {
+    namespace detail
+    {
+      /**
+       * @brief Minimum number of elements per chunk of a strided copy
+       */
+      inline constexpr size_t COPY_GRAIN = 1 << 15;
+
+      /**
+       * @brief Side of the square tiles a transposing copy works in
+       */
+      inline constexpr index_t COPY_TILE = 32;
+
+      /**
+       * @brief Simplifies strided layouts of one shape without changing the
+       * elements they visit or their order
+       *
+       * Drops dimensions of size 1 and merges each dimension into the one
+       * before it when the pair is contiguous (outer stride equals inner
+       * stride times inner size) in every layout. An empty layout
+       * afterwards describes a single element.
+       *
+       * @tparam Layouts std::array or std::vector of shape_t
+       * @param dims Dimensions, updated in place
+       * @param strides Strides in elements of each layout, updated in place
+       */
+      template <typename Layouts>
+      void collapse_dims(shape_t &dims, Layouts &strides)
+      {
+        const size_t N = strides.size();
+        size_t out = 0;
+        for (size_t i = 0; i < dims.size(); ++i)
+        {
+          if (dims[i] == 1)
+            continue;
+
+          bool mergeable = out > 0;
+          for (size_t k = 0; k < N && mergeable; ++k)
+            mergeable = strides[k][out - 1] == strides[k][i] * dims[i];
+
+          if (mergeable)
+          {
+            dims[out - 1] *= dims[i];
+            for (size_t k = 0; k < N; ++k)
+              strides[k][out - 1] = strides[k][i];
+            continue;
+          }
+
+          dims[out] = dims[i];
+          for (size_t k = 0; k < N; ++k)
+            strides[k][out] = strides[k][i];
+          ++out;
+        }
+
+        dims.resize(out);
+        for (size_t k = 0; k < N; ++k)
+          strides[k].resize(out);
+      }
+
+      /**
+       * @brief Simplifies a single strided layout; see above
+       *
+       * @param dims Dimensions, updated in place
+       * @param strides Strides in elements, updated in place
+       */
+      inline void collapse_dims(shape_t &dims, shape_t &strides)
+      {
+        std::array<shape_t, 1> layouts{std::move(strides)};
+        collapse_dims(dims, layouts);
+        strides = std::move(layouts[0]);
+      }
+
+      /**
+       * @brief Offset of the element with linear index `index` over the
+       * first `count` dimensions of a layout
+       */
+      inline index_t strided_offset(index_t index, const shape_t &dims,
+                                    const shape_t &strides, size_t count)
+      {
+        index_t offset = 0;
+        for (size_t i = count; i-- > 0;)
+        {
+          offset += (index % dims[i]) * strides[i];
+          index /= dims[i];
+        }
+        return offset;
+      }
+    } // namespace detail
+
+    /**
+     * @brief Gets the row-major (C order) strides of a shape
+     *
+     * @param shape Shape of a dense tensor
+     * @return shape_t Strides in elements, the last one 1
+     */
+    inline shape_t contiguous_strides(const Shape &shape)
+    {
+      shape_t strides(shape.rank());
+      index_t stride = 1;
+      for (size_t i = shape.rank(); i-- > 0;)
+      {
+        strides[i] = stride;
+        stride *= std::max<index_t>(shape[i], 1);
+      }
+      return strides;
+    }
+
+    /**
+     * @brief Gets the strides of a dense tensor broadcast to a larger shape
+     *
+     * @param shape Shape of a dense tensor, broadcastable to target
+     * @param target Shape it is broadcast to
+     * @return shape_t Strides over target, 0 along repeated dimensions
+     */
+    inline shape_t broadcast_strides(const Shape &shape, const Shape &target)
+    {
+      const shape_t dense = contiguous_strides(shape);
+      const size_t lead = target.rank() - shape.rank();
+
+      shape_t strides(target.rank(), 0);
+      for (size_t i = 0; i < shape.rank(); ++i)
+        if (shape[i] == target[lead + i])
+          strides[lead + i] = dense[i];
+      return strides;
+    }
+
+    /**
+     * @class TensorView
+     * @brief Strided view over a shared buffer
+     *
+     * Element (i0, ..., in) lives at data()[i0 * strides[0] + ... +
+     * in * strides[n]]. Transposes, permutations, slices and broadcasts
+     * only produce new strides and offsets over the same buffer, which the
+     * views keep alive together. A dense copy is made only when asked for,
+     * through contiguous() or copy_to(). Like std::span, constness of a
+     * view does not extend to its elements.
+     *
+     * @tparam T Element type
+     */
+    template <typename T>
+    class TensorView
+    {
+    public:
+      TensorView() = default;
+
+      /**
+       * @brief Views a buffer as a dense row-major tensor
+       *
+       * @param buffer Buffer holding at least shape.num_elements() elements
+       * @param shape Shape of the tensor
+       * @throw ShapeError if a dimension is negative
+       */
+      TensorView(std::shared_ptr<T[]> buffer, const Shape &shape)
+          : TensorView(std::move(buffer), shape, contiguous_strides(shape)) {}
+
+      /**
+       * @brief Views a buffer with explicit strides
+       *
+       * @param buffer Buffer the elements live in
+       * @param shape Shape of the view
+       * @param strides Distance in elements between consecutive indices of
+       * each dimension; 0 repeats an element (broadcast)
+       * @param offset Position of the first element in the buffer
+       * @throw ShapeError if the strides do not match the rank or a
+       * dimension is negative
+       * @throw ValueError if a stride or the offset is negative
+       */
+      TensorView(std::shared_ptr<T[]> buffer, const Shape &shape,
+                 const shape_t &strides, index_t offset = 0)
+          : m_buffer(std::move(buffer)), m_shape(shape), m_strides(strides), m_offset(offset)
+      {
+        TF_CHECK(m_strides.size() == m_shape.rank(), ShapeError,
+                 "Strides do not match the rank of the shape");
+        TF_CHECK(m_offset >= 0, ValueError, "View offset is negative");
+
+        for (size_t i = 0; i < m_shape.rank(); ++i)
+        {
+          TF_CHECK(m_shape[i] >= 0, ShapeError, "Dimension is negative");
+          TF_CHECK(m_strides[i] >= 0, ValueError, "Stride is negative");
+        }
+      }
+
+      /**
+       * @brief Allocates a dense, uninitialized tensor
+       *
+       * @param shape Shape of the tensor
+       * @return TensorView View over a new buffer
+       */
+      static TensorView allocate(const Shape &shape)
+      {
+        const index_t count = shape.num_elements();
+        return TensorView(Memory<T>::allocate_uninitialized(static_cast<size_t>(std::max<index_t>(count, 0))),
+                          shape);
+      }
+
+      // Properties
+      const Shape &shape() const { return m_shape; }
+      const shape_t &strides() const { return m_strides; }
+      index_t offset() const { return m_offset; }
+      size_t rank() const { return m_shape.rank(); }
+      index_t dim(size_t axis) const { return m_shape[axis]; }
+      index_t stride(size_t axis) const { return m_strides[axis]; }
+      index_t num_elements() const { return m_shape.num_elements(); }
+      const std::shared_ptr<T[]> &buffer() const { return m_buffer; }
+
+      /**
+       * @brief Gets the first element of the view
+       *
+       * @return T* Pointer the strides are relative to
+       */
+      T *data() const { return m_buffer.get() + m_offset; }
+
+      /**
+       * @brief Checks whether the view is dense and row-major
+       *
+       * Dimensions of size 1 may have any stride.
+       *
+       * @return bool True if the elements are consecutive in memory
+       */
+      bool is_contiguous() const
+      {
+        index_t expected = 1;
+        for (size_t i = rank(); i-- > 0;)
+        {
+          if (m_shape[i] == 0)
+            return true;
+          if (m_shape[i] == 1)
+            continue;
+          if (m_strides[i] != expected)
+            return false;
+          expected *= m_shape[i];
+        }
+        return true;
+      }
+
+      /**
+       * @brief Checks whether the innermost dimension is contiguous
+       *
+       * Such views can be processed one dense row at a time.
+       *
+       * @return bool True if the last stride is 1 (or the last dimension
+       * has at most one element)
+       */
+      bool is_inner_contiguous() const
+      {
+        return rank() == 0 || m_shape[rank() - 1] <= 1 || m_strides[rank() - 1] == 1;
+      }
+
+      // Element access
+      /**
+       * @brief Accesses an element without bounds checks
+       *
+       * @param indices One index per dimension
+       * @return T& Element
+       */
+      template <typename... Indices>
+      T &operator()(Indices... indices) const
+      {
+        static_assert((std::is_integral_v<Indices> && ...), "Indices must be integers");
+
+        index_t offset = 0;
+        size_t axis = 0;
+        ((offset += static_cast<index_t>(indices) * m_strides[axis++]), ...);
+        return data()[offset];
+      }
+
+      /**
+       * @brief Accesses an element with bounds checks
+       *
+       * @param index One index per dimension
+       * @return T& Element
+       * @throw IndexError if the index has the wrong rank or is out of range
+       */
+      T &at(const shape_t &index) const
+      {
+        TF_CHECK(index.size() == rank(), IndexError, "Index does not match the rank of the view");
+
+        index_t offset = 0;
+        for (size_t i = 0; i < rank(); ++i)
+        {
+          TF_CHECK(index[i] >= 0 && index[i] < m_shape[i], IndexError, "Index out of range");
+          offset += index[i] * m_strides[i];
+        }
+        return data()[offset];
+      }
+
+      // Views
+      /**
+       * @brief Swaps the last two dimensions
+       *
+       * @return TensorView Transposed view over the same buffer
+       * @throw ShapeError if the rank is less than 2
+       */
+      TensorView transpose() const
+      {
+        TF_CHECK(rank() >= 2, ShapeError, "Transpose needs at least two dimensions");
+
+        shape_t axes(rank());
+        for (size_t i = 0; i < rank(); ++i)
+          axes[i] = static_cast<index_t>(i);
+        std::swap(axes[rank() - 2], axes[rank() - 1]);
+        return permute(axes);
+      }
+
+      /**
+       * @brief Reorders the dimensions
+       *
+       * @param axes New order: dimension i of the result is dimension
+       * axes[i] of this view
+       * @return TensorView Permuted view over the same buffer
+       * @throw ValueError if axes is not a permutation of the dimensions
+       */
+      TensorView permute(const shape_t &axes) const
+      {
+        TF_CHECK(axes.size() == rank(), ValueError, "Permutation does not match the rank");
+
+        std::vector<bool> seen(rank(), false);
+        Shape shape = m_shape;
+        shape_t strides(rank());
+
+        for (size_t i = 0; i < rank(); ++i)
+        {
+          TF_CHECK(axes[i] >= 0 && static_cast<size_t>(axes[i]) < rank() &&
+                       !seen[static_cast<size_t>(axes[i])],
+                   ValueError, "Axes are not a permutation");
+          seen[static_cast<size_t>(axes[i])] = true;
+          shape.set(i, m_shape[static_cast<size_t>(axes[i])]);
+          strides[i] = m_strides[static_cast<size_t>(axes[i])];
+        }
+
+        return TensorView(m_buffer, shape, strides, m_offset);
+      }
+
+      /**
+       * @brief Takes every step-th index of [begin, end) along an axis
+       *
+       * @param axis Dimension to slice
+       * @param begin First index
+       * @param end One past the last index
+       * @param step Distance between taken indices
+       * @return TensorView Sliced view over the same buffer
+       * @throw IndexError if the axis or range is out of bounds
+       * @throw ValueError if step is not positive
+       */
+      TensorView slice(size_t axis, index_t begin, index_t end, index_t step = 1) const
+      {
+        TF_CHECK(axis < rank(), IndexError, "Slice axis out of range");
+        TF_CHECK(0 <= begin && begin <= end && end <= m_shape[axis], IndexError,
+                 "Slice range out of bounds");
+        TF_CHECK(step > 0, ValueError, "Slice step must be positive");
+
+        Shape shape = m_shape;
+        shape_t strides = m_strides;
+        shape.set(axis, (end - begin + step - 1) / step);
+        strides[axis] *= step;
+
+        const index_t offset = shape[axis] > 0 ? m_offset + begin * m_strides[axis] : m_offset;
+        return TensorView(m_buffer, shape, strides, offset);
+      }
+
+      /**
+       * @brief Fixes the index of one axis, dropping that dimension
+       *
+       * @param axis Dimension to remove
+       * @param index Index to keep
+       * @return TensorView View of rank one less over the same buffer
+       * @throw IndexError if the axis or index is out of bounds
+       */
+      TensorView select(size_t axis, index_t index) const
+      {
+        TF_CHECK(axis < rank(), IndexError, "Select axis out of range");
+        TF_CHECK(0 <= index && index < m_shape[axis], IndexError, "Select index out of range");
+
+        shape_t dims(m_shape.begin(), m_shape.end());
+        shape_t strides = m_strides;
+        dims.erase(dims.begin() + static_cast<std::ptrdiff_t>(axis));
+        strides.erase(strides.begin() + static_cast<std::ptrdiff_t>(axis));
+
+        return TensorView(m_buffer, Shape(dims), strides, m_offset + index * m_strides[axis]);
+      }
+
+      /**
+       * @brief Views the same elements with another shape
+       *
+       * Contiguous views are reshaped in place; other views are copied
+       * into a dense buffer first.
+       *
+       * @param shape New shape with the same number of elements
+       * @return TensorView Reshaped view
+       * @throw ShapeError if the number of elements differs
+       */
+      TensorView reshape(const Shape &shape) const
+      {
+        TF_CHECK(shape.num_elements() == num_elements(), ShapeError,
+                 "Reshape must preserve the number of elements");
+
+        if (!is_contiguous())
+          return contiguous().reshape(shape);
+
+        return TensorView(m_buffer, shape, contiguous_strides(shape), m_offset);
+      }
+
+      /**
+       * @brief Repeats the view along size-1 and missing leading dimensions
+       *
+       * Repeated dimensions get stride 0, so nothing is copied.
+       *
+       * @param shape Target shape
+       * @return TensorView Broadcast view over the same buffer
+       * @throw ShapeError if the shape is not broadcastable to the target
+       */
+      TensorView broadcast_to(const Shape &shape) const
+      {
+        TF_CHECK(m_shape.is_broadcastable_to(shape), ShapeError,
+                 "Cannot broadcast " + m_shape.to_string() + " to " + shape.to_string());
+
+        shape_t strides(shape.rank(), 0);
+        const size_t lead = shape.rank() - rank();
+        for (size_t i = 0; i < rank(); ++i)
+          if (m_shape[i] == shape[lead + i])
+            strides[lead + i] = m_strides[i];
+
+        return TensorView(m_buffer, shape, strides, m_offset);
+      }
+
+      // Materialization
+      /**
+       * @brief Gets a dense row-major view of the same elements
+       *
+       * @return TensorView This view if it is already contiguous, otherwise
+       * a copy in a new buffer
+       */
+      TensorView contiguous() const
+      {
+        if (is_contiguous())
+          return *this;
+
+        TensorView result = allocate(m_shape);
+        copy_to(result.data());
+        return result;
+      }
+
+      /**
+       * @brief Copies the elements in row-major order into a dense array
+       *
+       * The layout is collapsed first, then copied as one block, as dense
+       * rows, in cache-sized tiles (when the last two dimensions are
+       * transposed) or element by element, whichever applies. Large copies
+       * run on the thread pool.
+       *
+       * @param dst Destination of num_elements() elements; must not
+       * overlap the view
+       */
+      void copy_to(T *dst) const
+      {
+        if (num_elements() <= 0)
+          return;
+
+        shape_t dims(m_shape.begin(), m_shape.end());
+        shape_t strides = m_strides;
+        detail::collapse_dims(dims, strides);
+
+        const T *src = data();
+        const size_t r = dims.size();
+
+        if (r == 0)
+        {
+          dst[0] = src[0];
+          return;
+        }
+
+        if (r == 1 && strides[0] == 1)
+        {
+          Memory<T>::copy(dst, src, static_cast<size_t>(dims[0]));
+          return;
+        }
+
+        if (r >= 2 && strides[r - 2] == 1)
+        {
+          copy_transposed(src, dst, dims, strides);
+          return;
+        }
+
+        const index_t inner = dims[r - 1];
+        const index_t inner_stride = strides[r - 1];
+        const size_t rows = static_cast<size_t>(num_elements() / inner);
+        const size_t grain = std::max<size_t>(1, detail::COPY_GRAIN / static_cast<size_t>(inner));
+
+        parallel_for(0, rows, grain, [&](size_t begin, size_t end)
+                     {
+                       for (size_t row = begin; row < end; ++row)
+                       {
+                         const T *in = src + detail::strided_offset(static_cast<index_t>(row), dims,
+                                                                    strides, r - 1);
+                         T *out = dst + static_cast<index_t>(row) * inner;
+
+                         if (inner_stride == 1)
+                           std::copy_n(in, inner, out);
+                         else
+                           for (index_t j = 0; j < inner; ++j)
+                             out[j] = in[j * inner_stride];
+                       } });
+      }
+
+    private:
+      std::shared_ptr<T[]> m_buffer;
+      Shape m_shape;
+      shape_t m_strides;
+      index_t m_offset = 0;
+
+      /**
+       * @brief Copies a layout whose second-to-last dimension has stride 1
+       *
+       * Reading a transposed matrix row by row touches a new cache line per
+       * element; tiles keep both the rows read and the rows written in
+       * cache.
+       */
+      static void copy_transposed(const T *src, T *dst, const shape_t &dims, const shape_t &strides)
+      {
+        const size_t r = dims.size();
+        const index_t rows = dims[r - 2], cols = dims[r - 1];
+        const index_t col_stride = strides[r - 1];
+        const index_t row_tiles = (rows + detail::COPY_TILE - 1) / detail::COPY_TILE;
+
+        index_t outer = 1;
+        for (size_t i = 0; i + 2 < r; ++i)
+          outer *= dims[i];
+
+        const size_t grain = std::max<size_t>(
+            1, detail::COPY_GRAIN / static_cast<size_t>(detail::COPY_TILE * cols));
+
+        parallel_for(0, static_cast<size_t>(outer * row_tiles), grain, [&](size_t begin, size_t end)
+                     {
+                       for (size_t task = begin; task < end; ++task)
+                       {
+                         const index_t o = static_cast<index_t>(task) / row_tiles;
+                         const index_t i0 = static_cast<index_t>(task) % row_tiles * detail::COPY_TILE;
+                         const index_t i1 = std::min(rows, i0 + detail::COPY_TILE);
+
+                         const T *in = src + detail::strided_offset(o, dims, strides, r - 2);
+                         T *out = dst + o * rows * cols;
+
+                         for (index_t j0 = 0; j0 < cols; j0 += detail::COPY_TILE)
+                         {
+                           const index_t j1 = std::min(cols, j0 + detail::COPY_TILE);
+                           for (index_t i = i0; i < i1; ++i)
+                             for (index_t j = j0; j < j1; ++j)
+                               out[i * cols + j] = in[i + j * col_stride];
+                         }
+                       } });
+      }
+    };
+  } // namespace core
+} // namespace tf
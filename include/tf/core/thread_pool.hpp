@@ -0,0 +1,236 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace tf
+{
+  namespace core
+  {
+    /**
+     * @class ThreadPool
+     * @brief Persistent work-stealing pool for data-parallel loops
+     *
+     * A pool of size N runs N - 1 worker threads; the thread that starts a
+     * parallel loop executes chunks alongside them. Every worker owns a task
+     * deque: it serves its own deque from the back and steals from the front
+     * of the others when it runs dry. Loops may be nested: a chunk that
+     * starts another loop pushes the inner chunks to its own deque and keeps
+     * executing tasks until the inner loop has finished.
+     */
+    class ThreadPool
+    {
+    public:
+      /**
+       * @brief Function executed on a half-open index range [begin, end)
+       */
+      using RangeFunction = std::function<void(size_t, size_t)>;
+
+      /**
+       * @brief Constructs a pool
+       *
+       * @param num_threads Total number of threads, including the caller
+       */
+      explicit ThreadPool(size_t num_threads);
+
+      ~ThreadPool();
+
+      ThreadPool(const ThreadPool &) = delete;
+      ThreadPool &operator=(const ThreadPool &) = delete;
+
+      /**
+       * @brief Gets the number of threads loops are spread across
+       *
+       * @return size_t Worker threads plus the calling thread
+       */
+      size_t num_threads() const;
+
+      /**
+       * @brief Changes the number of threads
+       *
+       * Waits until no loop is running on the pool.
+       *
+       * @param num_threads Total number of threads, including the caller
+       * @throw ValueError if num_threads is zero
+       * @throw Exception if called from inside a parallel loop
+       */
+      void resize(size_t num_threads);
+
+      /**
+       * @brief Pins the worker threads to CPUs
+       *
+       * Worker i runs on cpus[i % cpus.size()]; the calling thread of a loop
+       * is left alone. Combined with utils::numa_node_cpus and a NUMA
+       * allocation policy this keeps loop chunks next to their memory. The
+       * setting survives resizes. An empty list unpins the workers.
+       *
+       * @param cpus CPU indices to pin to
+       * @return bool True if every worker was pinned (always false on
+       * platforms without thread affinity)
+       * @throw Exception if called from inside a parallel loop
+       */
+      bool set_affinity(const std::vector<int> &cpus);
+
+      /**
+       * @brief Gets the CPUs the workers are pinned to
+       *
+       * @return std::vector<int> CPU list, empty when unpinned
+       */
+      std::vector<int> affinity() const;
+
+      /**
+       * @brief Gets the chunk length a range is split into
+       *
+       * Ranges are split into about four chunks per thread so that stealing
+       * can even out imbalanced work, but chunks never drop below the grain.
+       *
+       * @param n Range length
+       * @param grain Minimum number of indices per chunk
+       * @return size_t Chunk length
+       */
+      size_t chunk_size(size_t n, size_t grain) const;
+
+      /**
+       * @brief Runs fn over [begin, end) split into chunks
+       *
+       * Returns once every chunk has run. The first exception thrown by a
+       * chunk is rethrown on the calling thread after all chunks finished.
+       *
+       * @param begin First index
+       * @param end One past the last index
+       * @param grain Minimum number of indices per chunk
+       * @param fn Function called with each chunk's [begin, end)
+       */
+      void parallel_for(size_t begin, size_t end, size_t grain, const RangeFunction &fn);
+
+      /**
+       * @brief Checks whether the calling thread is inside a parallel loop
+       *
+       * @return bool True on pool workers and on threads running a loop
+       */
+      static bool in_parallel_region();
+
+    private:
+      struct Job;
+      struct Task;
+      struct Worker;
+
+      std::vector<std::unique_ptr<Worker>> m_workers;
+      std::atomic<size_t> m_num_threads{1};
+      std::atomic<size_t> m_queued{0};
+      std::atomic<size_t> m_next_victim{0};
+      bool m_stop = false;
+      std::mutex m_sleep_mutex;
+      std::condition_variable m_wakeup;
+      mutable std::shared_mutex m_resize_mutex;
+      std::vector<int> m_affinity;
+
+      void start(size_t num_workers);
+      bool apply_affinity();
+      void stop();
+      void worker_loop(size_t index);
+      void push(size_t worker, const Task &task);
+      bool try_take(Task &task);
+      static void run(const Task &task);
+    };
+
+    /**
+     * @brief Gets the process-wide thread pool
+     *
+     * The pool follows Configuration::num_threads(): when the setting changed
+     * since the last call, the pool is resized before it is returned (unless
+     * the caller is itself inside a parallel loop).
+     *
+     * @return ThreadPool& Reference to the global pool
+     */
+    ThreadPool &thread_pool();
+
+    /**
+     * @brief Runs fn over [begin, end) on the global thread pool
+     *
+     * Ranges no longer than the grain run inline on the calling thread.
+     *
+     * @tparam Function Callable taking (size_t begin, size_t end)
+     * @param begin First index
+     * @param end One past the last index
+     * @param grain Minimum number of indices per chunk
+     * @param fn Function called with each chunk's [begin, end)
+     */
+    template <typename Function>
+    void parallel_for(size_t begin, size_t end, size_t grain, Function &&fn)
+    {
+      if (end <= begin)
+        return;
+
+      if (end - begin <= std::max<size_t>(grain, 1))
+      {
+        fn(begin, end);
+        return;
+      }
+
+      thread_pool().parallel_for(begin, end, grain, ThreadPool::RangeFunction(fn));
+    }
+
+    /**
+     * @brief Reduces [begin, end) on the global thread pool
+     *
+     * Each chunk is reduced by map, and the partial results are combined in
+     * chunk order, so the result is reproducible for a given thread count.
+     *
+     * @tparam T Result type
+     * @tparam Map Callable taking (size_t begin, size_t end) and returning T
+     * @tparam Combine Callable taking (T, T) and returning T
+     * @param begin First index
+     * @param end One past the last index
+     * @param grain Minimum number of indices per chunk
+     * @param identity Identity element of combine
+     * @param map Function reducing one chunk
+     * @param combine Function combining two partial results
+     * @return T Reduced value
+     */
+    template <typename T, typename Map, typename Combine>
+    T parallel_reduce(size_t begin, size_t end, size_t grain, T identity,
+                      Map &&map, Combine &&combine)
+    {
+      if (end <= begin)
+        return identity;
+
+      const size_t n = end - begin;
+      if (n <= std::max<size_t>(grain, 1))
+        return combine(identity, map(begin, end));
+
+      ThreadPool &pool = thread_pool();
+      const size_t chunk = pool.chunk_size(n, grain);
+      const size_t count = (n + chunk - 1) / chunk;
+
+      if (count <= 1)
+        return combine(identity, map(begin, end));
+
+      std::vector<T> partial(count, identity);
+      pool.parallel_for(0, count, 1, [&](size_t first, size_t last)
+                        {
+                          for (size_t c = first; c < last; ++c)
+                          {
+                            size_t b = begin + c * chunk;
+                            partial[c] = map(b, std::min(end, b + chunk));
+                          }
+                        });
+
+      T result = identity;
+      for (const T &value : partial)
+        result = combine(result, value);
+
+      return result;
+    }
+  } // namespace core
+} // namespace tf
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <tf/core/half.hpp>
+
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace tf
@@ -32,7 +35,10 @@ namespace tf
       Float64,
       Int32,
       Int64,
-      Bool
+      Bool,
+      BFloat16,
+      Float16,
+      Int8
     };
 
     /**
@@ -85,5 +91,82 @@ namespace tf
       using type = bool;
       static constexpr const char *name = "bool";
     };
+
+    template <>
+    struct DataTypeTraits<DataType::BFloat16>
+    {
+      using type = BFloat16;
+      static constexpr const char *name = "bfloat16";
+    };
+
+    template <>
+    struct DataTypeTraits<DataType::Float16>
+    {
+      using type = Float16;
+      static constexpr const char *name = "float16";
+    };
+
+    template <>
+    struct DataTypeTraits<DataType::Int8>
+    {
+      using type = std::int8_t;
+      static constexpr const char *name = "int8";
+    };
+
+    /**
+     * @brief Gets the size of one element of a data type
+     *
+     * @param type Data type
+     * @return size_t Size in bytes, 0 for an unknown value
+     */
+    constexpr size_t size_of(DataType type)
+    {
+      switch (type)
+      {
+      case DataType::Float64:
+      case DataType::Int64:
+        return 8;
+      case DataType::Float32:
+      case DataType::Int32:
+        return 4;
+      case DataType::BFloat16:
+      case DataType::Float16:
+        return 2;
+      case DataType::Bool:
+      case DataType::Int8:
+        return 1;
+      }
+      return 0;
+    }
+
+    /**
+     * @brief Gets the data type of an element type
+     *
+     * @tparam T Element type, the type of one of the DataTypeTraits
+     * @return DataType Matching enumerator
+     */
+    template <typename T>
+    constexpr DataType data_type_of()
+    {
+      if constexpr (std::is_same_v<T, float>)
+        return DataType::Float32;
+      else if constexpr (std::is_same_v<T, double>)
+        return DataType::Float64;
+      else if constexpr (std::is_same_v<T, std::int32_t>)
+        return DataType::Int32;
+      else if constexpr (std::is_same_v<T, std::int64_t>)
+        return DataType::Int64;
+      else if constexpr (std::is_same_v<T, bool>)
+        return DataType::Bool;
+      else if constexpr (std::is_same_v<T, BFloat16>)
+        return DataType::BFloat16;
+      else if constexpr (std::is_same_v<T, Float16>)
+        return DataType::Float16;
+      else
+      {
+        static_assert(std::is_same_v<T, std::int8_t>, "Type has no DataType");
+        return DataType::Int8;
+      }
+    }
   } // namespace core
 } // namespace tf
\ No newline at end of file
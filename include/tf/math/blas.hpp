@@ -3,9 +3,13 @@
 #include <tf/core/types.hpp>
 #include <tf/core/error.hpp>
 #include <tf/core/config.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/quantize.hpp>
 
 #include <cstddef>
+#include <cstdint>
 #include <complex>
+#include <limits>
 
 namespace tf
 {
@@ -22,10 +26,49 @@ namespace tf
       ConjTrans = 2
     };
 
+    /**
+     * @enum Activation
+     * @brief Activation a GEMM epilogue applies (see math/utils.hpp)
+     */
+    enum class Activation
+    {
+      Identity,
+      Relu,
+      LeakyRelu,
+      Sigmoid,
+      Tanh
+    };
+
+    /**
+     * @struct GemmEpilogue
+     * @brief Elementwise work fused into the store of a GEMM result
+     *
+     * Each element of alpha * op(A) * op(B) + beta * C goes through, in
+     * order: the bias add, the activation, rounding to the nearest multiple
+     * of quantum (ties to even) and clamping to [clamp_min, clamp_max].
+     * Steps left at their defaults are skipped.
+     *
+     * @tparam T Data type
+     */
+    template <typename T>
+    struct GemmEpilogue
+    {
+      const T *row_bias = nullptr;                            ///< m values, value i added to row i
+      const T *column_bias = nullptr;                         ///< n values, value j added to column j
+      Activation activation = Activation::Identity;           ///< Activation after the bias
+      T leaky_slope = T(0.01);                                ///< Slope of LeakyRelu below zero
+      T quantum = T{0};                                       ///< Quantization step, 0 for none
+      T clamp_min = -std::numeric_limits<T>::infinity();      ///< Lower output bound
+      T clamp_max = std::numeric_limits<T>::infinity();       ///< Upper output bound
+    };
+
     /**
      * @class Blas
      * @brief BLAS operations wrapper with optimized implementations
      *
+     * Matrices are stored in row-major order; leading dimensions are the
+     * distance in elements between consecutive rows.
+     *
      * @version 1.0.0
      */
     class Blas
@@ -100,6 +143,7 @@ namespace tf
        * @param beta Scaling factor for vector y
        * @param y Vector y with stride incy
        * @param incy Stride of vector y
+       * @throw ShapeError if lda is smaller than n
        */
       template <typename T>
       static void gemv(size_t m, size_t n, T alpha, const T *A, size_t lda,
@@ -119,6 +163,8 @@ namespace tf
        * @param beta Scaling factor for vector y
        * @param y Vector y with stride incy
        * @param incy Stride of vector y
+       * @throw ValueError if uplo is not 'U' or 'L'
+       * @throw ShapeError if lda is smaller than n
        */
       template <typename T>
       static void symv(char uplo, size_t n, T alpha, const T *A, size_t lda,
@@ -129,6 +175,11 @@ namespace tf
        *
        * C = alpha * op(A) * op(B) + beta * C
        *
+       * Runs on a cache-blocked kernel that packs panels of op(A) and op(B)
+       * into aligned scratch and computes register tiles of C with the
+       * widest FMA micro-kernel available. When beta is zero, C is not read.
+       * Large calls are delegated to the external BLAS when one is linked.
+       *
        * @tparam T Data type
        * @param transa Transpose operation for A
        * @param transb Transpose operation for B
@@ -143,6 +194,7 @@ namespace tf
        * @param beta Scaling factor for C
        * @param C Matrix C with leading dimension ldc
        * @param ldc Leading dimension of C
+       * @throw ShapeError if a leading dimension is too small
        */
       template <typename T>
       static void gemm(BlasOperation transa, BlasOperation transb,
@@ -150,6 +202,302 @@ namespace tf
                        const T *A, size_t lda, const T *B, size_t ldb,
                        T beta, T *C, size_t ldc);
 
+      /**
+       * @brief Matrix-matrix multiplication on strided views
+       *
+       * C = alpha * A * B + beta * C
+       *
+       * Views with contiguous rows are passed to gemm as they are, and
+       * views with contiguous columns (such as A.transpose()) become
+       * BlasOperation::Trans over the same buffer, so neither is copied.
+       * Any other layout is made contiguous first. C needs a unit stride
+       * along one axis; a column-major C is computed as C^T = B^T A^T.
+       *
+       * @tparam T Data type
+       * @param alpha Scaling factor for A and B
+       * @param A Matrix view of shape (m, k)
+       * @param B Matrix view of shape (k, n)
+       * @param beta Scaling factor for C
+       * @param C Matrix view of shape (m, n), written in place
+       * @throw ShapeError if a view is not a matrix, the shapes do not
+       * match or C has no unit stride
+       */
+      template <typename T>
+      static void gemm(T alpha, const core::TensorView<T> &A, const core::TensorView<T> &B,
+                       T beta, const core::TensorView<T> &C);
+
+      /**
+       * @brief Matrix-matrix multiplication with a fused epilogue
+       *
+       * C = epilogue(alpha * op(A) * op(B) + beta * C)
+       *
+       * The built-in kernel applies the bias, activation, quantization and
+       * clamping to each register tile of C before storing it, so a dense
+       * layer writes its output once instead of writing it, reading it back
+       * and writing it again. Calls delegated to the external BLAS apply the
+       * whole epilogue in a single pass over C afterwards.
+       *
+       * @tparam T Data type
+       * @param transa Transpose operation for A
+       * @param transb Transpose operation for B
+       * @param m Number of rows in C
+       * @param n Number of columns in C
+       * @param k Number of columns in A and rows in B
+       * @param alpha Scaling factor for A and B
+       * @param A Matrix A with leading dimension lda
+       * @param lda Leading dimension of A
+       * @param B Matrix B with leading dimension ldb
+       * @param ldb Leading dimension of B
+       * @param beta Scaling factor for C
+       * @param C Matrix C with leading dimension ldc
+       * @param ldc Leading dimension of C
+       * @param epilogue Work applied to the result
+       * @throw ShapeError if a leading dimension is too small
+       * @throw ValueError if the quantum is negative or the clamp range is
+       * empty
+       */
+      template <typename T>
+      static void gemm(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, T alpha,
+                       const T *A, size_t lda, const T *B, size_t ldb,
+                       T beta, T *C, size_t ldc, const GemmEpilogue<T> &epilogue);
+
+      /**
+       * @brief Matrix-matrix multiplication on strided views with a fused
+       * epilogue
+       *
+       * C = epilogue(alpha * A * B + beta * C), with the views mapped as in
+       * the overload without an epilogue.
+       *
+       * @tparam T Data type
+       * @param alpha Scaling factor for A and B
+       * @param A Matrix view of shape (m, k)
+       * @param B Matrix view of shape (k, n)
+       * @param beta Scaling factor for C
+       * @param C Matrix view of shape (m, n), written in place
+       * @param epilogue Work applied to the result
+       * @throw ShapeError if a view is not a matrix, the shapes do not
+       * match or C has no unit stride
+       * @throw ValueError if the quantum is negative or the clamp range is
+       * empty
+       */
+      template <typename T>
+      static void gemm(T alpha, const core::TensorView<T> &A, const core::TensorView<T> &B,
+                       T beta, const core::TensorView<T> &C, const GemmEpilogue<T> &epilogue);
+
+      /**
+       * @brief Batch of matrix-matrix multiplications given by pointer
+       * arrays
+       *
+       * C[i] = alpha * op(A[i]) * op(B[i]) + beta * C[i] for every i below
+       * batch_count, all of one shape. The whole batch is scheduled on the
+       * thread pool at once: small problems are grouped into chunks that
+       * run on one thread each, and problems with m, n and k up to 32 use
+       * kernels specialized for the width of C. Batches always run on the
+       * built-in kernels.
+       *
+       * @tparam T Data type
+       * @param transa Transpose operation for every A
+       * @param transb Transpose operation for every B
+       * @param m Number of rows in each C
+       * @param n Number of columns in each C
+       * @param k Number of columns in each op(A) and rows in each op(B)
+       * @param alpha Scaling factor for A and B
+       * @param A batch_count pointers to the A matrices
+       * @param lda Leading dimension of every A
+       * @param B batch_count pointers to the B matrices
+       * @param ldb Leading dimension of every B
+       * @param beta Scaling factor for C
+       * @param C batch_count pointers to the C matrices, which must not
+       * overlap
+       * @param ldc Leading dimension of every C
+       * @param batch_count Number of problems
+       * @throw ShapeError if a leading dimension is too small
+       * @throw ValueError if a pointer array is null
+       */
+      template <typename T>
+      static void gemm_batched(BlasOperation transa, BlasOperation transb,
+                               size_t m, size_t n, size_t k, T alpha,
+                               const T *const *A, size_t lda, const T *const *B, size_t ldb,
+                               T beta, T *const *C, size_t ldc, size_t batch_count);
+
+      /**
+       * @brief Batch of matrix-matrix multiplications at fixed strides
+       *
+       * C + i * stride_c = alpha * op(A + i * stride_a) *
+       * op(B + i * stride_b) + beta * (C + i * stride_c), scheduled as in
+       * gemm_batched. A stride of 0 shares one matrix across the batch,
+       * such as the weights of a projection applied to every head.
+       *
+       * @tparam T Data type
+       * @param transa Transpose operation for every A
+       * @param transb Transpose operation for every B
+       * @param m Number of rows in each C
+       * @param n Number of columns in each C
+       * @param k Number of columns in each op(A) and rows in each op(B)
+       * @param alpha Scaling factor for A and B
+       * @param A First A matrix
+       * @param lda Leading dimension of every A
+       * @param stride_a Elements between consecutive A matrices
+       * @param B First B matrix
+       * @param ldb Leading dimension of every B
+       * @param stride_b Elements between consecutive B matrices
+       * @param beta Scaling factor for C
+       * @param C First C matrix
+       * @param ldc Leading dimension of every C
+       * @param stride_c Elements between consecutive C matrices
+       * @param batch_count Number of problems
+       * @throw ShapeError if a leading dimension is too small or the C
+       * matrices overlap
+       */
+      template <typename T>
+      static void gemm_strided_batched(BlasOperation transa, BlasOperation transb,
+                                       size_t m, size_t n, size_t k, T alpha,
+                                       const T *A, size_t lda, size_t stride_a,
+                                       const T *B, size_t ldb, size_t stride_b,
+                                       T beta, T *C, size_t ldc, size_t stride_c,
+                                       size_t batch_count);
+
+      /**
+       * @brief Mixed-precision dot product, accumulated in float
+       *
+       * Runs on AVX-512 BF16 (bfloat16) dot-product instructions where the
+       * host has them.
+       *
+       * @param n Number of elements in the vectors
+       * @param x Vector x with stride incx
+       * @param incx Stride of vector x
+       * @param y Vector y with stride incy
+       * @param incy Stride of vector y
+       * @return float Dot product of the vectors
+       * @throw std::invalid_argument if n is zero
+       */
+      static float dot(size_t n, const core::BFloat16 *x, int incx,
+                       const core::BFloat16 *y, int incy);
+      static float dot(size_t n, const core::Float16 *x, int incx,
+                       const core::Float16 *y, int incy);
+
+      /**
+       * @brief Integer dot product of int8 vectors, accumulated in int32
+       *
+       * Runs on AVX-512 VNNI where the host has it; the sum wraps on
+       * overflow.
+       *
+       * @param n Number of elements in the vectors
+       * @param x Vector x with stride incx
+       * @param incx Stride of vector x
+       * @param y Vector y with stride incy
+       * @param incy Stride of vector y
+       * @return std::int32_t Dot product of the vectors
+       * @throw std::invalid_argument if n is zero
+       */
+      static std::int32_t dot(size_t n, const std::int8_t *x, int incx,
+                              const std::int8_t *y, int incy);
+
+      /**
+       * @brief Mixed-precision matrix-matrix multiplication
+       *
+       * C = alpha * op(A) * op(B) + beta * C, with reduced-precision A
+       * and B and products accumulated in float. The inputs are widened
+       * to float as they are packed for the float micro-kernel, so memory
+       * traffic is halved at the compute rate of a float GEMM. Always runs
+       * on the built-in kernels.
+       *
+       * @param transa Transpose operation for A
+       * @param transb Transpose operation for B
+       * @param m Number of rows in C
+       * @param n Number of columns in C
+       * @param k Number of columns in op(A) and rows in op(B)
+       * @param alpha Scaling factor for A and B
+       * @param A Matrix A with leading dimension lda
+       * @param lda Leading dimension of A
+       * @param B Matrix B with leading dimension ldb
+       * @param ldb Leading dimension of B
+       * @param beta Scaling factor for C
+       * @param C Float matrix C with leading dimension ldc
+       * @param ldc Leading dimension of C
+       * @throw ShapeError if a leading dimension is too small
+       */
+      static void gemm(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, float alpha,
+                       const core::BFloat16 *A, size_t lda, const core::BFloat16 *B, size_t ldb,
+                       float beta, float *C, size_t ldc);
+      static void gemm(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, float alpha,
+                       const core::Float16 *A, size_t lda, const core::Float16 *B, size_t ldb,
+                       float beta, float *C, size_t ldc);
+
+      /**
+       * @brief Integer matrix-matrix multiplication of int8 matrices
+       *
+       * C = alpha * op(A) * op(B) + beta * C in int32 arithmetic, which
+       * wraps on overflow (not before k exceeds 2^17 with alpha 1). Runs
+       * on AVX-512 VNNI where the host has it.
+       *
+       * @param transa Transpose operation for A
+       * @param transb Transpose operation for B
+       * @param m Number of rows in C
+       * @param n Number of columns in C
+       * @param k Number of columns in op(A) and rows in op(B)
+       * @param alpha Scaling factor for A and B
+       * @param A Matrix A with leading dimension lda
+       * @param lda Leading dimension of A
+       * @param B Matrix B with leading dimension ldb
+       * @param ldb Leading dimension of B
+       * @param beta Scaling factor for C
+       * @param C Int32 matrix C with leading dimension ldc
+       * @param ldc Leading dimension of C
+       * @throw ShapeError if a leading dimension is too small
+       */
+      static void gemm(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, std::int32_t alpha,
+                       const std::int8_t *A, size_t lda, const std::int8_t *B, size_t ldb,
+                       std::int32_t beta, std::int32_t *C, size_t ldc);
+
+      /**
+       * @brief Quantized matrix-matrix multiplication with int8 output
+       *
+       * C = quantize(epilogue(dequantize(op(A)) * dequantize(op(B))), qc)
+       *
+       * The products accumulate in int32 on the int8 kernels (VNNI where
+       * the host has it). Each tile of C is requantized as its last depth
+       * block is computed: zero points are corrected with the row sums of
+       * op(A) and the column sums of op(B), the scales applied, then the
+       * epilogue runs on the real values (its biases are float) and the
+       * result is rounded to the levels of qc. C is written once, as int8.
+       *
+       * qa holds one channel or one per row of op(A); qb and qc one or one
+       * per column (the output channels, as calibrated along the output
+       * axis of the weights). Their axis fields are not consulted.
+       *
+       * @param transa Transpose operation for A
+       * @param transb Transpose operation for B
+       * @param m Number of rows in C
+       * @param n Number of columns in C
+       * @param k Number of columns in op(A) and rows in op(B)
+       * @param A Matrix A with leading dimension lda
+       * @param lda Leading dimension of A
+       * @param qa Quantization of A
+       * @param B Matrix B with leading dimension ldb
+       * @param ldb Leading dimension of B
+       * @param qb Quantization of B
+       * @param C Int8 matrix C with leading dimension ldc
+       * @param ldc Leading dimension of C
+       * @param qc Quantization of C
+       * @param epilogue Work applied to the real result before it is
+       * quantized
+       * @throw ShapeError if a leading dimension is too small or a channel
+       * count does not match
+       * @throw ValueError if a parameter is out of range, the quantum is
+       * negative or the clamp range is empty
+       */
+      static void gemm(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k,
+                       const std::int8_t *A, size_t lda, const QuantParams &qa,
+                       const std::int8_t *B, size_t ldb, const QuantParams &qb,
+                       std::int8_t *C, size_t ldc, const QuantParams &qc,
+                       const GemmEpilogue<float> &epilogue = {});
+
       /**
        * @brief Symmetric matrix-matrix multiplication
        *
@@ -168,12 +516,25 @@ namespace tf
        * @param beta Scaling factor for C
        * @param C Matrix C with leading dimension ldc
        * @param ldc Leading dimension of C
+       * @throw ValueError if side or uplo is invalid
+       * @throw ShapeError if a leading dimension is too small
        */
       template <typename T>
       static void symm(char side, char uplo, size_t m, size_t n, T alpha,
                        const T *A, size_t lda, const T *B, size_t ldb,
                        T beta, T *C, size_t ldc);
 
+      /**
+       * @brief Gets the external BLAS library calls are delegated to
+       *
+       * Calls above a per-routine size cutoff go to the external library;
+       * smaller calls, and every call in builds without TF_USE_BLAS, run on
+       * the built-in kernels.
+       *
+       * @return const char* Backend name, or nullptr when none is linked
+       */
+      static const char *backend_name();
+
     private:
       /**
        * @brief Helper function for different data types
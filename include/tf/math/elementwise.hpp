@@ -0,0 +1,230 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace tf
+{
+  namespace math
+  {
+    /**
+     * @enum BinaryOp
+     * @brief Elementwise binary operations
+     *
+     * Maximum and Minimum follow the x86 instructions: when either operand
+     * is NaN the second one is returned.
+     */
+    enum class BinaryOp
+    {
+      Add,
+      Subtract,
+      Multiply,
+      Divide,
+      Maximum,
+      Minimum
+    };
+
+    /**
+     * @enum UnaryOp
+     * @brief Elementwise unary operations
+     */
+    enum class UnaryOp
+    {
+      Negate,
+      Abs,
+      Sqrt,
+      Square,
+      Relu,
+      Sigmoid,
+      Tanh
+    };
+
+    /**
+     * @struct BroadcastPlan
+     * @brief Iteration plan of an elementwise operation over strided
+     * operands of one (broadcast) shape
+     *
+     * Size-1 dimensions are dropped and dimensions that are contiguous in
+     * every operand are merged, so a dense operation becomes a single run
+     * and a bias add becomes rows x columns with a zero row stride for the
+     * bias.
+     */
+    struct BroadcastPlan
+    {
+      core::shape_t dims;                   ///< Collapsed dimensions, outermost first
+      std::array<core::shape_t, 3> strides; ///< Strides of the output and both inputs
+    };
+
+    /**
+     * @brief Gets the plan for a shape and operand strides
+     *
+     * Plans are cached per thread, so repeating an operation on the same
+     * layouts does not recompute them.
+     *
+     * @param shape Shape of the output, which the inputs are broadcast to
+     * @param out Strides of the output
+     * @param a Strides of the first input (0 along repeated dimensions)
+     * @param b Strides of the second input (0 along repeated dimensions)
+     * @return const BroadcastPlan& Plan, valid until the next call on this
+     * thread
+     * @throw ShapeError if a stride vector does not match the rank
+     */
+    const BroadcastPlan &broadcast_plan(const core::Shape &shape, const core::shape_t &out,
+                                        const core::shape_t &a, const core::shape_t &b);
+
+    /**
+     * @brief Applies a binary operation with broadcasting
+     *
+     * The inputs are broadcast to the output without being expanded. The
+     * innermost dimension runs through SIMD kernels (with a repeated
+     * operand kept in a register) and the outer dimensions are split
+     * across the thread pool. out may alias an input with the same layout.
+     *
+     * @param op Operation
+     * @param a First input
+     * @param b Second input
+     * @param out Output of the broadcast shape of a and b
+     * @throw ShapeError if the inputs do not broadcast to the output shape
+     * or the output repeats elements
+     */
+    void binary(BinaryOp op, const core::TensorView<float> &a, const core::TensorView<float> &b,
+                const core::TensorView<float> &out);
+    void binary(BinaryOp op, const core::TensorView<double> &a, const core::TensorView<double> &b,
+                const core::TensorView<double> &out);
+
+    /**
+     * @brief Applies a unary operation
+     *
+     * @param op Operation
+     * @param a Input, broadcastable to the output
+     * @param out Output; may alias a with the same layout
+     * @throw ShapeError if a does not broadcast to the output shape or the
+     * output repeats elements
+     */
+    void unary(UnaryOp op, const core::TensorView<float> &a, const core::TensorView<float> &out);
+    void unary(UnaryOp op, const core::TensorView<double> &a, const core::TensorView<double> &out);
+
+    /**
+     * @brief Applies a binary operation to one block of elements
+     *
+     * The unchecked building block of the operations above and of
+     * expression evaluation: z[i] = op(x[i * incx], y[i * incy]). It runs
+     * on the calling thread.
+     *
+     * @param op Operation
+     * @param n Number of elements
+     * @param x First input
+     * @param incx Increment of x, 0 (repeated) or 1
+     * @param y Second input
+     * @param incy Increment of y, 0 (repeated) or 1
+     * @param z Dense output; may alias a dense input
+     */
+    void binary_block(BinaryOp op, size_t n, const float *x, size_t incx, const float *y,
+                      size_t incy, float *z);
+    void binary_block(BinaryOp op, size_t n, const double *x, size_t incx, const double *y,
+                      size_t incy, double *z);
+
+    /**
+     * @brief Applies a unary operation to one dense block of elements
+     *
+     * @param op Operation
+     * @param n Number of elements
+     * @param x Input
+     * @param y Output; may alias x
+     */
+    void unary_block(UnaryOp op, size_t n, const float *x, float *y);
+    void unary_block(UnaryOp op, size_t n, const double *x, double *y);
+
+    /**
+     * @brief Converts a dense array between float and reduced-precision
+     * storage
+     *
+     * Narrowing rounds to nearest even (Float16 overflows to infinity);
+     * widening is exact. Large arrays are split across the thread pool.
+     *
+     * @param n Number of elements
+     * @param x Input
+     * @param y Output
+     */
+    void convert(size_t n, const float *x, core::BFloat16 *y);
+    void convert(size_t n, const core::BFloat16 *x, float *y);
+    void convert(size_t n, const float *x, core::Float16 *y);
+    void convert(size_t n, const core::Float16 *x, float *y);
+
+    /**
+     * @brief Applies a binary operation into a new dense tensor
+     *
+     * @tparam T Data type (float or double)
+     * @param op Operation
+     * @param a First input
+     * @param b Second input
+     * @return core::TensorView<T> Result of the broadcast shape
+     * @throw ShapeError if the shapes do not broadcast
+     */
+    template <typename T>
+    core::TensorView<T> binary(BinaryOp op, const core::TensorView<T> &a,
+                               const core::TensorView<T> &b)
+    {
+      auto out = core::TensorView<T>::allocate(core::broadcast_shapes(a.shape(), b.shape()));
+      binary(op, a, b, out);
+      return out;
+    }
+
+    /**
+     * @brief Applies a unary operation into a new dense tensor
+     *
+     * @tparam T Data type (float or double)
+     * @param op Operation
+     * @param a Input
+     * @return core::TensorView<T> Result of the shape of a
+     */
+    template <typename T>
+    core::TensorView<T> unary(UnaryOp op, const core::TensorView<T> &a)
+    {
+      auto out = core::TensorView<T>::allocate(a.shape());
+      unary(op, a, out);
+      return out;
+    }
+
+    /**
+     * @brief Adds a bias to every row of a matrix, in place
+     *
+     * @tparam T Data type (float or double)
+     * @param matrix Matrix view of shape (rows, cols)
+     * @param bias Vector view of shape (cols)
+     * @throw ShapeError if the shapes do not match
+     */
+    template <typename T>
+    void add_bias(const core::TensorView<T> &matrix, const core::TensorView<T> &bias)
+    {
+      TF_CHECK(matrix.rank() == 2 && bias.rank() == 1 && bias.dim(0) == matrix.dim(1),
+               core::ShapeError, "Bias must have one entry per column");
+      binary(BinaryOp::Add, matrix, bias, matrix);
+    }
+
+    /**
+     * @brief Multiplies every row of a matrix by its own factor, in place
+     *
+     * @tparam T Data type (float or double)
+     * @param matrix Matrix view of shape (rows, cols)
+     * @param scale Vector view of shape (rows)
+     * @throw ShapeError if the shapes do not match
+     */
+    template <typename T>
+    void scale_rows(const core::TensorView<T> &matrix, const core::TensorView<T> &scale)
+    {
+      TF_CHECK(matrix.rank() == 2 && scale.rank() == 1 && scale.dim(0) == matrix.dim(0),
+               core::ShapeError, "Scale must have one entry per row");
+
+      // The scale as a (rows, 1) column, repeated along each row
+      const core::TensorView<T> column(scale.buffer(), core::Shape({scale.dim(0), 1}),
+                                       core::shape_t{scale.stride(0), 0}, scale.offset());
+      binary(BinaryOp::Multiply, matrix, column, matrix);
+    }
+  } // namespace math
+} // namespace tf
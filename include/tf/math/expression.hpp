@@ -0,0 +1,512 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/core/thread_pool.hpp>
+#include <tf/math/elementwise.hpp>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+namespace tf
+{
+  namespace math
+  {
+    // Lazy elementwise expressions
+    //
+    // Arithmetic on views (and on scalars) builds an expression tree
+    // instead of computing anything: relu(a * b + c) is a value of type
+    // UnaryExpression<Relu, BinaryExpression<Add, BinaryExpression<Multiply,
+    // ...>>>. assign() and evaluate() then run the whole tree in a single
+    // pass over the output. The pass is tiled: each node computes
+    // EXPRESSION_BLOCK elements into a stack block with the SIMD kernels of
+    // the elementwise layer, so the intermediates stay in L1 and no
+    // intermediate tensors are allocated. Operands broadcast like in
+    // binary().
+    //
+    // The operators are found by argument-dependent lookup when an operand
+    // is an expression; combining two plain views needs the tf::math
+    // operators in scope (using namespace tf::math).
+
+    namespace detail
+    {
+      /**
+       * @brief Elements per parallel chunk
+       */
+      constexpr size_t EXPRESSION_GRAIN = 1 << 14;
+
+      /**
+       * @brief Elements each node computes at a time
+       */
+      constexpr size_t EXPRESSION_BLOCK = 256;
+
+      /**
+       * @brief Result of a node over one block: element i is
+       * data[i * inc], with inc 0 (one repeated value) or 1
+       */
+      template <typename T>
+      struct BlockOperand
+      {
+        const T *data;
+        size_t inc;
+      };
+
+      /**
+       * @brief Position of one block and the storage its nodes work in
+       *
+       * Nodes consume leaves and scratch slots in traversal order.
+       */
+      template <typename T, size_t Leaves>
+      struct BlockState
+      {
+        std::array<const T *, Leaves> base;      ///< Leaf pointers at the start of the run
+        std::array<core::index_t, Leaves> inner; ///< Innermost stride of each leaf
+        T (*scratch)[EXPRESSION_BLOCK];          ///< One block per slot
+        size_t begin;                            ///< First element of the block in the run
+        size_t size;                             ///< Elements in the block
+        size_t leaf;
+        size_t slot;
+      };
+    } // namespace detail
+
+    template <typename T>
+    class TerminalExpression;
+
+    template <typename T>
+    class ScalarExpression;
+
+    template <BinaryOp Op, typename L, typename R>
+    class BinaryExpression;
+
+    template <UnaryOp Op, typename E>
+    class UnaryExpression;
+
+    template <typename E>
+    struct is_expression : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_expression<TerminalExpression<T>> : std::true_type
+    {
+    };
+
+    template <typename T>
+    struct is_expression<ScalarExpression<T>> : std::true_type
+    {
+    };
+
+    template <BinaryOp Op, typename L, typename R>
+    struct is_expression<BinaryExpression<Op, L, R>> : std::true_type
+    {
+    };
+
+    template <UnaryOp Op, typename E>
+    struct is_expression<UnaryExpression<Op, E>> : std::true_type
+    {
+    };
+
+    template <typename E>
+    struct is_tensor_view : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_tensor_view<core::TensorView<T>> : std::true_type
+    {
+    };
+
+    /**
+     * @brief An expression node, or a view that becomes a leaf
+     */
+    template <typename E>
+    concept ExpressionOperand = is_expression<std::remove_cvref_t<E>>::value ||
+                                is_tensor_view<std::remove_cvref_t<E>>::value;
+
+    namespace detail
+    {
+      template <typename E>
+      struct operand_node
+      {
+        using type = E;
+      };
+
+      template <typename T>
+      struct operand_node<core::TensorView<T>>
+      {
+        using type = TerminalExpression<T>;
+      };
+
+      /**
+       * @brief Node type an operand is stored as
+       */
+      template <typename E>
+      using node_t = typename operand_node<std::remove_cvref_t<E>>::type;
+
+      /**
+       * @brief Element type of an operand
+       */
+      template <typename E>
+      using value_t = typename node_t<E>::value_type;
+    } // namespace detail
+
+    /**
+     * @class TerminalExpression
+     * @brief Leaf reading a view
+     *
+     * @tparam T Element type
+     */
+    template <typename T>
+    class TerminalExpression
+    {
+    public:
+      using value_type = T;
+      static constexpr size_t leaves = 1;
+      static constexpr size_t slots = 1;
+
+      TerminalExpression(const core::TensorView<T> &view) : m_view(view) {}
+
+      core::Shape shape() const { return m_view.shape(); }
+
+      template <typename F>
+      void for_each_leaf(F &&f) const { f(m_view); }
+
+      template <size_t Leaves>
+      detail::BlockOperand<T> evaluate(detail::BlockState<T, Leaves> &state, T *) const
+      {
+        const size_t leaf = state.leaf++;
+        T *block = state.scratch[state.slot++];
+
+        const core::index_t stride = state.inner[leaf];
+        const T *x = state.base[leaf] + static_cast<core::index_t>(state.begin) * stride;
+        if (stride <= 1)
+          return {x, static_cast<size_t>(stride)};
+
+        for (size_t i = 0; i < state.size; ++i)
+          block[i] = x[static_cast<core::index_t>(i) * stride];
+        return {block, 1};
+      }
+
+    private:
+      core::TensorView<T> m_view;
+    };
+
+    /**
+     * @class ScalarExpression
+     * @brief Leaf holding one value, repeated over every element
+     *
+     * @tparam T Element type
+     */
+    template <typename T>
+    class ScalarExpression
+    {
+    public:
+      using value_type = T;
+      static constexpr size_t leaves = 0;
+      static constexpr size_t slots = 0;
+
+      explicit ScalarExpression(T value) : m_value(value) {}
+
+      core::Shape shape() const { return core::Shape(); }
+
+      template <typename F>
+      void for_each_leaf(F &&) const {}
+
+      template <size_t Leaves>
+      detail::BlockOperand<T> evaluate(detail::BlockState<T, Leaves> &, T *) const
+      {
+        return {&m_value, 0};
+      }
+
+    private:
+      T m_value;
+    };
+
+    /**
+     * @class BinaryExpression
+     * @brief Node applying a binary operation to two subexpressions
+     *
+     * @tparam Op Operation
+     * @tparam L Left node type
+     * @tparam R Right node type
+     */
+    template <BinaryOp Op, typename L, typename R>
+    class BinaryExpression
+    {
+    public:
+      using value_type = typename L::value_type;
+      static constexpr size_t leaves = L::leaves + R::leaves;
+      static constexpr size_t slots = L::slots + R::slots + 1;
+
+      BinaryExpression(L lhs, R rhs) : m_lhs(std::move(lhs)), m_rhs(std::move(rhs)) {}
+
+      /**
+       * @brief Gets the broadcast shape of the operands
+       *
+       * @return core::Shape Shape of the result
+       * @throw ShapeError if the operands do not broadcast
+       */
+      core::Shape shape() const { return core::broadcast_shapes(m_lhs.shape(), m_rhs.shape()); }
+
+      template <typename F>
+      void for_each_leaf(F &&f) const
+      {
+        m_lhs.for_each_leaf(f);
+        m_rhs.for_each_leaf(f);
+      }
+
+      template <size_t Leaves>
+      detail::BlockOperand<value_type> evaluate(detail::BlockState<value_type, Leaves> &state,
+                                                value_type *target) const
+      {
+        const auto x = m_lhs.evaluate(state, nullptr);
+        const auto y = m_rhs.evaluate(state, nullptr);
+        value_type *z = target ? target : state.scratch[state.slot++];
+
+        // Repeated operands give a repeated result, computed once
+        const size_t inc = x.inc | y.inc;
+        binary_block(Op, inc ? state.size : 1, x.data, x.inc, y.data, y.inc, z);
+        return {z, inc};
+      }
+
+    private:
+      L m_lhs;
+      R m_rhs;
+    };
+
+    /**
+     * @class UnaryExpression
+     * @brief Node applying a unary operation to a subexpression
+     *
+     * @tparam Op Operation
+     * @tparam E Operand node type
+     */
+    template <UnaryOp Op, typename E>
+    class UnaryExpression
+    {
+    public:
+      using value_type = typename E::value_type;
+      static constexpr size_t leaves = E::leaves;
+      static constexpr size_t slots = E::slots + 1;
+
+      explicit UnaryExpression(E operand) : m_operand(std::move(operand)) {}
+
+      core::Shape shape() const { return m_operand.shape(); }
+
+      template <typename F>
+      void for_each_leaf(F &&f) const { m_operand.for_each_leaf(f); }
+
+      template <size_t Leaves>
+      detail::BlockOperand<value_type> evaluate(detail::BlockState<value_type, Leaves> &state,
+                                                value_type *target) const
+      {
+        const auto x = m_operand.evaluate(state, nullptr);
+        value_type *y = target ? target : state.scratch[state.slot++];
+
+        unary_block(Op, x.inc ? state.size : 1, x.data, y);
+        return {y, x.inc};
+      }
+
+    private:
+      E m_operand;
+    };
+
+    /**
+     * @brief Wraps an operand as an expression node
+     *
+     * @param operand View or expression
+     * @return detail::node_t<E> Node holding the operand
+     */
+    template <ExpressionOperand E>
+    detail::node_t<E> as_expression(const E &operand)
+    {
+      return detail::node_t<E>(operand);
+    }
+
+    /**
+     * @brief Evaluates an expression into an existing view
+     *
+     * The expression is computed in one tiled pass; rows of the output are
+     * split across the thread pool. out may be one of the expression's
+     * inputs if it has the same layout there (a = relu(a * b)).
+     *
+     * @param out Output, which the expression broadcasts to
+     * @param expression View or expression
+     * @throw ShapeError if the operands do not broadcast to the output shape
+     * or the output repeats elements
+     */
+    template <typename T, ExpressionOperand E>
+      requires std::same_as<detail::value_t<E>, T>
+    void assign(const core::TensorView<T> &out, const E &expression)
+    {
+      using Node = detail::node_t<E>;
+      constexpr size_t LEAVES = Node::leaves;
+
+      const Node node = as_expression(expression);
+      TF_CHECK(node.shape().is_broadcastable_to(out.shape()), core::ShapeError,
+               "Expression does not broadcast to the output shape");
+      for (size_t i = 0; i < out.rank(); ++i)
+        TF_CHECK(out.dim(i) <= 1 || out.stride(i) != 0, core::ShapeError,
+                 "Elementwise output repeats elements");
+
+      const size_t count = static_cast<size_t>(out.num_elements());
+      if (count == 0)
+        return;
+
+      // Strides of the output, then of every leaf broadcast to it
+      std::array<core::shape_t, LEAVES + 1> strides;
+      std::array<T *, LEAVES + 1> base;
+      strides[0] = out.strides();
+      base[0] = out.data();
+      size_t leaf = 1;
+      node.for_each_leaf([&](const core::TensorView<T> &view)
+                         {
+                           const core::TensorView<T> input = view.broadcast_to(out.shape());
+                           strides[leaf] = input.strides();
+                           base[leaf] = input.data();
+                           ++leaf; });
+
+      core::shape_t dims = out.shape().dims();
+      core::detail::collapse_dims(dims, strides);
+
+      const size_t r = dims.size();
+      const core::index_t inner = r > 0 ? dims[r - 1] : 1;
+      std::array<core::index_t, LEAVES> inner_strides{};
+      for (size_t k = 0; k < LEAVES; ++k)
+        inner_strides[k] = r > 0 ? strides[k + 1][r - 1] : 1;
+      const core::index_t sz = r > 0 ? strides[0][r - 1] : 1;
+
+      // Elements [begin, end) of the innermost run starting at row
+      auto run = [&](core::index_t row, size_t begin, size_t end)
+      {
+        T scratch[Node::slots > 0 ? Node::slots : 1][detail::EXPRESSION_BLOCK];
+
+        detail::BlockState<T, LEAVES> state;
+        state.inner = inner_strides;
+        state.scratch = scratch;
+        for (size_t k = 0; k < LEAVES; ++k)
+          state.base[k] = base[k + 1] + core::detail::strided_offset(row, dims, strides[k + 1], r - 1);
+        T *z = base[0] + core::detail::strided_offset(row, dims, strides[0], r - 1);
+
+        for (size_t b = begin; b < end; b += detail::EXPRESSION_BLOCK)
+        {
+          state.begin = b;
+          state.size = std::min(detail::EXPRESSION_BLOCK, end - b);
+          state.leaf = 0;
+          state.slot = 0;
+
+          T *target = sz == 1 ? z + b : nullptr;
+          const detail::BlockOperand<T> result = node.evaluate(state, target);
+
+          if (sz == 1)
+          {
+            if (result.inc == 0)
+            {
+              const T value = result.data[0];
+              std::fill_n(target, state.size, value);
+            }
+            else if (result.data != target)
+            {
+              std::copy_n(result.data, state.size, target);
+            }
+          }
+          else
+          {
+            for (size_t i = 0; i < state.size; ++i)
+              z[static_cast<core::index_t>(b + i) * sz] = result.data[i * result.inc];
+          }
+        }
+      };
+
+      const size_t rows = count / static_cast<size_t>(inner);
+      if (rows == 1)
+      {
+        core::parallel_for(0, static_cast<size_t>(inner), detail::EXPRESSION_GRAIN,
+                           [&](size_t begin, size_t end)
+                           { run(0, begin, end); });
+        return;
+      }
+
+      const size_t grain = std::max<size_t>(1, detail::EXPRESSION_GRAIN / static_cast<size_t>(inner));
+      core::parallel_for(0, rows, grain, [&](size_t begin, size_t end)
+                         {
+                           for (size_t row = begin; row < end; ++row)
+                             run(static_cast<core::index_t>(row), 0, static_cast<size_t>(inner)); });
+    }
+
+    /**
+     * @brief Evaluates an expression into a new dense tensor
+     *
+     * @param expression View or expression
+     * @return core::TensorView<T> Result of the broadcast shape of the
+     * operands
+     * @throw ShapeError if the operands do not broadcast
+     */
+    template <ExpressionOperand E>
+    core::TensorView<detail::value_t<E>> evaluate(const E &expression)
+    {
+      const detail::node_t<E> node = as_expression(expression);
+      auto out = core::TensorView<detail::value_t<E>>::allocate(node.shape());
+      assign(out, node);
+      return out;
+    }
+
+    // Building expressions
+
+#define TF_EXPRESSION_BINARY(NAME, OP)                                                        \
+  template <ExpressionOperand A, ExpressionOperand B>                                         \
+    requires std::same_as<detail::value_t<A>, detail::value_t<B>>                             \
+  BinaryExpression<OP, detail::node_t<A>, detail::node_t<B>> NAME(const A &a, const B &b)     \
+  {                                                                                           \
+    return {as_expression(a), as_expression(b)};                                              \
+  }                                                                                           \
+                                                                                              \
+  template <ExpressionOperand A>                                                              \
+  BinaryExpression<OP, detail::node_t<A>, ScalarExpression<detail::value_t<A>>>               \
+  NAME(const A &a, detail::value_t<A> b)                                                      \
+  {                                                                                           \
+    return {as_expression(a), ScalarExpression<detail::value_t<A>>(b)};                       \
+  }                                                                                           \
+                                                                                              \
+  template <ExpressionOperand B>                                                              \
+  BinaryExpression<OP, ScalarExpression<detail::value_t<B>>, detail::node_t<B>>               \
+  NAME(detail::value_t<B> a, const B &b)                                                      \
+  {                                                                                           \
+    return {ScalarExpression<detail::value_t<B>>(a), as_expression(b)};                       \
+  }
+
+    TF_EXPRESSION_BINARY(operator+, BinaryOp::Add)
+    TF_EXPRESSION_BINARY(operator-, BinaryOp::Subtract)
+    TF_EXPRESSION_BINARY(operator*, BinaryOp::Multiply)
+    TF_EXPRESSION_BINARY(operator/, BinaryOp::Divide)
+    TF_EXPRESSION_BINARY(maximum, BinaryOp::Maximum)
+    TF_EXPRESSION_BINARY(minimum, BinaryOp::Minimum)
+
+#undef TF_EXPRESSION_BINARY
+
+    // Taken by value, so that these are preferred over the scalar
+    // activation templates in utils.hpp as more constrained
+
+#define TF_EXPRESSION_UNARY(NAME, OP)                                \
+  template <ExpressionOperand E>                                     \
+  UnaryExpression<OP, detail::node_t<E>> NAME(E a)                   \
+  {                                                                  \
+    return UnaryExpression<OP, detail::node_t<E>>(as_expression(a)); \
+  }
+
+    TF_EXPRESSION_UNARY(operator-, UnaryOp::Negate)
+    TF_EXPRESSION_UNARY(abs, UnaryOp::Abs)
+    TF_EXPRESSION_UNARY(sqrt, UnaryOp::Sqrt)
+    TF_EXPRESSION_UNARY(square, UnaryOp::Square)
+    TF_EXPRESSION_UNARY(relu, UnaryOp::Relu)
+    TF_EXPRESSION_UNARY(sigmoid, UnaryOp::Sigmoid)
+    TF_EXPRESSION_UNARY(tanh, UnaryOp::Tanh)
+
+#undef TF_EXPRESSION_UNARY
+  } // namespace math
+} // namespace tf
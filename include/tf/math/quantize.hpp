@@ -0,0 +1,200 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/utils.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tf
+{
+  namespace math
+  {
+    /**
+     * @struct QuantParams
+     * @brief Affine mapping between float values and int8 levels
+     *
+     * q = clamp(round(x / scale) + zero_point, -128, 127), rounding to
+     * nearest even, and x = (q - zero_point) * scale. With one scale the
+     * mapping covers the whole tensor; with several, channel c (index c
+     * along axis) has its own scale and zero point.
+     */
+    struct QuantParams
+    {
+      std::vector<float> scale{1.0f};          ///< Positive step between levels, per channel
+      std::vector<std::int32_t> zero_point{0}; ///< Level of 0.0, in [-128, 127], per channel
+      size_t axis = 0;                         ///< Dimension of the channels, if more than one
+
+      size_t channels() const { return scale.size(); }
+
+      /**
+       * @brief Checks the parameters on their own, without a tensor
+       *
+       * @throw ValueError if there is no channel, the scales and zero
+       * points differ in count, a scale is not positive and finite or a
+       * zero point is outside [-128, 127]
+       */
+      void validate() const;
+
+      /**
+       * @brief Makes parameters shared by the whole tensor
+       *
+       * @param scale Step between levels
+       * @param zero_point Level of 0.0
+       * @return QuantParams Per-tensor parameters
+       */
+      static QuantParams per_tensor(float scale, std::int32_t zero_point = 0)
+      {
+        return QuantParams{{scale}, {zero_point}, 0};
+      }
+    };
+
+    /**
+     * @enum CalibrationMethod
+     * @brief How a calibrator picks the float range mapped to the levels
+     */
+    enum class CalibrationMethod
+    {
+      MinMax,    ///< Smallest and largest value seen
+      MeanStddev ///< mean +- num_stddev standard deviations, within MinMax
+    };
+
+    /**
+     * @struct CalibrationOptions
+     * @brief Range statistic and layout of the parameters a calibrator
+     * produces
+     */
+    struct CalibrationOptions
+    {
+      CalibrationMethod method = CalibrationMethod::MinMax;
+      float num_stddev = 4.0f;  ///< Half-width of the MeanStddev range
+      bool symmetric = false;   ///< Zero point 0 and levels [-127, 127], as for weights
+      bool per_channel = false; ///< One scale per index along axis
+      size_t axis = 0;          ///< Dimension of the channels
+    };
+
+    /**
+     * @class Calibrator
+     * @brief Collects the range of the values a tensor takes over many
+     * batches and turns it into quantization parameters
+     *
+     * Each batch is reduced to per-channel moments (see axis_moments) and
+     * extremes, which are merged across batches, so memory does not grow
+     * with their number. The range always contains 0, which therefore maps
+     * to a level exactly.
+     */
+    class Calibrator
+    {
+    public:
+      explicit Calibrator(const CalibrationOptions &options = {}) : m_options(options) {}
+
+      /**
+       * @brief Adds a batch of values
+       *
+       * @param x Batch; for per-channel options its dimension axis is the
+       * channel count, which every batch must share
+       * @throw ShapeError if axis is out of range or the channel count
+       * changes between batches
+       */
+      void observe(const core::TensorView<float> &x);
+
+      /**
+       * @brief Gets the parameters for the values observed so far
+       *
+       * A channel that only held zeros (or nothing) gets scale 1.
+       *
+       * @return QuantParams Parameters with one channel, or one per index
+       * along axis
+       */
+      QuantParams params() const;
+
+      /**
+       * @brief Forgets every observed batch
+       */
+      void reset();
+
+      const CalibrationOptions &options() const { return m_options; }
+
+    private:
+      CalibrationOptions m_options;
+      std::vector<Moments<double>> m_moments;
+      std::vector<float> m_min;
+      std::vector<float> m_max;
+    };
+
+    /**
+     * @brief Calibrates the parameters of a single tensor
+     *
+     * @param x Values to cover
+     * @param options Range statistic and layout
+     * @return QuantParams Parameters for x
+     * @throw ShapeError if a per-channel axis is out of range
+     */
+    QuantParams calibrate(const core::TensorView<float> &x, const CalibrationOptions &options = {});
+
+    /**
+     * @brief Quantizes a tensor to int8
+     *
+     * Runs on SIMD kernels split across the thread pool. A strided input is
+     * made contiguous first.
+     *
+     * @param x Input
+     * @param params Per-tensor parameters, or one channel per index along
+     * params.axis
+     * @param out Contiguous output of the shape of x
+     * @throw ShapeError if the shapes differ, out is not contiguous or the
+     * channels do not match the axis
+     * @throw ValueError if a scale is not positive and finite or a zero
+     * point is out of range
+     */
+    void quantize(const core::TensorView<float> &x, const QuantParams &params,
+                  const core::TensorView<std::int8_t> &out);
+
+    /**
+     * @brief Maps an int8 tensor back to float
+     *
+     * @param x Quantized input
+     * @param params Parameters x was quantized with
+     * @param out Contiguous output of the shape of x
+     * @throw ShapeError if the shapes differ, out is not contiguous or the
+     * channels do not match the axis
+     * @throw ValueError if a scale is not positive and finite or a zero
+     * point is out of range
+     */
+    void dequantize(const core::TensorView<std::int8_t> &x, const QuantParams &params,
+                    const core::TensorView<float> &out);
+
+    /**
+     * @brief Quantizes a tensor into a new dense tensor
+     *
+     * @param x Input
+     * @param params Quantization parameters
+     * @return core::TensorView<std::int8_t> Levels of the shape of x
+     */
+    inline core::TensorView<std::int8_t> quantize(const core::TensorView<float> &x,
+                                                  const QuantParams &params)
+    {
+      auto out = core::TensorView<std::int8_t>::allocate(x.shape());
+      quantize(x, params, out);
+      return out;
+    }
+
+    /**
+     * @brief Maps an int8 tensor back to float into a new dense tensor
+     *
+     * @param x Quantized input
+     * @param params Parameters x was quantized with
+     * @return core::TensorView<float> Values of the shape of x
+     */
+    inline core::TensorView<float> dequantize(const core::TensorView<std::int8_t> &x,
+                                              const QuantParams &params)
+    {
+      auto out = core::TensorView<float>::allocate(x.shape());
+      dequantize(x, params, out);
+      return out;
+    }
+  } // namespace math
+} // namespace tf
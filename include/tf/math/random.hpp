@@ -3,19 +3,165 @@
 #include <tf/core/types.hpp>
 #include <tf/core/error.hpp>
 
-#include <random>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <mutex>
-#include <thread>
-#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace tf
 {
   namespace math
   {
+    /**
+     * @class Philox4x32
+     * @brief Counter-based Philox4x32-10 random number generator
+     *
+     * Every 128-bit output block is a pure function of a 64-bit key (the
+     * seed), a 64-bit stream id and a 64-bit block counter (Salmon et al.,
+     * "Parallel Random Numbers: As Easy as 1, 2, 3"). Streams can therefore
+     * be split across threads or chunks without changing the values. The
+     * class satisfies UniformRandomBitGenerator, so it also works with the
+     * <random> distributions.
+     */
+    class Philox4x32
+    {
+    public:
+      using result_type = uint32_t;
+      using block_type = std::array<uint32_t, 4>;
+
+      /**
+       * @brief Constructs a generator at the start of a stream
+       *
+       * @param seed Key of the generator
+       * @param stream Stream id, e.g. a thread or chunk index
+       */
+      explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0)
+          : m_key(seed), m_stream(stream) {}
+
+      /**
+       * @brief Computes one output block
+       *
+       * @param key Key (seed)
+       * @param stream Stream id (high half of the counter)
+       * @param counter Block index (low half of the counter)
+       * @return block_type Four random 32-bit words
+       */
+      static constexpr block_type block(uint64_t key, uint64_t stream, uint64_t counter)
+      {
+        uint32_t c0 = static_cast<uint32_t>(counter);
+        uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+        uint32_t c2 = static_cast<uint32_t>(stream);
+        uint32_t c3 = static_cast<uint32_t>(stream >> 32);
+        uint32_t k0 = static_cast<uint32_t>(key);
+        uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+        for (int round = 0; round < 10; ++round)
+        {
+          const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+          const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+
+          c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+          c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+          c1 = static_cast<uint32_t>(p1);
+          c3 = static_cast<uint32_t>(p0);
+
+          k0 += 0x9E3779B9u;
+          k1 += 0xBB67AE85u;
+        }
+
+        return block_type{c0, c1, c2, c3};
+      }
+
+      /**
+       * @brief Gets the next 32-bit word of the stream
+       *
+       * @return result_type Random word
+       */
+      result_type operator()()
+      {
+        const uint64_t index = m_position / 4;
+        if (index != m_cached || !m_valid)
+        {
+          m_block = block(m_key, m_stream, index);
+          m_cached = index;
+          m_valid = true;
+        }
+
+        return m_block[m_position++ % 4];
+      }
+
+      /**
+       * @brief Skips words in constant time
+       *
+       * @param n Number of words to skip
+       */
+      void discard(unsigned long long n) { m_position += n; }
+
+      uint64_t seed() const { return m_key; }
+      uint64_t stream() const { return m_stream; }
+
+      static constexpr result_type min() { return 0; }
+      static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    private:
+      uint64_t m_key;
+      uint64_t m_stream;
+      uint64_t m_position = 0; ///< Index of the next word
+      uint64_t m_cached = 0;
+      bool m_valid = false;
+      block_type m_block{};
+    };
+
+    /**
+     * @brief Fills an array with elements [offset, offset + size) of a
+     * uniform Philox stream
+     *
+     * Runs vectorized on core::thread_pool(); the values depend only on
+     * the seed, stream and offset, never on the number of threads.
+     *
+     * @param data Output array
+     * @param size Number of elements
+     * @param min Lower bound (inclusive)
+     * @param max Upper bound (exclusive)
+     * @param seed Generator key
+     * @param stream Stream id
+     * @param offset Index of the first element within the stream
+     * @throw ValueError if data is null and size is not zero
+     */
+    void philox_uniform(float *data, size_t size, float min, float max,
+                        uint64_t seed, uint64_t stream = 0, uint64_t offset = 0);
+    void philox_uniform(double *data, size_t size, double min, double max,
+                        uint64_t seed, uint64_t stream = 0, uint64_t offset = 0);
+
+    /**
+     * @brief Fills an array with elements [offset, offset + size) of a
+     * normal (Box-Muller) Philox stream
+     *
+     * @param data Output array
+     * @param size Number of elements
+     * @param mean Mean value
+     * @param stddev Standard deviation value
+     * @param seed Generator key
+     * @param stream Stream id
+     * @param offset Index of the first element within the stream
+     * @throw ValueError if data is null and size is not zero
+     */
+    void philox_normal(float *data, size_t size, float mean, float stddev,
+                       uint64_t seed, uint64_t stream = 0, uint64_t offset = 0);
+    void philox_normal(double *data, size_t size, double mean, double stddev,
+                       uint64_t seed, uint64_t stream = 0, uint64_t offset = 0);
+
     /**
      * @class RandomGenerator
      * @brief Thread-safe random number generator with various distributions
+     *
+     * Backed by a single Philox4x32 stream: every draw or fill reserves the
+     * next range of block counters with one atomic increment and computes
+     * its values from them, without a lock. For a given seed the values
+     * depend only on the order of calls, not on the number of threads.
      */
     class RandomGenerator
     {
@@ -29,15 +175,19 @@ namespace tf
       /**
        * @brief Set the seed object for the random number generator
        *
+       * Also restarts the stream.
+       *
        * @param seed The seed value
        * @version 1.0.0
        */
       void set_seed(uint64_t seed)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_generator.seed(seed);
+        m_seed.store(seed, std::memory_order_relaxed);
+        m_counter.store(0, std::memory_order_relaxed);
       }
 
+      uint64_t seed() const { return m_seed.load(std::memory_order_relaxed); }
+
       /**
        * @brief Uniform distribution random number generator
        *
@@ -50,18 +200,12 @@ namespace tf
       template <typename T>
       T uniform(T min = T{0}, T max = T{1})
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        const Philox4x32::block_type w = next_block(1);
 
         if constexpr (std::is_integral_v<T>)
-        {
-          std::uniform_int_distribution<T> dist(min, max);
-          return dist(m_generator);
-        }
+          return uniform_integer(w, min, max);
         else
-        {
-          std::uniform_real_distribution<T> dist(min, max);
-          return dist(m_generator);
-        }
+          return min + (max - min) * static_cast<T>(unit(w[0], w[1]));
       }
 
       /**
@@ -76,10 +220,7 @@ namespace tf
       template <typename T>
       T normal(T mean = T{0}, T stddev = T{1})
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        std::normal_distribution<T> dist(mean, stddev);
-        return dist(m_generator);
+        return mean + stddev * static_cast<T>(standard_normal(next_block(1)));
       }
 
       /**
@@ -91,15 +232,15 @@ namespace tf
        */
       bool bernoulli(double p = 0.5)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        std::bernoulli_distribution dist(p);
-
-        return dist(m_generator);
+        const Philox4x32::block_type w = next_block(1);
+        return unit(w[0], w[1]) < p;
       }
 
       /**
        * @brief Generate array of random values
        *
+       * Floating-point arrays are filled in parallel with philox_uniform.
+       *
        * @tparam T Type of the random number
        * @param data Pointer to the array
        * @param size Size of the array
@@ -109,25 +250,33 @@ namespace tf
       template <typename T>
       void fill_uniform(T *data, size_t size, T min = T{0}, T max = T{1})
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if constexpr (std::is_integral_v<T>)
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>)
         {
-          std::uniform_int_distribution<T> dist(min, max);
-          for (size_t i = 0; i < size; ++i)
-            data[i] = dist(m_generator);
+          const uint64_t offset = reserve_elements(size, 16 / sizeof(T));
+          philox_uniform(data, size, min, max, seed(), 0, offset);
         }
         else
         {
-          std::uniform_real_distribution<T> dist(min, max);
+          const uint64_t first = m_counter.fetch_add(size, std::memory_order_relaxed);
+          const uint64_t key = seed();
+
           for (size_t i = 0; i < size; ++i)
-            data[i] = dist(m_generator);
+          {
+            const Philox4x32::block_type w = Philox4x32::block(key, 0, first + i);
+
+            if constexpr (std::is_integral_v<T>)
+              data[i] = uniform_integer(w, min, max);
+            else
+              data[i] = min + (max - min) * static_cast<T>(unit(w[0], w[1]));
+          }
         }
       }
 
       /**
        * @brief Generate array of random values from normal distribution
        *
+       * Floating-point arrays are filled in parallel with philox_normal.
+       *
        * @tparam T Type of the random number
        * @param data Pointer to the array
        * @param size Size of the array
@@ -137,16 +286,24 @@ namespace tf
       template <typename T>
       void fill_normal(T *data, size_t size, T mean = T{0}, T stddev = T{1})
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>)
+        {
+          const uint64_t offset = reserve_elements(size, 16 / sizeof(T));
+          philox_normal(data, size, mean, stddev, seed(), 0, offset);
+        }
+        else
+        {
+          const uint64_t first = m_counter.fetch_add(size, std::memory_order_relaxed);
+          const uint64_t key = seed();
 
-        std::normal_distribution<T> dist(mean, stddev);
-        for (size_t i = 0; i < size; ++i)
-          data[i] = dist(m_generator);
+          for (size_t i = 0; i < size; ++i)
+            data[i] = mean + stddev * static_cast<T>(standard_normal(Philox4x32::block(key, 0, first + i)));
+        }
       }
 
     private:
-      mutable std::mutex m_mutex;
-      std::mt19937_64 m_generator;
+      std::atomic<uint64_t> m_seed{0};
+      std::atomic<uint64_t> m_counter{0}; ///< Next unused block of the stream
 
       RandomGenerator()
       {
@@ -154,8 +311,54 @@ namespace tf
                         .time_since_epoch()
                         .count();
 
-        m_generator.seed(static_cast<uint64_t>(seed));
+        set_seed(static_cast<uint64_t>(seed));
+      }
+
+      Philox4x32::block_type next_block(uint64_t count)
+      {
+        return Philox4x32::block(seed(), 0, m_counter.fetch_add(count, std::memory_order_relaxed));
+      }
+
+      /**
+       * @brief Reserves whole blocks for size elements
+       *
+       * @return uint64_t Stream offset (in elements) of the first one
+       */
+      uint64_t reserve_elements(size_t size, size_t per_block)
+      {
+        const uint64_t blocks = (size + per_block - 1) / per_block;
+        return m_counter.fetch_add(blocks, std::memory_order_relaxed) * per_block;
+      }
+
+      /**
+       * @brief Uniform double in [0, 1), or (0, 1] when open_low
+       */
+      static double unit(uint32_t hi, uint32_t lo, bool open_low = false)
+      {
+        const uint64_t bits = ((static_cast<uint64_t>(hi) << 32) | lo) >> 11;
+        return static_cast<double>(bits + (open_low ? 1 : 0)) * 0x1p-53;
+      }
+
+      static double standard_normal(const Philox4x32::block_type &w)
+      {
+        constexpr double two_pi = 6.283185307179586476925;
+        const double radius = std::sqrt(-2.0 * std::log(unit(w[0], w[1], true)));
+        return radius * std::cos(two_pi * unit(w[2], w[3]));
+      }
+
+      template <typename T>
+      static T uniform_integer(const Philox4x32::block_type &w, T min, T max)
+      {
+        using U = std::make_unsigned_t<T>;
+        const uint64_t bits = (static_cast<uint64_t>(w[0]) << 32) | w[1];
+        const uint64_t range = static_cast<uint64_t>(static_cast<U>(static_cast<U>(max) - static_cast<U>(min)));
+
+        // The modulo bias is at most range / 2^64
+        if (range == std::numeric_limits<uint64_t>::max())
+          return static_cast<T>(bits);
+
+        return static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(bits % (range + 1))));
       }
     };
   } // namespace math
-} // namespace tf
\ No newline at end of file
+} // namespace tf
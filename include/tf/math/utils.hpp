@@ -1,9 +1,14 @@
 #pragma once
 
 #include <tf/core/types.hpp>
+#include <tf/core/thread_pool.hpp>
 #include <cmath>
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <numeric>
+#include <type_traits>
 
 namespace tf
 {
@@ -99,20 +104,6 @@ namespace tf
       return x > T{0} ? x : alpha * x;
     }
 
-    /**
-     * @brief Softmax activation function
-     *
-     * @tparam T Type of the array
-     * @param x Input array
-     * @return T Softmax value of the input
-     * @version 1.0.0
-     */
-    template <typename T>
-    inline T softmax(T x)
-    {
-      return std::exp(x) / std::exp(x).sum();
-    }
-
     // Derivative of activation functions
     /**
      * @brief Derivative of the sigmoid activation function
@@ -125,7 +116,8 @@ namespace tf
     template <typename T>
     inline T sigmoid_derivative(T x)
     {
-      return sigmoid(x) * (T{1} - sigmoid(x));
+      const T s = sigmoid(x);
+      return s * (T{1} - s);
     }
 
     /**
@@ -139,7 +131,8 @@ namespace tf
     template <typename T>
     inline T tanh_derivative(T x)
     {
-      return T{1} - std::pow(tanh(x), T{2});
+      const T t = tanh(x);
+      return T{1} - t * t;
     }
 
     /**
@@ -171,6 +164,568 @@ namespace tf
       return x > T{0} ? T{1} : alpha;
     }
 
+    // Activation functions over arrays
+    //
+    // These run vectorized on core::thread_pool(). sigmoid and tanh use a
+    // polynomial approximation of exp instead of libm: values are within
+    // 4 ULP and derivatives within 6 ULP of the exact result over the
+    // whole input range (measured maxima 3 and 4 ULP, float and double).
+    // Results within a few times the smallest normal number may be
+    // flushed to zero. The output arrays may alias the input.
+
+    /**
+     * @brief Sigmoid activation over an array
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = sigmoid(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void sigmoid(const float *in, float *out, size_t size);
+    void sigmoid(const double *in, double *out, size_t size);
+
+    /**
+     * @brief Sigmoid activation and its derivative in one pass
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = sigmoid(in[i])
+     * @param derivative Output array, derivative[i] = sigmoid_derivative(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void sigmoid_and_derivative(const float *in, float *out, float *derivative, size_t size);
+    void sigmoid_and_derivative(const double *in, double *out, double *derivative, size_t size);
+
+    /**
+     * @brief Hyperbolic tangent activation over an array
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = tanh(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void tanh(const float *in, float *out, size_t size);
+    void tanh(const double *in, double *out, size_t size);
+
+    /**
+     * @brief Hyperbolic tangent activation and its derivative in one pass
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = tanh(in[i])
+     * @param derivative Output array, derivative[i] = tanh_derivative(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void tanh_and_derivative(const float *in, float *out, float *derivative, size_t size);
+    void tanh_and_derivative(const double *in, double *out, double *derivative, size_t size);
+
+    /**
+     * @brief ReLU activation over an array
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = relu(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void relu(const float *in, float *out, size_t size);
+    void relu(const double *in, double *out, size_t size);
+
+    /**
+     * @brief ReLU activation and its derivative in one pass
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = relu(in[i])
+     * @param derivative Output array, derivative[i] = relu_derivative(in[i])
+     * @param size Number of elements
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void relu_and_derivative(const float *in, float *out, float *derivative, size_t size);
+    void relu_and_derivative(const double *in, double *out, double *derivative, size_t size);
+
+    /**
+     * @brief Leaky ReLU activation over an array
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = leaky_relu(in[i], alpha)
+     * @param size Number of elements
+     * @param alpha Leaky factor
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void leaky_relu(const float *in, float *out, size_t size, float alpha = 0.01f);
+    void leaky_relu(const double *in, double *out, size_t size, double alpha = 0.01);
+
+    /**
+     * @brief Leaky ReLU activation and its derivative in one pass
+     *
+     * @param in Input array
+     * @param out Output array, out[i] = leaky_relu(in[i], alpha)
+     * @param derivative Output array, derivative[i] = leaky_relu_derivative(in[i], alpha)
+     * @param size Number of elements
+     * @param alpha Leaky factor
+     * @throw ValueError if an array is null and size is not zero
+     */
+    void leaky_relu_and_derivative(const float *in, float *out, float *derivative,
+                                   size_t size, float alpha = 0.01f);
+    void leaky_relu_and_derivative(const double *in, double *out, double *derivative,
+                                   size_t size, double alpha = 0.01);
+
+    /**
+     * @brief Row-wise softmax of a row-major matrix
+     *
+     * out[i][j] = exp(in[i][j] - max_i) / sum_j exp(in[i][j] - max_i),
+     * computed with one online max-and-sum pass and one output pass per
+     * row; rows run in parallel on core::thread_pool(). Entries of -inf
+     * (masked positions) get a probability of zero.
+     *
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param in Input matrix with leading dimension ld_in
+     * @param ld_in Leading dimension of the input
+     * @param out Output matrix with leading dimension ld_out; may be in
+     * when ld_out equals ld_in
+     * @param ld_out Leading dimension of the output
+     * @throw ShapeError if a leading dimension is smaller than cols
+     * @throw ValueError if a matrix is null and not empty
+     */
+    void softmax(size_t rows, size_t cols, const float *in, size_t ld_in,
+                 float *out, size_t ld_out);
+    void softmax(size_t rows, size_t cols, const double *in, size_t ld_in,
+                 double *out, size_t ld_out);
+
+    /**
+     * @brief Row-wise log-softmax of a row-major matrix
+     *
+     * out[i][j] = in[i][j] - max_i - log(sum_j exp(in[i][j] - max_i)),
+     * which stays finite where softmax underflows to zero.
+     *
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param in Input matrix with leading dimension ld_in
+     * @param ld_in Leading dimension of the input
+     * @param out Output matrix with leading dimension ld_out; may be in
+     * when ld_out equals ld_in
+     * @param ld_out Leading dimension of the output
+     * @throw ShapeError if a leading dimension is smaller than cols
+     * @throw ValueError if a matrix is null and not empty
+     */
+    void log_softmax(size_t rows, size_t cols, const float *in, size_t ld_in,
+                     float *out, size_t ld_out);
+    void log_softmax(size_t rows, size_t cols, const double *in, size_t ld_in,
+                     double *out, size_t ld_out);
+
+    /**
+     * @struct Moments
+     * @brief Running count, mean and sum of squared deviations of a sample
+     *
+     * Values are added one at a time with Welford's update, and partial
+     * results (of separate chunks or threads) are combined with merge.
+     * Neither subtracts large sums, so the variance stays accurate when the
+     * mean is large compared to the spread.
+     *
+     * @tparam T Accumulator type
+     */
+    template <typename T>
+    struct Moments
+    {
+      size_t count = 0;
+      T mean = T{0};
+      T m2 = T{0}; ///< Sum of squared deviations from the mean
+
+      /**
+       * @brief Adds a value
+       *
+       * @param x Value to add
+       */
+      void push(T x)
+      {
+        ++count;
+        const T delta = x - mean;
+        mean += delta / static_cast<T>(count);
+        m2 += delta * (x - mean);
+      }
+
+      /**
+       * @brief Adds the values summarized by other
+       *
+       * @param other Moments of a disjoint sample
+       */
+      void merge(const Moments &other)
+      {
+        if (other.count == 0)
+          return;
+
+        if (count == 0)
+        {
+          *this = other;
+          return;
+        }
+
+        const T n = static_cast<T>(count + other.count);
+        const T delta = other.mean - mean;
+        mean += delta * (static_cast<T>(other.count) / n);
+        m2 += other.m2 + delta * delta * (static_cast<T>(count) * static_cast<T>(other.count) / n);
+        count += other.count;
+      }
+
+      /**
+       * @brief Gets the sample variance
+       *
+       * @return T Variance with n - 1 degrees of freedom, 0 for fewer than
+       * two values
+       */
+      T variance() const
+      {
+        return count > 1 ? m2 / static_cast<T>(count - 1) : T{0};
+      }
+
+      /**
+       * @brief Gets the population variance
+       *
+       * @return T Variance with n degrees of freedom, 0 when empty
+       */
+      T population_variance() const
+      {
+        return count > 0 ? m2 / static_cast<T>(count) : T{0};
+      }
+    };
+
+    /**
+     * @struct CoMoments
+     * @brief Running moments of two paired samples and their co-deviation
+     *
+     * @tparam T Accumulator type
+     */
+    template <typename T>
+    struct CoMoments
+    {
+      size_t count = 0;
+      T mean_x = T{0};
+      T mean_y = T{0};
+      T m2_x = T{0};
+      T m2_y = T{0};
+      T c_xy = T{0}; ///< Sum of products of the deviations from the means
+
+      /**
+       * @brief Adds a pair of values
+       *
+       * @param x Value of the first sample
+       * @param y Value of the second sample
+       */
+      void push(T x, T y)
+      {
+        ++count;
+        const T n = static_cast<T>(count);
+        const T dx = x - mean_x;
+        const T dy = y - mean_y;
+        mean_x += dx / n;
+        mean_y += dy / n;
+        m2_x += dx * (x - mean_x);
+        m2_y += dy * (y - mean_y);
+        c_xy += dx * (y - mean_y);
+      }
+
+      /**
+       * @brief Adds the pairs summarized by other
+       *
+       * @param other Co-moments of a disjoint sample
+       */
+      void merge(const CoMoments &other)
+      {
+        if (other.count == 0)
+          return;
+
+        if (count == 0)
+        {
+          *this = other;
+          return;
+        }
+
+        const T n = static_cast<T>(count + other.count);
+        const T weight = static_cast<T>(other.count) / n;
+        const T cross = static_cast<T>(count) * static_cast<T>(other.count) / n;
+        const T dx = other.mean_x - mean_x;
+        const T dy = other.mean_y - mean_y;
+
+        mean_x += dx * weight;
+        mean_y += dy * weight;
+        m2_x += other.m2_x + dx * dx * cross;
+        m2_y += other.m2_y + dy * dy * cross;
+        c_xy += other.c_xy + dx * dy * cross;
+        count += other.count;
+      }
+
+      /**
+       * @brief Gets the sample covariance
+       *
+       * @return T Covariance with n - 1 degrees of freedom, 0 for fewer
+       * than two pairs
+       */
+      T covariance() const
+      {
+        return count > 1 ? c_xy / static_cast<T>(count - 1) : T{0};
+      }
+
+      /**
+       * @brief Gets the Pearson correlation coefficient
+       *
+       * @return T Correlation, 0 for fewer than two pairs
+       */
+      T correlation() const
+      {
+        return count > 1 ? c_xy / std::sqrt(m2_x * m2_y) : T{0};
+      }
+    };
+
+    /**
+     * @brief Calculates the moments of an array in one read
+     *
+     * Large arrays are split across the thread pool and the partial
+     * moments merged.
+     *
+     * @param data Input array
+     * @param size Number of elements
+     * @return Moments Count, mean and sum of squared deviations
+     * @throw ValueError if data is null and size is not 0
+     */
+    Moments<float> moments(const float *data, size_t size);
+    Moments<double> moments(const double *data, size_t size);
+
+    /**
+     * @brief Calculates the co-moments of two arrays in one read
+     *
+     * @param x First array
+     * @param y Second array, of the same size
+     * @param size Number of elements of each array
+     * @return CoMoments Means, sums of squared deviations and co-deviation
+     * @throw ValueError if an array is null and size is not 0
+     */
+    CoMoments<float> comoments(const float *x, const float *y, size_t size);
+    CoMoments<double> comoments(const double *x, const double *y, size_t size);
+
+    /**
+     * @brief Calculates the moments of many strided lanes at once
+     *
+     * Lane l holds the count elements data[l * lane_stride + i * stride].
+     * Reducing axis k of a row-major tensor takes stride = the product of
+     * the dimensions after k and lanes = that product too with
+     * lane_stride = 1 (one lane per trailing index); reducing the last axis
+     * takes stride = 1 and lane_stride = its length. Both layouts are
+     * vectorized: adjacent lanes are reduced together in the first, each
+     * lane contiguously in the second. Other layouts are reduced element by
+     * element.
+     *
+     * @param count Number of elements per lane
+     * @param stride Distance between consecutive elements of a lane
+     * @param lanes Number of lanes
+     * @param lane_stride Distance between the first elements of two lanes
+     * @param data Input tensor
+     * @param out Moments of each lane, lanes entries
+     * @throw ValueError if data or out is null and the result is not empty
+     */
+    void axis_moments(size_t count, size_t stride, size_t lanes, size_t lane_stride,
+                      const float *data, Moments<float> *out);
+    void axis_moments(size_t count, size_t stride, size_t lanes, size_t lane_stride,
+                      const double *data, Moments<double> *out);
+
+    namespace detail
+    {
+      /**
+       * @brief Minimum number of elements per chunk of a parallel reduction
+       */
+      inline constexpr size_t REDUCTION_GRAIN = 1 << 15;
+
+      /**
+       * @brief std::accumulate that splits large random-access ranges
+       * across the thread pool
+       *
+       * Partial sums of the chunks are added together, so op must
+       * accumulate by addition.
+       *
+       * @tparam Iterator Type of the iterator
+       * @tparam T Type of the accumulator
+       * @tparam BinaryOp Type of the accumulation function
+       * @param begin Begin iterator
+       * @param end End iterator
+       * @param init Initial value
+       * @param op Accumulation function
+       * @return T Accumulated value
+       */
+      template <typename Iterator, typename T, typename BinaryOp>
+      T accumulate(Iterator begin, Iterator end, T init, BinaryOp op)
+      {
+        if constexpr (std::random_access_iterator<Iterator>)
+        {
+          using Diff = typename std::iterator_traits<Iterator>::difference_type;
+          auto size = static_cast<size_t>(std::distance(begin, end));
+
+          if (size > REDUCTION_GRAIN)
+            return core::parallel_reduce(
+                size_t{0}, size, REDUCTION_GRAIN, init,
+                [&](size_t b, size_t e)
+                { return std::accumulate(begin + static_cast<Diff>(b),
+                                         begin + static_cast<Diff>(e), T{0}, op); },
+                std::plus<T>());
+        }
+
+        return std::accumulate(begin, end, init, op);
+      }
+
+      /**
+       * @brief std::inner_product that splits large random-access ranges
+       * across the thread pool
+       *
+       * @tparam Iterator1 Type of the first iterator
+       * @tparam Iterator2 Type of the second iterator
+       * @tparam T Type of the accumulator
+       * @tparam BinaryOp Type of the element-wise product
+       * @param begin1 Begin iterator of the first array
+       * @param end1 End iterator of the first array
+       * @param begin2 Begin iterator of the second array
+       * @param init Initial value
+       * @param op Element-wise product, summed over the range
+       * @return T Sum of the element-wise products
+       */
+      template <typename Iterator1, typename Iterator2, typename T, typename BinaryOp>
+      T inner_product(Iterator1 begin1, Iterator1 end1, Iterator2 begin2, T init, BinaryOp op)
+      {
+        if constexpr (std::random_access_iterator<Iterator1> &&
+                      std::random_access_iterator<Iterator2>)
+        {
+          using Diff1 = typename std::iterator_traits<Iterator1>::difference_type;
+          using Diff2 = typename std::iterator_traits<Iterator2>::difference_type;
+          auto size = static_cast<size_t>(std::distance(begin1, end1));
+
+          if (size > REDUCTION_GRAIN)
+            return core::parallel_reduce(
+                size_t{0}, size, REDUCTION_GRAIN, init,
+                [&](size_t b, size_t e)
+                { return std::inner_product(begin1 + static_cast<Diff1>(b),
+                                            begin1 + static_cast<Diff1>(e),
+                                            begin2 + static_cast<Diff2>(b),
+                                            T{0}, std::plus<T>(), op); },
+                std::plus<T>());
+        }
+
+        return std::inner_product(begin1, end1, begin2, init, std::plus<T>(), op);
+      }
+
+      /**
+       * @brief Accumulator for the statistics of a value type: the type
+       * itself for floating point, double otherwise
+       */
+      template <typename T>
+      using StatisticType = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+      template <typename Iterator, typename T>
+      inline constexpr bool is_kernel_range =
+          std::contiguous_iterator<Iterator> &&
+          (std::is_same_v<T, float> || std::is_same_v<T, double>);
+
+      /**
+       * @brief Moments of a range in one pass
+       *
+       * Contiguous float and double ranges use the library kernels; large
+       * random-access ranges are split across the thread pool.
+       *
+       * @tparam Iterator Type of the iterator
+       * @param begin Begin iterator
+       * @param end End iterator
+       * @return Moments Moments in the statistic type of the value type
+       */
+      template <typename Iterator>
+      auto moments(Iterator begin, Iterator end)
+      {
+        using T = std::remove_cv_t<typename std::iterator_traits<Iterator>::value_type>;
+        using A = StatisticType<T>;
+
+        if constexpr (is_kernel_range<Iterator, T>)
+        {
+          return math::moments(std::to_address(begin), static_cast<size_t>(end - begin));
+        }
+        else
+        {
+          auto serial = [](Iterator b, Iterator e)
+          {
+            Moments<A> result;
+            for (; b != e; ++b)
+              result.push(static_cast<A>(*b));
+            return result;
+          };
+
+          if constexpr (std::random_access_iterator<Iterator>)
+          {
+            using Diff = typename std::iterator_traits<Iterator>::difference_type;
+            auto size = static_cast<size_t>(std::distance(begin, end));
+
+            if (size > REDUCTION_GRAIN)
+              return core::parallel_reduce(
+                  size_t{0}, size, REDUCTION_GRAIN, Moments<A>{},
+                  [&](size_t b, size_t e)
+                  { return serial(begin + static_cast<Diff>(b), begin + static_cast<Diff>(e)); },
+                  [](Moments<A> a, const Moments<A> &b)
+                  { a.merge(b); return a; });
+          }
+
+          return serial(begin, end);
+        }
+      }
+
+      /**
+       * @brief Co-moments of two ranges of equal length in one pass
+       *
+       * @tparam Iterator1 Type of the first iterator
+       * @tparam Iterator2 Type of the second iterator
+       * @param begin1 Begin iterator of the first array
+       * @param end1 End iterator of the first array
+       * @param begin2 Begin iterator of the second array
+       * @return CoMoments Co-moments in the statistic type of the first
+       * value type
+       */
+      template <typename Iterator1, typename Iterator2>
+      auto comoments(Iterator1 begin1, Iterator1 end1, Iterator2 begin2)
+      {
+        using T1 = std::remove_cv_t<typename std::iterator_traits<Iterator1>::value_type>;
+        using T2 = std::remove_cv_t<typename std::iterator_traits<Iterator2>::value_type>;
+        using A = StatisticType<T1>;
+
+        if constexpr (is_kernel_range<Iterator1, T1> && is_kernel_range<Iterator2, T1> &&
+                      std::is_same_v<T1, T2>)
+        {
+          return math::comoments(std::to_address(begin1), std::to_address(begin2),
+                                 static_cast<size_t>(end1 - begin1));
+        }
+        else
+        {
+          auto serial = [](Iterator1 b1, Iterator1 e1, Iterator2 b2)
+          {
+            CoMoments<A> result;
+            for (; b1 != e1; ++b1, ++b2)
+              result.push(static_cast<A>(*b1), static_cast<A>(*b2));
+            return result;
+          };
+
+          if constexpr (std::random_access_iterator<Iterator1> &&
+                        std::random_access_iterator<Iterator2>)
+          {
+            using Diff1 = typename std::iterator_traits<Iterator1>::difference_type;
+            using Diff2 = typename std::iterator_traits<Iterator2>::difference_type;
+            auto size = static_cast<size_t>(std::distance(begin1, end1));
+
+            if (size > REDUCTION_GRAIN)
+              return core::parallel_reduce(
+                  size_t{0}, size, REDUCTION_GRAIN, CoMoments<A>{},
+                  [&](size_t b, size_t e)
+                  { return serial(begin1 + static_cast<Diff1>(b), begin1 + static_cast<Diff1>(e),
+                                  begin2 + static_cast<Diff2>(b)); },
+                  [](CoMoments<A> a, const CoMoments<A> &b)
+                  { a.merge(b); return a; });
+          }
+
+          return serial(begin1, end1, begin2);
+        }
+      }
+    } // namespace detail
+
     // Statistic functions
     /**
      * @brief Calculates the mean of the array
@@ -190,12 +745,14 @@ namespace tf
       if (size == 0)
         return T{0};
 
-      return std::accumulate(begin, end, T{0}) / static_cast<T>(size);
+      return detail::accumulate(begin, end, T{0}, std::plus<T>()) / static_cast<T>(size);
     }
 
     /**
      * @brief Calculates the variance of the array
      *
+     * One pass over the data; see Moments.
+     *
      * @tparam Iterator Type of the iterator
      * @param begin Begin iterator
      * @param end End iterator
@@ -205,17 +762,12 @@ namespace tf
     template <typename Iterator>
     auto variance(Iterator begin, Iterator end)
     {
-      using T = typename std::iterator_traits<Iterator>::value_type;
-      auto size = std::distance(begin, end);
+      using T = std::remove_cv_t<typename std::iterator_traits<Iterator>::value_type>;
 
-      if (size <= 1)
+      if (std::distance(begin, end) <= 1)
         return T{0};
 
-      T m = mean(begin, end);
-      T sum = std::accumulate(begin, end, T{0}, [m](T a, T b)
-                              { return a + (b - m) * (b - m); });
-
-      return sum / static_cast<T>(size - 1);
+      return static_cast<T>(detail::moments(begin, end).variance());
     }
 
     /**
@@ -236,6 +788,8 @@ namespace tf
     /**
      * @brief Calculates the covariance of two arrays
      *
+     * One pass over both arrays; see CoMoments.
+     *
      * @tparam Iterator1 Type of the first iterator
      * @tparam Iterator2 Type of the second iterator
      * @param begin1 Begin iterator of the first array
@@ -249,8 +803,7 @@ namespace tf
     auto covariance(Iterator1 begin1, Iterator1 end1,
                     Iterator2 begin2, Iterator2 end2)
     {
-      using T1 = typename std::iterator_traits<Iterator1>::value_type;
-      using T2 = typename std::iterator_traits<Iterator2>::value_type;
+      using T1 = std::remove_cv_t<typename std::iterator_traits<Iterator1>::value_type>;
 
       auto size1 = std::distance(begin1, end1);
       auto size2 = std::distance(begin2, end2);
@@ -258,19 +811,14 @@ namespace tf
       if (size1 != size2 || size1 <= 1)
         return T1{0};
 
-      T1 m1 = mean(begin1, end1);
-      T1 m2 = mean(begin2, end2);
-
-      T1 sum = std::inner_product(begin1, end1, begin2, T1{0}, std::plus<T1>(),
-                                  [m1, m2](T1 a, T2 b)
-                                  { return (a - m1) * (b - m2); });
-
-      return sum / static_cast<T1>(size1 - 1);
+      return static_cast<T1>(detail::comoments(begin1, end1, begin2).covariance());
     }
 
     /**
      * @brief Calculates the correlation coefficient of two arrays
      *
+     * One pass over both arrays; see CoMoments.
+     *
      * @tparam Iterator1 Type of the first iterator
      * @tparam Iterator2 Type of the second iterator
      * @param begin1 Begin iterator of the first array
@@ -283,8 +831,7 @@ namespace tf
     auto correlation(Iterator1 begin1, Iterator1 end1,
                      Iterator2 begin2, Iterator2 end2)
     {
-      using T1 = typename std::iterator_traits<Iterator1>::value_type;
-      using T2 = typename std::iterator_traits<Iterator2>::value_type;
+      using T1 = std::remove_cv_t<typename std::iterator_traits<Iterator1>::value_type>;
 
       auto size1 = std::distance(begin1, end1);
       auto size2 = std::distance(begin2, end2);
@@ -292,11 +839,7 @@ namespace tf
       if (size1 != size2 || size1 <= 1)
         return T1{0};
 
-      T1 cov = covariance(begin1, end1, begin2, end2);
-      T1 std1 = stddev(begin1, end1);
-      T1 std2 = stddev(begin2, end2);
-
-      return cov / (std1 * std2);
+      return static_cast<T1>(detail::comoments(begin1, end1, begin2).correlation());
     }
   } // namespace math
 } // namespace tf
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/blas.hpp>
+#include <tf/math/elementwise.hpp>
+#include <tf/ops/graph.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace tf
+{
+  namespace ops
+  {
+    namespace detail
+    {
+      /**
+       * @brief Marks a missing node, leaf or kernel
+       */
+      constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+      /**
+       * @brief Operand of a fused step that is the result of the previous
+       * steps rather than a leaf
+       */
+      constexpr size_t RUNNING = NO_INDEX;
+
+      /**
+       * @brief Most distinct operands one fused elementwise kernel reads
+       */
+      constexpr size_t MAX_FUSED_LEAVES = 8;
+
+      /**
+       * @struct FusedStep
+       * @brief One recorded elementwise node inside a fused kernel
+       */
+      struct FusedStep
+      {
+        OpType type = OpType::Binary;                   ///< Binary or Unary
+        math::BinaryOp binary_op = math::BinaryOp::Add;
+        math::UnaryOp unary_op = math::UnaryOp::Negate;
+        size_t lhs = RUNNING;                           ///< Leaf index, or RUNNING
+        size_t rhs = RUNNING;                           ///< Leaf index, or RUNNING; unused by Unary
+      };
+
+      /**
+       * @struct Kernel
+       * @brief Unit of execution: recorded nodes computed in one pass into
+       * the buffer of the last of them
+       */
+      struct Kernel
+      {
+        enum class Kind
+        {
+          Gemm,       ///< A matrix product and the bias adds and activation after it
+          Elementwise ///< A chain of elementwise nodes
+        };
+
+        Kind kind = Kind::Elementwise;
+        NodeId output = NO_INDEX; ///< Node whose value the kernel writes
+        size_t nodes = 1;         ///< Recorded nodes the kernel computes
+        size_t level = 0;         ///< Kernels of one level are independent
+        float *out = nullptr;     ///< Planned location of the output
+
+        // Gemm
+        NodeId a = NO_INDEX;
+        NodeId b = NO_INDEX;
+        bool transpose_a = false;
+        bool transpose_b = false;
+        size_t m = 0;
+        size_t n = 0;
+        size_t k = 0;
+        NodeId row_bias = NO_INDEX;
+        NodeId column_bias = NO_INDEX;
+        math::Activation activation = math::Activation::Identity;
+
+        // Elementwise
+        std::vector<NodeId> leaves;       ///< Distinct operands read from memory
+        std::vector<FusedStep> steps;     ///< Applied in order, each over the previous result
+        core::shape_t dims;               ///< Collapsed iteration space
+        std::vector<core::shape_t> strides; ///< Strides of the output, then of each leaf
+        size_t inner = 1;                 ///< Length of the innermost run
+        size_t rows = 0;                  ///< Number of innermost runs
+      };
+    } // namespace detail
+
+    /**
+     * @struct ExecutorOptions
+     * @brief Compilation choices of an Executor
+     */
+    struct ExecutorOptions
+    {
+      bool fuse = true;       ///< Fuse elementwise nodes into GEMMs and into each other
+      bool concurrent = true; ///< Run independent kernels of a level on the thread pool together
+    };
+
+    /**
+     * @class Executor
+     * @brief Compiled form of a Graph
+     *
+     * Compilation keeps the nodes the outputs depend on and fuses them into
+     * kernels:
+     * - a matrix product absorbs a following bias add (of shape (n), (1, n)
+     *   or (m, 1)) and Relu, Sigmoid or Tanh into its GemmEpilogue;
+     * - chains of elementwise nodes run as one tiled pass that keeps the
+     *   running value in the output block, like math::assign().
+     * A node is only fused into its consumer when it is that consumer's
+     * sole operand use and not an output, so fused values never exist in
+     * memory.
+     *
+     * Kernels are grouped into levels by dependency depth. The lifetime of
+     * each kernel output spans the levels from its producer to its last
+     * consumer (to the end for outputs), and outputs with disjoint lifetimes
+     * share memory: every value is placed at an offset of one buffer,
+     * allocated at compilation. run() thus allocates nothing itself, and a
+     * value's address is the same on every run.
+     *
+     * One run at a time: the bound inputs and the buffer belong to the
+     * executor.
+     */
+    class Executor
+    {
+    public:
+      /**
+       * @brief Compiles a graph
+       *
+       * The graph is copied; constants keep sharing their buffers.
+       *
+       * @param graph Graph with at least one output
+       * @param options Compilation choices
+       * @throw ValueError if the graph has no outputs
+       */
+      explicit Executor(const Graph &graph, const ExecutorOptions &options = {});
+
+      Executor(const Executor &) = delete;
+      Executor &operator=(const Executor &) = delete;
+      Executor(Executor &&) = default;
+      Executor &operator=(Executor &&) = default;
+
+      /**
+       * @brief Binds an input to a tensor for the following runs
+       *
+       * The executor reads the tensor in place and holds a reference to its
+       * buffer until it is rebound.
+       *
+       * @param input Input node
+       * @param value Dense tensor of the input's shape
+       * @throw IndexError if input is not an input node of the graph
+       * @throw ShapeError if the shape differs or value is not dense
+       */
+      void bind(NodeId input, const core::TensorView<float> &value);
+
+      /**
+       * @brief Computes every output
+       *
+       * Kernels of a level run concurrently on the thread pool, each also
+       * splitting its own work across it.
+       *
+       * @throw ValueError if an input the outputs depend on is not bound
+       */
+      void run();
+
+      /**
+       * @brief Gets an output of the last run
+       *
+       * @param index Position of the output in the graph
+       * @return core::TensorView<float> Dense view; outputs computed by the
+       * graph live in the executor's buffer and are overwritten by the next
+       * run
+       * @throw IndexError if index is out of range
+       * @throw ValueError if the output is an unbound input
+       */
+      core::TensorView<float> output(size_t index) const;
+
+      // Properties
+      const Graph &graph() const { return m_graph; }
+      const std::vector<detail::Kernel> &kernels() const { return m_kernels; }
+      size_t num_kernels() const { return m_kernels.size(); }
+      size_t num_levels() const { return m_levels.size(); }
+
+      /**
+       * @brief Gets the size of the planned buffer
+       *
+       * @return size_t Bytes holding every kernel output
+       */
+      size_t arena_size() const { return m_arena_size; }
+
+      /**
+       * @brief Gets the memory the kernel outputs would take without reuse
+       *
+       * @return size_t Sum of their (aligned) sizes in bytes
+       */
+      size_t intermediate_size() const { return m_intermediate_size; }
+
+    private:
+      void fuse(const std::vector<bool> &live);
+      void schedule();
+      void plan();
+      void prepare(detail::Kernel &kernel) const;
+      void execute(const detail::Kernel &kernel) const;
+      void run_gemm(const detail::Kernel &kernel) const;
+      void run_rows(const detail::Kernel &kernel, size_t row, size_t begin, size_t end) const;
+
+      Graph m_graph;
+      ExecutorOptions m_options;
+      std::vector<detail::Kernel> m_kernels;
+      std::vector<std::vector<size_t>> m_levels;   ///< Kernel indices, by level
+      std::vector<size_t> m_producer;              ///< Kernel writing each node, or NO_INDEX
+      std::vector<NodeId> m_required;              ///< Inputs the outputs depend on
+      std::vector<const float *> m_data;           ///< Location of each node's value
+      std::vector<std::shared_ptr<float[]>> m_bound; ///< Buffers bound to inputs, by node
+      std::shared_ptr<float[]> m_arena;
+      size_t m_arena_size = 0;
+      size_t m_intermediate_size = 0;
+    };
+  } // namespace ops
+} // namespace tf
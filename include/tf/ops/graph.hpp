@@ -0,0 +1,159 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/elementwise.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tf
+{
+  namespace ops
+  {
+    /**
+     * @brief Identifier of a node, its position in the graph
+     */
+    using NodeId = size_t;
+
+    /**
+     * @enum OpType
+     * @brief Operation a graph node records
+     */
+    enum class OpType
+    {
+      Input,
+      Constant,
+      MatMul,
+      Binary,
+      Unary
+    };
+
+    /**
+     * @struct Node
+     * @brief One recorded operation and the shape of its result
+     *
+     * Nodes only refer to nodes recorded before them, so ids are in
+     * topological order.
+     */
+    struct Node
+    {
+      OpType type = OpType::Input;
+      std::vector<NodeId> inputs;                      ///< Operands, in order
+      core::Shape shape;                               ///< Shape of the result
+      std::string name;                                ///< Name of an input
+      math::BinaryOp binary_op = math::BinaryOp::Add;  ///< Operation of a Binary node
+      math::UnaryOp unary_op = math::UnaryOp::Negate;  ///< Operation of a Unary node
+      bool transpose_a = false;                        ///< MatMul uses the transpose of its first operand
+      bool transpose_b = false;                        ///< MatMul uses the transpose of its second operand
+      core::TensorView<float> value;                   ///< Dense value of a Constant node
+    };
+
+    /**
+     * @class Graph
+     * @brief Recorded computation over float32 tensors
+     *
+     * Operations are recorded rather than run: each call checks and infers
+     * the shape of its result and returns the new node. An Executor then
+     * compiles the nodes the outputs depend on into fused kernels over a
+     * preplanned buffer and runs them as often as needed.
+     */
+    class Graph
+    {
+    public:
+      /**
+       * @brief Records an input, bound to a tensor before each run
+       *
+       * @param name Name used in error messages
+       * @param shape Shape of the tensors it will be bound to
+       * @return NodeId New node
+       * @throw ShapeError if a dimension is negative
+       */
+      NodeId input(const std::string &name, const core::Shape &shape);
+
+      /**
+       * @brief Records a constant
+       *
+       * A dense view is kept as it is, so the graph sees later writes to
+       * its buffer; other layouts are copied.
+       *
+       * @param value Value of the constant
+       * @return NodeId New node
+       */
+      NodeId constant(const core::TensorView<float> &value);
+
+      /**
+       * @brief Records a scalar constant
+       *
+       * @param value Value of the constant
+       * @return NodeId New node of shape ()
+       */
+      NodeId scalar(float value);
+
+      /**
+       * @brief Records a matrix product op(a) * op(b)
+       *
+       * @param a Matrix of shape (m, k), or (k, m) with transpose_a
+       * @param b Matrix of shape (k, n), or (n, k) with transpose_b
+       * @param transpose_a Use the transpose of a
+       * @param transpose_b Use the transpose of b
+       * @return NodeId New node of shape (m, n)
+       * @throw IndexError if an operand is not a node of the graph
+       * @throw ShapeError if an operand is not a matrix or the inner
+       * dimensions differ
+       */
+      NodeId matmul(NodeId a, NodeId b, bool transpose_a = false, bool transpose_b = false);
+
+      /**
+       * @brief Records an elementwise binary operation
+       *
+       * The operands broadcast like in math::binary().
+       *
+       * @param op Operation
+       * @param a First operand
+       * @param b Second operand
+       * @return NodeId New node of the broadcast shape
+       * @throw IndexError if an operand is not a node of the graph
+       * @throw ShapeError if the operands do not broadcast
+       */
+      NodeId binary(math::BinaryOp op, NodeId a, NodeId b);
+
+      /**
+       * @brief Records an elementwise unary operation
+       *
+       * @param op Operation
+       * @param a Operand
+       * @return NodeId New node of the shape of a
+       * @throw IndexError if a is not a node of the graph
+       */
+      NodeId unary(math::UnaryOp op, NodeId a);
+
+      /**
+       * @brief Marks a node as an output of the graph
+       *
+       * @param node Node whose value is read after a run
+       * @return size_t Position of the output
+       * @throw IndexError if node is not a node of the graph
+       */
+      size_t output(NodeId node);
+
+      // Properties
+      size_t size() const { return m_nodes.size(); }
+      const Node &node(NodeId id) const;
+      const std::vector<Node> &nodes() const { return m_nodes; }
+      const std::vector<NodeId> &inputs() const { return m_inputs; }
+      const std::vector<NodeId> &outputs() const { return m_outputs; }
+
+    private:
+      NodeId add(Node node);
+      void check(NodeId id) const;
+
+      std::vector<Node> m_nodes;
+      std::vector<NodeId> m_inputs;
+      std::vector<NodeId> m_outputs;
+    };
+  } // namespace ops
+} // namespace tf
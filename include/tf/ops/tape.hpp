@@ -0,0 +1,288 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/blas.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace tf
+{
+  namespace ops
+  {
+    /**
+     * @brief Identifier of a value recorded on a tape, its position there
+     */
+    using VarId = size_t;
+
+    /**
+     * @enum TapeOp
+     * @brief Operation that produced a tape value
+     */
+    enum class TapeOp
+    {
+      Variable,
+      MatMul,
+      Add,
+      Subtract,
+      Multiply,
+      Activation,
+      Sum,
+      Mean
+    };
+
+    /**
+     * @class Tape
+     * @brief Eager float32 operations recorded for reverse-mode
+     * differentiation
+     *
+     * Every operation runs when it is called and is appended to the tape;
+     * backward() then walks the tape from a scalar loss to its first entry.
+     * Both directions are single passes per operation: activations compute
+     * their derivative (math::relu_and_derivative() and friends) alongside
+     * their value and keep it, so their backward step is one multiply, and
+     * matrix product gradients are accumulated by the GEMM itself (beta 1)
+     * instead of through a temporary.
+     *
+     * Memory:
+     * - values, saved derivatives and gradients come from buffers the tape
+     *   keeps for reuse across clear(), taken only when no view still
+     *   refers to them; the gradient of an intermediate value is given back
+     *   as soon as it has been propagated;
+     * - operations recorded between begin_checkpoint() and end_checkpoint()
+     *   give back their values when the segment ends, except the last one,
+     *   and backward() recomputes them from the segment's inputs when it
+     *   reaches the segment, one segment at a time;
+     * - accumulate_into() makes backward() add the gradient of a variable
+     *   into a caller-owned buffer, which it never clears, so micro-batches
+     *   accumulate without copies.
+     *
+     * Operands broadcast like in math::binary(); the gradient of a
+     * broadcast operand is reduced back to its shape.
+     */
+    class Tape
+    {
+    public:
+      /**
+       * @brief Records a variable (a parameter or an input)
+       *
+       * A dense view is used in place; other layouts are copied.
+       *
+       * @param value Value of the variable
+       * @param requires_grad Whether backward() computes its gradient
+       * @return VarId New value
+       */
+      VarId variable(const core::TensorView<float> &value, bool requires_grad = true);
+
+      /**
+       * @brief Computes and records op(a) * op(b)
+       *
+       * @param a Matrix of shape (m, k), or (k, m) with transpose_a
+       * @param b Matrix of shape (k, n), or (n, k) with transpose_b
+       * @param transpose_a Use the transpose of a
+       * @param transpose_b Use the transpose of b
+       * @return VarId New value of shape (m, n)
+       * @throw IndexError if an operand is not on the tape
+       * @throw ShapeError if an operand is not a matrix or the inner
+       * dimensions differ
+       */
+      VarId matmul(VarId a, VarId b, bool transpose_a = false, bool transpose_b = false);
+
+      /**
+       * @brief Computes and records a + b, a - b or a * b
+       *
+       * @param a First operand
+       * @param b Second operand
+       * @return VarId New value of the broadcast shape
+       * @throw IndexError if an operand is not on the tape
+       * @throw ShapeError if the operands do not broadcast
+       */
+      VarId add(VarId a, VarId b);
+      VarId subtract(VarId a, VarId b);
+      VarId multiply(VarId a, VarId b);
+
+      /**
+       * @brief Computes and records an activation
+       *
+       * @param activation Relu, LeakyRelu, Sigmoid or Tanh
+       * @param a Operand
+       * @param leaky_slope Slope of LeakyRelu below zero
+       * @return VarId New value of the shape of a
+       * @throw IndexError if a is not on the tape
+       * @throw ValueError if activation is Identity
+       */
+      VarId activation(math::Activation activation, VarId a, float leaky_slope = 0.01f);
+
+      /**
+       * @brief Computes and records the sum or the mean of all elements
+       *
+       * @param a Operand
+       * @return VarId New scalar value
+       * @throw IndexError if a is not on the tape
+       */
+      VarId sum(VarId a);
+      VarId mean(VarId a);
+
+      /**
+       * @brief Starts a checkpointed segment
+       *
+       * @throw ValueError if a segment is already open
+       */
+      void begin_checkpoint();
+
+      /**
+       * @brief Ends the open segment and gives back the values recorded in
+       * it, except the last one
+       *
+       * Variables recorded in the segment are kept. Views obtained
+       * earlier stay valid. Reading a released value (or recording an
+       * operation on it) recomputes the segment and keeps it until the
+       * next backward().
+       *
+       * @throw ValueError if no segment is open
+       */
+      void end_checkpoint();
+
+      /**
+       * @brief Makes backward() add the gradient of a variable into a
+       * buffer
+       *
+       * @param variable Variable
+       * @param gradient Dense buffer of the variable's shape
+       * @throw IndexError if variable is not a variable of the tape
+       * @throw ShapeError if the shape differs or gradient is not dense
+       */
+      void accumulate_into(VarId variable, const core::TensorView<float> &gradient);
+
+      /**
+       * @brief Computes the gradient of a scalar with respect to every
+       * value that requires one
+       *
+       * Gradients of variables are kept until clear() (or, with
+       * accumulate_into(), added to the caller's buffer); gradients of
+       * other values are given back once propagated.
+       *
+       * @param loss Value with a single element
+       * @throw IndexError if loss is not on the tape
+       * @throw ShapeError if loss has more than one element
+       */
+      void backward(VarId loss);
+
+      /**
+       * @brief Gets a value, recomputing it if its segment gave it back
+       *
+       * @param id Value
+       * @return const core::TensorView<float>& Dense value
+       * @throw IndexError if id is not on the tape
+       */
+      const core::TensorView<float> &value(VarId id);
+
+      /**
+       * @brief Gets the gradient of a variable after backward()
+       *
+       * @param variable Variable
+       * @return const core::TensorView<float>& Gradient, or an empty view if
+       * the loss does not depend on the variable
+       * @throw IndexError if variable is not on the tape
+       */
+      const core::TensorView<float> &gradient(VarId variable) const;
+
+      /**
+       * @brief Forgets every recorded operation
+       *
+       * The reusable buffers are kept, so a training step recording the
+       * same shapes again takes no new ones.
+       */
+      void clear();
+
+      // Properties
+      size_t size() const { return m_nodes.size(); }
+      TapeOp op(VarId id) const;
+      const core::Shape &shape(VarId id) const;
+
+      /**
+       * @brief Gets the memory held by recorded operations
+       *
+       * @return size_t Bytes of the values and saved derivatives of every
+       * operation other than variables
+       */
+      size_t resident_bytes() const;
+
+      /**
+       * @brief Gets the memory of the buffers kept for reuse
+       *
+       * @return size_t Bytes of every buffer the tape took, in use or not
+       */
+      size_t pooled_bytes() const;
+
+    private:
+      static constexpr size_t NO_SEGMENT = static_cast<size_t>(-1);
+
+      struct Node
+      {
+        TapeOp op = TapeOp::Variable;
+        VarId a = 0;
+        VarId b = 0;
+        core::Shape shape;
+        math::Activation activation = math::Activation::Identity;
+        float leaky_slope = 0.01f;
+        bool transpose_a = false;
+        bool transpose_b = false;
+        bool requires_grad = false;
+        bool released = false;
+        size_t segment = NO_SEGMENT;
+        core::TensorView<float> value;
+        core::TensorView<float> derivative; ///< Saved by activations
+      };
+
+      struct Segment
+      {
+        VarId first = 0;
+        VarId last = 0; ///< Output of the segment, never released
+      };
+
+      VarId record(Node node);
+      void compute(Node &node);
+      void ensure(VarId id);
+      void materialize(size_t segment);
+      void release(size_t segment);
+      void propagate(VarId id);
+      core::TensorView<float> &target(VarId id, bool &first);
+      core::TensorView<float> acquire(const core::Shape &shape);
+      void check(VarId id) const;
+
+      std::vector<Node> m_nodes;
+      std::vector<Segment> m_segments;
+      bool m_open = false;
+
+      std::vector<core::TensorView<float>> m_gradients;
+      std::vector<bool> m_has_gradient; ///< Gradient written by the running backward()
+      std::vector<bool> m_accumulates;  ///< Gradient is a caller's buffer, only added to
+
+      std::vector<std::pair<size_t, std::shared_ptr<float[]>>> m_buffers; ///< Reusable, by element count
+    };
+
+    /**
+     * @class CheckpointScope
+     * @brief Records the operations of its lifetime as one checkpointed
+     * segment of a tape
+     */
+    class CheckpointScope
+    {
+    public:
+      explicit CheckpointScope(Tape &tape) : m_tape(tape) { m_tape.begin_checkpoint(); }
+      ~CheckpointScope() { m_tape.end_checkpoint(); }
+
+      CheckpointScope(const CheckpointScope &) = delete;
+      CheckpointScope &operator=(const CheckpointScope &) = delete;
+
+    private:
+      Tape &m_tape;
+    };
+  } // namespace ops
+} // namespace tf
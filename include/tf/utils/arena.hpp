@@ -0,0 +1,383 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/utils/memory.hpp>
+#include <tf/utils/page_allocator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace tf
+{
+  namespace utils
+  {
+    /**
+     * @class Arena
+     * @brief Bump allocator over a list of reusable chunks
+     *
+     * Allocation moves a pointer forward; memory is only reclaimed by
+     * rewinding to an earlier marker (or resetting). Chunks are kept when
+     * rewound, so once an arena has grown to a workload's peak, repeating
+     * that workload never touches the system allocator. An arena is meant
+     * to be used by one thread at a time.
+     */
+    class Arena
+    {
+    public:
+      /**
+       * @struct Marker
+       * @brief Position in an arena to rewind to
+       */
+      struct Marker
+      {
+        size_t chunk = 0;
+        size_t offset = 0;
+      };
+
+      /**
+       * @brief Constructs an arena
+       *
+       * No memory is reserved until the first allocation.
+       *
+       * @param chunk_size Minimum size of each chunk in bytes
+       * @param policy How chunks are backed (heap, huge pages, NUMA)
+       */
+      explicit Arena(size_t chunk_size = 1024 * 1024,
+                     const AllocationPolicy &policy = AllocationPolicy{})
+          : m_chunk_size(std::max<size_t>(chunk_size, DEFAULT_ALIGNMENT)), m_policy(policy) {}
+
+      ~Arena()
+      {
+        for (Chunk &chunk : m_chunks)
+          release(chunk);
+      }
+
+      Arena(const Arena &) = delete;
+      Arena &operator=(const Arena &) = delete;
+
+      /**
+       * @brief Allocates uninitialized memory
+       *
+       * @param size Size in bytes
+       * @param alignment Alignment, a power of two
+       * @return void* Pointer valid until the arena is rewound past it
+       * @throw ValueError if the alignment is not a power of two
+       */
+      void *allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT)
+      {
+        TF_CHECK(alignment != 0 && (alignment & (alignment - 1)) == 0,
+                 core::ValueError, "Alignment must be a power of two");
+
+        while (m_current < m_chunks.size())
+        {
+          Chunk &chunk = m_chunks[m_current];
+          char *base = static_cast<char *>(chunk.pages.ptr);
+          char *ptr = align_pointer(base + m_offset, alignment);
+
+          if (ptr + size <= base + chunk.pages.size)
+          {
+            m_offset = static_cast<size_t>(ptr - base) + size;
+            m_used = std::max(m_used, used_bytes());
+            return ptr;
+          }
+
+          // A retained chunk that is too small for this request is replaced
+          // by a bigger one; otherwise move on to the next chunk.
+          if (m_offset == 0 && chunk.pages.size < size + alignment)
+          {
+            release(chunk);
+            chunk = acquire(size + alignment);
+            continue;
+          }
+
+          ++m_current;
+          m_offset = 0;
+        }
+
+        m_chunks.push_back(acquire(size + alignment));
+        return allocate(size, alignment);
+      }
+
+      /**
+       * @brief Allocates an uninitialized array
+       *
+       * @tparam T Element type
+       * @param count Number of elements
+       * @return T* Pointer aligned to at least DEFAULT_ALIGNMENT
+       */
+      template <typename T>
+      T *allocate_array(size_t count)
+      {
+        return static_cast<T *>(allocate(count * sizeof(T),
+                                         std::max(alignof(T), DEFAULT_ALIGNMENT)));
+      }
+
+      /**
+       * @brief Gets the current position
+       *
+       * @return Marker Position to pass to rewind
+       */
+      Marker marker() const { return Marker{m_current, m_offset}; }
+
+      /**
+       * @brief Frees everything allocated since a marker was taken
+       *
+       * @param marker Position returned by marker()
+       */
+      void rewind(const Marker &marker)
+      {
+        m_current = marker.chunk;
+        m_offset = marker.offset;
+      }
+
+      /**
+       * @brief Frees every allocation, keeping the chunks for reuse
+       */
+      void reset() { rewind(Marker{}); }
+
+      // Statistics
+      size_t bytes_used() const { return used_bytes(); }
+      size_t peak_bytes_used() const { return m_used; }
+      size_t num_chunks() const { return m_chunks.size(); }
+
+      size_t capacity() const
+      {
+        size_t total = 0;
+        for (const Chunk &chunk : m_chunks)
+          total += chunk.pages.size;
+        return total;
+      }
+
+    private:
+      struct Chunk
+      {
+        PageAllocation pages;
+      };
+
+      std::vector<Chunk> m_chunks;
+      size_t m_current = 0;
+      size_t m_offset = 0;
+      size_t m_used = 0;
+      size_t m_chunk_size;
+      AllocationPolicy m_policy;
+
+      size_t used_bytes() const
+      {
+        size_t total = m_offset;
+        for (size_t i = 0; i < m_current && i < m_chunks.size(); ++i)
+          total += m_chunks[i].pages.size;
+        return total;
+      }
+
+      Chunk acquire(size_t min_size)
+      {
+        size_t size = std::max(m_chunk_size, min_size);
+        size = (size + DEFAULT_ALIGNMENT - 1) & ~(DEFAULT_ALIGNMENT - 1);
+
+        Chunk chunk;
+        if (m_policy.is_default())
+        {
+          chunk.pages.ptr = ::operator new(size, std::align_val_t{DEFAULT_ALIGNMENT});
+          chunk.pages.size = size;
+        }
+        else
+        {
+          chunk.pages = allocate_pages(size, m_policy);
+        }
+
+        return chunk;
+      }
+
+      void release(Chunk &chunk)
+      {
+        if (m_policy.is_default())
+          ::operator delete(chunk.pages.ptr, std::align_val_t{DEFAULT_ALIGNMENT});
+        else
+          free_pages(chunk.pages);
+
+        chunk.pages = PageAllocation{};
+      }
+    };
+
+    namespace detail
+    {
+      inline Arena *&current_arena_slot()
+      {
+        thread_local Arena *arena = nullptr;
+        return arena;
+      }
+    } // namespace detail
+
+    /**
+     * @brief Gets the arena of the innermost ArenaScope on this thread
+     *
+     * @return Arena* Current arena, or nullptr outside any scope
+     */
+    inline Arena *current_arena()
+    {
+      return detail::current_arena_slot();
+    }
+
+    /**
+     * @brief Gets this thread's default arena for ArenaScope
+     *
+     * @return Arena& Thread-local arena
+     */
+    inline Arena &thread_arena()
+    {
+      thread_local Arena arena;
+      return arena;
+    }
+
+    /**
+     * @brief Gets this thread's arena for library-internal scratch
+     *
+     * Kept apart from thread_arena() so kernels (for example GEMM packing)
+     * can take scratch space inside a caller's ArenaScope without
+     * interleaving with the caller's allocations.
+     *
+     * @return Arena& Thread-local scratch arena
+     */
+    inline Arena &scratch_arena()
+    {
+      thread_local Arena arena;
+      return arena;
+    }
+
+    /**
+     * @class ArenaCheckpoint
+     * @brief RAII marker that rewinds an arena on destruction
+     *
+     * Unlike ArenaScope it does not change the current arena.
+     */
+    class ArenaCheckpoint
+    {
+    public:
+      explicit ArenaCheckpoint(Arena &arena) : m_arena(arena), m_marker(arena.marker()) {}
+      ~ArenaCheckpoint() { m_arena.rewind(m_marker); }
+
+      ArenaCheckpoint(const ArenaCheckpoint &) = delete;
+      ArenaCheckpoint &operator=(const ArenaCheckpoint &) = delete;
+
+    private:
+      Arena &m_arena;
+      Arena::Marker m_marker;
+    };
+
+    /**
+     * @class ArenaScope
+     * @brief RAII scope whose allocations are released together
+     *
+     * While the scope is alive, core::Memory<T>::allocate on this thread
+     * bump-allocates from the scope's arena; when it ends, the arena is
+     * rewound and the previous scope (if any) becomes current again. Memory
+     * allocated inside the scope must not outlive it. Chunks of a parallel
+     * loop never allocate from the caller's scope.
+     */
+    class ArenaScope
+    {
+    public:
+      /**
+       * @brief Opens a scope on this thread's default arena
+       */
+      ArenaScope() : ArenaScope(thread_arena()) {}
+
+      /**
+       * @brief Opens a scope on an arena
+       *
+       * @param arena Arena to allocate from
+       */
+      explicit ArenaScope(Arena &arena)
+          : m_checkpoint(arena), m_arena(arena), m_previous(detail::current_arena_slot())
+      {
+        detail::current_arena_slot() = &arena;
+      }
+
+      ~ArenaScope()
+      {
+        detail::current_arena_slot() = m_previous;
+      }
+
+      // Scopes are tied to their thread's scope stack
+      ArenaScope(const ArenaScope &) = delete;
+      ArenaScope &operator=(const ArenaScope &) = delete;
+
+      /**
+       * @brief Gets the arena of this scope
+       *
+       * @return Arena& Arena allocations are served from
+       */
+      Arena &arena() const { return m_arena; }
+
+    private:
+      ArenaCheckpoint m_checkpoint;
+      Arena &m_arena;
+      Arena *m_previous;
+    };
+
+    /**
+     * @class ArenaSuspension
+     * @brief RAII guard that hides this thread's ArenaScope
+     *
+     * Memory allocated under the guard comes from the heap even inside an
+     * ArenaScope, for buffers that must outlive the scope (a parallel
+     * loop's chunks, the pooled buffers of an autodiff tape).
+     */
+    class ArenaSuspension
+    {
+    public:
+      ArenaSuspension() : m_previous(detail::current_arena_slot())
+      {
+        detail::current_arena_slot() = nullptr;
+      }
+
+      ~ArenaSuspension() { detail::current_arena_slot() = m_previous; }
+
+      ArenaSuspension(const ArenaSuspension &) = delete;
+      ArenaSuspension &operator=(const ArenaSuspension &) = delete;
+
+    private:
+      Arena *m_previous;
+    };
+
+    /**
+     * @class ArenaAllocator
+     * @brief Standard allocator over an Arena; deallocation is a no-op
+     *
+     * @tparam T Value type
+     */
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+      using value_type = T;
+
+      explicit ArenaAllocator(Arena &arena) noexcept : m_arena(&arena) {}
+
+      template <typename U>
+      ArenaAllocator(const ArenaAllocator<U> &other) noexcept : m_arena(other.arena()) {}
+
+      T *allocate(size_t n)
+      {
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T),
+                                                  std::max(alignof(T), DEFAULT_ALIGNMENT)));
+      }
+
+      void deallocate(T *, size_t) noexcept {}
+
+      Arena *arena() const noexcept { return m_arena; }
+
+      template <typename U>
+      bool operator==(const ArenaAllocator<U> &other) const noexcept
+      {
+        return m_arena == other.arena();
+      }
+
+    private:
+      Arena *m_arena;
+    };
+  } // namespace utils
+} // namespace tf
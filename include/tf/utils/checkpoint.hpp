@@ -0,0 +1,284 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tf
+{
+  namespace utils
+  {
+    /**
+     * @brief Alignment of every tensor in a checkpoint file
+     */
+    inline constexpr size_t CHECKPOINT_ALIGNMENT = 64;
+
+    /**
+     * @brief Version written by CheckpointWriter and read by Checkpoint
+     */
+    inline constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+
+    /**
+     * @brief Default uncompressed size of a compressed block
+     */
+    inline constexpr size_t CHECKPOINT_BLOCK_SIZE = 1024 * 1024;
+
+    /**
+     * @enum Compression
+     * @brief Block codec of a stored tensor
+     */
+    enum class Compression
+    {
+      None, ///< Raw elements, which can be mapped without a copy
+      LZ4,  ///< LZ4 blocks (TF_USE_LZ4)
+      Zstd  ///< Zstandard blocks (TF_USE_ZSTD)
+    };
+
+    /**
+     * @brief Checks whether a codec was compiled in
+     *
+     * @param codec Codec
+     * @return bool True for None and for codecs enabled at build time
+     */
+    bool compression_available(Compression codec);
+
+    /**
+     * @struct CompressionOptions
+     * @brief How a tensor is compressed when a checkpoint is saved
+     *
+     * The tensor is cut along its first dimension into blocks of
+     * block_rows indices, compressed independently, so that a range of rows
+     * can be read without decompressing the rest.
+     */
+    struct CompressionOptions
+    {
+      Compression codec = Compression::None;
+      size_t block_rows = 0; ///< Rows per block; 0 for about CHECKPOINT_BLOCK_SIZE bytes
+      int level = 0;         ///< Codec level; 0 for the codec's default
+    };
+
+    /**
+     * @struct CheckpointEntry
+     * @brief Description of one tensor stored in a checkpoint
+     */
+    struct CheckpointEntry
+    {
+      std::string name;
+      core::DataType dtype = core::DataType::Float32;
+      core::Shape shape;
+      Compression compression = Compression::None;
+      size_t offset = 0; ///< Position of the data from the start of the file, a multiple of 64
+      size_t size = 0;   ///< Stored bytes: the elements, or the block table and blocks
+
+      /**
+       * @brief Gets the number of indices along the first dimension
+       *
+       * @return size_t Rows, 1 for a scalar
+       */
+      size_t rows() const { return shape.rank() == 0 ? 1 : static_cast<size_t>(shape[0]); }
+
+      /**
+       * @brief Gets the uncompressed size of the elements
+       *
+       * @return size_t Elements times the element size
+       */
+      size_t data_size() const
+      {
+        return core::size_of(dtype) * static_cast<size_t>(std::max<core::index_t>(shape.num_elements(), 0));
+      }
+    };
+
+    /**
+     * @class CheckpointWriter
+     * @brief Collects named tensors and writes them as a checkpoint file
+     *
+     * The file is little-endian:
+     *
+     *     magic "TFCKPT\0\0", u32 version, u32 count, u64 data offset
+     *     count entries of
+     *       u32 name size, u32 dtype, u32 rank, u32 compression,
+     *       u64 offset, u64 size, i64 dims[rank], char name[name size]
+     *     zero padding up to the data offset, then the tensors in the order
+     *     they were added, each 64-byte aligned
+     *
+     * An uncompressed tensor is stored dense and row-major. A compressed
+     * one is stored as u64 block rows, u64 block count and the u64 end of
+     * every block (from the start of the tensor's data), followed by the
+     * blocks.
+     *
+     * Tensors are not copied when added: the writer keeps their buffers
+     * alive until it is destroyed, and only strided views are made dense.
+     */
+    class CheckpointWriter
+    {
+    public:
+      /**
+       * @brief Adds a tensor
+       *
+       * @tparam T Element type, one with a core::DataType
+       * @param name Name the tensor is loaded by
+       * @param tensor Tensor, made dense if it is strided
+       * @param compression How the tensor is stored
+       * @throw ValueError if the name is empty or already used
+       * @throw NotImplementedError if the codec was not compiled in
+       */
+      template <typename T>
+      void add(const std::string &name, const core::TensorView<T> &tensor,
+               const CompressionOptions &compression = {})
+      {
+        const core::TensorView<T> dense = tensor.contiguous();
+        add(name, core::data_type_of<T>(), dense.shape(),
+            std::shared_ptr<const void>(dense.buffer(), dense.data()), compression);
+      }
+
+      /**
+       * @brief Adds raw dense data
+       *
+       * @param name Name the tensor is loaded by
+       * @param dtype Type of the elements
+       * @param shape Shape of the tensor
+       * @param data Row-major elements, kept alive by the writer
+       * @param compression How the tensor is stored
+       * @throw ValueError if the name is empty or already used, the type
+       * is unknown or data is null for a non-empty tensor
+       * @throw NotImplementedError if the codec was not compiled in
+       */
+      void add(const std::string &name, core::DataType dtype, const core::Shape &shape,
+               std::shared_ptr<const void> data, const CompressionOptions &compression = {});
+
+      /**
+       * @brief Writes every tensor added so far
+       *
+       * The file is written next to path and renamed over it once
+       * complete, so readers never see a partial checkpoint.
+       *
+       * @param path File to create or replace
+       * @throw IOError if the file cannot be written
+       */
+      void save(const std::string &path) const;
+
+      size_t size() const { return m_entries.size(); }
+
+    private:
+      std::vector<CheckpointEntry> m_entries;
+      std::vector<std::shared_ptr<const void>> m_data;
+      std::vector<CompressionOptions> m_compression;
+      std::unordered_map<std::string, size_t> m_index;
+    };
+
+    /**
+     * @struct CheckpointOptions
+     * @brief How a checkpoint file is mapped
+     */
+    struct CheckpointOptions
+    {
+      bool prefetch = false; ///< Ask the kernel to read the whole file ahead (MADV_WILLNEED)
+      bool writable = false; ///< Map copy-on-write, so that views can be written
+    };
+
+    /**
+     * @class Checkpoint
+     * @brief Memory-mapped checkpoint file
+     *
+     * Opening only parses the header: tensors are views straight over the
+     * mapping, their pages read on first touch (or ahead, with prefetch)
+     * and shared through the page cache with every process mapping the
+     * same file. Views keep the mapping alive, so they may outlive the
+     * checkpoint. Unless the options ask for a writable mapping, writing
+     * through a view faults; a writable mapping is private, so writes never
+     * reach the file. Without mmap (non-Linux builds) the file is read into
+     * memory instead. Compressed tensors cannot be mapped: they are
+     * decompressed into a new buffer on every get.
+     */
+    class Checkpoint
+    {
+    public:
+      Checkpoint() = default;
+
+      /**
+       * @brief Maps a checkpoint file
+       *
+       * @param path File written by CheckpointWriter
+       * @param options Mapping options
+       * @throw IOError if the file cannot be opened or mapped, or its
+       * header is not a valid checkpoint
+       */
+      explicit Checkpoint(const std::string &path, const CheckpointOptions &options = {});
+
+      /**
+       * @brief Gets a tensor
+       *
+       * @tparam T Element type, which must match the stored type
+       * @param name Name of the tensor
+       * @return core::TensorView<T> Dense view over the mapping, or over a
+       * decompressed copy
+       * @throw IndexError if there is no tensor of that name
+       * @throw TypeError if the tensor holds another type
+       * @throw IOError if a compressed tensor is corrupt
+       * @throw NotImplementedError if its codec was not compiled in
+       */
+      template <typename T>
+      core::TensorView<T> get(const std::string &name) const
+      {
+        const CheckpointEntry &e = entry(name);
+        TF_CHECK(e.dtype == core::data_type_of<T>(), core::TypeError,
+                 "Checkpoint tensor holds another type");
+        if (e.compression != Compression::None)
+          return core::TensorView<T>(std::reinterpret_pointer_cast<T[]>(decompress(e)), e.shape);
+        return core::TensorView<T>(
+            std::shared_ptr<T[]>(m_data, reinterpret_cast<T *>(m_data.get() + e.offset)), e.shape);
+      }
+
+      /**
+       * @brief Gets the description of a tensor
+       *
+       * @param name Name of the tensor
+       * @return const CheckpointEntry& Entry
+       * @throw IndexError if there is no tensor of that name
+       */
+      const CheckpointEntry &entry(const std::string &name) const;
+
+      /**
+       * @brief Asks the kernel to read the pages of one tensor ahead
+       *
+       * Returns immediately; the pages are read in the background.
+       *
+       * @param name Name of the tensor
+       * @throw IndexError if there is no tensor of that name
+       */
+      void prefetch(const std::string &name) const;
+
+      bool contains(const std::string &name) const { return m_index.count(name) != 0; }
+      const std::vector<CheckpointEntry> &entries() const { return m_entries; }
+      size_t size() const { return m_entries.size(); }
+      size_t file_size() const { return m_file_size; }
+
+    private:
+      std::shared_ptr<char[]> decompress(const CheckpointEntry &entry) const;
+
+      std::shared_ptr<char[]> m_data;
+      size_t m_file_size = 0;
+      std::vector<CheckpointEntry> m_entries;
+      std::unordered_map<std::string, size_t> m_index;
+    };
+
+    /**
+     * @brief Reads the entries of a checkpoint without mapping its data
+     *
+     * @param path Checkpoint file
+     * @return std::vector<CheckpointEntry> Entries, in file order
+     * @throw IOError if the file cannot be read or its header is not a
+     * valid checkpoint
+     */
+    std::vector<CheckpointEntry> read_checkpoint_index(const std::string &path);
+  } // namespace utils
+} // namespace tf
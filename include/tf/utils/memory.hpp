@@ -3,14 +3,22 @@
 #include <tf/core/types.hpp>
 #include <tf/core/error.hpp>
 #include <tf/core/macros.hpp>
+#include <tf/utils/page_allocator.hpp>
 
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <map>
 #include <mutex>
 #include <atomic>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
+#include <new>
 #include <thread>
+#include <utility>
 
 namespace tf
 {
@@ -22,6 +30,13 @@ namespace tf
 
     inline constexpr size_t DEFAULT_ALIGNMENT = 64;
 
+    /**
+     * @brief Common alignments for MemoryPool::allocate
+     */
+    inline constexpr size_t CACHE_LINE_ALIGNMENT = 64;
+    inline constexpr size_t PAGE_ALIGNMENT = 4 * 1024;
+    inline constexpr size_t HUGE_PAGE_ALIGNMENT = 2 * 1024 * 1024;
+
     /**
      * @brief Allocate memory with the specified size and alignment.
      *
@@ -39,36 +54,276 @@ namespace tf
       return reinterpret_cast<T *>(aligned_address);
     }
 
-    /**
-     * @struct MemoryBlock
-     * @brief Structure representing a memory block.
-     */
-    struct MemoryBlock
+    namespace detail
     {
-      void *ptr;
-      size_t size;
-      size_t alignment;
-      bool in_use;
-    };
+      /**
+       * @brief Bytes reserved in front of every pooled allocation
+       *
+       * One cache line, so user pointers keep the default alignment.
+       */
+      inline constexpr size_t POOL_HEADER_SIZE = DEFAULT_ALIGNMENT;
+
+      /**
+       * @brief Largest request served from the size-class free lists
+       */
+      inline constexpr size_t POOL_MAX_SMALL_SIZE = size_t{1} << 18;
+
+      /**
+       * @brief Number of size classes
+       *
+       * 64, 128, 192 and 256 bytes, then four classes per power of two up
+       * to POOL_MAX_SMALL_SIZE. Every class is a multiple of 64 bytes.
+       */
+      inline constexpr size_t POOL_NUM_CLASSES = 4 + 4 * 10;
+
+      /**
+       * @brief Bytes a thread caches per size class before it hands half of
+       * its blocks back to the shared free list
+       */
+      inline constexpr size_t POOL_THREAD_CACHE_BYTES = size_t{256} << 10;
+
+      /**
+       * @brief Smallest remainder worth splitting off a large free block
+       */
+      inline constexpr size_t POOL_MIN_LARGE_SPLIT = size_t{64} << 10;
+
+      inline constexpr std::uint32_t POOL_MAGIC = 0x7f3c9a55u;
+      inline constexpr std::uint32_t POOL_LARGE_CLASS = 0xffffffffu;
+      inline constexpr std::uint32_t POOL_ALIGNED_CLASS = 0xfffffffeu;
+
+      /**
+       * @struct PoolBlockHeader
+       * @brief Bookkeeping stored directly in front of a pooled allocation
+       */
+      struct PoolBlockHeader
+      {
+        std::uint32_t magic;
+        std::uint32_t size_class;
+        std::uint64_t pool_id;
+        size_t capacity;
+        PoolBlockHeader *next;
+        size_t offset; // over-aligned blocks: distance back to the backing block
+        bool in_use;
+      };
+
+      static_assert(sizeof(PoolBlockHeader) <= POOL_HEADER_SIZE,
+                    "Pool block header must fit in one cache line");
+
+      /**
+       * @brief Gets the size class that serves a request
+       *
+       * @param size Requested size in bytes, at most POOL_MAX_SMALL_SIZE
+       * @return size_t Index of the smallest class that fits
+       */
+      inline size_t size_class_index(size_t size)
+      {
+        if (size <= 256)
+          return size == 0 ? 0 : (size - 1) / 64;
+
+        const size_t s = size - 1;
+        const size_t p = static_cast<size_t>(std::bit_width(s)) - 1;
+        const size_t step = size_t{1} << (p - 2);
+        const size_t sub = (s - (size_t{1} << p)) / step;
+
+        return 4 + (p - 8) * 4 + sub;
+      }
+
+      /**
+       * @brief Gets the capacity of a size class
+       *
+       * @param index Size class index
+       * @return size_t Usable bytes of blocks in that class
+       */
+      inline size_t size_class_capacity(size_t index)
+      {
+        if (index < 4)
+          return (index + 1) * 64;
+
+        const size_t p = 8 + (index - 4) / 4;
+        const size_t sub = (index - 4) % 4;
+
+        return (size_t{1} << p) + (sub + 1) * (size_t{1} << (p - 2));
+      }
+
+      /**
+       * @struct PoolState
+       * @brief Memory and free lists of one pool, shared with thread caches
+       *
+       * Thread caches only hold a weak reference, so blocks they cache are
+       * dropped (not touched) once the pool is gone.
+       */
+      struct PoolState
+      {
+        PoolState(std::uint64_t pool_id, const AllocationPolicy &allocation_policy)
+            : id(pool_id), policy(allocation_policy)
+        {
+          for (auto &list : free_lists)
+            list.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~PoolState()
+        {
+          for (const PageAllocation &region : regions)
+          {
+            if (policy.is_default())
+              ::operator delete(region.ptr, std::align_val_t{DEFAULT_ALIGNMENT});
+            else
+              free_pages(region);
+          }
+        }
+
+        PoolState(const PoolState &) = delete;
+        PoolState &operator=(const PoolState &) = delete;
+
+        const std::uint64_t id;
+        const AllocationPolicy policy;
+
+        // Shared per-class free lists. Blocks are pushed one at a time or as
+        // a chain with a CAS loop, and only ever removed by taking the whole
+        // list with an exchange, which rules out the ABA problem of a
+        // single-element CAS pop.
+        std::atomic<PoolBlockHeader *> free_lists[POOL_NUM_CLASSES];
+
+        // Regions and the bump pointer into the newest one
+        std::mutex region_mutex;
+        std::vector<PageAllocation> regions;
+        char *bump = nullptr;
+        char *bump_end = nullptr;
+
+        // Free blocks above POOL_MAX_SMALL_SIZE, keyed by capacity
+        std::mutex large_mutex;
+        std::multimap<size_t, PoolBlockHeader *> large_free;
+
+        std::atomic<size_t> total_size{0};
+        std::atomic<size_t> max_block_size{0};
+        std::atomic<size_t> num_blocks{0};
+
+        void push(size_t index, PoolBlockHeader *first, PoolBlockHeader *last)
+        {
+          PoolBlockHeader *head = free_lists[index].load(std::memory_order_relaxed);
+          do
+          {
+            last->next = head;
+          } while (!free_lists[index].compare_exchange_weak(
+              head, first, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        PoolBlockHeader *take_all(size_t index)
+        {
+          if (free_lists[index].load(std::memory_order_relaxed) == nullptr)
+            return nullptr;
+
+          return free_lists[index].exchange(nullptr, std::memory_order_acquire);
+        }
+      };
+
+      /**
+       * @struct PoolThreadCache
+       * @brief Per-thread free lists for the pool the thread last adopted
+       *
+       * A thread caches blocks for a single pool at a time; calls on any
+       * other live pool use that pool's shared lists directly.
+       */
+      struct PoolThreadCache
+      {
+        struct List
+        {
+          PoolBlockHeader *head = nullptr;
+          size_t count = 0;
+        };
+
+        std::uint64_t pool_id = 0;
+        std::weak_ptr<PoolState> state;
+        List lists[POOL_NUM_CLASSES];
+
+        ~PoolThreadCache() { release(); }
+
+        /**
+         * @brief Returns cached blocks to their pool, if it still exists
+         */
+        void release()
+        {
+          if (std::shared_ptr<PoolState> owner = state.lock())
+          {
+            for (size_t i = 0; i < POOL_NUM_CLASSES; ++i)
+            {
+              PoolBlockHeader *head = lists[i].head;
+              if (!head)
+                continue;
+
+              PoolBlockHeader *last = head;
+              while (last->next)
+                last = last->next;
+
+              owner->push(i, head, last);
+            }
+          }
+
+          for (List &list : lists)
+            list = List{};
+
+          state.reset();
+          pool_id = 0;
+        }
+      };
+
+      inline PoolThreadCache &pool_thread_cache()
+      {
+        thread_local PoolThreadCache cache;
+        return cache;
+      }
+
+      inline std::uint64_t next_pool_id()
+      {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+      }
+    } // namespace detail
 
     /**
      * @class MemoryPool
-     * @brief Class representing a memory pool.
+     * @brief Segregated size-class memory pool
+     *
+     * Requests up to detail::POOL_MAX_SMALL_SIZE bytes are rounded to one of
+     * detail::POOL_NUM_CLASSES size classes and served from per-thread
+     * caches, backed by lock-free per-class free lists shared by all
+     * threads. Fresh blocks are split off large regions with a bump pointer,
+     * so allocation and deallocation are O(1) and never take a lock unless
+     * the pool has to carve or grow. Larger requests use a best-fit list of
+     * free blocks that are split when much larger than the request.
+     *
+     * Every block carries a one-cache-line header in front of the returned
+     * pointer, which is how deallocate finds its size class.
+     *
+     * Alignments above DEFAULT_ALIGNMENT (up to HUGE_PAGE_ALIGNMENT) are
+     * carved out of a regular block that reserves alignment slack. A second
+     * header directly in front of the aligned pointer records the offset
+     * back to the backing block, so the memory is returned to the pool like
+     * any other allocation.
      */
     class MemoryPool
     {
     public:
-      explicit MemoryPool(size_t initial_size = 1024 * 1024)
-          : m_total_size(0), m_max_block_size(0)
+      /**
+       * @brief Constructs a memory pool
+       *
+       * @param initial_size Size of the first region in bytes
+       * @param policy How regions are backed: the heap for the default
+       * policy, otherwise page mappings with the requested huge pages and
+       * NUMA placement
+       */
+      explicit MemoryPool(size_t initial_size = 1024 * 1024,
+                          const AllocationPolicy &policy = AllocationPolicy{})
+          : m_state(std::make_shared<detail::PoolState>(detail::next_pool_id(), policy))
       {
+        std::lock_guard<std::mutex> lock(m_state->region_mutex);
         grow(initial_size);
       }
 
-      ~MemoryPool()
-      {
-        for (MemoryBlock &block : m_blocks)
-          ::operator delete(block.ptr);
-      }
+      ~MemoryPool() = default;
+
+      MemoryPool(const MemoryPool &) = delete;
+      MemoryPool &operator=(const MemoryPool &) = delete;
 
       /**
        * @brief Allocates memory with the specified size and alignment.
@@ -76,76 +331,409 @@ namespace tf
        * @param size Size of the memory to allocate.
        * @param alignment Alignment of the memory.
        * @return void* Pointer to the allocated memory.
+       * @throw ValueError if the alignment is not a power of two.
+       * @throw MemoryError if the alignment exceeds HUGE_PAGE_ALIGNMENT.
        */
       void *allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (MemoryBlock &block : m_blocks)
-        {
-          if (!block.in_use && block.size >= size)
-          {
-            block.in_use = true;
-            return align_pointer(static_cast<char *>(block.ptr), alignment);
-          }
-        }
+        TF_CHECK(alignment != 0 && (alignment & (alignment - 1)) == 0,
+                 core::ValueError, "Alignment must be a power of two");
+        TF_CHECK(alignment <= HUGE_PAGE_ALIGNMENT, core::MemoryError,
+                 "Alignment above HUGE_PAGE_ALIGNMENT is not supported");
+
+        if (alignment <= DEFAULT_ALIGNMENT)
+          return allocate_block(size);
 
-        size_t grow_size = std::max(size, m_total_size / 2);
-        grow(grow_size);
+        // The backing block is 64-byte aligned, so an aligned address with
+        // room for a header in front lies within its first `alignment`
+        // bytes.
+        char *base = static_cast<char *>(allocate_block(size + alignment));
+        char *aligned = align_pointer(base + detail::POOL_HEADER_SIZE, alignment);
 
-        m_blocks.back().in_use = true;
-        return align_pointer(static_cast<char *>(m_blocks.back().ptr),
-                             alignment);
+        detail::PoolBlockHeader *header = init_header(
+            aligned - detail::POOL_HEADER_SIZE, detail::POOL_ALIGNED_CLASS, size);
+        header->offset = static_cast<size_t>(aligned - base);
+        header->in_use = true;
+
+        return aligned;
       }
 
       /**
        * @brief Deallocates memory.
        *
        * @param ptr Pointer to the memory to deallocate.
+       * @throw MemoryError if ptr was not allocated by this pool or was
+       * already deallocated.
        */
       void deallocate(void *ptr)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (MemoryBlock &block : m_blocks)
+        if (!ptr)
+          return;
+
+        auto *header = reinterpret_cast<detail::PoolBlockHeader *>(
+            static_cast<char *>(ptr) - detail::POOL_HEADER_SIZE);
+
+        TF_CHECK(header->magic == detail::POOL_MAGIC && header->pool_id == m_state->id,
+                 core::MemoryError, "Pointer was not allocated by this pool");
+        TF_CHECK(header->in_use, core::MemoryError, "Pointer was already deallocated");
+
+        header->in_use = false;
+
+        if (header->size_class == detail::POOL_ALIGNED_CLASS)
         {
-          if (block.ptr == ptr)
-          {
-            block.in_use = false;
-            return;
-          }
+          // The header lives inside the backing block; clear it so a stale
+          // pointer cannot pass the checks above once the block is reused.
+          char *base = static_cast<char *>(ptr) - header->offset;
+          header->magic = 0;
+          deallocate(base);
+          return;
+        }
+
+        if (header->size_class == detail::POOL_LARGE_CLASS)
+        {
+          std::lock_guard<std::mutex> lock(m_state->large_mutex);
+          m_state->large_free.emplace(header->capacity, header);
+          return;
         }
+
+        const size_t index = header->size_class;
+        detail::PoolThreadCache *cache = thread_cache();
+        if (!cache)
+        {
+          m_state->push(index, header, header);
+          return;
+        }
+
+        detail::PoolThreadCache::List &list = cache->lists[index];
+        header->next = list.head;
+        list.head = header;
+        ++list.count;
+
+        if (list.count > cache_limit(index))
+          flush_half(list, index);
       }
 
       // Statistics
-      size_t total_size() const { return m_total_size; }
-      size_t max_block_size() const { return m_max_block_size; }
-      size_t num_blocks() const { return m_blocks.size(); }
+      size_t total_size() const { return m_state->total_size.load(std::memory_order_relaxed); }
+      size_t max_block_size() const { return m_state->max_block_size.load(std::memory_order_relaxed); }
+      size_t num_blocks() const { return m_state->num_blocks.load(std::memory_order_relaxed); }
 
     private:
-      std::vector<MemoryBlock> m_blocks;
-      size_t m_total_size;
-      size_t m_max_block_size;
-      mutable std::mutex m_mutex;
+      std::shared_ptr<detail::PoolState> m_state;
+
+      void *allocate_block(size_t size)
+      {
+        detail::PoolBlockHeader *header =
+            size <= detail::POOL_MAX_SMALL_SIZE ? allocate_small(size) : allocate_large(size);
+
+        header->in_use = true;
+        return reinterpret_cast<char *>(header) + detail::POOL_HEADER_SIZE;
+      }
+
+      /**
+       * @brief Gets the calling thread's cache if it belongs to this pool
+       *
+       * A thread adopts this pool when its cache is unused or its previous
+       * pool has been destroyed.
+       *
+       * @return detail::PoolThreadCache* Cache, or nullptr if the thread
+       * caches for another live pool
+       */
+      detail::PoolThreadCache *thread_cache() const
+      {
+        detail::PoolThreadCache &cache = detail::pool_thread_cache();
+        if (cache.pool_id == m_state->id)
+          return &cache;
+
+        if (cache.pool_id != 0 && !cache.state.expired())
+          return nullptr;
+
+        // The previous pool is gone, so its cached blocks were freed with it
+        for (auto &list : cache.lists)
+          list = detail::PoolThreadCache::List{};
+
+        cache.pool_id = m_state->id;
+        cache.state = m_state;
+        return &cache;
+      }
+
+      static size_t cache_limit(size_t index)
+      {
+        return std::max<size_t>(2, detail::POOL_THREAD_CACHE_BYTES /
+                                       detail::size_class_capacity(index));
+      }
+
+      /**
+       * @brief Moves half of a thread's cached blocks to the shared list
+       */
+      void flush_half(detail::PoolThreadCache::List &list, size_t index)
+      {
+        const size_t keep = list.count / 2;
+        detail::PoolBlockHeader *last = list.head;
+        for (size_t i = 1; i < keep; ++i)
+          last = last->next;
+
+        detail::PoolBlockHeader *first = last->next;
+        detail::PoolBlockHeader *tail = first;
+        while (tail->next)
+          tail = tail->next;
+
+        last->next = nullptr;
+        list.count = keep;
+        m_state->push(index, first, tail);
+      }
+
+      detail::PoolBlockHeader *allocate_small(size_t size)
+      {
+        const size_t index = detail::size_class_index(size);
+        detail::PoolThreadCache *cache = thread_cache();
+
+        // Fast path: this thread's own cache
+        if (cache && cache->lists[index].head)
+        {
+          detail::PoolThreadCache::List &list = cache->lists[index];
+          detail::PoolBlockHeader *header = list.head;
+          list.head = header->next;
+          --list.count;
+          return header;
+        }
+
+        // Shared list: take every block, keep one and cache (or return) the rest
+        if (detail::PoolBlockHeader *head = m_state->take_all(index))
+        {
+          detail::PoolBlockHeader *rest = head->next;
+          if (rest && cache)
+          {
+            size_t count = 0;
+            for (detail::PoolBlockHeader *h = rest; h; h = h->next)
+              ++count;
+
+            cache->lists[index].head = rest;
+            cache->lists[index].count = count;
+            if (count > cache_limit(index))
+              flush_half(cache->lists[index], index);
+          }
+          else if (rest)
+          {
+            detail::PoolBlockHeader *last = rest;
+            while (last->next)
+              last = last->next;
+            m_state->push(index, rest, last);
+          }
+
+          return head;
+        }
+
+        // Carve fresh blocks from the current region; extras go to the cache
+        const size_t capacity = detail::size_class_capacity(index);
+        const size_t block = detail::POOL_HEADER_SIZE + capacity;
+        const size_t batch = cache ? std::clamp<size_t>((16 << 10) / block, 1, 16) : 1;
+
+        std::lock_guard<std::mutex> lock(m_state->region_mutex);
+        if (static_cast<size_t>(m_state->bump_end - m_state->bump) < block)
+          grow(std::max(block, total_size() / 2));
+
+        detail::PoolBlockHeader *header = carve(block, index, capacity);
+        for (size_t i = 1; i < batch; ++i)
+        {
+          if (static_cast<size_t>(m_state->bump_end - m_state->bump) < block)
+            break;
+
+          detail::PoolBlockHeader *extra = carve(block, index, capacity);
+          extra->next = cache->lists[index].head;
+          cache->lists[index].head = extra;
+          ++cache->lists[index].count;
+        }
+
+        return header;
+      }
+
+      detail::PoolBlockHeader *allocate_large(size_t size)
+      {
+        const size_t capacity = align_size(size);
+
+        {
+          std::lock_guard<std::mutex> lock(m_state->large_mutex);
+          auto it = m_state->large_free.lower_bound(capacity);
+          if (it != m_state->large_free.end())
+          {
+            detail::PoolBlockHeader *header = it->second;
+            m_state->large_free.erase(it);
+
+            // Split off the tail when it is big enough to be useful
+            const size_t remainder = header->capacity - capacity;
+            if (remainder >= detail::POOL_HEADER_SIZE + detail::POOL_MIN_LARGE_SPLIT)
+            {
+              char *tail = reinterpret_cast<char *>(header) + detail::POOL_HEADER_SIZE + capacity;
+              detail::PoolBlockHeader *split = init_header(
+                  tail, detail::POOL_LARGE_CLASS, remainder - detail::POOL_HEADER_SIZE);
+              m_state->large_free.emplace(split->capacity, split);
+              header->capacity = capacity;
+            }
+
+            return header;
+          }
+        }
+
+        const size_t block = detail::POOL_HEADER_SIZE + capacity;
+
+        std::lock_guard<std::mutex> lock(m_state->region_mutex);
+        if (static_cast<size_t>(m_state->bump_end - m_state->bump) < block)
+          grow(std::max(block, total_size() / 2));
+
+        return carve(block, detail::POOL_LARGE_CLASS, capacity);
+      }
+
+      static size_t align_size(size_t size)
+      {
+        return (size + DEFAULT_ALIGNMENT - 1) & ~(DEFAULT_ALIGNMENT - 1);
+      }
+
+      detail::PoolBlockHeader *init_header(void *at, std::uint32_t size_class, size_t capacity)
+      {
+        auto *header = static_cast<detail::PoolBlockHeader *>(at);
+        header->magic = detail::POOL_MAGIC;
+        header->size_class = size_class;
+        header->pool_id = m_state->id;
+        header->capacity = capacity;
+        header->next = nullptr;
+        header->offset = 0;
+        header->in_use = false;
+        return header;
+      }
+
+      /**
+       * @brief Splits a block off the front of the current region
+       *
+       * Must be called with the region mutex held and enough room left.
+       */
+      detail::PoolBlockHeader *carve(size_t block, size_t size_class, size_t capacity)
+      {
+        char *at = m_state->bump;
+        m_state->bump += block;
+        return init_header(at, static_cast<std::uint32_t>(size_class), capacity);
+      }
 
       /**
        * @brief Grows the memory pool by the specified size.
        *
+       * What is left of the previous region is split into blocks of the
+       * largest size classes that fit, so it is not wasted. Must be called
+       * with the region mutex held.
+       *
        * @param min_size Minimum size to grow the memory pool.
        */
       void grow(size_t min_size)
       {
-        size_t size = std::max(min_size, static_cast<size_t>(64));
-        void *ptr = ::operator new(size);
+        for (size_t i = detail::POOL_NUM_CLASSES; i-- > 0;)
+        {
+          const size_t capacity = detail::size_class_capacity(i);
+          const size_t block = detail::POOL_HEADER_SIZE + capacity;
+
+          while (static_cast<size_t>(m_state->bump_end - m_state->bump) >= block)
+          {
+            detail::PoolBlockHeader *header = carve(block, i, capacity);
+            m_state->push(i, header, header);
+          }
+        }
+
+        size_t size = align_size(std::max(min_size, detail::POOL_HEADER_SIZE + DEFAULT_ALIGNMENT));
+
+        PageAllocation region;
+        if (m_state->policy.is_default())
+        {
+          region.ptr = ::operator new(size, std::align_val_t{DEFAULT_ALIGNMENT});
+          region.size = size;
+        }
+        else
+        {
+          // Mappings come in whole pages; use all of them
+          region = allocate_pages(size, m_state->policy);
+          size = region.size;
+        }
 
-        m_blocks.push_back({ptr, size, DEFAULT_ALIGNMENT, false});
+        m_state->regions.push_back(region);
+        m_state->bump = static_cast<char *>(region.ptr);
+        m_state->bump_end = m_state->bump + size;
 
-        m_total_size += size;
-        m_max_block_size = std::max(m_max_block_size, size);
+        m_state->total_size.fetch_add(size, std::memory_order_relaxed);
+        m_state->max_block_size.store(std::max(max_block_size(), size), std::memory_order_relaxed);
+        m_state->num_blocks.fetch_add(1, std::memory_order_relaxed);
       }
     };
 
+    namespace detail
+    {
+      /**
+       * @brief Number of independently locked allocation maps
+       */
+      inline constexpr size_t TRACKER_NUM_SHARDS = 64;
+
+      /**
+       * @brief Buckets of the allocation-size histogram (one per bit width)
+       */
+      inline constexpr size_t TRACKER_HISTOGRAM_BUCKETS = 8 * sizeof(size_t) + 1;
+
+      /**
+       * @brief Net bytes a thread buffers before publishing them
+       */
+      inline constexpr int64_t TRACKER_FLUSH_BYTES = 64 * 1024;
+
+      /**
+       * @brief One shard of the live-allocation map, selected by address
+       */
+      struct alignas(DEFAULT_ALIGNMENT) TrackerShard
+      {
+        struct Entry
+        {
+          size_t size;
+          size_t weight; ///< Allocations this entry stands for (the sample rate)
+        };
+
+        std::mutex mutex;
+        std::unordered_map<void *, Entry> allocations;
+        std::atomic<size_t> active{0};
+      };
+
+      /**
+       * @brief Counters owned (written) by a single thread
+       *
+       * Readers merge them on demand. reset_stats zeroes them from
+       * another thread, so every update is an atomic read-modify-write
+       * rather than a load and store; on a line only its owner touches it
+       * stays uncontended.
+       */
+      struct alignas(DEFAULT_ALIGNMENT) TrackerCounters
+      {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+        std::atomic<int64_t> pending_bytes{0};
+        std::array<std::atomic<size_t>, TRACKER_HISTOGRAM_BUCKETS> histogram{};
+        uint64_t rng = 0;
+      };
+
+      template <typename T>
+      inline void add_relaxed(std::atomic<T> &counter, T value)
+      {
+        counter.fetch_add(value, std::memory_order_relaxed);
+      }
+    } // namespace detail
+
     /**
      * @class MemoryTracker
      * @brief Class representing a memory tracker.
+     *
+     * Counters and the size histogram are kept per thread and merged when
+     * read; live allocations are recorded in address-sharded maps, so
+     * threads tracking unrelated pointers rarely contend. Byte totals are
+     * buffered per thread (up to a small threshold) before being
+     * published, so peak usage may be under-reported by at most that
+     * threshold per concurrently allocating thread.
+     *
+     * With a sample rate of N, only about one in N allocations is recorded
+     * and each recorded one counts N times towards bytes, active
+     * allocations and deallocations. Allocation counts and the histogram
+     * always cover every allocation.
      */
     class MemoryTracker
     {
@@ -153,12 +741,15 @@ namespace tf
       /**
        * @brief Gets the memory tracker instance.
        *
+       * The instance is never destroyed, so threads exiting during static
+       * destruction can still report to it.
+       *
        * @return MemoryTracker& Memory tracker instance.
        */
       static MemoryTracker &instance()
       {
-        static MemoryTracker instance;
-        return instance;
+        static MemoryTracker *instance = new MemoryTracker();
+        return *instance;
       }
 
       /**
@@ -169,11 +760,32 @@ namespace tf
        */
       void track_allocation(void *ptr, size_t size)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        detail::TrackerCounters &local = counters();
+        detail::add_relaxed(local.allocations, size_t{1});
+        detail::add_relaxed(local.histogram[histogram_bucket(size)], size_t{1});
+
+        const size_t rate = m_sample_rate.load(std::memory_order_relaxed);
+        if (rate > 1 && next_random(local) % rate != 0)
+          return;
+
+        detail::TrackerShard &shard = shard_for(ptr);
+        int64_t delta = static_cast<int64_t>(size * rate);
+        {
+          std::lock_guard<std::mutex> lock(shard.mutex);
+
+          auto [it, inserted] = shard.allocations.try_emplace(ptr, detail::TrackerShard::Entry{size, rate});
+          if (!inserted)
+          {
+            // The pointer was tracked again without being released
+            delta -= static_cast<int64_t>(it->second.size * it->second.weight);
+            shard.active.fetch_sub(it->second.weight, std::memory_order_relaxed);
+            it->second = detail::TrackerShard::Entry{size, rate};
+          }
+
+          shard.active.fetch_add(rate, std::memory_order_relaxed);
+        }
 
-        m_allocations[ptr] = AllocationInfo{size, std::this_thread::get_id()};
-        m_total_allocated += size;
-        m_allocation_count++;
+        publish(local, delta);
       }
 
       /**
@@ -183,51 +795,291 @@ namespace tf
        */
       void track_deallocation(void *ptr)
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        detail::TrackerShard &shard = shard_for(ptr);
+
+        // Recording a pointer happens before releasing it, so an empty
+        // shard cannot hold it
+        if (shard.active.load(std::memory_order_relaxed) == 0)
+          return;
 
-        auto it = m_allocations.find(ptr);
-        if (it != m_allocations.end())
+        detail::TrackerShard::Entry entry;
         {
-          m_total_allocated -= it->second.size;
-          m_deallocation_count++;
-          m_allocations.erase(it);
+          std::lock_guard<std::mutex> lock(shard.mutex);
+
+          auto it = shard.allocations.find(ptr);
+          if (it == shard.allocations.end())
+            return;
+
+          entry = it->second;
+          shard.allocations.erase(it);
+          shard.active.fetch_sub(entry.weight, std::memory_order_relaxed);
         }
+
+        detail::TrackerCounters &local = counters();
+        detail::add_relaxed(local.deallocations, entry.weight);
+        publish(local, -static_cast<int64_t>(entry.size * entry.weight));
+      }
+
+      /**
+       * @brief Sets how many allocations each recorded one stands for.
+       *
+       * @param rate Sample rate, 1 to record every allocation.
+       * @throw ValueError if the rate is zero.
+       */
+      void set_sample_rate(size_t rate)
+      {
+        TF_CHECK(rate > 0, core::ValueError, "Sample rate must be positive");
+        m_sample_rate.store(rate, std::memory_order_relaxed);
       }
 
+      size_t sample_rate() const { return m_sample_rate.load(std::memory_order_relaxed); }
+
       // Statistics
-      size_t total_allocated() const { return m_total_allocated; }
-      size_t allocation_count() const { return m_allocation_count; }
-      size_t deallocation_count() const { return m_deallocation_count; }
-      size_t active_allocations() const { return m_allocations.size(); }
+      /**
+       * @brief Gets the bytes currently allocated.
+       *
+       * @return size_t Live bytes (an estimate when sampling).
+       */
+      size_t total_allocated() const
+      {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        return current_bytes();
+      }
+
+      /**
+       * @brief Gets the highest number of bytes allocated at once.
+       *
+       * @return size_t Peak live bytes since the last reset.
+       */
+      size_t peak_allocated() const
+      {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        return std::max(m_peak.load(std::memory_order_relaxed), current_bytes());
+      }
+
+      size_t allocation_count() const
+      {
+        return merge([](const detail::TrackerCounters &c)
+                     { return c.allocations.load(std::memory_order_relaxed); });
+      }
+
+      size_t deallocation_count() const
+      {
+        return merge([](const detail::TrackerCounters &c)
+                     { return c.deallocations.load(std::memory_order_relaxed); });
+      }
+
+      size_t active_allocations() const
+      {
+        size_t total = 0;
+        for (const detail::TrackerShard &shard : m_shards)
+          total += shard.active.load(std::memory_order_relaxed);
+        return total;
+      }
+
+      /**
+       * @brief Gets the allocation-size histogram.
+       *
+       * Bucket b counts allocations whose size has bit width b, i.e. sizes
+       * in [2^(b-1), 2^b); bucket 0 counts zero-byte allocations.
+       *
+       * @return std::vector<size_t> TRACKER_HISTOGRAM_BUCKETS counts.
+       */
+      std::vector<size_t> size_histogram() const
+      {
+        std::vector<size_t> histogram(detail::TRACKER_HISTOGRAM_BUCKETS, 0);
+
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        auto add = [&histogram](const detail::TrackerCounters &c)
+        {
+          for (size_t b = 0; b < histogram.size(); ++b)
+            histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+        };
+
+        add(m_retired);
+        for (const auto &counters : m_threads)
+          add(*counters);
+        return histogram;
+      }
+
+      /**
+       * @brief Gets the histogram bucket of an allocation size.
+       *
+       * @param size Size in bytes.
+       * @return size_t Bucket index.
+       */
+      static size_t histogram_bucket(size_t size)
+      {
+        return static_cast<size_t>(std::bit_width(size));
+      }
 
       /**
        * @brief Resets the memory tracker statistics.
+       *
+       * Safe while other threads allocate: every counter is zeroed
+       * atomically, so no update made before the reset is written back
+       * after it. Operations that overlap the reset are counted on either
+       * side of it, and releases of pointers recorded before it are
+       * ignored.
        */
       void reset_stats()
       {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+        for (detail::TrackerShard &shard : m_shards)
+        {
+          std::lock_guard<std::mutex> shard_lock(shard.mutex);
+          shard.allocations.clear();
+          shard.active.store(0, std::memory_order_relaxed);
+        }
 
-        m_total_allocated = 0;
-        m_allocation_count = 0;
-        m_deallocation_count = 0;
+        clear(m_retired);
+        for (const auto &counters : m_threads)
+          clear(*counters);
 
-        m_allocations.clear();
+        m_current.store(0, std::memory_order_relaxed);
+        m_peak.store(0, std::memory_order_relaxed);
       }
 
     private:
-      struct AllocationInfo
+      /**
+       * @brief Registers the calling thread's counters for its lifetime
+       */
+      struct ThreadSlot
       {
-        size_t size;
-        std::thread::id thread_id;
+        std::shared_ptr<detail::TrackerCounters> counters;
+
+        ~ThreadSlot()
+        {
+          if (counters)
+            MemoryTracker::instance().retire(counters);
+        }
       };
 
-      std::unordered_map<void *, AllocationInfo> m_allocations;
-      std::atomic<size_t> m_total_allocated{0};
-      std::atomic<size_t> m_allocation_count{0};
-      std::atomic<size_t> m_deallocation_count{0};
-      mutable std::mutex m_mutex;
+      std::array<detail::TrackerShard, detail::TRACKER_NUM_SHARDS> m_shards;
+
+      mutable std::mutex m_registry_mutex;
+      std::vector<std::shared_ptr<detail::TrackerCounters>> m_threads;
+      detail::TrackerCounters m_retired; ///< Counts of threads that exited
+
+      std::atomic<int64_t> m_current{0}; ///< Published live bytes
+      std::atomic<size_t> m_peak{0};
+      std::atomic<size_t> m_sample_rate{1};
 
       MemoryTracker() = default;
+
+      detail::TrackerCounters &counters()
+      {
+        thread_local ThreadSlot slot;
+        if (!slot.counters)
+        {
+          auto counters = std::make_shared<detail::TrackerCounters>();
+
+          // Distinct, non-zero xorshift seed per thread
+          uint64_t seed = reinterpret_cast<std::uintptr_t>(counters.get()) * 0x9e3779b97f4a7c15ull;
+          counters->rng = seed ? seed : 1;
+
+          std::lock_guard<std::mutex> lock(m_registry_mutex);
+          m_threads.push_back(counters);
+          slot.counters = std::move(counters);
+        }
+
+        return *slot.counters;
+      }
+
+      void retire(const std::shared_ptr<detail::TrackerCounters> &counters)
+      {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+        detail::add_relaxed(m_retired.allocations, counters->allocations.load(std::memory_order_relaxed));
+        detail::add_relaxed(m_retired.deallocations, counters->deallocations.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < detail::TRACKER_HISTOGRAM_BUCKETS; ++b)
+          detail::add_relaxed(m_retired.histogram[b], counters->histogram[b].load(std::memory_order_relaxed));
+        m_current.fetch_add(counters->pending_bytes.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+
+        m_threads.erase(std::remove(m_threads.begin(), m_threads.end(), counters), m_threads.end());
+      }
+
+      static void clear(detail::TrackerCounters &counters)
+      {
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.deallocations.store(0, std::memory_order_relaxed);
+        counters.pending_bytes.store(0, std::memory_order_relaxed);
+        for (auto &bucket : counters.histogram)
+          bucket.store(0, std::memory_order_relaxed);
+      }
+
+      template <typename Getter>
+      size_t merge(Getter get) const
+      {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+        size_t total = get(m_retired);
+        for (const auto &counters : m_threads)
+          total += get(*counters);
+        return total;
+      }
+
+      /**
+       * @brief Live bytes; the caller holds the registry mutex
+       */
+      size_t current_bytes() const
+      {
+        int64_t total = m_current.load(std::memory_order_relaxed);
+        for (const auto &counters : m_threads)
+          total += counters->pending_bytes.load(std::memory_order_relaxed);
+        return total > 0 ? static_cast<size_t>(total) : 0;
+      }
+
+      detail::TrackerShard &shard_for(const void *ptr)
+      {
+        // Fibonacci hashing of the address above cache-line granularity
+        const uint64_t key = static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(ptr) >> 6);
+        return m_shards[(key * 0x9e3779b97f4a7c15ull) >> (64 - std::countr_zero(detail::TRACKER_NUM_SHARDS))];
+      }
+
+      static uint64_t next_random(detail::TrackerCounters &counters)
+      {
+        uint64_t x = counters.rng;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        counters.rng = x;
+        return x;
+      }
+
+      /**
+       * @brief Adds a byte delta to the thread's pending total
+       *
+       * The shared total is only written once the pending amount crosses
+       * TRACKER_FLUSH_BYTES; the peak is only written when it grows.
+       */
+      void publish(detail::TrackerCounters &local, int64_t delta)
+      {
+        const int64_t pending = local.pending_bytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+        int64_t published = m_current.load(std::memory_order_relaxed);
+
+        if (pending >= detail::TRACKER_FLUSH_BYTES || pending <= -detail::TRACKER_FLUSH_BYTES)
+        {
+          // Take what is pending now, which a concurrent reset may have zeroed
+          const int64_t flushed = local.pending_bytes.exchange(0, std::memory_order_relaxed);
+          published = m_current.fetch_add(flushed, std::memory_order_relaxed) + flushed;
+        }
+        else
+        {
+          published += pending;
+        }
+
+        if (delta > 0 && published > 0)
+        {
+          const size_t value = static_cast<size_t>(published);
+          size_t peak = m_peak.load(std::memory_order_relaxed);
+          while (value > peak && !m_peak.compare_exchange_weak(peak, value, std::memory_order_relaxed))
+          {
+          }
+        }
+      }
     };
 
     /**
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace tf
+{
+  namespace utils
+  {
+    /**
+     * @enum PageSize
+     * @brief Page size requested for a mapping
+     */
+    enum class PageSize
+    {
+      Default,     ///< Regular pages
+      Transparent, ///< Regular mapping advised for transparent huge pages
+      Huge2M,      ///< Reserved 2 MB huge pages (MAP_HUGETLB)
+      Huge1G       ///< Reserved 1 GB huge pages (MAP_HUGETLB)
+    };
+
+    /**
+     * @enum NumaPolicy
+     * @brief Placement of a mapping's pages across NUMA nodes
+     */
+    enum class NumaPolicy
+    {
+      Default,    ///< Kernel default (first touch)
+      Bind,       ///< Only allocate from the given nodes
+      Preferred,  ///< Prefer the first given node, fall back to others
+      Interleave  ///< Spread pages round-robin over the given nodes
+    };
+
+    /**
+     * @struct AllocationPolicy
+     * @brief How large buffers are backed by the operating system
+     *
+     * Huge pages that cannot be provided degrade gracefully: 1 GB falls back
+     * to 2 MB, and reserved huge pages fall back to transparent huge pages.
+     * A NUMA policy the system rejects (for example on a single-node host)
+     * leaves the default placement.
+     */
+    struct AllocationPolicy
+    {
+      PageSize page_size = PageSize::Default;
+      NumaPolicy numa = NumaPolicy::Default;
+      std::vector<int> nodes; ///< Nodes for the NUMA policy; empty means all
+
+      /**
+       * @brief Checks whether the policy asks for anything beyond the heap
+       *
+       * @return bool True for the default page size and NUMA placement
+       */
+      bool is_default() const
+      {
+        return page_size == PageSize::Default && numa == NumaPolicy::Default;
+      }
+    };
+
+    /**
+     * @struct PageAllocation
+     * @brief A mapping returned by allocate_pages
+     */
+    struct PageAllocation
+    {
+      void *ptr = nullptr;
+      size_t size = 0;                       ///< Mapped bytes, a multiple of the page size
+      PageSize page_size = PageSize::Default; ///< Page size actually obtained
+      bool mapped = false;                   ///< False when backed by the heap
+    };
+
+    /**
+     * @brief Maps memory according to an allocation policy
+     *
+     * The mapping is aligned to (and sized in multiples of) the page size
+     * obtained, and zero-filled. Pages are not touched, so with the default
+     * NUMA policy they land on the node of the thread that first writes
+     * them.
+     *
+     * @param size Minimum size in bytes
+     * @param policy Page size and NUMA placement
+     * @return PageAllocation Mapping, to be released with free_pages
+     * @throw MemoryError if no memory could be mapped
+     */
+    PageAllocation allocate_pages(size_t size, const AllocationPolicy &policy);
+
+    /**
+     * @brief Releases a mapping returned by allocate_pages
+     *
+     * @param allocation Mapping to release
+     */
+    void free_pages(const PageAllocation &allocation);
+
+    /**
+     * @brief Gets the number of NUMA nodes
+     *
+     * @return int Number of online nodes, at least 1
+     */
+    int numa_node_count();
+
+    /**
+     * @brief Gets the CPUs of a NUMA node
+     *
+     * Suitable for core::ThreadPool::set_affinity, so that the pool's
+     * threads run next to memory bound to the same node.
+     *
+     * @param node NUMA node index
+     * @return std::vector<int> CPU indices, empty if the node is unknown
+     */
+    std::vector<int> numa_node_cpus(int node);
+  } // namespace utils
+} // namespace tf
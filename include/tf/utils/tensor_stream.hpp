@@ -0,0 +1,153 @@
+#pragma once
+
+#include <tf/core/types.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/utils/checkpoint.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tf
+{
+  namespace utils
+  {
+    namespace detail
+    {
+      struct StreamState;
+    } // namespace detail
+
+    /**
+     * @struct StreamOptions
+     * @brief Batching and read-ahead of a TensorStream
+     */
+    struct StreamOptions
+    {
+      size_t batch_size = 1;  ///< Rows (indices along the first dimension) per batch
+      size_t buffers = 2;     ///< Batch buffers, filled ahead of the consumer; 2 double-buffers
+      size_t io_threads = 1;  ///< Background threads reading and decompressing batches
+      bool drop_last = false; ///< Skip a final batch with fewer than batch_size rows
+    };
+
+    /**
+     * @class StreamBatch
+     * @brief Rows [first_row, first_row + rows) of every streamed tensor
+     *
+     * The views live in a pooled buffer of the stream, which is reused for
+     * a later batch once the batch and every view obtained from it are
+     * gone.
+     */
+    class StreamBatch
+    {
+    public:
+      size_t index() const { return m_index; }
+      size_t first_row() const { return m_first_row; }
+      size_t rows() const { return m_rows; }
+      size_t size() const { return m_data.size(); }
+
+      /**
+       * @brief Gets the rows of one tensor
+       *
+       * @tparam T Element type, which must match the stored type
+       * @param i Position of the tensor among the streamed names
+       * @return core::TensorView<T> Dense view of shape (rows, ...)
+       * @throw IndexError if i is out of range
+       * @throw TypeError if the tensor holds another type
+       */
+      template <typename T>
+      core::TensorView<T> get(size_t i) const
+      {
+        TF_CHECK(i < m_data.size(), core::IndexError, "Stream batch has no such tensor");
+        TF_CHECK(m_types[i] == core::data_type_of<T>(), core::TypeError,
+                 "Stream tensor holds another type");
+        return core::TensorView<T>(std::shared_ptr<T[]>(m_lease, reinterpret_cast<T *>(m_data[i])),
+                                   m_shapes[i]);
+      }
+
+    private:
+      friend class TensorStream;
+
+      size_t m_index = 0;
+      size_t m_first_row = 0;
+      size_t m_rows = 0;
+      std::vector<char *> m_data;
+      std::vector<core::DataType> m_types;
+      std::vector<core::Shape> m_shapes;
+      std::shared_ptr<void> m_lease; ///< Returns the buffer to the stream when released
+    };
+
+    /**
+     * @class TensorStream
+     * @brief Reads checkpoint tensors batch by batch, ahead of the consumer
+     *
+     * For data sets that do not fit in memory: the streamed tensors share
+     * their first dimension, which is cut into batches. Background threads
+     * read (and, for compressed tensors, decompress) the following batches
+     * into a fixed set of buffers from a MemoryPool while the consumer
+     * works on the current one, so I/O overlaps compute and memory stays
+     * at `buffers` batches. Batches are delivered in order whatever the
+     * number of threads. Files are read with plain positioned reads rather
+     * than mapped, so the data is not kept in the address space.
+     */
+    class TensorStream
+    {
+    public:
+      /**
+       * @brief Opens a checkpoint and starts reading ahead
+       *
+       * @param path Checkpoint file
+       * @param names Tensors to stream, all with the same first dimension
+       * @param options Batching and read-ahead
+       * @throw IOError if the file is not a valid checkpoint
+       * @throw IndexError if a name is not in the checkpoint
+       * @throw ShapeError if a tensor is a scalar or the first dimensions
+       * differ
+       * @throw ValueError if names is empty or an option is 0
+       * @throw NotImplementedError if a tensor's codec was not compiled in
+       */
+      TensorStream(const std::string &path, const std::vector<std::string> &names,
+                   const StreamOptions &options = {});
+
+      /**
+       * @brief Stops the background threads; batches still alive stay valid
+       */
+      ~TensorStream();
+
+      TensorStream(const TensorStream &) = delete;
+      TensorStream &operator=(const TensorStream &) = delete;
+
+      /**
+       * @brief Gets the next batch, waiting for it if it is not read yet
+       *
+       * @return std::optional<StreamBatch> Batch, or nothing at the end of
+       * the pass
+       * @throw IOError if reading or decompressing the batch failed
+       * @throw ValueError if every buffer is held by a live batch, so the
+       * next one can never be read
+       */
+      std::optional<StreamBatch> next();
+
+      /**
+       * @brief Restarts from the first batch
+       */
+      void reset();
+
+      size_t num_rows() const;
+      size_t num_batches() const;
+      const std::vector<CheckpointEntry> &entries() const;
+
+    private:
+      void start();
+      void stop();
+
+      std::shared_ptr<detail::StreamState> m_state;
+      std::vector<std::thread> m_workers;
+      size_t m_next = 0;
+    };
+  } // namespace utils
+} // namespace tf
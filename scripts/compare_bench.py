@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON reports and flags regressions.
+
+Usage:
+  compare_bench.py BASELINE.json CONTENDER.json [--threshold PCT]
+                   [--metric real_time|cpu_time] [--filter REGEX]
+
+Reports come from `benchmarks --benchmark_out=FILE --benchmark_out_format=json`
+(or the benchmarks_json build target). With --benchmark_repetitions, the median
+aggregate of each benchmark is compared; otherwise the single run is.
+
+Exits with status 1 when a benchmark common to both reports got slower by
+more than the threshold, so the script can gate CI jobs.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+# Seconds per time unit of the "time_unit" field
+UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+# Context keys that make timings incomparable when they differ
+CONTEXT_KEYS = ("host_name", "num_cpus", "library_build_type",
+                "tf_cpu_isa", "tf_blas_backend", "tf_num_threads")
+
+# Rate counters shown next to the time, in order of preference
+RATES = ("FLOP/s", "bytes_per_second", "items_per_second")
+
+
+def load(path):
+    with open(path, encoding="utf-8") as handle:
+        report = json.load(handle)
+
+    runs = {}
+    medians = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[entry["run_name"]] = entry
+        else:
+            runs.setdefault(entry.get("run_name", entry["name"]), entry)
+
+    # Medians replace the individual repetitions they summarize
+    runs.update(medians)
+    return report.get("context", {}), runs
+
+
+def seconds(entry, metric):
+    return entry[metric] * UNITS[entry.get("time_unit", "ns")]
+
+
+def format_rate(value):
+    for prefix, scale in (("T", 1e12), ("G", 1e9), ("M", 1e6), ("k", 1e3)):
+        if value >= scale:
+            return f"{value / scale:.2f}{prefix}"
+    return f"{value:.2f}"
+
+
+def rate_of(entry):
+    for name in RATES:
+        if name in entry:
+            return name, entry[name]
+    return None, None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="slowdown in percent reported as a regression (default: 5)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time",
+                        help="time compared (default: real_time)")
+    parser.add_argument("--filter", default=None,
+                        help="only compare benchmarks whose name matches this regex")
+    args = parser.parse_args()
+
+    base_context, base = load(args.baseline)
+    new_context, new = load(args.contender)
+
+    for key in CONTEXT_KEYS:
+        if base_context.get(key) != new_context.get(key):
+            print(f"warning: {key} differs: {base_context.get(key)} vs {new_context.get(key)}",
+                  file=sys.stderr)
+
+    pattern = re.compile(args.filter) if args.filter else None
+    names = [name for name in base if name in new and (not pattern or pattern.search(name))]
+    if not names:
+        print("No benchmarks in common", file=sys.stderr)
+        return 2
+
+    width = max(len(name) for name in names)
+    print(f"{'Benchmark':<{width}}  {'Baseline':>12}  {'Contender':>12}  {'Change':>8}  Rate")
+
+    regressions = []
+    for name in names:
+        before = seconds(base[name], args.metric)
+        after = seconds(new[name], args.metric)
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+
+        rate_name, rate_before = rate_of(base[name])
+        rate = ""
+        if rate_name and rate_name in new[name]:
+            rate = f"{format_rate(rate_before)} -> {format_rate(new[name][rate_name])} {rate_name}"
+
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        elif change < -args.threshold:
+            flag = "  improved"
+
+        print(f"{name:<{width}}  {before * 1e6:>10.3f}us  {after * 1e6:>10.3f}us  {change:>+7.1f}%  {rate}{flag}")
+
+    missing = sorted(set(base) - set(new))
+    if missing:
+        print(f"\n{len(missing)} baseline benchmarks missing from the contender", file=sys.stderr)
+
+    if regressions:
+        print(f"\n{len(regressions)} of {len(names)} benchmarks slower by more than {args.threshold:g}%")
+        return 1
+
+    print(f"\nNo regression above {args.threshold:g}% in {len(names)} benchmarks")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -15,6 +15,8 @@ show_help() {
   echo "  -t, --type TYPE         Build type (Debug|Release|RelWithDebInfo) [default: Release]"
   echo "  -c, --compiler CC       Compiler to use (gcc|clang) [default: gcc]"
   echo "  -f, --filter PATTERN    Only run tests matching pattern"
+  echo "  -b, --benchmark         Run the benchmarks instead, writing benchmarks.json"
+  echo "                          to the build directory (see scripts/compare_bench.py)"
 }
 
 # Parse arguments
@@ -36,6 +38,10 @@ while [[ $# -gt 0 ]]; do
     TEST_FILTER="$2"
     shift 2
     ;;
+  -b | --benchmark)
+    BENCHMARK=true
+    shift
+    ;;
   *)
     echo "Unknown option: $1"
     show_help
@@ -53,6 +59,15 @@ fi
 
 cd "$BUILD_DIR"
 
+if [ "$BENCHMARK" = true ]; then
+  echo "Running benchmarks..."
+  LD_LIBRARY_PATH="" ./bench/benchmarks \
+    --benchmark_out=benchmarks.json --benchmark_out_format=json \
+    ${TEST_FILTER:+--benchmark_filter="$TEST_FILTER"}
+  cd ../..
+  exit 0
+fi
+
 echo "Running tests..."
 if [ -n "$TEST_FILTER" ]; then
   LD_LIBRARY_PATH="" ./tests/unit/unit_tests --gtest_filter="$TEST_FILTER"
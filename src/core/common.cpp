@@ -0,0 +1,123 @@
+#include <tf/core/common.hpp>
+#include <tf/core/cpu.hpp>
+#include <tf/core/thread_pool.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TF_STREAMING_STORES 1
+#endif
+
+namespace tf
+{
+  namespace core
+  {
+    namespace detail
+    {
+      namespace
+      {
+        /**
+         * @brief Bytes per parallel chunk; a multiple of the page size so
+         * chunks line up with pages
+         */
+        constexpr size_t STREAM_GRAIN = 1024 * 1024;
+
+        constexpr size_t STREAM_ALIGNMENT = 16;
+
+        size_t head_bytes(const void *dst, size_t bytes)
+        {
+          const size_t misalignment = reinterpret_cast<std::uintptr_t>(dst) % STREAM_ALIGNMENT;
+          const size_t head = misalignment ? STREAM_ALIGNMENT - misalignment : 0;
+          return std::min(head, bytes);
+        }
+
+        void stream_copy_range(char *dst, const char *src, size_t bytes)
+        {
+#if defined(TF_STREAMING_STORES)
+          const size_t head = head_bytes(dst, bytes);
+          std::memcpy(dst, src, head);
+          dst += head;
+          src += head;
+          bytes -= head;
+
+          const size_t body = bytes / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+          for (size_t i = 0; i < body; i += STREAM_ALIGNMENT)
+          {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), v);
+          }
+
+          std::memcpy(dst + body, src + body, bytes - body);
+
+          // Streaming stores are weakly ordered; publish them before the
+          // chunk is reported done
+          _mm_sfence();
+#else
+          std::memcpy(dst, src, bytes);
+#endif
+        }
+
+        void stream_fill_range(char *dst, const char *pattern, size_t value_size, size_t count)
+        {
+          size_t bytes = count * value_size;
+
+#if defined(TF_STREAMING_STORES)
+          // Elements are aligned to their size, which divides 16, so every
+          // 16-byte boundary is also an element boundary
+          const size_t head = head_bytes(dst, bytes);
+          for (size_t i = 0; i < head; i += value_size)
+            std::memcpy(dst + i, pattern, value_size);
+          dst += head;
+          bytes -= head;
+
+          alignas(STREAM_ALIGNMENT) char block[STREAM_ALIGNMENT];
+          for (size_t i = 0; i < STREAM_ALIGNMENT; i += value_size)
+            std::memcpy(block + i, pattern, value_size);
+          const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+
+          const size_t body = bytes / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+          for (size_t i = 0; i < body; i += STREAM_ALIGNMENT)
+            _mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), v);
+
+          for (size_t i = body; i < bytes; i += value_size)
+            std::memcpy(dst + i, pattern, value_size);
+
+          _mm_sfence();
+#else
+          for (size_t i = 0; i < bytes; i += value_size)
+            std::memcpy(dst + i, pattern, value_size);
+#endif
+        }
+      } // namespace
+
+      size_t streaming_threshold()
+      {
+        static const size_t threshold = cpu_features().l3_cache_size;
+        return threshold;
+      }
+
+      void stream_copy(void *dst, const void *src, size_t bytes)
+      {
+        char *d = static_cast<char *>(dst);
+        const char *s = static_cast<const char *>(src);
+
+        parallel_for(0, bytes, STREAM_GRAIN, [d, s](size_t begin, size_t end)
+                     { stream_copy_range(d + begin, s + begin, end - begin); });
+      }
+
+      void stream_fill(void *dst, const void *value, size_t value_size, size_t count)
+      {
+        TF_CHECK(value_size != 0 && STREAM_ALIGNMENT % value_size == 0, ValueError,
+                 "Fill pattern size must divide 16");
+
+        char *d = static_cast<char *>(dst);
+        const char *pattern = static_cast<const char *>(value);
+
+        parallel_for(0, count, STREAM_GRAIN / value_size, [=](size_t begin, size_t end)
+                     { stream_fill_range(d + begin * value_size, pattern, value_size, end - begin); });
+      }
+    } // namespace detail
+  } // namespace core
+} // namespace tf
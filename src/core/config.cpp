@@ -0,0 +1,104 @@
+#include <tf/core/config.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace tf
+{
+  namespace core
+  {
+    namespace detail
+    {
+      namespace
+      {
+        /**
+         * @brief Reader slots of every thread that read an RcuCell
+         *
+         * Slots have stable addresses and are handed to new threads once
+         * their thread exits, so the registry grows with the number of
+         * threads alive at once, not with the number ever created.
+         */
+        struct RcuRegistry
+        {
+          std::mutex mutex;
+          std::deque<RcuReader> readers;
+        };
+
+        RcuRegistry &rcu_registry()
+        {
+          // Leaked: threads may read the configuration while static
+          // destructors run
+          static RcuRegistry *registry = new RcuRegistry();
+          return *registry;
+        }
+
+        /**
+         * @brief Returns the thread's slot to the registry when it exits
+         */
+        struct RcuReaderRelease
+        {
+          RcuReader *reader = nullptr;
+
+          ~RcuReaderRelease()
+          {
+            if (!reader)
+              return;
+
+            RcuRegistry &registry = rcu_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            reader->in_use = false;
+            // Reads from later thread-exit code take a slot that is never
+            // reused
+            rcu_thread_reader = nullptr;
+          }
+        };
+
+        thread_local bool t_release_registered = false;
+      } // namespace
+
+      RcuReader &register_rcu_reader()
+      {
+        RcuRegistry &registry = rcu_registry();
+        RcuReader *reader = nullptr;
+        {
+          std::lock_guard<std::mutex> lock(registry.mutex);
+          for (RcuReader &candidate : registry.readers)
+            if (!candidate.in_use)
+            {
+              candidate.in_use = true;
+              reader = &candidate;
+              break;
+            }
+
+          if (!reader)
+            reader = &registry.readers.emplace_back();
+        }
+
+        rcu_thread_reader = reader;
+        if (!t_release_registered)
+        {
+          thread_local RcuReaderRelease release;
+          release.reader = reader;
+          t_release_registered = true;
+        }
+        return *reader;
+      }
+
+      std::uint64_t oldest_rcu_reader()
+      {
+        RcuRegistry &registry = rcu_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        for (const RcuReader &reader : registry.readers)
+        {
+          const std::uint64_t epoch = reader.epoch.load(std::memory_order_seq_cst);
+          if (epoch != 0)
+            oldest = std::min(oldest, epoch);
+        }
+        return oldest;
+      }
+    } // namespace detail
+  } // namespace core
+} // namespace tf
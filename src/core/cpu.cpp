@@ -0,0 +1,200 @@
+#include <tf/core/cpu.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TF_CPU_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace tf
+{
+  namespace core
+  {
+    namespace
+    {
+#if defined(TF_CPU_X86)
+      void cpuid(std::uint32_t leaf, std::uint32_t subleaf, std::uint32_t regs[4])
+      {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+          regs[i] = static_cast<std::uint32_t>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+      }
+
+      std::uint64_t xgetbv0()
+      {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        std::uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+      }
+
+      bool bit(std::uint32_t reg, int index)
+      {
+        return (reg >> index) & 1u;
+      }
+
+      void detect_x86(CpuFeatures &f)
+      {
+        std::uint32_t r[4];
+        cpuid(0, 0, r);
+        const std::uint32_t max_leaf = r[0];
+
+        if (max_leaf < 1)
+          return;
+
+        cpuid(1, 0, r);
+        f.sse4_2 = bit(r[2], 20);
+        f.fma = bit(r[2], 12);
+        f.f16c = bit(r[2], 29);
+
+        // The OS must save the wider register state for AVX / AVX-512 to be usable
+        const bool osxsave = bit(r[2], 27);
+        const std::uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+        const bool os_ymm = (xcr0 & 0x6) == 0x6;
+        const bool os_zmm = (xcr0 & 0xe6) == 0xe6;
+        const bool os_amx = (xcr0 & 0x60000) == 0x60000;
+
+        f.avx = bit(r[2], 28) && os_ymm;
+        f.fma = f.fma && os_ymm;
+        f.f16c = f.f16c && os_ymm;
+
+        if (max_leaf < 7)
+          return;
+
+        cpuid(7, 0, r);
+        f.avx2 = bit(r[1], 5) && os_ymm;
+        f.avx512f = bit(r[1], 16) && os_zmm;
+        f.avx512dq = bit(r[1], 17) && os_zmm;
+        f.avx512bw = bit(r[1], 30) && os_zmm;
+        f.avx512vl = bit(r[1], 31) && os_zmm;
+        f.avx512_vnni = bit(r[2], 11) && os_zmm;
+        f.amx_bf16 = bit(r[3], 22) && os_amx;
+        f.amx_tile = bit(r[3], 24) && os_amx;
+        f.amx_int8 = bit(r[3], 25) && os_amx;
+
+        cpuid(7, 1, r);
+        f.avx512_bf16 = bit(r[0], 5) && os_zmm;
+      }
+#endif
+
+      void detect_caches(CpuFeatures &f)
+      {
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+        long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+        if (l1 > 0)
+          f.l1d_cache_size = static_cast<size_t>(l1);
+        if (l2 > 0)
+          f.l2_cache_size = static_cast<size_t>(l2);
+        if (l3 > 0)
+          f.l3_cache_size = static_cast<size_t>(l3);
+#else
+        (void)f;
+#endif
+      }
+
+      CpuFeatures detect()
+      {
+        CpuFeatures f;
+#if defined(TF_CPU_X86)
+        detect_x86(f);
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+        f.neon = true;
+#endif
+        detect_caches(f);
+        return f;
+      }
+
+      CpuIsa best_isa(const CpuFeatures &f)
+      {
+        if (f.neon)
+          return CpuIsa::NEON;
+
+        if (f.avx512f && f.avx512dq && f.avx512bw && f.avx512vl && f.avx2 && f.fma)
+          return CpuIsa::AVX512;
+
+        if (f.avx2 && f.fma)
+          return CpuIsa::AVX2;
+
+        if (f.sse4_2)
+          return CpuIsa::SSE4;
+
+        return CpuIsa::Generic;
+      }
+
+      CpuIsa select_isa()
+      {
+        CpuIsa isa = best_isa(cpu_features());
+        const char *env = std::getenv("TF_CPU_ISA");
+
+        if (!env || isa == CpuIsa::NEON)
+          return isa;
+
+        CpuIsa requested = isa;
+        if (std::strcmp(env, "generic") == 0)
+          requested = CpuIsa::Generic;
+        else if (std::strcmp(env, "sse4") == 0)
+          requested = CpuIsa::SSE4;
+        else if (std::strcmp(env, "avx2") == 0)
+          requested = CpuIsa::AVX2;
+        else if (std::strcmp(env, "avx512") == 0)
+          requested = CpuIsa::AVX512;
+
+        // The override may only lower the ISA
+        return static_cast<int>(requested) < static_cast<int>(isa) ? requested : isa;
+      }
+    } // namespace
+
+    const CpuFeatures &cpu_features()
+    {
+      static const CpuFeatures features = detect();
+      return features;
+    }
+
+    CpuIsa cpu_isa()
+    {
+      static const CpuIsa isa = select_isa();
+      return isa;
+    }
+
+    const char *isa_name(CpuIsa isa)
+    {
+      switch (isa)
+      {
+      case CpuIsa::SSE4:
+        return "sse4";
+      case CpuIsa::AVX2:
+        return "avx2";
+      case CpuIsa::AVX512:
+        return "avx512";
+      case CpuIsa::NEON:
+        return "neon";
+      case CpuIsa::Generic:
+      default:
+        return "generic";
+      }
+    }
+  } // namespace core
+} // namespace tf
@@ -0,0 +1,650 @@
+#include <tf/core/device.hpp>
+#include <tf/core/config.hpp>
+
+#if defined(TF_CUDA_ENABLED)
+#include <cuda_runtime.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <string>
+
+namespace tf
+{
+  namespace core
+  {
+    namespace cuda
+    {
+      namespace
+      {
+        thread_local Stream *t_current = nullptr;
+
+#if defined(TF_CUDA_ENABLED)
+        /**
+         * @brief Block sizes are rounded up so that freed blocks fit later
+         * requests of slightly different sizes
+         */
+        constexpr size_t SMALL_BLOCK = 512;             ///< Rounding below LARGE_THRESHOLD
+        constexpr size_t LARGE_BLOCK = 2 * 1024 * 1024; ///< Rounding from LARGE_THRESHOLD
+        constexpr size_t LARGE_THRESHOLD = 1024 * 1024;
+
+        constexpr size_t STAGING_CHUNK = 4 * 1024 * 1024;
+        constexpr size_t MAX_STAGING_CHUNKS = 8; ///< Per device
+
+        size_t round_up(size_t value, size_t multiple)
+        {
+          return (value + multiple - 1) / multiple * multiple;
+        }
+
+        void check(cudaError_t status, const char *what)
+        {
+          if (status != cudaSuccess)
+            throw DeviceError(std::string(what) + ": " + cudaGetErrorString(status));
+        }
+
+        /**
+         * @class DeviceScope
+         * @brief Makes a device current for its lifetime
+         */
+        class DeviceScope
+        {
+        public:
+          explicit DeviceScope(int device)
+          {
+            check(cudaGetDevice(&m_previous), "cudaGetDevice");
+            if (m_previous != device)
+              check(cudaSetDevice(device), "cudaSetDevice");
+            m_device = device;
+          }
+
+          ~DeviceScope()
+          {
+            if (m_previous != m_device)
+              cudaSetDevice(m_previous);
+          }
+
+          DeviceScope(const DeviceScope &) = delete;
+          DeviceScope &operator=(const DeviceScope &) = delete;
+
+        private:
+          int m_previous = 0;
+          int m_device = 0;
+        };
+
+        cudaStream_t native(const Stream &stream)
+        {
+          return static_cast<cudaStream_t>(stream.handle());
+        }
+
+        /**
+         * @class StagingPool
+         * @brief Pinned host buffers for copies from and to pageable memory
+         *
+         * Each chunk carries an event recorded after the last transfer that
+         * used it; a chunk is handed out again once that event completed,
+         * so copies never wait for the whole stream.
+         */
+        class StagingPool
+        {
+        public:
+          struct Chunk
+          {
+            void *host = nullptr;
+            cudaEvent_t event = nullptr;
+            int device = 0;
+            bool busy = false;
+          };
+
+          static StagingPool &instance()
+          {
+            // Never destroyed: the CUDA runtime may already be shut down
+            // when static destructors run
+            static StagingPool *pool = new StagingPool();
+            return *pool;
+          }
+
+          Chunk &acquire(int device)
+          {
+            Chunk *chosen = nullptr;
+            {
+              std::unique_lock<std::mutex> lock(m_mutex);
+              for (;;)
+              {
+                // Prefer an idle chunk whose last transfer has finished,
+                // then a new one, then any idle chunk
+                size_t owned = 0;
+                bool ready = false;
+                chosen = nullptr;
+                for (Chunk &chunk : m_chunks)
+                {
+                  if (chunk.device != device)
+                    continue;
+                  ++owned;
+                  if (chunk.busy)
+                    continue;
+                  if (cudaEventQuery(chunk.event) == cudaSuccess)
+                  {
+                    chosen = &chunk;
+                    ready = true;
+                    break;
+                  }
+                  if (!chosen)
+                    chosen = &chunk;
+                }
+
+                if (!ready && owned < MAX_STAGING_CHUNKS)
+                {
+                  Chunk chunk;
+                  chunk.device = device;
+                  check(cudaHostAlloc(&chunk.host, STAGING_CHUNK, cudaHostAllocPortable), "cudaHostAlloc");
+                  check(cudaEventCreateWithFlags(&chunk.event, cudaEventDisableTiming), "cudaEventCreate");
+                  m_chunks.push_back(chunk);
+                  chosen = &m_chunks.back();
+                }
+
+                if (chosen)
+                  break;
+                m_released.wait(lock);
+              }
+              chosen->busy = true;
+            }
+
+            check(cudaEventSynchronize(chosen->event), "cudaEventSynchronize");
+            return *chosen;
+          }
+
+          void release(Chunk &chunk)
+          {
+            {
+              std::lock_guard<std::mutex> lock(m_mutex);
+              chunk.busy = false;
+            }
+            m_released.notify_one();
+          }
+
+        private:
+          StagingPool() = default;
+
+          std::mutex m_mutex;
+          std::condition_variable m_released;
+          std::deque<Chunk> m_chunks; ///< Stable addresses while growing
+        };
+
+        bool is_pinned(const void *ptr)
+        {
+          cudaPointerAttributes attributes;
+          if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess)
+          {
+            cudaGetLastError(); // Unregistered host memory on older runtimes
+            return false;
+          }
+          return attributes.type == cudaMemoryTypeHost;
+        }
+#else
+        [[noreturn]] void unavailable()
+        {
+          throw DeviceError("CUDA support is not built in (configure with TF_USE_CUDA=ON)");
+        }
+#endif
+      } // namespace
+
+#if defined(TF_CUDA_ENABLED)
+      bool available()
+      {
+        return device_count() > 0;
+      }
+
+      int device_count()
+      {
+        int count = 0;
+        if (cudaGetDeviceCount(&count) != cudaSuccess)
+        {
+          cudaGetLastError();
+          return 0;
+        }
+        return count;
+      }
+
+      int current_device()
+      {
+        int device = 0;
+        check(cudaGetDevice(&device), "cudaGetDevice");
+        return device;
+      }
+
+      void set_device(int device)
+      {
+        TF_CHECK(device >= 0 && device < device_count(), DeviceError,
+                 "CUDA device " + std::to_string(device) + " does not exist");
+        check(cudaSetDevice(device), "cudaSetDevice");
+      }
+
+      void synchronize()
+      {
+        check(cudaDeviceSynchronize(), "cudaDeviceSynchronize");
+      }
+
+      bool is_device_pointer(const void *ptr)
+      {
+        if (!ptr)
+          return false;
+
+        cudaPointerAttributes attributes;
+        if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess)
+        {
+          cudaGetLastError();
+          return false;
+        }
+        return attributes.type == cudaMemoryTypeDevice || attributes.type == cudaMemoryTypeManaged;
+      }
+
+      // Stream
+      Stream::Stream() : m_device(current_device()), m_owned(true)
+      {
+        cudaStream_t stream = nullptr;
+        check(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking), "cudaStreamCreate");
+        m_handle = stream;
+      }
+
+      Stream::Stream(PerThread) : m_handle(cudaStreamPerThread), m_owned(false) {}
+
+      Stream::~Stream()
+      {
+        // Errors are ignored: the runtime may be shutting down
+        if (m_handle)
+          cudaStreamSynchronize(static_cast<cudaStream_t>(m_handle));
+        if (m_owned && m_handle)
+          cudaStreamDestroy(static_cast<cudaStream_t>(m_handle));
+      }
+
+      int Stream::device() const
+      {
+        if (m_owned)
+          return m_device;
+
+        int device = 0;
+        if (cudaGetDevice(&device) != cudaSuccess)
+          cudaGetLastError();
+        return device;
+      }
+
+      void Stream::synchronize() const
+      {
+        check(cudaStreamSynchronize(native(*this)), "cudaStreamSynchronize");
+      }
+
+      bool Stream::query() const
+      {
+        const cudaError_t status = cudaStreamQuery(native(*this));
+        if (status == cudaErrorNotReady)
+          return false;
+        check(status, "cudaStreamQuery");
+        return true;
+      }
+#else
+      bool available()
+      {
+        return false;
+      }
+
+      int device_count()
+      {
+        return 0;
+      }
+
+      int current_device()
+      {
+        unavailable();
+      }
+
+      void set_device(int)
+      {
+        unavailable();
+      }
+
+      void synchronize()
+      {
+        unavailable();
+      }
+
+      bool is_device_pointer(const void *)
+      {
+        return false;
+      }
+
+      // Stream
+      Stream::Stream()
+      {
+        unavailable();
+      }
+
+      Stream::Stream(PerThread) {}
+
+      Stream::~Stream() = default;
+
+      int Stream::device() const
+      {
+        return m_device;
+      }
+
+      void Stream::synchronize() const
+      {
+        unavailable();
+      }
+
+      bool Stream::query() const
+      {
+        unavailable();
+      }
+#endif
+
+      Stream::Stream(Stream &&other) noexcept
+          : m_handle(other.m_handle), m_device(other.m_device), m_owned(other.m_owned)
+      {
+        other.m_handle = nullptr;
+        other.m_owned = false;
+      }
+
+      Stream &Stream::operator=(Stream &&other) noexcept
+      {
+        if (this != &other)
+        {
+          Stream discarded(std::move(*this));
+          m_handle = other.m_handle;
+          m_device = other.m_device;
+          m_owned = other.m_owned;
+          other.m_handle = nullptr;
+          other.m_owned = false;
+        }
+        return *this;
+      }
+
+      Stream &Stream::current()
+      {
+        if (t_current)
+          return *t_current;
+
+        thread_local Stream per_thread{PerThread{}};
+        return per_thread;
+      }
+
+      // StreamGuard
+      StreamGuard::StreamGuard(Stream &stream) : m_previous(t_current)
+      {
+        t_current = &stream;
+      }
+
+      StreamGuard::~StreamGuard()
+      {
+        t_current = m_previous;
+      }
+
+      // DeviceAllocator
+      DeviceAllocator &DeviceAllocator::instance()
+      {
+        // Never destroyed: the CUDA runtime may already be shut down when
+        // static destructors run
+        static DeviceAllocator *allocator = new DeviceAllocator();
+        return *allocator;
+      }
+
+#if defined(TF_CUDA_ENABLED)
+      void *DeviceAllocator::allocate(size_t bytes, const Stream &stream)
+      {
+        if (bytes == 0)
+          return nullptr;
+
+        const size_t size = bytes < LARGE_THRESHOLD ? round_up(bytes, SMALL_BLOCK)
+                                                    : round_up(bytes, LARGE_BLOCK);
+        const int device = stream.device();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_reserved.size() <= static_cast<size_t>(device))
+        {
+          m_reserved.resize(static_cast<size_t>(device) + 1, 0);
+          m_in_use.resize(static_cast<size_t>(device) + 1, 0);
+        }
+
+        // Best fit among the stream's own free blocks, at most twice the
+        // size so that small requests do not pin large blocks
+        Block block;
+        for (auto it = m_cached.lower_bound(size); it != m_cached.end() && it->first <= 2 * size; ++it)
+        {
+          if (it->second.device == device && it->second.stream == stream.order_key())
+          {
+            block = it->second;
+            m_cached.erase(it);
+            break;
+          }
+        }
+
+        if (!block.ptr)
+        {
+          DeviceScope scope(device);
+          size_t free_bytes = 0;
+          size_t total_bytes = 0;
+          check(cudaMemGetInfo(&free_bytes, &total_bytes), "cudaMemGetInfo");
+          const size_t limit = static_cast<size_t>(static_cast<double>(total_bytes) *
+                                                   config().memory_fraction());
+
+          if (m_reserved[device] + size > limit)
+            release_cache(device);
+          TF_CHECK(m_reserved[device] + size <= limit, MemoryError,
+                   "Allocating " + std::to_string(size) + " bytes on CUDA device " + std::to_string(device) +
+                       " exceeds the memory fraction (" + std::to_string(m_reserved[device]) + " of " +
+                       std::to_string(limit) + " bytes reserved)");
+
+          void *ptr = nullptr;
+          if (cudaMalloc(&ptr, size) != cudaSuccess)
+          {
+            cudaGetLastError();
+            release_cache(device);
+            TF_CHECK(cudaMalloc(&ptr, size) == cudaSuccess, MemoryError,
+                     "Out of memory on CUDA device " + std::to_string(device) + " allocating " +
+                         std::to_string(size) + " bytes");
+          }
+
+          block.ptr = ptr;
+          block.size = size;
+          block.device = device;
+          block.stream = stream.order_key();
+          m_reserved[device] += size;
+        }
+
+        m_in_use[device] += block.size;
+        m_allocated.emplace(block.ptr, block);
+        m_live.fetch_add(1, std::memory_order_relaxed);
+        return block.ptr;
+      }
+
+      void DeviceAllocator::release_cache(int device)
+      {
+        for (auto it = m_cached.begin(); it != m_cached.end();)
+        {
+          if (device >= 0 && it->second.device != device)
+          {
+            ++it;
+            continue;
+          }
+
+          // cudaFree waits for the device, so queued work using the block
+          // has finished
+          DeviceScope scope(it->second.device);
+          cudaFree(it->second.ptr);
+          m_reserved[it->second.device] -= it->second.size;
+          it = m_cached.erase(it);
+        }
+      }
+
+      size_t DeviceAllocator::limit() const
+      {
+        size_t free_bytes = 0;
+        size_t total_bytes = 0;
+        check(cudaMemGetInfo(&free_bytes, &total_bytes), "cudaMemGetInfo");
+        return static_cast<size_t>(static_cast<double>(total_bytes) * config().memory_fraction());
+      }
+#else
+      void *DeviceAllocator::allocate(size_t bytes, const Stream &)
+      {
+        if (bytes == 0)
+          return nullptr;
+        unavailable();
+      }
+
+      void DeviceAllocator::release_cache(int) {}
+
+      size_t DeviceAllocator::limit() const
+      {
+        unavailable();
+      }
+#endif
+
+      void DeviceAllocator::deallocate(void *ptr)
+      {
+        if (!ptr)
+          return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_allocated.find(ptr);
+        TF_CHECK(it != m_allocated.end(), ValueError, "Pointer was not allocated by the device allocator");
+
+        const Block block = it->second;
+        m_allocated.erase(it);
+        m_in_use[block.device] -= block.size;
+        m_cached.emplace(block.size, block);
+        m_live.fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      void DeviceAllocator::empty_cache()
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        release_cache(-1);
+      }
+
+      size_t DeviceAllocator::allocated_bytes() const
+      {
+        if (!available())
+          return 0;
+
+        const size_t device = static_cast<size_t>(current_device());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return device < m_in_use.size() ? m_in_use[device] : 0;
+      }
+
+      size_t DeviceAllocator::reserved_bytes() const
+      {
+        if (!available())
+          return 0;
+
+        const size_t device = static_cast<size_t>(current_device());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return device < m_reserved.size() ? m_reserved[device] : 0;
+      }
+
+      // Copies
+#if defined(TF_CUDA_ENABLED)
+      void copy_to_device(void *dst, const void *src, size_t bytes, const Stream &stream)
+      {
+        if (bytes == 0)
+          return;
+
+        if (is_pinned(src))
+        {
+          check(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyHostToDevice, native(stream)), "cudaMemcpyAsync");
+          return;
+        }
+
+        StagingPool &pool = StagingPool::instance();
+        auto *out = static_cast<unsigned char *>(dst);
+        const auto *in = static_cast<const unsigned char *>(src);
+
+        for (size_t offset = 0; offset < bytes; offset += STAGING_CHUNK)
+        {
+          const size_t length = std::min(STAGING_CHUNK, bytes - offset);
+          StagingPool::Chunk &chunk = pool.acquire(stream.device());
+
+          std::memcpy(chunk.host, in + offset, length);
+          const cudaError_t status = cudaMemcpyAsync(out + offset, chunk.host, length,
+                                                     cudaMemcpyHostToDevice, native(stream));
+          if (status == cudaSuccess)
+            cudaEventRecord(chunk.event, native(stream));
+          pool.release(chunk);
+          check(status, "cudaMemcpyAsync");
+        }
+      }
+
+      void copy_to_host(void *dst, const void *src, size_t bytes, const Stream &stream)
+      {
+        if (bytes == 0)
+          return;
+
+        if (is_pinned(dst))
+        {
+          check(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDeviceToHost, native(stream)), "cudaMemcpyAsync");
+          stream.synchronize();
+          return;
+        }
+
+        StagingPool &pool = StagingPool::instance();
+        auto *out = static_cast<unsigned char *>(dst);
+        const auto *in = static_cast<const unsigned char *>(src);
+
+        // Double buffered: chunk i + 1 is transferred while chunk i is
+        // copied out of its pinned buffer
+        StagingPool::Chunk *pending = nullptr;
+        size_t pending_offset = 0;
+        auto drain = [&]()
+        {
+          const cudaError_t status = cudaEventSynchronize(pending->event);
+          if (status == cudaSuccess)
+            std::memcpy(out + pending_offset, pending->host, std::min(STAGING_CHUNK, bytes - pending_offset));
+          pool.release(*pending);
+          pending = nullptr;
+          check(status, "cudaEventSynchronize");
+        };
+
+        for (size_t offset = 0; offset < bytes; offset += STAGING_CHUNK)
+        {
+          const size_t length = std::min(STAGING_CHUNK, bytes - offset);
+          StagingPool::Chunk &chunk = pool.acquire(stream.device());
+
+          cudaError_t status = cudaMemcpyAsync(chunk.host, in + offset, length,
+                                               cudaMemcpyDeviceToHost, native(stream));
+          if (status == cudaSuccess)
+            status = cudaEventRecord(chunk.event, native(stream));
+          if (status != cudaSuccess)
+          {
+            pool.release(chunk);
+            if (pending)
+              drain();
+            check(status, "cudaMemcpyAsync");
+          }
+
+          if (pending)
+            drain();
+          pending = &chunk;
+          pending_offset = offset;
+        }
+
+        drain();
+      }
+#else
+      void copy_to_device(void *, const void *, size_t bytes, const Stream &)
+      {
+        if (bytes == 0)
+          return;
+        unavailable();
+      }
+
+      void copy_to_host(void *, const void *, size_t bytes, const Stream &)
+      {
+        if (bytes == 0)
+          return;
+        unavailable();
+      }
+#endif
+    } // namespace cuda
+  } // namespace core
+} // namespace tf
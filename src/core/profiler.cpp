@@ -0,0 +1,315 @@
+#include <tf/core/profiler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <utility>
+
+namespace tf
+{
+  namespace core
+  {
+    namespace
+    {
+      /**
+       * @brief Writes a string as a JSON string literal
+       */
+      void write_json_string(std::ostream &out, const char *text)
+      {
+        out << '"';
+        for (const char *c = text ? text : ""; *c; ++c)
+        {
+          switch (*c)
+          {
+          case '"':
+            out << "\\\"";
+            break;
+          case '\\':
+            out << "\\\\";
+            break;
+          case '\n':
+            out << "\\n";
+            break;
+          default:
+            if (static_cast<unsigned char>(*c) < 0x20)
+            {
+              char escaped[8];
+              std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(*c));
+              out << escaped;
+            }
+            else
+              out << *c;
+          }
+        }
+        out << '"';
+      }
+
+      /**
+       * @brief Writes nanoseconds as the microseconds of the trace format
+       */
+      void write_microseconds(std::ostream &out, uint64_t ns)
+      {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                      static_cast<unsigned long long>(ns % 1000));
+        out << text;
+      }
+
+      /**
+       * @brief Gets the start of the profiler's clock, the first call
+       */
+      std::chrono::steady_clock::time_point epoch()
+      {
+        static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+      }
+    } // namespace
+
+    namespace detail
+    {
+      ProfileRing::ProfileRing(size_t capacity, uint32_t thread)
+          : m_slots(new Slot[capacity]), m_capacity(capacity), m_thread(thread)
+      {
+      }
+
+      void ProfileRing::push(const ProfileEvent &event)
+      {
+        const uint64_t index = m_head.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[index % m_capacity];
+
+        // Odd while writing: readers that see it, or see it change, skip the slot
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.category.store(event.category, std::memory_order_relaxed);
+        slot.start_ns.store(event.start_ns, std::memory_order_relaxed);
+        slot.duration_ns.store(event.duration_ns, std::memory_order_relaxed);
+        slot.flops.store(event.flops, std::memory_order_relaxed);
+        slot.bytes.store(event.bytes, std::memory_order_relaxed);
+        slot.allocations.store(event.allocations, std::memory_order_relaxed);
+        slot.allocated_bytes.store(event.allocated_bytes, std::memory_order_relaxed);
+        slot.depth.store(event.depth, std::memory_order_relaxed);
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        m_head.store(index + 1, std::memory_order_release);
+      }
+
+      void ProfileRing::snapshot(std::vector<ProfileEvent> &out) const
+      {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const uint64_t floor = m_floor.load(std::memory_order_acquire);
+        const uint64_t first = std::max(floor, head > m_capacity ? head - m_capacity : 0);
+
+        for (uint64_t index = first; index < head; ++index)
+        {
+          const Slot &slot = m_slots[index % m_capacity];
+          const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+          if (sequence != 2 * index + 2)
+            continue;
+
+          ProfileEvent event;
+          event.name = slot.name.load(std::memory_order_relaxed);
+          event.category = slot.category.load(std::memory_order_relaxed);
+          event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+          event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+          event.flops = slot.flops.load(std::memory_order_relaxed);
+          event.bytes = slot.bytes.load(std::memory_order_relaxed);
+          event.allocations = slot.allocations.load(std::memory_order_relaxed);
+          event.allocated_bytes = slot.allocated_bytes.load(std::memory_order_relaxed);
+          event.depth = slot.depth.load(std::memory_order_relaxed);
+          event.thread = m_thread;
+
+          // Overwritten while reading
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+          out.push_back(event);
+        }
+      }
+
+      namespace
+      {
+        /**
+         * @brief Owns the thread's ring and releases it when the thread exits
+         */
+        struct ProfileRingSlot
+        {
+          std::shared_ptr<ProfileRing> ring;
+
+          ~ProfileRingSlot() { ring->in_use.store(false, std::memory_order_release); }
+        };
+      } // namespace
+
+      ProfileRing &profile_ring()
+      {
+        thread_local ProfileRingSlot slot{Profiler::instance().register_thread()};
+        return *slot.ring;
+      }
+    } // namespace detail
+
+    Profiler &Profiler::instance()
+    {
+      // Leaked: threads may record while static destructors run
+      static Profiler *profiler = new Profiler();
+      return *profiler;
+    }
+
+    std::shared_ptr<detail::ProfileRing> Profiler::register_thread()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      // Reuse the ring of an exited thread once nothing in it is visible,
+      // so memory follows the threads alive at once
+      for (const auto &ring : m_rings)
+        if (!ring->in_use.load(std::memory_order_acquire) && ring->empty() &&
+            ring->capacity() == m_capacity)
+        {
+          ring->in_use.store(true, std::memory_order_relaxed);
+          return ring;
+        }
+
+      auto ring = std::make_shared<detail::ProfileRing>(m_capacity, m_next_thread++);
+      m_rings.push_back(ring);
+      return ring;
+    }
+
+    void Profiler::set_capacity(size_t events)
+    {
+      TF_CHECK(events > 0, ValueError, "Profiler capacity must be positive");
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_capacity = events;
+    }
+
+    size_t Profiler::capacity() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_capacity;
+    }
+
+    size_t Profiler::ring_count() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_rings.size();
+    }
+
+    void Profiler::clear()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      // Exited threads record nothing more, so their rings can go; a
+      // snapshot in progress keeps its own reference
+      std::erase_if(m_rings, [](const std::shared_ptr<detail::ProfileRing> &ring)
+                    { return !ring->in_use.load(std::memory_order_acquire); });
+      for (const auto &ring : m_rings)
+        ring->clear();
+    }
+
+    std::vector<ProfileEvent> Profiler::events() const
+    {
+      std::vector<std::shared_ptr<detail::ProfileRing>> rings;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        rings = m_rings;
+      }
+
+      std::vector<ProfileEvent> events;
+      for (const auto &ring : rings)
+        ring->snapshot(events);
+
+      std::stable_sort(events.begin(), events.end(),
+                       [](const ProfileEvent &a, const ProfileEvent &b)
+                       { return a.start_ns < b.start_ns; });
+      return events;
+    }
+
+    std::vector<ProfileSummary> Profiler::summary() const
+    {
+      // Names are literals, but equal literals may still differ in address
+      std::map<std::pair<std::string, std::string>, ProfileSummary> totals;
+      for (const ProfileEvent &event : events())
+      {
+        ProfileSummary &total = totals[{event.name ? event.name : "", event.category ? event.category : ""}];
+        total.name = event.name;
+        total.category = event.category;
+        ++total.count;
+        total.total_ns += event.duration_ns;
+        total.flops += event.flops;
+        total.bytes += event.bytes;
+        total.allocations += event.allocations;
+      }
+
+      std::vector<ProfileSummary> summary;
+      summary.reserve(totals.size());
+      for (const auto &[key, total] : totals)
+        summary.push_back(total);
+
+      std::stable_sort(summary.begin(), summary.end(),
+                       [](const ProfileSummary &a, const ProfileSummary &b)
+                       { return a.total_ns > b.total_ns; });
+      return summary;
+    }
+
+    void Profiler::write_chrome_trace(std::ostream &out) const
+    {
+      const std::vector<ProfileEvent> recorded = events();
+
+      std::vector<uint32_t> threads;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto &ring : m_rings)
+          threads.push_back(ring->thread());
+      }
+      std::sort(threads.begin(), threads.end());
+
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+      bool first = true;
+      for (uint32_t thread : threads)
+      {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+            << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+        first = false;
+      }
+
+      for (const ProfileEvent &event : recorded)
+      {
+        out << (first ? "" : ",") << "\n{\"name\":";
+        write_json_string(out, event.name);
+        out << ",\"cat\":";
+        write_json_string(out, event.category);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+        write_microseconds(out, event.start_ns);
+        out << ",\"dur\":";
+        write_microseconds(out, event.duration_ns);
+        out << ",\"args\":{\"flops\":" << event.flops << ",\"bytes\":" << event.bytes
+            << ",\"allocations\":" << event.allocations << ",\"allocated_bytes\":" << event.allocated_bytes;
+        if (event.flops > 0 && event.duration_ns > 0)
+          out << ",\"gflops\":" << static_cast<double>(event.flops) / static_cast<double>(event.duration_ns);
+        out << "}}";
+        first = false;
+      }
+      out << "\n]}\n";
+    }
+
+    void Profiler::write_chrome_trace(const std::string &path) const
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      TF_CHECK(out.is_open(), IOError, "Cannot open trace file: " + path);
+
+      write_chrome_trace(out);
+      out.flush();
+      TF_CHECK(out.good(), IOError, "Failed to write trace file: " + path);
+    }
+
+    uint64_t Profiler::now()
+    {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count());
+    }
+  } // namespace core
+} // namespace tf
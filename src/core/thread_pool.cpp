@@ -0,0 +1,373 @@
+#include <tf/core/thread_pool.hpp>
+#include <tf/core/config.hpp>
+#include <tf/utils/arena.hpp>
+
+#include <deque>
+#include <exception>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace tf
+{
+  namespace core
+  {
+    /**
+     * @brief State shared by the chunks of one parallel loop
+     *
+     * Lives on the stack of the thread that started the loop and is only
+     * touched by a chunk before it decrements remaining.
+     */
+    struct ThreadPool::Job
+    {
+      const RangeFunction *fn = nullptr;
+      std::atomic<size_t> remaining{0};
+      std::mutex error_mutex;
+      std::exception_ptr error;
+    };
+
+    struct ThreadPool::Task
+    {
+      Job *job = nullptr;
+      size_t begin = 0;
+      size_t end = 0;
+    };
+
+    struct ThreadPool::Worker
+    {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+      std::thread thread;
+    };
+
+    namespace
+    {
+      // Pool the current thread works for, and its deque index
+      thread_local const ThreadPool *t_pool = nullptr;
+      thread_local size_t t_index = 0;
+
+      // Number of loops the current thread has started and not finished
+      thread_local size_t t_depth = 0;
+
+      /**
+       * @brief Marks the calling thread as running a loop
+       */
+      class DepthGuard
+      {
+      public:
+        DepthGuard() { ++t_depth; }
+        ~DepthGuard() { --t_depth; }
+
+        DepthGuard(const DepthGuard &) = delete;
+        DepthGuard &operator=(const DepthGuard &) = delete;
+      };
+    } // namespace
+
+    ThreadPool::ThreadPool(size_t num_threads)
+    {
+      TF_CHECK(num_threads > 0, ValueError, "Number of threads must be positive");
+      start(num_threads - 1);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+      stop();
+    }
+
+    size_t ThreadPool::num_threads() const
+    {
+      return m_num_threads.load(std::memory_order_relaxed);
+    }
+
+    void ThreadPool::resize(size_t num_threads)
+    {
+      TF_CHECK(num_threads > 0, ValueError, "Number of threads must be positive");
+      TF_CHECK(!in_parallel_region(), Exception,
+               "Thread pool cannot be resized from inside a parallel loop");
+
+      std::unique_lock<std::shared_mutex> lock(m_resize_mutex);
+      if (m_workers.size() + 1 == num_threads)
+        return;
+
+      stop();
+      start(num_threads - 1);
+    }
+
+    bool ThreadPool::set_affinity(const std::vector<int> &cpus)
+    {
+      TF_CHECK(!in_parallel_region(), Exception,
+               "Thread pool affinity cannot be changed from inside a parallel loop");
+
+      std::unique_lock<std::shared_mutex> lock(m_resize_mutex);
+      m_affinity = cpus;
+      return apply_affinity();
+    }
+
+    std::vector<int> ThreadPool::affinity() const
+    {
+      std::shared_lock<std::shared_mutex> lock(m_resize_mutex);
+      return m_affinity;
+    }
+
+    bool ThreadPool::apply_affinity()
+    {
+#if defined(__linux__)
+      bool pinned = true;
+
+      for (size_t i = 0; i < m_workers.size(); ++i)
+      {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        if (m_affinity.empty())
+        {
+          // Unpin: inherit whatever the process is allowed to run on
+          if (sched_getaffinity(0, sizeof(set), &set) != 0)
+            continue;
+        }
+        else
+        {
+          int cpu = m_affinity[i % m_affinity.size()];
+          if (cpu < 0 || cpu >= CPU_SETSIZE)
+          {
+            pinned = false;
+            continue;
+          }
+          CPU_SET(cpu, &set);
+        }
+
+        if (pthread_setaffinity_np(m_workers[i]->thread.native_handle(), sizeof(set), &set) != 0)
+          pinned = false;
+      }
+
+      return pinned && !m_affinity.empty();
+#else
+      return false;
+#endif
+    }
+
+    size_t ThreadPool::chunk_size(size_t n, size_t grain) const
+    {
+      grain = std::max<size_t>(grain, 1);
+
+      // A stale count only changes how finely the range is split
+      const size_t threads = num_threads();
+      if (threads == 1)
+        return std::max(n, grain);
+
+      const size_t target = (n + threads * 4 - 1) / (threads * 4);
+      return std::max(grain, target);
+    }
+
+    void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain,
+                                  const RangeFunction &fn)
+    {
+      if (end <= begin)
+        return;
+
+      // Nested loops already run under the outermost loop's lock
+      std::shared_lock<std::shared_mutex> lock(m_resize_mutex, std::defer_lock);
+      if (!in_parallel_region())
+        lock.lock();
+
+      const size_t n = end - begin;
+      const size_t chunk = chunk_size(n, grain);
+      const size_t count = (n + chunk - 1) / chunk;
+
+      // Also covers the inline path: fn runs under the shared lock, so it
+      // must see itself inside a loop and never try to resize the pool
+      DepthGuard depth;
+
+      if (m_workers.empty() || count <= 1)
+      {
+        // A chunk may run on any thread, including one inside an unrelated
+        // ArenaScope, so it never allocates from that scope
+        utils::ArenaSuspension suspension;
+        fn(begin, end);
+        return;
+      }
+
+      Job job;
+      job.fn = &fn;
+      job.remaining.store(count, std::memory_order_relaxed);
+
+      // A worker keeps its inner chunks local so they stay cache-warm;
+      // any other thread deals them out round-robin.
+      const bool is_worker = t_pool == this;
+      for (size_t c = 1; c < count; ++c)
+      {
+        size_t b = begin + c * chunk;
+        Task task{&job, b, std::min(end, b + chunk)};
+        push(is_worker ? t_index : (c - 1) % m_workers.size(), task);
+      }
+
+      {
+        std::lock_guard<std::mutex> sleep_lock(m_sleep_mutex);
+      }
+      m_wakeup.notify_all();
+
+      run(Task{&job, begin, std::min(end, begin + chunk)});
+
+      // Help with whatever is queued (this loop's chunks, or nested ones)
+      // until every chunk of this loop has finished.
+      while (job.remaining.load(std::memory_order_acquire) > 0)
+      {
+        Task task;
+        if (try_take(task))
+          run(task);
+        else
+          std::this_thread::yield();
+      }
+
+      if (job.error)
+        std::rethrow_exception(job.error);
+    }
+
+    bool ThreadPool::in_parallel_region()
+    {
+      return t_pool != nullptr || t_depth > 0;
+    }
+
+    void ThreadPool::start(size_t num_workers)
+    {
+      m_stop = false;
+      m_workers.clear();
+
+      for (size_t i = 0; i < num_workers; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+
+      for (size_t i = 0; i < num_workers; ++i)
+        m_workers[i]->thread = std::thread([this, i]
+                                           { worker_loop(i); });
+
+      m_num_threads.store(num_workers + 1, std::memory_order_relaxed);
+
+      if (!m_affinity.empty())
+        apply_affinity();
+    }
+
+    void ThreadPool::stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stop = true;
+      }
+      m_wakeup.notify_all();
+
+      for (auto &worker : m_workers)
+        if (worker->thread.joinable())
+          worker->thread.join();
+
+      m_workers.clear();
+      m_num_threads.store(1, std::memory_order_relaxed);
+    }
+
+    void ThreadPool::worker_loop(size_t index)
+    {
+      t_pool = this;
+      t_index = index;
+
+      for (;;)
+      {
+        Task task;
+        if (try_take(task))
+        {
+          run(task);
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wakeup.wait(lock, [this]
+                      { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+
+        // Loops never outlive the pool, so nothing is queued at shutdown
+        if (m_stop)
+          return;
+      }
+    }
+
+    void ThreadPool::push(size_t worker, const Task &task)
+    {
+      Worker &w = *m_workers[worker];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.tasks.push_back(task);
+      m_queued.fetch_add(1, std::memory_order_release);
+    }
+
+    bool ThreadPool::try_take(Task &task)
+    {
+      if (m_queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+      if (t_pool == this)
+      {
+        Worker &own = *m_workers[t_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+          task = own.tasks.back();
+          own.tasks.pop_back();
+          m_queued.fetch_sub(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+
+      // Steal the oldest (usually largest remaining) work from a victim,
+      // starting at a rotating index so thieves spread out.
+      const size_t count = m_workers.size();
+      const size_t start = m_next_victim.fetch_add(1, std::memory_order_relaxed);
+      for (size_t i = 0; i < count; ++i)
+      {
+        Worker &victim = *m_workers[(start + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+          task = victim.tasks.front();
+          victim.tasks.pop_front();
+          m_queued.fetch_sub(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void ThreadPool::run(const Task &task)
+    {
+      Job &job = *task.job;
+
+      utils::ArenaSuspension suspension;
+
+      try
+      {
+        (*job.fn)(task.begin, task.end);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(job.error_mutex);
+        if (!job.error)
+          job.error = std::current_exception();
+      }
+
+      // Last access to the job: the owner may return as soon as it sees 0
+      job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    ThreadPool &thread_pool()
+    {
+      static ThreadPool pool(static_cast<size_t>(config().num_threads()));
+
+      if (!ThreadPool::in_parallel_region())
+      {
+        const size_t wanted = static_cast<size_t>(config().num_threads());
+        if (wanted != pool.num_threads())
+          pool.resize(wanted);
+      }
+
+      return pool;
+    }
+  } // namespace core
+} // namespace tf
@@ -0,0 +1,171 @@
+#include <tf/math/utils.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/macros.hpp>
+#include <tf/core/thread_pool.hpp>
+#include "math/kernels/kernels.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace
+    {
+      /**
+       * @brief Elements per parallel chunk
+       */
+      constexpr size_t ACTIVATION_GRAIN = 1 << 14;
+
+      template <typename T, typename Kernel, typename... Args>
+      void activate(Kernel kernel, const T *in, T *out, std::type_identity_t<T> *derivative,
+                    size_t size, Args... args)
+      {
+        TF_CHECK(size == 0 || (in != nullptr && out != nullptr), core::ValueError,
+                 "Activation array is null");
+        TF_PROFILE_KERNEL("activation", size, (derivative ? 3 : 2) * size * sizeof(T));
+
+        core::parallel_for(0, size, ACTIVATION_GRAIN, [&](size_t begin, size_t end)
+                           { kernel(end - begin, in + begin, out + begin,
+                                    derivative ? derivative + begin : nullptr, args...); });
+      }
+
+      template <typename T>
+      T *checked(T *derivative, size_t size)
+      {
+        TF_CHECK(size == 0 || derivative != nullptr, core::ValueError,
+                 "Derivative array is null");
+        return derivative;
+      }
+
+      template <typename T, typename Kernel>
+      void row_wise(Kernel kernel, size_t rows, size_t cols, const T *in, size_t ld_in,
+                    T *out, size_t ld_out)
+      {
+        TF_CHECK(ld_in >= cols && ld_out >= cols, core::ShapeError,
+                 "Leading dimension is smaller than the number of columns");
+        TF_CHECK(rows == 0 || cols == 0 || (in != nullptr && out != nullptr), core::ValueError,
+                 "Softmax matrix is null");
+
+        if (cols == 0)
+          return;
+        TF_PROFILE_KERNEL("softmax", 4 * rows * cols, 2 * rows * cols * sizeof(T));
+
+        const size_t grain = std::max<size_t>(1, ACTIVATION_GRAIN / cols);
+        core::parallel_for(0, rows, grain, [&](size_t begin, size_t end)
+                           {
+                             for (size_t r = begin; r < end; ++r)
+                               kernel(cols, in + r * ld_in, out + r * ld_out); });
+      }
+    } // namespace
+
+    void sigmoid(const float *in, float *out, size_t size)
+    {
+      activate(kernels::kernel_table<float>().sigmoid, in, out, nullptr, size);
+    }
+
+    void sigmoid(const double *in, double *out, size_t size)
+    {
+      activate(kernels::kernel_table<double>().sigmoid, in, out, nullptr, size);
+    }
+
+    void sigmoid_and_derivative(const float *in, float *out, float *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<float>().sigmoid, in, out, checked(derivative, size), size);
+    }
+
+    void sigmoid_and_derivative(const double *in, double *out, double *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<double>().sigmoid, in, out, checked(derivative, size), size);
+    }
+
+    void tanh(const float *in, float *out, size_t size)
+    {
+      activate(kernels::kernel_table<float>().tanh, in, out, nullptr, size);
+    }
+
+    void tanh(const double *in, double *out, size_t size)
+    {
+      activate(kernels::kernel_table<double>().tanh, in, out, nullptr, size);
+    }
+
+    void tanh_and_derivative(const float *in, float *out, float *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<float>().tanh, in, out, checked(derivative, size), size);
+    }
+
+    void tanh_and_derivative(const double *in, double *out, double *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<double>().tanh, in, out, checked(derivative, size), size);
+    }
+
+    void relu(const float *in, float *out, size_t size)
+    {
+      activate(kernels::kernel_table<float>().relu, in, out, nullptr, size);
+    }
+
+    void relu(const double *in, double *out, size_t size)
+    {
+      activate(kernels::kernel_table<double>().relu, in, out, nullptr, size);
+    }
+
+    void relu_and_derivative(const float *in, float *out, float *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<float>().relu, in, out, checked(derivative, size), size);
+    }
+
+    void relu_and_derivative(const double *in, double *out, double *derivative, size_t size)
+    {
+      activate(kernels::kernel_table<double>().relu, in, out, checked(derivative, size), size);
+    }
+
+    void leaky_relu(const float *in, float *out, size_t size, float alpha)
+    {
+      activate(kernels::kernel_table<float>().leaky_relu, in, out, nullptr, size, alpha);
+    }
+
+    void leaky_relu(const double *in, double *out, size_t size, double alpha)
+    {
+      activate(kernels::kernel_table<double>().leaky_relu, in, out, nullptr, size, alpha);
+    }
+
+    void leaky_relu_and_derivative(const float *in, float *out, float *derivative,
+                                   size_t size, float alpha)
+    {
+      activate(kernels::kernel_table<float>().leaky_relu, in, out,
+               checked(derivative, size), size, alpha);
+    }
+
+    void leaky_relu_and_derivative(const double *in, double *out, double *derivative,
+                                   size_t size, double alpha)
+    {
+      activate(kernels::kernel_table<double>().leaky_relu, in, out,
+               checked(derivative, size), size, alpha);
+    }
+
+    void softmax(size_t rows, size_t cols, const float *in, size_t ld_in,
+                 float *out, size_t ld_out)
+    {
+      row_wise(kernels::kernel_table<float>().softmax, rows, cols, in, ld_in, out, ld_out);
+    }
+
+    void softmax(size_t rows, size_t cols, const double *in, size_t ld_in,
+                 double *out, size_t ld_out)
+    {
+      row_wise(kernels::kernel_table<double>().softmax, rows, cols, in, ld_in, out, ld_out);
+    }
+
+    void log_softmax(size_t rows, size_t cols, const float *in, size_t ld_in,
+                     float *out, size_t ld_out)
+    {
+      row_wise(kernels::kernel_table<float>().log_softmax, rows, cols, in, ld_in, out, ld_out);
+    }
+
+    void log_softmax(size_t rows, size_t cols, const double *in, size_t ld_in,
+                     double *out, size_t ld_out)
+    {
+      row_wise(kernels::kernel_table<double>().log_softmax, rows, cols, in, ld_in, out, ld_out);
+    }
+  } // namespace math
+} // namespace tf
@@ -1,125 +1,902 @@
 #include <tf/math/blas.hpp>
+#include <tf/core/thread_pool.hpp>
+#include <tf/utils/arena.hpp>
+#include "math/blas_backend.hpp"
+#include "math/gemm.hpp"
+#include "math/kernels/kernels.hpp"
+
 #include <cmath>
+#include <cstddef>
 #include <algorithm>
+#include <limits>
 
 namespace tf
 {
   namespace math
   {
-    // Vector dot product
-    template <>
-    float Blas::dot<float>(size_t n, const float *x, int incx,
-                           const float *y, int incy)
+    namespace
     {
-      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+      /**
+       * @brief Minimum number of elements a parallel chunk works on
+       *
+       * Smaller chunks cost more in scheduling than they gain from running
+       * on another core.
+       */
+      constexpr size_t PARALLEL_GRAIN = 1 << 15;
 
-      float result = 0.0f;
-      for (size_t i = 0; i < n; ++i)
-        result += x[i * incx] * y[i * incy];
+      /**
+       * @brief Gets the first element visited by a BLAS-style strided loop
+       *
+       * With a negative stride the vector is traversed from its last
+       * element, as in reference BLAS.
+       */
+      template <typename T>
+      T *strided_begin(T *x, size_t n, int inc)
+      {
+        return inc < 0 ? x + static_cast<std::ptrdiff_t>(n - 1) * -inc : x;
+      }
 
-      return result;
-    }
+      /**
+       * @brief Gets the raw bits of reduced-precision floats, as the
+       * kernels take them
+       */
+      template <typename T>
+      const std::uint16_t *raw_bits(const T *x)
+      {
+        static_assert(sizeof(T) == sizeof(std::uint16_t));
+        return reinterpret_cast<const std::uint16_t *>(x);
+      }
 
-    template <>
-    double Blas::dot<double>(size_t n, const double *x,
-                             int incx, const double *y, int incy)
-    {
-      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+      /**
+       * @brief Strided dot product accumulated in Acc (T itself, or a wider
+       * type for reduced-precision T)
+       */
+      template <typename T, typename Acc = T>
+      Acc strided_dot(size_t n, const T *x, int incx, const T *y, int incy)
+      {
+        x = strided_begin(x, n, incx);
+        y = strided_begin(y, n, incy);
 
-      double result = 0.0;
-      for (size_t i = 0; i < n; ++i)
-        result += x[i * incx] * y[i * incy];
+        Acc result = Acc{0};
+        for (size_t i = 0; i < n; ++i, x += incx, y += incy)
+          result += static_cast<Acc>(*x) * static_cast<Acc>(*y);
 
-      return result;
-    }
+        return result;
+      }
 
-    // Vector norm
-    template <>
-    float Blas::nrm2(size_t n, const float *x, int incx)
-    {
-      float scale = 0.0f;
-      float ssq = 1.0f;
+      /**
+       * @brief Overflow- and underflow-safe norm (scaled sum of squares)
+       */
+      template <typename T>
+      T scaled_nrm2(size_t n, const T *x, int incx)
+      {
+        x = strided_begin(x, n, incx);
+
+        T scale = T{0};
+        T ssq = T{1};
+
+        for (size_t i = 0; i < n; ++i, x += incx)
+        {
+          if (*x != T{0})
+          {
+            T absxi = std::abs(*x);
 
-      for (size_t i = 0; i < n; ++i)
+            if (scale < absxi)
+            {
+              T temp = scale / absxi;
+              ssq = T{1} + ssq * (temp * temp);
+              scale = absxi;
+            }
+            else
+            {
+              T temp = absxi / scale;
+              ssq += temp * temp;
+            }
+          }
+        }
+
+        return scale * std::sqrt(ssq);
+      }
+
+      template <typename T>
+      T nrm2_impl(size_t n, const T *x, int incx)
       {
-        if (x[i * incx] != 0.0f)
+        if (n == 0)
+          return T{0};
+
+        if (incx == 1)
         {
-          float absxi = std::abs(x[i * incx]);
-          if (scale < absxi)
+          // Unscaled sum of squares is exact enough unless it overflowed or
+          // lost precision to underflow; only then pay for the scaled loop.
+          T ssq = kernels::kernel_table<T>().sumsq(n, x);
+          constexpr T tiny = std::numeric_limits<T>::min() /
+                             std::numeric_limits<T>::epsilon();
+
+          if (std::isfinite(ssq) && ssq >= tiny)
+            return std::sqrt(ssq);
+        }
+
+        return scaled_nrm2(n, x, incx);
+      }
+
+      template <typename T>
+      void scal_impl(size_t n, T alpha, T *x, int incx)
+      {
+        if (incx == 1)
+        {
+          kernels::kernel_table<T>().scal(n, alpha, x);
+          return;
+        }
+
+        x = strided_begin(x, n, incx);
+        for (size_t i = 0; i < n; ++i, x += incx)
+          *x *= alpha;
+      }
+
+      template <typename T>
+      void axpy_impl(size_t n, T alpha, const T *x, int incx, T *y, int incy)
+      {
+        if (incx == 1 && incy == 1)
+        {
+          const auto axpy = kernels::kernel_table<T>().axpy;
+          core::parallel_for(0, n, PARALLEL_GRAIN, [&](size_t begin, size_t end)
+                             { axpy(end - begin, alpha, x + begin, y + begin); });
+          return;
+        }
+
+        x = strided_begin(x, n, incx);
+        y = strided_begin(y, n, incy);
+        for (size_t i = 0; i < n; ++i, x += incx, y += incy)
+          *y += alpha * *x;
+      }
+
+      bool is_upper(char uplo)
+      {
+        return uplo == 'U' || uplo == 'u';
+      }
+
+      void check_uplo(char uplo)
+      {
+        TF_CHECK(uplo == 'U' || uplo == 'u' || uplo == 'L' || uplo == 'l',
+                 core::ValueError, "Invalid uplo, expected 'U' or 'L'");
+      }
+
+      /**
+       * @brief Writes y = alpha * t + beta * y where t is contiguous
+       *
+       * When beta is zero, y is not read.
+       */
+      template <typename T>
+      void update_vector(size_t n, T alpha, const T *t, T beta, T *y, int incy)
+      {
+        y = strided_begin(y, n, incy);
+        for (size_t i = 0; i < n; ++i, y += incy)
+          *y = beta == T{0} ? alpha * t[i] : alpha * t[i] + beta * *y;
+      }
+
+      /**
+       * @brief Gets a unit-stride view of x, copying into the arena if needed
+       */
+      template <typename T>
+      const T *unit_stride(size_t n, const T *x, int incx, utils::Arena &arena)
+      {
+        if (incx == 1)
+          return x;
+
+        T *copy = arena.allocate_array<T>(n);
+        x = strided_begin(x, n, incx);
+        for (size_t i = 0; i < n; ++i, x += incx)
+          copy[i] = *x;
+
+        return copy;
+      }
+
+      template <typename T>
+      void gemv_impl(size_t m, size_t n, T alpha, const T *A, size_t lda,
+                     const T *x, int incx, T beta, T *y, int incy)
+      {
+        TF_CHECK(lda >= std::max<size_t>(n, 1), core::ShapeError, "Invalid lda");
+
+        if (m == 0)
+          return;
+
+        if (backend::gemv(m, n, alpha, A, lda, x, incx, beta, y, incy))
+          return;
+
+        // Temporaries come from the thread's scratch arena, like the GEMM
+        // panels, so the call does not touch the heap
+        utils::Arena &arena = utils::scratch_arena();
+        utils::ArenaCheckpoint checkpoint(arena);
+        T *t = arena.allocate_array<T>(m);
+
+        if (alpha == T{0} || n == 0)
+          std::fill_n(t, m, T{0});
+        else
+        {
+          const T *xu = unit_stride(n, x, incx, arena);
+          const auto dot = kernels::kernel_table<T>().dot;
+
+          core::parallel_for(0, m, std::max<size_t>(1, PARALLEL_GRAIN / n),
+                             [&](size_t begin, size_t end)
+                             {
+                               for (size_t i = begin; i < end; ++i)
+                                 t[i] = dot(n, A + i * lda, xu);
+                             });
+        }
+
+        update_vector(m, alpha, t, beta, y, incy);
+      }
+
+      template <typename T>
+      void symv_impl(char uplo, size_t n, T alpha, const T *A, size_t lda,
+                     const T *x, int incx, T beta, T *y, int incy)
+      {
+        check_uplo(uplo);
+        TF_CHECK(lda >= std::max<size_t>(n, 1), core::ShapeError, "Invalid lda");
+
+        if (n == 0)
+          return;
+
+        if (backend::symv(uplo, n, alpha, A, lda, x, incx, beta, y, incy))
+          return;
+
+        utils::Arena &arena = utils::scratch_arena();
+        utils::ArenaCheckpoint checkpoint(arena);
+        T *t = arena.allocate_array<T>(n);
+        std::fill_n(t, n, T{0});
+
+        if (alpha != T{0})
+        {
+          const T *xu = unit_stride(n, x, incx, arena);
+          const auto &table = kernels::kernel_table<T>();
+
+          // Each stored row segment of the triangle contributes to t[i]
+          // through a dot product and, mirrored, to the other entries
+          // through an axpy; both run on contiguous memory.
+          for (size_t i = 0; i < n; ++i)
           {
-            float temp = scale / absxi;
+            const T *row = A + i * lda;
+            size_t begin = is_upper(uplo) ? i + 1 : 0;
+            size_t count = is_upper(uplo) ? n - i - 1 : i;
 
-            ssq = 1.0f + ssq * (temp * temp);
-            scale = absxi;
+            t[i] += row[i] * xu[i];
+            if (count > 0)
+            {
+              t[i] += table.dot(count, row + begin, xu + begin);
+              table.axpy(count, xu[i], row + begin, t + begin);
+            }
           }
-          else
+        }
+
+        update_vector(n, alpha, t, beta, y, incy);
+      }
+
+      template <typename T>
+      void symm_impl(char side, char uplo, size_t m, size_t n, T alpha,
+                     const T *A, size_t lda, const T *B, size_t ldb,
+                     T beta, T *C, size_t ldc)
+      {
+        TF_CHECK(side == 'L' || side == 'l' || side == 'R' || side == 'r',
+                 core::ValueError, "Invalid side, expected 'L' or 'R'");
+        check_uplo(uplo);
+
+        bool left = side == 'L' || side == 'l';
+        size_t ka = left ? m : n;
+
+        TF_CHECK(lda >= std::max<size_t>(ka, 1), core::ShapeError, "Invalid lda");
+        TF_CHECK(ldb >= std::max<size_t>(n, 1), core::ShapeError, "Invalid ldb");
+        TF_CHECK(ldc >= std::max<size_t>(n, 1), core::ShapeError, "Invalid ldc");
+
+        if (m == 0 || n == 0)
+          return;
+
+        if (backend::symm(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc))
+          return;
+
+        // Mirror the referenced triangle into a dense matrix so the product
+        // runs on the packed GEMM kernel.
+        utils::Arena &arena = utils::scratch_arena();
+        utils::ArenaCheckpoint checkpoint(arena);
+        T *full = arena.allocate_array<T>(ka * ka);
+        for (size_t i = 0; i < ka; ++i)
+        {
+          for (size_t j = 0; j < ka; ++j)
           {
-            float temp = absxi / scale;
-            ssq += temp * temp;
+            bool stored = is_upper(uplo) ? j >= i : j <= i;
+            full[i * ka + j] = stored ? A[i * lda + j] : A[j * lda + i];
           }
         }
+
+        if (left)
+          detail::gemm_packed(BlasOperation::NoTrans, BlasOperation::NoTrans,
+                              m, n, m, alpha, full, ka, B, ldb, beta, C, ldc);
+        else
+          detail::gemm_packed(BlasOperation::NoTrans, BlasOperation::NoTrans,
+                              m, n, n, alpha, B, ldb, full, ka, beta, C, ldc);
       }
 
-      return scale * std::sqrt(ssq);
-    }
+      /**
+       * @brief A matrix view as gemm arguments
+       *
+       * Keeps the dense copy alive when the view had to be materialized.
+       */
+      template <typename T>
+      struct MatrixOperand
+      {
+        const T *data = nullptr;
+        size_t ld = 1;
+        BlasOperation op = BlasOperation::NoTrans;
+        core::TensorView<T> storage;
+      };
 
-    template <>
-    double Blas::nrm2<double>(size_t n, const double *x, int incx)
-    {
-      double scale = 0.0;
-      double ssq = 1.0;
+      /**
+       * @brief Checks whether a 2-D view is row-major with contiguous rows
+       */
+      template <typename T>
+      bool has_unit_column_stride(const core::TensorView<T> &view)
+      {
+        const core::index_t rows = view.dim(0), cols = view.dim(1);
+        return (cols <= 1 || view.stride(1) == 1) &&
+               (rows <= 1 || view.stride(0) >= std::max<core::index_t>(cols, 1));
+      }
 
-      for (size_t i = 0; i < n; ++i)
+      template <typename T>
+      MatrixOperand<T> as_operand(const core::TensorView<T> &view)
       {
-        if (x[i * incx] != 0.0)
+        const core::index_t rows = view.dim(0), cols = view.dim(1);
+        MatrixOperand<T> operand;
+
+        if (has_unit_column_stride(view))
         {
-          double absxi = std::abs(x[i * incx]);
+          operand.data = view.data();
+          operand.ld = static_cast<size_t>(rows <= 1 ? std::max<core::index_t>(cols, 1) : view.stride(0));
+          return operand;
+        }
 
-          if (scale < absxi)
-          {
-            double temp = scale / absxi;
-            ssq = 1.0 + ssq * (temp * temp);
-            scale = absxi;
-          }
-          else
+        // Contiguous columns: the buffer holds op(view) row-major
+        if (has_unit_column_stride(view.transpose()))
+        {
+          operand.data = view.data();
+          operand.ld = static_cast<size_t>(cols <= 1 ? std::max<core::index_t>(rows, 1) : view.stride(1));
+          operand.op = BlasOperation::Trans;
+          return operand;
+        }
+
+        operand.storage = view.contiguous();
+        operand.data = operand.storage.data();
+        operand.ld = static_cast<size_t>(std::max<core::index_t>(cols, 1));
+        return operand;
+      }
+
+      template <typename T>
+      kernels::Epilogue<T> make_epilogue(const GemmEpilogue<T> &epilogue)
+      {
+        TF_CHECK(epilogue.quantum >= T{0}, core::ValueError, "Epilogue quantum is negative");
+        TF_CHECK(epilogue.clamp_min <= epilogue.clamp_max, core::ValueError,
+                 "Epilogue clamp range is empty");
+
+        kernels::Epilogue<T> result{};
+        result.row_bias = epilogue.row_bias;
+        result.column_bias = epilogue.column_bias;
+        result.slope = epilogue.leaky_slope;
+        result.quantum = epilogue.quantum;
+        result.clamp = epilogue.clamp_min > -std::numeric_limits<T>::infinity() ||
+                       epilogue.clamp_max < std::numeric_limits<T>::infinity();
+        result.lower = epilogue.clamp_min;
+        result.upper = epilogue.clamp_max;
+
+        switch (epilogue.activation)
+        {
+        case Activation::Identity:
+          result.activation = kernels::EpilogueActivation::Identity;
+          break;
+        case Activation::Relu:
+          result.activation = kernels::EpilogueActivation::Relu;
+          break;
+        case Activation::LeakyRelu:
+          result.activation = kernels::EpilogueActivation::LeakyRelu;
+          break;
+        case Activation::Sigmoid:
+          result.activation = kernels::EpilogueActivation::Sigmoid;
+          break;
+        case Activation::Tanh:
+          result.activation = kernels::EpilogueActivation::Tanh;
+          break;
+        }
+
+        return result;
+      }
+
+      /**
+       * @brief gemm with an epilogue on checked dimensions
+       */
+      template <typename T>
+      void gemm_fused(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, T alpha,
+                      const T *A, size_t lda, const T *B, size_t ldb,
+                      T beta, T *C, size_t ldc, const GemmEpilogue<T> &epilogue)
+      {
+        const kernels::Epilogue<T> fused = make_epilogue(epilogue);
+
+        if (backend::cuda::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                                beta, C, ldc, true) ||
+            backend::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                          beta, C, ldc))
+        {
+          if (m > 0 && n > 0)
+            detail::gemm_epilogue(m, n, C, ldc, fused);
+          return;
+        }
+
+        detail::gemm_packed(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                            beta, C, ldc, &fused);
+      }
+
+      template <typename T>
+      void gemm_pointer_batch(BlasOperation transa, BlasOperation transb,
+                              size_t m, size_t n, size_t k, T alpha,
+                              const T *const *A, size_t lda, const T *const *B, size_t ldb,
+                              T beta, T *const *C, size_t ldc, size_t batch_count)
+      {
+        TF_CHECK(batch_count == 0 || (A != nullptr && B != nullptr && C != nullptr),
+                 core::ValueError, "Batch pointer array is null");
+
+        detail::GemmBatch<T> batch;
+        batch.a = A;
+        batch.b = B;
+        batch.c = C;
+        detail::gemm_batched(transa, transb, m, n, k, alpha, lda, ldb, beta, ldc, batch, batch_count);
+      }
+
+      template <typename T>
+      void gemm_stride_batch(BlasOperation transa, BlasOperation transb,
+                             size_t m, size_t n, size_t k, T alpha,
+                             const T *A, size_t lda, size_t stride_a,
+                             const T *B, size_t ldb, size_t stride_b,
+                             T beta, T *C, size_t ldc, size_t stride_c, size_t batch_count)
+      {
+        TF_CHECK(batch_count <= 1 || m == 0 || n == 0 || stride_c >= (m - 1) * ldc + n,
+                 core::ShapeError, "C matrices of the batch overlap");
+
+        detail::GemmBatch<T> batch;
+        batch.a_base = A;
+        batch.b_base = B;
+        batch.c_base = C;
+        batch.stride_a = stride_a;
+        batch.stride_b = stride_b;
+        batch.stride_c = stride_c;
+        detail::gemm_batched(transa, transb, m, n, k, alpha, lda, ldb, beta, ldc, batch, batch_count);
+      }
+
+      template <typename T>
+      void gemm_views(T alpha, const core::TensorView<T> &A, const core::TensorView<T> &B,
+                      T beta, const core::TensorView<T> &C, const GemmEpilogue<T> *epilogue = nullptr)
+      {
+        TF_CHECK(A.rank() == 2 && B.rank() == 2 && C.rank() == 2, core::ShapeError,
+                 "gemm views must be matrices");
+        TF_CHECK(A.dim(1) == B.dim(0) && A.dim(0) == C.dim(0) && B.dim(1) == C.dim(1),
+                 core::ShapeError, "gemm view shapes do not match");
+
+        if (!has_unit_column_stride(C))
+        {
+          // C^T = B^T A^T writes a column-major C row by row
+          TF_CHECK(has_unit_column_stride(C.transpose()), core::ShapeError,
+                   "gemm output view must have a unit stride along one axis");
+          if (!epilogue)
           {
-            double temp = absxi / scale;
-            ssq += temp * temp;
+            gemm_views(alpha, B.transpose(), A.transpose(), beta, C.transpose());
+            return;
           }
+
+          // Rows of C are columns of C^T
+          GemmEpilogue<T> transposed = *epilogue;
+          std::swap(transposed.row_bias, transposed.column_bias);
+          gemm_views(alpha, B.transpose(), A.transpose(), beta, C.transpose(), &transposed);
+          return;
         }
+
+        const MatrixOperand<T> a = as_operand(A);
+        const MatrixOperand<T> b = as_operand(B);
+        const size_t ldc = static_cast<size_t>(C.dim(0) <= 1 ? std::max<core::index_t>(C.dim(1), 1)
+                                                             : C.stride(0));
+
+        const size_t m = static_cast<size_t>(C.dim(0));
+        const size_t n = static_cast<size_t>(C.dim(1));
+        const size_t k = static_cast<size_t>(A.dim(1));
+        if (epilogue)
+          Blas::gemm(a.op, b.op, m, n, k, alpha, a.data, a.ld, b.data, b.ld,
+                     beta, C.data(), ldc, *epilogue);
+        else
+          Blas::gemm(a.op, b.op, m, n, k, alpha, a.data, a.ld, b.data, b.ld,
+                     beta, C.data(), ldc);
       }
+    } // namespace
+
+    // Vector dot product
+    template <>
+    float Blas::dot<float>(size_t n, const float *x, int incx,
+                           const float *y, int incy)
+    {
+      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+      TF_PROFILE_KERNEL("dot", 2 * n, 2 * n * sizeof(float));
+
+      float result;
+      if (backend::dot(n, x, incx, y, incy, result))
+        return result;
+
+      if (incx == 1 && incy == 1)
+        return kernels::kernel_table<float>().dot(n, x, y);
+
+      return strided_dot(n, x, incx, y, incy);
+    }
+
+    template <>
+    double Blas::dot<double>(size_t n, const double *x,
+                             int incx, const double *y, int incy)
+    {
+      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+      TF_PROFILE_KERNEL("dot", 2 * n, 2 * n * sizeof(double));
+
+      double result;
+      if (backend::dot(n, x, incx, y, incy, result))
+        return result;
+
+      if (incx == 1 && incy == 1)
+        return kernels::kernel_table<double>().dot(n, x, y);
+
+      return strided_dot(n, x, incx, y, incy);
+    }
 
-      return scale * std::sqrt(ssq);
+    // Vector norm
+    template <>
+    float Blas::nrm2<float>(size_t n, const float *x, int incx)
+    {
+      return nrm2_impl(n, x, incx);
+    }
+
+    template <>
+    double Blas::nrm2<double>(size_t n, const double *x, int incx)
+    {
+      return nrm2_impl(n, x, incx);
     }
 
     // Scale vector
     template <>
     void Blas::scal<float>(size_t n, float alpha, float *x, int incx)
     {
-      for (size_t i = 0; i < n; ++i)
-        x[i * incx] *= alpha;
+      TF_PROFILE_KERNEL("scal", n, 2 * n * sizeof(float));
+      scal_impl(n, alpha, x, incx);
     }
 
     template <>
     void Blas::scal<double>(size_t n, double alpha, double *x, int incx)
     {
-      for (size_t i = 0; i < n; ++i)
-        x[i * incx] *= alpha;
+      TF_PROFILE_KERNEL("scal", n, 2 * n * sizeof(double));
+      scal_impl(n, alpha, x, incx);
     }
 
     // Vector addition
     template <>
     void Blas::axpy<float>(size_t n, float alpha, const float *x, int incx, float *y, int incy)
     {
-      for (size_t i = 0; i < n; ++i)
-        y[i * incy] += alpha * x[i * incx];
+      TF_PROFILE_KERNEL("axpy", 2 * n, 3 * n * sizeof(float));
+      if (backend::axpy(n, alpha, x, incx, y, incy))
+        return;
+
+      axpy_impl(n, alpha, x, incx, y, incy);
     }
 
     template <>
     void Blas::axpy<double>(size_t n, double alpha, const double *x, int incx, double *y, int incy)
     {
-      for (size_t i = 0; i < n; ++i)
-        y[i * incy] += alpha * x[i * incx];
+      TF_PROFILE_KERNEL("axpy", 2 * n, 3 * n * sizeof(double));
+      if (backend::axpy(n, alpha, x, incx, y, incy))
+        return;
+
+      axpy_impl(n, alpha, x, incx, y, incy);
+    }
+
+    // Matrix-vector multiplication
+    template <>
+    void Blas::gemv<float>(size_t m, size_t n, float alpha, const float *A, size_t lda,
+                           const float *x, int incx, float beta, float *y, int incy)
+    {
+      TF_PROFILE_KERNEL("gemv", 2 * m * n, (m * n + n + 2 * m) * sizeof(float));
+      gemv_impl(m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    template <>
+    void Blas::gemv<double>(size_t m, size_t n, double alpha, const double *A, size_t lda,
+                            const double *x, int incx, double beta, double *y, int incy)
+    {
+      TF_PROFILE_KERNEL("gemv", 2 * m * n, (m * n + n + 2 * m) * sizeof(double));
+      gemv_impl(m, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    // Symmetric matrix-vector multiplication
+    template <>
+    void Blas::symv<float>(char uplo, size_t n, float alpha, const float *A, size_t lda,
+                           const float *x, int incx, float beta, float *y, int incy)
+    {
+      symv_impl(uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    template <>
+    void Blas::symv<double>(char uplo, size_t n, double alpha, const double *A, size_t lda,
+                            const double *x, int incx, double beta, double *y, int incy)
+    {
+      symv_impl(uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+    }
+
+    // Matrix-matrix multiplication
+    template <>
+    void Blas::gemm<float>(BlasOperation transa, BlasOperation transb,
+                           size_t m, size_t n, size_t k, float alpha,
+                           const float *A, size_t lda, const float *B, size_t ldb,
+                           float beta, float *C, size_t ldc)
+    {
+      check_gemm_dims<float>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm", 2 * m * n * k, (m * k + k * n + m * n) * sizeof(float));
+
+      if (backend::cuda::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                              beta, C, ldc))
+        return;
+
+      if (backend::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                        beta, C, ldc))
+        return;
+
+      detail::gemm_packed(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                          beta, C, ldc);
+    }
+
+    template <>
+    void Blas::gemm<double>(BlasOperation transa, BlasOperation transb,
+                            size_t m, size_t n, size_t k, double alpha,
+                            const double *A, size_t lda, const double *B, size_t ldb,
+                            double beta, double *C, size_t ldc)
+    {
+      check_gemm_dims<double>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm", 2 * m * n * k, (m * k + k * n + m * n) * sizeof(double));
+
+      if (backend::cuda::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                              beta, C, ldc))
+        return;
+
+      if (backend::gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                        beta, C, ldc))
+        return;
+
+      detail::gemm_packed(transa, transb, m, n, k, alpha, A, lda, B, ldb,
+                          beta, C, ldc);
+    }
+
+    template <>
+    void Blas::gemm<float>(BlasOperation transa, BlasOperation transb,
+                           size_t m, size_t n, size_t k, float alpha,
+                           const float *A, size_t lda, const float *B, size_t ldb,
+                           float beta, float *C, size_t ldc,
+                           const GemmEpilogue<float> &epilogue)
+    {
+      check_gemm_dims<float>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_fused", 2 * m * n * k, (m * k + k * n + m * n) * sizeof(float));
+      gemm_fused(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+    }
+
+    template <>
+    void Blas::gemm<double>(BlasOperation transa, BlasOperation transb,
+                            size_t m, size_t n, size_t k, double alpha,
+                            const double *A, size_t lda, const double *B, size_t ldb,
+                            double beta, double *C, size_t ldc,
+                            const GemmEpilogue<double> &epilogue)
+    {
+      check_gemm_dims<double>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_fused", 2 * m * n * k, (m * k + k * n + m * n) * sizeof(double));
+      gemm_fused(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+    }
+
+    template <>
+    void Blas::gemm<float>(float alpha, const core::TensorView<float> &A,
+                           const core::TensorView<float> &B, float beta,
+                           const core::TensorView<float> &C)
+    {
+      gemm_views(alpha, A, B, beta, C);
+    }
+
+    template <>
+    void Blas::gemm<double>(double alpha, const core::TensorView<double> &A,
+                            const core::TensorView<double> &B, double beta,
+                            const core::TensorView<double> &C)
+    {
+      gemm_views(alpha, A, B, beta, C);
+    }
+
+    template <>
+    void Blas::gemm<float>(float alpha, const core::TensorView<float> &A,
+                           const core::TensorView<float> &B, float beta,
+                           const core::TensorView<float> &C,
+                           const GemmEpilogue<float> &epilogue)
+    {
+      gemm_views(alpha, A, B, beta, C, &epilogue);
+    }
+
+    template <>
+    void Blas::gemm<double>(double alpha, const core::TensorView<double> &A,
+                            const core::TensorView<double> &B, double beta,
+                            const core::TensorView<double> &C,
+                            const GemmEpilogue<double> &epilogue)
+    {
+      gemm_views(alpha, A, B, beta, C, &epilogue);
+    }
+
+    // Batched matrix-matrix multiplication
+    template <>
+    void Blas::gemm_batched<float>(BlasOperation transa, BlasOperation transb,
+                                   size_t m, size_t n, size_t k, float alpha,
+                                   const float *const *A, size_t lda,
+                                   const float *const *B, size_t ldb,
+                                   float beta, float *const *C, size_t ldc,
+                                   size_t batch_count)
+    {
+      check_gemm_dims<float>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_batched", 2 * m * n * k * batch_count,
+                        (m * k + k * n + m * n) * batch_count * sizeof(float));
+      gemm_pointer_batch(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, batch_count);
+    }
+
+    template <>
+    void Blas::gemm_batched<double>(BlasOperation transa, BlasOperation transb,
+                                    size_t m, size_t n, size_t k, double alpha,
+                                    const double *const *A, size_t lda,
+                                    const double *const *B, size_t ldb,
+                                    double beta, double *const *C, size_t ldc,
+                                    size_t batch_count)
+    {
+      check_gemm_dims<double>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_batched", 2 * m * n * k * batch_count,
+                        (m * k + k * n + m * n) * batch_count * sizeof(double));
+      gemm_pointer_batch(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, batch_count);
+    }
+
+    template <>
+    void Blas::gemm_strided_batched<float>(BlasOperation transa, BlasOperation transb,
+                                           size_t m, size_t n, size_t k, float alpha,
+                                           const float *A, size_t lda, size_t stride_a,
+                                           const float *B, size_t ldb, size_t stride_b,
+                                           float beta, float *C, size_t ldc, size_t stride_c,
+                                           size_t batch_count)
+    {
+      check_gemm_dims<float>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_batched", 2 * m * n * k * batch_count,
+                        (m * k + k * n + m * n) * batch_count * sizeof(float));
+      gemm_stride_batch(transa, transb, m, n, k, alpha, A, lda, stride_a, B, ldb, stride_b,
+                        beta, C, ldc, stride_c, batch_count);
+    }
+
+    template <>
+    void Blas::gemm_strided_batched<double>(BlasOperation transa, BlasOperation transb,
+                                            size_t m, size_t n, size_t k, double alpha,
+                                            const double *A, size_t lda, size_t stride_a,
+                                            const double *B, size_t ldb, size_t stride_b,
+                                            double beta, double *C, size_t ldc, size_t stride_c,
+                                            size_t batch_count)
+    {
+      check_gemm_dims<double>(m, n, k, lda, ldb, ldc, transa, transb);
+      TF_PROFILE_KERNEL("gemm_batched", 2 * m * n * k * batch_count,
+                        (m * k + k * n + m * n) * batch_count * sizeof(double));
+      gemm_stride_batch(transa, transb, m, n, k, alpha, A, lda, stride_a, B, ldb, stride_b,
+                        beta, C, ldc, stride_c, batch_count);
+    }
+
+    // Mixed-precision dot products and matrix-matrix multiplication
+    float Blas::dot(size_t n, const core::BFloat16 *x, int incx,
+                    const core::BFloat16 *y, int incy)
+    {
+      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+
+      if (incx == 1 && incy == 1)
+        return kernels::reduced_kernel_table().dot_bf16(n, raw_bits(x), raw_bits(y));
+
+      return strided_dot<core::BFloat16, float>(n, x, incx, y, incy);
+    }
+
+    float Blas::dot(size_t n, const core::Float16 *x, int incx,
+                    const core::Float16 *y, int incy)
+    {
+      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+
+      if (incx == 1 && incy == 1)
+        return kernels::reduced_kernel_table().dot_f16(n, raw_bits(x), raw_bits(y));
+
+      return strided_dot<core::Float16, float>(n, x, incx, y, incy);
+    }
+
+    std::int32_t Blas::dot(size_t n, const std::int8_t *x, int incx,
+                           const std::int8_t *y, int incy)
+    {
+      TF_CHECK(n > 0, std::invalid_argument, "Invalid vector size");
+
+      if (incx == 1 && incy == 1)
+        return kernels::reduced_kernel_table().dot_i8(n, x, y);
+
+      // Unsigned, so the sum wraps like the kernels instead of overflowing
+      const auto sum = strided_dot<std::int8_t, std::uint32_t>(n, x, incx, y, incy);
+      return static_cast<std::int32_t>(sum);
+    }
+
+    void Blas::gemm(BlasOperation transa, BlasOperation transb,
+                    size_t m, size_t n, size_t k, float alpha,
+                    const core::BFloat16 *A, size_t lda, const core::BFloat16 *B, size_t ldb,
+                    float beta, float *C, size_t ldc)
+    {
+      check_gemm_dims<core::BFloat16>(m, n, k, lda, ldb, ldc, transa, transb);
+      detail::gemm_mixed(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    void Blas::gemm(BlasOperation transa, BlasOperation transb,
+                    size_t m, size_t n, size_t k, float alpha,
+                    const core::Float16 *A, size_t lda, const core::Float16 *B, size_t ldb,
+                    float beta, float *C, size_t ldc)
+    {
+      check_gemm_dims<core::Float16>(m, n, k, lda, ldb, ldc, transa, transb);
+      detail::gemm_mixed(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    void Blas::gemm(BlasOperation transa, BlasOperation transb,
+                    size_t m, size_t n, size_t k, std::int32_t alpha,
+                    const std::int8_t *A, size_t lda, const std::int8_t *B, size_t ldb,
+                    std::int32_t beta, std::int32_t *C, size_t ldc)
+    {
+      check_gemm_dims<std::int8_t>(m, n, k, lda, ldb, ldc, transa, transb);
+      detail::gemm_mixed(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    void Blas::gemm(BlasOperation transa, BlasOperation transb,
+                    size_t m, size_t n, size_t k,
+                    const std::int8_t *A, size_t lda, const QuantParams &qa,
+                    const std::int8_t *B, size_t ldb, const QuantParams &qb,
+                    std::int8_t *C, size_t ldc, const QuantParams &qc,
+                    const GemmEpilogue<float> &epilogue)
+    {
+      check_gemm_dims<std::int8_t>(m, n, k, lda, ldb, ldc, transa, transb);
+      qa.validate();
+      qb.validate();
+      qc.validate();
+      TF_CHECK(qa.channels() == 1 || qa.channels() == m, core::ShapeError,
+               "Quantization of A needs one channel or one per row");
+      TF_CHECK(qb.channels() == 1 || qb.channels() == n, core::ShapeError,
+               "Quantization of B needs one channel or one per column");
+      TF_CHECK(qc.channels() == 1 || qc.channels() == n, core::ShapeError,
+               "Quantization of C needs one channel or one per column");
+
+      const kernels::Epilogue<float> fused = make_epilogue(epilogue);
+      const bool identity = !epilogue.row_bias && !epilogue.column_bias &&
+                            epilogue.activation == Activation::Identity &&
+                            fused.quantum == 0.0f && !fused.clamp;
+      detail::gemm_requantized(transa, transb, m, n, k, A, lda, qa, B, ldb, qb, C, ldc, qc,
+                               identity ? nullptr : &fused);
+    }
+
+    // Symmetric matrix-matrix multiplication
+    template <>
+    void Blas::symm<float>(char side, char uplo, size_t m, size_t n, float alpha,
+                           const float *A, size_t lda, const float *B, size_t ldb,
+                           float beta, float *C, size_t ldc)
+    {
+      symm_impl(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    template <>
+    void Blas::symm<double>(char side, char uplo, size_t m, size_t n, double alpha,
+                            const double *A, size_t lda, const double *B, size_t ldb,
+                            double beta, double *C, size_t ldc)
+    {
+      symm_impl(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    const char *Blas::backend_name()
+    {
+      return backend::name();
     }
 
     template <typename T>
@@ -130,16 +907,17 @@ namespace tf
       bool ta = transa != BlasOperation::NoTrans;
       bool tb = transb != BlasOperation::NoTrans;
 
-      if (ta && lda < k)
+      // Row-major storage: op(A) is m x k, op(B) is k x n and C is m x n
+      if (ta && lda < m)
         throw core::ShapeError("Invalid lda for transposed A");
 
-      if (!ta && lda < m)
+      if (!ta && lda < k)
         throw core::ShapeError("Invalid lda for non-transposed A");
 
-      if (tb && ldb < n)
+      if (tb && ldb < k)
         throw core::ShapeError("Invalid ldb for transposed B");
 
-      if (!tb && ldb < k)
+      if (!tb && ldb < n)
         throw core::ShapeError("Invalid ldb for non-transposed B");
 
       if (ldc < n)
@@ -0,0 +1,324 @@
+#include "math/blas_backend.hpp"
+
+#if defined(TF_BLAS_ENABLED)
+#if __has_include(<mkl_cblas.h>)
+#include <mkl_cblas.h>
+#elif __has_include(<cblas.h>)
+#include <cblas.h>
+#else
+#error "TF_USE_BLAS requires a CBLAS header (cblas.h or mkl_cblas.h)"
+#endif
+#endif
+
+#include <climits>
+#include <cstdlib>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace backend
+    {
+#if defined(TF_BLAS_ENABLED)
+      namespace
+      {
+        /**
+         * @brief Checks that all dimensions fit the library's integer type
+         *
+         * CBLAS takes int (LP64) sizes; larger problems stay on the
+         * built-in kernels rather than being truncated.
+         */
+        template <typename... Sizes>
+        bool fits_int(Sizes... sizes)
+        {
+          return ((static_cast<size_t>(sizes) <= static_cast<size_t>(INT_MAX)) && ...);
+        }
+
+        int to_int(size_t value)
+        {
+          return static_cast<int>(value);
+        }
+
+        CBLAS_TRANSPOSE to_cblas(BlasOperation op)
+        {
+          switch (op)
+          {
+          case BlasOperation::Trans:
+            return CblasTrans;
+          case BlasOperation::ConjTrans:
+            return CblasConjTrans;
+          case BlasOperation::NoTrans:
+          default:
+            return CblasNoTrans;
+          }
+        }
+
+        CBLAS_UPLO to_cblas_uplo(char uplo)
+        {
+          return (uplo == 'U' || uplo == 'u') ? CblasUpper : CblasLower;
+        }
+
+        CBLAS_SIDE to_cblas_side(char side)
+        {
+          return (side == 'L' || side == 'l') ? CblasLeft : CblasRight;
+        }
+
+        // Overloads mapping element types onto the s/d entry points
+        float call_dot(int n, const float *x, int incx, const float *y, int incy)
+        {
+          return cblas_sdot(n, x, incx, y, incy);
+        }
+
+        double call_dot(int n, const double *x, int incx, const double *y, int incy)
+        {
+          return cblas_ddot(n, x, incx, y, incy);
+        }
+
+        void call_axpy(int n, float alpha, const float *x, int incx, float *y, int incy)
+        {
+          cblas_saxpy(n, alpha, x, incx, y, incy);
+        }
+
+        void call_axpy(int n, double alpha, const double *x, int incx, double *y, int incy)
+        {
+          cblas_daxpy(n, alpha, x, incx, y, incy);
+        }
+
+        void call_gemv(int m, int n, float alpha, const float *A, int lda,
+                       const float *x, int incx, float beta, float *y, int incy)
+        {
+          cblas_sgemv(CblasRowMajor, CblasNoTrans, m, n, alpha, A, lda,
+                      x, incx, beta, y, incy);
+        }
+
+        void call_gemv(int m, int n, double alpha, const double *A, int lda,
+                       const double *x, int incx, double beta, double *y, int incy)
+        {
+          cblas_dgemv(CblasRowMajor, CblasNoTrans, m, n, alpha, A, lda,
+                      x, incx, beta, y, incy);
+        }
+
+        void call_symv(CBLAS_UPLO uplo, int n, float alpha, const float *A, int lda,
+                       const float *x, int incx, float beta, float *y, int incy)
+        {
+          cblas_ssymv(CblasRowMajor, uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+        }
+
+        void call_symv(CBLAS_UPLO uplo, int n, double alpha, const double *A, int lda,
+                       const double *x, int incx, double beta, double *y, int incy)
+        {
+          cblas_dsymv(CblasRowMajor, uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+        }
+
+        void call_gemm(CBLAS_TRANSPOSE ta, CBLAS_TRANSPOSE tb, int m, int n, int k,
+                       float alpha, const float *A, int lda, const float *B, int ldb,
+                       float beta, float *C, int ldc)
+        {
+          cblas_sgemm(CblasRowMajor, ta, tb, m, n, k, alpha, A, lda, B, ldb,
+                      beta, C, ldc);
+        }
+
+        void call_gemm(CBLAS_TRANSPOSE ta, CBLAS_TRANSPOSE tb, int m, int n, int k,
+                       double alpha, const double *A, int lda, const double *B, int ldb,
+                       double beta, double *C, int ldc)
+        {
+          cblas_dgemm(CblasRowMajor, ta, tb, m, n, k, alpha, A, lda, B, ldb,
+                      beta, C, ldc);
+        }
+
+        void call_symm(CBLAS_SIDE side, CBLAS_UPLO uplo, int m, int n,
+                       float alpha, const float *A, int lda, const float *B, int ldb,
+                       float beta, float *C, int ldc)
+        {
+          cblas_ssymm(CblasRowMajor, side, uplo, m, n, alpha, A, lda, B, ldb,
+                      beta, C, ldc);
+        }
+
+        void call_symm(CBLAS_SIDE side, CBLAS_UPLO uplo, int m, int n,
+                       double alpha, const double *A, int lda, const double *B, int ldb,
+                       double beta, double *C, int ldc)
+        {
+          cblas_dsymm(CblasRowMajor, side, uplo, m, n, alpha, A, lda, B, ldb,
+                      beta, C, ldc);
+        }
+
+        template <typename T>
+        bool dot_impl(size_t n, const T *x, int incx, const T *y, int incy, T &result)
+        {
+          if (n < LEVEL1_MIN_SIZE || !fits_int(n))
+            return false;
+
+          result = call_dot(to_int(n), x, incx, y, incy);
+          return true;
+        }
+
+        template <typename T>
+        bool axpy_impl(size_t n, T alpha, const T *x, int incx, T *y, int incy)
+        {
+          if (n < LEVEL1_MIN_SIZE || !fits_int(n))
+            return false;
+
+          call_axpy(to_int(n), alpha, x, incx, y, incy);
+          return true;
+        }
+
+        template <typename T>
+        bool gemv_impl(size_t m, size_t n, T alpha, const T *A, size_t lda,
+                       const T *x, int incx, T beta, T *y, int incy)
+        {
+          if (m * n < LEVEL2_MIN_WORK || !fits_int(m, n, lda))
+            return false;
+
+          call_gemv(to_int(m), to_int(n), alpha, A, to_int(lda), x, incx, beta, y, incy);
+          return true;
+        }
+
+        template <typename T>
+        bool symv_impl(char uplo, size_t n, T alpha, const T *A, size_t lda,
+                       const T *x, int incx, T beta, T *y, int incy)
+        {
+          if (n * n < LEVEL2_MIN_WORK || !fits_int(n, lda))
+            return false;
+
+          call_symv(to_cblas_uplo(uplo), to_int(n), alpha, A, to_int(lda),
+                    x, incx, beta, y, incy);
+          return true;
+        }
+
+        template <typename T>
+        bool gemm_impl(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, T alpha,
+                       const T *A, size_t lda, const T *B, size_t ldb,
+                       T beta, T *C, size_t ldc)
+        {
+          if (m * n * k < GEMM_MIN_WORK || !fits_int(m, n, k, lda, ldb, ldc))
+            return false;
+
+          call_gemm(to_cblas(transa), to_cblas(transb), to_int(m), to_int(n), to_int(k),
+                    alpha, A, to_int(lda), B, to_int(ldb), beta, C, to_int(ldc));
+          return true;
+        }
+
+        template <typename T>
+        bool symm_impl(char side, char uplo, size_t m, size_t n, T alpha,
+                       const T *A, size_t lda, const T *B, size_t ldb,
+                       T beta, T *C, size_t ldc)
+        {
+          const size_t ka = (side == 'L' || side == 'l') ? m : n;
+          if (m * n * ka < GEMM_MIN_WORK || !fits_int(m, n, lda, ldb, ldc))
+            return false;
+
+          call_symm(to_cblas_side(side), to_cblas_uplo(uplo), to_int(m), to_int(n),
+                    alpha, A, to_int(lda), B, to_int(ldb), beta, C, to_int(ldc));
+          return true;
+        }
+      } // namespace
+
+      const char *name()
+      {
+        return "cblas";
+      }
+#else
+      namespace
+      {
+        template <typename... Args>
+        bool dot_impl(Args...) { return false; }
+
+        template <typename... Args>
+        bool axpy_impl(Args...) { return false; }
+
+        template <typename... Args>
+        bool gemv_impl(Args...) { return false; }
+
+        template <typename... Args>
+        bool symv_impl(Args...) { return false; }
+
+        template <typename... Args>
+        bool gemm_impl(Args...) { return false; }
+
+        template <typename... Args>
+        bool symm_impl(Args...) { return false; }
+      } // namespace
+
+      const char *name()
+      {
+        return nullptr;
+      }
+#endif
+
+      bool dot(size_t n, const float *x, int incx, const float *y, int incy, float &result)
+      {
+        return dot_impl(n, x, incx, y, incy, result);
+      }
+
+      bool dot(size_t n, const double *x, int incx, const double *y, int incy, double &result)
+      {
+        return dot_impl(n, x, incx, y, incy, result);
+      }
+
+      bool axpy(size_t n, float alpha, const float *x, int incx, float *y, int incy)
+      {
+        return axpy_impl(n, alpha, x, incx, y, incy);
+      }
+
+      bool axpy(size_t n, double alpha, const double *x, int incx, double *y, int incy)
+      {
+        return axpy_impl(n, alpha, x, incx, y, incy);
+      }
+
+      bool gemv(size_t m, size_t n, float alpha, const float *A, size_t lda,
+                const float *x, int incx, float beta, float *y, int incy)
+      {
+        return gemv_impl(m, n, alpha, A, lda, x, incx, beta, y, incy);
+      }
+
+      bool gemv(size_t m, size_t n, double alpha, const double *A, size_t lda,
+                const double *x, int incx, double beta, double *y, int incy)
+      {
+        return gemv_impl(m, n, alpha, A, lda, x, incx, beta, y, incy);
+      }
+
+      bool symv(char uplo, size_t n, float alpha, const float *A, size_t lda,
+                const float *x, int incx, float beta, float *y, int incy)
+      {
+        return symv_impl(uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+      }
+
+      bool symv(char uplo, size_t n, double alpha, const double *A, size_t lda,
+                const double *x, int incx, double beta, double *y, int incy)
+      {
+        return symv_impl(uplo, n, alpha, A, lda, x, incx, beta, y, incy);
+      }
+
+      bool gemm(BlasOperation transa, BlasOperation transb,
+                size_t m, size_t n, size_t k, float alpha,
+                const float *A, size_t lda, const float *B, size_t ldb,
+                float beta, float *C, size_t ldc)
+      {
+        return gemm_impl(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+      }
+
+      bool gemm(BlasOperation transa, BlasOperation transb,
+                size_t m, size_t n, size_t k, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double beta, double *C, size_t ldc)
+      {
+        return gemm_impl(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+      }
+
+      bool symm(char side, char uplo, size_t m, size_t n, float alpha,
+                const float *A, size_t lda, const float *B, size_t ldb,
+                float beta, float *C, size_t ldc)
+      {
+        return symm_impl(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+      }
+
+      bool symm(char side, char uplo, size_t m, size_t n, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double beta, double *C, size_t ldc)
+      {
+        return symm_impl(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+      }
+    } // namespace backend
+  } // namespace math
+} // namespace tf
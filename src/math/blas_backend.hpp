@@ -0,0 +1,106 @@
+#pragma once
+
+#include <tf/math/blas.hpp>
+
+#include <cstddef>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace backend
+    {
+      /**
+       * @brief Minimum amount of work before a call is handed to the
+       * external BLAS library
+       *
+       * Below these sizes the library's own dispatch (argument checks,
+       * thread start-up, kernel selection) costs more than the built-in
+       * kernels need to finish the call.
+       */
+      inline constexpr size_t GEMM_MIN_WORK = 48 * 48 * 48; ///< m * n * k
+      inline constexpr size_t LEVEL2_MIN_WORK = 256 * 256;  ///< m * n
+      inline constexpr size_t LEVEL1_MIN_SIZE = 1 << 16;    ///< n
+
+      /**
+       * @brief Gets the name of the external BLAS backend
+       *
+       * @return const char* "cblas" when built with TF_USE_BLAS, nullptr otherwise
+       */
+      const char *name();
+
+      // Each function returns true when the call was executed by the
+      // external library, and false when the caller should fall back to the
+      // built-in kernels (backend disabled, call too small, or arguments
+      // that do not fit the library's integer type).
+
+      bool dot(size_t n, const float *x, int incx, const float *y, int incy, float &result);
+      bool dot(size_t n, const double *x, int incx, const double *y, int incy, double &result);
+
+      bool axpy(size_t n, float alpha, const float *x, int incx, float *y, int incy);
+      bool axpy(size_t n, double alpha, const double *x, int incx, double *y, int incy);
+
+      bool gemv(size_t m, size_t n, float alpha, const float *A, size_t lda,
+                const float *x, int incx, float beta, float *y, int incy);
+      bool gemv(size_t m, size_t n, double alpha, const double *A, size_t lda,
+                const double *x, int incx, double beta, double *y, int incy);
+
+      bool symv(char uplo, size_t n, float alpha, const float *A, size_t lda,
+                const float *x, int incx, float beta, float *y, int incy);
+      bool symv(char uplo, size_t n, double alpha, const double *A, size_t lda,
+                const double *x, int incx, double beta, double *y, int incy);
+
+      bool gemm(BlasOperation transa, BlasOperation transb,
+                size_t m, size_t n, size_t k, float alpha,
+                const float *A, size_t lda, const float *B, size_t ldb,
+                float beta, float *C, size_t ldc);
+      bool gemm(BlasOperation transa, BlasOperation transb,
+                size_t m, size_t n, size_t k, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double beta, double *C, size_t ldc);
+
+      bool symm(char side, char uplo, size_t m, size_t n, float alpha,
+                const float *A, size_t lda, const float *B, size_t ldb,
+                float beta, float *C, size_t ldc);
+      bool symm(char side, char uplo, size_t m, size_t n, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double beta, double *C, size_t ldc);
+
+      /**
+       * @brief cuBLAS dispatch, built with TF_USE_CUDA
+       *
+       * Operands in device memory (see core::cuda::to_device()) always run
+       * on the device, queued on the calling thread's current stream.
+       * Host operands run there only when the default device is
+       * DeviceType::CUDA and the product is large enough to pay for the
+       * transfers; they are staged through the caching allocator and the
+       * call returns with C written back.
+       */
+      namespace cuda
+      {
+        inline constexpr size_t GEMM_MIN_WORK = 256 * 256 * 256; ///< m * n * k, host operands
+
+        /**
+         * @brief Runs a GEMM with cuBLAS when its operands or the
+         * configuration call for it
+         *
+         * Callers pass host_output when they go on to read C on the host,
+         * as the epilogue of a fused GEMM does.
+         *
+         * @return bool True if cuBLAS executed the call
+         * @throw DeviceError if operands are split between host and device
+         * @throw NotImplementedError if host_output is set and C is device
+         * memory
+         */
+        bool gemm(BlasOperation transa, BlasOperation transb,
+                  size_t m, size_t n, size_t k, float alpha,
+                  const float *A, size_t lda, const float *B, size_t ldb,
+                  float beta, float *C, size_t ldc, bool host_output = false);
+        bool gemm(BlasOperation transa, BlasOperation transb,
+                  size_t m, size_t n, size_t k, double alpha,
+                  const double *A, size_t lda, const double *B, size_t ldb,
+                  double beta, double *C, size_t ldc, bool host_output = false);
+      } // namespace cuda
+    } // namespace backend
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,218 @@
+#include "math/blas_backend.hpp"
+#include <tf/core/config.hpp>
+#include <tf/core/device.hpp>
+
+#if defined(TF_CUDA_ENABLED)
+#include <cublas_v2.h>
+#include <cuda_runtime.h>
+#endif
+
+#include <climits>
+#include <string>
+#include <vector>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace backend
+    {
+      namespace cuda
+      {
+#if defined(TF_CUDA_ENABLED)
+        namespace
+        {
+          void check(cublasStatus_t status, const char *what)
+          {
+            if (status != CUBLAS_STATUS_SUCCESS)
+              throw core::DeviceError(std::string(what) + " failed with cuBLAS status " +
+                                      std::to_string(static_cast<int>(status)));
+          }
+
+          /**
+           * @brief Gets the calling thread's cuBLAS handle for a device
+           *
+           * Handles are never destroyed: the main thread's thread-local
+           * destructors may run after the CUDA runtime shut down.
+           */
+          cublasHandle_t handle(int device)
+          {
+            thread_local std::vector<cublasHandle_t> handles;
+
+            const size_t index = static_cast<size_t>(device);
+            if (handles.size() <= index)
+              handles.resize(index + 1, nullptr);
+            if (!handles[index])
+              check(cublasCreate(&handles[index]), "cublasCreate");
+            return handles[index];
+          }
+
+          template <typename... Sizes>
+          bool fits_int(Sizes... sizes)
+          {
+            return ((static_cast<size_t>(sizes) <= static_cast<size_t>(INT_MAX)) && ...);
+          }
+
+          cublasOperation_t to_cublas(BlasOperation op)
+          {
+            switch (op)
+            {
+            case BlasOperation::Trans:
+              return CUBLAS_OP_T;
+            case BlasOperation::ConjTrans:
+              return CUBLAS_OP_C;
+            case BlasOperation::NoTrans:
+            default:
+              return CUBLAS_OP_N;
+            }
+          }
+
+          // Overloads mapping element types onto the S/D entry points
+          cublasStatus_t call_gemm(cublasHandle_t h, cublasOperation_t ta, cublasOperation_t tb,
+                                   int m, int n, int k, const float *alpha,
+                                   const float *A, int lda, const float *B, int ldb,
+                                   const float *beta, float *C, int ldc)
+          {
+            return cublasSgemm(h, ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+          }
+
+          cublasStatus_t call_gemm(cublasHandle_t h, cublasOperation_t ta, cublasOperation_t tb,
+                                   int m, int n, int k, const double *alpha,
+                                   const double *A, int lda, const double *B, int ldb,
+                                   const double *beta, double *C, int ldc)
+          {
+            return cublasDgemm(h, ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+          }
+
+          /**
+           * @brief Elements spanned by a row-major matrix
+           */
+          size_t span(size_t rows, size_t cols, size_t ld)
+          {
+            return rows == 0 || cols == 0 ? 0 : (rows - 1) * ld + cols;
+          }
+
+          /**
+           * @class Staging
+           * @brief Device copy of a host operand, freed in stream order
+           */
+          class Staging
+          {
+          public:
+            Staging(size_t bytes, const core::cuda::Stream &stream)
+                : m_ptr(core::cuda::DeviceAllocator::instance().allocate(bytes, stream)) {}
+            ~Staging() { core::cuda::DeviceAllocator::instance().deallocate(m_ptr); }
+
+            Staging(const Staging &) = delete;
+            Staging &operator=(const Staging &) = delete;
+
+            void *get() const { return m_ptr; }
+
+          private:
+            void *m_ptr;
+          };
+
+          template <typename T>
+          void device_gemm(BlasOperation transa, BlasOperation transb,
+                           size_t m, size_t n, size_t k, T alpha,
+                           const T *A, size_t lda, const T *B, size_t ldb,
+                           T beta, T *C, size_t ldc, const core::cuda::Stream &stream)
+          {
+            TF_CHECK(fits_int(m, n, k, lda, ldb, ldc), core::DeviceError,
+                     "GEMM dimensions exceed the range of cuBLAS");
+
+            cublasHandle_t h = handle(stream.device());
+            check(cublasSetStream(h, static_cast<cudaStream_t>(stream.handle())), "cublasSetStream");
+
+            // cuBLAS is column-major: row-major C = op(A) op(B) is
+            // column-major C^T = op(B)^T op(A)^T over the same memory
+            check(call_gemm(h, to_cublas(transb), to_cublas(transa),
+                            static_cast<int>(n), static_cast<int>(m), static_cast<int>(k), &alpha,
+                            B, static_cast<int>(ldb), A, static_cast<int>(lda), &beta,
+                            C, static_cast<int>(ldc)),
+                  "cublas gemm");
+          }
+
+          template <typename T>
+          bool gemm_impl(BlasOperation transa, BlasOperation transb,
+                         size_t m, size_t n, size_t k, T alpha,
+                         const T *A, size_t lda, const T *B, size_t ldb,
+                         T beta, T *C, size_t ldc, bool host_output)
+          {
+            // Neither device operands nor offloading are possible: skip the
+            // pointer queries
+            const bool offload = core::config().default_device() == core::DeviceType::CUDA;
+            if (!offload && !core::cuda::DeviceAllocator::instance().in_use())
+              return false;
+
+            // Operands that are never read (empty products) follow C
+            const bool device_c = m > 0 && n > 0 && core::cuda::is_device_pointer(C);
+            const bool device_a = m > 0 && k > 0 ? core::cuda::is_device_pointer(A) : device_c;
+            const bool device_b = n > 0 && k > 0 ? core::cuda::is_device_pointer(B) : device_c;
+
+            core::cuda::Stream &stream = core::cuda::Stream::current();
+            if (device_a || device_b || device_c)
+            {
+              TF_CHECK(device_a && device_b && device_c, core::DeviceError,
+                       "GEMM operands must all be on the host or all on the device");
+              TF_CHECK(!host_output, core::NotImplementedError,
+                       "GEMM epilogues run on the host and need a host output");
+
+              if (m > 0 && n > 0)
+                device_gemm(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, stream);
+              return true;
+            }
+
+            if (!offload || m * n * k < GEMM_MIN_WORK || !fits_int(m, n, k, lda, ldb, ldc) ||
+                !core::cuda::available())
+              return false;
+
+            const size_t a_span = transa == BlasOperation::NoTrans ? span(m, k, lda) : span(k, m, lda);
+            const size_t b_span = transb == BlasOperation::NoTrans ? span(k, n, ldb) : span(n, k, ldb);
+            const size_t c_span = span(m, n, ldc);
+
+            Staging a(a_span * sizeof(T), stream);
+            Staging b(b_span * sizeof(T), stream);
+            Staging c(c_span * sizeof(T), stream);
+            core::cuda::copy_to_device(a.get(), A, a_span * sizeof(T), stream);
+            core::cuda::copy_to_device(b.get(), B, b_span * sizeof(T), stream);
+
+            // C comes back whole, so the gaps between its rows are uploaded
+            // too when there are any
+            if (beta != T(0) || ldc != n)
+              core::cuda::copy_to_device(c.get(), C, c_span * sizeof(T), stream);
+
+            device_gemm(transa, transb, m, n, k, alpha,
+                        static_cast<const T *>(a.get()), lda, static_cast<const T *>(b.get()), ldb,
+                        beta, static_cast<T *>(c.get()), ldc, stream);
+            core::cuda::copy_to_host(C, c.get(), c_span * sizeof(T), stream);
+            return true;
+          }
+        } // namespace
+#else
+        namespace
+        {
+          template <typename... Args>
+          bool gemm_impl(Args...) { return false; }
+        } // namespace
+#endif
+
+        bool gemm(BlasOperation transa, BlasOperation transb,
+                  size_t m, size_t n, size_t k, float alpha,
+                  const float *A, size_t lda, const float *B, size_t ldb,
+                  float beta, float *C, size_t ldc, bool host_output)
+        {
+          return gemm_impl(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, host_output);
+        }
+
+        bool gemm(BlasOperation transa, BlasOperation transb,
+                  size_t m, size_t n, size_t k, double alpha,
+                  const double *A, size_t lda, const double *B, size_t ldb,
+                  double beta, double *C, size_t ldc, bool host_output)
+        {
+          return gemm_impl(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, host_output);
+        }
+      } // namespace cuda
+    } // namespace backend
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,345 @@
+#include <tf/math/elementwise.hpp>
+#include <tf/core/thread_pool.hpp>
+#include "math/kernels/kernels.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace
+    {
+      /**
+       * @brief Elements per parallel chunk
+       */
+      constexpr size_t ELEMENTWISE_GRAIN = 1 << 14;
+
+      /**
+       * @brief Elements gathered at a time from operands whose innermost
+       * stride is neither 0 nor 1
+       */
+      constexpr size_t GATHER_BLOCK = 256;
+
+      /**
+       * @brief Plans kept per thread before the cache is cleared
+       */
+      constexpr size_t PLAN_CACHE_SIZE = 256;
+
+      struct PlanKeyHash
+      {
+        size_t operator()(const core::shape_t &key) const
+        {
+          size_t hash = key.size();
+          for (core::index_t v : key)
+            hash ^= std::hash<core::index_t>()(v) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+          return hash;
+        }
+      };
+
+      /**
+       * @brief Runs a conversion kernel, which takes reduced-precision
+       * values as raw bits, over the thread pool
+       */
+      template <typename From, typename To, typename In, typename Out>
+      void run_convert(void (*kernel)(size_t, const In *, Out *), size_t n, const From *x, To *y)
+      {
+        static_assert(sizeof(From) == sizeof(In) && sizeof(To) == sizeof(Out));
+        core::parallel_for(0, n, ELEMENTWISE_GRAIN, [&](size_t begin, size_t end)
+                           { kernel(end - begin, reinterpret_cast<const In *>(x + begin),
+                                    reinterpret_cast<Out *>(y + begin)); });
+      }
+
+      using PlanCache = std::unordered_map<core::shape_t, BroadcastPlan, PlanKeyHash>;
+
+      /**
+       * @brief Checks that a view can be written elementwise
+       */
+      template <typename T>
+      void check_output(const core::TensorView<T> &out)
+      {
+        for (size_t i = 0; i < out.rank(); ++i)
+          TF_CHECK(out.dim(i) <= 1 || out.stride(i) != 0, core::ShapeError,
+                   "Elementwise output repeats elements");
+      }
+
+      template <typename T>
+      using BinaryKernel = void (*)(size_t, const T *, size_t, const T *, size_t, T *);
+
+      template <typename T>
+      BinaryKernel<T> binary_kernel(BinaryOp op)
+      {
+        const kernels::KernelTable<T> &table = kernels::kernel_table<T>();
+        switch (op)
+        {
+        case BinaryOp::Add:
+          return table.add;
+        case BinaryOp::Subtract:
+          return table.subtract;
+        case BinaryOp::Multiply:
+          return table.multiply;
+        case BinaryOp::Divide:
+          return table.divide;
+        case BinaryOp::Maximum:
+          return table.maximum;
+        case BinaryOp::Minimum:
+          return table.minimum;
+        }
+        return table.add;
+      }
+
+      template <typename T>
+      void apply_unary(UnaryOp op, size_t n, const T *x, T *y)
+      {
+        const kernels::KernelTable<T> &table = kernels::kernel_table<T>();
+        switch (op)
+        {
+        case UnaryOp::Negate:
+          table.negate(n, x, y);
+          break;
+        case UnaryOp::Abs:
+          table.abs(n, x, y);
+          break;
+        case UnaryOp::Sqrt:
+          table.sqrt(n, x, y);
+          break;
+        case UnaryOp::Square:
+          table.square(n, x, y);
+          break;
+        case UnaryOp::Relu:
+          table.relu(n, x, y, nullptr);
+          break;
+        case UnaryOp::Sigmoid:
+          table.sigmoid(n, x, y, nullptr);
+          break;
+        case UnaryOp::Tanh:
+          table.tanh(n, x, y, nullptr);
+          break;
+        }
+      }
+
+      /**
+       * @brief Runs apply(n, x, incx, y, incy, z) over every innermost run
+       * of a plan
+       *
+       * apply always sees input increments of 0 or 1 and a dense output:
+       * other layouts are gathered into (and scattered from) blocks on the
+       * stack first.
+       */
+      template <typename T, typename Apply>
+      void execute(const BroadcastPlan &plan, size_t count, T *z, const T *x, const T *y,
+                   Apply apply)
+      {
+        if (count == 0)
+          return;
+
+        const size_t r = plan.dims.size();
+        const core::index_t inner = r > 0 ? plan.dims[r - 1] : 1;
+        const core::index_t sz = r > 0 ? plan.strides[0][r - 1] : 1;
+        const core::index_t sx = r > 0 ? plan.strides[1][r - 1] : 1;
+        const core::index_t sy = r > 0 ? plan.strides[2][r - 1] : 1;
+        const bool direct = sz == 1 && sx <= 1 && sy <= 1;
+
+        // Elements [begin, end) of one innermost run
+        auto run = [&](T *zr, const T *xr, const T *yr, size_t begin, size_t end)
+        {
+          if (direct)
+          {
+            apply(end - begin, xr + static_cast<core::index_t>(begin) * sx, static_cast<size_t>(sx),
+                  yr + static_cast<core::index_t>(begin) * sy, static_cast<size_t>(sy), zr + begin);
+            return;
+          }
+
+          T bx[GATHER_BLOCK], by[GATHER_BLOCK], bz[GATHER_BLOCK];
+          for (size_t b = begin; b < end; b += GATHER_BLOCK)
+          {
+            const size_t n = std::min(GATHER_BLOCK, end - b);
+            const core::index_t i = static_cast<core::index_t>(b);
+
+            const T *px = xr + i * sx;
+            const T *py = yr + i * sy;
+            if (sx > 1)
+            {
+              for (size_t j = 0; j < n; ++j)
+                bx[j] = px[static_cast<core::index_t>(j) * sx];
+              px = bx;
+            }
+            if (sy > 1)
+            {
+              for (size_t j = 0; j < n; ++j)
+                by[j] = py[static_cast<core::index_t>(j) * sy];
+              py = by;
+            }
+
+            T *pz = sz == 1 ? zr + b : bz;
+            apply(n, px, sx == 0 ? 0 : 1, py, sy == 0 ? 0 : 1, pz);
+
+            if (sz != 1)
+              for (size_t j = 0; j < n; ++j)
+                zr[(i + static_cast<core::index_t>(j)) * sz] = bz[j];
+          }
+        };
+
+        const size_t rows = count / static_cast<size_t>(inner);
+        if (rows == 1)
+        {
+          core::parallel_for(0, static_cast<size_t>(inner), ELEMENTWISE_GRAIN,
+                             [&](size_t begin, size_t end)
+                             { run(z, x, y, begin, end); });
+          return;
+        }
+
+        const size_t grain = std::max<size_t>(1, ELEMENTWISE_GRAIN / static_cast<size_t>(inner));
+        core::parallel_for(0, rows, grain, [&](size_t begin, size_t end)
+                           {
+                             for (size_t row = begin; row < end; ++row)
+                             {
+                               const core::index_t index = static_cast<core::index_t>(row);
+                               run(z + core::detail::strided_offset(index, plan.dims, plan.strides[0], r - 1),
+                                   x + core::detail::strided_offset(index, plan.dims, plan.strides[1], r - 1),
+                                   y + core::detail::strided_offset(index, plan.dims, plan.strides[2], r - 1),
+                                   0, static_cast<size_t>(inner));
+                             } });
+      }
+
+      template <typename T>
+      void run_binary(BinaryOp op, const core::TensorView<T> &a, const core::TensorView<T> &b,
+                      const core::TensorView<T> &out)
+      {
+        TF_CHECK(out.shape() == core::broadcast_shapes(a.shape(), b.shape()), core::ShapeError,
+                 "Output shape does not match the broadcast shape of the inputs");
+        check_output(out);
+        TF_PROFILE_KERNEL("binary", out.num_elements(), 3 * out.num_elements() * sizeof(T));
+
+        const core::TensorView<T> x = a.broadcast_to(out.shape());
+        const core::TensorView<T> y = b.broadcast_to(out.shape());
+        const BroadcastPlan &plan = broadcast_plan(out.shape(), out.strides(), x.strides(), y.strides());
+
+        execute(plan, static_cast<size_t>(out.num_elements()), out.data(), x.data(), y.data(),
+                binary_kernel<T>(op));
+      }
+
+      template <typename T>
+      void run_unary(UnaryOp op, const core::TensorView<T> &a, const core::TensorView<T> &out)
+      {
+        TF_CHECK(a.shape().is_broadcastable_to(out.shape()), core::ShapeError,
+                 "Input does not broadcast to the output shape");
+        check_output(out);
+        TF_PROFILE_KERNEL("unary", out.num_elements(), 2 * out.num_elements() * sizeof(T));
+
+        const core::TensorView<T> x = a.broadcast_to(out.shape());
+        const core::shape_t none(out.rank(), 0);
+        const BroadcastPlan &plan = broadcast_plan(out.shape(), out.strides(), x.strides(), none);
+
+        auto apply = [&](size_t n, const T *in, size_t inc, const T *, size_t, T *result)
+        {
+          // A repeated input is evaluated once
+          const size_t m = inc == 0 ? 1 : n;
+          apply_unary(op, m, in, result);
+
+          if (inc == 0)
+            std::fill(result + 1, result + n, result[0]);
+        };
+
+        execute(plan, static_cast<size_t>(out.num_elements()), out.data(), x.data(), x.data(), apply);
+      }
+    } // namespace
+
+    const BroadcastPlan &broadcast_plan(const core::Shape &shape, const core::shape_t &out,
+                                        const core::shape_t &a, const core::shape_t &b)
+    {
+      const size_t rank = shape.rank();
+      TF_CHECK(out.size() == rank && a.size() == rank && b.size() == rank, core::ShapeError,
+               "Strides do not match the rank of the shape");
+
+      core::shape_t key;
+      key.reserve(4 * rank);
+      key.insert(key.end(), shape.begin(), shape.end());
+      key.insert(key.end(), out.begin(), out.end());
+      key.insert(key.end(), a.begin(), a.end());
+      key.insert(key.end(), b.begin(), b.end());
+
+      thread_local PlanCache cache;
+      auto it = cache.find(key);
+      if (it != cache.end())
+        return it->second;
+
+      if (cache.size() >= PLAN_CACHE_SIZE)
+        cache.clear();
+
+      BroadcastPlan plan;
+      plan.dims.assign(shape.begin(), shape.end());
+      plan.strides = {out, a, b};
+      core::detail::collapse_dims(plan.dims, plan.strides);
+
+      return cache.emplace(std::move(key), std::move(plan)).first->second;
+    }
+
+    void binary_block(BinaryOp op, size_t n, const float *x, size_t incx, const float *y,
+                      size_t incy, float *z)
+    {
+      binary_kernel<float>(op)(n, x, incx, y, incy, z);
+    }
+
+    void binary_block(BinaryOp op, size_t n, const double *x, size_t incx, const double *y,
+                      size_t incy, double *z)
+    {
+      binary_kernel<double>(op)(n, x, incx, y, incy, z);
+    }
+
+    void convert(size_t n, const float *x, core::BFloat16 *y)
+    {
+      run_convert(kernels::reduced_kernel_table().f32_to_bf16, n, x, y);
+    }
+
+    void convert(size_t n, const core::BFloat16 *x, float *y)
+    {
+      run_convert(kernels::reduced_kernel_table().bf16_to_f32, n, x, y);
+    }
+
+    void convert(size_t n, const float *x, core::Float16 *y)
+    {
+      run_convert(kernels::reduced_kernel_table().f32_to_f16, n, x, y);
+    }
+
+    void convert(size_t n, const core::Float16 *x, float *y)
+    {
+      run_convert(kernels::reduced_kernel_table().f16_to_f32, n, x, y);
+    }
+
+    void unary_block(UnaryOp op, size_t n, const float *x, float *y)
+    {
+      apply_unary(op, n, x, y);
+    }
+
+    void unary_block(UnaryOp op, size_t n, const double *x, double *y)
+    {
+      apply_unary(op, n, x, y);
+    }
+
+    void binary(BinaryOp op, const core::TensorView<float> &a, const core::TensorView<float> &b,
+                const core::TensorView<float> &out)
+    {
+      run_binary(op, a, b, out);
+    }
+
+    void binary(BinaryOp op, const core::TensorView<double> &a, const core::TensorView<double> &b,
+                const core::TensorView<double> &out)
+    {
+      run_binary(op, a, b, out);
+    }
+
+    void unary(UnaryOp op, const core::TensorView<float> &a, const core::TensorView<float> &out)
+    {
+      run_unary(op, a, out);
+    }
+
+    void unary(UnaryOp op, const core::TensorView<double> &a, const core::TensorView<double> &out)
+    {
+      run_unary(op, a, out);
+    }
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,882 @@
+#include "math/gemm.hpp"
+
+#include <tf/core/thread_pool.hpp>
+#include <tf/utils/arena.hpp>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace detail
+    {
+      namespace
+      {
+        /**
+         * @brief Copies n contiguous values, widening reduced-precision
+         * ones to float with the conversion kernels
+         */
+        template <typename S, typename T>
+        void widen(size_t n, const S *src, T *dst)
+        {
+          if constexpr (std::is_same_v<S, core::BFloat16> || std::is_same_v<S, core::Float16>)
+          {
+            const kernels::ReducedKernelTable &table = kernels::reduced_kernel_table();
+            const auto *bits = reinterpret_cast<const std::uint16_t *>(src);
+            if constexpr (std::is_same_v<S, core::BFloat16>)
+              table.bf16_to_f32(n, bits, dst);
+            else
+              table.f16_to_f32(n, bits, dst);
+          }
+          else
+            for (size_t i = 0; i < n; ++i)
+              dst[i] = src[i];
+        }
+
+        /**
+         * @brief Packs an mc x kc block of op(A) into mr-row micro-panels.
+         *
+         * Each micro-panel stores mr consecutive values per depth step;
+         * rows past the edge of the matrix are zero-filled. Values of a
+         * reduced-precision S are widened to T.
+         */
+        template <typename S, typename T>
+        void pack_a(const S *A, size_t lda, bool trans,
+                    size_t mc, size_t kc, size_t mr, T *buf)
+        {
+          for (size_t ir = 0; ir < mc; ir += mr)
+          {
+            const size_t rows = std::min(mr, mc - ir);
+
+            if (!trans)
+            {
+              for (size_t p = 0; p < kc; ++p)
+              {
+                for (size_t i = 0; i < rows; ++i)
+                  buf[i] = static_cast<T>(A[(ir + i) * lda + p]);
+
+                for (size_t i = rows; i < mr; ++i)
+                  buf[i] = T{0};
+
+                buf += mr;
+              }
+            }
+            else
+            {
+              for (size_t p = 0; p < kc; ++p)
+              {
+                widen(rows, A + p * lda + ir, buf);
+
+                for (size_t i = rows; i < mr; ++i)
+                  buf[i] = T{0};
+
+                buf += mr;
+              }
+            }
+          }
+        }
+
+        /**
+         * @brief Packs a kc x nc block of op(B) into nr-column micro-panels.
+         *
+         * Each micro-panel stores nr consecutive values per depth step;
+         * columns past the edge of the matrix are zero-filled. Values of a
+         * reduced-precision S are widened to T.
+         */
+        template <typename S, typename T>
+        void pack_b(const S *B, size_t ldb, bool trans,
+                    size_t kc, size_t nc, size_t nr, T *buf)
+        {
+          for (size_t jr = 0; jr < nc; jr += nr)
+          {
+            const size_t cols = std::min(nr, nc - jr);
+
+            if (!trans)
+            {
+              for (size_t p = 0; p < kc; ++p)
+              {
+                widen(cols, B + p * ldb + jr, buf);
+
+                for (size_t j = cols; j < nr; ++j)
+                  buf[j] = T{0};
+
+                buf += nr;
+              }
+            }
+            else
+            {
+              for (size_t p = 0; p < kc; ++p)
+              {
+                for (size_t j = 0; j < cols; ++j)
+                  buf[j] = static_cast<T>(B[(jr + j) * ldb + p]);
+
+                for (size_t j = cols; j < nr; ++j)
+                  buf[j] = T{0};
+
+                buf += nr;
+              }
+            }
+          }
+        }
+
+        /**
+         * @brief C = beta * C, without reading C when beta is zero
+         */
+        template <typename T>
+        void scale_c(size_t m, size_t n, T beta, T *C, size_t ldc)
+        {
+          for (size_t i = 0; i < m; ++i)
+          {
+            T *row = C + i * ldc;
+            if (beta == T{0})
+              std::fill_n(row, n, T{0});
+            else if (beta != T{1})
+              for (size_t j = 0; j < n; ++j)
+                row[j] *= beta;
+          }
+        }
+
+        /**
+         * @brief Problems below this many multiply-adds run on one thread
+         */
+        constexpr size_t GEMM_PARALLEL_MIN_WORK = 64 * 64 * 64;
+
+        /**
+         * @brief Elements a parallel chunk of a standalone epilogue covers
+         */
+        constexpr size_t EPILOGUE_GRAIN = 1 << 14;
+
+        /**
+         * @brief Moves the bias pointers of an epilogue to a block of C
+         */
+        template <typename T>
+        kernels::Epilogue<T> offset_epilogue(const kernels::Epilogue<T> &epilogue,
+                                             size_t row, size_t column)
+        {
+          kernels::Epilogue<T> result = epilogue;
+          if (result.row_bias)
+            result.row_bias += row;
+          if (result.column_bias)
+            result.column_bias += column;
+          return result;
+        }
+
+        /**
+         * @brief Computes one mc x nc block of C from packed panels
+         *
+         * epilogue, when not null, refers to this block and is applied as
+         * the tiles are stored.
+         */
+        template <typename T>
+        void gemm_block(const kernels::KernelTable<T> &table,
+                        size_t mc, size_t nc, size_t kc, T alpha,
+                        const T *a_buf, const T *b_buf, T beta,
+                        T *C, size_t ldc, T *tile,
+                        const kernels::Epilogue<T> *epilogue)
+        {
+          const kernels::GemmKernel<T> &kernel = table.gemm;
+          const size_t mr = kernel.mr;
+          const size_t nr = kernel.nr;
+
+          for (size_t jr = 0; jr < nc; jr += nr)
+          {
+            const size_t cols = std::min(nr, nc - jr);
+            const T *b_panel = b_buf + jr * kc;
+
+            for (size_t ir = 0; ir < mc; ir += mr)
+            {
+              const size_t rows = std::min(mr, mc - ir);
+              const T *a_panel = a_buf + ir * kc;
+              T *c_tile = C + ir * ldc + jr;
+
+              if (rows == mr && cols == nr)
+              {
+                if (epilogue)
+                  kernel.fused(kc, a_panel, b_panel, c_tile, ldc, alpha, beta,
+                               offset_epilogue(*epilogue, ir, jr));
+                else
+                  kernel.kernel(kc, a_panel, b_panel, c_tile, ldc, alpha, beta);
+                continue;
+              }
+
+              // Edge tile: compute the full tile into scratch, then
+              // merge only the valid part into C.
+              kernel.kernel(kc, a_panel, b_panel, tile, nr, alpha, T{0});
+              for (size_t i = 0; i < rows; ++i)
+              {
+                T *c_row = c_tile + i * ldc;
+                const T *t_row = tile + i * nr;
+
+                if (beta == T{0})
+                  std::copy_n(t_row, cols, c_row);
+                else
+                  for (size_t j = 0; j < cols; ++j)
+                    c_row[j] = t_row[j] + beta * c_row[j];
+              }
+
+              if (epilogue)
+                table.epilogue(rows, cols, c_tile, ldc, offset_epilogue(*epilogue, ir, jr));
+            }
+          }
+        }
+
+        /**
+         * @brief Runs a problem with m, n and k at most
+         * kernels::SMALL_GEMM_MAX on the fixed-size kernel of the
+         * narrowest width that fits n
+         */
+        template <typename T>
+        void gemm_small(const kernels::KernelTable<T> &table, bool ta, bool tb,
+                        size_t m, size_t n, size_t k, T alpha,
+                        const T *A, size_t lda, const T *B, size_t ldb,
+                        T beta, T *C, size_t ldc)
+        {
+          size_t width = 0;
+          while ((size_t{4} << width) < n)
+            ++width;
+
+          table.small_gemm[width](m, n, k, alpha,
+                                  A, ta ? 1 : lda, ta ? lda : 1,
+                                  B, tb ? 1 : ldb, tb ? ldb : 1,
+                                  beta, C, ldc);
+        }
+
+        size_t round_up(size_t value, size_t multiple)
+        {
+          return (value + multiple - 1) / multiple * multiple;
+        }
+
+        /**
+         * @brief Whether a problem is big enough to split across the pool
+         * and, if so, the rows of A each thread packs at once
+         */
+        size_t row_block(size_t m, size_t n, size_t k, size_t mc, size_t mr, bool &parallel)
+        {
+          // When m is too small to give every thread a full mc block,
+          // blocks shrink (to a multiple of mr) so all threads get work.
+          parallel = m * n * k >= GEMM_PARALLEL_MIN_WORK;
+          if (!parallel)
+            return mc;
+
+          const size_t threads = core::thread_pool().num_threads();
+          return std::min(mc, round_up((m + threads - 1) / threads, mr));
+        }
+
+        /**
+         * @brief Cache-blocked GEMM on the micro-kernel of T, reading A and
+         * B as S (T itself, or a reduced-precision type widened to T while
+         * packing)
+         */
+        template <typename S, typename T>
+        void gemm_blocked(BlasOperation transa, BlasOperation transb,
+                          size_t m, size_t n, size_t k, T alpha,
+                          const S *A, size_t lda, const S *B, size_t ldb,
+                          T beta, T *C, size_t ldc,
+                          const kernels::Epilogue<T> *epilogue)
+        {
+          if (m == 0 || n == 0)
+            return;
+
+          if (alpha == T{0} || k == 0)
+          {
+            scale_c(m, n, beta, C, ldc);
+            if (epilogue)
+              gemm_epilogue(m, n, C, ldc, *epilogue);
+            return;
+          }
+
+          const kernels::KernelTable<T> &table = kernels::kernel_table<T>();
+          const kernels::GemmKernel<T> &kernel = table.gemm;
+          const size_t mr = kernel.mr;
+          const size_t nr = kernel.nr;
+          const bool ta = transa != BlasOperation::NoTrans;
+          const bool tb = transb != BlasOperation::NoTrans;
+
+          // Small problems skip packing and blocking altogether
+          if constexpr (std::is_same_v<S, T>)
+          {
+            if (m <= kernels::SMALL_GEMM_MAX && n <= kernels::SMALL_GEMM_MAX &&
+                k <= kernels::SMALL_GEMM_MAX)
+            {
+              gemm_small(table, ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+              if (epilogue)
+                table.epilogue(m, n, C, ldc, *epilogue);
+              return;
+            }
+          }
+
+          // Pack buffers come from the thread's scratch arena. The B panel
+          // stays live across the parallel loop, during which this thread may
+          // run an unrelated task that starts its own GEMM; that call
+          // allocates above it and rewinds before this one resumes.
+          utils::Arena &arena = utils::scratch_arena();
+          utils::ArenaCheckpoint checkpoint(arena);
+          T *b_buf = arena.allocate_array<T>(kernel.kc * kernel.nc);
+
+          // Row blocks of C are independent, so they are spread across the
+          // pool
+          bool parallel;
+          const size_t mc_block = row_block(m, n, k, kernel.mc, mr, parallel);
+          const size_t num_row_blocks = (m + mc_block - 1) / mc_block;
+          const size_t grain = parallel ? 1 : num_row_blocks;
+
+          for (size_t jc = 0; jc < n; jc += kernel.nc)
+          {
+            const size_t nc = std::min(kernel.nc, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += kernel.kc)
+            {
+              const size_t kc = std::min(kernel.kc, k - pc);
+              const T beta_pc = pc == 0 ? beta : T{1};
+              const bool final_depth = pc + kc == k;
+
+              pack_b(tb ? B + jc * ldb + pc : B + pc * ldb + jc,
+                     ldb, tb, kc, nc, nr, b_buf);
+
+              core::parallel_for(0, num_row_blocks, grain, [&](size_t first, size_t last)
+                                 {
+                                   utils::Arena &local = utils::scratch_arena();
+                                   utils::ArenaCheckpoint local_checkpoint(local);
+                                   T *a_buf = local.allocate_array<T>(mc_block * kernel.kc);
+                                   T *tile = local.allocate_array<T>(mr * nr);
+
+                                   for (size_t blk = first; blk < last; ++blk)
+                                   {
+                                     const size_t ic = blk * mc_block;
+                                     const size_t mc = std::min(mc_block, m - ic);
+
+                                     pack_a(ta ? A + pc * lda + ic : A + ic * lda + pc,
+                                            lda, ta, mc, kc, mr, a_buf);
+                                     const kernels::Epilogue<T> block_epilogue =
+                                         epilogue ? offset_epilogue(*epilogue, ic, jc) : kernels::Epilogue<T>{};
+                                     gemm_block(table, mc, nc, kc, alpha, a_buf, b_buf,
+                                                beta_pc, C + ic * ldc + jc, ldc, tile,
+                                                epilogue && final_depth ? &block_epilogue : nullptr);
+                                   }
+                                 });
+            }
+          }
+        }
+
+        /**
+         * @struct DotLayout
+         * @brief How values of S are packed for a kernels::DotGemmKernel
+         */
+        template <typename S>
+        struct DotLayout;
+
+        template <>
+        struct DotLayout<std::int8_t>
+        {
+          using a_type = std::uint8_t;
+          using b_type = std::int8_t;
+          using c_type = std::int32_t;
+
+          // vpdpbusd multiplies unsigned by signed bytes, so A is biased by
+          // 128 and 128 times each column sum of B is subtracted again
+          static a_type a(std::int8_t v) { return static_cast<a_type>(v ^ 0x80); }
+          static b_type b(std::int8_t v) { return v; }
+          static constexpr bool offset = true;
+        };
+
+        /**
+         * @brief Packs an mc x kc block of op(A) into mr-row micro-panels
+         * of depth groups; rows and depth past the edge hold zero
+         */
+        template <typename S>
+        void pack_a_groups(const S *A, size_t lda, bool trans, size_t mc, size_t kc,
+                           size_t mr, size_t group, typename DotLayout<S>::a_type *buf)
+        {
+          for (size_t ir = 0; ir < mc; ir += mr)
+          {
+            const size_t rows = std::min(mr, mc - ir);
+
+            for (size_t p0 = 0; p0 < kc; p0 += group, buf += mr * group)
+            {
+              const size_t depth = std::min(group, kc - p0);
+              if (rows < mr || depth < group)
+                std::fill_n(buf, mr * group, DotLayout<S>::a(S{}));
+
+              if (!trans)
+                for (size_t i = 0; i < rows; ++i)
+                {
+                  const S *src = A + (ir + i) * lda + p0;
+                  for (size_t t = 0; t < depth; ++t)
+                    buf[i * group + t] = DotLayout<S>::a(src[t]);
+                }
+              else
+                for (size_t t = 0; t < depth; ++t)
+                {
+                  const S *src = A + (p0 + t) * lda + ir;
+                  for (size_t i = 0; i < rows; ++i)
+                    buf[i * group + t] = DotLayout<S>::a(src[i]);
+                }
+            }
+          }
+        }
+
+        /**
+         * @brief pack_b_groups for a group size known at compile time, so
+         * that the interleaving loops unroll
+         */
+        template <size_t Group, typename S>
+        void pack_b_panels(const S *B, size_t ldb, bool trans, size_t kc, size_t nc,
+                           size_t nr, typename DotLayout<S>::b_type *buf,
+                           typename DotLayout<S>::c_type *offset)
+        {
+          const size_t groups = (kc + Group - 1) / Group;
+
+          for (size_t jr = 0; jr < nc; jr += nr)
+          {
+            const size_t cols = std::min(nr, nc - jr);
+            typename DotLayout<S>::b_type *panel = buf;
+
+            for (size_t p0 = 0; p0 < kc; p0 += Group, buf += nr * Group)
+            {
+              const size_t depth = std::min(Group, kc - p0);
+              if (cols < nr || depth < Group)
+              {
+                std::fill_n(buf, nr * Group, DotLayout<S>::b(S{}));
+                if (!trans)
+                  for (size_t t = 0; t < depth; ++t)
+                  {
+                    const S *src = B + (p0 + t) * ldb + jr;
+                    for (size_t j = 0; j < cols; ++j)
+                      buf[j * Group + t] = DotLayout<S>::b(src[j]);
+                  }
+                else
+                  for (size_t j = 0; j < cols; ++j)
+                  {
+                    const S *src = B + (jr + j) * ldb + p0;
+                    for (size_t t = 0; t < depth; ++t)
+                      buf[j * Group + t] = DotLayout<S>::b(src[t]);
+                  }
+                continue;
+              }
+
+              if (!trans)
+              {
+                const S *src = B + p0 * ldb + jr;
+                for (size_t j = 0; j < nr; ++j)
+                  for (size_t t = 0; t < Group; ++t)
+                    buf[j * Group + t] = DotLayout<S>::b(src[t * ldb + j]);
+              }
+              else
+                for (size_t j = 0; j < nr; ++j)
+                {
+                  const S *src = B + (jr + j) * ldb + p0;
+                  for (size_t t = 0; t < Group; ++t)
+                    buf[j * Group + t] = DotLayout<S>::b(src[t]);
+                }
+            }
+
+            if constexpr (DotLayout<S>::offset)
+            {
+              // Summed from the packed panel, which is in cache
+              typename DotLayout<S>::c_type *sums = offset + jr;
+              std::fill_n(sums, nr, 0);
+              for (size_t g = 0; g < groups; ++g, panel += nr * Group)
+                for (size_t j = 0; j < nr; ++j)
+                  for (size_t t = 0; t < Group; ++t)
+                    sums[j] += panel[j * Group + t];
+
+              for (size_t j = 0; j < nr; ++j)
+                sums[j] *= 128;
+            }
+          }
+        }
+
+        /**
+         * @brief Packs a kc x nc block of op(B) into nr-column micro-panels
+         * of depth groups, and, for layouts with an offset, 128 times the
+         * sum of every column into offset
+         */
+        template <typename S>
+        void pack_b_groups(const S *B, size_t ldb, bool trans, size_t kc, size_t nc,
+                           size_t nr, size_t group, typename DotLayout<S>::b_type *buf,
+                           typename DotLayout<S>::c_type *offset)
+        {
+          switch (group)
+          {
+          case 1:
+            return pack_b_panels<1>(B, ldb, trans, kc, nc, nr, buf, offset);
+          case 2:
+            return pack_b_panels<2>(B, ldb, trans, kc, nc, nr, buf, offset);
+          default:
+            return pack_b_panels<4>(B, ldb, trans, kc, nc, nr, buf, offset);
+          }
+        }
+
+        /**
+         * @brief Cache-blocked GEMM on a dot-product micro-kernel; same
+         * structure as gemm_blocked
+         *
+         * store, when given, is called as store(i, j, rows, cols, tile, ld)
+         * from the worker threads with each finished rows x cols tile of C
+         * at (i, j), while it is in cache. C may then be null if k fits one
+         * depth block, and tiles are computed into scratch only.
+         */
+        template <typename S, typename Store = std::nullptr_t>
+        void gemm_grouped(const kernels::DotGemmKernel<typename DotLayout<S>::a_type,
+                                                       typename DotLayout<S>::b_type,
+                                                       typename DotLayout<S>::c_type> &kernel,
+                          bool ta, bool tb, size_t m, size_t n, size_t k,
+                          typename DotLayout<S>::c_type alpha, const S *A, size_t lda,
+                          const S *B, size_t ldb, typename DotLayout<S>::c_type beta,
+                          typename DotLayout<S>::c_type *C, size_t ldc,
+                          const Store &store = nullptr)
+        {
+          using Layout = DotLayout<S>;
+          using TA = typename Layout::a_type;
+          using TB = typename Layout::b_type;
+          using TC = typename Layout::c_type;
+
+          const size_t mr = kernel.mr;
+          const size_t nr = kernel.nr;
+          const size_t group = kernel.group;
+
+          utils::Arena &arena = utils::scratch_arena();
+          utils::ArenaCheckpoint checkpoint(arena);
+          TB *b_buf = arena.allocate_array<TB>(kernel.kc * kernel.nc);
+          TC *offset = Layout::offset ? arena.allocate_array<TC>(kernel.nc) : nullptr;
+
+          bool parallel;
+          const size_t mc_block = row_block(m, n, k, kernel.mc, mr, parallel);
+          const size_t num_row_blocks = (m + mc_block - 1) / mc_block;
+          const size_t grain = parallel ? 1 : num_row_blocks;
+
+          for (size_t jc = 0; jc < n; jc += kernel.nc)
+          {
+            const size_t nc = std::min(kernel.nc, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += kernel.kc)
+            {
+              const size_t kc = std::min(kernel.kc, k - pc);
+              const size_t groups = (kc + group - 1) / group;
+              const TC beta_pc = pc == 0 ? beta : TC{1};
+              const bool final_depth = pc + kc == k;
+
+              pack_b_groups(tb ? B + jc * ldb + pc : B + pc * ldb + jc,
+                            ldb, tb, kc, nc, nr, group, b_buf, offset);
+
+              core::parallel_for(0, num_row_blocks, grain, [&](size_t first, size_t last)
+                                 {
+                                   utils::Arena &local = utils::scratch_arena();
+                                   utils::ArenaCheckpoint local_checkpoint(local);
+                                   TA *a_buf = local.allocate_array<TA>(mc_block * kernel.kc);
+                                   TC *tile = local.allocate_array<TC>(mr * nr);
+
+                                   for (size_t blk = first; blk < last; ++blk)
+                                   {
+                                     const size_t ic = blk * mc_block;
+                                     const size_t mc = std::min(mc_block, m - ic);
+
+                                     pack_a_groups(ta ? A + pc * lda + ic : A + ic * lda + pc,
+                                                   lda, ta, mc, kc, mr, group, a_buf);
+
+                                     for (size_t jr = 0; jr < nc; jr += nr)
+                                     {
+                                       const size_t cols = std::min(nr, nc - jr);
+                                       const TB *b_panel = b_buf + jr * groups * group;
+                                       const TC *panel_offset = offset ? offset + jr : nullptr;
+
+                                       for (size_t ir = 0; ir < mc; ir += mr)
+                                       {
+                                         const size_t rows = std::min(mr, mc - ir);
+                                         const TA *a_panel = a_buf + ir * groups * group;
+                                         TC *c_tile = C ? C + (ic + ir) * ldc + jc + jr : nullptr;
+
+                                         if (c_tile && rows == mr && cols == nr)
+                                           kernel.kernel(groups, a_panel, b_panel, panel_offset,
+                                                         c_tile, ldc, alpha, beta_pc);
+                                         else
+                                         {
+                                           kernel.kernel(groups, a_panel, b_panel, panel_offset,
+                                                         tile, nr, alpha, TC{0});
+                                           if (c_tile)
+                                             for (size_t i = 0; i < rows; ++i)
+                                               for (size_t j = 0; j < cols; ++j)
+                                               {
+                                                 TC &c = c_tile[i * ldc + j];
+                                                 c = beta_pc == TC{0} ? tile[i * nr + j]
+                                                                      : tile[i * nr + j] + beta_pc * c;
+                                               }
+                                         }
+
+                                         if constexpr (!std::is_null_pointer_v<Store>)
+                                         {
+                                           if (final_depth)
+                                             store(ic + ir, jc + jr, rows, cols,
+                                                   c_tile ? c_tile : tile, c_tile ? ldc : nr);
+                                         }
+                                       }
+                                     }
+                                   }
+                                 });
+            }
+          }
+        }
+
+        /**
+         * @brief Sums count lines of depth int8 values, wrapping: line l
+         * holds X[l * ld + p] if contiguous, X[p * ld + l] otherwise
+         */
+        void line_sums(const std::int8_t *X, size_t ld, bool contiguous, size_t count,
+                       size_t depth, std::uint32_t *sums)
+        {
+          if (contiguous)
+          {
+            for (size_t l = 0; l < count; ++l)
+            {
+              const std::int8_t *line = X + l * ld;
+              std::uint32_t sum = 0;
+              for (size_t p = 0; p < depth; ++p)
+                sum += static_cast<std::uint32_t>(line[p]);
+              sums[l] = sum;
+            }
+            return;
+          }
+
+          std::fill_n(sums, count, 0u);
+          for (size_t p = 0; p < depth; ++p)
+          {
+            const std::int8_t *row = X + p * ld;
+            for (size_t l = 0; l < count; ++l)
+              sums[l] += static_cast<std::uint32_t>(row[l]);
+          }
+        }
+
+        /**
+         * @struct Requantizer
+         * @brief Tile store of a quantized GEMM: turns finished int32 tiles
+         * into int8 through the zero-point corrections, the scales, the
+         * float epilogue and the quantization of C
+         */
+        struct Requantizer
+        {
+          const QuantParams &qa;
+          const QuantParams &qb;
+          const QuantParams &qc;
+          const std::uint32_t *row_sums;    ///< Of op(A); null when B has no zero points
+          const std::uint32_t *column_sums; ///< Of op(B); null when A has no zero points
+          std::uint32_t k;
+          const kernels::Epilogue<float> *epilogue;
+          std::int8_t *C;
+          size_t ldc;
+
+          void operator()(size_t i0, size_t j0, size_t rows, size_t cols,
+                          const std::int32_t *acc, size_t ld) const
+          {
+            const size_t inc_a = qa.channels() > 1 ? 1 : 0;
+            const size_t inc_b = qb.channels() > 1 ? 1 : 0;
+            const size_t inc_c = qc.channels() > 1 ? 1 : 0;
+
+            utils::Arena &arena = utils::scratch_arena();
+            utils::ArenaCheckpoint checkpoint(arena);
+            float *values = arena.allocate_array<float>(rows * cols);
+
+            for (size_t r = 0; r < rows; ++r)
+            {
+              const size_t i = i0 + r;
+              const float scale_a = qa.scale[i * inc_a];
+              const auto za = static_cast<std::uint32_t>(qa.zero_point[i * inc_a]);
+
+              for (size_t c = 0; c < cols; ++c)
+              {
+                const size_t j = j0 + c;
+
+                // sum((a - za) * (b - zb)) expanded around the raw product,
+                // in unsigned arithmetic so that it wraps like the product
+                auto value = static_cast<std::uint32_t>(acc[r * ld + c]);
+                if (column_sums)
+                  value -= za * column_sums[j];
+                if (row_sums)
+                {
+                  const auto zb = static_cast<std::uint32_t>(qb.zero_point[j * inc_b]);
+                  value -= zb * row_sums[i] - k * za * zb;
+                }
+
+                values[r * cols + c] = scale_a * qb.scale[j * inc_b] *
+                                       static_cast<float>(static_cast<std::int32_t>(value));
+              }
+            }
+
+            if (epilogue)
+              kernels::kernel_table<float>().epilogue(rows, cols, values, cols,
+                                                      offset_epilogue(*epilogue, i0, j0));
+
+            const kernels::ReducedKernelTable &table = kernels::reduced_kernel_table();
+            for (size_t r = 0; r < rows; ++r)
+              table.quantize_i8(cols, values + r * cols, qc.scale.data() + j0 * inc_c,
+                                qc.zero_point.data() + j0 * inc_c, inc_c, C + (i0 + r) * ldc + j0);
+          }
+        };
+
+        bool has_zero_point(const QuantParams &params)
+        {
+          return std::any_of(params.zero_point.begin(), params.zero_point.end(),
+                             [](std::int32_t z)
+                             { return z != 0; });
+        }
+      } // namespace
+
+      template <typename T>
+      void gemm_packed(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, T alpha,
+                       const T *A, size_t lda, const T *B, size_t ldb,
+                       T beta, T *C, size_t ldc,
+                       const kernels::Epilogue<T> *epilogue)
+      {
+        gemm_blocked(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+      }
+
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, float alpha,
+                      const core::BFloat16 *A, size_t lda, const core::BFloat16 *B, size_t ldb,
+                      float beta, float *C, size_t ldc)
+      {
+        gemm_blocked(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc,
+                     static_cast<const kernels::Epilogue<float> *>(nullptr));
+      }
+
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, float alpha,
+                      const core::Float16 *A, size_t lda, const core::Float16 *B, size_t ldb,
+                      float beta, float *C, size_t ldc)
+      {
+        gemm_blocked(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc,
+                     static_cast<const kernels::Epilogue<float> *>(nullptr));
+      }
+
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, std::int32_t alpha,
+                      const std::int8_t *A, size_t lda, const std::int8_t *B, size_t ldb,
+                      std::int32_t beta, std::int32_t *C, size_t ldc)
+      {
+        if (m == 0 || n == 0)
+          return;
+
+        if (alpha == 0 || k == 0)
+        {
+          scale_c(m, n, beta, C, ldc);
+          return;
+        }
+
+        gemm_grouped(kernels::reduced_kernel_table().gemm_i8,
+                     transa != BlasOperation::NoTrans, transb != BlasOperation::NoTrans,
+                     m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+      }
+
+      void gemm_requantized(BlasOperation transa, BlasOperation transb,
+                            size_t m, size_t n, size_t k,
+                            const std::int8_t *A, size_t lda, const QuantParams &qa,
+                            const std::int8_t *B, size_t ldb, const QuantParams &qb,
+                            std::int8_t *C, size_t ldc, const QuantParams &qc,
+                            const kernels::Epilogue<float> *epilogue)
+      {
+        if (m == 0 || n == 0)
+          return;
+
+        const bool ta = transa != BlasOperation::NoTrans;
+        const bool tb = transb != BlasOperation::NoTrans;
+
+        utils::Arena &arena = utils::scratch_arena();
+        utils::ArenaCheckpoint checkpoint(arena);
+
+        // The zero-point corrections need the sums of the rows of op(A)
+        // and of the columns of op(B), one pass over each operand
+        std::uint32_t *row_sums = nullptr;
+        std::uint32_t *column_sums = nullptr;
+        if (has_zero_point(qb))
+        {
+          row_sums = arena.allocate_array<std::uint32_t>(m);
+          line_sums(A, lda, !ta, m, k, row_sums);
+        }
+        if (has_zero_point(qa))
+        {
+          column_sums = arena.allocate_array<std::uint32_t>(n);
+          line_sums(B, ldb, tb, n, k, column_sums);
+        }
+
+        const Requantizer store{qa, qb, qc, row_sums, column_sums,
+                                static_cast<std::uint32_t>(k), epilogue, C, ldc};
+
+        if (k == 0)
+        {
+          // Every product is empty: one pass over C with zero sums
+          std::int32_t *zeros = arena.allocate_array<std::int32_t>(n);
+          std::fill_n(zeros, n, 0);
+          store(0, 0, m, n, zeros, 0);
+          return;
+        }
+
+        // Tiles are requantized from scratch when one depth block covers
+        // k; otherwise the partial sums of the earlier blocks need a home
+        const auto &kernel = kernels::reduced_kernel_table().gemm_i8;
+        std::int32_t *partial = k > kernel.kc ? arena.allocate_array<std::int32_t>(m * n) : nullptr;
+
+        gemm_grouped(kernel, ta, tb, m, n, k, std::int32_t{1}, A, lda, B, ldb,
+                     std::int32_t{0}, partial, n, store);
+      }
+
+      template <typename T>
+      void gemm_batched(BlasOperation transa, BlasOperation transb,
+                        size_t m, size_t n, size_t k, T alpha,
+                        size_t lda, size_t ldb, T beta, size_t ldc,
+                        const GemmBatch<T> &batch, size_t count)
+      {
+        if (count == 0 || m == 0 || n == 0)
+          return;
+
+        const size_t work = m * n * std::max<size_t>(k, 1);
+        const size_t grain = std::max<size_t>(1, GEMM_PARALLEL_MIN_WORK / work);
+
+        core::parallel_for(0, count, grain, [&](size_t begin, size_t end)
+                           {
+                             for (size_t i = begin; i < end; ++i)
+                               gemm_packed(transa, transb, m, n, k, alpha, batch.A(i), lda,
+                                           batch.B(i), ldb, beta, batch.C(i), ldc);
+                           });
+      }
+
+      template <typename T>
+      void gemm_epilogue(size_t m, size_t n, T *C, size_t ldc,
+                         const kernels::Epilogue<T> &epilogue)
+      {
+        const auto kernel = kernels::kernel_table<T>().epilogue;
+        const size_t grain = std::max<size_t>(1, EPILOGUE_GRAIN / std::max<size_t>(n, 1));
+
+        core::parallel_for(0, m, grain, [&](size_t begin, size_t end)
+                           { kernel(end - begin, n, C + begin * ldc, ldc, offset_epilogue(epilogue, begin, 0)); });
+      }
+
+      template void gemm_packed<float>(BlasOperation, BlasOperation,
+                                       size_t, size_t, size_t, float,
+                                       const float *, size_t, const float *, size_t,
+                                       float, float *, size_t, const kernels::Epilogue<float> *);
+
+      template void gemm_packed<double>(BlasOperation, BlasOperation,
+                                        size_t, size_t, size_t, double,
+                                        const double *, size_t, const double *, size_t,
+                                        double, double *, size_t, const kernels::Epilogue<double> *);
+
+      template void gemm_batched<float>(BlasOperation, BlasOperation,
+                                        size_t, size_t, size_t, float,
+                                        size_t, size_t, float, size_t,
+                                        const GemmBatch<float> &, size_t);
+
+      template void gemm_batched<double>(BlasOperation, BlasOperation,
+                                         size_t, size_t, size_t, double,
+                                         size_t, size_t, double, size_t,
+                                         const GemmBatch<double> &, size_t);
+
+      template void gemm_epilogue<float>(size_t, size_t, float *, size_t,
+                                         const kernels::Epilogue<float> &);
+
+      template void gemm_epilogue<double>(size_t, size_t, double *, size_t,
+                                          const kernels::Epilogue<double> &);
+    } // namespace detail
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <tf/math/blas.hpp>
+#include <tf/math/quantize.hpp>
+#include "math/kernels/kernels.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace detail
+    {
+      /**
+       * @brief Cache-blocked, packed GEMM on row-major matrices
+       *
+       * C = epilogue(alpha * op(A) * op(B) + beta * C)
+       *
+       * The micro-kernel and blocking sizes come from
+       * kernels::kernel_table<T>(). Dimensions are assumed to be validated
+       * by the caller. The epilogue, when given, is applied by the fused
+       * micro-kernel as the last depth block of each tile is stored; its
+       * bias pointers refer to the whole of C.
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      void gemm_packed(BlasOperation transa, BlasOperation transb,
+                       size_t m, size_t n, size_t k, T alpha,
+                       const T *A, size_t lda, const T *B, size_t ldb,
+                       T beta, T *C, size_t ldc,
+                       const kernels::Epilogue<T> *epilogue = nullptr);
+
+      /**
+       * @brief Mixed-precision GEMM on row-major matrices
+       *
+       * C = alpha * op(A) * op(B) + beta * C, with reduced-precision inputs
+       * and products accumulated in float (int32 for int8, wrapping on
+       * overflow). bfloat16 and half precision are widened to float while
+       * packing and run on the float micro-kernel (faster than vdpbf16ps,
+       * which issues at half the rate of FMA); int8 runs on the dot-product
+       * micro-kernel of kernels::reduced_kernel_table() (vpdpbusd on
+       * AVX-512 VNNI).
+       * Dimensions are assumed to be validated by the caller.
+       */
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, float alpha,
+                      const core::BFloat16 *A, size_t lda, const core::BFloat16 *B, size_t ldb,
+                      float beta, float *C, size_t ldc);
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, float alpha,
+                      const core::Float16 *A, size_t lda, const core::Float16 *B, size_t ldb,
+                      float beta, float *C, size_t ldc);
+      void gemm_mixed(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, std::int32_t alpha,
+                      const std::int8_t *A, size_t lda, const std::int8_t *B, size_t ldb,
+                      std::int32_t beta, std::int32_t *C, size_t ldc);
+
+      /**
+       * @brief Quantized GEMM with int8 output on row-major matrices
+       *
+       * Accumulates op(A) * op(B) in int32 on the int8 micro-kernel and
+       * hands every finished tile, while it is in cache, to a store that
+       * applies the zero-point corrections and scales, the epilogue (in
+       * float, on the real values) and the quantization to qc. Partial sums
+       * go through an m x n int32 scratch only when k spans more than one
+       * depth block. Parameters are assumed to be validated by the caller:
+       * qa has one channel or one per row, qb and qc one or one per column.
+       */
+      void gemm_requantized(BlasOperation transa, BlasOperation transb,
+                            size_t m, size_t n, size_t k,
+                            const std::int8_t *A, size_t lda, const QuantParams &qa,
+                            const std::int8_t *B, size_t ldb, const QuantParams &qb,
+                            std::int8_t *C, size_t ldc, const QuantParams &qc,
+                            const kernels::Epilogue<float> *epilogue);
+
+      /**
+       * @struct GemmBatch
+       * @brief Operands of a batch of GEMMs: pointer arrays, or base
+       * pointers and strides between consecutive matrices
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      struct GemmBatch
+      {
+        const T *const *a = nullptr; ///< Pointer array for A, or null to use a_base
+        const T *const *b = nullptr; ///< Pointer array for B, or null to use b_base
+        T *const *c = nullptr;       ///< Pointer array for C, or null to use c_base
+        const T *a_base = nullptr;
+        const T *b_base = nullptr;
+        T *c_base = nullptr;
+        size_t stride_a = 0;
+        size_t stride_b = 0;
+        size_t stride_c = 0;
+
+        const T *A(size_t i) const { return a ? a[i] : a_base + i * stride_a; }
+        const T *B(size_t i) const { return b ? b[i] : b_base + i * stride_b; }
+        T *C(size_t i) const { return c ? c[i] : c_base + i * stride_c; }
+      };
+
+      /**
+       * @brief Runs a batch of GEMMs of one shape on the built-in kernels
+       *
+       * Consecutive problems are grouped into chunks of at least
+       * GEMM_PARALLEL_MIN_WORK multiply-adds and the chunks are spread over
+       * the thread pool; a problem big enough to be parallel on its own
+       * also splits its rows (the pool runs nested loops).
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      void gemm_batched(BlasOperation transa, BlasOperation transb,
+                        size_t m, size_t n, size_t k, T alpha,
+                        size_t lda, size_t ldb, T beta, size_t ldc,
+                        const GemmBatch<T> &batch, size_t count);
+
+      /**
+       * @brief Applies an epilogue to an m x n matrix in place, in one pass
+       * split across the thread pool
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      void gemm_epilogue(size_t m, size_t n, T *C, size_t ldc,
+                         const kernels::Epilogue<T> &epilogue);
+    } // namespace detail
+  } // namespace math
+} // namespace tf
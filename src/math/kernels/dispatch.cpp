@@ -0,0 +1,145 @@
+#include "math/kernels/kernels.hpp"
+
+#include <tf/core/cpu.hpp>
+
+#include <algorithm>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace kernels
+    {
+      namespace
+      {
+        size_t round_down(size_t value, size_t multiple)
+        {
+          return std::max(multiple, value / multiple * multiple);
+        }
+
+        /**
+         * @brief Derives GEMM cache blocking from the host cache sizes
+         *
+         * A kc x nr micro-panel of B should stay in half of L1, an mc x kc
+         * block of A in half of L2 and a kc x nc block of B in half of L3.
+         *
+         * @param element Bytes per depth step of a packed row or column
+         */
+        template <typename Kernel>
+        void set_gemm_blocking(Kernel &gemm, size_t element)
+        {
+          const core::CpuFeatures &cpu = core::cpu_features();
+
+          size_t kc = cpu.l1d_cache_size / 2 / (gemm.nr * element);
+          gemm.kc = std::clamp<size_t>(round_down(kc, 8), 64, 512);
+
+          size_t mc = cpu.l2_cache_size / 2 / (gemm.kc * element);
+          gemm.mc = round_down(std::clamp<size_t>(mc, gemm.mr, 1024), gemm.mr);
+
+          size_t nc = cpu.l3_cache_size / 2 / (gemm.kc * element);
+          gemm.nc = round_down(std::clamp<size_t>(nc, gemm.nr, 4096), gemm.nr);
+        }
+
+        template <typename T>
+        const KernelTable<T> &isa_table(core::CpuIsa isa)
+        {
+          constexpr bool is_float = sizeof(T) == sizeof(float);
+
+          switch (isa)
+          {
+#if defined(__x86_64__) || defined(_M_X64)
+          case core::CpuIsa::AVX512:
+            if constexpr (is_float)
+              return avx512::table_f32();
+            else
+              return avx512::table_f64();
+          case core::CpuIsa::AVX2:
+            if constexpr (is_float)
+              return avx2::table_f32();
+            else
+              return avx2::table_f64();
+          case core::CpuIsa::SSE4:
+            if constexpr (is_float)
+              return sse4::table_f32();
+            else
+              return sse4::table_f64();
+#endif
+          default:
+            if constexpr (is_float)
+              return generic::table_f32();
+            else
+              return generic::table_f64();
+          }
+        }
+
+        template <typename T>
+        KernelTable<T> select_table()
+        {
+          KernelTable<T> table = isa_table<T>(core::cpu_isa());
+          set_gemm_blocking(table.gemm, sizeof(T));
+          return table;
+        }
+
+        const ReducedKernelTable &isa_reduced_table(core::CpuIsa isa)
+        {
+          switch (isa)
+          {
+#if defined(__x86_64__) || defined(_M_X64)
+          case core::CpuIsa::AVX512:
+            return avx512::table_reduced();
+          case core::CpuIsa::AVX2:
+            return avx2::table_reduced();
+          case core::CpuIsa::SSE4:
+            return sse4::table_reduced();
+#endif
+          default:
+            return generic::table_reduced();
+          }
+        }
+
+        ReducedKernelTable select_reduced_table()
+        {
+          const core::CpuIsa isa = core::cpu_isa();
+          ReducedKernelTable table = isa_reduced_table(isa);
+
+#if defined(__x86_64__) || defined(_M_X64)
+          // Every CPU with AVX-512 BF16 also has VNNI, which the dot
+          // kernels' TU is built with
+          const core::CpuFeatures &cpu = core::cpu_features();
+          if (isa == core::CpuIsa::AVX512 && cpu.avx512_vnni)
+          {
+            table.dot_i8 = &avx512_dot::dot_i8;
+            table.gemm_i8 = avx512_dot::gemm_i8();
+
+            if (cpu.avx512_bf16)
+              table.dot_bf16 = &avx512_dot::dot_bf16;
+          }
+#endif
+
+          set_gemm_blocking(table.gemm_i8, sizeof(std::int8_t));
+          return table;
+        }
+      } // namespace
+
+      template <>
+      const KernelTable<float> &kernel_table<float>()
+      {
+        static const KernelTable<float> table = select_table<float>();
+        return table;
+      }
+
+      template <>
+      const KernelTable<double> &kernel_table<double>()
+      {
+        static const KernelTable<double> table = select_table<double>();
+        return table;
+      }
+
+      const ReducedKernelTable &reduced_kernel_table()
+      {
+        static const ReducedKernelTable table = select_reduced_table();
+        return table;
+      }
+    } // namespace kernels
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace kernels
+    {
+      using std::size_t;
+
+      /**
+       * @enum EpilogueActivation
+       * @brief Activation applied by a GEMM epilogue
+       */
+      enum class EpilogueActivation
+      {
+        Identity,
+        Relu,
+        LeakyRelu,
+        Sigmoid,
+        Tanh
+      };
+
+      /**
+       * @struct Epilogue
+       * @brief Work applied to a tile of C after the product, before the
+       * tile is stored
+       *
+       * c = clamp(round(f(c + row_bias[i] + column_bias[j]) / quantum) *
+       * quantum, lower, upper), skipping every step that is not used. The
+       * bias pointers point at the first row and column of the tile.
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      struct Epilogue
+      {
+        const T *row_bias;             ///< One value per row of the tile, or null
+        const T *column_bias;          ///< One value per column of the tile, or null
+        EpilogueActivation activation; ///< f
+        T slope;                       ///< Slope of LeakyRelu below zero
+        T quantum;                     ///< Rounding step (ties to even), or 0
+        bool clamp;                    ///< Whether to clamp to [lower, upper]
+        T lower;
+        T upper;
+      };
+
+      /**
+       * @struct GemmKernel
+       * @brief Register-tiled micro-kernel together with its blocking sizes
+       *
+       * The micro-kernel computes an mr x nr tile of C from a packed
+       * micro-panel of A (kc x mr, column by column) and a packed
+       * micro-panel of B (kc x nr, row by row, cache-line aligned):
+       *
+       * C = alpha * A_panel * B_panel + beta * C
+       *
+       * When beta is zero, C is written without being read. The fused
+       * micro-kernel also applies an epilogue to the tile while it is still
+       * in registers.
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      struct GemmKernel
+      {
+        using micro_kernel_t = void (*)(size_t kc, const T *a, const T *b,
+                                        T *c, size_t ldc, T alpha, T beta);
+        using fused_kernel_t = void (*)(size_t kc, const T *a, const T *b,
+                                        T *c, size_t ldc, T alpha, T beta,
+                                        const Epilogue<T> &epilogue);
+
+        size_t mr; ///< Rows of the register tile
+        size_t nr; ///< Columns of the register tile
+        size_t mc; ///< Rows of A kept in L2 (multiple of mr)
+        size_t kc; ///< Depth of a packed panel kept in L1
+        size_t nc; ///< Columns of B kept in L3 (multiple of nr)
+        micro_kernel_t kernel;
+        fused_kernel_t fused;
+      };
+
+      /**
+       * @struct DotGemmKernel
+       * @brief Register-tiled micro-kernel for dot-product instructions
+       * that reduce several consecutive depth steps into each 32-bit lane
+       * (vpdpbusd: 4 int8 products, vpmaddwd: 2)
+       *
+       * Panels are packed in groups of that many depth steps, zero-padded:
+       * the A micro-panel holds ceil(kc / group) x mr x group values and
+       * the B micro-panel ceil(kc / group) x nr x group values. The kernel
+       * computes
+       *
+       * C = alpha * (A_panel * B_panel - offset) + beta * C
+       *
+       * where offset, unless null, holds one value per column of the tile.
+       * When beta is zero, C is written without being read.
+       *
+       * @tparam TA Packed element of A
+       * @tparam TB Packed element of B
+       * @tparam TC Accumulator and element of C
+       */
+      template <typename TA, typename TB, typename TC>
+      struct DotGemmKernel
+      {
+        using micro_kernel_t = void (*)(size_t groups, const TA *a, const TB *b,
+                                        const TC *offset, TC *c, size_t ldc,
+                                        TC alpha, TC beta);
+
+        size_t group; ///< Depth steps per lane
+        size_t mr;    ///< Rows of the register tile
+        size_t nr;    ///< Columns of the register tile
+        size_t mc;    ///< Rows of A kept in L2 (multiple of mr)
+        size_t kc;    ///< Depth of a packed panel kept in L1 (multiple of group)
+        size_t nc;    ///< Columns of B kept in L3 (multiple of nr)
+        micro_kernel_t kernel;
+      };
+
+      /**
+       * @brief Largest m, n and k of a GEMM handled by the fixed-size
+       * kernels
+       */
+      constexpr size_t SMALL_GEMM_MAX = 32;
+
+      /**
+       * @brief Number of fixed-size GEMM kernels: widths 4, 8, 16 and 32
+       */
+      constexpr size_t SMALL_GEMM_KERNELS = 4;
+
+      /**
+       * @struct KernelTable
+       * @brief Unit-stride kernels compiled for one instruction set
+       *
+       * @tparam T Data type
+       */
+      template <typename T>
+      struct KernelTable
+      {
+        const char *isa;
+
+        T (*dot)(size_t n, const T *x, const T *y);
+        void (*axpy)(size_t n, T alpha, const T *x, T *y);
+        void (*scal)(size_t n, T alpha, T *x);
+        T (*sumsq)(size_t n, const T *x);
+
+        // Elements [offset, offset + n) of the Philox4x32-10 stream
+        // (key, stream): uniform in [min, max), or normal (Box-Muller)
+        void (*random_uniform)(size_t n, T *x, T min, T max,
+                               std::uint64_t key, std::uint64_t stream, std::uint64_t offset);
+        void (*random_normal)(size_t n, T *x, T mean, T stddev,
+                              std::uint64_t key, std::uint64_t stream, std::uint64_t offset);
+
+        // Activations y = f(x) and, unless dy is null, dy = f'(x); x may
+        // alias y or dy
+        void (*sigmoid)(size_t n, const T *x, T *y, T *dy);
+        void (*tanh)(size_t n, const T *x, T *y, T *dy);
+        void (*relu)(size_t n, const T *x, T *y, T *dy);
+        void (*leaky_relu)(size_t n, const T *x, T *y, T *dy, T alpha);
+
+        // Softmax and log-softmax of one row; x may alias y
+        void (*softmax)(size_t n, const T *x, T *y);
+        void (*log_softmax)(size_t n, const T *x, T *y);
+
+        // Means and sums of squared deviations (and co-deviation) in one
+        // read of the data; column_moments reduces the rows of a row-major
+        // matrix into one entry per column
+        void (*moments)(size_t n, const T *x, T &mean, T &m2);
+        void (*comoments)(size_t n, const T *x, const T *y, T &mean_x, T &mean_y,
+                          T &m2_x, T &m2_y, T &c_xy);
+        void (*column_moments)(size_t rows, size_t cols, const T *x, size_t ld, T *mean, T *m2);
+
+        // z[i] = x[i * incx] op y[i * incy] with incx and incy 0 (repeat
+        // one value) or 1; z may alias a dense input
+        void (*add)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+        void (*subtract)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+        void (*multiply)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+        void (*divide)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+        void (*maximum)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+        void (*minimum)(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z);
+
+        // y = f(x) over a dense array; x may alias y
+        void (*negate)(size_t n, const T *x, T *y);
+        void (*abs)(size_t n, const T *x, T *y);
+        void (*sqrt)(size_t n, const T *x, T *y);
+        void (*square)(size_t n, const T *x, T *y);
+
+        // Applies a GEMM epilogue to a rows x cols block of C in place
+        void (*epilogue)(size_t rows, size_t cols, T *c, size_t ldc, const Epilogue<T> &epilogue);
+
+        // C = alpha * op(A) * op(B) + beta * C for m, k <= SMALL_GEMM_MAX,
+        // with op(A)[i][p] = a[i * a_row + p * a_col] and op(B)[p][j] =
+        // b[p * b_row + j * b_col]; entry w handles n <= 4 << w
+        void (*small_gemm[SMALL_GEMM_KERNELS])(size_t m, size_t n, size_t k, T alpha,
+                                               const T *a, size_t a_row, size_t a_col,
+                                               const T *b, size_t b_row, size_t b_col,
+                                               T beta, T *c, size_t ldc);
+
+        GemmKernel<T> gemm;
+      };
+
+      /**
+       * @struct ReducedKernelTable
+       * @brief Kernels on reduced-precision data, which is passed as raw
+       * bits: bfloat16 and IEEE half as std::uint16_t
+       *
+       * Products are accumulated in float, or in int32 for int8 (wrapping
+       * on overflow).
+       */
+      struct ReducedKernelTable
+      {
+        const char *isa;
+
+        // Conversions from and to float, rounding to nearest even
+        void (*bf16_to_f32)(size_t n, const std::uint16_t *x, float *y);
+        void (*f32_to_bf16)(size_t n, const float *x, std::uint16_t *y);
+        void (*f16_to_f32)(size_t n, const std::uint16_t *x, float *y);
+        void (*f32_to_f16)(size_t n, const float *x, std::uint16_t *y);
+
+        float (*dot_bf16)(size_t n, const std::uint16_t *x, const std::uint16_t *y);
+        float (*dot_f16)(size_t n, const std::uint16_t *x, const std::uint16_t *y);
+        std::int32_t (*dot_i8)(size_t n, const std::int8_t *x, const std::int8_t *y);
+
+        // Affine int8 quantization: y = clamp(round(x / scale) + zero_point)
+        // to [-128, 127] (NaN to -128) and x = (y - zero_point) * scale.
+        // scale and zero_point are read with increment inc, 0 (one pair for
+        // the whole run) or 1 (one pair per element)
+        void (*quantize_i8)(size_t n, const float *x, const float *scale,
+                            const std::int32_t *zero_point, size_t inc, std::int8_t *y);
+        void (*dequantize_i8)(size_t n, const std::int8_t *x, const float *scale,
+                              const std::int32_t *zero_point, size_t inc, float *y);
+
+        // int8 with A biased by 128 to be unsigned, in quadruples for
+        // vpdpbusd (pairs for vpmaddwd, single steps for portable code);
+        // the offset holds 128 times each column sum of B
+        DotGemmKernel<std::uint8_t, std::int8_t, std::int32_t> gemm_i8;
+      };
+
+      /**
+       * @brief Gets the kernel table for the host CPU
+       *
+       * The table is selected once, from core::cpu_isa(), on first use.
+       *
+       * @tparam T Data type (float or double)
+       * @return const KernelTable<T>& Kernels for the best supported ISA
+       */
+      template <typename T>
+      const KernelTable<T> &kernel_table();
+
+      /**
+       * @brief Gets the reduced-precision kernels for the host CPU
+       *
+       * These are the kernels of the selected ISA, with the dot products
+       * and GEMM micro-kernels replaced by AVX-512 BF16 and VNNI ones when
+       * that ISA is AVX-512 and the host has the extensions.
+       *
+       * @return const ReducedKernelTable& Kernels for the host
+       */
+      const ReducedKernelTable &reduced_kernel_table();
+
+#define TF_DECLARE_KERNEL_TABLES(isa)           \
+  namespace isa                                 \
+  {                                             \
+    const KernelTable<float> &table_f32();      \
+    const KernelTable<double> &table_f64();     \
+    const ReducedKernelTable &table_reduced();  \
+  }
+
+      // One set per translation unit built from kernels_impl.hpp
+      TF_DECLARE_KERNEL_TABLES(generic)
+      TF_DECLARE_KERNEL_TABLES(sse4)
+      TF_DECLARE_KERNEL_TABLES(avx2)
+      TF_DECLARE_KERNEL_TABLES(avx512)
+
+#undef TF_DECLARE_KERNEL_TABLES
+
+      // Built with AVX-512 BF16 and VNNI flags, from kernels_avx512_dot.cpp
+      namespace avx512_dot
+      {
+        float dot_bf16(size_t n, const std::uint16_t *x, const std::uint16_t *y);
+        std::int32_t dot_i8(size_t n, const std::int8_t *x, const std::int8_t *y);
+        DotGemmKernel<std::uint8_t, std::int8_t, std::int32_t> gemm_i8();
+      } // namespace avx512_dot
+    } // namespace kernels
+  } // namespace math
+} // namespace tf
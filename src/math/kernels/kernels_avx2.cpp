@@ -0,0 +1,6 @@
+// Built with AVX2 + FMA flags (see CMakeLists.txt).
+#if defined(__x86_64__) || defined(_M_X64)
+#define TF_KERNEL_NAMESPACE avx2
+#define TF_KERNEL_ISA_NAME "avx2"
+#include "math/kernels/kernels_impl.hpp"
+#endif
@@ -0,0 +1,6 @@
+// Built with AVX-512 F/DQ/BW/VL flags (see CMakeLists.txt).
+#if defined(__x86_64__) || defined(_M_X64)
+#define TF_KERNEL_NAMESPACE avx512
+#define TF_KERNEL_ISA_NAME "avx512"
+#include "math/kernels/kernels_impl.hpp"
+#endif
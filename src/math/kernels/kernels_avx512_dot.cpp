@@ -0,0 +1,159 @@
+// Dot-product kernels for AVX-512 BF16 (vdpbf16ps) and VNNI (vpdpbusd).
+//
+// Built with AVX-512 F/BW/VL plus BF16 and VNNI flags (see CMakeLists.txt)
+// and each kernel is only called when the host has its extension, so this
+// TU holds nothing but these kernels: like kernels_impl.hpp, it includes no
+// headers with inline code that could be shared with other TUs.
+#if defined(__x86_64__) || defined(_M_X64)
+#include "math/kernels/kernels.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+// See kernels_impl.hpp (GCC PR 105593)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace tf
+{
+  namespace math
+  {
+    namespace kernels
+    {
+      namespace avx512_dot
+      {
+        namespace
+        {
+          constexpr size_t MR = 12; ///< Rows of the register tile
+          constexpr size_t NV = 2;  ///< Vectors of 16 columns in the register tile
+
+          inline __m512bh as_bf16(__m512i v)
+          {
+            return (__m512bh)v;
+          }
+
+          /**
+           * @brief Broadcasts the 32-bit group at p to every lane
+           */
+          inline __m512i broadcast_group(const void *p)
+          {
+            std::int32_t group;
+            std::memcpy(&group, p, sizeof(group));
+            return _mm512_set1_epi32(group);
+          }
+
+          inline __mmask32 tail_mask32(size_t count)
+          {
+            return count >= 32 ? ~__mmask32{0} : static_cast<__mmask32>((1u << count) - 1u);
+          }
+
+          inline __mmask64 tail_mask64(size_t count)
+          {
+            return count >= 64 ? ~__mmask64{0} : static_cast<__mmask64>((std::uint64_t{1} << count) - 1u);
+          }
+
+          /**
+           * @brief 12 x 32 int8 tile: each step multiplies four unsigned
+           * (biased) depth values of a row by four signed values of 16
+           * columns
+           */
+          void i8_kernel(size_t groups, const std::uint8_t *a, const std::int8_t *b,
+                         const std::int32_t *offset, std::int32_t *c, size_t ldc,
+                         std::int32_t alpha, std::int32_t beta)
+          {
+            __m512i acc[MR][NV];
+            for (size_t i = 0; i < MR; ++i)
+              for (size_t v = 0; v < NV; ++v)
+                acc[i][v] = _mm512_setzero_si512();
+
+            for (size_t g = 0; g < groups; ++g, a += MR * 4, b += NV * 64)
+            {
+              __m512i bv[NV];
+              for (size_t v = 0; v < NV; ++v)
+                bv[v] = _mm512_loadu_si512(b + v * 64);
+
+              for (size_t i = 0; i < MR; ++i)
+              {
+                const __m512i av = broadcast_group(a + i * 4);
+                for (size_t v = 0; v < NV; ++v)
+                  acc[i][v] = _mm512_dpbusd_epi32(acc[i][v], av, bv[v]);
+              }
+            }
+
+            const __m512i va = _mm512_set1_epi32(alpha);
+            const __m512i vb = _mm512_set1_epi32(beta);
+            for (size_t i = 0; i < MR; ++i)
+              for (size_t v = 0; v < NV; ++v)
+              {
+                std::int32_t *out = c + i * ldc + v * 16;
+                __m512i r = acc[i][v];
+                if (offset)
+                  r = _mm512_sub_epi32(r, _mm512_loadu_si512(offset + v * 16));
+                if (alpha != 1)
+                  r = _mm512_mullo_epi32(r, va);
+                if (beta != 0)
+                  r = _mm512_add_epi32(r, _mm512_mullo_epi32(vb, _mm512_loadu_si512(out)));
+                _mm512_storeu_si512(out, r);
+              }
+          }
+        } // namespace
+
+        float dot_bf16(size_t n, const std::uint16_t *x, const std::uint16_t *y)
+        {
+          // Each lane accumulates the products of one pair of elements
+          __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+
+          size_t i = 0;
+          for (; i + 64 <= n; i += 64)
+          {
+            acc0 = _mm512_dpbf16_ps(acc0, as_bf16(_mm512_loadu_si512(x + i)),
+                                    as_bf16(_mm512_loadu_si512(y + i)));
+            acc1 = _mm512_dpbf16_ps(acc1, as_bf16(_mm512_loadu_si512(x + i + 32)),
+                                    as_bf16(_mm512_loadu_si512(y + i + 32)));
+          }
+
+          for (; i < n; i += 32)
+          {
+            const __mmask32 mask = tail_mask32(n - i);
+            acc0 = _mm512_dpbf16_ps(acc0, as_bf16(_mm512_maskz_loadu_epi16(mask, x + i)),
+                                    as_bf16(_mm512_maskz_loadu_epi16(mask, y + i)));
+          }
+
+          return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+        }
+
+        std::int32_t dot_i8(size_t n, const std::int8_t *x, const std::int8_t *y)
+        {
+          // x + 128 is unsigned, so sum((x + 128) * y) - 128 * sum(y) is
+          // the signed product; the sum of y comes from a dot with ones
+          const __m512i bias = _mm512_set1_epi8(static_cast<char>(0x80));
+          const __m512i ones = _mm512_set1_epi8(1);
+          __m512i acc = _mm512_setzero_si512(), sum = _mm512_setzero_si512();
+
+          for (size_t i = 0; i < n; i += 64)
+          {
+            const __mmask64 mask = tail_mask64(n - i);
+            const __m512i vx = _mm512_maskz_loadu_epi8(mask, x + i);
+            const __m512i vy = _mm512_maskz_loadu_epi8(mask, y + i);
+            acc = _mm512_dpbusd_epi32(acc, _mm512_xor_si512(vx, bias), vy);
+            sum = _mm512_dpbusd_epi32(sum, ones, vy);
+          }
+
+          const __m512i result = _mm512_sub_epi32(acc, _mm512_slli_epi32(sum, 7));
+          return _mm512_reduce_add_epi32(result);
+        }
+
+        DotGemmKernel<std::uint8_t, std::int8_t, std::int32_t> gemm_i8()
+        {
+          return {4, MR, NV * 16, 0, 0, 0, &i8_kernel};
+        }
+      } // namespace avx512_dot
+    } // namespace kernels
+  } // namespace math
+} // namespace tf
+#endif
@@ -0,0 +1,4 @@
+// Baseline build flags; also the NEON path on AArch64.
+#define TF_KERNEL_NAMESPACE generic
+#define TF_KERNEL_ISA_NAME "generic"
+#include "math/kernels/kernels_impl.hpp"
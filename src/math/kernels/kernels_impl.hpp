@@ -0,0 +1,2290 @@
+// Kernel implementations shared by every instruction set.
+//
+// This file is included by one small translation unit per ISA
+// (kernels_generic.cpp, kernels_sse4.cpp, ...), each of which is compiled
+// with its own target flags (see CMakeLists.txt) and defines:
+//
+//   TF_KERNEL_NAMESPACE  namespace the kernels are emitted into
+//   TF_KERNEL_ISA_NAME   name reported by KernelTable::isa
+//
+// The vector width is picked from the compiler's predefined ISA macros, so
+// the same code becomes SSE, AVX2, AVX-512 or NEON depending on the flags.
+//
+// Because the including TU is built with ISA flags that the host may not
+// support, only headers whose inline code is harmless to duplicate may be
+// included here: no standard containers, algorithms or streams.
+
+#if !defined(TF_KERNEL_NAMESPACE) || !defined(TF_KERNEL_ISA_NAME)
+#error "TF_KERNEL_NAMESPACE and TF_KERNEL_ISA_NAME must be defined"
+#endif
+
+#include "math/kernels/kernels.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX512F__) && defined(__GNUC__) && !defined(__clang__)
+// GCC 12's AVX-512 headers self-initialize placeholder registers, which
+// -Wuninitialized (or -Wmaybe-uninitialized, depending on the optimization
+// level) reports at every inlined use (GCC PR 105593).
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace tf
+{
+  namespace math
+  {
+    namespace kernels
+    {
+      namespace TF_KERNEL_NAMESPACE
+      {
+        namespace
+        {
+          /**
+           * @struct Vec
+           * @brief Minimal SIMD abstraction over the active instruction set
+           *
+           * Every specialization provides the same static interface, so the
+           * kernels below are written once against it. max(a, b) is
+           * a > b ? a : b (b when either is NaN), as on x86; pow2i(k) is 2^k
+           * for integral k in the normal exponent range.
+           */
+          template <typename T>
+          struct Vec;
+
+#if !defined(__AVX512F__) && !defined(__AVX2__) && !defined(__SSE2__) && !defined(_M_X64) && \
+    !(defined(__ARM_NEON) && defined(__aarch64__))
+          // Compiler builtins, so no libm wrapper is instantiated in this TU
+          inline float scalar_sqrt(float x) { return __builtin_sqrtf(x); }
+          inline double scalar_sqrt(double x) { return __builtin_sqrt(x); }
+          inline float scalar_abs(float x) { return __builtin_fabsf(x); }
+          inline double scalar_abs(double x) { return __builtin_fabs(x); }
+          inline float scalar_copysign(float x, float y) { return __builtin_copysignf(x, y); }
+          inline double scalar_copysign(double x, double y) { return __builtin_copysign(x, y); }
+#endif
+
+          /**
+           * @struct GemmTile
+           * @brief Register tile (mr rows x nv vectors) of the GEMM kernel
+           */
+          template <typename T>
+          struct GemmTile;
+
+#if defined(__AVX512F__)
+          template <>
+          struct Vec<float>
+          {
+            using reg = __m512;
+            using mask = __mmask16;
+            static constexpr size_t width = 16;
+            static reg zero() { return _mm512_setzero_ps(); }
+            static reg set1(float v) { return _mm512_set1_ps(v); }
+            static reg load(const float *p) { return _mm512_load_ps(p); }
+            static reg loadu(const float *p) { return _mm512_loadu_ps(p); }
+            static void storeu(float *p, reg v) { _mm512_storeu_ps(p, v); }
+            static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+            static reg sqrt(reg a) { return _mm512_sqrt_ps(a); }
+            static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+            static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+            static reg abs(reg a) { return _mm512_abs_ps(a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const __m512i mask = _mm512_set1_epi32(0x7fffffff);
+              // Bits of the magnitude where mask is set, of the sign elsewhere
+              return _mm512_castsi512_ps(_mm512_ternarylogic_epi32(
+                  mask, _mm512_castps_si512(magnitude), _mm512_castps_si512(sign), 0xca));
+            }
+            static mask less(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+            static reg select(mask m, reg a, reg b) { return _mm512_mask_blend_ps(m, b, a); }
+            static reg pow2i(reg k)
+            {
+              const __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(k), _mm512_set1_epi32(127));
+              return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+            }
+            static float reduce_add(reg v)
+            {
+              return _mm512_reduce_add_ps(v);
+            }
+          };
+
+          template <>
+          struct Vec<double>
+          {
+            using reg = __m512d;
+            using mask = __mmask8;
+            static constexpr size_t width = 8;
+            static reg zero() { return _mm512_setzero_pd(); }
+            static reg set1(double v) { return _mm512_set1_pd(v); }
+            static reg load(const double *p) { return _mm512_load_pd(p); }
+            static reg loadu(const double *p) { return _mm512_loadu_pd(p); }
+            static void storeu(double *p, reg v) { _mm512_storeu_pd(p, v); }
+            static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+            static reg sqrt(reg a) { return _mm512_sqrt_pd(a); }
+            static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+            static reg abs(reg a) { return _mm512_abs_pd(a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const __m512i mask = _mm512_set1_epi64(0x7fffffffffffffffll);
+              return _mm512_castsi512_pd(_mm512_ternarylogic_epi64(
+                  mask, _mm512_castpd_si512(magnitude), _mm512_castpd_si512(sign), 0xca));
+            }
+            static mask less(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+            static reg select(mask m, reg a, reg b) { return _mm512_mask_blend_pd(m, b, a); }
+            static reg pow2i(reg k)
+            {
+              const __m256i e = _mm256_add_epi32(_mm512_cvtpd_epi32(k), _mm256_set1_epi32(1023));
+              return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_cvtepu32_epi64(e), 52));
+            }
+            static double reduce_add(reg v)
+            {
+              return _mm512_reduce_add_pd(v);
+            }
+          };
+
+          template <>
+          struct GemmTile<float>
+          {
+            static constexpr size_t mr = 12, nv = 2;
+          };
+
+          template <>
+          struct GemmTile<double>
+          {
+            static constexpr size_t mr = 12, nv = 2;
+          };
+#elif defined(__AVX2__) && defined(__FMA__)
+          template <>
+          struct Vec<float>
+          {
+            using reg = __m256;
+            using mask = __m256;
+            static constexpr size_t width = 8;
+            static reg zero() { return _mm256_setzero_ps(); }
+            static reg set1(float v) { return _mm256_set1_ps(v); }
+            static reg load(const float *p) { return _mm256_load_ps(p); }
+            static reg loadu(const float *p) { return _mm256_loadu_ps(p); }
+            static void storeu(float *p, reg v) { _mm256_storeu_ps(p, v); }
+            static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+            static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+            static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+            static reg abs(reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const reg bit = _mm256_set1_ps(-0.0f);
+              return _mm256_or_ps(_mm256_andnot_ps(bit, magnitude), _mm256_and_ps(bit, sign));
+            }
+            static mask less(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            static reg select(mask m, reg a, reg b) { return _mm256_blendv_ps(b, a, m); }
+            static reg pow2i(reg k)
+            {
+              const __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127));
+              return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+            }
+            static float reduce_add(reg v)
+            {
+              __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+              s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+              s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+              return _mm_cvtss_f32(s);
+            }
+          };
+
+          template <>
+          struct Vec<double>
+          {
+            using reg = __m256d;
+            using mask = __m256d;
+            static constexpr size_t width = 4;
+            static reg zero() { return _mm256_setzero_pd(); }
+            static reg set1(double v) { return _mm256_set1_pd(v); }
+            static reg load(const double *p) { return _mm256_load_pd(p); }
+            static reg loadu(const double *p) { return _mm256_loadu_pd(p); }
+            static void storeu(double *p, reg v) { _mm256_storeu_pd(p, v); }
+            static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+            static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+            static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+            static reg abs(reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const reg bit = _mm256_set1_pd(-0.0);
+              return _mm256_or_pd(_mm256_andnot_pd(bit, magnitude), _mm256_and_pd(bit, sign));
+            }
+            static mask less(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+            static reg select(mask m, reg a, reg b) { return _mm256_blendv_pd(b, a, m); }
+            static reg pow2i(reg k)
+            {
+              const __m128i e = _mm_add_epi32(_mm256_cvtpd_epi32(k), _mm_set1_epi32(1023));
+              return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepu32_epi64(e), 52));
+            }
+            static double reduce_add(reg v)
+            {
+              __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+              return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+          };
+
+          template <>
+          struct GemmTile<float>
+          {
+            static constexpr size_t mr = 6, nv = 2;
+          };
+
+          template <>
+          struct GemmTile<double>
+          {
+            static constexpr size_t mr = 6, nv = 2;
+          };
+#elif defined(__SSE2__) || defined(_M_X64)
+          template <>
+          struct Vec<float>
+          {
+            using reg = __m128;
+            using mask = __m128;
+            static constexpr size_t width = 4;
+            static reg zero() { return _mm_setzero_ps(); }
+            static reg set1(float v) { return _mm_set1_ps(v); }
+            static reg load(const float *p) { return _mm_load_ps(p); }
+            static reg loadu(const float *p) { return _mm_loadu_ps(p); }
+            static void storeu(float *p, reg v) { _mm_storeu_ps(p, v); }
+            static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+            static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+            static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+            static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+            static reg abs(reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const reg bit = _mm_set1_ps(-0.0f);
+              return _mm_or_ps(_mm_andnot_ps(bit, magnitude), _mm_and_ps(bit, sign));
+            }
+            static mask less(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+            static reg select(mask m, reg a, reg b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+            static reg pow2i(reg k)
+            {
+              const __m128i e = _mm_add_epi32(_mm_cvtps_epi32(k), _mm_set1_epi32(127));
+              return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+            }
+            static float reduce_add(reg v)
+            {
+              __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+              s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+              return _mm_cvtss_f32(s);
+            }
+          };
+
+          template <>
+          struct Vec<double>
+          {
+            using reg = __m128d;
+            using mask = __m128d;
+            static constexpr size_t width = 2;
+            static reg zero() { return _mm_setzero_pd(); }
+            static reg set1(double v) { return _mm_set1_pd(v); }
+            static reg load(const double *p) { return _mm_load_pd(p); }
+            static reg loadu(const double *p) { return _mm_loadu_pd(p); }
+            static void storeu(double *p, reg v) { _mm_storeu_pd(p, v); }
+            static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+            static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+            static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+            static reg abs(reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              const reg bit = _mm_set1_pd(-0.0);
+              return _mm_or_pd(_mm_andnot_pd(bit, magnitude), _mm_and_pd(bit, sign));
+            }
+            static mask less(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+            static reg select(mask m, reg a, reg b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+            static reg pow2i(reg k)
+            {
+              // The biased exponents are positive, so zero-extending is enough
+              const __m128i e = _mm_add_epi32(_mm_cvtpd_epi32(k), _mm_set1_epi32(1023));
+              return _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(e, _mm_setzero_si128()), 52));
+            }
+            static double reduce_add(reg v)
+            {
+              return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+          };
+
+          template <>
+          struct GemmTile<float>
+          {
+            static constexpr size_t mr = 4, nv = 2;
+          };
+
+          template <>
+          struct GemmTile<double>
+          {
+            static constexpr size_t mr = 4, nv = 2;
+          };
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+          template <>
+          struct Vec<float>
+          {
+            using reg = float32x4_t;
+            using mask = uint32x4_t;
+            static constexpr size_t width = 4;
+            static reg zero() { return vdupq_n_f32(0.0f); }
+            static reg set1(float v) { return vdupq_n_f32(v); }
+            static reg load(const float *p) { return vld1q_f32(p); }
+            static reg loadu(const float *p) { return vld1q_f32(p); }
+            static void storeu(float *p, reg v) { vst1q_f32(p, v); }
+            static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+            static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return vfmaq_f32(c, a, b); }
+            static reg sqrt(reg a) { return vsqrtq_f32(a); }
+            static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+            static reg div(reg a, reg b) { return vdivq_f32(a, b); }
+            static reg max(reg a, reg b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+            static reg abs(reg a) { return vabsq_f32(a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              return vbslq_f32(vdupq_n_u32(0x7fffffffu), magnitude, sign);
+            }
+            static mask less(reg a, reg b) { return vcltq_f32(a, b); }
+            static reg select(mask m, reg a, reg b) { return vbslq_f32(m, a, b); }
+            static reg pow2i(reg k)
+            {
+              const int32x4_t e = vaddq_s32(vcvtq_s32_f32(k), vdupq_n_s32(127));
+              return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+            }
+            static float reduce_add(reg v) { return vaddvq_f32(v); }
+          };
+
+          template <>
+          struct Vec<double>
+          {
+            using reg = float64x2_t;
+            using mask = uint64x2_t;
+            static constexpr size_t width = 2;
+            static reg zero() { return vdupq_n_f64(0.0); }
+            static reg set1(double v) { return vdupq_n_f64(v); }
+            static reg load(const double *p) { return vld1q_f64(p); }
+            static reg loadu(const double *p) { return vld1q_f64(p); }
+            static void storeu(double *p, reg v) { vst1q_f64(p, v); }
+            static reg add(reg a, reg b) { return vaddq_f64(a, b); }
+            static reg mul(reg a, reg b) { return vmulq_f64(a, b); }
+            static reg fmadd(reg a, reg b, reg c) { return vfmaq_f64(c, a, b); }
+            static reg sqrt(reg a) { return vsqrtq_f64(a); }
+            static reg sub(reg a, reg b) { return vsubq_f64(a, b); }
+            static reg div(reg a, reg b) { return vdivq_f64(a, b); }
+            static reg max(reg a, reg b) { return vbslq_f64(vcgtq_f64(a, b), a, b); }
+            static reg abs(reg a) { return vabsq_f64(a); }
+            static reg copysign(reg magnitude, reg sign)
+            {
+              return vbslq_f64(vdupq_n_u64(0x7fffffffffffffffull), magnitude, sign);
+            }
+            static mask less(reg a, reg b) { return vcltq_f64(a, b); }
+            static reg select(mask m, reg a, reg b) { return vbslq_f64(m, a, b); }
+            static reg pow2i(reg k)
+            {
+              const int64x2_t e = vaddq_s64(vcvtq_s64_f64(k), vdupq_n_s64(1023));
+              return vreinterpretq_f64_s64(vshlq_n_s64(e, 52));
+            }
+            static double reduce_add(reg v) { return vaddvq_f64(v); }
+          };
+
+          template <>
+          struct GemmTile<float>
+          {
+            static constexpr size_t mr = 8, nv = 3;
+          };
+
+          template <>
+          struct GemmTile<double>
+          {
+            static constexpr size_t mr = 8, nv = 3;
+          };
+#else
+          template <typename T>
+          struct Vec
+          {
+            using reg = T;
+            using mask = bool;
+            static constexpr size_t width = 1;
+            static reg zero() { return T{0}; }
+            static reg set1(T v) { return v; }
+            static reg load(const T *p) { return *p; }
+            static reg loadu(const T *p) { return *p; }
+            static void storeu(T *p, reg v) { *p = v; }
+            static reg add(reg a, reg b) { return a + b; }
+            static reg mul(reg a, reg b) { return a * b; }
+            static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+            static reg sqrt(reg a) { return scalar_sqrt(a); }
+            static reg sub(reg a, reg b) { return a - b; }
+            static reg div(reg a, reg b) { return a / b; }
+            static reg max(reg a, reg b) { return a > b ? a : b; }
+            static reg abs(reg a) { return scalar_abs(a); }
+            static reg copysign(reg magnitude, reg sign) { return scalar_copysign(magnitude, sign); }
+            static mask less(reg a, reg b) { return a < b; }
+            static reg select(mask m, reg a, reg b) { return m ? a : b; }
+            static reg pow2i(reg k)
+            {
+              T result;
+              if constexpr (sizeof(T) == sizeof(float))
+              {
+                const uint32_t bits = static_cast<uint32_t>(static_cast<int>(k) + 127) << 23;
+                std::memcpy(&result, &bits, sizeof(T));
+              }
+              else
+              {
+                const uint64_t bits = static_cast<uint64_t>(static_cast<int>(k) + 1023) << 52;
+                std::memcpy(&result, &bits, sizeof(T));
+              }
+              return result;
+            }
+            static T reduce_add(reg v) { return v; }
+          };
+
+          template <typename T>
+          struct GemmTile
+          {
+            static constexpr size_t mr = 4, nv = 4;
+          };
+#endif
+
+          // Level 1 kernels (unit stride)
+          /**
+           * @brief Dot product with four independent accumulators
+           */
+          template <typename T>
+          T dot(size_t n, const T *x, const T *y)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+
+            typename V::reg acc0 = V::zero(), acc1 = V::zero();
+            typename V::reg acc2 = V::zero(), acc3 = V::zero();
+
+            size_t i = 0;
+            for (; i + 4 * W <= n; i += 4 * W)
+            {
+              acc0 = V::fmadd(V::loadu(x + i), V::loadu(y + i), acc0);
+              acc1 = V::fmadd(V::loadu(x + i + W), V::loadu(y + i + W), acc1);
+              acc2 = V::fmadd(V::loadu(x + i + 2 * W), V::loadu(y + i + 2 * W), acc2);
+              acc3 = V::fmadd(V::loadu(x + i + 3 * W), V::loadu(y + i + 3 * W), acc3);
+            }
+
+            for (; i + W <= n; i += W)
+              acc0 = V::fmadd(V::loadu(x + i), V::loadu(y + i), acc0);
+
+            T result = V::reduce_add(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+            for (; i < n; ++i)
+              result += x[i] * y[i];
+
+            return result;
+          }
+
+          /**
+           * @brief Sum of squares with four independent accumulators
+           */
+          template <typename T>
+          T sumsq(size_t n, const T *x)
+          {
+            return dot(n, x, x);
+          }
+
+          /**
+           * @brief y = alpha * x + y
+           */
+          template <typename T>
+          void axpy(size_t n, T alpha, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+            const typename V::reg va = V::set1(alpha);
+
+            size_t i = 0;
+            for (; i + 2 * W <= n; i += 2 * W)
+            {
+              V::storeu(y + i, V::fmadd(va, V::loadu(x + i), V::loadu(y + i)));
+              V::storeu(y + i + W, V::fmadd(va, V::loadu(x + i + W), V::loadu(y + i + W)));
+            }
+
+            for (; i + W <= n; i += W)
+              V::storeu(y + i, V::fmadd(va, V::loadu(x + i), V::loadu(y + i)));
+
+            for (; i < n; ++i)
+              y[i] += alpha * x[i];
+          }
+
+          /**
+           * @brief x = alpha * x
+           */
+          template <typename T>
+          void scal(size_t n, T alpha, T *x)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+            const typename V::reg va = V::set1(alpha);
+
+            size_t i = 0;
+            for (; i + 2 * W <= n; i += 2 * W)
+            {
+              V::storeu(x + i, V::mul(va, V::loadu(x + i)));
+              V::storeu(x + i + W, V::mul(va, V::loadu(x + i + W)));
+            }
+
+            for (; i + W <= n; i += W)
+              V::storeu(x + i, V::mul(va, V::loadu(x + i)));
+
+            for (; i < n; ++i)
+              x[i] *= alpha;
+          }
+
+          // Level 3 kernels
+          /**
+           * @brief Accumulates an MR x (NV * width) tile of A_panel * B_panel
+           * in vector registers
+           */
+          template <typename T, size_t MR, size_t NV>
+          inline void gemm_accumulate(size_t kc, const T *a, const T *b,
+                                      typename Vec<T>::reg (&acc)[MR][NV])
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+            constexpr size_t NR = NV * W;
+
+            for (size_t i = 0; i < MR; ++i)
+              for (size_t v = 0; v < NV; ++v)
+                acc[i][v] = V::zero();
+
+            for (size_t p = 0; p < kc; ++p)
+            {
+              Reg bv[NV];
+              for (size_t v = 0; v < NV; ++v)
+                bv[v] = V::load(b + v * W);
+
+              for (size_t i = 0; i < MR; ++i)
+              {
+                const Reg ai = V::set1(a[i]);
+                for (size_t v = 0; v < NV; ++v)
+                  acc[i][v] = V::fmadd(ai, bv[v], acc[i][v]);
+              }
+
+              a += MR;
+              b += NR;
+            }
+          }
+
+          /**
+           * @brief GEMM micro-kernel holding an MR x (NV * width) tile of C
+           * in vector registers
+           */
+          template <typename T, size_t MR, size_t NV>
+          void gemm_micro_kernel(size_t kc, const T *a, const T *b,
+                                 T *c, size_t ldc, T alpha, T beta)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            Reg acc[MR][NV];
+            gemm_accumulate<T, MR, NV>(kc, a, b, acc);
+
+            const Reg valpha = V::set1(alpha);
+            if (beta == T{0})
+            {
+              for (size_t i = 0; i < MR; ++i)
+                for (size_t v = 0; v < NV; ++v)
+                  V::storeu(c + i * ldc + v * W, V::mul(valpha, acc[i][v]));
+            }
+            else
+            {
+              const Reg vbeta = V::set1(beta);
+              for (size_t i = 0; i < MR; ++i)
+              {
+                for (size_t v = 0; v < NV; ++v)
+                {
+                  T *cp = c + i * ldc + v * W;
+                  V::storeu(cp, V::fmadd(valpha, acc[i][v], V::mul(vbeta, V::loadu(cp))));
+                }
+              }
+            }
+          }
+
+          /**
+           * @brief GEMM for m, k <= SMALL_GEMM_MAX and n <= N, with the
+           * width of C fixed at compile time
+           *
+           * op(B) is packed into an aligned stack panel padded to whole
+           * vectors, and four rows of C at a time are accumulated in
+           * registers; no scratch arena or blocking is involved.
+           */
+          template <typename T, size_t N>
+          void small_gemm(size_t m, size_t n, size_t k, T alpha,
+                          const T *a, size_t a_row, size_t a_col,
+                          const T *b, size_t b_row, size_t b_col,
+                          T beta, T *c, size_t ldc)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+            constexpr size_t NV = (N + W - 1) / W;
+            constexpr size_t NP = NV * W;
+            constexpr size_t MR = 4;
+
+            alignas(64) T panel[SMALL_GEMM_MAX * NP];
+            for (size_t p = 0; p < k; ++p)
+            {
+              T *row = panel + p * NP;
+              for (size_t j = 0; j < n; ++j)
+                row[j] = b[p * b_row + j * b_col];
+              for (size_t j = n; j < NP; ++j)
+                row[j] = T{0};
+            }
+
+            const Reg valpha = V::set1(alpha);
+            const Reg vbeta = V::set1(beta);
+
+            for (size_t i0 = 0; i0 < m; i0 += MR)
+            {
+              const size_t rows = m - i0 < MR ? m - i0 : MR;
+
+              // Rows past the edge repeat the last row and are discarded
+              const T *ar[MR];
+              for (size_t r = 0; r < MR; ++r)
+                ar[r] = a + (i0 + (r < rows ? r : rows - 1)) * a_row;
+
+              Reg acc[MR][NV];
+              for (size_t r = 0; r < MR; ++r)
+                for (size_t v = 0; v < NV; ++v)
+                  acc[r][v] = V::zero();
+
+              for (size_t p = 0; p < k; ++p)
+              {
+                Reg bv[NV];
+                for (size_t v = 0; v < NV; ++v)
+                  bv[v] = V::load(panel + p * NP + v * W);
+
+                for (size_t r = 0; r < MR; ++r)
+                {
+                  const Reg ai = V::set1(ar[r][p * a_col]);
+                  for (size_t v = 0; v < NV; ++v)
+                    acc[r][v] = V::fmadd(ai, bv[v], acc[r][v]);
+                }
+              }
+
+              for (size_t r = 0; r < rows; ++r)
+              {
+                T *cr = c + (i0 + r) * ldc;
+                if (n == NP)
+                {
+                  for (size_t v = 0; v < NV; ++v)
+                  {
+                    T *cp = cr + v * W;
+                    V::storeu(cp, beta == T{0} ? V::mul(valpha, acc[r][v])
+                                               : V::fmadd(valpha, acc[r][v], V::mul(vbeta, V::loadu(cp))));
+                  }
+                  continue;
+                }
+
+                T out[NP];
+                for (size_t v = 0; v < NV; ++v)
+                  V::storeu(out + v * W, V::mul(valpha, acc[r][v]));
+                for (size_t j = 0; j < n; ++j)
+                  cr[j] = beta == T{0} ? out[j] : out[j] + beta * cr[j];
+              }
+            }
+          }
+
+          // Random number kernels
+          //
+          // Element e of a stream is derived from Philox4x32-10 block
+          // e / P (P = 4 floats or 2 doubles per 128-bit block), so any
+          // range of a stream can be generated independently. The loops run
+          // over RNG_BATCH independent counters and vectorize with the
+          // flags of the including TU.
+
+          constexpr size_t RNG_BATCH = 16;
+          constexpr uint32_t PHILOX_M0 = 0xD2511F53u;
+          constexpr uint32_t PHILOX_M1 = 0xCD9E8D57u;
+          constexpr uint32_t PHILOX_W0 = 0x9E3779B9u;
+          constexpr uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+          /**
+           * @brief Philox4x32-10 of RNG_BATCH consecutive counters
+           *
+           * Counter j is (block + j, stream) as two 64-bit halves; word q of
+           * its output is stored in w[q][j].
+           */
+          inline void philox_batch(uint64_t key, uint64_t stream, uint64_t block,
+                                   uint32_t w[4][RNG_BATCH])
+          {
+            for (size_t j = 0; j < RNG_BATCH; ++j)
+            {
+              const uint64_t counter = block + j;
+              w[0][j] = static_cast<uint32_t>(counter);
+              w[1][j] = static_cast<uint32_t>(counter >> 32);
+              w[2][j] = static_cast<uint32_t>(stream);
+              w[3][j] = static_cast<uint32_t>(stream >> 32);
+            }
+
+            const uint32_t k0 = static_cast<uint32_t>(key);
+            const uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+            for (size_t j = 0; j < RNG_BATCH; ++j)
+            {
+              uint32_t c0 = w[0][j], c1 = w[1][j], c2 = w[2][j], c3 = w[3][j];
+
+              for (uint32_t round = 0; round < 10; ++round)
+              {
+                const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+                const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+
+                c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ (k0 + round * PHILOX_W0);
+                c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ (k1 + round * PHILOX_W1);
+                c1 = static_cast<uint32_t>(p1);
+                c3 = static_cast<uint32_t>(p0);
+              }
+
+              w[0][j] = c0;
+              w[1][j] = c1;
+              w[2][j] = c2;
+              w[3][j] = c3;
+            }
+          }
+
+          /**
+           * @brief Uniform in [0, 1) (or (0, 1] when open_low) from random bits
+           */
+          inline float unit_float(uint32_t w, bool open_low = false)
+          {
+            return static_cast<float>((w >> 8) + (open_low ? 1u : 0u)) * 0x1p-24f;
+          }
+
+          inline double unit_double(uint32_t hi, uint32_t lo, bool open_low = false)
+          {
+            const uint64_t bits = ((static_cast<uint64_t>(hi) << 32) | lo) >> 11;
+            return static_cast<double>(bits + (open_low ? 1u : 0u)) * 0x1p-53;
+          }
+
+          template <typename T>
+          struct FloatBits;
+
+          template <>
+          struct FloatBits<float>
+          {
+            using type = uint32_t;
+            static constexpr int mantissa = 23;
+            static constexpr type half_exponent = 0x3f000000u;
+            static constexpr int log_terms = 5;
+            static constexpr int sin_terms = 5;
+          };
+
+          template <>
+          struct FloatBits<double>
+          {
+            using type = uint64_t;
+            static constexpr int mantissa = 52;
+            static constexpr type half_exponent = 0x3fe0000000000000ull;
+            static constexpr int log_terms = 11;
+            static constexpr int sin_terms = 9;
+          };
+
+          /**
+           * @brief Natural logarithm of a positive normal number
+           *
+           * x = 2^e * m with m in [sqrt(1/2), sqrt(2)), and
+           * log(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| < 0.172.
+           */
+          template <typename T>
+          inline T log_positive(T x)
+          {
+            using Bits = FloatBits<T>;
+            using U = typename Bits::type;
+            constexpr U mantissa_mask = (U{1} << Bits::mantissa) - 1;
+
+            U bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            T e = static_cast<T>(static_cast<int>(bits >> Bits::mantissa)) -
+                  static_cast<T>((1 << (8 * sizeof(T) - Bits::mantissa - 2)) - 2);
+
+            bits = (bits & mantissa_mask) | Bits::half_exponent;
+            T m;
+            std::memcpy(&m, &bits, sizeof(T));
+
+            // m is in [1/2, 1); move it around 1
+            const bool low = m < T(0.70710678118654752440);
+            m = low ? m + m : m;
+            e = low ? e - T{1} : e;
+
+            const T s = (m - T{1}) / (m + T{1});
+            const T s2 = s * s;
+
+            T p = T{1} / T(2 * Bits::log_terms - 1);
+            for (int i = Bits::log_terms - 2; i >= 0; --i)
+              p = p * s2 + T{1} / T(2 * i + 1);
+
+            return T{2} * s * p + e * T(0.69314718055994530942);
+          }
+
+          /**
+           * @brief sin and cos of 2 pi u for u in [0, 1)
+           *
+           * The angle is reduced to a quarter turn index and a remainder
+           * in [-pi/4, pi/4], where Taylor polynomials converge quickly.
+           */
+          template <typename T>
+          inline void sincos_turn(T u, T &sin_out, T &cos_out)
+          {
+            constexpr int terms = FloatBits<T>::sin_terms;
+
+            const T t = u * T{4};
+            const int k = static_cast<int>(t + T(0.5));
+            const T a = (t - static_cast<T>(k)) * T(1.57079632679489661923);
+            const T a2 = a * a;
+
+            // 1/(2i+1)! and 1/(2i)!, highest order first
+            T sp = T{1}, cp = T{1};
+            for (int i = terms - 1; i >= 1; --i)
+            {
+              sp = T{1} - a2 * sp * (T{1} / T((2 * i) * (2 * i + 1)));
+              cp = T{1} - a2 * cp * (T{1} / T((2 * i - 1) * (2 * i)));
+            }
+            const T s = a * sp;
+            const T c = cp;
+
+            const int q = k & 3;
+            sin_out = q == 0 ? s : q == 1 ? c : q == 2 ? -s : -c;
+            cos_out = q == 0 ? c : q == 1 ? -s : q == 2 ? -c : s;
+          }
+
+          /**
+           * @brief Values of RNG_BATCH consecutive blocks, in element order
+           */
+          template <typename T, bool Normal>
+          void random_batch(uint64_t key, uint64_t stream, uint64_t block,
+                            T a, T b, T *out)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+            constexpr bool is_float = sizeof(T) == sizeof(float);
+            constexpr size_t PER_BLOCK = is_float ? 4 : 2;
+            constexpr size_t COUNT = RNG_BATCH * PER_BLOCK;
+
+            uint32_t w[4][RNG_BATCH];
+            philox_batch(key, stream, block, w);
+
+            if constexpr (!Normal)
+            {
+              const T scale = b - a;
+              for (size_t j = 0; j < RNG_BATCH; ++j)
+              {
+                if constexpr (is_float)
+                {
+                  for (size_t q = 0; q < 4; ++q)
+                    out[j * 4 + q] = a + scale * unit_float(w[q][j]);
+                }
+                else
+                {
+                  out[j * 2] = a + scale * unit_double(w[0][j], w[1][j]);
+                  out[j * 2 + 1] = a + scale * unit_double(w[2][j], w[3][j]);
+                }
+              }
+            }
+            else
+            {
+              // Box-Muller: every pair of uniforms gives two normals
+              constexpr size_t PAIRS = COUNT / 2;
+              T radius[PAIRS], turn[PAIRS];
+
+              for (size_t j = 0; j < RNG_BATCH; ++j)
+              {
+                if constexpr (is_float)
+                {
+                  radius[2 * j] = unit_float(w[0][j], true);
+                  turn[2 * j] = unit_float(w[1][j]);
+                  radius[2 * j + 1] = unit_float(w[2][j], true);
+                  turn[2 * j + 1] = unit_float(w[3][j]);
+                }
+                else
+                {
+                  radius[j] = unit_double(w[0][j], w[1][j], true);
+                  turn[j] = unit_double(w[2][j], w[3][j]);
+                }
+              }
+
+              for (size_t m = 0; m < PAIRS; ++m)
+                radius[m] = T{-2} * log_positive(radius[m]);
+
+              for (size_t m = 0; m + W <= PAIRS; m += W)
+                V::storeu(radius + m, V::sqrt(V::loadu(radius + m)));
+
+              for (size_t m = 0; m < PAIRS; ++m)
+              {
+                T s, c;
+                sincos_turn(turn[m], s, c);
+                const T r = b * radius[m];
+                out[2 * m] = a + r * c;
+                out[2 * m + 1] = a + r * s;
+              }
+            }
+          }
+
+          /**
+           * @brief Writes elements [offset, offset + n) of a random stream
+           *
+           * Uniform values are in [a, b); normal values have mean a and
+           * standard deviation b.
+           */
+          template <typename T, bool Normal>
+          void random_fill(size_t n, T *x, T a, T b,
+                           uint64_t key, uint64_t stream, uint64_t offset)
+          {
+            constexpr size_t PER_BLOCK = sizeof(T) == sizeof(float) ? 4 : 2;
+            constexpr size_t COUNT = RNG_BATCH * PER_BLOCK;
+
+            uint64_t block = offset / PER_BLOCK;
+            size_t skip = static_cast<size_t>(offset % PER_BLOCK);
+
+            alignas(64) T buffer[COUNT];
+            while (n > 0)
+            {
+              if (skip == 0 && n >= COUNT)
+              {
+                random_batch<T, Normal>(key, stream, block, a, b, x);
+                x += COUNT;
+                n -= COUNT;
+              }
+              else
+              {
+                random_batch<T, Normal>(key, stream, block, a, b, buffer);
+                size_t take = COUNT - skip < n ? COUNT - skip : n;
+                for (size_t i = 0; i < take; ++i)
+                  x[i] = buffer[skip + i];
+
+                x += take;
+                n -= take;
+                skip = 0;
+              }
+
+              block += RNG_BATCH;
+            }
+          }
+
+          template <typename T>
+          void random_uniform(size_t n, T *x, T min, T max,
+                              uint64_t key, uint64_t stream, uint64_t offset)
+          {
+            random_fill<T, false>(n, x, min, max, key, stream, offset);
+          }
+
+          template <typename T>
+          void random_normal(size_t n, T *x, T mean, T stddev,
+                             uint64_t key, uint64_t stream, uint64_t offset)
+          {
+            random_fill<T, true>(n, x, mean, stddev, key, stream, offset);
+          }
+
+          // Activation kernels
+          //
+          // exp is evaluated as 2^k * (1 + q): k = round(x / ln 2), the
+          // remainder r = x - k ln 2 (Cody-Waite, |r| <= ln 2 / 2) goes
+          // through a Taylor polynomial, and 2^k is assembled in the
+          // exponent field. Keeping q separate gives expm1 for free, which
+          // tanh needs near zero. Every function only needs exp of
+          // non-positive arguments.
+
+          template <typename T>
+          struct ExpConstants;
+
+          template <>
+          struct ExpConstants<float>
+          {
+            static constexpr float lowest = -87.3365f; // exp(lowest) is normal
+            static constexpr float round_magic = 0x1.8p23f;
+            static constexpr float ln2_hi = 0x1.62e4p-1f; // k * ln2_hi is exact
+            static constexpr float ln2_lo = 0x1.7f7d1cp-20f;
+            static constexpr int terms = 7;
+          };
+
+          template <>
+          struct ExpConstants<double>
+          {
+            static constexpr double lowest = -708.3964;
+            static constexpr double round_magic = 0x1.8p52;
+            static constexpr double ln2_hi = 0x1.62e42feep-1;
+            static constexpr double ln2_lo = 0x1.a39ef35793c76p-33;
+            static constexpr int terms = 13;
+          };
+
+          constexpr double reciprocal_factorial(int n)
+          {
+            double f = 1.0;
+            for (int i = 2; i <= n; ++i)
+              f *= i;
+            return 1.0 / f;
+          }
+
+          /**
+           * @brief sum_{i=I}^{N} r^(i-I) / i!, by Horner's rule
+           */
+          template <typename T, int I, int N>
+          inline typename Vec<T>::reg exp_tail(typename Vec<T>::reg r)
+          {
+            using V = Vec<T>;
+            if constexpr (I == N)
+              return V::set1(T(reciprocal_factorial(N)));
+            else
+              return V::fmadd(exp_tail<T, I + 1, N>(r), r, V::set1(T(reciprocal_factorial(I))));
+          }
+
+          /**
+           * @brief exp(x) = scale * (1 + q) for x <= 0
+           *
+           * scale is zero when exp(x) is below the smallest normal number.
+           */
+          template <typename T>
+          inline void exp_parts(typename Vec<T>::reg x, typename Vec<T>::reg &scale,
+                                typename Vec<T>::reg &q)
+          {
+            using V = Vec<T>;
+            using C = ExpConstants<T>;
+
+            const typename V::mask tiny = V::less(x, V::set1(C::lowest));
+            x = V::max(V::set1(C::lowest), x);
+
+            const typename V::reg magic = V::set1(C::round_magic);
+            const typename V::reg k = V::sub(V::fmadd(x, V::set1(T(1.44269504088896340736)), magic), magic);
+            const typename V::reg r = V::fmadd(k, V::set1(-C::ln2_lo),
+                                               V::fmadd(k, V::set1(-C::ln2_hi), x));
+
+            q = V::fmadd(V::mul(r, r), exp_tail<T, 2, C::terms>(r), r);
+            scale = V::select(tiny, V::zero(), V::pow2i(k));
+          }
+
+          /**
+           * @brief Applies op(x, y, dy) vector by vector
+           *
+           * The tail goes through a padded buffer, so every element is
+           * computed the same way. x may alias y or dy.
+           */
+          template <typename T, typename Op>
+          inline void activation_loop(size_t n, const T *x, T *y, T *dy, Op op)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+            typename V::reg out, derivative;
+
+            size_t i = 0;
+            for (; i + W <= n; i += W)
+            {
+              op(V::loadu(x + i), out, derivative);
+              V::storeu(y + i, out);
+              if (dy)
+                V::storeu(dy + i, derivative);
+            }
+
+            if (i < n)
+            {
+              T in[W] = {}, out_tail[W], derivative_tail[W];
+              std::memcpy(in, x + i, (n - i) * sizeof(T));
+
+              op(V::loadu(in), out, derivative);
+              V::storeu(out_tail, out);
+              V::storeu(derivative_tail, derivative);
+
+              std::memcpy(y + i, out_tail, (n - i) * sizeof(T));
+              if (dy)
+                std::memcpy(dy + i, derivative_tail, (n - i) * sizeof(T));
+            }
+          }
+
+          /**
+           * @brief out = 1 / (1 + exp(-v)), derivative = out (1 - out)
+           *
+           * With e = exp(-|v|), out = 1 / (1 + e) for v >= 0 and e / (1 + e)
+           * otherwise, and derivative = e / (1 + e)^2, so neither side
+           * cancels.
+           */
+          template <typename T>
+          inline void sigmoid_vec(typename Vec<T>::reg v, typename Vec<T>::reg &out,
+                                  typename Vec<T>::reg &derivative)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+
+            Reg scale, q;
+            exp_parts<T>(V::sub(V::zero(), V::abs(v)), scale, q);
+            const Reg e = V::fmadd(scale, q, scale);
+
+            const Reg s = V::div(V::set1(T{1}), V::add(V::set1(T{1}), e));
+            const Reg es = V::mul(e, s);
+            out = V::select(V::less(v, V::zero()), es, s);
+            derivative = V::mul(es, s);
+          }
+
+          /**
+           * @brief out = tanh(v), derivative = 1 - out^2
+           *
+           * With e = exp(-2|v|), tanh(|v|) = -expm1(-2|v|) / (1 + e) and
+           * derivative = 4 e / (1 + e)^2.
+           */
+          template <typename T>
+          inline void tanh_vec(typename Vec<T>::reg v, typename Vec<T>::reg &out,
+                               typename Vec<T>::reg &derivative)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+
+            Reg scale, q;
+            exp_parts<T>(V::mul(V::set1(T{-2}), V::abs(v)), scale, q);
+            const Reg e = V::fmadd(scale, q, scale);
+            const Reg em1 = V::fmadd(scale, q, V::sub(scale, V::set1(T{1})));
+
+            const Reg s = V::div(V::set1(T{1}), V::add(V::set1(T{1}), e));
+            out = V::copysign(V::mul(V::sub(V::zero(), em1), s), v);
+            derivative = V::mul(V::mul(V::set1(T{4}), e), V::mul(s, s));
+          }
+
+          /**
+           * @brief y = 1 / (1 + exp(-x)), dy = y (1 - y)
+           */
+          template <typename T>
+          void sigmoid(size_t n, const T *x, T *y, T *dy)
+          {
+            using Reg = typename Vec<T>::reg;
+
+            activation_loop(n, x, y, dy, [](Reg v, Reg &out, Reg &derivative)
+                            { sigmoid_vec<T>(v, out, derivative); });
+          }
+
+          /**
+           * @brief y = tanh(x), dy = 1 - y^2
+           */
+          template <typename T>
+          void tanh(size_t n, const T *x, T *y, T *dy)
+          {
+            using Reg = typename Vec<T>::reg;
+
+            activation_loop(n, x, y, dy, [](Reg v, Reg &out, Reg &derivative)
+                            { tanh_vec<T>(v, out, derivative); });
+          }
+
+          /**
+           * @brief y = max(x, 0), dy = 1 for x > 0 and 0 otherwise
+           */
+          template <typename T>
+          void relu(size_t n, const T *x, T *y, T *dy)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+
+            activation_loop(n, x, y, dy, [](Reg v, Reg &out, Reg &derivative)
+                            {
+                              const typename V::mask positive = V::less(V::zero(), v);
+                              out = V::select(positive, v, V::zero());
+                              derivative = V::select(positive, V::set1(T{1}), V::zero()); });
+          }
+
+          /**
+           * @brief y = x for x > 0 and alpha x otherwise, dy = 1 or alpha
+           */
+          template <typename T>
+          void leaky_relu(size_t n, const T *x, T *y, T *dy, T alpha)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            const Reg valpha = V::set1(alpha);
+
+            activation_loop(n, x, y, dy, [valpha](Reg v, Reg &out, Reg &derivative)
+                            {
+                              const typename V::mask positive = V::less(V::zero(), v);
+                              out = V::select(positive, v, V::mul(valpha, v));
+                              derivative = V::select(positive, V::set1(T{1}), valpha); });
+          }
+
+          // GEMM epilogue kernels
+          //
+          // Applied to a tile of C before it is stored: by
+          // gemm_fused_kernel to full register tiles, and by gemm_epilogue
+          // to edge tiles and to results of an external BLAS.
+
+          /**
+           * @brief Rounds to the nearest integer, ties to even
+           *
+           * Adding and subtracting 2^(digits - 1) leaves no fraction bits;
+           * larger magnitudes are integers already.
+           */
+          template <typename T>
+          inline typename Vec<T>::reg round_even(typename Vec<T>::reg v)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+
+            const Reg big = V::set1(T{1} / std::numeric_limits<T>::epsilon());
+            const Reg magnitude = V::abs(v);
+            const Reg rounded = V::sub(V::add(magnitude, big), big);
+            return V::select(V::less(magnitude, big), V::copysign(rounded, v), v);
+          }
+
+          /**
+           * @brief Applies the activation, rounding and clamping of an
+           * epilogue to one vector (bias already added)
+           */
+          template <typename T>
+          inline typename Vec<T>::reg epilogue_vec(typename Vec<T>::reg v, const Epilogue<T> &epilogue)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            Reg derivative;
+
+            switch (epilogue.activation)
+            {
+            case EpilogueActivation::Identity:
+              break;
+            case EpilogueActivation::Relu:
+              v = V::select(V::less(V::zero(), v), v, V::zero());
+              break;
+            case EpilogueActivation::LeakyRelu:
+              v = V::select(V::less(V::zero(), v), v, V::mul(V::set1(epilogue.slope), v));
+              break;
+            case EpilogueActivation::Sigmoid:
+              sigmoid_vec<T>(v, v, derivative);
+              break;
+            case EpilogueActivation::Tanh:
+              tanh_vec<T>(v, v, derivative);
+              break;
+            }
+
+            if (epilogue.quantum != T{0})
+            {
+              const Reg quantum = V::set1(epilogue.quantum);
+              v = V::mul(round_even<T>(V::div(v, quantum)), quantum);
+            }
+
+            if (epilogue.clamp)
+            {
+              // NaN stays NaN
+              const Reg upper = V::set1(epilogue.upper);
+              v = V::max(V::set1(epilogue.lower), V::select(V::less(upper, v), upper, v));
+            }
+
+            return v;
+          }
+
+          /**
+           * @brief gemm_micro_kernel followed by an epilogue applied to the
+           * tile before it leaves the registers
+           */
+          template <typename T, size_t MR, size_t NV>
+          void gemm_fused_kernel(size_t kc, const T *a, const T *b,
+                                 T *c, size_t ldc, T alpha, T beta,
+                                 const Epilogue<T> &epilogue)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            Reg acc[MR][NV];
+            gemm_accumulate<T, MR, NV>(kc, a, b, acc);
+
+            const Reg valpha = V::set1(alpha);
+            const Reg vbeta = V::set1(beta);
+            const bool biased = epilogue.row_bias || epilogue.column_bias;
+
+            for (size_t i = 0; i < MR; ++i)
+            {
+              const Reg row = epilogue.row_bias ? V::set1(epilogue.row_bias[i]) : V::zero();
+              for (size_t v = 0; v < NV; ++v)
+              {
+                T *cp = c + i * ldc + v * W;
+                Reg r = beta == T{0} ? V::mul(valpha, acc[i][v])
+                                     : V::fmadd(valpha, acc[i][v], V::mul(vbeta, V::loadu(cp)));
+                if (biased)
+                {
+                  const Reg bias = epilogue.column_bias
+                                       ? V::add(row, V::loadu(epilogue.column_bias + v * W))
+                                       : row;
+                  r = V::add(r, bias);
+                }
+                V::storeu(cp, epilogue_vec<T>(r, epilogue));
+              }
+            }
+          }
+
+          /**
+           * @brief Applies an epilogue to a rows x cols block of C in place
+           *
+           * Row tails go through a padded buffer, so every element is
+           * computed as in the fused micro-kernel.
+           */
+          template <typename T>
+          void gemm_epilogue(size_t rows, size_t cols, T *c, size_t ldc, const Epilogue<T> &epilogue)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            const bool biased = epilogue.row_bias || epilogue.column_bias;
+            for (size_t i = 0; i < rows; ++i)
+            {
+              T *row = c + i * ldc;
+              const Reg rb = epilogue.row_bias ? V::set1(epilogue.row_bias[i]) : V::zero();
+              auto apply = [&](Reg v, const T *column_bias)
+              {
+                if (biased)
+                  v = V::add(v, column_bias ? V::add(rb, V::loadu(column_bias)) : rb);
+                return epilogue_vec<T>(v, epilogue);
+              };
+
+              size_t j = 0;
+              for (; j + W <= cols; j += W)
+                V::storeu(row + j, apply(V::loadu(row + j),
+                                         epilogue.column_bias ? epilogue.column_bias + j : nullptr));
+
+              if (j < cols)
+              {
+                T in[W] = {}, bias[W] = {}, out[W];
+                std::memcpy(in, row + j, (cols - j) * sizeof(T));
+                if (epilogue.column_bias)
+                  std::memcpy(bias, epilogue.column_bias + j, (cols - j) * sizeof(T));
+
+                V::storeu(out, apply(V::loadu(in), epilogue.column_bias ? bias : nullptr));
+                std::memcpy(row + j, out, (cols - j) * sizeof(T));
+              }
+            }
+          }
+
+          // Softmax kernels
+          //
+          // One pass keeps a running maximum m and a running sum of
+          // exp(x - m) per lane ("online softmax"); a block of four vectors
+          // shares one rescaling of the sum, so the pass costs about 1.25
+          // exp per element. A second pass writes the outputs.
+
+          /**
+           * @brief exp(x) for x <= 0 (zero below the smallest normal number)
+           */
+          template <typename T>
+          inline typename Vec<T>::reg exp_nonpositive(typename Vec<T>::reg x)
+          {
+            typename Vec<T>::reg scale, q;
+            exp_parts<T>(x, scale, q);
+            return Vec<T>::fmadd(scale, q, scale);
+          }
+
+          /**
+           * @brief Maximum and sum of exp(x - max) of a row
+           */
+          template <typename T>
+          inline void softmax_stats(size_t n, const T *x, T &max_out, T &sum_out)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            // The running maximum starts finite, so leading -inf entries
+            // (masked positions) never produce inf - inf
+            constexpr T lowest = sizeof(T) == sizeof(float) ? T(-0x1.fffffep127) : T(-0x1.fffffffffffffp1023);
+            Reg m = V::set1(lowest), sum = V::zero();
+
+            size_t i = 0;
+            for (; i + 4 * W <= n; i += 4 * W)
+            {
+              const Reg x0 = V::loadu(x + i), x1 = V::loadu(x + i + W);
+              const Reg x2 = V::loadu(x + i + 2 * W), x3 = V::loadu(x + i + 3 * W);
+
+              const Reg next = V::max(m, V::max(V::max(x0, x1), V::max(x2, x3)));
+              sum = V::mul(sum, exp_nonpositive<T>(V::sub(m, next)));
+              m = next;
+
+              const Reg e01 = V::add(exp_nonpositive<T>(V::sub(x0, m)), exp_nonpositive<T>(V::sub(x1, m)));
+              const Reg e23 = V::add(exp_nonpositive<T>(V::sub(x2, m)), exp_nonpositive<T>(V::sub(x3, m)));
+              sum = V::add(sum, V::add(e01, e23));
+            }
+
+            for (; i < n; i += W)
+            {
+              // The tail is padded with -inf, which adds nothing
+              T tail[W];
+              const T *p = x + i;
+              if (i + W > n)
+              {
+                for (size_t j = 0; j < W; ++j)
+                  tail[j] = i + j < n ? x[i + j] : T(-__builtin_huge_val());
+                p = tail;
+              }
+
+              const Reg v = V::loadu(p);
+              const Reg next = V::max(m, v);
+              sum = V::fmadd(sum, exp_nonpositive<T>(V::sub(m, next)), exp_nonpositive<T>(V::sub(v, next)));
+              m = next;
+            }
+
+            // Combine the lanes
+            T lanes[W];
+            V::storeu(lanes, m);
+            T row_max = lanes[0];
+            for (size_t j = 1; j < W; ++j)
+              row_max = lanes[j] > row_max ? lanes[j] : row_max;
+
+            max_out = row_max;
+            sum_out = V::reduce_add(V::mul(sum, exp_nonpositive<T>(V::sub(m, V::set1(row_max)))));
+          }
+
+          /**
+           * @brief y = exp(x - max) / sum(exp(x - max)) over one row
+           */
+          template <typename T>
+          void softmax(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            T row_max, sum;
+            softmax_stats(n, x, row_max, sum);
+
+            const typename V::reg vmax = V::set1(row_max);
+            const typename V::reg inv = V::set1(T{1} / sum);
+            activation_loop(n, x, y, static_cast<T *>(nullptr),
+                            [&](typename V::reg v, typename V::reg &out, typename V::reg &)
+                            { out = V::mul(exp_nonpositive<T>(V::sub(v, vmax)), inv); });
+          }
+
+          /**
+           * @brief y = x - max - log(sum(exp(x - max))) over one row
+           */
+          template <typename T>
+          void log_softmax(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            T row_max, sum;
+            softmax_stats(n, x, row_max, sum);
+
+            // Compiler builtin, so no libm wrapper is instantiated in this TU
+            const T log_sum = sizeof(T) == sizeof(float) ? T(__builtin_logf(static_cast<float>(sum)))
+                                                         : T(__builtin_log(static_cast<double>(sum)));
+            const typename V::reg shift = V::set1(row_max + log_sum);
+            activation_loop(n, x, y, static_cast<T *>(nullptr),
+                            [&](typename V::reg v, typename V::reg &out, typename V::reg &)
+                            { out = V::sub(v, shift); });
+          }
+
+          // Elementwise kernels
+          //
+          // Binary kernels read each input either as a dense row (inc 1) or
+          // as one value repeated over the row (inc 0, a broadcast), so a
+          // bias or a per-row scale never has to be expanded. The output is
+          // dense and may alias an input of the same layout.
+
+          /**
+           * @brief z = op(x, y), with x and/or y repeated when BX / BY
+           */
+          template <bool BX, bool BY, typename T, typename Op>
+          inline void binary_lanes(size_t n, const T *x, const T *y, T *z, Op op)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            const Reg rx = BX ? V::set1(x[0]) : V::zero();
+            const Reg ry = BY ? V::set1(y[0]) : V::zero();
+
+            size_t i = 0;
+            for (; i + 2 * W <= n; i += 2 * W)
+            {
+              V::storeu(z + i, op(BX ? rx : V::loadu(x + i), BY ? ry : V::loadu(y + i)));
+              V::storeu(z + i + W, op(BX ? rx : V::loadu(x + i + W), BY ? ry : V::loadu(y + i + W)));
+            }
+
+            for (; i + W <= n; i += W)
+              V::storeu(z + i, op(BX ? rx : V::loadu(x + i), BY ? ry : V::loadu(y + i)));
+
+            if (i < n)
+            {
+              T a[W] = {}, b[W] = {}, c[W];
+              for (size_t j = 0; j < n - i; ++j)
+              {
+                a[j] = BX ? x[0] : x[i + j];
+                b[j] = BY ? y[0] : y[i + j];
+              }
+
+              V::storeu(c, op(V::loadu(a), V::loadu(b)));
+              std::memcpy(z + i, c, (n - i) * sizeof(T));
+            }
+          }
+
+          template <typename T, typename Op>
+          inline void binary_loop(size_t n, const T *x, size_t incx, const T *y, size_t incy,
+                                  T *z, Op op)
+          {
+            if (incx == 0 && incy == 0)
+              binary_lanes<true, true>(n, x, y, z, op);
+            else if (incx == 0)
+              binary_lanes<true, false>(n, x, y, z, op);
+            else if (incy == 0)
+              binary_lanes<false, true>(n, x, y, z, op);
+            else
+              binary_lanes<false, false>(n, x, y, z, op);
+          }
+
+          template <typename T>
+          void add(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::add(a, b); });
+          }
+
+          template <typename T>
+          void subtract(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::sub(a, b); });
+          }
+
+          template <typename T>
+          void multiply(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::mul(a, b); });
+          }
+
+          template <typename T>
+          void divide(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::div(a, b); });
+          }
+
+          template <typename T>
+          void maximum(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::max(a, b); });
+          }
+
+          template <typename T>
+          void minimum(size_t n, const T *x, size_t incx, const T *y, size_t incy, T *z)
+          {
+            using V = Vec<T>;
+            binary_loop(n, x, incx, y, incy, z, [](typename V::reg a, typename V::reg b)
+                        { return V::select(V::less(a, b), a, b); });
+          }
+
+          /**
+           * @brief y = op(x) over a dense array; x may alias y
+           */
+          template <typename T, typename Op>
+          inline void unary_loop(size_t n, const T *x, T *y, Op op)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+
+            size_t i = 0;
+            for (; i + W <= n; i += W)
+              V::storeu(y + i, op(V::loadu(x + i)));
+
+            if (i < n)
+            {
+              T in[W] = {}, out[W];
+              std::memcpy(in, x + i, (n - i) * sizeof(T));
+              V::storeu(out, op(V::loadu(in)));
+              std::memcpy(y + i, out, (n - i) * sizeof(T));
+            }
+          }
+
+          template <typename T>
+          void negate(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            unary_loop(n, x, y, [](typename V::reg v)
+                       { return V::sub(V::zero(), v); });
+          }
+
+          template <typename T>
+          void absolute(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            unary_loop(n, x, y, [](typename V::reg v)
+                       { return V::abs(v); });
+          }
+
+          template <typename T>
+          void square_root(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            unary_loop(n, x, y, [](typename V::reg v)
+                       { return V::sqrt(v); });
+          }
+
+          template <typename T>
+          void square(size_t n, const T *x, T *y)
+          {
+            using V = Vec<T>;
+            unary_loop(n, x, y, [](typename V::reg v)
+                       { return V::mul(v, v); });
+          }
+
+          // Reduced-precision kernels
+          //
+          // The scalar conversions repeat those of tf/core/half.hpp on raw
+          // bits, so no inline function built with this TU's flags can be
+          // picked by the linker for another TU.
+
+          inline float bits_to_float(std::uint32_t bits)
+          {
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+          }
+
+          inline std::uint32_t float_to_bits(float value)
+          {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+          }
+
+          inline float bf16_to_float(std::uint16_t x)
+          {
+            return bits_to_float(static_cast<std::uint32_t>(x) << 16);
+          }
+
+          inline std::uint16_t float_to_bf16(float x)
+          {
+            const std::uint32_t bits = float_to_bits(x);
+            if ((bits & 0x7fffffffu) > 0x7f800000u)
+              return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+            return static_cast<std::uint16_t>((bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16);
+          }
+
+          inline float half_to_float(std::uint16_t x)
+          {
+            const std::uint32_t sign = static_cast<std::uint32_t>(x & 0x8000u) << 16;
+            const std::uint32_t exponent = (x >> 10) & 0x1fu;
+            const std::uint32_t mantissa = x & 0x3ffu;
+
+            if (exponent == 0x1fu)
+              return bits_to_float(sign | 0x7f800000u | (mantissa << 13));
+            if (exponent == 0)
+              return bits_to_float(sign | float_to_bits(static_cast<float>(mantissa) * 0x1p-24f));
+            return bits_to_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+          }
+
+          inline std::uint16_t float_to_half(float x)
+          {
+            const std::uint32_t bits = float_to_bits(x);
+            const std::uint32_t sign = (bits >> 16) & 0x8000u;
+            const std::uint32_t magnitude = bits & 0x7fffffffu;
+
+            std::uint32_t half;
+            if (magnitude > 0x7f800000u)
+              half = 0x7e00u;
+            else if (magnitude >= 0x477ff000u)
+              half = 0x7c00u;
+            else if (magnitude < 0x38800000u)
+              half = float_to_bits(bits_to_float(magnitude) + 0.5f) - 0x3f000000u;
+            else
+              half = (magnitude + 0xc8000fffu + ((magnitude >> 13) & 1u)) >> 13;
+
+            return static_cast<std::uint16_t>(sign | half);
+          }
+
+          void bf16_to_f32(size_t n, const std::uint16_t *x, float *y)
+          {
+            for (size_t i = 0; i < n; ++i)
+              y[i] = bf16_to_float(x[i]);
+          }
+
+          void f32_to_bf16(size_t n, const float *x, std::uint16_t *y)
+          {
+            for (size_t i = 0; i < n; ++i)
+              y[i] = float_to_bf16(x[i]);
+          }
+
+          void f16_to_f32(size_t n, const std::uint16_t *x, float *y)
+          {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+              _mm512_storeu_ps(y + i, _mm512_cvtph_ps(_mm256_loadu_si256(
+                                          reinterpret_cast<const __m256i *>(x + i))));
+#elif defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+              _mm256_storeu_ps(y + i, _mm256_cvtph_ps(_mm_loadu_si128(
+                                          reinterpret_cast<const __m128i *>(x + i))));
+#endif
+            for (; i < n; ++i)
+              y[i] = half_to_float(x[i]);
+          }
+
+          void f32_to_f16(size_t n, const float *x, std::uint16_t *y)
+          {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + i),
+                                  _mm512_cvtps_ph(_mm512_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i),
+                               _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+            for (; i < n; ++i)
+              y[i] = float_to_half(x[i]);
+          }
+
+          /**
+           * @brief Dot product of reduced-precision vectors, widened to
+           * float one L1-sized block at a time
+           */
+          template <void (*Widen)(size_t, const std::uint16_t *, float *)>
+          float widened_dot(size_t n, const std::uint16_t *x, const std::uint16_t *y)
+          {
+            constexpr size_t BLOCK = 512;
+            alignas(64) float xb[BLOCK];
+            alignas(64) float yb[BLOCK];
+
+            float result = 0.0f;
+            for (size_t i = 0; i < n; i += BLOCK)
+            {
+              const size_t count = n - i < BLOCK ? n - i : BLOCK;
+              Widen(count, x + i, xb);
+              Widen(count, y + i, yb);
+              result += dot<float>(count, xb, yb);
+            }
+            return result;
+          }
+
+          std::int32_t dot_i8(size_t n, const std::int8_t *x, const std::int8_t *y)
+          {
+            // Unsigned, so overflow wraps as documented instead of being UB
+            std::uint32_t result = 0;
+            for (size_t i = 0; i < n; ++i)
+              result += static_cast<std::uint32_t>(static_cast<std::int32_t>(x[i]) * y[i]);
+            return static_cast<std::int32_t>(result);
+          }
+
+          /**
+           * @brief Rounds to an integer in the current rounding mode (to
+           * nearest even by default), like the vector conversions
+           */
+          inline std::int32_t round_to_int(float x)
+          {
+#if defined(__SSE2__) || defined(_M_X64)
+            return _mm_cvtss_si32(_mm_set_ss(x));
+#else
+            return static_cast<std::int32_t>(__builtin_nearbyintf(x));
+#endif
+          }
+
+          inline std::int8_t quantize_value(float x, float scale, std::int32_t zero_point)
+          {
+            // Clamped before rounding so the conversion cannot overflow; the
+            // bounds are integers, so this equals clamping afterwards. NaN
+            // fails the first test and lands on the lower bound, as max_ps
+            // returns its second operand.
+            const float lower = static_cast<float>(-128 - zero_point);
+            const float upper = static_cast<float>(127 - zero_point);
+            float v = x / scale;
+            v = v > lower ? v : lower;
+            v = v < upper ? v : upper;
+            return static_cast<std::int8_t>(round_to_int(v) + zero_point);
+          }
+
+          template <bool PerElement>
+          void quantize_run(size_t n, const float *x, const float *scale,
+                            const std::int32_t *zero_point, std::int8_t *y)
+          {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+              const __m512 s = PerElement ? _mm512_loadu_ps(scale + i) : _mm512_set1_ps(*scale);
+              const __m512i z = PerElement ? _mm512_loadu_si512(zero_point + i)
+                                           : _mm512_set1_epi32(*zero_point);
+              const __m512 lower = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_set1_epi32(-128), z));
+              const __m512 upper = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_set1_epi32(127), z));
+
+              __m512 v = _mm512_div_ps(_mm512_loadu_ps(x + i), s);
+              v = _mm512_min_ps(_mm512_max_ps(v, lower), upper);
+              const __m512i q = _mm512_add_epi32(_mm512_cvtps_epi32(v), z);
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i), _mm512_cvtepi32_epi8(q));
+            }
+#elif defined(__AVX2__)
+            for (; i + 8 <= n; i += 8)
+            {
+              const __m256 s = PerElement ? _mm256_loadu_ps(scale + i) : _mm256_set1_ps(*scale);
+              const __m256i z = PerElement
+                                    ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(zero_point + i))
+                                    : _mm256_set1_epi32(*zero_point);
+              const __m256 lower = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_set1_epi32(-128), z));
+              const __m256 upper = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_set1_epi32(127), z));
+
+              __m256 v = _mm256_div_ps(_mm256_loadu_ps(x + i), s);
+              v = _mm256_min_ps(_mm256_max_ps(v, lower), upper);
+              const __m256i q = _mm256_add_epi32(_mm256_cvtps_epi32(v), z);
+
+              // In range, so the saturating packs are plain narrowing
+              __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+              _mm_storel_epi64(reinterpret_cast<__m128i *>(y + i), _mm_packs_epi16(w, w));
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            for (; i + 4 <= n; i += 4)
+            {
+              const __m128 s = PerElement ? _mm_loadu_ps(scale + i) : _mm_set1_ps(*scale);
+              const __m128i z = PerElement
+                                    ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(zero_point + i))
+                                    : _mm_set1_epi32(*zero_point);
+              const __m128 lower = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(-128), z));
+              const __m128 upper = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(127), z));
+
+              __m128 v = _mm_div_ps(_mm_loadu_ps(x + i), s);
+              v = _mm_min_ps(_mm_max_ps(v, lower), upper);
+              const __m128i q = _mm_add_epi32(_mm_cvtps_epi32(v), z);
+
+              __m128i w = _mm_packs_epi32(q, q);
+              const std::int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(w, w));
+              std::memcpy(y + i, &bytes, sizeof(bytes));
+            }
+#endif
+            for (; i < n; ++i)
+              y[i] = quantize_value(x[i], scale[PerElement ? i : 0], zero_point[PerElement ? i : 0]);
+          }
+
+          template <bool PerElement>
+          void dequantize_run(size_t n, const std::int8_t *x, const float *scale,
+                              const std::int32_t *zero_point, float *y)
+          {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+              const __m512 s = PerElement ? _mm512_loadu_ps(scale + i) : _mm512_set1_ps(*scale);
+              const __m512i z = PerElement ? _mm512_loadu_si512(zero_point + i)
+                                           : _mm512_set1_epi32(*zero_point);
+              const __m512i q = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i)));
+              _mm512_storeu_ps(y + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(q, z)), s));
+            }
+#elif defined(__AVX2__)
+            for (; i + 8 <= n; i += 8)
+            {
+              const __m256 s = PerElement ? _mm256_loadu_ps(scale + i) : _mm256_set1_ps(*scale);
+              const __m256i z = PerElement
+                                    ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(zero_point + i))
+                                    : _mm256_set1_epi32(*zero_point);
+              const __m256i q = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(x + i)));
+              _mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(q, z)), s));
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            for (; i + 4 <= n; i += 4)
+            {
+              const __m128 s = PerElement ? _mm_loadu_ps(scale + i) : _mm_set1_ps(*scale);
+              const __m128i z = PerElement
+                                    ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(zero_point + i))
+                                    : _mm_set1_epi32(*zero_point);
+
+              // Each byte repeated through its lane, then shifted down with
+              // its sign
+              std::int32_t bytes;
+              std::memcpy(&bytes, x + i, sizeof(bytes));
+              __m128i q = _mm_cvtsi32_si128(bytes);
+              q = _mm_unpacklo_epi16(_mm_unpacklo_epi8(q, q), _mm_unpacklo_epi8(q, q));
+              q = _mm_srai_epi32(q, 24);
+              _mm_storeu_ps(y + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(q, z)), s));
+            }
+#endif
+            for (; i < n; ++i)
+            {
+              const size_t c = PerElement ? i : 0;
+              y[i] = static_cast<float>(x[i] - zero_point[c]) * scale[c];
+            }
+          }
+
+          void quantize_i8(size_t n, const float *x, const float *scale,
+                           const std::int32_t *zero_point, size_t inc, std::int8_t *y)
+          {
+            if (inc == 0)
+              quantize_run<false>(n, x, scale, zero_point, y);
+            else
+              quantize_run<true>(n, x, scale, zero_point, y);
+          }
+
+          void dequantize_i8(size_t n, const std::int8_t *x, const float *scale,
+                             const std::int32_t *zero_point, size_t inc, float *y)
+          {
+            if (inc == 0)
+              dequantize_run<false>(n, x, scale, zero_point, y);
+            else
+              dequantize_run<true>(n, x, scale, zero_point, y);
+          }
+
+#if defined(__AVX2__)
+          // vpmaddwd multiplies pairs of int16 and adds each pair into an
+          // int32 lane, so A and B are packed in pairs of depth steps
+          constexpr size_t I8_GROUP = 2, I8_MR = 6;
+#else
+          constexpr size_t I8_GROUP = 1, I8_MR = 4;
+#endif
+          constexpr size_t I8_NR = 16;
+
+          /**
+           * @brief int8 micro-kernel without VNNI, over the DotGemmKernel
+           * layout with groups of I8_GROUP depth steps (A biased by 128)
+           */
+          void gemm_i8_kernel(size_t groups, const std::uint8_t *a, const std::int8_t *b,
+                              const std::int32_t *offset, std::int32_t *c, size_t ldc,
+                              std::int32_t alpha, std::int32_t beta)
+          {
+            // Unsigned, so overflow wraps as documented instead of being UB
+            std::uint32_t acc[I8_MR][I8_NR];
+
+#if defined(__AVX2__)
+            __m256i sum[I8_MR][2];
+            for (size_t i = 0; i < I8_MR; ++i)
+              sum[i][0] = sum[i][1] = _mm256_setzero_si256();
+
+            for (size_t g = 0; g < groups; ++g, a += I8_MR * 2, b += I8_NR * 2)
+            {
+              // Columns 0-7 and 8-15, two depth steps each, widened to int16
+              const __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+              const __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 16)));
+
+              for (size_t i = 0; i < I8_MR; ++i)
+              {
+                const __m256i av = _mm256_set1_epi32(static_cast<int>(a[2 * i] | (a[2 * i + 1] << 16)));
+                sum[i][0] = _mm256_add_epi32(sum[i][0], _mm256_madd_epi16(av, b0));
+                sum[i][1] = _mm256_add_epi32(sum[i][1], _mm256_madd_epi16(av, b1));
+              }
+            }
+
+            for (size_t i = 0; i < I8_MR; ++i)
+            {
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc[i]), sum[i][0]);
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc[i] + 8), sum[i][1]);
+            }
+#else
+            for (size_t i = 0; i < I8_MR; ++i)
+              for (size_t j = 0; j < I8_NR; ++j)
+                acc[i][j] = 0;
+
+            for (size_t p = 0; p < groups; ++p, a += I8_MR, b += I8_NR)
+              for (size_t i = 0; i < I8_MR; ++i)
+              {
+                const std::int32_t ai = a[i];
+                for (size_t j = 0; j < I8_NR; ++j)
+                  acc[i][j] += static_cast<std::uint32_t>(ai * b[j]);
+              }
+#endif
+
+            for (size_t i = 0; i < I8_MR; ++i)
+              for (size_t j = 0; j < I8_NR; ++j)
+              {
+                std::uint32_t value = acc[i][j];
+                if (offset)
+                  value -= static_cast<std::uint32_t>(offset[j]);
+                value *= static_cast<std::uint32_t>(alpha);
+                if (beta != 0)
+                  value += static_cast<std::uint32_t>(beta) * static_cast<std::uint32_t>(c[i * ldc + j]);
+                c[i * ldc + j] = static_cast<std::int32_t>(value);
+              }
+          }
+
+          // Statistics kernels
+          //
+          // Data is read once, in blocks small enough to stay in L1: a block
+          // is summed for its mean, its squared deviations are summed on the
+          // second (cached) read, and the block is merged into the running
+          // result with the update of Chan et al. This is as stable as
+          // Welford's per-element update but has no division per element.
+
+          constexpr size_t MOMENT_BLOCK = 512;
+          constexpr size_t MOMENT_ROWS = 32;
+
+          /**
+           * @brief Merges (count_b, mean_b, m2_b) into (count_a, mean, m2)
+           */
+          template <typename T>
+          inline void chan_merge(size_t count_a, T &mean, T &m2, size_t count_b, T mean_b, T m2_b)
+          {
+            const T n = static_cast<T>(count_a + count_b);
+            const T delta = mean_b - mean;
+            mean += delta * (static_cast<T>(count_b) / n);
+            m2 += m2_b + delta * delta * (static_cast<T>(count_a) * static_cast<T>(count_b) / n);
+          }
+
+          /**
+           * @brief Sum of a block with four independent accumulators
+           */
+          template <typename T>
+          inline T block_sum(size_t n, const T *x)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+
+            typename V::reg acc0 = V::zero(), acc1 = V::zero();
+            typename V::reg acc2 = V::zero(), acc3 = V::zero();
+
+            size_t i = 0;
+            for (; i + 4 * W <= n; i += 4 * W)
+            {
+              acc0 = V::add(acc0, V::loadu(x + i));
+              acc1 = V::add(acc1, V::loadu(x + i + W));
+              acc2 = V::add(acc2, V::loadu(x + i + 2 * W));
+              acc3 = V::add(acc3, V::loadu(x + i + 3 * W));
+            }
+
+            for (; i + W <= n; i += W)
+              acc0 = V::add(acc0, V::loadu(x + i));
+
+            T result = V::reduce_add(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+            for (; i < n; ++i)
+              result += x[i];
+
+            return result;
+          }
+
+          /**
+           * @brief Sum of (x - a) (y - b) over a block; y may equal x
+           */
+          template <typename T>
+          inline T block_codeviation(size_t n, const T *x, T a, const T *y, T b)
+          {
+            using V = Vec<T>;
+            constexpr size_t W = V::width;
+            const typename V::reg va = V::set1(a), vb = V::set1(b);
+
+            typename V::reg acc0 = V::zero(), acc1 = V::zero();
+
+            size_t i = 0;
+            for (; i + 2 * W <= n; i += 2 * W)
+            {
+              acc0 = V::fmadd(V::sub(V::loadu(x + i), va), V::sub(V::loadu(y + i), vb), acc0);
+              acc1 = V::fmadd(V::sub(V::loadu(x + i + W), va), V::sub(V::loadu(y + i + W), vb), acc1);
+            }
+
+            for (; i + W <= n; i += W)
+              acc0 = V::fmadd(V::sub(V::loadu(x + i), va), V::sub(V::loadu(y + i), vb), acc0);
+
+            T result = V::reduce_add(V::add(acc0, acc1));
+            for (; i < n; ++i)
+              result += (x[i] - a) * (y[i] - b);
+
+            return result;
+          }
+
+          /**
+           * @brief Mean and sum of squared deviations of a contiguous array
+           */
+          template <typename T>
+          void moments(size_t n, const T *x, T &mean, T &m2)
+          {
+            mean = T{0};
+            m2 = T{0};
+
+            for (size_t i = 0; i < n; i += MOMENT_BLOCK)
+            {
+              const size_t nb = n - i < MOMENT_BLOCK ? n - i : MOMENT_BLOCK;
+              const T mean_b = block_sum(nb, x + i) / static_cast<T>(nb);
+              const T m2_b = block_codeviation(nb, x + i, mean_b, x + i, mean_b);
+              chan_merge(i, mean, m2, nb, mean_b, m2_b);
+            }
+          }
+
+          /**
+           * @brief Means, sums of squared deviations and co-deviation of two
+           * contiguous arrays
+           */
+          template <typename T>
+          void comoments(size_t n, const T *x, const T *y, T &mean_x, T &mean_y,
+                         T &m2_x, T &m2_y, T &c_xy)
+          {
+            mean_x = mean_y = m2_x = m2_y = c_xy = T{0};
+
+            for (size_t i = 0; i < n; i += MOMENT_BLOCK)
+            {
+              const size_t nb = n - i < MOMENT_BLOCK ? n - i : MOMENT_BLOCK;
+              const T bx = block_sum(nb, x + i) / static_cast<T>(nb);
+              const T by = block_sum(nb, y + i) / static_cast<T>(nb);
+              const T cb = block_codeviation(nb, x + i, bx, y + i, by);
+
+              // The co-deviation picks up dx * dy where m2 picks up dx^2
+              const T total = static_cast<T>(i + nb);
+              const T dx = bx - mean_x, dy = by - mean_y;
+              c_xy += cb + dx * dy * (static_cast<T>(i) * static_cast<T>(nb) / total);
+
+              chan_merge(i, mean_x, m2_x, nb, bx, block_codeviation(nb, x + i, bx, x + i, bx));
+              chan_merge(i, mean_y, m2_y, nb, by, block_codeviation(nb, y + i, by, y + i, by));
+            }
+          }
+
+          /**
+           * @brief Per-column means and sums of squared deviations of a
+           * row-major matrix; mean and m2 have one entry per column
+           */
+          template <typename T>
+          void column_moments(size_t rows, size_t cols, const T *x, size_t ld, T *mean, T *m2)
+          {
+            using V = Vec<T>;
+            using Reg = typename V::reg;
+            constexpr size_t W = V::width;
+
+            for (size_t c = 0; c < cols; ++c)
+              mean[c] = m2[c] = T{0};
+
+            for (size_t r = 0; r < rows; r += MOMENT_ROWS)
+            {
+              const size_t nb = rows - r < MOMENT_ROWS ? rows - r : MOMENT_ROWS;
+              const T *block = x + r * ld;
+
+              const T n = static_cast<T>(r + nb);
+              const T weight = static_cast<T>(nb) / n;
+              const T cross = static_cast<T>(r) * static_cast<T>(nb) / n;
+              const Reg vinv = V::set1(T{1} / static_cast<T>(nb));
+              const Reg vweight = V::set1(weight), vcross = V::set1(cross);
+
+              size_t c = 0;
+              for (; c + W <= cols; c += W)
+              {
+                Reg sum = V::zero();
+                for (size_t i = 0; i < nb; ++i)
+                  sum = V::add(sum, V::loadu(block + i * ld + c));
+                const Reg mean_b = V::mul(sum, vinv);
+
+                Reg m2_b = V::zero();
+                for (size_t i = 0; i < nb; ++i)
+                {
+                  const Reg d = V::sub(V::loadu(block + i * ld + c), mean_b);
+                  m2_b = V::fmadd(d, d, m2_b);
+                }
+
+                const Reg mean_a = V::loadu(mean + c);
+                const Reg delta = V::sub(mean_b, mean_a);
+                V::storeu(mean + c, V::fmadd(delta, vweight, mean_a));
+                V::storeu(m2 + c, V::fmadd(V::mul(delta, delta), vcross,
+                                           V::add(V::loadu(m2 + c), m2_b)));
+              }
+
+              for (; c < cols; ++c)
+              {
+                T sum = T{0};
+                for (size_t i = 0; i < nb; ++i)
+                  sum += block[i * ld + c];
+                const T mean_b = sum / static_cast<T>(nb);
+
+                T m2_b = T{0};
+                for (size_t i = 0; i < nb; ++i)
+                {
+                  const T d = block[i * ld + c] - mean_b;
+                  m2_b += d * d;
+                }
+
+                chan_merge(r, mean[c], m2[c], nb, mean_b, m2_b);
+              }
+            }
+          }
+
+          template <typename T>
+          constexpr KernelTable<T> make_table()
+          {
+            using Tile = GemmTile<T>;
+
+            return KernelTable<T>{
+                TF_KERNEL_ISA_NAME,
+                &dot<T>,
+                &axpy<T>,
+                &scal<T>,
+                &sumsq<T>,
+                &random_uniform<T>,
+                &random_normal<T>,
+                &sigmoid<T>,
+                &tanh<T>,
+                &relu<T>,
+                &leaky_relu<T>,
+                &softmax<T>,
+                &log_softmax<T>,
+                &moments<T>,
+                &comoments<T>,
+                &column_moments<T>,
+                &add<T>,
+                &subtract<T>,
+                &multiply<T>,
+                &divide<T>,
+                &maximum<T>,
+                &minimum<T>,
+                &negate<T>,
+                &absolute<T>,
+                &square_root<T>,
+                &square<T>,
+                &gemm_epilogue<T>,
+                {&small_gemm<T, 4>, &small_gemm<T, 8>, &small_gemm<T, 16>, &small_gemm<T, 32>},
+                GemmKernel<T>{Tile::mr, Tile::nv * Vec<T>::width, 0, 0, 0,
+                              &gemm_micro_kernel<T, Tile::mr, Tile::nv>,
+                              &gemm_fused_kernel<T, Tile::mr, Tile::nv>},
+            };
+          }
+
+          // Constant-initialized, so no code from this TU runs before the
+          // dispatcher has checked that the host supports the ISA.
+          constexpr KernelTable<float> kTableF32 = make_table<float>();
+          constexpr KernelTable<double> kTableF64 = make_table<double>();
+
+          constexpr ReducedKernelTable kTableReduced{
+              TF_KERNEL_ISA_NAME,
+              &bf16_to_f32,
+              &f32_to_bf16,
+              &f16_to_f32,
+              &f32_to_f16,
+              &widened_dot<&bf16_to_f32>,
+              &widened_dot<&f16_to_f32>,
+              &dot_i8,
+              &quantize_i8,
+              &dequantize_i8,
+              DotGemmKernel<std::uint8_t, std::int8_t, std::int32_t>{I8_GROUP, I8_MR, I8_NR, 0, 0, 0, &gemm_i8_kernel},
+          };
+        } // namespace
+
+        const KernelTable<float> &table_f32()
+        {
+          return kTableF32;
+        }
+
+        const KernelTable<double> &table_f64()
+        {
+          return kTableF64;
+        }
+
+        const ReducedKernelTable &table_reduced()
+        {
+          return kTableReduced;
+        }
+      } // namespace TF_KERNEL_NAMESPACE
+    } // namespace kernels
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,6 @@
+// Built with SSE4.2 flags (see CMakeLists.txt).
+#if defined(__x86_64__) || defined(_M_X64)
+#define TF_KERNEL_NAMESPACE sse4
+#define TF_KERNEL_ISA_NAME "sse4"
+#include "math/kernels/kernels_impl.hpp"
+#endif
@@ -0,0 +1,275 @@
+#include <tf/math/quantize.hpp>
+#include <tf/core/thread_pool.hpp>
+#include "math/kernels/kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace
+    {
+      /**
+       * @brief Elements per parallel chunk
+       */
+      constexpr size_t QUANTIZE_GRAIN = 1 << 14;
+
+      /**
+       * @struct ChannelLayout
+       * @brief A contiguous tensor seen as outer x channels x inner
+       */
+      struct ChannelLayout
+      {
+        size_t outer;
+        size_t channels;
+        size_t inner;
+      };
+
+      ChannelLayout split_axis(const core::Shape &shape, size_t axis)
+      {
+        ChannelLayout layout{1, static_cast<size_t>(shape[axis]), 1};
+        for (size_t i = 0; i < axis; ++i)
+          layout.outer *= static_cast<size_t>(shape[i]);
+        for (size_t i = axis + 1; i < shape.rank(); ++i)
+          layout.inner *= static_cast<size_t>(shape[i]);
+        return layout;
+      }
+
+      /**
+       * @brief Gets the layout params apply to, one channel covering the
+       * whole tensor when params are per tensor
+       */
+      ChannelLayout channel_layout(const core::Shape &shape, const QuantParams &params)
+      {
+        params.validate();
+
+        if (params.channels() == 1)
+          return {1, 1, static_cast<size_t>(std::max<core::index_t>(shape.num_elements(), 0))};
+
+        TF_CHECK(params.axis < shape.rank(), core::ShapeError, "Quantization axis is out of range");
+        TF_CHECK(static_cast<size_t>(shape[params.axis]) == params.channels(), core::ShapeError,
+                 "Quantization channels do not match the axis");
+        return split_axis(shape, params.axis);
+      }
+
+      /**
+       * @brief Runs a quantization kernel over a contiguous tensor on the
+       * thread pool: one run per channel, or one per row of channels when
+       * the channels are the innermost dimension
+       */
+      template <typename In, typename Out, typename Kernel>
+      void run_channels(Kernel kernel, const ChannelLayout &layout, const In *x,
+                        const QuantParams &params, Out *y)
+      {
+        const float *scale = params.scale.data();
+        const std::int32_t *zero_point = params.zero_point.data();
+        const size_t channels = layout.channels;
+        const size_t inner = layout.inner;
+
+        if (channels == 1)
+        {
+          core::parallel_for(0, inner, QUANTIZE_GRAIN, [&](size_t begin, size_t end)
+                             { kernel(end - begin, x + begin, scale, zero_point, 0, y + begin); });
+          return;
+        }
+
+        if (inner == 1)
+        {
+          core::parallel_for(0, layout.outer, std::max<size_t>(1, QUANTIZE_GRAIN / channels),
+                             [&](size_t begin, size_t end)
+                             {
+                               for (size_t row = begin; row < end; ++row)
+                                 kernel(channels, x + row * channels, scale, zero_point, 1,
+                                        y + row * channels);
+                             });
+          return;
+        }
+
+        core::parallel_for(0, layout.outer * channels, std::max<size_t>(1, QUANTIZE_GRAIN / inner),
+                           [&](size_t begin, size_t end)
+                           {
+                             for (size_t run = begin; run < end; ++run)
+                             {
+                               const size_t c = run % channels;
+                               kernel(inner, x + run * inner, scale + c, zero_point + c, 0,
+                                      y + run * inner);
+                             }
+                           });
+      }
+
+      Moments<double> widen(const Moments<float> &moments)
+      {
+        return {moments.count, moments.mean, moments.m2};
+      }
+    } // namespace
+
+    void QuantParams::validate() const
+    {
+      TF_CHECK(!scale.empty(), core::ValueError, "Quantization needs at least one channel");
+      TF_CHECK(scale.size() == zero_point.size(), core::ValueError,
+               "Quantization scales and zero points differ in count");
+
+      for (const float s : scale)
+        TF_CHECK(s > 0.0f && std::isfinite(s), core::ValueError,
+                 "Quantization scale must be positive and finite");
+      for (const std::int32_t z : zero_point)
+        TF_CHECK(z >= -128 && z <= 127, core::ValueError,
+                 "Quantization zero point is outside the int8 range");
+    }
+
+    void Calibrator::observe(const core::TensorView<float> &x)
+    {
+      const core::TensorView<float> dense = x.contiguous();
+      const core::index_t count = std::max<core::index_t>(dense.num_elements(), 0);
+
+      ChannelLayout layout{1, 1, static_cast<size_t>(count)};
+      if (m_options.per_channel)
+      {
+        TF_CHECK(m_options.axis < dense.rank(), core::ShapeError,
+                 "Calibration axis is out of range");
+        layout = split_axis(dense.shape(), m_options.axis);
+      }
+
+      const size_t channels = layout.channels;
+      if (m_moments.empty())
+      {
+        m_moments.assign(channels, Moments<double>{});
+        m_min.assign(channels, std::numeric_limits<float>::infinity());
+        m_max.assign(channels, -std::numeric_limits<float>::infinity());
+      }
+      TF_CHECK(m_moments.size() == channels, core::ShapeError,
+               "Calibration batches differ in channel count");
+
+      if (count == 0)
+        return;
+
+      const float *data = dense.data();
+      std::vector<Moments<float>> moments(channels);
+
+      if (channels == 1)
+        moments[0] = math::moments(data, layout.inner);
+      else if (layout.inner == 1)
+        axis_moments(layout.outer, channels, channels, 1, data, moments.data());
+      else
+      {
+        std::vector<Moments<float>> block(channels);
+        for (size_t o = 0; o < layout.outer; ++o)
+        {
+          axis_moments(layout.inner, 1, channels, layout.inner, data + o * channels * layout.inner,
+                       block.data());
+          for (size_t c = 0; c < channels; ++c)
+            moments[c].merge(block[c]);
+        }
+      }
+
+      for (size_t c = 0; c < channels; ++c)
+        m_moments[c].merge(widen(moments[c]));
+
+      // Extremes, in the order the layout stores them
+      for (size_t o = 0; o < layout.outer; ++o)
+        for (size_t c = 0; c < channels; ++c)
+        {
+          const float *run = data + (o * channels + c) * layout.inner;
+          float lo = m_min[c], hi = m_max[c];
+          for (size_t i = 0; i < layout.inner; ++i)
+          {
+            lo = std::min(lo, run[i]);
+            hi = std::max(hi, run[i]);
+          }
+          m_min[c] = lo;
+          m_max[c] = hi;
+        }
+    }
+
+    QuantParams Calibrator::params() const
+    {
+      const size_t channels = std::max<size_t>(m_moments.size(), 1);
+
+      QuantParams result;
+      result.scale.assign(channels, 1.0f);
+      result.zero_point.assign(channels, 0);
+      result.axis = m_options.per_channel ? m_options.axis : 0;
+
+      for (size_t c = 0; c < m_moments.size(); ++c)
+      {
+        const Moments<double> &moments = m_moments[c];
+        if (moments.count == 0)
+          continue;
+
+        double lo = m_min[c], hi = m_max[c];
+        if (m_options.method == CalibrationMethod::MeanStddev)
+        {
+          const double spread = m_options.num_stddev * std::sqrt(moments.population_variance());
+          lo = std::max(lo, moments.mean - spread);
+          hi = std::min(hi, moments.mean + spread);
+        }
+
+        // 0 must be a level, so that zero padding and ReLU outputs are exact
+        lo = std::min(lo, 0.0);
+        hi = std::max(hi, 0.0);
+
+        double scale;
+        double zero_point = 0.0;
+        if (m_options.symmetric)
+          scale = std::max(-lo, hi) / 127.0;
+        else
+        {
+          scale = (hi - lo) / 255.0;
+          zero_point = std::clamp(std::nearbyint(-128.0 - lo / scale), -128.0, 127.0);
+        }
+
+        const auto narrow = static_cast<float>(scale);
+        if (!(narrow > 0.0f) || !std::isfinite(narrow))
+          continue;
+
+        result.scale[c] = narrow;
+        result.zero_point[c] = static_cast<std::int32_t>(zero_point);
+      }
+
+      return result;
+    }
+
+    void Calibrator::reset()
+    {
+      m_moments.clear();
+      m_min.clear();
+      m_max.clear();
+    }
+
+    QuantParams calibrate(const core::TensorView<float> &x, const CalibrationOptions &options)
+    {
+      Calibrator calibrator(options);
+      calibrator.observe(x);
+      return calibrator.params();
+    }
+
+    void quantize(const core::TensorView<float> &x, const QuantParams &params,
+                  const core::TensorView<std::int8_t> &out)
+    {
+      TF_CHECK(x.shape() == out.shape(), core::ShapeError,
+               "Quantized output must have the shape of the input");
+      TF_CHECK(out.is_contiguous(), core::ShapeError, "Quantized output must be contiguous");
+
+      const ChannelLayout layout = channel_layout(x.shape(), params);
+      const core::TensorView<float> dense = x.contiguous();
+      run_channels(kernels::reduced_kernel_table().quantize_i8, layout, dense.data(), params,
+                   out.data());
+    }
+
+    void dequantize(const core::TensorView<std::int8_t> &x, const QuantParams &params,
+                    const core::TensorView<float> &out)
+    {
+      TF_CHECK(x.shape() == out.shape(), core::ShapeError,
+               "Dequantized output must have the shape of the input");
+      TF_CHECK(out.is_contiguous(), core::ShapeError, "Dequantized output must be contiguous");
+
+      const ChannelLayout layout = channel_layout(x.shape(), params);
+      const core::TensorView<std::int8_t> dense = x.contiguous();
+      run_channels(kernels::reduced_kernel_table().dequantize_i8, layout, dense.data(), params,
+                   out.data());
+    }
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,55 @@
+#include <tf/math/random.hpp>
+#include <tf/core/thread_pool.hpp>
+#include "math/kernels/kernels.hpp"
+
+namespace tf
+{
+  namespace math
+  {
+    namespace
+    {
+      /**
+       * @brief Elements per parallel chunk (a multiple of every kernel batch)
+       */
+      constexpr size_t RANDOM_GRAIN = 1 << 14;
+
+      template <typename T, typename Kernel>
+      void philox_fill(Kernel kernel, T *data, size_t size, T a, T b,
+                       uint64_t seed, uint64_t stream, uint64_t offset)
+      {
+        TF_CHECK(size == 0 || data != nullptr, core::ValueError, "Output array is null");
+
+        core::parallel_for(0, size, RANDOM_GRAIN, [&](size_t begin, size_t end)
+                           { kernel(end - begin, data + begin, a, b, seed, stream, offset + begin); });
+      }
+    } // namespace
+
+    void philox_uniform(float *data, size_t size, float min, float max,
+                        uint64_t seed, uint64_t stream, uint64_t offset)
+    {
+      philox_fill(kernels::kernel_table<float>().random_uniform,
+                  data, size, min, max, seed, stream, offset);
+    }
+
+    void philox_uniform(double *data, size_t size, double min, double max,
+                        uint64_t seed, uint64_t stream, uint64_t offset)
+    {
+      philox_fill(kernels::kernel_table<double>().random_uniform,
+                  data, size, min, max, seed, stream, offset);
+    }
+
+    void philox_normal(float *data, size_t size, float mean, float stddev,
+                       uint64_t seed, uint64_t stream, uint64_t offset)
+    {
+      philox_fill(kernels::kernel_table<float>().random_normal,
+                  data, size, mean, stddev, seed, stream, offset);
+    }
+
+    void philox_normal(double *data, size_t size, double mean, double stddev,
+                       uint64_t seed, uint64_t stream, uint64_t offset)
+    {
+      philox_fill(kernels::kernel_table<double>().random_normal,
+                  data, size, mean, stddev, seed, stream, offset);
+    }
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,214 @@
+#include <tf/math/utils.hpp>
+#include <tf/core/error.hpp>
+#include <tf/core/thread_pool.hpp>
+#include "math/kernels/kernels.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace tf
+{
+  namespace math
+  {
+    namespace
+    {
+      /**
+       * @brief Elements per parallel chunk
+       */
+      constexpr size_t STATISTICS_GRAIN = 1 << 15;
+
+      /**
+       * @brief Lanes reduced together by one task of a column reduction
+       */
+      constexpr size_t LANE_BLOCK = 256;
+
+      /**
+       * @brief Most row chunks a column reduction is split into
+       */
+      constexpr size_t MAX_ROW_CHUNKS = 64;
+
+      template <typename T>
+      Moments<T> contiguous_moments(const T *data, size_t size)
+      {
+        const auto kernel = kernels::kernel_table<T>().moments;
+
+        return core::parallel_reduce(
+            size_t{0}, size, STATISTICS_GRAIN, Moments<T>{},
+            [&](size_t begin, size_t end)
+            {
+              Moments<T> result;
+              result.count = end - begin;
+              kernel(end - begin, data + begin, result.mean, result.m2);
+              return result; },
+            [](Moments<T> a, const Moments<T> &b)
+            { a.merge(b); return a; });
+      }
+
+      template <typename T>
+      Moments<T> strided_moments(const T *data, size_t count, size_t stride)
+      {
+        Moments<T> result;
+        for (size_t i = 0; i < count; ++i)
+          result.push(data[i * stride]);
+        return result;
+      }
+
+      /**
+       * @brief Moments of adjacent lanes (lane_stride 1), tiled over row
+       * chunks and lane blocks
+       *
+       * The tiling depends only on the shape, so the result does not depend
+       * on the number of threads.
+       */
+      template <typename T>
+      void column_moments(size_t count, size_t stride, size_t lanes, const T *data,
+                          Moments<T> *out)
+      {
+        const auto kernel = kernels::kernel_table<T>().column_moments;
+
+        const size_t block = std::min(lanes, LANE_BLOCK);
+        const size_t rows = std::max((STATISTICS_GRAIN + block - 1) / block,
+                                     (count + MAX_ROW_CHUNKS - 1) / MAX_ROW_CHUNKS);
+        const size_t chunks = (count + rows - 1) / rows;
+        const size_t blocks = (lanes + block - 1) / block;
+
+        std::vector<T> mean(chunks * lanes), m2(chunks * lanes);
+
+        core::parallel_for(0, chunks * blocks, 1, [&](size_t begin, size_t end)
+                           {
+                             for (size_t t = begin; t < end; ++t)
+                             {
+                               const size_t r = t / blocks * rows;
+                               const size_t l = t % blocks * block;
+                               const size_t offset = t / blocks * lanes + l;
+                               kernel(std::min(rows, count - r), std::min(block, lanes - l),
+                                      data + r * stride + l, stride,
+                                      mean.data() + offset, m2.data() + offset);
+                             } });
+
+        for (size_t l = 0; l < lanes; ++l)
+        {
+          out[l] = Moments<T>{};
+          for (size_t c = 0; c < chunks; ++c)
+          {
+            Moments<T> partial;
+            partial.count = std::min(rows, count - c * rows);
+            partial.mean = mean[c * lanes + l];
+            partial.m2 = m2[c * lanes + l];
+            out[l].merge(partial);
+          }
+        }
+      }
+
+      template <typename T>
+      void lane_moments(size_t count, size_t stride, size_t lanes, size_t lane_stride,
+                        const T *data, Moments<T> *out)
+      {
+        TF_CHECK(lanes == 0 || out != nullptr, core::ValueError, "Statistics output is null");
+        TF_CHECK(lanes == 0 || count == 0 || data != nullptr, core::ValueError,
+                 "Statistics array is null");
+
+        if (lanes == 0)
+          return;
+
+        if (count == 0)
+        {
+          std::fill(out, out + lanes, Moments<T>{});
+          return;
+        }
+
+        if (lanes == 1)
+        {
+          out[0] = stride == 1 ? contiguous_moments(data, count)
+                               : core::parallel_reduce(
+                                     size_t{0}, count, STATISTICS_GRAIN, Moments<T>{},
+                                     [&](size_t begin, size_t end)
+                                     { return strided_moments(data + begin * stride, end - begin, stride); },
+                                     [](Moments<T> a, const Moments<T> &b)
+                                     { a.merge(b); return a; });
+          return;
+        }
+
+        if (lane_stride == 1)
+        {
+          column_moments(count, stride, lanes, data, out);
+          return;
+        }
+
+        const auto kernel = kernels::kernel_table<T>().moments;
+        const size_t grain = std::max<size_t>(1, STATISTICS_GRAIN / count);
+
+        core::parallel_for(0, lanes, grain, [&](size_t begin, size_t end)
+                           {
+                             for (size_t l = begin; l < end; ++l)
+                             {
+                               const T *lane = data + l * lane_stride;
+                               if (stride == 1)
+                               {
+                                 out[l].count = count;
+                                 kernel(count, lane, out[l].mean, out[l].m2);
+                               }
+                               else
+                               {
+                                 out[l] = strided_moments(lane, count, stride);
+                               }
+                             } });
+      }
+
+      template <typename T>
+      CoMoments<T> paired_moments(const T *x, const T *y, size_t size)
+      {
+        TF_CHECK(size == 0 || (x != nullptr && y != nullptr), core::ValueError,
+                 "Statistics array is null");
+
+        const auto kernel = kernels::kernel_table<T>().comoments;
+
+        return core::parallel_reduce(
+            size_t{0}, size, STATISTICS_GRAIN, CoMoments<T>{},
+            [&](size_t begin, size_t end)
+            {
+              CoMoments<T> result;
+              result.count = end - begin;
+              kernel(end - begin, x + begin, y + begin, result.mean_x, result.mean_y,
+                     result.m2_x, result.m2_y, result.c_xy);
+              return result; },
+            [](CoMoments<T> a, const CoMoments<T> &b)
+            { a.merge(b); return a; });
+      }
+    } // namespace
+
+    Moments<float> moments(const float *data, size_t size)
+    {
+      TF_CHECK(size == 0 || data != nullptr, core::ValueError, "Statistics array is null");
+      return contiguous_moments(data, size);
+    }
+
+    Moments<double> moments(const double *data, size_t size)
+    {
+      TF_CHECK(size == 0 || data != nullptr, core::ValueError, "Statistics array is null");
+      return contiguous_moments(data, size);
+    }
+
+    CoMoments<float> comoments(const float *x, const float *y, size_t size)
+    {
+      return paired_moments(x, y, size);
+    }
+
+    CoMoments<double> comoments(const double *x, const double *y, size_t size)
+    {
+      return paired_moments(x, y, size);
+    }
+
+    void axis_moments(size_t count, size_t stride, size_t lanes, size_t lane_stride,
+                      const float *data, Moments<float> *out)
+    {
+      lane_moments(count, stride, lanes, lane_stride, data, out);
+    }
+
+    void axis_moments(size_t count, size_t stride, size_t lanes, size_t lane_stride,
+                      const double *data, Moments<double> *out)
+    {
+      lane_moments(count, stride, lanes, lane_stride, data, out);
+    }
+  } // namespace math
+} // namespace tf
@@ -0,0 +1,561 @@
+#include <tf/ops/executor.hpp>
+#include <tf/core/thread_pool.hpp>
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace tf
+{
+  namespace ops
+  {
+    namespace
+    {
+      using detail::FusedStep;
+      using detail::Kernel;
+      using detail::NO_INDEX;
+      using detail::RUNNING;
+
+      /**
+       * @brief Elements per parallel chunk of a fused elementwise kernel
+       */
+      constexpr size_t FUSED_GRAIN = 1 << 14;
+
+      /**
+       * @brief Elements every step of a fused kernel computes at a time,
+       * so the running value stays in L1 between steps
+       */
+      constexpr size_t FUSED_BLOCK = 1024;
+
+      /**
+       * @brief Alignment of every value in the planned buffer
+       */
+      constexpr size_t ARENA_ALIGNMENT = 64;
+
+      size_t align_up(size_t size)
+      {
+        return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+      }
+
+      /**
+       * @brief Maps a unary operation to the GEMM epilogue activation
+       * computing it, if there is one
+       */
+      bool activation_of(math::UnaryOp op, math::Activation &activation)
+      {
+        switch (op)
+        {
+        case math::UnaryOp::Relu:
+          activation = math::Activation::Relu;
+          return true;
+        case math::UnaryOp::Sigmoid:
+          activation = math::Activation::Sigmoid;
+          return true;
+        case math::UnaryOp::Tanh:
+          activation = math::Activation::Tanh;
+          return true;
+        default:
+          return false;
+        }
+      }
+
+      /**
+       * @brief Calls fn with every node a kernel reads
+       */
+      template <typename Function>
+      void for_each_input(const Kernel &kernel, Function fn)
+      {
+        if (kernel.kind == Kernel::Kind::Elementwise)
+        {
+          for (NodeId leaf : kernel.leaves)
+            fn(leaf);
+          return;
+        }
+
+        fn(kernel.a);
+        fn(kernel.b);
+        if (kernel.row_bias != NO_INDEX)
+          fn(kernel.row_bias);
+        if (kernel.column_bias != NO_INDEX)
+          fn(kernel.column_bias);
+      }
+    } // namespace
+
+    Executor::Executor(const Graph &graph, const ExecutorOptions &options)
+        : m_graph(graph), m_options(options)
+    {
+      TF_CHECK(!m_graph.outputs().empty(), core::ValueError, "Graph has no outputs");
+
+      const std::vector<Node> &nodes = m_graph.nodes();
+      std::vector<bool> live(nodes.size(), false);
+      for (NodeId id : m_graph.outputs())
+        live[id] = true;
+      for (size_t id = nodes.size(); id-- > 0;)
+        if (live[id])
+          for (NodeId input : nodes[id].inputs)
+            live[input] = true;
+
+      for (NodeId id : m_graph.inputs())
+        if (live[id])
+          m_required.push_back(id);
+
+      m_data.assign(nodes.size(), nullptr);
+      m_bound.resize(nodes.size());
+      for (NodeId id = 0; id < nodes.size(); ++id)
+        if (nodes[id].type == OpType::Constant)
+          m_data[id] = nodes[id].value.data();
+
+      fuse(live);
+      schedule();
+      plan();
+    }
+
+    void Executor::fuse(const std::vector<bool> &live)
+    {
+      const std::vector<Node> &nodes = m_graph.nodes();
+
+      std::vector<std::vector<NodeId>> users(nodes.size());
+      for (NodeId id = 0; id < nodes.size(); ++id)
+        if (live[id])
+          for (NodeId input : nodes[id].inputs)
+            users[input].push_back(id);
+
+      std::vector<bool> is_output(nodes.size(), false);
+      for (NodeId id : m_graph.outputs())
+        is_output[id] = true;
+
+      // A value folds into the node using it when nothing else needs it
+      auto foldable = [&](NodeId value, NodeId node)
+      {
+        if (!m_options.fuse || is_output[value])
+          return false;
+        return std::all_of(users[value].begin(), users[value].end(), [&](NodeId user)
+                           { return user == node; });
+      };
+
+      // Kernel whose output is value, if it can take the node using it
+      auto tail = [&](NodeId value, NodeId node, Kernel::Kind kind) -> Kernel *
+      {
+        const size_t p = m_producer[value];
+        if (p == NO_INDEX || m_kernels[p].kind != kind || m_kernels[p].output != value ||
+            nodes[value].shape != nodes[node].shape || !foldable(value, node))
+          return nullptr;
+        return &m_kernels[p];
+      };
+
+      auto into_gemm = [&](NodeId id)
+      {
+        const Node &node = nodes[id];
+        for (NodeId value : node.inputs)
+        {
+          Kernel *kernel = tail(value, id, Kernel::Kind::Gemm);
+          // The epilogue adds biases before the activation, so nothing
+          // folds after one
+          if (!kernel || kernel->activation != math::Activation::Identity)
+            continue;
+
+          math::Activation activation;
+          if (node.type == OpType::Unary && activation_of(node.unary_op, activation))
+          {
+            kernel->activation = activation;
+          }
+          else if (node.type == OpType::Binary && node.binary_op == math::BinaryOp::Add)
+          {
+            const NodeId bias = node.inputs[0] == value ? node.inputs[1] : node.inputs[0];
+            const core::Shape &shape = nodes[bias].shape;
+            const auto m = static_cast<core::index_t>(kernel->m);
+            const auto n = static_cast<core::index_t>(kernel->n);
+
+            if (bias == value)
+              continue;
+            if (kernel->column_bias == NO_INDEX && (shape == core::Shape({n}) || shape == core::Shape({1, n})))
+              kernel->column_bias = bias;
+            else if (kernel->row_bias == NO_INDEX && shape == core::Shape({m, 1}))
+              kernel->row_bias = bias;
+            else
+              continue;
+          }
+          else
+          {
+            continue;
+          }
+
+          kernel->output = id;
+          ++kernel->nodes;
+          m_producer[id] = m_producer[value];
+          return true;
+        }
+        return false;
+      };
+
+      // Leaf index of an operand, added if new; the running value is not a leaf
+      auto operand = [](Kernel &kernel, NodeId input, NodeId running)
+      {
+        if (input == running)
+          return RUNNING;
+        const auto it = std::find(kernel.leaves.begin(), kernel.leaves.end(), input);
+        if (it != kernel.leaves.end())
+          return static_cast<size_t>(it - kernel.leaves.begin());
+        kernel.leaves.push_back(input);
+        return kernel.leaves.size() - 1;
+      };
+
+      auto append = [&](Kernel &kernel, const Node &node, NodeId running)
+      {
+        FusedStep step;
+        step.type = node.type;
+        step.binary_op = node.binary_op;
+        step.unary_op = node.unary_op;
+        step.lhs = operand(kernel, node.inputs[0], running);
+        if (node.type == OpType::Binary)
+          step.rhs = operand(kernel, node.inputs[1], running);
+        kernel.steps.push_back(step);
+      };
+
+      auto into_chain = [&](NodeId id)
+      {
+        const Node &node = nodes[id];
+        for (NodeId value : node.inputs)
+        {
+          Kernel *kernel = tail(value, id, Kernel::Kind::Elementwise);
+          if (!kernel)
+            continue;
+
+          size_t added = 0;
+          for (size_t i = 0; i < node.inputs.size(); ++i)
+          {
+            const NodeId input = node.inputs[i];
+            const bool repeated = i > 0 && node.inputs[0] == input;
+            if (input != value && !repeated &&
+                std::find(kernel->leaves.begin(), kernel->leaves.end(), input) == kernel->leaves.end())
+              ++added;
+          }
+          if (kernel->leaves.size() + added > detail::MAX_FUSED_LEAVES)
+            continue;
+
+          append(*kernel, node, value);
+          kernel->output = id;
+          ++kernel->nodes;
+          m_producer[id] = m_producer[value];
+          return true;
+        }
+        return false;
+      };
+
+      m_producer.assign(nodes.size(), NO_INDEX);
+      for (NodeId id = 0; id < nodes.size(); ++id)
+      {
+        const Node &node = nodes[id];
+        if (!live[id] || node.type == OpType::Input || node.type == OpType::Constant)
+          continue;
+
+        if (node.type == OpType::MatMul)
+        {
+          const Node &a = nodes[node.inputs[0]];
+          Kernel kernel;
+          kernel.kind = Kernel::Kind::Gemm;
+          kernel.output = id;
+          kernel.a = node.inputs[0];
+          kernel.b = node.inputs[1];
+          kernel.transpose_a = node.transpose_a;
+          kernel.transpose_b = node.transpose_b;
+          kernel.m = static_cast<size_t>(node.shape[0]);
+          kernel.n = static_cast<size_t>(node.shape[1]);
+          kernel.k = static_cast<size_t>(node.transpose_a ? a.shape[0] : a.shape[1]);
+          m_producer[id] = m_kernels.size();
+          m_kernels.push_back(std::move(kernel));
+          continue;
+        }
+
+        if (into_gemm(id) || into_chain(id))
+          continue;
+
+        Kernel kernel;
+        kernel.kind = Kernel::Kind::Elementwise;
+        kernel.output = id;
+        append(kernel, node, NO_INDEX);
+        m_producer[id] = m_kernels.size();
+        m_kernels.push_back(std::move(kernel));
+      }
+    }
+
+    void Executor::schedule()
+    {
+      // Operands are recorded before the nodes using them, so ordering by
+      // output puts every kernel after the kernels it reads
+      std::sort(m_kernels.begin(), m_kernels.end(), [](const Kernel &x, const Kernel &y)
+                { return x.output < y.output; });
+
+      std::fill(m_producer.begin(), m_producer.end(), NO_INDEX);
+      for (size_t i = 0; i < m_kernels.size(); ++i)
+        m_producer[m_kernels[i].output] = i;
+
+      for (size_t i = 0; i < m_kernels.size(); ++i)
+      {
+        Kernel &kernel = m_kernels[i];
+        kernel.level = 0;
+        for_each_input(kernel, [&](NodeId input)
+                       {
+                         const size_t p = m_producer[input];
+                         if (p != NO_INDEX)
+                           kernel.level = std::max(kernel.level, m_kernels[p].level + 1); });
+
+        if (kernel.level >= m_levels.size())
+          m_levels.resize(kernel.level + 1);
+        m_levels[kernel.level].push_back(i);
+      }
+    }
+
+    void Executor::plan()
+    {
+      const std::vector<Node> &nodes = m_graph.nodes();
+      const size_t count = m_kernels.size();
+
+      // Levels during which each output must stay intact: kernels of a
+      // level run together, so a value is only dead after the level of its
+      // last reader
+      std::vector<size_t> last(count);
+      for (size_t i = 0; i < count; ++i)
+        last[i] = m_kernels[i].level;
+      for (const Kernel &kernel : m_kernels)
+        for_each_input(kernel, [&](NodeId input)
+                       {
+                         const size_t p = m_producer[input];
+                         if (p != NO_INDEX)
+                           last[p] = std::max(last[p], kernel.level); });
+      for (NodeId id : m_graph.outputs())
+        if (m_producer[id] != NO_INDEX)
+          last[m_producer[id]] = NO_INDEX;
+
+      std::vector<size_t> sizes(count);
+      for (size_t i = 0; i < count; ++i)
+      {
+        sizes[i] = align_up(static_cast<size_t>(nodes[m_kernels[i].output].shape.num_elements()) * sizeof(float));
+        m_intermediate_size += sizes[i];
+      }
+
+      // Largest values first, each at the lowest offset that no value
+      // alive at the same time covers
+      std::vector<size_t> order(count);
+      for (size_t i = 0; i < count; ++i)
+        order[i] = i;
+      std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y)
+                       { return sizes[x] > sizes[y]; });
+
+      std::vector<size_t> offsets(count, 0);
+      std::vector<size_t> placed;
+      std::vector<size_t> conflicts;
+      for (size_t i : order)
+      {
+        conflicts.clear();
+        for (size_t j : placed)
+          if (m_kernels[i].level <= last[j] && m_kernels[j].level <= last[i])
+            conflicts.push_back(j);
+        std::sort(conflicts.begin(), conflicts.end(), [&](size_t x, size_t y)
+                  { return offsets[x] < offsets[y]; });
+
+        size_t offset = 0;
+        for (size_t j : conflicts)
+        {
+          if (offset + sizes[i] <= offsets[j])
+            break;
+          offset = std::max(offset, offsets[j] + sizes[j]);
+        }
+
+        offsets[i] = offset;
+        m_arena_size = std::max(m_arena_size, offset + sizes[i]);
+        if (sizes[i] > 0)
+          placed.push_back(i);
+      }
+
+      const size_t elements = std::max<size_t>(m_arena_size / sizeof(float), 1);
+      m_arena = std::shared_ptr<float[]>(new (std::align_val_t{ARENA_ALIGNMENT}) float[elements],
+                                         [](float *p)
+                                         { ::operator delete[](p, std::align_val_t{ARENA_ALIGNMENT}); });
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        Kernel &kernel = m_kernels[i];
+        kernel.out = m_arena.get() + offsets[i] / sizeof(float);
+        m_data[kernel.output] = kernel.out;
+        prepare(kernel);
+      }
+    }
+
+    void Executor::prepare(Kernel &kernel) const
+    {
+      if (kernel.kind != Kernel::Kind::Elementwise)
+        return;
+
+      const std::vector<Node> &nodes = m_graph.nodes();
+      const core::Shape &shape = nodes[kernel.output].shape;
+
+      kernel.dims = shape.dims();
+      kernel.strides.push_back(core::contiguous_strides(shape));
+      for (NodeId leaf : kernel.leaves)
+        kernel.strides.push_back(core::broadcast_strides(nodes[leaf].shape, shape));
+      core::detail::collapse_dims(kernel.dims, kernel.strides);
+
+      const size_t r = kernel.dims.size();
+      const auto elements = static_cast<size_t>(shape.num_elements());
+      kernel.inner = r > 0 ? static_cast<size_t>(kernel.dims[r - 1]) : 1;
+      kernel.rows = elements == 0 ? 0 : elements / kernel.inner;
+    }
+
+    void Executor::bind(NodeId input, const core::TensorView<float> &value)
+    {
+      TF_CHECK(input < m_graph.size() && m_graph.node(input).type == OpType::Input, core::IndexError,
+               "Node is not an input of the graph");
+      const Node &node = m_graph.node(input);
+      TF_CHECK(value.shape() == node.shape, core::ShapeError,
+               "Tensor bound to input " + node.name + " has another shape");
+      TF_CHECK(value.buffer() && value.is_contiguous(), core::ShapeError,
+               "Tensor bound to input " + node.name + " is not dense");
+
+      m_data[input] = value.data();
+      m_bound[input] = value.buffer();
+    }
+
+    void Executor::run()
+    {
+      TF_PROFILE_SCOPE("executor.run");
+      for (NodeId id : m_required)
+        TF_CHECK(m_bound[id] != nullptr, core::ValueError,
+                 "Graph input " + m_graph.node(id).name + " is not bound");
+
+      for (const std::vector<size_t> &level : m_levels)
+      {
+        if (level.size() == 1 || !m_options.concurrent)
+        {
+          for (size_t i : level)
+            execute(m_kernels[i]);
+          continue;
+        }
+
+        core::parallel_for(0, level.size(), 1, [this, &level](size_t begin, size_t end)
+                           {
+                             for (size_t i = begin; i < end; ++i)
+                               execute(m_kernels[level[i]]); });
+      }
+    }
+
+    core::TensorView<float> Executor::output(size_t index) const
+    {
+      TF_CHECK(index < m_graph.outputs().size(), core::IndexError, "Graph has no such output");
+
+      const NodeId id = m_graph.outputs()[index];
+      const Node &node = m_graph.node(id);
+      float *data = const_cast<float *>(m_data[id]);
+
+      switch (node.type)
+      {
+      case OpType::Constant:
+        return node.value;
+      case OpType::Input:
+        TF_CHECK(m_bound[id] != nullptr, core::ValueError, "Graph input " + node.name + " is not bound");
+        return core::TensorView<float>(std::shared_ptr<float[]>(m_bound[id], data), node.shape);
+      default:
+        return core::TensorView<float>(std::shared_ptr<float[]>(m_arena, data), node.shape);
+      }
+    }
+
+    void Executor::execute(const Kernel &kernel) const
+    {
+      if (kernel.kind == Kernel::Kind::Gemm)
+      {
+        run_gemm(kernel);
+        return;
+      }
+
+      if (kernel.rows == 0)
+        return;
+      TF_PROFILE_KERNEL("fused_elementwise", kernel.rows * kernel.inner * kernel.steps.size(),
+                        kernel.rows * kernel.inner * (kernel.leaves.size() + 1) * sizeof(float));
+
+      // The lambdas capture two pointers, which std::function stores inline
+      if (kernel.rows == 1)
+      {
+        core::parallel_for(0, kernel.inner, FUSED_GRAIN, [this, &kernel](size_t begin, size_t end)
+                           { run_rows(kernel, 0, begin, end); });
+        return;
+      }
+
+      const size_t grain = std::max<size_t>(1, FUSED_GRAIN / kernel.inner);
+      core::parallel_for(0, kernel.rows, grain, [this, &kernel](size_t begin, size_t end)
+                         {
+                           for (size_t row = begin; row < end; ++row)
+                             run_rows(kernel, row, 0, kernel.inner); });
+    }
+
+    void Executor::run_gemm(const Kernel &kernel) const
+    {
+      math::GemmEpilogue<float> epilogue;
+      epilogue.row_bias = kernel.row_bias != NO_INDEX ? m_data[kernel.row_bias] : nullptr;
+      epilogue.column_bias = kernel.column_bias != NO_INDEX ? m_data[kernel.column_bias] : nullptr;
+      epilogue.activation = kernel.activation;
+
+      // Transposed operands are stored as (k, m) and (n, k)
+      const size_t lda = std::max<size_t>(kernel.transpose_a ? kernel.m : kernel.k, 1);
+      const size_t ldb = std::max<size_t>(kernel.transpose_b ? kernel.k : kernel.n, 1);
+      math::Blas::gemm<float>(kernel.transpose_a ? math::BlasOperation::Trans : math::BlasOperation::NoTrans,
+                              kernel.transpose_b ? math::BlasOperation::Trans : math::BlasOperation::NoTrans,
+                              kernel.m, kernel.n, kernel.k, 1.0f, m_data[kernel.a], lda, m_data[kernel.b], ldb,
+                              0.0f, kernel.out, std::max<size_t>(kernel.n, 1), epilogue);
+    }
+
+    void Executor::run_rows(const Kernel &kernel, size_t row, size_t begin, size_t end) const
+    {
+      const size_t r = kernel.dims.size();
+      const auto index = static_cast<core::index_t>(row);
+
+      // Start of the run in every leaf; innermost strides are 0 or 1 for
+      // dense tensors broadcast to the output
+      const float *base[detail::MAX_FUSED_LEAVES];
+      size_t inc[detail::MAX_FUSED_LEAVES];
+      for (size_t k = 0; k < kernel.leaves.size(); ++k)
+      {
+        const core::shape_t &strides = kernel.strides[k + 1];
+        base[k] = m_data[kernel.leaves[k]] +
+                  (r > 0 ? core::detail::strided_offset(index, kernel.dims, strides, r - 1) : 0);
+        inc[k] = r > 0 ? static_cast<size_t>(strides[r - 1]) : 1;
+      }
+      float *z = kernel.out + (r > 0 ? core::detail::strided_offset(index, kernel.dims, kernel.strides[0], r - 1) : 0);
+
+      for (size_t b = begin; b < end; b += FUSED_BLOCK)
+      {
+        const size_t n = std::min(FUSED_BLOCK, end - b);
+        float *block = z + b;
+
+        auto source = [&](size_t leaf, size_t &step_inc) -> const float *
+        {
+          if (leaf == RUNNING)
+          {
+            step_inc = 1;
+            return block;
+          }
+          step_inc = inc[leaf];
+          return base[leaf] + b * inc[leaf];
+        };
+
+        for (const FusedStep &step : kernel.steps)
+        {
+          size_t incx = 1;
+          const float *x = source(step.lhs, incx);
+
+          if (step.type == OpType::Unary)
+          {
+            // A repeated input is evaluated once
+            math::unary_block(step.unary_op, incx == 0 ? 1 : n, x, block);
+            if (incx == 0)
+              std::fill(block + 1, block + n, block[0]);
+            continue;
+          }
+
+          size_t incy = 1;
+          const float *y = source(step.rhs, incy);
+          math::binary_block(step.binary_op, n, x, incx, y, incy, block);
+        }
+      }
+    }
+  } // namespace ops
+} // namespace tf
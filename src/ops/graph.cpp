@@ -0,0 +1,120 @@
+#include <tf/ops/graph.hpp>
+#include <tf/utils/arena.hpp>
+
+#include <utility>
+
+namespace tf
+{
+  namespace ops
+  {
+    NodeId Graph::input(const std::string &name, const core::Shape &shape)
+    {
+      for (core::index_t dim : shape)
+        TF_CHECK(dim >= 0, core::ShapeError, "Input " + name + " has a negative dimension");
+
+      Node node;
+      node.type = OpType::Input;
+      node.shape = shape;
+      node.name = name;
+      const NodeId id = add(std::move(node));
+      m_inputs.push_back(id);
+      return id;
+    }
+
+    NodeId Graph::constant(const core::TensorView<float> &value)
+    {
+      Node node;
+      node.type = OpType::Constant;
+      node.shape = value.shape();
+      if (value.is_contiguous())
+        node.value = value;
+      else
+      {
+        // The copy lives as long as the graph, past any ArenaScope
+        utils::ArenaSuspension suspension;
+        node.value = value.contiguous();
+      }
+      return add(std::move(node));
+    }
+
+    NodeId Graph::scalar(float value)
+    {
+      utils::ArenaSuspension suspension;
+      auto view = core::TensorView<float>::allocate(core::Shape{});
+      view.data()[0] = value;
+      return constant(view);
+    }
+
+    NodeId Graph::matmul(NodeId a, NodeId b, bool transpose_a, bool transpose_b)
+    {
+      check(a);
+      check(b);
+      const core::Shape &sa = m_nodes[a].shape;
+      const core::Shape &sb = m_nodes[b].shape;
+      TF_CHECK(sa.rank() == 2 && sb.rank() == 2, core::ShapeError, "Matrix product operands must be matrices");
+
+      const core::index_t m = transpose_a ? sa[1] : sa[0];
+      const core::index_t k = transpose_a ? sa[0] : sa[1];
+      const core::index_t kb = transpose_b ? sb[1] : sb[0];
+      const core::index_t n = transpose_b ? sb[0] : sb[1];
+      TF_CHECK(k == kb, core::ShapeError, "Matrix product inner dimensions do not match");
+
+      Node node;
+      node.type = OpType::MatMul;
+      node.inputs = {a, b};
+      node.shape = core::Shape({m, n});
+      node.transpose_a = transpose_a;
+      node.transpose_b = transpose_b;
+      return add(std::move(node));
+    }
+
+    NodeId Graph::binary(math::BinaryOp op, NodeId a, NodeId b)
+    {
+      check(a);
+      check(b);
+
+      Node node;
+      node.type = OpType::Binary;
+      node.inputs = {a, b};
+      node.shape = core::broadcast_shapes(m_nodes[a].shape, m_nodes[b].shape);
+      node.binary_op = op;
+      return add(std::move(node));
+    }
+
+    NodeId Graph::unary(math::UnaryOp op, NodeId a)
+    {
+      check(a);
+
+      Node node;
+      node.type = OpType::Unary;
+      node.inputs = {a};
+      node.shape = m_nodes[a].shape;
+      node.unary_op = op;
+      return add(std::move(node));
+    }
+
+    size_t Graph::output(NodeId node)
+    {
+      check(node);
+      m_outputs.push_back(node);
+      return m_outputs.size() - 1;
+    }
+
+    const Node &Graph::node(NodeId id) const
+    {
+      check(id);
+      return m_nodes[id];
+    }
+
+    NodeId Graph::add(Node node)
+    {
+      m_nodes.push_back(std::move(node));
+      return m_nodes.size() - 1;
+    }
+
+    void Graph::check(NodeId id) const
+    {
+      TF_CHECK(id < m_nodes.size(), core::IndexError, "Graph has no such node");
+    }
+  } // namespace ops
+} // namespace tf
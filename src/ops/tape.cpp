@@ -0,0 +1,595 @@
+#include <tf/ops/tape.hpp>
+#include <tf/math/elementwise.hpp>
+#include <tf/math/utils.hpp>
+#include <tf/utils/arena.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace tf
+{
+  namespace ops
+  {
+    namespace
+    {
+      math::BlasOperation operation(bool transpose)
+      {
+        return transpose ? math::BlasOperation::Trans : math::BlasOperation::NoTrans;
+      }
+
+      /**
+       * @brief Writes (first) or adds scale * g into t, where g has the
+       * shape of an operation and t the shape of one of its operands
+       *
+       * The dimensions the operand was broadcast along are summed.
+       */
+      void reduce_into(const float *g, const core::Shape &out, float scale, float *t,
+                       const core::Shape &shape, bool first)
+      {
+        const auto count = static_cast<size_t>(out.num_elements());
+        if (shape == out)
+        {
+          if (first)
+            for (size_t i = 0; i < count; ++i)
+              t[i] = scale * g[i];
+          else
+            for (size_t i = 0; i < count; ++i)
+              t[i] += scale * g[i];
+          return;
+        }
+
+        if (first)
+          std::fill_n(t, static_cast<size_t>(shape.num_elements()), 0.0f);
+        if (count == 0)
+          return;
+
+        std::array<core::shape_t, 2> strides{core::contiguous_strides(out), core::broadcast_strides(shape, out)};
+        core::shape_t dims = out.dims();
+        core::detail::collapse_dims(dims, strides);
+
+        const size_t r = dims.size();
+        const size_t inner = r > 0 ? static_cast<size_t>(dims[r - 1]) : 1;
+        const bool repeated = r > 0 && strides[1][r - 1] == 0;
+        for (size_t row = 0; row < count / inner; ++row)
+        {
+          const auto index = static_cast<core::index_t>(row);
+          const float *gr = g + (r > 0 ? core::detail::strided_offset(index, dims, strides[0], r - 1) : 0);
+          float *tr = t + (r > 0 ? core::detail::strided_offset(index, dims, strides[1], r - 1) : 0);
+
+          if (repeated)
+          {
+            float total = 0.0f;
+            for (size_t j = 0; j < inner; ++j)
+              total += gr[j];
+            tr[0] += scale * total;
+          }
+          else
+          {
+            for (size_t j = 0; j < inner; ++j)
+              tr[j] += scale * gr[j];
+          }
+        }
+      }
+
+      /**
+       * @brief Writes (first) or adds g * d into t, all of n elements
+       */
+      void multiply_into(size_t n, const float *g, const float *d, float *t, bool first)
+      {
+        if (first)
+          for (size_t i = 0; i < n; ++i)
+            t[i] = g[i] * d[i];
+        else
+          for (size_t i = 0; i < n; ++i)
+            t[i] += g[i] * d[i];
+      }
+    } // namespace
+
+    VarId Tape::variable(const core::TensorView<float> &value, bool requires_grad)
+    {
+      Node node;
+      node.op = TapeOp::Variable;
+      node.shape = value.shape();
+      node.requires_grad = requires_grad;
+      if (value.is_contiguous())
+        node.value = value;
+      else
+      {
+        // The copy lives as long as the tape, past any ArenaScope
+        utils::ArenaSuspension suspension;
+        node.value = value.contiguous();
+      }
+      m_nodes.push_back(std::move(node));
+      return m_nodes.size() - 1;
+    }
+
+    VarId Tape::matmul(VarId a, VarId b, bool transpose_a, bool transpose_b)
+    {
+      check(a);
+      check(b);
+      const core::Shape &sa = m_nodes[a].shape;
+      const core::Shape &sb = m_nodes[b].shape;
+      TF_CHECK(sa.rank() == 2 && sb.rank() == 2, core::ShapeError, "Matrix product operands must be matrices");
+      TF_CHECK((transpose_a ? sa[0] : sa[1]) == (transpose_b ? sb[1] : sb[0]), core::ShapeError,
+               "Matrix product inner dimensions do not match");
+
+      Node node;
+      node.op = TapeOp::MatMul;
+      node.a = a;
+      node.b = b;
+      node.shape = core::Shape({transpose_a ? sa[1] : sa[0], transpose_b ? sb[0] : sb[1]});
+      node.transpose_a = transpose_a;
+      node.transpose_b = transpose_b;
+      return record(std::move(node));
+    }
+
+    VarId Tape::add(VarId a, VarId b)
+    {
+      check(a);
+      check(b);
+      Node node;
+      node.op = TapeOp::Add;
+      node.a = a;
+      node.b = b;
+      node.shape = core::broadcast_shapes(m_nodes[a].shape, m_nodes[b].shape);
+      return record(std::move(node));
+    }
+
+    VarId Tape::subtract(VarId a, VarId b)
+    {
+      check(a);
+      check(b);
+      Node node;
+      node.op = TapeOp::Subtract;
+      node.a = a;
+      node.b = b;
+      node.shape = core::broadcast_shapes(m_nodes[a].shape, m_nodes[b].shape);
+      return record(std::move(node));
+    }
+
+    VarId Tape::multiply(VarId a, VarId b)
+    {
+      check(a);
+      check(b);
+      Node node;
+      node.op = TapeOp::Multiply;
+      node.a = a;
+      node.b = b;
+      node.shape = core::broadcast_shapes(m_nodes[a].shape, m_nodes[b].shape);
+      return record(std::move(node));
+    }
+
+    VarId Tape::activation(math::Activation activation, VarId a, float leaky_slope)
+    {
+      check(a);
+      TF_CHECK(activation != math::Activation::Identity, core::ValueError,
+               "Identity is not an activation to record");
+
+      Node node;
+      node.op = TapeOp::Activation;
+      node.a = a;
+      node.shape = m_nodes[a].shape;
+      node.activation = activation;
+      node.leaky_slope = leaky_slope;
+      return record(std::move(node));
+    }
+
+    VarId Tape::sum(VarId a)
+    {
+      check(a);
+      Node node;
+      node.op = TapeOp::Sum;
+      node.a = a;
+      return record(std::move(node));
+    }
+
+    VarId Tape::mean(VarId a)
+    {
+      check(a);
+      Node node;
+      node.op = TapeOp::Mean;
+      node.a = a;
+      return record(std::move(node));
+    }
+
+    void Tape::begin_checkpoint()
+    {
+      TF_CHECK(!m_open, core::ValueError, "A checkpoint segment is already open");
+      m_open = true;
+      m_segments.push_back({m_nodes.size(), m_nodes.size()});
+    }
+
+    void Tape::end_checkpoint()
+    {
+      TF_CHECK(m_open, core::ValueError, "No checkpoint segment is open");
+      m_open = false;
+
+      Segment &segment = m_segments.back();
+      segment.last = m_nodes.size() == segment.first ? segment.first : m_nodes.size() - 1;
+      release(m_segments.size() - 1);
+    }
+
+    void Tape::accumulate_into(VarId variable, const core::TensorView<float> &gradient)
+    {
+      TF_CHECK(variable < m_nodes.size() && m_nodes[variable].op == TapeOp::Variable, core::IndexError,
+               "Value is not a variable of the tape");
+      TF_CHECK(gradient.shape() == m_nodes[variable].shape, core::ShapeError,
+               "Gradient buffer does not match the shape of the variable");
+      TF_CHECK(gradient.buffer() && gradient.is_contiguous(), core::ShapeError, "Gradient buffer is not dense");
+
+      m_gradients.resize(m_nodes.size());
+      m_accumulates.resize(m_nodes.size(), false);
+      m_gradients[variable] = gradient;
+      m_accumulates[variable] = true;
+    }
+
+    void Tape::backward(VarId loss)
+    {
+      TF_PROFILE_SCOPE("tape.backward");
+      check(loss);
+      TF_CHECK(m_nodes[loss].shape.num_elements() == 1, core::ShapeError, "Loss must have a single element");
+
+      m_gradients.resize(m_nodes.size());
+      m_accumulates.resize(m_nodes.size(), false);
+      m_has_gradient.assign(m_nodes.size(), false);
+      for (VarId id = 0; id < m_nodes.size(); ++id)
+        if (!m_accumulates[id])
+          m_gradients[id] = core::TensorView<float>();
+
+      if (!m_nodes[loss].requires_grad)
+        return;
+
+      bool first = false;
+      float *seed = target(loss, first).data();
+      seed[0] = first ? 1.0f : seed[0] + 1.0f;
+
+      for (VarId id = loss + 1; id-- > 0;)
+      {
+        Node &node = m_nodes[id];
+        if (node.op != TapeOp::Variable && node.requires_grad && m_has_gradient[id])
+        {
+          ensure(id);
+          propagate(id);
+          // Only variables keep their gradient
+          m_gradients[id] = core::TensorView<float>();
+        }
+
+        // Leaving a segment: its recomputed values are no longer needed
+        if (node.segment != NO_SEGMENT && m_segments[node.segment].first == id)
+          release(node.segment);
+      }
+    }
+
+    const core::TensorView<float> &Tape::value(VarId id)
+    {
+      check(id);
+      ensure(id);
+      return m_nodes[id].value;
+    }
+
+    const core::TensorView<float> &Tape::gradient(VarId variable) const
+    {
+      check(variable);
+      static const core::TensorView<float> none;
+      if (variable >= m_gradients.size())
+        return none;
+      return m_gradients[variable];
+    }
+
+    void Tape::clear()
+    {
+      m_nodes.clear();
+      m_segments.clear();
+      m_open = false;
+      m_gradients.clear();
+      m_has_gradient.clear();
+      m_accumulates.clear();
+    }
+
+    TapeOp Tape::op(VarId id) const
+    {
+      check(id);
+      return m_nodes[id].op;
+    }
+
+    const core::Shape &Tape::shape(VarId id) const
+    {
+      check(id);
+      return m_nodes[id].shape;
+    }
+
+    size_t Tape::resident_bytes() const
+    {
+      size_t bytes = 0;
+      for (const Node &node : m_nodes)
+      {
+        if (node.op == TapeOp::Variable)
+          continue;
+        if (node.value.buffer())
+          bytes += static_cast<size_t>(node.value.num_elements()) * sizeof(float);
+        if (node.derivative.buffer())
+          bytes += static_cast<size_t>(node.derivative.num_elements()) * sizeof(float);
+      }
+      return bytes;
+    }
+
+    size_t Tape::pooled_bytes() const
+    {
+      size_t bytes = 0;
+      for (const auto &[size, buffer] : m_buffers)
+        bytes += size * sizeof(float);
+      return bytes;
+    }
+
+    VarId Tape::record(Node node)
+    {
+      node.requires_grad = m_nodes[node.a].requires_grad ||
+                           (node.op != TapeOp::Activation && node.op != TapeOp::Sum &&
+                            node.op != TapeOp::Mean && m_nodes[node.b].requires_grad);
+      if (m_open)
+        node.segment = m_segments.size() - 1;
+
+      compute(node);
+      m_nodes.push_back(std::move(node));
+      return m_nodes.size() - 1;
+    }
+
+    void Tape::compute(Node &node)
+    {
+      TF_PROFILE_SCOPE("tape.forward");
+      ensure(node.a);
+      const core::TensorView<float> &a = m_nodes[node.a].value;
+      const bool binary = node.op == TapeOp::MatMul || node.op == TapeOp::Add ||
+                          node.op == TapeOp::Subtract || node.op == TapeOp::Multiply;
+      if (binary)
+        ensure(node.b);
+      const core::TensorView<float> &b = m_nodes[binary ? node.b : node.a].value;
+
+      node.value = acquire(node.shape);
+      float *out = node.value.data();
+      const auto count = static_cast<size_t>(node.shape.num_elements());
+
+      switch (node.op)
+      {
+      case TapeOp::MatMul:
+      {
+        const size_t m = static_cast<size_t>(node.shape[0]);
+        const size_t n = static_cast<size_t>(node.shape[1]);
+        const size_t k = static_cast<size_t>(node.transpose_a ? a.dim(0) : a.dim(1));
+        math::Blas::gemm<float>(operation(node.transpose_a), operation(node.transpose_b), m, n, k, 1.0f,
+                                a.data(), std::max<size_t>(static_cast<size_t>(a.dim(1)), 1),
+                                b.data(), std::max<size_t>(static_cast<size_t>(b.dim(1)), 1),
+                                0.0f, out, std::max<size_t>(n, 1));
+        break;
+      }
+      case TapeOp::Add:
+        math::binary(math::BinaryOp::Add, a, b, node.value);
+        break;
+      case TapeOp::Subtract:
+        math::binary(math::BinaryOp::Subtract, a, b, node.value);
+        break;
+      case TapeOp::Multiply:
+        math::binary(math::BinaryOp::Multiply, a, b, node.value);
+        break;
+      case TapeOp::Activation:
+      {
+        // The derivative is computed in the same pass and kept for backward
+        node.derivative = acquire(node.shape);
+        float *derivative = node.derivative.data();
+        switch (node.activation)
+        {
+        case math::Activation::Relu:
+          math::relu_and_derivative(a.data(), out, derivative, count);
+          break;
+        case math::Activation::LeakyRelu:
+          math::leaky_relu_and_derivative(a.data(), out, derivative, count, node.leaky_slope);
+          break;
+        case math::Activation::Sigmoid:
+          math::sigmoid_and_derivative(a.data(), out, derivative, count);
+          break;
+        case math::Activation::Tanh:
+          math::tanh_and_derivative(a.data(), out, derivative, count);
+          break;
+        case math::Activation::Identity:
+          break;
+        }
+        break;
+      }
+      case TapeOp::Sum:
+      case TapeOp::Mean:
+      {
+        const auto n = static_cast<size_t>(a.num_elements());
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i)
+          total += a.data()[i];
+        if (node.op == TapeOp::Mean && n > 0)
+          total /= static_cast<double>(n);
+        out[0] = static_cast<float>(total);
+        break;
+      }
+      case TapeOp::Variable:
+        break;
+      }
+      node.released = false;
+    }
+
+    void Tape::ensure(VarId id)
+    {
+      if (m_nodes[id].released)
+        materialize(m_nodes[id].segment);
+    }
+
+    void Tape::materialize(size_t segment)
+    {
+      TF_PROFILE_SCOPE("tape.recompute");
+      const Segment &range = m_segments[segment];
+      for (VarId id = range.first; id <= range.last; ++id)
+        if (m_nodes[id].released)
+          compute(m_nodes[id]);
+    }
+
+    void Tape::release(size_t segment)
+    {
+      const Segment &range = m_segments[segment];
+      for (VarId id = range.first; id < range.last; ++id)
+      {
+        Node &node = m_nodes[id];
+        if (node.op == TapeOp::Variable)
+          continue;
+        node.value = core::TensorView<float>();
+        node.derivative = core::TensorView<float>();
+        node.released = true;
+      }
+    }
+
+    void Tape::propagate(VarId id)
+    {
+      const Node &node = m_nodes[id];
+      const core::TensorView<float> &gradient = m_gradients[id];
+      const float *g = gradient.data();
+      const auto count = static_cast<size_t>(node.shape.num_elements());
+      bool first = false;
+
+      auto wants = [&](VarId input)
+      {
+        return m_nodes[input].requires_grad;
+      };
+
+      switch (node.op)
+      {
+      case TapeOp::MatMul:
+      {
+        ensure(node.a);
+        ensure(node.b);
+        const core::TensorView<float> &a = m_nodes[node.a].value;
+        const core::TensorView<float> &b = m_nodes[node.b].value;
+        const size_t m = static_cast<size_t>(node.shape[0]);
+        const size_t n = static_cast<size_t>(node.shape[1]);
+        const size_t k = static_cast<size_t>(node.transpose_a ? a.dim(0) : a.dim(1));
+        const size_t lda = std::max<size_t>(static_cast<size_t>(a.dim(1)), 1);
+        const size_t ldb = std::max<size_t>(static_cast<size_t>(b.dim(1)), 1);
+        const size_t ldg = std::max<size_t>(n, 1);
+        using math::BlasOperation;
+
+        // With C = op(A) op(B): dA = dC op(B)^T (stored as (k, m) when A is
+        // transposed: op(B) dC^T) and dB = op(A)^T dC (or dC^T op(A))
+        if (wants(node.a))
+        {
+          float *t = target(node.a, first).data();
+          const float beta = first ? 0.0f : 1.0f;
+          if (!node.transpose_a)
+            math::Blas::gemm<float>(BlasOperation::NoTrans, operation(!node.transpose_b), m, k, n, 1.0f,
+                                    g, ldg, b.data(), ldb, beta, t, std::max<size_t>(k, 1));
+          else
+            math::Blas::gemm<float>(operation(node.transpose_b), BlasOperation::Trans, k, m, n, 1.0f,
+                                    b.data(), ldb, g, ldg, beta, t, std::max<size_t>(m, 1));
+        }
+        if (wants(node.b))
+        {
+          float *t = target(node.b, first).data();
+          const float beta = first ? 0.0f : 1.0f;
+          if (!node.transpose_b)
+            math::Blas::gemm<float>(operation(!node.transpose_a), BlasOperation::NoTrans, k, n, m, 1.0f,
+                                    a.data(), lda, g, ldg, beta, t, std::max<size_t>(n, 1));
+          else
+            math::Blas::gemm<float>(BlasOperation::Trans, operation(node.transpose_a), n, k, m, 1.0f,
+                                    g, ldg, a.data(), lda, beta, t, std::max<size_t>(k, 1));
+        }
+        break;
+      }
+      case TapeOp::Add:
+      case TapeOp::Subtract:
+      {
+        if (wants(node.a))
+        {
+          float *t = target(node.a, first).data();
+          reduce_into(g, node.shape, 1.0f, t, m_nodes[node.a].shape, first);
+        }
+        if (wants(node.b))
+        {
+          float *t = target(node.b, first).data();
+          reduce_into(g, node.shape, node.op == TapeOp::Add ? 1.0f : -1.0f, t, m_nodes[node.b].shape, first);
+        }
+        break;
+      }
+      case TapeOp::Multiply:
+      {
+        ensure(node.a);
+        ensure(node.b);
+        const VarId operands[2] = {node.a, node.b};
+        for (size_t side = 0; side < 2; ++side)
+        {
+          const VarId input = operands[side];
+          if (!wants(input))
+            continue;
+
+          const core::TensorView<float> &other = m_nodes[operands[1 - side]].value;
+          float *t = target(input, first).data();
+          if (m_nodes[input].shape == node.shape && other.shape() == node.shape)
+          {
+            multiply_into(count, g, other.data(), t, first);
+            continue;
+          }
+
+          // g * other at the full shape, then reduced to the operand
+          core::TensorView<float> product = acquire(node.shape);
+          math::binary(math::BinaryOp::Multiply, gradient, other, product);
+          reduce_into(product.data(), node.shape, 1.0f, t, m_nodes[input].shape, first);
+        }
+        break;
+      }
+      case TapeOp::Activation:
+      {
+        float *t = target(node.a, first).data();
+        multiply_into(count, g, node.derivative.data(), t, first);
+        break;
+      }
+      case TapeOp::Sum:
+      case TapeOp::Mean:
+      {
+        const core::Shape &shape = m_nodes[node.a].shape;
+        const auto n = static_cast<size_t>(shape.num_elements());
+        const float value = node.op == TapeOp::Mean && n > 0 ? g[0] / static_cast<float>(n) : g[0];
+        float *t = target(node.a, first).data();
+        if (first)
+          std::fill_n(t, n, value);
+        else
+          for (size_t i = 0; i < n; ++i)
+            t[i] += value;
+        break;
+      }
+      case TapeOp::Variable:
+        break;
+      }
+    }
+
+    core::TensorView<float> &Tape::target(VarId id, bool &first)
+    {
+      core::TensorView<float> &gradient = m_gradients[id];
+      first = !m_accumulates[id] && !m_has_gradient[id];
+      if (first)
+        gradient = acquire(m_nodes[id].shape);
+      m_has_gradient[id] = true;
+      return gradient;
+    }
+
+    core::TensorView<float> Tape::acquire(const core::Shape &shape)
+    {
+      const size_t count = std::max<size_t>(static_cast<size_t>(shape.num_elements()), 1);
+      for (const auto &[size, buffer] : m_buffers)
+        if (size == count && buffer.use_count() == 1)
+          return core::TensorView<float>(buffer, shape);
+
+      // Pooled buffers outlive clear() and any ArenaScope they were first
+      // needed in
+      utils::ArenaSuspension suspension;
+      m_buffers.emplace_back(count, core::Memory<float>::allocate_uninitialized(count));
+      return core::TensorView<float>(m_buffers.back().second, shape);
+    }
+
+    void Tape::check(VarId id) const
+    {
+      TF_CHECK(id < m_nodes.size(), core::IndexError, "Tape has no such value");
+    }
+  } // namespace ops
+} // namespace tf
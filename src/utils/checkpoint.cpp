@@ -0,0 +1,485 @@
+#include <tf/utils/checkpoint.hpp>
+#include "utils/compression.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tf
+{
+  namespace utils
+  {
+    namespace
+    {
+      constexpr char MAGIC[8] = {'T', 'F', 'C', 'K', 'P', 'T', '\0', '\0'};
+
+      /**
+       * @brief Bytes before the first entry: magic, version, count and
+       * data offset
+       */
+      constexpr size_t PREAMBLE_SIZE = 8 + 4 + 4 + 8;
+
+      /**
+       * @brief Fixed bytes of an entry, before its dims and name
+       */
+      constexpr size_t ENTRY_SIZE = 4 * 4 + 8 + 8;
+
+      /**
+       * @brief Largest rank accepted when parsing, against corrupt counts
+       */
+      constexpr std::uint32_t MAX_RANK = 64;
+
+      size_t round_up(size_t value, size_t multiple)
+      {
+        return (value + multiple - 1) / multiple * multiple;
+      }
+
+      void check_byte_order()
+      {
+        TF_CHECK(std::endian::native == std::endian::little, core::NotImplementedError,
+                 "Checkpoints are only supported on little-endian hosts");
+      }
+
+      template <typename T>
+      void append(std::string &out, T value)
+      {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+      }
+
+      /**
+       * @struct HeaderReader
+       * @brief Bounds-checked cursor over a checkpoint header
+       */
+      struct HeaderReader
+      {
+        const char *pos;
+        const char *end;
+
+        void need(size_t bytes) const
+        {
+          TF_CHECK(pos <= end && static_cast<size_t>(end - pos) >= bytes, core::IOError,
+                   "Checkpoint header is truncated");
+        }
+
+        template <typename T>
+        T read()
+        {
+          need(sizeof(T));
+          T value;
+          std::memcpy(&value, pos, sizeof(T));
+          pos += sizeof(T);
+          return value;
+        }
+      };
+
+      /**
+       * @brief Gets the bytes of a tensor's elements, or fails on overflow
+       *
+       * Runs on the raw dimensions, before a Shape multiplies them.
+       */
+      size_t checked_bytes(const core::index_t *dims, size_t rank, core::DataType dtype)
+      {
+        constexpr auto MAX_ELEMENTS = static_cast<size_t>(std::numeric_limits<core::index_t>::max());
+
+        size_t elements = 1;
+        size_t bytes = core::size_of(dtype);
+        for (size_t i = 0; i < rank; ++i)
+        {
+          TF_CHECK(dims[i] >= 0, core::IOError, "Checkpoint dimension is negative");
+          const auto dim = static_cast<size_t>(dims[i]);
+          TF_CHECK(dim == 0 || (elements <= MAX_ELEMENTS / dim &&
+                                bytes <= std::numeric_limits<size_t>::max() / dim),
+                   core::IOError, "Checkpoint tensor size overflows");
+          elements *= dim;
+          bytes *= dim;
+        }
+        return bytes;
+      }
+
+      /**
+       * @brief Allocates bytes aligned like a mapping, so the 64-byte data
+       * alignment holds
+       */
+      std::shared_ptr<char[]> allocate_bytes(size_t size)
+      {
+        return std::shared_ptr<char[]>(new (std::align_val_t{CHECKPOINT_ALIGNMENT}) char[std::max<size_t>(size, 1)],
+                                       [](char *p)
+                                       { ::operator delete[](p, std::align_val_t{CHECKPOINT_ALIGNMENT}); });
+      }
+
+      /**
+       * @brief Maps (or, without mmap, reads) a whole file
+       */
+      std::shared_ptr<char[]> map_file(const std::string &path, bool writable, size_t &size)
+      {
+#if defined(__linux__)
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        TF_CHECK(fd >= 0, core::IOError, "Failed to open checkpoint " + path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+          ::close(fd);
+          TF_CHECK(false, core::IOError, "Checkpoint " + path + " is empty or unreadable");
+        }
+        size = static_cast<size_t>(info.st_size);
+
+        // Private either way: a writable mapping is copy-on-write, and the
+        // file is never modified
+        const int protection = PROT_READ | (writable ? PROT_WRITE : 0);
+        void *ptr = ::mmap(nullptr, size, protection, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        TF_CHECK(ptr != MAP_FAILED, core::IOError, "Failed to map checkpoint " + path);
+
+        const size_t length = size;
+        return std::shared_ptr<char[]>(static_cast<char *>(ptr),
+                                       [length](char *p)
+                                       { ::munmap(p, length); });
+#else
+        (void)writable;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        TF_CHECK(file.is_open(), core::IOError, "Failed to open checkpoint " + path);
+
+        const std::streamoff length = file.tellg();
+        TF_CHECK(length > 0, core::IOError, "Checkpoint " + path + " is empty or unreadable");
+        size = static_cast<size_t>(length);
+
+        std::shared_ptr<char[]> data = allocate_bytes(size);
+        file.seekg(0);
+        file.read(data.get(), length);
+        TF_CHECK(file.good(), core::IOError, "Failed to read checkpoint " + path);
+        return data;
+#endif
+      }
+
+      /**
+       * @brief Advises the kernel that a range will be read soon
+       */
+      void will_need(const char *base, size_t offset, size_t size)
+      {
+#if defined(__linux__) && defined(MADV_WILLNEED)
+        if (size == 0)
+          return;
+
+        // madvise takes page-aligned ranges
+        const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / page * page;
+        ::madvise(const_cast<char *>(base) + begin, offset + size - begin, MADV_WILLNEED);
+#else
+        (void)base;
+        (void)offset;
+        (void)size;
+#endif
+      }
+
+      /**
+       * @brief Parses the entries of a header
+       *
+       * @param data Start of the file, holding at least `available` bytes
+       * @param available Bytes of the file in memory, at least the header
+       * @param file_size Size of the whole file
+       * @param path File name, for messages
+       * @param index Filled with the position of every name
+       */
+      std::vector<CheckpointEntry> parse_header(const char *data, size_t available, size_t file_size,
+                                                const std::string &path,
+                                                std::unordered_map<std::string, size_t> &index)
+      {
+        HeaderReader reader{data, data + available};
+        reader.need(sizeof(MAGIC));
+        TF_CHECK(std::memcmp(reader.pos, MAGIC, sizeof(MAGIC)) == 0, core::IOError,
+                 path + " is not a checkpoint");
+        reader.pos += sizeof(MAGIC);
+
+        TF_CHECK(reader.read<std::uint32_t>() == CHECKPOINT_VERSION, core::IOError,
+                 "Checkpoint version is not supported");
+        const auto count = reader.read<std::uint32_t>();
+        const auto data_offset = reader.read<std::uint64_t>();
+        TF_CHECK(data_offset >= PREAMBLE_SIZE && data_offset <= available, core::IOError,
+                 "Checkpoint header is truncated");
+        reader.end = data + data_offset;
+
+        std::vector<CheckpointEntry> entries;
+        entries.reserve(std::min<size_t>(count, data_offset / ENTRY_SIZE));
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+          const auto name_size = reader.read<std::uint32_t>();
+          const auto dtype = reader.read<std::uint32_t>();
+          const auto rank = reader.read<std::uint32_t>();
+          const auto compression = reader.read<std::uint32_t>();
+          const auto offset = reader.read<std::uint64_t>();
+          const auto size = reader.read<std::uint64_t>();
+
+          TF_CHECK(core::size_of(static_cast<core::DataType>(dtype)) != 0, core::IOError,
+                   "Checkpoint tensor type is unknown");
+          TF_CHECK(compression <= static_cast<std::uint32_t>(Compression::Zstd), core::IOError,
+                   "Checkpoint tensor compression is unknown");
+          TF_CHECK(rank <= MAX_RANK, core::IOError, "Checkpoint tensor rank is too large");
+
+          CheckpointEntry entry;
+          entry.dtype = static_cast<core::DataType>(dtype);
+          entry.compression = static_cast<Compression>(compression);
+
+          core::index_t dims[MAX_RANK];
+          for (std::uint32_t d = 0; d < rank; ++d)
+            dims[d] = reader.read<std::int64_t>();
+          const size_t bytes = checked_bytes(dims, rank, entry.dtype);
+          entry.shape = core::Shape(dims, rank);
+
+          reader.need(name_size);
+          entry.name.assign(reader.pos, name_size);
+          reader.pos += name_size;
+
+          TF_CHECK(entry.compression != Compression::None || size == bytes, core::IOError,
+                   "Checkpoint tensor size does not match its shape");
+          TF_CHECK(offset % CHECKPOINT_ALIGNMENT == 0 && offset >= data_offset &&
+                       offset <= file_size && size <= file_size - offset,
+                   core::IOError, "Checkpoint tensor lies outside the file");
+          entry.offset = static_cast<size_t>(offset);
+          entry.size = static_cast<size_t>(size);
+
+          TF_CHECK(index.emplace(entry.name, entries.size()).second, core::IOError,
+                   "Checkpoint holds two tensors named " + entry.name);
+          entries.push_back(std::move(entry));
+        }
+        return entries;
+      }
+
+      /**
+       * @brief Writes one tensor at the current position
+       *
+       * @return size_t Bytes written
+       */
+      size_t write_tensor(std::ofstream &file, const CheckpointEntry &entry, const char *data,
+                          const CompressionOptions &options)
+      {
+        const size_t raw = entry.data_size();
+        if (options.codec == Compression::None)
+        {
+          file.write(data, static_cast<std::streamsize>(raw));
+          return raw;
+        }
+
+        const size_t rows = entry.rows();
+        const size_t row_bytes = rows == 0 ? 0 : raw / rows;
+        const size_t block_rows = options.block_rows != 0
+                                      ? options.block_rows
+                                      : std::max<size_t>(1, CHECKPOINT_BLOCK_SIZE / std::max<size_t>(row_bytes, 1));
+        const size_t count = (rows + block_rows - 1) / block_rows;
+
+        // The table is written once the block sizes are known
+        std::vector<std::uint64_t> table(2 + count);
+        table[0] = block_rows;
+        table[1] = count;
+        const size_t table_bytes = table.size() * sizeof(std::uint64_t);
+
+        const std::streampos start = file.tellp();
+        file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(table_bytes));
+
+        std::vector<char> scratch(detail::compress_bound(options.codec, std::min(rows, block_rows) * row_bytes));
+        size_t end = table_bytes;
+        for (size_t b = 0; b < count; ++b)
+        {
+          const size_t first = b * block_rows;
+          const size_t bytes = std::min(block_rows, rows - first) * row_bytes;
+          const size_t written = bytes == 0 ? 0
+                                            : detail::compress_block(options.codec, data + first * row_bytes,
+                                                                     bytes, scratch.data(), options.level);
+          file.write(scratch.data(), static_cast<std::streamsize>(written));
+          end += written;
+          table[2 + b] = end;
+        }
+
+        file.seekp(start);
+        file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(table_bytes));
+        file.seekp(start + static_cast<std::streamoff>(end));
+        return end;
+      }
+    } // namespace
+
+    void CheckpointWriter::add(const std::string &name, core::DataType dtype,
+                               const core::Shape &shape, std::shared_ptr<const void> data,
+                               const CompressionOptions &compression)
+    {
+      TF_CHECK(!name.empty(), core::ValueError, "Checkpoint tensor name is empty");
+      TF_CHECK(m_index.count(name) == 0, core::ValueError,
+               "Checkpoint tensor " + name + " is already added");
+      TF_CHECK(core::size_of(dtype) != 0, core::ValueError, "Checkpoint tensor type is unknown");
+      TF_CHECK(compression_available(compression.codec), core::NotImplementedError,
+               "Checkpoint compression codec was not compiled in");
+
+      CheckpointEntry entry;
+      entry.name = name;
+      entry.dtype = dtype;
+      entry.shape = shape;
+      entry.compression = compression.codec;
+      entry.size = entry.data_size();
+      TF_CHECK(data != nullptr || entry.size == 0, core::ValueError,
+               "Checkpoint tensor " + name + " has no data");
+
+      m_index.emplace(name, m_entries.size());
+      m_entries.push_back(std::move(entry));
+      m_data.push_back(std::move(data));
+      m_compression.push_back(compression);
+    }
+
+    void CheckpointWriter::save(const std::string &path) const
+    {
+      check_byte_order();
+
+      size_t header_size = PREAMBLE_SIZE;
+      for (const CheckpointEntry &entry : m_entries)
+        header_size += ENTRY_SIZE + 8 * entry.shape.rank() + entry.name.size();
+      const size_t data_offset = round_up(header_size, CHECKPOINT_ALIGNMENT);
+
+      const std::string temporary = path + ".tmp";
+      {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        TF_CHECK(file.is_open(), core::IOError, "Failed to create checkpoint " + temporary);
+
+        // The data streams out first; compressed sizes are only known once
+        // written, so the header is filled in last
+        std::string header(data_offset, '\0');
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+        const char padding[CHECKPOINT_ALIGNMENT] = {};
+        std::vector<size_t> offsets(m_entries.size()), sizes(m_entries.size());
+        size_t position = data_offset;
+        for (size_t i = 0; i < m_entries.size() && file; ++i)
+        {
+          offsets[i] = position;
+          sizes[i] = write_tensor(file, m_entries[i], static_cast<const char *>(m_data[i].get()),
+                                  m_compression[i]);
+
+          const size_t next = round_up(position + sizes[i], CHECKPOINT_ALIGNMENT);
+          file.write(padding, static_cast<std::streamsize>(next - position - sizes[i]));
+          position = next;
+        }
+
+        header.clear();
+        header.append(MAGIC, sizeof(MAGIC));
+        append(header, CHECKPOINT_VERSION);
+        append(header, static_cast<std::uint32_t>(m_entries.size()));
+        append(header, static_cast<std::uint64_t>(data_offset));
+
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+          const CheckpointEntry &entry = m_entries[i];
+          append(header, static_cast<std::uint32_t>(entry.name.size()));
+          append(header, static_cast<std::uint32_t>(entry.dtype));
+          append(header, static_cast<std::uint32_t>(entry.shape.rank()));
+          append(header, static_cast<std::uint32_t>(entry.compression));
+          append(header, static_cast<std::uint64_t>(offsets[i]));
+          append(header, static_cast<std::uint64_t>(sizes[i]));
+          for (size_t d = 0; d < entry.shape.rank(); ++d)
+            append(header, static_cast<std::int64_t>(entry.shape[d]));
+          header.append(entry.name);
+        }
+
+        file.seekp(0);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        file.flush();
+        if (!file)
+        {
+          file.close();
+          std::remove(temporary.c_str());
+          TF_CHECK(false, core::IOError, "Failed to write checkpoint " + temporary);
+        }
+      }
+
+      if (std::rename(temporary.c_str(), path.c_str()) != 0)
+      {
+        std::remove(temporary.c_str());
+        TF_CHECK(false, core::IOError, "Failed to replace checkpoint " + path);
+      }
+    }
+
+    Checkpoint::Checkpoint(const std::string &path, const CheckpointOptions &options)
+    {
+      check_byte_order();
+
+      m_data = map_file(path, options.writable, m_file_size);
+      if (options.prefetch)
+        will_need(m_data.get(), 0, m_file_size);
+
+      m_entries = parse_header(m_data.get(), m_file_size, m_file_size, path, m_index);
+    }
+
+    const CheckpointEntry &Checkpoint::entry(const std::string &name) const
+    {
+      const auto it = m_index.find(name);
+      TF_CHECK(it != m_index.end(), core::IndexError, "Checkpoint has no tensor " + name);
+      return m_entries[it->second];
+    }
+
+    void Checkpoint::prefetch(const std::string &name) const
+    {
+      const CheckpointEntry &e = entry(name);
+      will_need(m_data.get(), e.offset, e.size);
+    }
+
+    std::shared_ptr<char[]> Checkpoint::decompress(const CheckpointEntry &entry) const
+    {
+      const char *stored = m_data.get() + entry.offset;
+      const detail::BlockTable table = detail::read_block_table(
+          entry, [stored](size_t offset, size_t size, char *out)
+          { std::memcpy(out, stored + offset, size); });
+
+      const size_t rows = entry.rows();
+      const size_t row_bytes = rows == 0 ? 0 : entry.data_size() / rows;
+      std::shared_ptr<char[]> out = allocate_bytes(entry.data_size());
+
+      for (size_t b = 0; b + 1 < table.bounds.size(); ++b)
+      {
+        const size_t first = b * table.block_rows;
+        const size_t raw = std::min(table.block_rows, rows - first) * row_bytes;
+        if (raw != 0)
+          detail::decompress_block(entry.compression, stored + table.bounds[b],
+                                   table.bounds[b + 1] - table.bounds[b],
+                                   out.get() + first * row_bytes, raw);
+      }
+      return out;
+    }
+
+    std::vector<CheckpointEntry> read_checkpoint_index(const std::string &path)
+    {
+      check_byte_order();
+
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      TF_CHECK(file.is_open(), core::IOError, "Failed to open checkpoint " + path);
+      const std::streamoff file_size = file.tellg();
+      file.seekg(0);
+
+      // The preamble gives the size of the rest of the header
+      std::string header(PREAMBLE_SIZE, '\0');
+      file.read(header.data(), static_cast<std::streamsize>(header.size()));
+      TF_CHECK(file.good() && std::memcmp(header.data(), MAGIC, sizeof(MAGIC)) == 0, core::IOError,
+               path + " is not a checkpoint");
+
+      std::uint64_t data_offset;
+      std::memcpy(&data_offset, header.data() + PREAMBLE_SIZE - sizeof(data_offset), sizeof(data_offset));
+      TF_CHECK(data_offset >= PREAMBLE_SIZE && data_offset <= static_cast<std::uint64_t>(file_size),
+               core::IOError, "Checkpoint header is truncated");
+
+      header.resize(static_cast<size_t>(data_offset));
+      file.read(header.data() + PREAMBLE_SIZE, static_cast<std::streamsize>(data_offset - PREAMBLE_SIZE));
+      TF_CHECK(file.good(), core::IOError, "Failed to read checkpoint " + path);
+
+      std::unordered_map<std::string, size_t> index;
+      return parse_header(header.data(), header.size(), static_cast<size_t>(file_size), path, index);
+    }
+  } // namespace utils
+} // namespace tf
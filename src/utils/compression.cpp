@@ -0,0 +1,162 @@
+#include "utils/compression.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <string>
+
+#if defined(TF_LZ4_ENABLED)
+#include <lz4.h>
+#endif
+#if defined(TF_ZSTD_ENABLED)
+#include <zstd.h>
+#endif
+
+namespace tf
+{
+  namespace utils
+  {
+    bool compression_available(Compression codec)
+    {
+      switch (codec)
+      {
+      case Compression::None:
+        return true;
+      case Compression::LZ4:
+#if defined(TF_LZ4_ENABLED)
+        return true;
+#else
+        return false;
+#endif
+      case Compression::Zstd:
+#if defined(TF_ZSTD_ENABLED)
+        return true;
+#else
+        return false;
+#endif
+      }
+      return false;
+    }
+
+    namespace detail
+    {
+      BlockTable read_block_table(const CheckpointEntry &entry, const ReadBytes &read)
+      {
+        TF_CHECK(entry.size >= 2 * sizeof(std::uint64_t), core::IOError,
+                 "Checkpoint block table is truncated");
+
+        std::uint64_t head[2];
+        read(0, sizeof(head), reinterpret_cast<char *>(head));
+
+        const size_t rows = entry.rows();
+        BlockTable table;
+        table.block_rows = static_cast<size_t>(head[0]);
+        const auto count = static_cast<size_t>(head[1]);
+
+        const size_t expected = rows == 0 || table.block_rows == 0
+                                    ? 0
+                                    : (rows + table.block_rows - 1) / table.block_rows;
+        TF_CHECK(count == expected && (rows == 0 || table.block_rows > 0), core::IOError,
+                 "Checkpoint block count does not match the shape");
+        TF_CHECK(count <= (entry.size - sizeof(head)) / sizeof(std::uint64_t), core::IOError,
+                 "Checkpoint block table is truncated");
+
+        std::vector<std::uint64_t> ends(count);
+        if (count > 0)
+          read(sizeof(head), count * sizeof(std::uint64_t), reinterpret_cast<char *>(ends.data()));
+
+        table.bounds.resize(count + 1);
+        table.bounds[0] = sizeof(head) + count * sizeof(std::uint64_t);
+        for (size_t b = 0; b < count; ++b)
+        {
+          TF_CHECK(ends[b] >= table.bounds[b] && ends[b] <= entry.size, core::IOError,
+                   "Checkpoint block lies outside its tensor");
+          table.bounds[b + 1] = static_cast<size_t>(ends[b]);
+        }
+        return table;
+      }
+
+      size_t compress_bound(Compression codec, size_t size)
+      {
+        switch (codec)
+        {
+#if defined(TF_LZ4_ENABLED)
+        case Compression::LZ4:
+          TF_CHECK(size <= LZ4_MAX_INPUT_SIZE, core::ValueError, "LZ4 block is too large");
+          return static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+#endif
+#if defined(TF_ZSTD_ENABLED)
+        case Compression::Zstd:
+          return ZSTD_compressBound(size);
+#endif
+        default:
+          return size;
+        }
+      }
+
+      size_t compress_block(Compression codec, const char *src, size_t size, char *dst, int level)
+      {
+        const size_t capacity = compress_bound(codec, size);
+        switch (codec)
+        {
+#if defined(TF_LZ4_ENABLED)
+        case Compression::LZ4:
+        {
+          // LZ4 levels are acceleration factors: higher is faster
+          const int written = LZ4_compress_fast(src, dst, static_cast<int>(size),
+                                                static_cast<int>(capacity), level > 0 ? level : 1);
+          TF_CHECK(written > 0 || size == 0, core::IOError, "LZ4 compression failed");
+          return static_cast<size_t>(written);
+        }
+#endif
+#if defined(TF_ZSTD_ENABLED)
+        case Compression::Zstd:
+        {
+          const size_t written = ZSTD_compress(dst, capacity, src, size,
+                                               level != 0 ? level : ZSTD_CLEVEL_DEFAULT);
+          TF_CHECK(!ZSTD_isError(written), core::IOError,
+                   std::string("Zstd compression failed: ") + ZSTD_getErrorName(written));
+          return written;
+        }
+#endif
+        default:
+          (void)src;
+          (void)dst;
+          (void)level;
+          (void)capacity;
+          throw core::NotImplementedError("Compression codec was not compiled in");
+        }
+      }
+
+      void decompress_block(Compression codec, const char *src, size_t size, char *dst, size_t raw)
+      {
+        switch (codec)
+        {
+#if defined(TF_LZ4_ENABLED)
+        case Compression::LZ4:
+        {
+          TF_CHECK(size <= INT_MAX && raw <= INT_MAX, core::IOError, "LZ4 block is too large");
+          const int read = LZ4_decompress_safe(src, dst, static_cast<int>(size), static_cast<int>(raw));
+          TF_CHECK(read >= 0 && static_cast<size_t>(read) == raw, core::IOError,
+                   "LZ4 block is corrupt");
+          return;
+        }
+#endif
+#if defined(TF_ZSTD_ENABLED)
+        case Compression::Zstd:
+        {
+          const size_t read = ZSTD_decompress(dst, raw, src, size);
+          TF_CHECK(!ZSTD_isError(read) && read == raw, core::IOError, "Zstd block is corrupt");
+          return;
+        }
+#endif
+        default:
+          (void)src;
+          (void)size;
+          (void)dst;
+          (void)raw;
+          throw core::NotImplementedError("Compression codec was not compiled in");
+        }
+      }
+    } // namespace detail
+  } // namespace utils
+} // namespace tf
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <tf/utils/checkpoint.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace tf
+{
+  namespace utils
+  {
+    namespace detail
+    {
+      /**
+       * @struct BlockTable
+       * @brief Layout of a compressed checkpoint tensor
+       */
+      struct BlockTable
+      {
+        size_t block_rows = 0;      ///< Rows per block, the last one possibly shorter
+        std::vector<size_t> bounds; ///< Start of every block and end of the last, from the tensor's data
+      };
+
+      /**
+       * @brief Reads bytes [offset, offset + size) of a tensor's data
+       */
+      using ReadBytes = std::function<void(size_t offset, size_t size, char *out)>;
+
+      /**
+       * @brief Reads and checks the block table of a compressed tensor
+       *
+       * @param entry Compressed entry
+       * @param read Reader over the entry's stored bytes
+       * @return BlockTable Table whose blocks lie within entry.size
+       * @throw IOError if the table is inconsistent with the entry
+       */
+      BlockTable read_block_table(const CheckpointEntry &entry, const ReadBytes &read);
+
+      /**
+       * @brief Gets the largest compressed size of a block
+       *
+       * @param codec Compiled-in codec
+       * @param size Uncompressed bytes
+       * @return size_t Capacity compress_block needs
+       */
+      size_t compress_bound(Compression codec, size_t size);
+
+      /**
+       * @brief Compresses one block
+       *
+       * @param codec Compiled-in codec
+       * @param src Uncompressed bytes
+       * @param size Number of uncompressed bytes
+       * @param dst Output of compress_bound(codec, size) bytes
+       * @param level Codec level, 0 for its default
+       * @return size_t Compressed bytes
+       * @throw IOError if the codec fails
+       */
+      size_t compress_block(Compression codec, const char *src, size_t size, char *dst, int level);
+
+      /**
+       * @brief Decompresses one block
+       *
+       * @param codec Codec
+       * @param src Compressed bytes
+       * @param size Number of compressed bytes
+       * @param dst Output
+       * @param raw Exact uncompressed size
+       * @throw IOError if the block is corrupt or does not inflate to raw
+       * bytes
+       * @throw NotImplementedError if the codec was not compiled in
+       */
+      void decompress_block(Compression codec, const char *src, size_t size, char *dst, size_t raw);
+    } // namespace detail
+  } // namespace utils
+} // namespace tf
@@ -0,0 +1,266 @@
+#include <tf/utils/page_allocator.hpp>
+#include <tf/utils/memory.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tf
+{
+  namespace utils
+  {
+    namespace
+    {
+      constexpr size_t SMALL_PAGE = 4 * 1024;
+      constexpr size_t HUGE_2M = 2 * 1024 * 1024;
+      constexpr size_t HUGE_1G = 1024 * 1024 * 1024;
+
+      size_t round_up(size_t value, size_t multiple)
+      {
+        return (value + multiple - 1) / multiple * multiple;
+      }
+
+      /**
+       * @brief Parses a sysfs CPU/node list such as "0-3,8,10-11"
+       */
+      std::vector<int> parse_list(const std::string &text)
+      {
+        std::vector<int> values;
+        std::stringstream stream(text);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+          if (item.empty() || item == "\n")
+            continue;
+
+          size_t dash = item.find('-');
+          int first = std::stoi(item.substr(0, dash));
+          int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+
+          for (int v = first; v <= last; ++v)
+            values.push_back(v);
+        }
+
+        return values;
+      }
+
+      std::string read_file(const std::string &path)
+      {
+        std::ifstream file(path);
+        std::string text;
+        std::getline(file, text);
+        return text;
+      }
+
+#if defined(__linux__)
+      // Memory policy modes from <linux/mempolicy.h>; the raw syscall avoids
+      // a dependency on libnuma.
+      constexpr int TF_MPOL_PREFERRED = 1;
+      constexpr int TF_MPOL_BIND = 2;
+      constexpr int TF_MPOL_INTERLEAVE = 3;
+
+      void apply_numa_policy(void *ptr, size_t size, const AllocationPolicy &policy)
+      {
+#if defined(SYS_mbind)
+        int mode = 0;
+        switch (policy.numa)
+        {
+        case NumaPolicy::Bind:
+          mode = TF_MPOL_BIND;
+          break;
+        case NumaPolicy::Preferred:
+          mode = TF_MPOL_PREFERRED;
+          break;
+        case NumaPolicy::Interleave:
+          mode = TF_MPOL_INTERLEAVE;
+          break;
+        case NumaPolicy::Default:
+        default:
+          return;
+        }
+
+        std::vector<int> nodes = policy.nodes;
+        if (nodes.empty())
+          for (int n = 0; n < numa_node_count(); ++n)
+            nodes.push_back(n);
+
+        // Preferred takes a single node
+        if (policy.numa == NumaPolicy::Preferred)
+          nodes.resize(1);
+
+        constexpr size_t BITS = 8 * sizeof(unsigned long);
+        int max_node = 0;
+        for (int n : nodes)
+          max_node = std::max(max_node, n);
+
+        std::vector<unsigned long> mask(static_cast<size_t>(max_node) / BITS + 1, 0);
+        for (int n : nodes)
+          if (n >= 0)
+            mask[static_cast<size_t>(n) / BITS] |= 1ul << (static_cast<size_t>(n) % BITS);
+
+        // The kernel reads maxnode - 1 bits. Failure (unknown node, no NUMA
+        // support, sandboxing) keeps the default placement.
+        syscall(SYS_mbind, ptr, size, mode, mask.data(), mask.size() * BITS + 1, 0u);
+#else
+        (void)ptr;
+        (void)size;
+        (void)policy;
+#endif
+      }
+
+      void *map_hugetlb(size_t size, size_t page, int log2_page)
+      {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        void *ptr = mmap(nullptr, round_up(size, page), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2_page << MAP_HUGE_SHIFT),
+                         -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+        (void)size;
+        (void)page;
+        (void)log2_page;
+        return nullptr;
+#endif
+      }
+
+      /**
+       * @brief Maps regular pages aligned to `alignment`
+       *
+       * Over-maps by the alignment and unmaps the unaligned head and tail.
+       */
+      void *map_aligned(size_t size, size_t alignment)
+      {
+        const size_t length = size + (alignment > SMALL_PAGE ? alignment : 0);
+        void *raw = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+          return nullptr;
+
+        char *begin = static_cast<char *>(raw);
+        char *aligned = align_pointer(begin, alignment);
+        char *end = begin + length;
+
+        if (aligned > begin)
+          munmap(begin, static_cast<size_t>(aligned - begin));
+        if (end > aligned + size)
+          munmap(aligned + size, static_cast<size_t>(end - (aligned + size)));
+
+        return aligned;
+      }
+#endif
+    } // namespace
+
+    PageAllocation allocate_pages(size_t size, const AllocationPolicy &policy)
+    {
+      PageAllocation allocation;
+      size = std::max<size_t>(size, 1);
+
+#if defined(__linux__)
+      if (policy.page_size == PageSize::Huge1G)
+      {
+        allocation.ptr = map_hugetlb(size, HUGE_1G, 30);
+        allocation.size = round_up(size, HUGE_1G);
+        allocation.page_size = PageSize::Huge1G;
+      }
+
+      if (!allocation.ptr &&
+          (policy.page_size == PageSize::Huge1G || policy.page_size == PageSize::Huge2M))
+      {
+        allocation.ptr = map_hugetlb(size, HUGE_2M, 21);
+        allocation.size = round_up(size, HUGE_2M);
+        allocation.page_size = PageSize::Huge2M;
+      }
+
+      if (!allocation.ptr)
+      {
+        // Transparent huge pages need 2 MB-aligned ranges to be used
+        const bool thp = policy.page_size != PageSize::Default;
+        const size_t page = thp ? HUGE_2M : SMALL_PAGE;
+
+        allocation.size = round_up(size, page);
+        allocation.ptr = map_aligned(allocation.size, page);
+        allocation.page_size = thp ? PageSize::Transparent : PageSize::Default;
+
+#if defined(MADV_HUGEPAGE)
+        if (allocation.ptr && thp)
+          madvise(allocation.ptr, allocation.size, MADV_HUGEPAGE);
+#endif
+      }
+
+      TF_CHECK(allocation.ptr != nullptr, core::MemoryError, "Failed to map pages");
+
+      allocation.mapped = true;
+      apply_numa_policy(allocation.ptr, allocation.size, policy);
+#else
+      // No page-level control: fall back to aligned heap memory
+      const size_t page = policy.page_size == PageSize::Default ? SMALL_PAGE : HUGE_2M;
+      allocation.size = round_up(size, page);
+      allocation.ptr = ::operator new(allocation.size, std::align_val_t{page});
+      std::memset(allocation.ptr, 0, allocation.size);
+      allocation.page_size = policy.page_size == PageSize::Default ? PageSize::Default
+                                                                   : PageSize::Transparent;
+#endif
+
+      return allocation;
+    }
+
+    void free_pages(const PageAllocation &allocation)
+    {
+      if (!allocation.ptr)
+        return;
+
+#if defined(__linux__)
+      if (allocation.mapped)
+      {
+        munmap(allocation.ptr, allocation.size);
+        return;
+      }
+#endif
+
+      const size_t page = allocation.page_size == PageSize::Default ? SMALL_PAGE : HUGE_2M;
+      ::operator delete(allocation.ptr, std::align_val_t{page});
+    }
+
+    int numa_node_count()
+    {
+      static const int count = []
+      {
+        std::vector<int> nodes = parse_list(read_file("/sys/devices/system/node/online"));
+        return nodes.empty() ? 1 : nodes.back() + 1;
+      }();
+
+      return count;
+    }
+
+    std::vector<int> numa_node_cpus(int node)
+    {
+      if (node < 0)
+        return {};
+
+      std::string text = read_file("/sys/devices/system/node/node" +
+                                   std::to_string(node) + "/cpulist");
+      if (text.empty() && node == 0)
+      {
+        // No NUMA information: every CPU is on node 0
+        std::vector<int> cpus;
+        for (unsigned i = 0; i < std::thread::hardware_concurrency(); ++i)
+          cpus.push_back(static_cast<int>(i));
+        return cpus;
+      }
+
+      return parse_list(text);
+    }
+  } // namespace utils
+} // namespace tf
@@ -0,0 +1,372 @@
+#include <tf/utils/tensor_stream.hpp>
+#include <tf/utils/memory.hpp>
+#include "utils/compression.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+namespace tf
+{
+  namespace utils
+  {
+    namespace detail
+    {
+      /**
+       * @struct StreamState
+       * @brief Everything a TensorStream shares with its threads and with
+       * the leases of live batches
+       */
+      struct StreamState
+      {
+        std::string path;
+        StreamOptions options;
+        std::vector<CheckpointEntry> entries;
+        std::vector<BlockTable> tables; ///< Per entry; empty for uncompressed ones
+        std::vector<size_t> row_bytes;
+        size_t rows = 0;
+        size_t batches = 0;
+
+        MemoryPool pool;
+        std::vector<std::vector<char *>> slots; ///< Per buffer, one region per entry
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<size_t> free;         ///< Buffers ready to be filled
+        std::map<size_t, size_t> ready;   ///< Filled buffer of each batch, by batch index
+        size_t claimed = 0;               ///< Next batch a thread will take
+        size_t filling = 0;               ///< Buffers being filled
+        bool stopping = false;
+        std::exception_ptr error;
+
+        explicit StreamState(size_t capacity) : pool(std::max<size_t>(capacity, 1)) {}
+
+        ~StreamState()
+        {
+          for (std::vector<char *> &slot : slots)
+            for (char *region : slot)
+              pool.deallocate(region);
+        }
+      };
+    } // namespace detail
+
+    namespace
+    {
+      using detail::StreamState;
+
+      /**
+       * @brief Reads bytes at a position of the file, or fails
+       */
+      void read_at(std::ifstream &file, size_t offset, size_t size, char *out)
+      {
+        if (size == 0)
+          return;
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(out, static_cast<std::streamsize>(size));
+        TF_CHECK(file.good(), core::IOError, "Failed to read streamed checkpoint");
+      }
+
+      /**
+       * @struct BlockCache
+       * @brief Last block a thread decompressed for one tensor, reused
+       * while batches are smaller than blocks
+       */
+      struct BlockCache
+      {
+        size_t block = static_cast<size_t>(-1);
+        std::vector<char> data;
+      };
+
+      /**
+       * @brief Reads rows [first, first + count) of a compressed tensor
+       */
+      void read_compressed(std::ifstream &file, const CheckpointEntry &entry,
+                           const detail::BlockTable &table, size_t row_bytes, size_t first,
+                           size_t count, char *out, std::vector<char> &stored, BlockCache &cache)
+      {
+        const size_t rows = entry.rows();
+        const size_t last = first + count;
+
+        for (size_t b = first / table.block_rows; b * table.block_rows < last; ++b)
+        {
+          const size_t block_first = b * table.block_rows;
+          const size_t block_rows = std::min(table.block_rows, rows - block_first);
+          const size_t raw = block_rows * row_bytes;
+          const size_t begin = std::max(first, block_first);
+          const size_t end = std::min(last, block_first + block_rows);
+
+          // A block wholly inside the batch decompresses in place
+          const bool whole = begin == block_first && end == block_first + block_rows;
+          char *target = out + (begin - first) * row_bytes;
+
+          if (raw != 0 && (whole || cache.block != b))
+          {
+            const size_t size = table.bounds[b + 1] - table.bounds[b];
+            stored.resize(size);
+            read_at(file, entry.offset + table.bounds[b], size, stored.data());
+
+            if (!whole)
+            {
+              cache.data.resize(raw);
+              cache.block = b;
+            }
+            detail::decompress_block(entry.compression, stored.data(), size,
+                                     whole ? target : cache.data.data(), raw);
+          }
+
+          if (!whole)
+            std::memcpy(target, cache.data.data() + (begin - block_first) * row_bytes,
+                        (end - begin) * row_bytes);
+        }
+      }
+
+      void fill(StreamState &state, std::ifstream &file, size_t batch, const std::vector<char *> &slot,
+                std::vector<char> &stored, std::vector<BlockCache> &caches)
+      {
+        const size_t first = batch * state.options.batch_size;
+        const size_t count = std::min(state.options.batch_size, state.rows - first);
+
+        for (size_t t = 0; t < state.entries.size(); ++t)
+        {
+          const CheckpointEntry &entry = state.entries[t];
+          const size_t row_bytes = state.row_bytes[t];
+
+          if (entry.compression == Compression::None)
+            read_at(file, entry.offset + first * row_bytes, count * row_bytes, slot[t]);
+          else
+            read_compressed(file, entry, state.tables[t], row_bytes, first, count, slot[t], stored,
+                            caches[t]);
+        }
+      }
+
+      /**
+       * @brief Body of a background thread: claims free buffers and fills
+       * them with the next unclaimed batches
+       */
+      void run_worker(const std::shared_ptr<StreamState> &shared)
+      {
+        StreamState &state = *shared;
+        std::ifstream file;
+        // Reads are large: let them go straight to the file
+        file.rdbuf()->pubsetbuf(nullptr, 0);
+        file.open(state.path, std::ios::binary);
+
+        std::vector<char> stored;
+        std::vector<BlockCache> caches(state.entries.size());
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        for (;;)
+        {
+          state.changed.wait(lock, [&]
+                             { return state.stopping || state.claimed == state.batches ||
+                                      (!state.free.empty() && !state.error); });
+          if (state.stopping || state.claimed == state.batches || state.error)
+            return;
+
+          const size_t slot = state.free.back();
+          state.free.pop_back();
+          const size_t batch = state.claimed++;
+          ++state.filling;
+          lock.unlock();
+
+          std::exception_ptr error;
+          try
+          {
+            TF_CHECK(file.is_open(), core::IOError, "Failed to open streamed checkpoint " + state.path);
+            fill(state, file, batch, state.slots[slot], stored, caches);
+          }
+          catch (...)
+          {
+            error = std::current_exception();
+          }
+
+          lock.lock();
+          --state.filling;
+          if (error)
+          {
+            state.free.push_back(slot);
+            if (!state.error)
+              state.error = error;
+          }
+          else
+            state.ready.emplace(batch, slot);
+          state.changed.notify_all();
+        }
+      }
+    } // namespace
+
+    TensorStream::TensorStream(const std::string &path, const std::vector<std::string> &names,
+                               const StreamOptions &options)
+    {
+      TF_CHECK(!names.empty(), core::ValueError, "Stream needs at least one tensor");
+      TF_CHECK(options.batch_size > 0 && options.buffers > 0 && options.io_threads > 0,
+               core::ValueError, "Stream batch size, buffers and threads must be positive");
+
+      const std::vector<CheckpointEntry> index = read_checkpoint_index(path);
+      std::vector<CheckpointEntry> entries;
+      for (const std::string &name : names)
+      {
+        const auto it = std::find_if(index.begin(), index.end(), [&](const CheckpointEntry &e)
+                                     { return e.name == name; });
+        TF_CHECK(it != index.end(), core::IndexError, "Checkpoint has no tensor " + name);
+        TF_CHECK(it->shape.rank() > 0, core::ShapeError, "Streamed tensor " + name + " is a scalar");
+        TF_CHECK(entries.empty() || it->shape[0] == entries.front().shape[0], core::ShapeError,
+                 "Streamed tensors differ in their first dimension");
+        TF_CHECK(compression_available(it->compression), core::NotImplementedError,
+                 "Streamed tensor " + name + " uses a codec that was not compiled in");
+        entries.push_back(*it);
+      }
+
+      const size_t rows = entries.front().rows();
+      size_t batch_bytes = 0;
+      std::vector<size_t> row_bytes;
+      for (const CheckpointEntry &entry : entries)
+      {
+        row_bytes.push_back(rows == 0 ? 0 : entry.data_size() / rows);
+        batch_bytes += row_bytes.back() * options.batch_size + DEFAULT_ALIGNMENT + detail::POOL_HEADER_SIZE;
+      }
+
+      m_state = std::make_shared<detail::StreamState>(batch_bytes * options.buffers);
+      detail::StreamState &state = *m_state;
+      state.path = path;
+      state.options = options;
+      state.entries = std::move(entries);
+      state.row_bytes = std::move(row_bytes);
+      state.rows = rows;
+      state.batches = options.drop_last ? rows / options.batch_size
+                                        : (rows + options.batch_size - 1) / options.batch_size;
+
+      {
+        std::ifstream file(path, std::ios::binary);
+        TF_CHECK(file.is_open(), core::IOError, "Failed to open streamed checkpoint " + path);
+        state.tables.resize(state.entries.size());
+        for (size_t t = 0; t < state.entries.size(); ++t)
+        {
+          const CheckpointEntry &entry = state.entries[t];
+          if (entry.compression != Compression::None)
+            state.tables[t] = detail::read_block_table(
+                entry, [&](size_t offset, size_t size, char *out)
+                { read_at(file, entry.offset + offset, size, out); });
+        }
+      }
+
+      state.slots.resize(options.buffers);
+      for (size_t s = 0; s < options.buffers; ++s)
+      {
+        for (size_t t = 0; t < state.entries.size(); ++t)
+          state.slots[s].push_back(static_cast<char *>(
+              state.pool.allocate(std::max<size_t>(state.row_bytes[t] * options.batch_size, 1))));
+        state.free.push_back(options.buffers - 1 - s);
+      }
+
+      start();
+    }
+
+    TensorStream::~TensorStream()
+    {
+      stop();
+    }
+
+    void TensorStream::start()
+    {
+      for (size_t i = 0; i < m_state->options.io_threads; ++i)
+        m_workers.emplace_back(run_worker, m_state);
+    }
+
+    void TensorStream::stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->stopping = true;
+      }
+      m_state->changed.notify_all();
+
+      for (std::thread &worker : m_workers)
+        worker.join();
+      m_workers.clear();
+    }
+
+    std::optional<StreamBatch> TensorStream::next()
+    {
+      detail::StreamState &state = *m_state;
+      if (m_next == state.batches)
+        return std::nullopt;
+
+      std::unique_lock<std::mutex> lock(state.mutex);
+      auto it = state.ready.end();
+      for (;;)
+      {
+        if (state.error)
+          std::rethrow_exception(state.error);
+
+        it = state.ready.find(m_next);
+        if (it != state.ready.end())
+          break;
+
+        // Batches are claimed in order, so an unclaimed next batch with no
+        // buffer free or in flight can only mean the caller holds them all
+        TF_CHECK(!(state.claimed == m_next && state.free.empty() && state.filling == 0),
+                 core::ValueError, "Every stream buffer is held by a live batch");
+        state.changed.wait(lock);
+      }
+
+      const size_t slot = it->second;
+      state.ready.erase(it);
+      lock.unlock();
+
+      StreamBatch batch;
+      batch.m_index = m_next;
+      batch.m_first_row = m_next * state.options.batch_size;
+      batch.m_rows = std::min(state.options.batch_size, state.rows - batch.m_first_row);
+      batch.m_data = state.slots[slot];
+
+      for (const CheckpointEntry &entry : state.entries)
+      {
+        core::shape_t dims(entry.shape.begin(), entry.shape.end());
+        dims[0] = static_cast<core::index_t>(batch.m_rows);
+        batch.m_types.push_back(entry.dtype);
+        batch.m_shapes.emplace_back(dims);
+      }
+
+      // The buffer goes back to the free list with the last view of the batch
+      std::shared_ptr<detail::StreamState> shared = m_state;
+      batch.m_lease = std::shared_ptr<void>(nullptr, [shared, slot](void *)
+                                            {
+                                              {
+                                                std::lock_guard<std::mutex> guard(shared->mutex);
+                                                shared->free.push_back(slot);
+                                              }
+                                              shared->changed.notify_all(); });
+
+      ++m_next;
+      return batch;
+    }
+
+    void TensorStream::reset()
+    {
+      stop();
+
+      detail::StreamState &state = *m_state;
+      {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto &[batch, slot] : state.ready)
+          state.free.push_back(slot);
+        state.ready.clear();
+        state.claimed = 0;
+        state.stopping = false;
+        state.error = nullptr;
+      }
+
+      m_next = 0;
+      start();
+    }
+
+    size_t TensorStream::num_rows() const { return m_state->rows; }
+    size_t TensorStream::num_batches() const { return m_state->batches; }
+    const std::vector<CheckpointEntry> &TensorStream::entries() const { return m_state->entries; }
+  } // namespace utils
+} // namespace tf
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <tf/core/common.hpp>
+#include <tf/core/config.hpp>
+#include <tf/core/thread_pool.hpp>
+#include <tf/utils/arena.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+using namespace tf::utils;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for arena tests.
+   *
+   */
+  class ArenaTest : public ::testing::Test
+  {
+  protected:
+    Arena arena{4096};
+  };
+
+  TEST_F(ArenaTest, AllocationsAreAligned)
+  {
+    for (size_t alignment = 1; alignment <= 1024; alignment *= 2)
+    {
+      arena.allocate(3, 1);
+      void *ptr = arena.allocate(17, alignment);
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0u) << alignment;
+    }
+
+    double *values = arena.allocate_array<double>(10);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(values) % DEFAULT_ALIGNMENT, 0u);
+
+    EXPECT_THROW(arena.allocate(8, 3), tf::core::ValueError);
+  }
+
+  TEST_F(ArenaTest, RewindReusesMemory)
+  {
+    void *first = arena.allocate(100);
+    Arena::Marker marker = arena.marker();
+
+    void *second = arena.allocate(200);
+    arena.allocate(300);
+    EXPECT_NE(first, second);
+
+    arena.rewind(marker);
+    EXPECT_EQ(arena.allocate(200), second);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_EQ(arena.allocate(100), first);
+  }
+
+  TEST_F(ArenaTest, GrowsForLargeAllocations)
+  {
+    arena.allocate(1000);
+    char *large = static_cast<char *>(arena.allocate(64 * 1024));
+    large[0] = 1;
+    large[64 * 1024 - 1] = 2;
+
+    EXPECT_GE(arena.num_chunks(), 2u);
+    EXPECT_GE(arena.capacity(), 64u * 1024u + 1000u);
+
+    // Steady state: repeating the same pattern adds no chunks
+    const size_t chunks = arena.num_chunks();
+    const size_t capacity = arena.capacity();
+    for (int i = 0; i < 10; ++i)
+    {
+      arena.reset();
+      arena.allocate(1000);
+      EXPECT_EQ(arena.allocate(64 * 1024), large);
+    }
+    EXPECT_EQ(arena.num_chunks(), chunks);
+    EXPECT_EQ(arena.capacity(), capacity);
+  }
+
+  TEST_F(ArenaTest, ReplacesChunksThatAreTooSmall)
+  {
+    arena.allocate(100);
+    arena.reset();
+
+    // The retained first chunk is too small and gets replaced
+    char *ptr = static_cast<char *>(arena.allocate(32 * 1024));
+    ptr[32 * 1024 - 1] = 1;
+    EXPECT_EQ(arena.num_chunks(), 1u);
+    EXPECT_GE(arena.capacity(), 32u * 1024u);
+  }
+
+  TEST_F(ArenaTest, CheckpointRewindsOnExit)
+  {
+    arena.allocate(128);
+    const size_t used = arena.bytes_used();
+
+    {
+      ArenaCheckpoint checkpoint(arena);
+      arena.allocate(512);
+      EXPECT_GT(arena.bytes_used(), used);
+    }
+
+    EXPECT_EQ(arena.bytes_used(), used);
+    EXPECT_EQ(current_arena(), nullptr);
+  }
+
+  TEST_F(ArenaTest, ScopesNest)
+  {
+    Arena other(4096);
+    EXPECT_EQ(current_arena(), nullptr);
+
+    {
+      ArenaScope outer(arena);
+      EXPECT_EQ(current_arena(), &arena);
+      arena.allocate(64);
+
+      {
+        ArenaScope inner(other);
+        EXPECT_EQ(current_arena(), &other);
+        EXPECT_EQ(&inner.arena(), &other);
+        other.allocate(64);
+      }
+
+      EXPECT_EQ(current_arena(), &arena);
+      EXPECT_EQ(other.bytes_used(), 0u);
+      EXPECT_GT(arena.bytes_used(), 0u);
+    }
+
+    EXPECT_EQ(current_arena(), nullptr);
+    EXPECT_EQ(arena.bytes_used(), 0u);
+
+    {
+      ArenaScope scope;
+      EXPECT_EQ(current_arena(), &thread_arena());
+    }
+    EXPECT_EQ(current_arena(), nullptr);
+  }
+
+  TEST_F(ArenaTest, MemoryAllocatesFromCurrentScope)
+  {
+    float *previous = nullptr;
+
+    for (int step = 0; step < 3; ++step)
+    {
+      ArenaScope scope(arena);
+
+      auto buffer = tf::core::Memory<float>::allocate(256);
+      EXPECT_GT(arena.bytes_used(), 256u * sizeof(float));
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.get()) % alignof(float), 0u);
+
+      for (size_t i = 0; i < 256; ++i)
+      {
+        EXPECT_EQ(buffer[i], 0.0f);
+        buffer[i] = static_cast<float>(step);
+      }
+
+      // Every step reuses the same memory
+      if (previous)
+        EXPECT_EQ(buffer.get(), previous);
+      previous = buffer.get();
+    }
+
+    EXPECT_EQ(arena.bytes_used(), 0u);
+
+    // Outside any scope the heap is used
+    auto heap = tf::core::Memory<float>::allocate(256);
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_NE(heap.get(), previous);
+  }
+
+  TEST_F(ArenaTest, ParallelChunksDoNotUseScope)
+  {
+    const int threads = tf::core::config().num_threads();
+    tf::core::config().set_num_threads(4);
+
+    ArenaScope scope(arena);
+    std::atomic<size_t> in_scope{0};
+
+    tf::core::parallel_for(0, 64, 1, [&](size_t, size_t)
+                           {
+                             if (current_arena() != nullptr)
+                               in_scope.fetch_add(1);
+                             auto buffer = tf::core::Memory<int>::allocate(16);
+                             buffer[0] = 1; });
+
+    EXPECT_EQ(in_scope.load(), 0u);
+    EXPECT_EQ(current_arena(), &arena);
+    EXPECT_EQ(arena.bytes_used(), 0u);
+
+    tf::core::config().set_num_threads(threads);
+  }
+} // namespace test
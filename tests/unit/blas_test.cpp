@@ -0,0 +1,873 @@
+#include <gtest/gtest.h>
+#include <tf/math/blas.hpp>
+#include <tf/math/random.hpp>
+#include <tf/math/utils.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <tuple>
+
+using namespace tf::math;
+
+namespace test
+{
+  /**
+   * @brief Reference row-major GEMM used to validate the optimized kernels
+   */
+  template <typename T>
+  void reference_gemm(BlasOperation transa, BlasOperation transb,
+                      size_t m, size_t n, size_t k, T alpha,
+                      const T *A, size_t lda, const T *B, size_t ldb,
+                      T beta, T *C, size_t ldc)
+  {
+    bool ta = transa != BlasOperation::NoTrans;
+    bool tb = transb != BlasOperation::NoTrans;
+
+    for (size_t i = 0; i < m; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        double sum = 0.0;
+        for (size_t p = 0; p < k; ++p)
+        {
+          T a = ta ? A[p * lda + i] : A[i * lda + p];
+          T b = tb ? B[j * ldb + p] : B[p * ldb + j];
+          sum += static_cast<double>(a) * static_cast<double>(b);
+        }
+
+        T c = beta == T{0} ? T{0} : beta * C[i * ldc + j];
+        C[i * ldc + j] = static_cast<T>(alpha * sum) + c;
+      }
+    }
+  }
+
+  template <typename T>
+  class BlasGemmTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(7);
+    }
+
+    void run(BlasOperation transa, BlasOperation transb,
+             size_t m, size_t n, size_t k, T alpha, T beta, size_t pad = 0)
+    {
+      bool ta = transa != BlasOperation::NoTrans;
+      bool tb = transb != BlasOperation::NoTrans;
+
+      size_t lda = (ta ? m : k) + pad;
+      size_t ldb = (tb ? k : n) + pad;
+      size_t ldc = n + pad;
+
+      std::vector<T> A((ta ? k : m) * lda);
+      std::vector<T> B((tb ? n : k) * ldb);
+      std::vector<T> C(m * ldc);
+
+      auto &rng = RandomGenerator::instance();
+      rng.fill_uniform(A.data(), A.size(), T{-1}, T{1});
+      rng.fill_uniform(B.data(), B.size(), T{-1}, T{1});
+      rng.fill_uniform(C.data(), C.size(), T{-1}, T{1});
+
+      std::vector<T> expected = C;
+      reference_gemm(transa, transb, m, n, k, alpha, A.data(), lda,
+                     B.data(), ldb, beta, expected.data(), ldc);
+      Blas::gemm(transa, transb, m, n, k, alpha, A.data(), lda,
+                 B.data(), ldb, beta, C.data(), ldc);
+
+      T tol = static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) *
+              static_cast<T>(k + 1);
+
+      for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < ldc; ++j)
+          ASSERT_NEAR(C[i * ldc + j], expected[i * ldc + j], tol)
+              << "at (" << i << ", " << j << ")";
+    }
+  };
+
+  using GemmTypes = ::testing::Types<float, double>;
+  TYPED_TEST_SUITE(BlasGemmTest, GemmTypes);
+
+  TYPED_TEST(BlasGemmTest, AllTransposeCombinations)
+  {
+    const BlasOperation ops[] = {BlasOperation::NoTrans, BlasOperation::Trans,
+                                 BlasOperation::ConjTrans};
+
+    for (BlasOperation ta : ops)
+      for (BlasOperation tb : ops)
+        this->run(ta, tb, 37, 53, 29, TypeParam{1}, TypeParam{0});
+  }
+
+  TYPED_TEST(BlasGemmTest, AlphaBetaAndPadding)
+  {
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans,
+              19, 23, 17, TypeParam{0.5}, TypeParam{-2}, 5);
+    this->run(BlasOperation::Trans, BlasOperation::NoTrans,
+              19, 23, 17, TypeParam{2}, TypeParam{1}, 3);
+  }
+
+  TYPED_TEST(BlasGemmTest, CrossesCacheBlocks)
+  {
+    this->run(BlasOperation::NoTrans, BlasOperation::Trans,
+              211, 97, 300, TypeParam{1}, TypeParam{0.25});
+  }
+
+  TYPED_TEST(BlasGemmTest, DegenerateSizes)
+  {
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans,
+              1, 1, 1, TypeParam{1}, TypeParam{0});
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans,
+              7, 5, 0, TypeParam{1}, TypeParam{3});
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans,
+              7, 5, 4, TypeParam{0}, TypeParam{0});
+  }
+
+  TYPED_TEST(BlasGemmTest, SmallSizesUseFixedKernels)
+  {
+    const BlasOperation ops[] = {BlasOperation::NoTrans, BlasOperation::Trans};
+    const size_t sizes[] = {1, 3, 4, 5, 8, 13, 16, 17, 31, 32};
+
+    for (BlasOperation ta : ops)
+      for (BlasOperation tb : ops)
+        for (size_t n : sizes)
+        {
+          this->run(ta, tb, 32, n, 7, TypeParam{1}, TypeParam{0});
+          this->run(ta, tb, 5, n, 32, TypeParam{-0.5}, TypeParam{2}, 3);
+        }
+  }
+
+  TYPED_TEST(BlasGemmTest, StridedBatchMatchesSingleCalls)
+  {
+    using T = TypeParam;
+    auto &rng = RandomGenerator::instance();
+    const int threads = tf::core::config().num_threads();
+    tf::core::config().set_num_threads(4);
+
+    // Small heads, a shared (stride 0) B, and problems large enough to
+    // split their own rows
+    const size_t shapes[][4] = {{16, 16, 16, 300}, {7, 33, 5, 10}, {130, 70, 90, 3}};
+    for (const auto &shape : shapes)
+    {
+      const size_t m = shape[0], n = shape[1], k = shape[2], count = shape[3];
+      for (size_t stride_b : {k * n + 3, size_t{0}})
+      {
+        const size_t stride_a = m * k, stride_c = m * n + 5;
+        std::vector<T> A(count * stride_a), B(count * stride_b + k * n), C(count * stride_c);
+        rng.fill_uniform(A.data(), A.size(), T{-1}, T{1});
+        rng.fill_uniform(B.data(), B.size(), T{-1}, T{1});
+        rng.fill_uniform(C.data(), C.size(), T{-1}, T{1});
+
+        std::vector<T> expected = C;
+        for (size_t i = 0; i < count; ++i)
+          reference_gemm(BlasOperation::Trans, BlasOperation::NoTrans, m, n, k, T{2},
+                         A.data() + i * stride_a, m, B.data() + i * stride_b, n, T{0.5},
+                         expected.data() + i * stride_c, n);
+
+        Blas::gemm_strided_batched(BlasOperation::Trans, BlasOperation::NoTrans, m, n, k, T{2},
+                                   A.data(), m, stride_a, B.data(), n, stride_b, T{0.5},
+                                   C.data(), n, stride_c, count);
+
+        const T tol = static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) * static_cast<T>(k + 1);
+        for (size_t i = 0; i < C.size(); ++i)
+          ASSERT_NEAR(C[i], expected[i], tol) << m << "x" << n << "x" << k << " at " << i;
+      }
+    }
+    tf::core::config().set_num_threads(threads);
+
+    std::vector<T> C(64);
+    EXPECT_THROW(Blas::gemm_strided_batched(BlasOperation::NoTrans, BlasOperation::NoTrans, 4, 4, 4,
+                                            T{1}, C.data(), 4, 0, C.data(), 4, 0, T{0},
+                                            C.data(), 4, 8, 2),
+                 tf::core::ShapeError);
+  }
+
+  TYPED_TEST(BlasGemmTest, PointerBatchMatchesSingleCalls)
+  {
+    using T = TypeParam;
+    const size_t m = 9, n = 24, k = 12, count = 50;
+    auto &rng = RandomGenerator::instance();
+
+    std::vector<std::vector<T>> A(count, std::vector<T>(k * m)), B(count, std::vector<T>(n * k)),
+        C(count, std::vector<T>(m * n));
+    std::vector<const T *> a, b;
+    std::vector<T *> c;
+    for (size_t i = 0; i < count; ++i)
+    {
+      rng.fill_uniform(A[i].data(), A[i].size(), T{-1}, T{1});
+      rng.fill_uniform(B[i].data(), B[i].size(), T{-1}, T{1});
+      a.push_back(A[i].data());
+      b.push_back(B[i].data());
+      c.push_back(C[i].data());
+    }
+
+    Blas::gemm_batched(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{1},
+                       a.data(), k, b.data(), k, T{0}, c.data(), n, count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      std::vector<T> expected(m * n);
+      reference_gemm(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{1},
+                     A[i].data(), k, B[i].data(), k, T{0}, expected.data(), n);
+      for (size_t j = 0; j < m * n; ++j)
+        ASSERT_NEAR(C[i][j], expected[j], static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) * 13)
+            << i << " " << j;
+    }
+
+    EXPECT_THROW(Blas::gemm_batched(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{1},
+                                    static_cast<const T *const *>(nullptr), k, b.data(), k, T{0},
+                                    c.data(), n, count),
+                 tf::core::ValueError);
+    EXPECT_THROW(Blas::gemm_batched(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{1},
+                                    a.data(), k - 1, b.data(), k, T{0}, c.data(), n, count),
+                 tf::core::ShapeError);
+  }
+
+  TEST(BlasTest, DotUnitAndStrided)
+  {
+    // Odd length so the vector body, vector tail and scalar tail all run
+    std::vector<double> x(103), y(206);
+    double expected = 0.0;
+
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      x[i] = 0.5 * static_cast<double>(i) - 7.0;
+      y[2 * i] = 1.0 / static_cast<double>(i + 1);
+      y[2 * i + 1] = 1e9;
+      expected += x[i] * y[2 * i];
+    }
+
+    EXPECT_NEAR(Blas::dot(x.size(), x.data(), 1, y.data(), 2), expected, 1e-9);
+
+    std::vector<double> y_unit(x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+      y_unit[i] = y[2 * i];
+
+    EXPECT_NEAR(Blas::dot(x.size(), x.data(), 1, y_unit.data(), 1), expected, 1e-9);
+
+    std::vector<float> xf{1.0f, 2.0f, 3.0f};
+    EXPECT_FLOAT_EQ(Blas::dot(3, xf.data(), 1, xf.data(), 1), 14.0f);
+    EXPECT_THROW(Blas::dot<float>(0, xf.data(), 1, xf.data(), 1), std::invalid_argument);
+  }
+
+  TEST(BlasTest, NegativeStrideTraversesBackwards)
+  {
+    std::vector<float> x{1.0f, 2.0f, 3.0f};
+    std::vector<float> y{10.0f, 20.0f, 30.0f};
+
+    // x reversed is (3, 2, 1)
+    EXPECT_FLOAT_EQ(Blas::dot(3, x.data(), -1, y.data(), 1), 100.0f);
+
+    Blas::axpy(3, 1.0f, x.data(), -1, y.data(), 1);
+    EXPECT_EQ(y, (std::vector<float>{13.0f, 22.0f, 31.0f}));
+  }
+
+  TEST(BlasTest, Nrm2IsOverflowAndUnderflowSafe)
+  {
+    std::vector<float> x(37, 3.0f);
+    EXPECT_NEAR(Blas::nrm2(x.size(), x.data(), 1), 3.0f * std::sqrt(37.0f), 1e-4f);
+
+    std::vector<float> big{3e30f, 4e30f};
+    EXPECT_NEAR(Blas::nrm2(2, big.data(), 1) / 5e30f, 1.0f, 1e-6f);
+
+    std::vector<double> tiny{3e-200, 4e-200};
+    EXPECT_NEAR(Blas::nrm2(2, tiny.data(), 1) / 5e-200, 1.0, 1e-12);
+
+    std::vector<double> strided{3.0, -1.0, 4.0, -1.0};
+    EXPECT_DOUBLE_EQ(Blas::nrm2(2, strided.data(), 2), 5.0);
+    EXPECT_DOUBLE_EQ(Blas::nrm2<double>(0, strided.data(), 1), 0.0);
+  }
+
+  TEST(BlasTest, ScalAndAxpy)
+  {
+    std::vector<float> x(21), y(21);
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      x[i] = static_cast<float>(i);
+      y[i] = 1.0f;
+    }
+
+    Blas::axpy(x.size(), 2.0f, x.data(), 1, y.data(), 1);
+    for (size_t i = 0; i < y.size(); ++i)
+      EXPECT_FLOAT_EQ(y[i], 2.0f * static_cast<float>(i) + 1.0f);
+
+    Blas::scal(x.size(), 0.5f, x.data(), 1);
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_FLOAT_EQ(x[i], 0.5f * static_cast<float>(i));
+
+    std::vector<double> z{1.0, 2.0, 3.0, 4.0};
+    Blas::scal(2, -1.0, z.data(), 2);
+    EXPECT_EQ(z, (std::vector<double>{-1.0, 2.0, -3.0, 4.0}));
+  }
+
+  TEST(BlasTest, GemmRejectsInvalidLeadingDimensions)
+  {
+    std::vector<float> A(6), B(6), C(4);
+
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans,
+                            2, 2, 3, 1.0f, A.data(), 2, B.data(), 2,
+                            0.0f, C.data(), 2),
+                 tf::core::ShapeError);
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans,
+                            2, 2, 3, 1.0f, A.data(), 3, B.data(), 2,
+                            0.0f, C.data(), 1),
+                 tf::core::ShapeError);
+  }
+
+  TEST(BlasTest, GemmBetaZeroIgnoresExistingOutput)
+  {
+    std::vector<float> A{1.0f, 2.0f, 3.0f, 4.0f};
+    std::vector<float> B{1.0f, 0.0f, 0.0f, 1.0f};
+    std::vector<float> C(4, std::nanf(""));
+
+    Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 2,
+               1.0f, A.data(), 2, B.data(), 2, 0.0f, C.data(), 2);
+
+    EXPECT_EQ(C, A);
+  }
+  /**
+   * @brief Expands the referenced triangle of a row-major symmetric matrix
+   */
+  template <typename T>
+  std::vector<T> symmetric_full(char uplo, size_t n, const std::vector<T> &A, size_t lda)
+  {
+    std::vector<T> full(n * n);
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < n; ++j)
+      {
+        bool stored = uplo == 'U' ? j >= i : j <= i;
+        full[i * n + j] = stored ? A[i * lda + j] : A[j * lda + i];
+      }
+
+    return full;
+  }
+
+  template <typename T>
+  class BlasLevel2Test : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(11);
+    }
+
+    std::vector<T> random(size_t size)
+    {
+      std::vector<T> v(size);
+      RandomGenerator::instance().fill_uniform(v.data(), v.size(), T{-1}, T{1});
+      return v;
+    }
+
+    T tol(size_t k) const
+    {
+      return static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) *
+             static_cast<T>(k + 1);
+    }
+
+    void run_gemv(size_t m, size_t n, T alpha, T beta, int incx, int incy)
+    {
+      size_t lda = n + 3;
+      auto A = random(m * lda);
+      auto x = random(n * incx);
+      auto y = random(m * incy);
+
+      std::vector<T> expected = y;
+      for (size_t i = 0; i < m; ++i)
+      {
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j)
+          sum += static_cast<double>(A[i * lda + j]) * x[j * incx];
+        expected[i * incy] = static_cast<T>(alpha * sum) + beta * y[i * incy];
+      }
+
+      Blas::gemv(m, n, alpha, A.data(), lda, x.data(), incx, beta, y.data(), incy);
+
+      for (size_t i = 0; i < y.size(); ++i)
+        ASSERT_NEAR(y[i], expected[i], tol(n)) << "at " << i;
+    }
+
+    void run_symv(char uplo, size_t n, T alpha, T beta, int incx)
+    {
+      size_t lda = n + 1;
+      auto A = random(n * lda);
+      auto x = random(n * incx);
+      auto y = random(n);
+      auto full = symmetric_full(uplo, n, A, lda);
+
+      std::vector<T> expected = y;
+      for (size_t i = 0; i < n; ++i)
+      {
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j)
+          sum += static_cast<double>(full[i * n + j]) * x[j * incx];
+        expected[i] = static_cast<T>(alpha * sum) + beta * y[i];
+      }
+
+      Blas::symv(uplo, n, alpha, A.data(), lda, x.data(), incx, beta, y.data(), 1);
+
+      for (size_t i = 0; i < n; ++i)
+        ASSERT_NEAR(y[i], expected[i], tol(n)) << "at " << i;
+    }
+
+    void run_symm(char side, char uplo, size_t m, size_t n, T alpha, T beta)
+    {
+      size_t ka = side == 'L' ? m : n;
+      size_t lda = ka + 2;
+      auto A = random(ka * lda);
+      auto B = random(m * n);
+      auto C = random(m * n);
+      auto full = symmetric_full(uplo, ka, A, lda);
+
+      std::vector<T> expected = C;
+      if (side == 'L')
+        reference_gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, m, n, m, alpha,
+                       full.data(), ka, B.data(), n, beta, expected.data(), n);
+      else
+        reference_gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, m, n, n, alpha,
+                       B.data(), n, full.data(), ka, beta, expected.data(), n);
+
+      Blas::symm(side, uplo, m, n, alpha, A.data(), lda, B.data(), n, beta, C.data(), n);
+
+      for (size_t i = 0; i < C.size(); ++i)
+        ASSERT_NEAR(C[i], expected[i], tol(ka)) << "at " << i;
+    }
+  };
+
+  TYPED_TEST_SUITE(BlasLevel2Test, GemmTypes);
+
+  TYPED_TEST(BlasLevel2Test, Gemv)
+  {
+    this->run_gemv(17, 29, TypeParam{1}, TypeParam{0}, 1, 1);
+    this->run_gemv(17, 29, TypeParam{0.5}, TypeParam{2}, 2, 3);
+    this->run_gemv(5, 0, TypeParam{1}, TypeParam{-1}, 1, 1);
+    // Large enough to cross the external backend cutoff
+    this->run_gemv(300, 280, TypeParam{1}, TypeParam{0.5}, 1, 1);
+  }
+
+  TYPED_TEST(BlasLevel2Test, Symv)
+  {
+    for (char uplo : {'U', 'L'})
+    {
+      this->run_symv(uplo, 23, TypeParam{1}, TypeParam{0}, 1);
+      this->run_symv(uplo, 23, TypeParam{-1}, TypeParam{0.5}, 2);
+      this->run_symv(uplo, 300, TypeParam{2}, TypeParam{1}, 1);
+    }
+  }
+
+  TYPED_TEST(BlasLevel2Test, Symm)
+  {
+    for (char side : {'L', 'R'})
+      for (char uplo : {'U', 'L'})
+      {
+        this->run_symm(side, uplo, 13, 21, TypeParam{1}, TypeParam{0});
+        this->run_symm(side, uplo, 70, 65, TypeParam{0.5}, TypeParam{2});
+      }
+  }
+
+  TEST(BlasTest, Level2RejectsInvalidArguments)
+  {
+    std::vector<float> A(16), x(4), y(4), C(16);
+
+    EXPECT_THROW(Blas::gemv(4, 4, 1.0f, A.data(), 3, x.data(), 1, 0.0f, y.data(), 1),
+                 tf::core::ShapeError);
+    EXPECT_THROW(Blas::symv('X', 4, 1.0f, A.data(), 4, x.data(), 1, 0.0f, y.data(), 1),
+                 tf::core::ValueError);
+    EXPECT_THROW(Blas::symm('X', 'U', 4, 4, 1.0f, A.data(), 4, A.data(), 4,
+                            0.0f, C.data(), 4),
+                 tf::core::ValueError);
+    EXPECT_THROW(Blas::symm('L', 'U', 4, 4, 1.0f, A.data(), 3, A.data(), 4,
+                            0.0f, C.data(), 4),
+                 tf::core::ShapeError);
+  }
+
+  TYPED_TEST(BlasGemmTest, ViewsMapToTransposeFlags)
+  {
+    using T = TypeParam;
+    using tf::core::Shape;
+    using tf::core::TensorView;
+
+    const tf::core::index_t M = 23, N = 19, K = 31;
+    const size_t m = M, n = N, k = K;
+    auto a = TensorView<T>::allocate(Shape({K, M}));
+    auto b = TensorView<T>::allocate(Shape({N, K + 4}));
+    auto c = TensorView<T>::allocate(Shape({N, M}));
+
+    auto &rng = RandomGenerator::instance();
+    rng.fill_uniform(a.data(), m * k, T{-1}, T{1});
+    rng.fill_uniform(b.data(), n * (k + 4), T{-1}, T{1});
+
+    // C^T = A^T B^T over views: every operand is a transposed layout, and
+    // B is also a column slice
+    std::vector<T> expected(m * n);
+    reference_gemm(BlasOperation::Trans, BlasOperation::Trans, m, n, k, T{1},
+                   a.data(), m, b.data() + 2, k + 4, T{0}, expected.data(), n);
+
+    Blas::gemm(T{1}, a.transpose(), b.slice(1, 2, K + 2).transpose(), T{0}, c.transpose());
+
+    const T tol = static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) * static_cast<T>(k);
+    for (size_t i = 0; i < m; ++i)
+      for (size_t j = 0; j < n; ++j)
+        ASSERT_NEAR(c(j, i), expected[i * n + j], tol) << i << " " << j;
+
+    // Broadcast operands are materialized
+    auto row = a.select(0, 0).broadcast_to(Shape({2, M}));
+    auto d = TensorView<T>::allocate(Shape({2, 2}));
+    Blas::gemm(T{1}, row, row.transpose(), T{0}, d);
+    EXPECT_NEAR(d(0, 1), Blas::dot(m, a.data(), 1, a.data(), 1), tol);
+
+    EXPECT_THROW(Blas::gemm(T{1}, a, a, T{0}, c), tf::core::ShapeError);
+    EXPECT_THROW(Blas::gemm(T{1}, row, row.transpose(), T{0}, d.broadcast_to(Shape({2, 2, 2}))),
+                 tf::core::ShapeError);
+  }
+
+  /**
+   * @brief Applies a GEMM epilogue the slow way, one element at a time
+   */
+  template <typename T>
+  T reference_epilogue(T value, size_t i, size_t j, const GemmEpilogue<T> &epilogue)
+  {
+    if (epilogue.row_bias)
+      value += epilogue.row_bias[i];
+    if (epilogue.column_bias)
+      value += epilogue.column_bias[j];
+
+    switch (epilogue.activation)
+    {
+    case Activation::Identity:
+      break;
+    case Activation::Relu:
+      value = relu(value);
+      break;
+    case Activation::LeakyRelu:
+      value = leaky_relu(value, epilogue.leaky_slope);
+      break;
+    case Activation::Sigmoid:
+      value = sigmoid(value);
+      break;
+    case Activation::Tanh:
+      value = tanh(value);
+      break;
+    }
+
+    if (epilogue.quantum > T{0})
+      value = std::nearbyint(value / epilogue.quantum) * epilogue.quantum;
+    return std::clamp(value, epilogue.clamp_min, epilogue.clamp_max);
+  }
+
+  TYPED_TEST(BlasGemmTest, FusedEpilogueMatchesSeparatePasses)
+  {
+    using T = TypeParam;
+    const Activation activations[] = {Activation::Identity, Activation::Relu, Activation::LeakyRelu,
+                                      Activation::Sigmoid, Activation::Tanh};
+    // Edge tiles only, and several cache blocks (large enough for an
+    // external BLAS, whose result gets a separate epilogue pass)
+    const size_t sizes[][3] = {{37, 53, 29}, {211, 97, 300}};
+
+    auto &rng = RandomGenerator::instance();
+    for (const auto &size : sizes)
+    {
+      const size_t m = size[0], n = size[1], k = size[2];
+      std::vector<T> A(m * k), B(k * n), C0(m * n), row_bias(m), column_bias(n);
+      rng.fill_uniform(A.data(), A.size(), T{-1}, T{1});
+      rng.fill_uniform(B.data(), B.size(), T{-1}, T{1});
+      rng.fill_uniform(C0.data(), C0.size(), T{-1}, T{1});
+      rng.fill_uniform(row_bias.data(), m, T{-2}, T{2});
+      rng.fill_uniform(column_bias.data(), n, T{-2}, T{2});
+
+      std::vector<T> product = C0;
+      reference_gemm(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{0.5},
+                     A.data(), k, B.data(), k, T{0.25}, product.data(), n);
+
+      const T tol = static_cast<T>(std::is_same_v<T, float> ? 1e-4 : 1e-12) * static_cast<T>(k + 1);
+      for (Activation activation : activations)
+      {
+        for (int bias = 0; bias < 3; ++bias)
+        {
+          GemmEpilogue<T> epilogue;
+          epilogue.activation = activation;
+          epilogue.leaky_slope = T{0.1};
+          epilogue.row_bias = bias != 1 ? row_bias.data() : nullptr;
+          epilogue.column_bias = bias != 0 ? column_bias.data() : nullptr;
+          if (bias == 2)
+          {
+            epilogue.clamp_min = T{-0.5};
+            epilogue.clamp_max = T{0.75};
+          }
+
+          std::vector<T> C = C0;
+          Blas::gemm(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{0.5},
+                     A.data(), k, B.data(), k, T{0.25}, C.data(), n, epilogue);
+
+          for (size_t i = 0; i < m; ++i)
+            for (size_t j = 0; j < n; ++j)
+              ASSERT_NEAR(C[i * n + j], reference_epilogue(product[i * n + j], i, j, epilogue), tol)
+                  << static_cast<int>(activation) << " " << bias << " at (" << i << ", " << j << ")";
+        }
+      }
+
+      // Quantized outputs land on the grid, within half a step
+      GemmEpilogue<T> quantized;
+      quantized.column_bias = column_bias.data();
+      quantized.quantum = T{0.125};
+      quantized.clamp_min = T{-1};
+      quantized.clamp_max = T{1};
+
+      std::vector<T> C = C0;
+      Blas::gemm(BlasOperation::NoTrans, BlasOperation::Trans, m, n, k, T{0.5},
+                 A.data(), k, B.data(), k, T{0.25}, C.data(), n, quantized);
+      for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < n; ++j)
+        {
+          const T value = C[i * n + j];
+          const T exact = std::clamp(product[i * n + j] + column_bias[j], T{-1}, T{1});
+          ASSERT_EQ(value, std::round(value * 8) / 8);
+          ASSERT_LE(std::abs(value - exact), T{0.0625} + tol);
+        }
+    }
+  }
+
+  TYPED_TEST(BlasGemmTest, FusedEpilogueOnViewsAndDegenerateSizes)
+  {
+    using T = TypeParam;
+    using tf::core::Shape;
+    using tf::core::TensorView;
+
+    const tf::core::index_t M = 13, N = 21, K = 9;
+    auto a = TensorView<T>::allocate(Shape({M, K}));
+    auto b = TensorView<T>::allocate(Shape({K, N}));
+    auto c = TensorView<T>::allocate(Shape({N, M}));
+    std::vector<T> row_bias(M), column_bias(N);
+
+    auto &rng = RandomGenerator::instance();
+    rng.fill_uniform(a.data(), M * K, T{-1}, T{1});
+    rng.fill_uniform(b.data(), K * N, T{-1}, T{1});
+    rng.fill_uniform(row_bias.data(), M, T{-1}, T{1});
+    rng.fill_uniform(column_bias.data(), N, T{-1}, T{1});
+
+    GemmEpilogue<T> epilogue;
+    epilogue.row_bias = row_bias.data();
+    epilogue.column_bias = column_bias.data();
+    epilogue.activation = Activation::Relu;
+
+    // A column-major C is computed transposed; the biases keep their axes
+    std::vector<T> expected(M * N);
+    reference_gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, M, N, K, T{1},
+                   a.data(), K, b.data(), N, T{0}, expected.data(), N);
+    Blas::gemm(T{1}, a, b, T{0}, c.transpose(), epilogue);
+
+    const T tol = static_cast<T>(std::is_same_v<T, float> ? 1e-5 : 1e-12) * static_cast<T>(K);
+    for (tf::core::index_t i = 0; i < M; ++i)
+      for (tf::core::index_t j = 0; j < N; ++j)
+        ASSERT_NEAR(c(j, i), reference_epilogue(expected[i * N + j], i, j, epilogue), tol);
+
+    // k = 0 still applies the epilogue to beta * C
+    std::vector<T> C(M * N, T{2});
+    Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, M, N, 0, T{1},
+               a.data(), K, b.data(), N, T{-1}, C.data(), N, epilogue);
+    for (tf::core::index_t i = 0; i < M; ++i)
+      for (tf::core::index_t j = 0; j < N; ++j)
+        ASSERT_EQ(C[i * N + j], relu(T{-2} + row_bias[i] + column_bias[j]));
+
+    GemmEpilogue<T> invalid;
+    invalid.clamp_min = T{1};
+    invalid.clamp_max = T{0};
+    EXPECT_THROW(Blas::gemm(T{1}, a, b, T{0}, c.transpose(), invalid), tf::core::ValueError);
+    invalid = GemmEpilogue<T>{};
+    invalid.quantum = T{-1};
+    EXPECT_THROW(Blas::gemm(T{1}, a, b, T{0}, c.transpose(), invalid), tf::core::ValueError);
+  }
+
+  TEST(BlasTest, LargeLevel1MatchesBuiltin)
+  {
+    // Above the external backend cutoff; results must agree with the
+    // built-in kernels whichever path runs
+    const size_t n = size_t{1} << 17;
+    std::vector<double> x(n), y(n, 1.0);
+    double expected = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      x[i] = static_cast<double>(i % 7) - 3.0;
+      expected += x[i];
+    }
+
+    EXPECT_NEAR(Blas::dot(n, x.data(), 1, y.data(), 1), expected, 1e-9);
+
+    Blas::axpy(n, 2.0, x.data(), 1, y.data(), 1);
+    for (size_t i = 0; i < n; ++i)
+      ASSERT_DOUBLE_EQ(y[i], 1.0 + 2.0 * x[i]);
+  }
+  /**
+   * @brief Draws values uniformly from [low, high), rounded to S
+   */
+  template <typename S>
+  std::vector<S> random_values(size_t count, float low, float high)
+  {
+    std::vector<float> values(count);
+    RandomGenerator::instance().fill_uniform(values.data(), count, low, high);
+
+    std::vector<S> result;
+    result.reserve(count);
+    for (float v : values)
+    {
+      if constexpr (std::is_integral_v<S>)
+        result.push_back(static_cast<S>(std::lround(v)));
+      else
+        result.push_back(S(v));
+    }
+    return result;
+  }
+
+  template <typename W, typename S>
+  std::vector<W> widen(const std::vector<S> &values)
+  {
+    return std::vector<W>(values.begin(), values.end());
+  }
+
+  template <typename S>
+  class BlasMixedPrecisionTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(11);
+    }
+
+    void run(BlasOperation transa, BlasOperation transb,
+             size_t m, size_t n, size_t k, float alpha, float beta)
+    {
+      const bool ta = transa != BlasOperation::NoTrans;
+      const bool tb = transb != BlasOperation::NoTrans;
+      const size_t lda = (ta ? m : k) + 1;
+      const size_t ldb = (tb ? k : n) + 3;
+      const size_t ldc = n + 2;
+
+      const auto A = random_values<S>((ta ? k : m) * lda, -1.0f, 1.0f);
+      const auto B = random_values<S>((tb ? n : k) * ldb, -1.0f, 1.0f);
+      std::vector<float> C = widen<float>(random_values<S>(m * ldc, -1.0f, 1.0f));
+
+      // The inputs widen exactly, so only the accumulation order differs
+      std::vector<float> expected = C;
+      const auto a = widen<float>(A);
+      const auto b = widen<float>(B);
+      reference_gemm(transa, transb, m, n, k, alpha, a.data(), lda, b.data(), ldb,
+                     beta, expected.data(), ldc);
+      Blas::gemm(transa, transb, m, n, k, alpha, A.data(), lda, B.data(), ldb,
+                 beta, C.data(), ldc);
+
+      const float tol = 1e-5f * static_cast<float>(k + 1);
+      for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < ldc; ++j)
+          ASSERT_NEAR(C[i * ldc + j], expected[i * ldc + j], tol)
+              << "at (" << i << ", " << j << ") of " << m << " x " << n << " x " << k;
+    }
+  };
+
+  using ReducedTypes = ::testing::Types<tf::core::BFloat16, tf::core::Float16>;
+  TYPED_TEST_SUITE(BlasMixedPrecisionTest, ReducedTypes);
+
+  TYPED_TEST(BlasMixedPrecisionTest, GemmMatchesWidenedInputs)
+  {
+    const BlasOperation ops[] = {BlasOperation::NoTrans, BlasOperation::Trans};
+    for (BlasOperation ta : ops)
+      for (BlasOperation tb : ops)
+        this->run(ta, tb, 37, 45, 67, 1.0f, 0.0f);
+
+    // Edge tiles, odd depths and several depth blocks
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans, 5, 3, 1, 2.0f, 0.5f);
+    this->run(BlasOperation::NoTrans, BlasOperation::Trans, 130, 70, 1201, 0.5f, -1.0f);
+    this->run(BlasOperation::Trans, BlasOperation::NoTrans, 2, 100, 33, 1.0f, 1.0f);
+    this->run(BlasOperation::NoTrans, BlasOperation::NoTrans, 4, 4, 0, 1.0f, 2.0f);
+  }
+
+  TYPED_TEST(BlasMixedPrecisionTest, DotMatchesWidenedInputs)
+  {
+    for (size_t n : {1u, 31u, 64u, 1037u})
+    {
+      const auto x = random_values<TypeParam>(2 * n, -2.0f, 2.0f);
+      const auto y = random_values<TypeParam>(n, -2.0f, 2.0f);
+
+      double unit = 0.0, strided = 0.0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        unit += static_cast<double>(x[i]) * static_cast<float>(y[i]);
+        strided += static_cast<double>(x[2 * (n - 1 - i)]) * static_cast<float>(y[i]);
+      }
+
+      EXPECT_NEAR(Blas::dot(n, x.data(), 1, y.data(), 1), unit, 1e-5 * static_cast<double>(n));
+      EXPECT_NEAR(Blas::dot(n, x.data(), -2, y.data(), 1), strided, 1e-5 * static_cast<double>(n));
+    }
+
+    const TypeParam one(1.0f);
+    EXPECT_THROW(Blas::dot(0, &one, 1, &one, 1), std::invalid_argument);
+  }
+
+  TEST(BlasTest, Int8GemmIsExact)
+  {
+    RandomGenerator::instance().set_seed(13);
+    const BlasOperation ops[] = {BlasOperation::NoTrans, BlasOperation::Trans};
+
+    struct Size
+    {
+      size_t m, n, k;
+    };
+    for (const Size size : {Size{37, 45, 67}, Size{1, 33, 5}, Size{70, 130, 1100}})
+      for (BlasOperation transa : ops)
+        for (BlasOperation transb : ops)
+        {
+          const auto [m, n, k] = size;
+          const bool ta = transa != BlasOperation::NoTrans;
+          const bool tb = transb != BlasOperation::NoTrans;
+          const size_t lda = (ta ? m : k) + 1;
+          const size_t ldb = tb ? k : n;
+          const size_t ldc = n + 1;
+
+          // The extremes exercise the unsigned bias of the VNNI kernel
+          auto A = random_values<std::int8_t>((ta ? k : m) * lda, -128.4f, 127.4f);
+          auto B = random_values<std::int8_t>((tb ? n : k) * ldb, -128.4f, 127.4f);
+          A[0] = -128;
+          B[0] = -128;
+          B[1] = 127;
+
+          std::vector<std::int32_t> C(m * ldc, 7);
+          std::vector<std::int32_t> expected = C;
+          const auto a = widen<std::int32_t>(A);
+          const auto b = widen<std::int32_t>(B);
+          reference_gemm<std::int32_t>(transa, transb, m, n, k, 3, a.data(), lda, b.data(), ldb,
+                                       -2, expected.data(), ldc);
+          Blas::gemm(transa, transb, m, n, k, 3, A.data(), lda, B.data(), ldb, -2, C.data(), ldc);
+          ASSERT_EQ(C, expected) << m << " x " << n << " x " << k;
+        }
+
+    std::vector<std::int8_t> x{1, 2};
+    std::vector<std::int32_t> c(4, 5);
+    Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 0, 1, x.data(), 1,
+               x.data(), 2, 2, c.data(), 2);
+    EXPECT_EQ(c, std::vector<std::int32_t>(4, 10));
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 2, 1,
+                            x.data(), 1, x.data(), 2, 0, c.data(), 2),
+                 tf::core::ShapeError);
+  }
+
+  TEST(BlasTest, Int8DotIsExact)
+  {
+    RandomGenerator::instance().set_seed(17);
+    for (size_t n : {1u, 63u, 64u, 1000u})
+    {
+      auto x = random_values<std::int8_t>(n, -128.4f, 127.4f);
+      auto y = random_values<std::int8_t>(2 * n, -128.4f, 127.4f);
+      x[0] = -128;
+      y[0] = -128;
+
+      std::int32_t unit = 0, strided = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        unit += x[i] * y[i];
+        strided += x[i] * y[2 * i];
+      }
+
+      EXPECT_EQ(Blas::dot(n, x.data(), 1, y.data(), 1), unit);
+      EXPECT_EQ(Blas::dot(n, x.data(), 1, y.data(), 2), strided);
+    }
+  }
+} // namespace test
@@ -0,0 +1,359 @@
+#include <gtest/gtest.h>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/utils/checkpoint.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace tf::utils;
+using tf::core::Shape;
+using tf::core::TensorView;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for checkpoint tests, with a scratch file removed
+   * after each test
+   *
+   */
+  class CheckpointTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+      path = (std::filesystem::temp_directory_path() /
+              (std::string("tf_") + info->name() + "_" + std::to_string(::getpid()) + ".ckpt"))
+                 .string();
+    }
+
+    void TearDown() override
+    {
+      std::filesystem::remove(path);
+      std::filesystem::remove(path + ".tmp");
+    }
+
+    template <typename T>
+    static TensorView<T> iota(const Shape &shape, T start)
+    {
+      auto tensor = TensorView<T>::allocate(shape);
+      for (tf::core::index_t i = 0; i < shape.num_elements(); ++i)
+        tensor.data()[i] = static_cast<T>(start + static_cast<T>(i));
+      return tensor;
+    }
+
+    void write_bytes(const std::string &bytes) const
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::string read_bytes() const
+    {
+      std::ifstream file(path, std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(file), {});
+    }
+
+    std::string path;
+  };
+
+  TEST_F(CheckpointTest, RoundTripsTensorsOfEveryLayout)
+  {
+    const auto weights = iota<float>({3, 5}, 0.5f);
+    const auto ids = iota<std::int64_t>({7}, -3);
+    const auto levels = iota<std::int8_t>({2, 3, 1}, -2);
+    const auto scalar = iota<double>(Shape{}, 2.0);
+    const auto empty = TensorView<float>::allocate({0, 4});
+
+    CheckpointWriter writer;
+    writer.add("layer.weight", weights);
+    writer.add("ids", ids);
+    writer.add("levels", levels);
+    writer.add("scalar", scalar);
+    writer.add("empty", empty);
+    writer.add("layer.weight.t", weights.transpose());
+    EXPECT_EQ(writer.size(), 6u);
+    writer.save(path);
+
+    const Checkpoint checkpoint(path);
+    ASSERT_EQ(checkpoint.size(), 6u);
+    EXPECT_EQ(checkpoint.file_size(), std::filesystem::file_size(path));
+    EXPECT_TRUE(checkpoint.contains("ids"));
+    EXPECT_FALSE(checkpoint.contains("bias"));
+
+    // Entries keep the order they were added in
+    EXPECT_EQ(checkpoint.entries()[0].name, "layer.weight");
+    EXPECT_EQ(checkpoint.entries()[5].name, "layer.weight.t");
+    for (const CheckpointEntry &entry : checkpoint.entries())
+      EXPECT_EQ(entry.offset % CHECKPOINT_ALIGNMENT, 0u) << entry.name;
+
+    const auto w = checkpoint.get<float>("layer.weight");
+    EXPECT_EQ(w.shape(), weights.shape());
+    EXPECT_EQ(std::memcmp(w.data(), weights.data(), 15 * sizeof(float)), 0);
+
+    const auto i = checkpoint.get<std::int64_t>("ids");
+    EXPECT_EQ(i.shape(), Shape({7}));
+    EXPECT_EQ(i.data()[0], -3);
+    EXPECT_EQ(i.data()[6], 3);
+
+    const auto l = checkpoint.get<std::int8_t>("levels");
+    EXPECT_EQ(l.shape(), Shape({2, 3, 1}));
+    EXPECT_EQ(l.data()[5], 3);
+
+    const auto s = checkpoint.get<double>("scalar");
+    EXPECT_EQ(s.rank(), 0u);
+    EXPECT_EQ(s.data()[0], 2.0);
+
+    EXPECT_EQ(checkpoint.get<float>("empty").shape(), Shape({0, 4}));
+
+    // A strided view is stored dense
+    const auto t = checkpoint.get<float>("layer.weight.t");
+    EXPECT_EQ(t.shape(), Shape({5, 3}));
+    EXPECT_TRUE(t.is_contiguous());
+    for (tf::core::index_t r = 0; r < 5; ++r)
+      for (tf::core::index_t c = 0; c < 3; ++c)
+        EXPECT_EQ(t.data()[r * 3 + c], weights.data()[c * 5 + r]);
+  }
+
+  TEST_F(CheckpointTest, ViewsAliasTheMappingAndOutliveIt)
+  {
+    CheckpointWriter writer;
+    writer.add("x", iota<float>({1000}, 0.0f));
+    writer.save(path);
+
+    TensorView<float> view;
+    {
+      CheckpointOptions options;
+      options.prefetch = true;
+      const Checkpoint checkpoint(path, options);
+      checkpoint.prefetch("x");
+
+      view = checkpoint.get<float>("x");
+      const auto again = checkpoint.get<float>("x");
+
+      // No per-tensor copy: every view points into the same mapping
+      EXPECT_EQ(view.data(), again.data());
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(view.data()) % CHECKPOINT_ALIGNMENT, 0u);
+    }
+
+    EXPECT_EQ(view.data()[999], 999.0f);
+  }
+
+  TEST_F(CheckpointTest, WritableMappingsNeverReachTheFile)
+  {
+    CheckpointWriter writer;
+    writer.add("x", iota<std::int32_t>({16}, 1));
+    writer.save(path);
+    const std::string before = read_bytes();
+
+    CheckpointOptions options;
+    options.writable = true;
+    {
+      const Checkpoint checkpoint(path, options);
+      auto x = checkpoint.get<std::int32_t>("x");
+      x.data()[0] = 42;
+      EXPECT_EQ(checkpoint.get<std::int32_t>("x").data()[0], 42);
+    }
+
+    EXPECT_EQ(read_bytes(), before);
+    EXPECT_EQ(Checkpoint(path).get<std::int32_t>("x").data()[0], 1);
+  }
+
+  TEST_F(CheckpointTest, SaveReplacesAnExistingFile)
+  {
+    CheckpointWriter first;
+    first.add("a", iota<float>({4}, 0.0f));
+    first.save(path);
+
+    const Checkpoint old(path);
+    const auto a = old.get<float>("a");
+
+    CheckpointWriter second;
+    second.add("b", iota<float>({4}, 10.0f));
+    second.save(path);
+
+    // The old mapping still sees the file it opened
+    EXPECT_EQ(a.data()[3], 3.0f);
+    const Checkpoint fresh(path);
+    EXPECT_FALSE(fresh.contains("a"));
+    EXPECT_EQ(fresh.get<float>("b").data()[0], 10.0f);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+  }
+
+  TEST_F(CheckpointTest, CompressedTensorsDecompressOnGet)
+  {
+    for (Compression codec : {Compression::LZ4, Compression::Zstd})
+    {
+      if (!compression_available(codec))
+      {
+        CheckpointWriter writer;
+        EXPECT_THROW(writer.add("x", iota<float>({4}, 0.0f), {codec}), tf::core::NotImplementedError);
+        continue;
+      }
+
+      // Repetitive rows compress well; block_rows 7 leaves a short last block
+      auto rows = TensorView<std::int32_t>::allocate({50, 33});
+      for (tf::core::index_t i = 0; i < rows.shape().num_elements(); ++i)
+        rows.data()[i] = static_cast<std::int32_t>(i % 33);
+
+      CheckpointWriter writer;
+      writer.add("rows", rows, {codec, 7, 0});
+      writer.add("default", iota<float>({300, 2}, 1.0f), {codec});
+      writer.add("empty", TensorView<float>::allocate({0, 3}), {codec});
+      writer.add("raw", iota<double>({5}, 0.0));
+      writer.save(path);
+
+      const Checkpoint checkpoint(path);
+      EXPECT_EQ(checkpoint.entry("rows").compression, codec);
+      EXPECT_LT(checkpoint.entry("rows").size, checkpoint.entry("rows").data_size());
+      EXPECT_EQ(checkpoint.entry("raw").compression, Compression::None);
+
+      const auto r = checkpoint.get<std::int32_t>("rows");
+      EXPECT_EQ(r.shape(), rows.shape());
+      EXPECT_EQ(std::memcmp(r.data(), rows.data(), 50 * 33 * sizeof(std::int32_t)), 0);
+      EXPECT_EQ(checkpoint.get<float>("default").data()[599], 600.0f);
+      EXPECT_EQ(checkpoint.get<float>("empty").shape(), Shape({0, 3}));
+      EXPECT_EQ(checkpoint.get<double>("raw").data()[4], 4.0);
+
+      // Each get of a compressed tensor is its own copy
+      EXPECT_NE(checkpoint.get<std::int32_t>("rows").data(), r.data());
+    }
+  }
+
+  TEST_F(CheckpointTest, IndexIsReadWithoutTheData)
+  {
+    CheckpointWriter writer;
+    writer.add("a", iota<float>({3, 4}, 0.0f));
+    writer.add("b", iota<std::int8_t>({9}, 0));
+    writer.save(path);
+
+    const std::vector<CheckpointEntry> index = read_checkpoint_index(path);
+    const Checkpoint checkpoint(path);
+    ASSERT_EQ(index.size(), 2u);
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+      EXPECT_EQ(index[i].name, checkpoint.entries()[i].name);
+      EXPECT_EQ(index[i].shape, checkpoint.entries()[i].shape);
+      EXPECT_EQ(index[i].offset, checkpoint.entries()[i].offset);
+      EXPECT_EQ(index[i].size, checkpoint.entries()[i].size);
+    }
+    EXPECT_EQ(index[1].dtype, tf::core::DataType::Int8);
+    EXPECT_EQ(index[0].rows(), 3u);
+    EXPECT_EQ(index[0].data_size(), 48u);
+
+    EXPECT_THROW(read_checkpoint_index(path + ".missing"), tf::core::IOError);
+  }
+
+  TEST_F(CheckpointTest, RejectsMisuse)
+  {
+    CheckpointWriter writer;
+    writer.add("x", iota<float>({2}, 0.0f));
+    EXPECT_THROW(writer.add("x", iota<float>({2}, 0.0f)), tf::core::ValueError);
+    EXPECT_THROW(writer.add("", iota<float>({2}, 0.0f)), tf::core::ValueError);
+    EXPECT_THROW(writer.add("n", tf::core::DataType::Float32, Shape({2}), nullptr),
+                 tf::core::ValueError);
+    EXPECT_THROW(writer.save("/nonexistent/dir/model.ckpt"), tf::core::IOError);
+    writer.save(path);
+
+    const Checkpoint checkpoint(path);
+    EXPECT_THROW(checkpoint.get<float>("y"), tf::core::IndexError);
+    EXPECT_THROW(checkpoint.get<double>("x"), tf::core::TypeError);
+    EXPECT_THROW(checkpoint.prefetch("y"), tf::core::IndexError);
+
+    EXPECT_THROW(Checkpoint(path + ".missing"), tf::core::IOError);
+  }
+
+  TEST_F(CheckpointTest, RejectsCorruptFiles)
+  {
+    CheckpointWriter writer;
+    writer.add("x", iota<float>({64}, 0.0f));
+    writer.save(path);
+    const std::string good = read_bytes();
+
+    write_bytes("");
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    write_bytes("not a checkpoint at all");
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    // Header cut short
+    write_bytes(good.substr(0, 30));
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    // Data cut short
+    write_bytes(good.substr(0, good.size() - 100));
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    // Unknown version
+    std::string bad = good;
+    bad[8] = 9;
+    write_bytes(bad);
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    // Size that does not match the shape (first entry's size field)
+    bad = good;
+    bad[24 + 24] ^= 1;
+    write_bytes(bad);
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    // Unknown compression
+    bad = good;
+    bad[24 + 12] = 7;
+    write_bytes(bad);
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+    EXPECT_THROW(read_checkpoint_index(path), tf::core::IOError);
+
+    // Data offset inside the preamble, then an entry with a huge name
+    bad = good.substr(0, 12);
+    const std::uint32_t count = 1, name_size = 0x7fffffff;
+    const std::uint64_t data_offset = 0;
+    bad.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    bad.append(reinterpret_cast<const char *>(&data_offset), sizeof(data_offset));
+    bad.append(reinterpret_cast<const char *>(&name_size), sizeof(name_size));
+    bad.append(40, '\0');
+    write_bytes(bad);
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+    EXPECT_THROW(read_checkpoint_index(path), tf::core::IOError);
+
+    write_bytes(good);
+    EXPECT_EQ(Checkpoint(path).get<float>("x").data()[63], 63.0f);
+  }
+
+  TEST_F(CheckpointTest, RejectsMalformedDimensions)
+  {
+    CheckpointWriter writer;
+    writer.add("m", iota<float>({2, 2}, 0.0f));
+    writer.save(path);
+    const std::string good = read_bytes();
+
+    // The first entry's dimensions follow its 32 fixed bytes
+    auto with_dims = [&](std::int64_t rows, std::int64_t cols)
+    {
+      std::string bad = good;
+      std::memcpy(&bad[24 + 32], &rows, sizeof(rows));
+      std::memcpy(&bad[24 + 40], &cols, sizeof(cols));
+      return bad;
+    };
+
+    // Element count overflows before the shape is built
+    write_bytes(with_dims(std::int64_t{1} << 40, std::int64_t{1} << 40));
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+    EXPECT_THROW(read_checkpoint_index(path), tf::core::IOError);
+
+    // Fits in the element count but not in bytes
+    write_bytes(with_dims(std::int64_t{1} << 31, std::int64_t{1} << 31));
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    write_bytes(with_dims(-2, -2));
+    EXPECT_THROW(Checkpoint{path}, tf::core::IOError);
+
+    write_bytes(with_dims(2, 2));
+    EXPECT_EQ(Checkpoint(path).get<float>("m").data()[3], 3.0f);
+  }
+} // namespace test
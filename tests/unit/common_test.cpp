@@ -2,6 +2,11 @@
 #include <gtest/gtest.h>
 #include <tf/core/common.hpp>
 #include <tf/core/macros.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 
 using namespace tf::core;
 
@@ -50,7 +55,65 @@ namespace test
     EXPECT_EQ(s.to_string(), "(2, 3, 4)");
   }
 
-  TEST(MemoryTest, AllocateAndCopy)
+  TEST(ShapeTest, SetUpdatesElementCount)
+  {
+    Shape s({2, 3, 4});
+    s.set(1, 5);
+    EXPECT_EQ(s[1], 5);
+    EXPECT_EQ(s.num_elements(), 40);
+    EXPECT_EQ(s, Shape({2, 5, 4}));
+
+    s.set(0, 0);
+    EXPECT_EQ(s.num_elements(), 0);
+    EXPECT_EQ(Shape().num_elements(), 1);
+  }
+
+  TEST(ShapeTest, CopiesAndMovesBeyondInlineRank)
+  {
+    const Shape small({1, 2, 3, 4, 5, 6, 7, 8});
+    const Shape large({1, 2, 3, 4, 5, 6, 7, 8, 2, 3});
+    EXPECT_EQ(large.rank(), 10u);
+    EXPECT_EQ(large.num_elements(), 40320 * 6);
+    EXPECT_EQ(large.to_string(), "(1, 2, 3, 4, 5, 6, 7, 8, 2, 3)");
+
+    Shape copy = large;
+    EXPECT_EQ(copy, large);
+    EXPECT_NE(copy.begin(), large.begin());
+
+    Shape moved = std::move(copy);
+    EXPECT_EQ(moved, large);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(copy.num_elements(), 1);
+
+    // Reassigning between inline and heap storage
+    moved = small;
+    EXPECT_EQ(moved, small);
+    EXPECT_EQ(moved.num_elements(), 40320);
+    moved = large;
+    EXPECT_EQ(moved, large);
+    moved = moved;
+    EXPECT_EQ(moved, large);
+
+    EXPECT_EQ(large.dims(), (std::vector<Shape::value_type>{1, 2, 3, 4, 5, 6, 7, 8, 2, 3}));
+    EXPECT_EQ(Shape(large.dims()), large);
+  }
+
+  TEST(ShapeTest, StaticShape)
+  {
+    constexpr StaticShape<3> s(2, 3, 4);
+    static_assert(s.rank() == 3);
+    static_assert(s.num_elements() == 24);
+    static_assert(s.strides() == std::array<Shape::value_type, 3>{12, 4, 1});
+    static_assert(s == StaticShape<3>(2, 3, 4));
+    static_assert(s != StaticShape<3>(2, 3, 5));
+    static_assert(StaticShape<0>().num_elements() == 1);
+
+    const Shape dynamic = s;
+    EXPECT_EQ(dynamic, Shape({2, 3, 4}));
+    EXPECT_EQ(s.to_string(), "(2, 3, 4)");
+  }
+
+  TEST(CommonMemoryTest, AllocateAndCopy)
   {
     auto ptr1 = Memory<int>::allocate(5);
     auto ptr2 = Memory<int>::allocate(5);
@@ -68,7 +131,7 @@ namespace test
     }
   }
 
-  TEST(MemoryTest, Fill)
+  TEST(CommonMemoryTest, Fill)
   {
     auto ptr = Memory<int>::allocate(5);
     Memory<int>::fill(ptr.get(), 5, 42);
@@ -79,6 +142,80 @@ namespace test
     }
   }
 
+  TEST(CommonMemoryTest, AllocateUninitialized)
+  {
+    auto ptr = Memory<float>::allocate_uninitialized(1000);
+    ASSERT_NE(ptr, nullptr);
+    Memory<float>::fill(ptr.get(), 1000, 1.5f);
+    EXPECT_EQ(ptr[999], 1.5f);
+
+    // Non-trivial types are still constructed
+    auto strings = Memory<std::string>::allocate_uninitialized(3);
+    EXPECT_TRUE(strings[2].empty());
+
+    tf::utils::Arena arena;
+    {
+      tf::utils::ArenaScope scope(arena);
+      auto scratch = Memory<double>::allocate_uninitialized(64);
+      EXPECT_GE(arena.bytes_used(), 64 * sizeof(double));
+    }
+  }
+
+  TEST(CommonMemoryTest, AllocateFromPool)
+  {
+    tf::utils::MemoryPool pool(64 * 1024);
+    double *first = nullptr;
+
+    {
+      auto ptr = Memory<double>::allocate_uninitialized(100, pool);
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr.get()) % tf::utils::CACHE_LINE_ALIGNMENT, 0u);
+
+      for (int i = 0; i < 100; ++i)
+        ptr[i] = i;
+      EXPECT_EQ(ptr[99], 99.0);
+      first = ptr.get();
+    }
+
+    // Released to the pool, so the next buffer reuses the block
+    auto again = Memory<double>::allocate_uninitialized(100, pool);
+    EXPECT_EQ(again.get(), first);
+  }
+
+  TEST(CommonMemoryTest, StreamingCopyAndFill)
+  {
+    // Odd sizes and offsets exercise the unaligned head and tail
+    const size_t count = (3 << 20) + 7;
+    std::vector<int> src(count + 1), dst(count + 1, -1);
+    for (size_t i = 0; i < src.size(); ++i)
+      src[i] = static_cast<int>(i * 7);
+
+    const size_t bytes = count * sizeof(int);
+    char *d = reinterpret_cast<char *>(dst.data());
+    const char *s = reinterpret_cast<const char *>(src.data());
+
+    detail::stream_copy(d + 3, s + 3, bytes);
+    EXPECT_EQ(std::memcmp(d, "\xff\xff\xff", 3), 0);
+    EXPECT_EQ(std::memcmp(d + 3, s + 3, bytes), 0);
+    EXPECT_EQ(static_cast<unsigned char>(d[bytes + 3]), 0xffu);
+
+    const double value = 2.25;
+    std::vector<double> values(count + 2, 0.0);
+    detail::stream_fill(values.data() + 1, &value, sizeof(double), count);
+    EXPECT_EQ(values.front(), 0.0);
+    EXPECT_EQ(values.back(), 0.0);
+    for (size_t i = 1; i <= count; ++i)
+      ASSERT_EQ(values[i], value) << "at " << i;
+
+    const short pattern = 0x1234;
+    std::vector<short> shorts(count, 0);
+    detail::stream_fill(shorts.data(), &pattern, sizeof(short), count);
+    EXPECT_TRUE(std::all_of(shorts.begin(), shorts.end(), [](short v)
+                            { return v == 0x1234; }));
+
+    EXPECT_THROW(detail::stream_fill(shorts.data(), &pattern, 3, 1), ValueError);
+    EXPECT_GT(detail::streaming_threshold(), 0u);
+  }
+
   TEST(ScopeGuardTest, Execution)
   {
     bool executed = false;
@@ -2,6 +2,10 @@
 #include <tf/core/config.hpp>
 #include <thread>
 #include <future>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
 
 using namespace tf::core;
 
@@ -131,4 +135,163 @@ namespace test
 
     EXPECT_EQ(config().get_option("test1", 0), 1);
   }
-} // namespace test
\ No newline at end of file
+
+  TEST_F(ConfigTest, OptionHandles)
+  {
+    // A handle resolved before the option is set sees later values
+    const OptionHandle<int> handle = config().option<int>("handle_int");
+    EXPECT_FALSE(handle.is_set());
+    EXPECT_EQ(handle.get(7), 7);
+
+    config().set_option("handle_int", 3);
+    EXPECT_TRUE(handle.is_set());
+    EXPECT_EQ(handle.get(7), 3);
+
+    handle.set(5);
+    EXPECT_EQ(config().get_option("handle_int", 0), 5);
+    EXPECT_EQ(handle.name(), "handle_int");
+
+    const OptionHandle<std::string> text = config().option<std::string>("handle_string");
+    text.set("value");
+    EXPECT_EQ(config().get_option("handle_string", std::string()), "value");
+
+    // The type of an option is fixed by its first use
+    EXPECT_THROW(config().option<std::string>("handle_int"), TypeError);
+    EXPECT_THROW(config().set_option("handle_int", 1.5), TypeError);
+  }
+
+  TEST_F(ConfigTest, GuardsAreThreadLocal)
+  {
+    const OptionHandle<int> handle = config().option<int>("guarded");
+    handle.set(1);
+
+    {
+      TF_WITH_CONFIG("guarded", 2);
+      TF_WITH_CONFIG("guarded_new", 3);
+      EXPECT_EQ(handle.get(0), 2);
+      EXPECT_EQ(config().get_option("guarded_new", 0), 3);
+
+      int seen = 0;
+      std::thread other([&]
+                        { seen = handle.get(0); });
+      other.join();
+      EXPECT_EQ(seen, 1);
+
+      // Setting the global value keeps the guard's value on this thread
+      handle.set(4);
+      EXPECT_EQ(handle.get(0), 2);
+    }
+
+    EXPECT_EQ(handle.get(0), 4);
+    EXPECT_FALSE(config().option<int>("guarded_new").is_set());
+  }
+
+  TEST_F(ConfigTest, ReadsDuringWrites)
+  {
+    const OptionHandle<std::string> text = config().option<std::string>("contended");
+    text.set("a");
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+      readers.emplace_back([&]
+                           {
+                             while (!done.load())
+                             {
+                               const int threads = config().num_threads();
+                               ASSERT_TRUE(threads == 4 || threads == 8);
+                               const std::string value = text.get("");
+                               ASSERT_TRUE(value == "a" || value == "bb");
+                               ASSERT_GE(config().get_option("contended_count", 0), 0);
+                             } });
+
+    for (int i = 0; i < 2000; ++i)
+    {
+      config().set_num_threads(i % 2 ? 8 : 4);
+      text.set(i % 2 ? "bb" : "a");
+      config().set_option("contended_count", i);
+      // New names publish a new index while readers use the old one
+      if (i % 100 == 0)
+        config().set_option("contended_" + std::to_string(i), i);
+    }
+    done = true;
+
+    for (std::thread &reader : readers)
+      reader.join();
+    EXPECT_EQ(config().get_option("contended_1900", 0), 1900);
+  }
+
+  TEST_F(ConfigTest, RetiredVersionsStayBounded)
+  {
+    constexpr int READERS = 4;
+    tf::core::detail::RcuCell<std::string> cell(std::make_unique<const std::string>("0"));
+
+    std::atomic<bool> done{false};
+    std::atomic<int> started{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < READERS; ++t)
+      readers.emplace_back([&]
+                           {
+                             started.fetch_add(1);
+                             // Some reader is almost always inside a read
+                             while (!done.load())
+                               cell.read([](const std::string *value)
+                                         { ASSERT_FALSE(value->empty()); }); });
+    while (started.load() < READERS)
+      std::this_thread::yield();
+
+    size_t peak = 0;
+    for (int i = 1; i <= 20000; ++i)
+    {
+      cell.publish(std::make_unique<const std::string>(std::to_string(i)));
+      peak = std::max(peak, cell.retired());
+    }
+
+    // Versions retired before the readers' current reads are freed
+    for (int i = 0; i < 1000 && cell.retired() > READERS; ++i)
+    {
+      std::this_thread::yield();
+      cell.publish(std::make_unique<const std::string>("last"));
+    }
+    EXPECT_LE(cell.retired(), static_cast<size_t>(READERS));
+    EXPECT_LT(peak, 20000u);
+
+    done = true;
+    for (std::thread &reader : readers)
+      reader.join();
+    cell.publish(std::make_unique<const std::string>("idle"));
+    EXPECT_EQ(cell.retired(), 0u);
+  }
+
+  TEST_F(ConfigTest, ReadersKeepTheirVersionAlive)
+  {
+    tf::core::detail::RcuCell<std::string> cell(std::make_unique<const std::string>("held"));
+
+    std::atomic<bool> reading{false}, release{false};
+    std::string seen;
+    std::thread reader([&]
+                       { cell.read([&](const std::string *value)
+                                   {
+                                     reading = true;
+                                     while (!release.load())
+                                       std::this_thread::yield();
+                                     seen = *value; }); });
+    while (!reading.load())
+      std::this_thread::yield();
+
+    // Nothing retired while the read runs can be freed
+    for (int i = 0; i < 100; ++i)
+      cell.publish(std::make_unique<const std::string>(std::to_string(i)));
+    EXPECT_EQ(cell.retired(), 100u);
+
+    release = true;
+    reader.join();
+    EXPECT_EQ(seen, "held");
+
+    cell.publish(std::make_unique<const std::string>("next"));
+    EXPECT_EQ(cell.retired(), 0u);
+    EXPECT_EQ(cell.read([](const std::string *value)
+                        { return *value; }),
+              "next");
+  }
+} // namespace test
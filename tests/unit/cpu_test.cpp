@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <tf/core/cpu.hpp>
+#include <string>
+
+using namespace tf::core;
+
+namespace test
+{
+  TEST(CpuTest, FeaturesAreConsistent)
+  {
+    const CpuFeatures &features = cpu_features();
+
+    // Detection runs once; later calls see the same object
+    EXPECT_EQ(&features, &cpu_features());
+
+    if (features.avx512f)
+      EXPECT_TRUE(features.avx2);
+
+    EXPECT_GT(features.l1d_cache_size, 0u);
+    EXPECT_GE(features.l2_cache_size, features.l1d_cache_size);
+  }
+
+  TEST(CpuTest, SelectedIsaIsSupported)
+  {
+    const CpuFeatures &features = cpu_features();
+    CpuIsa isa = cpu_isa();
+
+    switch (isa)
+    {
+    case CpuIsa::AVX512:
+      EXPECT_TRUE(features.avx512f && features.avx512bw);
+      break;
+    case CpuIsa::AVX2:
+      EXPECT_TRUE(features.avx2 && features.fma);
+      break;
+    case CpuIsa::SSE4:
+      EXPECT_TRUE(features.sse4_2);
+      break;
+    case CpuIsa::NEON:
+      EXPECT_TRUE(features.neon);
+      break;
+    case CpuIsa::Generic:
+      break;
+    }
+
+    EXPECT_FALSE(std::string(isa_name(isa)).empty());
+    EXPECT_EQ(std::string(isa_name(CpuIsa::AVX2)), "avx2");
+  }
+} // namespace test
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <tf/core/config.hpp>
+#include <tf/core/device.hpp>
+#include <tf/math/blas.hpp>
+#include <tf/math/random.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace tf::core;
+using tf::math::Blas;
+using tf::math::BlasOperation;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for the CUDA backend
+   *
+   * Tests that need a device are skipped when none is available; the
+   * others check that a host-only build degrades cleanly.
+   */
+  class DeviceTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      tf::math::RandomGenerator::instance().set_seed(11);
+      config().set_default_device(DeviceType::CPU);
+      config().set_memory_fraction(0.9f);
+    }
+
+    void TearDown() override
+    {
+      config().set_default_device(DeviceType::CPU);
+      config().set_memory_fraction(0.9f);
+      cuda::DeviceAllocator::instance().empty_cache();
+    }
+
+    static TensorView<float> random(const Shape &shape)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      tf::math::RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                                         -1.0f, 1.0f);
+      return view;
+    }
+
+    static std::vector<float> reference_gemm(const TensorView<float> &A, const TensorView<float> &B)
+    {
+      const auto m = A.dim(0), k = A.dim(1), n = B.dim(1);
+      std::vector<float> C(static_cast<size_t>(m * n), 0.0f);
+      for (index_t i = 0; i < m; ++i)
+        for (index_t p = 0; p < k; ++p)
+          for (index_t j = 0; j < n; ++j)
+            C[i * n + j] += A.data()[i * k + p] * B.data()[p * n + j];
+      return C;
+    }
+  };
+
+  TEST_F(DeviceTest, HostOnlyBuildsDegradeCleanly)
+  {
+    if (cuda::available())
+      GTEST_SKIP() << "A CUDA device is available";
+
+    EXPECT_EQ(cuda::device_count(), 0);
+    EXPECT_FALSE(cuda::is_device_pointer(this));
+    EXPECT_FALSE(cuda::DeviceAllocator::instance().in_use());
+    EXPECT_EQ(cuda::DeviceAllocator::instance().allocated_bytes(), 0u);
+    EXPECT_EQ(cuda::DeviceAllocator::instance().allocate(0), nullptr);
+
+    EXPECT_THROW(cuda::Stream(), DeviceError);
+    EXPECT_THROW(cuda::DeviceAllocator::instance().allocate(256), DeviceError);
+    EXPECT_THROW(cuda::to_device(random({4, 4})), DeviceError);
+
+    // A CUDA default device falls back to the host kernels
+    config().set_default_device(DeviceType::CUDA);
+    const auto A = random({300, 260});
+    const auto B = random({260, 270});
+    auto C = TensorView<float>::allocate({300, 270});
+    Blas::gemm(1.0f, A, B, 0.0f, C);
+
+    const auto expected = reference_gemm(A, B);
+    for (size_t i = 0; i < expected.size(); i += 97)
+      ASSERT_NEAR(C.data()[i], expected[i], 1e-3f);
+  }
+
+  TEST_F(DeviceTest, CopiesRoundTrip)
+  {
+    if (!cuda::available())
+      GTEST_SKIP() << "No CUDA device";
+
+    // Larger than one staging buffer, and a strided view
+    const auto host = random({1500, 1000});
+    const auto device = cuda::to_device(host);
+    EXPECT_TRUE(cuda::is_device_pointer(device.data()));
+
+    const auto back = cuda::to_host(device);
+    for (index_t i = 0; i < host.num_elements(); ++i)
+      ASSERT_EQ(back.data()[i], host.data()[i]);
+
+    const auto transposed = cuda::to_host(cuda::to_device(host.transpose()));
+    EXPECT_EQ(transposed.shape(), Shape({1000, 1500}));
+    EXPECT_EQ(transposed.data()[1500 * 3 + 7], host.data()[1000 * 7 + 3]);
+  }
+
+  TEST_F(DeviceTest, AllocatorCachesPerStream)
+  {
+    if (!cuda::available())
+      GTEST_SKIP() << "No CUDA device";
+
+    cuda::DeviceAllocator &allocator = cuda::DeviceAllocator::instance();
+    cuda::Stream stream;
+
+    void *first = allocator.allocate(1000, stream);
+    const size_t reserved = allocator.reserved_bytes();
+    EXPECT_GE(allocator.allocated_bytes(), 1000u);
+    allocator.deallocate(first);
+
+    // Same stream, similar size: the cached block comes back
+    void *second = allocator.allocate(900, stream);
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(allocator.reserved_bytes(), reserved);
+
+    // Another stream never reuses it while it is cached
+    allocator.deallocate(second);
+    void *other = allocator.allocate(900, cuda::Stream::current());
+    EXPECT_NE(other, first);
+    allocator.deallocate(other);
+
+    allocator.empty_cache();
+    EXPECT_EQ(allocator.reserved_bytes(), 0u);
+    int host = 0;
+    EXPECT_THROW(allocator.deallocate(&host), ValueError);
+  }
+
+  TEST_F(DeviceTest, AllocatorRespectsMemoryFraction)
+  {
+    if (!cuda::available())
+      GTEST_SKIP() << "No CUDA device";
+
+    cuda::DeviceAllocator &allocator = cuda::DeviceAllocator::instance();
+    config().set_memory_fraction(0.25f);
+    const size_t limit = allocator.limit();
+
+    EXPECT_THROW(allocator.allocate(limit + (4 << 20)), MemoryError);
+
+    void *ptr = allocator.allocate(limit / 2);
+    EXPECT_LE(allocator.reserved_bytes(), limit);
+    allocator.deallocate(ptr);
+  }
+
+  TEST_F(DeviceTest, GemmRunsOnDeviceOperands)
+  {
+    if (!cuda::available())
+      GTEST_SKIP() << "No CUDA device";
+
+    const auto A = random({70, 50});
+    const auto B = random({50, 90});
+    const auto expected = reference_gemm(A, B);
+
+    cuda::Stream stream;
+    cuda::StreamGuard guard(stream);
+    const auto dA = cuda::to_device(A);
+    const auto dB = cuda::to_device(B);
+    const auto dBt = cuda::to_device(B.transpose().contiguous());
+    auto dC = cuda::to_device(TensorView<float>::allocate({70, 90}));
+
+    Blas::gemm(1.0f, dA, dB, 0.0f, dC);
+    auto C = cuda::to_host(dC);
+    for (size_t i = 0; i < expected.size(); ++i)
+      ASSERT_NEAR(C.data()[i], expected[i], 1e-4f);
+
+    // Transposed operand, accumulating into C
+    Blas::gemm(1.0f, dA, dBt.transpose(), 1.0f, dC);
+    C = cuda::to_host(dC);
+    for (size_t i = 0; i < expected.size(); ++i)
+      ASSERT_NEAR(C.data()[i], 2 * expected[i], 2e-4f);
+
+    // Mixed host and device operands are rejected
+    EXPECT_THROW(Blas::gemm(1.0f, A, dB, 0.0f, dC), DeviceError);
+  }
+
+  TEST_F(DeviceTest, LargeHostGemmsOffload)
+  {
+    if (!cuda::available())
+      GTEST_SKIP() << "No CUDA device";
+
+    const auto A = random({300, 280});
+    const auto B = random({280, 260});
+    const auto expected = reference_gemm(A, B);
+
+    config().set_default_device(DeviceType::CUDA);
+    auto C = TensorView<float>::allocate({300, 260});
+    Blas::gemm(1.0f, A, B, 0.0f, C);
+
+    // Staging buffers went back to the cache
+    EXPECT_EQ(cuda::DeviceAllocator::instance().allocated_bytes(), 0u);
+    EXPECT_GT(cuda::DeviceAllocator::instance().reserved_bytes(), 0u);
+    for (size_t i = 0; i < expected.size(); ++i)
+      ASSERT_NEAR(C.data()[i], expected[i], 1e-3f);
+  }
+} // namespace test
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <tf/core/config.hpp>
+#include <tf/math/elementwise.hpp>
+#include <tf/math/random.hpp>
+#include <tf/math/utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace tf::math;
+using tf::core::index_t;
+using tf::core::Shape;
+using tf::core::shape_t;
+using tf::core::TensorView;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for the broadcasting elementwise engine.
+   */
+  class ElementwiseTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(11);
+    }
+
+    static TensorView<float> random(const Shape &shape)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                               0.5f, 2.0f);
+      return view;
+    }
+  };
+
+  TEST_F(ElementwiseTest, BroadcastShapes)
+  {
+    EXPECT_EQ(tf::core::broadcast_shapes(Shape({4, 1, 3}), Shape({5, 1})), Shape({4, 5, 3}));
+    EXPECT_EQ(tf::core::broadcast_shapes(Shape({}), Shape({2, 2})), Shape({2, 2}));
+    EXPECT_THROW(tf::core::broadcast_shapes(Shape({2, 3}), Shape({4})), tf::core::ShapeError);
+  }
+
+  TEST_F(ElementwiseTest, PlansCollapseAndAreCached)
+  {
+    // Bias add over (8, 16, 32): rows collapse, the bias keeps stride 0
+    const Shape shape({8, 16, 32});
+    const shape_t dense = tf::core::contiguous_strides(shape);
+    const BroadcastPlan &plan = broadcast_plan(shape, dense, dense, shape_t{0, 0, 1});
+    EXPECT_EQ(plan.dims, (shape_t{128, 32}));
+    EXPECT_EQ(plan.strides[0], (shape_t{32, 1}));
+    EXPECT_EQ(plan.strides[2], (shape_t{0, 1}));
+
+    const BroadcastPlan *first = &plan;
+    EXPECT_EQ(&broadcast_plan(shape, dense, dense, shape_t{0, 0, 1}), first);
+
+    // Fully dense operands become one run
+    EXPECT_EQ(broadcast_plan(shape, dense, dense, dense).dims, (shape_t{8 * 16 * 32}));
+  }
+
+  TEST_F(ElementwiseTest, BinaryOpsBroadcastWithoutExpanding)
+  {
+    const BinaryOp ops[] = {BinaryOp::Add, BinaryOp::Subtract, BinaryOp::Multiply,
+                            BinaryOp::Divide, BinaryOp::Maximum, BinaryOp::Minimum};
+    auto reference = [](BinaryOp op, float a, float b)
+    {
+      switch (op)
+      {
+      case BinaryOp::Add:
+        return a + b;
+      case BinaryOp::Subtract:
+        return a - b;
+      case BinaryOp::Multiply:
+        return a * b;
+      case BinaryOp::Divide:
+        return a / b;
+      case BinaryOp::Maximum:
+        return std::max(a, b);
+      case BinaryOp::Minimum:
+        return std::min(a, b);
+      }
+      return 0.0f;
+    };
+
+    auto a = random(Shape({5, 1, 37}));
+    auto b = random(Shape({7, 1}));
+
+    for (BinaryOp op : ops)
+    {
+      TensorView<float> out = binary(op, a, b);
+      ASSERT_EQ(out.shape(), Shape({5, 7, 37}));
+
+      for (index_t i = 0; i < 5; ++i)
+        for (index_t j = 0; j < 7; ++j)
+          for (index_t k = 0; k < 37; ++k)
+            ASSERT_FLOAT_EQ(out(i, j, k), reference(op, a(i, 0, k), b(j, 0)))
+                << static_cast<int>(op) << " " << i << " " << j << " " << k;
+    }
+
+    EXPECT_THROW(binary(BinaryOp::Add, a, random(Shape({3}))), tf::core::ShapeError);
+    auto wrong = TensorView<float>::allocate(Shape({5, 7, 36}));
+    EXPECT_THROW(binary(BinaryOp::Add, a, b, wrong), tf::core::ShapeError);
+    EXPECT_THROW(binary(BinaryOp::Add, a, b, random(Shape({37})).broadcast_to(Shape({5, 7, 37}))),
+                 tf::core::ShapeError);
+  }
+
+  TEST_F(ElementwiseTest, StridedOperandsAndOutputs)
+  {
+    // Transposed input, sliced input and a transposed output
+    auto a = random(Shape({40, 30}));
+    auto b = random(Shape({60, 20}));
+    auto out = TensorView<double>::allocate(Shape({30, 20}));
+    auto ad = TensorView<double>::allocate(Shape({40, 30}));
+    auto bd = TensorView<double>::allocate(Shape({60, 20}));
+    std::copy_n(a.data(), 1200, ad.data());
+    std::copy_n(b.data(), 1200, bd.data());
+
+    auto x = ad.slice(0, 0, 20).transpose(); // (30, 20), column stride 30
+    auto y = bd.slice(0, 0, 60, 2);          // (30, 20), row stride 40
+    binary(BinaryOp::Multiply, x, y, out.transpose().transpose());
+    auto t = TensorView<double>::allocate(Shape({20, 30}));
+    binary(BinaryOp::Subtract, x, y, t.transpose());
+
+    for (index_t i = 0; i < 30; ++i)
+      for (index_t j = 0; j < 20; ++j)
+      {
+        ASSERT_DOUBLE_EQ(out(i, j), x(i, j) * y(i, j));
+        ASSERT_DOUBLE_EQ(t(j, i), x(i, j) - y(i, j));
+      }
+  }
+
+  TEST_F(ElementwiseTest, UnaryOpsMatchScalarFunctions)
+  {
+    auto a = random(Shape({3, 101}));
+    for (index_t i = 0; i < 3 * 101; i += 2)
+      a.data()[i] = -a.data()[i];
+
+    const UnaryOp ops[] = {UnaryOp::Negate, UnaryOp::Abs, UnaryOp::Square, UnaryOp::Relu,
+                           UnaryOp::Sigmoid, UnaryOp::Tanh};
+    for (UnaryOp op : ops)
+    {
+      TensorView<float> out = unary(op, a.transpose());
+      for (index_t i = 0; i < 101; ++i)
+        for (index_t j = 0; j < 3; ++j)
+        {
+          const float v = a(j, i);
+          float expected = 0.0f;
+          switch (op)
+          {
+          case UnaryOp::Negate:
+            expected = -v;
+            break;
+          case UnaryOp::Abs:
+            expected = std::fabs(v);
+            break;
+          case UnaryOp::Square:
+            expected = v * v;
+            break;
+          case UnaryOp::Relu:
+            expected = relu(v);
+            break;
+          case UnaryOp::Sigmoid:
+            expected = sigmoid(v);
+            break;
+          case UnaryOp::Tanh:
+            expected = std::tanh(v);
+            break;
+          default:
+            break;
+          }
+          ASSERT_NEAR(out(i, j), expected, 1e-6f) << static_cast<int>(op);
+        }
+    }
+
+    auto roots = unary(UnaryOp::Sqrt, unary(UnaryOp::Square, a));
+    EXPECT_FLOAT_EQ(roots(0, 0), std::fabs(a(0, 0)));
+
+    // A broadcast input is evaluated once per repeated value
+    auto column = random(Shape({3, 1}));
+    auto filled = TensorView<float>::allocate(Shape({3, 50}));
+    unary(UnaryOp::Negate, column, filled);
+    EXPECT_EQ(filled(2, 49), -column(2, 0));
+  }
+
+  TEST_F(ElementwiseTest, BiasAndRowScaleInPlace)
+  {
+    const int threads = tf::core::config().num_threads();
+    tf::core::config().set_num_threads(4);
+
+    // Large enough to be split across rows
+    auto matrix = random(Shape({513, 257}));
+    auto bias = random(Shape({257}));
+    auto scale = random(Shape({2, 513})).select(0, 1);
+    std::vector<float> original(matrix.data(), matrix.data() + 513 * 257);
+
+    add_bias(matrix, bias);
+    scale_rows(matrix, scale);
+
+    for (index_t i = 0; i < 513; ++i)
+      for (index_t j = 0; j < 257; ++j)
+        ASSERT_FLOAT_EQ(matrix(i, j), (original[static_cast<size_t>(i * 257 + j)] + bias(j)) * scale(i));
+
+    EXPECT_THROW(add_bias(matrix, scale), tf::core::ShapeError);
+
+    // One long run is split across threads too
+    auto x = random(Shape({1 << 18}));
+    auto y = binary(BinaryOp::Add, x, x);
+    EXPECT_EQ(y((1 << 18) - 1), 2.0f * x((1 << 18) - 1));
+
+    tf::core::config().set_num_threads(threads);
+  }
+  TEST_F(ElementwiseTest, ConvertsReducedPrecisionLikeScalarCasts)
+  {
+    // Every half and bfloat16 bit pattern, and an odd count so the vector
+    // body and the scalar tail both run
+    const size_t n = 65536 + 13;
+    std::vector<tf::core::Float16> halves(n);
+    std::vector<tf::core::BFloat16> brains(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      halves[i] = tf::core::Float16::from_bits(static_cast<std::uint16_t>(i));
+      brains[i] = tf::core::BFloat16::from_bits(static_cast<std::uint16_t>(i * 7));
+    }
+
+    std::vector<float> wide(n), back(n);
+    convert(n, halves.data(), wide.data());
+    for (size_t i = 0; i < n; ++i)
+      if (!std::isnan(wide[i]))
+        ASSERT_EQ(wide[i], static_cast<float>(halves[i])) << i;
+
+    convert(n, brains.data(), back.data());
+    for (size_t i = 0; i < n; ++i)
+      if (!std::isnan(back[i]))
+        ASSERT_EQ(back[i], static_cast<float>(brains[i])) << i;
+
+    // Narrowing arbitrary floats, including ties, overflow and subnormals
+    std::vector<float> values(n);
+    RandomGenerator::instance().fill_uniform(values.data(), n, -70000.0f, 70000.0f);
+    for (size_t i = 0; i < n; i += 5)
+      values[i] *= 1e-9f;
+    values[1] = 1.0f + 0x1p-11f;
+    values[2] = 65520.0f;
+    values[3] = std::numeric_limits<float>::infinity();
+
+    std::vector<tf::core::Float16> narrow_half(n);
+    std::vector<tf::core::BFloat16> narrow_brain(n);
+    convert(n, values.data(), narrow_half.data());
+    convert(n, values.data(), narrow_brain.data());
+    for (size_t i = 0; i < n; ++i)
+    {
+      ASSERT_EQ(narrow_half[i].bits, tf::core::Float16(values[i]).bits) << values[i];
+      ASSERT_EQ(narrow_brain[i].bits, tf::core::BFloat16(values[i]).bits) << values[i];
+    }
+  }
+} // namespace test
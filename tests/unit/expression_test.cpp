@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <tf/core/config.hpp>
+#include <tf/math/expression.hpp>
+#include <tf/math/random.hpp>
+#include <tf/math/utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+using namespace tf::math;
+using tf::core::index_t;
+using tf::core::Shape;
+using tf::core::shape_t;
+using tf::core::TensorView;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for lazy elementwise expressions.
+   */
+  class ExpressionTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(5);
+    }
+
+    static TensorView<float> random(const Shape &shape)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                               -2.0f, 2.0f);
+      return view;
+    }
+
+    static void expect_near(const TensorView<float> &actual, const TensorView<float> &expected)
+    {
+      ASSERT_EQ(actual.shape(), expected.shape());
+      const TensorView<float> a = actual.contiguous();
+      const TensorView<float> e = expected.contiguous();
+      for (index_t i = 0; i < a.num_elements(); ++i)
+        ASSERT_NEAR(a.data()[i], e.data()[i], 1e-5f * (1.0f + std::abs(e.data()[i]))) << i;
+    }
+  };
+
+  TEST_F(ExpressionTest, BuildsTreesWithoutComputing)
+  {
+    const auto a = random(Shape({4, 8}));
+    const auto b = random(Shape({4, 8}));
+    const auto c = random(Shape({8}));
+
+    auto expression = relu(a * b + c);
+    using Expected = UnaryExpression<
+        UnaryOp::Relu,
+        BinaryExpression<BinaryOp::Add,
+                         BinaryExpression<BinaryOp::Multiply, TerminalExpression<float>,
+                                          TerminalExpression<float>>,
+                         TerminalExpression<float>>>;
+    static_assert(std::is_same_v<decltype(expression), Expected>);
+    static_assert(Expected::leaves == 3);
+    EXPECT_EQ(expression.shape(), Shape({4, 8}));
+
+    // Scalar activations are unaffected
+    EXPECT_EQ(relu(-1.0f), 0.0f);
+    EXPECT_NEAR(sigmoid(0.0), 0.5, 1e-12);
+  }
+
+  TEST_F(ExpressionTest, FusedChainMatchesUnfusedOps)
+  {
+    const auto a = random(Shape({37, 300}));
+    const auto b = random(Shape({37, 300}));
+    const auto c = random(Shape({300}));
+
+    const auto expected = unary(UnaryOp::Relu, binary(BinaryOp::Add, binary(BinaryOp::Multiply, a, b), c));
+    expect_near(evaluate(relu(a * b + c)), expected);
+
+    const auto mixed = evaluate(tanh(sqrt(abs(a)) - square(b) / 4.0f) * 2.0f + sigmoid(-c));
+    for (index_t i = 0; i < 37; ++i)
+      for (index_t j = 0; j < 300; ++j)
+      {
+        const float reference = std::tanh(std::sqrt(std::abs(a(i, j))) - b(i, j) * b(i, j) / 4.0f) * 2.0f +
+                                1.0f / (1.0f + std::exp(c(j)));
+        ASSERT_NEAR(mixed(i, j), reference, 1e-5f) << i << ", " << j;
+      }
+
+    const auto clamped = evaluate(maximum(a, 0.5f) + minimum(1.0f - b, 2.0f * a));
+    for (index_t i = 0; i < 37; ++i)
+      for (index_t j = 0; j < 300; ++j)
+        ASSERT_FLOAT_EQ(clamped(i, j), std::max(a(i, j), 0.5f) + std::min(1.0f - b(i, j), 2.0f * a(i, j)));
+  }
+
+  TEST_F(ExpressionTest, StridedAndBroadcastOperands)
+  {
+    const auto a = random(Shape({64, 48}));
+    const auto b = random(Shape({48, 64}));
+    const auto column = random(Shape({64, 1}));
+
+    // Transposed and sliced inputs are gathered, a strided output scattered
+    const auto bt = b.transpose();
+    const auto sliced = random(Shape({64, 96})).slice(1, 0, 96, 2);
+    auto out = TensorView<float>::allocate(Shape({48, 64})).transpose();
+
+    assign(out, a * bt - column + sliced);
+    for (index_t i = 0; i < 64; ++i)
+      for (index_t j = 0; j < 48; ++j)
+        ASSERT_NEAR(out(i, j), a(i, j) * b(j, i) - column(i, 0) + sliced(i, j), 1e-5f);
+
+    // A subtree of repeated values is computed once per block
+    const auto corner = a.slice(0, 0, 1).slice(1, 0, 1);
+    auto filled = TensorView<float>::allocate(Shape({3, 500}));
+    assign(filled, relu(corner * 0.0f + 3.0f));
+    for (index_t i = 0; i < filled.num_elements(); ++i)
+      ASSERT_FLOAT_EQ(filled.data()[i], 3.0f);
+
+    EXPECT_THROW(assign(out, a * b), tf::core::ShapeError);
+    const auto repeated = TensorView<float>::allocate(Shape({8})).broadcast_to(Shape({4, 8}));
+    EXPECT_THROW(assign(repeated, relu(a.slice(0, 0, 4).slice(1, 0, 8))), tf::core::ShapeError);
+  }
+
+  TEST_F(ExpressionTest, AssignsInPlaceAndIndependentOfThreadCount)
+  {
+    const int threads = tf::core::config().num_threads();
+    const auto b = random(Shape({257, 129}));
+    const auto c = random(Shape({129}));
+
+    std::vector<float> results[2];
+    const int counts[2] = {1, 4};
+    for (int k = 0; k < 2; ++k)
+    {
+      tf::core::config().set_num_threads(counts[k]);
+      RandomGenerator::instance().set_seed(9);
+      auto a = random(Shape({257, 129}));
+      const auto expected = evaluate(relu(a * b + c));
+
+      assign(a, relu(a * b + c));
+      expect_near(a, expected);
+      results[k].assign(a.data(), a.data() + a.num_elements());
+    }
+    tf::core::config().set_num_threads(threads);
+
+    EXPECT_EQ(results[0], results[1]);
+  }
+} // namespace test
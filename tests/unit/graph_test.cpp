@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/blas.hpp>
+#include <tf/math/elementwise.hpp>
+#include <tf/math/random.hpp>
+#include <tf/ops/executor.hpp>
+#include <tf/ops/graph.hpp>
+#include <tf/utils/arena.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace tf::ops;
+using tf::core::Shape;
+using tf::core::TensorView;
+using tf::math::BinaryOp;
+using tf::math::UnaryOp;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for graph recording and execution.
+   */
+  class GraphTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      tf::math::RandomGenerator::instance().set_seed(5);
+    }
+
+    static TensorView<float> random(const Shape &shape)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      tf::math::RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                                         -1.0f, 1.0f);
+      return view;
+    }
+
+    static TensorView<float> matmul(const TensorView<float> &a, const TensorView<float> &b)
+    {
+      auto out = TensorView<float>::allocate({a.dim(0), b.dim(1)});
+      tf::math::Blas::gemm(1.0f, a, b, 0.0f, out);
+      return out;
+    }
+
+    static TensorView<float> binary(BinaryOp op, const TensorView<float> &a, const TensorView<float> &b)
+    {
+      auto out = TensorView<float>::allocate(tf::core::broadcast_shapes(a.shape(), b.shape()));
+      tf::math::binary(op, a, b, out);
+      return out;
+    }
+
+    static TensorView<float> unary(UnaryOp op, const TensorView<float> &a)
+    {
+      auto out = TensorView<float>::allocate(a.shape());
+      tf::math::unary(op, a, out);
+      return out;
+    }
+
+    static void expect_near(const TensorView<float> &actual, const TensorView<float> &expected)
+    {
+      ASSERT_EQ(actual.shape(), expected.shape());
+      for (int64_t i = 0; i < expected.num_elements(); ++i)
+        ASSERT_NEAR(actual.data()[i], expected.data()[i], 1e-4f) << "at " << i;
+    }
+  };
+
+  TEST_F(GraphTest, RecordsAndChecksShapes)
+  {
+    Graph graph;
+    const NodeId x = graph.input("x", {4, 3});
+    const NodeId w = graph.constant(random({5, 3}));
+    const NodeId y = graph.matmul(x, w, false, true);
+    EXPECT_EQ(graph.node(y).shape, Shape({4, 5}));
+    EXPECT_EQ(graph.node(y).inputs, (std::vector<NodeId>{x, w}));
+
+    const NodeId column = graph.input("column", {4, 1});
+    EXPECT_EQ(graph.node(graph.binary(BinaryOp::Add, y, column)).shape, Shape({4, 5}));
+    EXPECT_EQ(graph.node(graph.unary(UnaryOp::Tanh, y)).shape, Shape({4, 5}));
+    EXPECT_EQ(graph.inputs(), (std::vector<NodeId>{x, column}));
+    EXPECT_EQ(graph.output(y), 0u);
+
+    EXPECT_THROW(graph.matmul(x, w), tf::core::ShapeError);
+    EXPECT_THROW(graph.matmul(x, graph.scalar(1.0f)), tf::core::ShapeError);
+    EXPECT_THROW(graph.binary(BinaryOp::Add, x, w), tf::core::ShapeError);
+    EXPECT_THROW(graph.unary(UnaryOp::Relu, 100), tf::core::IndexError);
+    EXPECT_THROW(graph.output(100), tf::core::IndexError);
+  }
+
+  TEST_F(GraphTest, MatchesEagerOperations)
+  {
+    const auto x = random({9, 16});
+    const auto w1 = random({16, 12});
+    const auto b1 = random({12});
+    const auto w2 = random({10, 12});
+    const auto s = random({9, 1});
+
+    Graph graph;
+    const NodeId in = graph.input("x", x.shape());
+    NodeId h = graph.matmul(in, graph.constant(w1));
+    h = graph.unary(UnaryOp::Relu, graph.binary(BinaryOp::Add, h, graph.constant(b1)));
+    NodeId o = graph.matmul(h, graph.constant(w2), false, true);
+    o = graph.binary(BinaryOp::Multiply, graph.constant(s), o);
+    o = graph.unary(UnaryOp::Sigmoid, graph.binary(BinaryOp::Subtract, o, graph.scalar(0.25f)));
+    graph.output(o);
+    graph.output(h);
+
+    auto eh = unary(UnaryOp::Relu, binary(BinaryOp::Add, matmul(x, w1), b1));
+    auto eo = binary(BinaryOp::Multiply, s, matmul(eh, w2.transpose().contiguous()));
+    auto scalar = TensorView<float>::allocate(Shape{});
+    scalar.data()[0] = 0.25f;
+    eo = unary(UnaryOp::Sigmoid, binary(BinaryOp::Subtract, eo, scalar));
+
+    for (bool fuse : {true, false})
+      for (bool concurrent : {true, false})
+      {
+        Executor executor(graph, {fuse, concurrent});
+        executor.bind(in, x);
+        executor.run();
+        expect_near(executor.output(0), eo);
+        expect_near(executor.output(1), eh);
+      }
+  }
+
+  TEST_F(GraphTest, FusesBiasAndActivationIntoTheGemm)
+  {
+    const auto x = random({6, 8});
+    const auto w = random({8, 5});
+    const auto column = random({1, 5});
+    const auto row = random({6, 1});
+
+    Graph graph;
+    const NodeId in = graph.input("x", x.shape());
+    NodeId y = graph.matmul(in, graph.constant(w));
+    y = graph.binary(BinaryOp::Add, graph.constant(column), y);
+    y = graph.binary(BinaryOp::Add, y, graph.constant(row));
+    y = graph.unary(UnaryOp::Tanh, y);
+    // Nothing folds into the epilogue after the activation
+    y = graph.unary(UnaryOp::Relu, y);
+    graph.output(y);
+
+    Executor executor(graph);
+    ASSERT_EQ(executor.num_kernels(), 2u);
+    const detail::Kernel &gemm = executor.kernels()[0];
+    EXPECT_EQ(gemm.kind, detail::Kernel::Kind::Gemm);
+    EXPECT_EQ(gemm.nodes, 4u);
+    EXPECT_EQ(gemm.activation, tf::math::Activation::Tanh);
+    EXPECT_NE(gemm.row_bias, detail::NO_INDEX);
+    EXPECT_NE(gemm.column_bias, detail::NO_INDEX);
+
+    executor.bind(in, x);
+    executor.run();
+    auto expected = binary(BinaryOp::Add, binary(BinaryOp::Add, matmul(x, w), column), row);
+    expected = unary(UnaryOp::Relu, unary(UnaryOp::Tanh, expected));
+    expect_near(executor.output(0), expected);
+  }
+
+  TEST_F(GraphTest, FusesElementwiseChainsWithBroadcasting)
+  {
+    const auto a = random({7, 300});
+    const auto b = random({300});
+    const auto c = random({7, 1});
+
+    Graph graph;
+    const NodeId na = graph.input("a", a.shape());
+    const NodeId nb = graph.input("b", b.shape());
+    const NodeId nc = graph.input("c", c.shape());
+    NodeId y = graph.binary(BinaryOp::Multiply, na, nb);
+    y = graph.binary(BinaryOp::Add, nc, y);
+    y = graph.unary(UnaryOp::Square, y);
+    y = graph.binary(BinaryOp::Maximum, y, y);
+    y = graph.binary(BinaryOp::Divide, y, graph.scalar(2.0f));
+    y = graph.binary(BinaryOp::Subtract, y, na);
+    graph.output(y);
+
+    // A value read by two nodes is kept in memory
+    const NodeId shared = graph.unary(UnaryOp::Abs, nb);
+    graph.output(graph.binary(BinaryOp::Add, shared, graph.unary(UnaryOp::Negate, shared)));
+
+    Executor executor(graph);
+    EXPECT_EQ(executor.num_kernels(), 3u);
+    const detail::Kernel &chain = executor.kernels()[0];
+    EXPECT_EQ(chain.nodes, 6u);
+    EXPECT_EQ(chain.leaves.size(), 4u);
+    EXPECT_EQ(executor.kernels()[1].nodes, 1u);
+
+    executor.bind(na, a);
+    executor.bind(nb, b);
+    executor.bind(nc, c);
+    executor.run();
+
+    auto two = TensorView<float>::allocate(Shape{});
+    two.data()[0] = 2.0f;
+    auto expected = unary(UnaryOp::Square, binary(BinaryOp::Add, c, binary(BinaryOp::Multiply, a, b)));
+    expected = binary(BinaryOp::Subtract, binary(BinaryOp::Divide, expected, two), a);
+    expect_near(executor.output(0), expected);
+
+    const auto zero = executor.output(1);
+    for (int64_t i = 0; i < zero.num_elements(); ++i)
+      ASSERT_EQ(zero.data()[i], 0.0f);
+  }
+
+  TEST_F(GraphTest, PlansOneBufferWithReuse)
+  {
+    const auto x = random({32, 64});
+    std::vector<TensorView<float>> weights;
+
+    Graph graph;
+    const NodeId in = graph.input("x", x.shape());
+    NodeId h = in;
+    auto expected = x;
+    for (int layer = 0; layer < 5; ++layer)
+    {
+      weights.push_back(random({64, 64}));
+      h = graph.unary(UnaryOp::Tanh, graph.matmul(h, graph.constant(weights.back())));
+      expected = unary(UnaryOp::Tanh, matmul(expected, weights.back()));
+    }
+    graph.output(h);
+
+    Executor executor(graph);
+    EXPECT_EQ(executor.num_kernels(), 5u);
+    EXPECT_EQ(executor.num_levels(), 5u);
+    EXPECT_EQ(executor.intermediate_size(), 5u * 32 * 64 * sizeof(float));
+    // Each layer only needs its input and output alive
+    EXPECT_EQ(executor.arena_size(), 2u * 32 * 64 * sizeof(float));
+
+    executor.bind(in, x);
+    executor.run();
+    const float *first = executor.output(0).data();
+    expect_near(executor.output(0), expected);
+
+    executor.run();
+    EXPECT_EQ(executor.output(0).data(), first);
+    expect_near(executor.output(0), expected);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0u);
+  }
+
+  TEST_F(GraphTest, RunsIndependentBranchesTogether)
+  {
+    const auto x = random({24, 40});
+
+    Graph graph;
+    const NodeId in = graph.input("x", x.shape());
+    NodeId sum = 0;
+    TensorView<float> expected;
+    for (int branch = 0; branch < 4; ++branch)
+    {
+      const auto w = random({40, 24});
+      const NodeId y = graph.unary(UnaryOp::Relu, graph.matmul(in, graph.constant(w)));
+      const auto e = unary(UnaryOp::Relu, matmul(x, w));
+      sum = branch == 0 ? y : graph.binary(BinaryOp::Add, sum, y);
+      expected = branch == 0 ? e : binary(BinaryOp::Add, expected, e);
+    }
+    graph.output(sum);
+
+    Executor executor(graph);
+    EXPECT_EQ(executor.num_kernels(), 5u);
+    EXPECT_EQ(executor.num_levels(), 2u);
+    executor.bind(in, x);
+
+    // The four products share a level, so none of them may reuse another's
+    // memory
+    EXPECT_EQ(executor.arena_size(), 5u * 24 * 24 * sizeof(float));
+
+    for (int repeat = 0; repeat < 20; ++repeat)
+    {
+      executor.run();
+      expect_near(executor.output(0), expected);
+    }
+  }
+
+  TEST_F(GraphTest, OutputsInputsAndSkipsDeadNodes)
+  {
+    const auto x = random({3, 4});
+    const auto c = random({4});
+
+    Graph graph;
+    const NodeId in = graph.input("x", x.shape());
+    const NodeId unused = graph.input("unused", {2});
+    graph.unary(UnaryOp::Negate, unused);
+    const NodeId constant = graph.constant(c);
+    graph.output(in);
+    graph.output(constant);
+    graph.output(graph.binary(BinaryOp::Add, in, constant));
+
+    Executor executor(graph);
+    EXPECT_EQ(executor.num_kernels(), 1u);
+    executor.bind(in, x);
+    executor.run();
+
+    EXPECT_EQ(executor.output(0).data(), x.data());
+    EXPECT_EQ(executor.output(1).data(), c.data());
+    expect_near(executor.output(2), binary(BinaryOp::Add, x, c));
+  }
+
+  TEST_F(GraphTest, RejectsInvalidUse)
+  {
+    Graph empty;
+    empty.input("x", {2});
+    EXPECT_THROW(Executor{empty}, tf::core::ValueError);
+
+    Graph graph;
+    const NodeId in = graph.input("x", {2, 3});
+    const NodeId y = graph.unary(UnaryOp::Relu, in);
+    graph.output(y);
+
+    Executor executor(graph);
+    EXPECT_THROW(executor.run(), tf::core::ValueError);
+    EXPECT_THROW(executor.bind(y, random({2, 3})), tf::core::IndexError);
+    EXPECT_THROW(executor.bind(in, random({3, 2})), tf::core::ShapeError);
+    EXPECT_THROW(executor.bind(in, random({3, 2}).transpose()), tf::core::ShapeError);
+    EXPECT_THROW(executor.output(1), tf::core::IndexError);
+
+    executor.bind(in, random({2, 3}));
+    EXPECT_NO_THROW(executor.run());
+  }
+
+  TEST_F(GraphTest, ConstantsOutliveArenaScopes)
+  {
+    const auto w = random({6, 4});
+
+    Graph graph;
+    const NodeId in = graph.input("x", {3, 6});
+    NodeId out;
+    {
+      // A strided constant and a scalar are copied inside the scope
+      tf::utils::ArenaScope scope;
+      out = graph.binary(BinaryOp::Add, graph.matmul(in, graph.constant(w.transpose().contiguous().transpose())),
+                         graph.scalar(0.5f));
+    }
+    graph.output(out);
+
+    {
+      tf::utils::ArenaScope scope;
+      auto scratch = TensorView<float>::allocate({64, 64});
+      std::fill_n(scratch.data(), scratch.num_elements(), 12345.0f);
+    }
+
+    const auto x = random({3, 6});
+    auto half = TensorView<float>::allocate(Shape{});
+    half.data()[0] = 0.5f;
+    Executor executor(graph);
+    executor.bind(in, x);
+    executor.run();
+    expect_near(executor.output(0), binary(BinaryOp::Add, matmul(x, w), half));
+  }
+} // namespace test
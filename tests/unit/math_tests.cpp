@@ -1,9 +1,14 @@
 #include <gtest/gtest.h>
 #include <tf/math/random.hpp>
 #include <tf/math/utils.hpp>
+#include <tf/core/config.hpp>
 #include <vector>
 #include <thread>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
 
 using namespace tf::math;
 
@@ -71,6 +76,130 @@ namespace test
     EXPECT_NEAR(static_cast<float>(count) / trials, 0.5f, 0.1f);
   }
 
+  TEST_F(MathTest, PhiloxKnownAnswers)
+  {
+    // Known-answer vectors of the Philox4x32-10 reference implementation
+    using Block = Philox4x32::block_type;
+    EXPECT_EQ(Philox4x32::block(0, 0, 0),
+              (Block{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}));
+    EXPECT_EQ(Philox4x32::block(0x299f31d0a4093822ull, 0x0370734413198a2eull, 0x85a308d3243f6a88ull),
+              (Block{0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}));
+
+    Philox4x32 engine(7, 3);
+    Philox4x32 skipped(7, 3);
+    skipped.discard(6);
+
+    Block second = Philox4x32::block(7, 3, 1);
+    for (int i = 0; i < 6; ++i)
+      engine();
+    EXPECT_EQ(engine(), second[2]);
+    EXPECT_EQ(skipped(), second[2]);
+  }
+
+  TEST_F(MathTest, PhiloxFillMatchesBlocks)
+  {
+    const uint64_t seed = 1234, stream = 5;
+    std::vector<float> values(103);
+    philox_uniform(values.data(), values.size(), -2.0f, 2.0f, seed, stream);
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      const uint32_t word = Philox4x32::block(seed, stream, i / 4)[i % 4];
+      const float expected = -2.0f + 4.0f * (static_cast<float>(word >> 8) * 0x1p-24f);
+      ASSERT_EQ(values[i], expected) << "at " << i;
+    }
+
+    // Normal values follow Box-Muller on the same blocks
+    std::vector<double> normals(21);
+    philox_normal(normals.data(), normals.size(), 1.0, 2.0, seed, stream);
+
+    for (size_t i = 0; i < normals.size(); i += 2)
+    {
+      const auto w = Philox4x32::block(seed, stream, i / 2);
+      const double u1 = static_cast<double>((((static_cast<uint64_t>(w[0]) << 32) | w[1]) >> 11) + 1) * 0x1p-53;
+      const double u2 = static_cast<double>(((static_cast<uint64_t>(w[2]) << 32) | w[3]) >> 11) * 0x1p-53;
+      const double radius = std::sqrt(-2.0 * std::log(u1));
+
+      EXPECT_NEAR(normals[i], 1.0 + 2.0 * radius * std::cos(2.0 * M_PI * u2), 1e-9) << "at " << i;
+      if (i + 1 < normals.size())
+        EXPECT_NEAR(normals[i + 1], 1.0 + 2.0 * radius * std::sin(2.0 * M_PI * u2), 1e-9) << "at " << i;
+    }
+  }
+
+  TEST_F(MathTest, PhiloxFillIndependentOfThreadsAndChunks)
+  {
+    const size_t n = 200003;
+    std::vector<float> serial(n), parallel(n), pieces(n);
+    const int threads = tf::core::config().num_threads();
+
+    tf::core::config().set_num_threads(1);
+    philox_normal(serial.data(), n, 0.0f, 1.0f, 99);
+
+    tf::core::config().set_num_threads(4);
+    philox_normal(parallel.data(), n, 0.0f, 1.0f, 99);
+    tf::core::config().set_num_threads(threads);
+    EXPECT_EQ(serial, parallel);
+
+    // Any split of the stream at any offset gives the same values
+    const size_t splits[] = {0, 1, 6, 67, 4099, 100001, n};
+    for (size_t i = 0; i + 1 < std::size(splits); ++i)
+      philox_normal(pieces.data() + splits[i], splits[i + 1] - splits[i], 0.0f, 1.0f, 99, 0, splits[i]);
+    EXPECT_EQ(serial, pieces);
+
+    // Different streams differ
+    philox_normal(pieces.data(), n, 0.0f, 1.0f, 99, 1);
+    EXPECT_NE(serial, pieces);
+
+    EXPECT_THROW(philox_uniform(static_cast<float *>(nullptr), 4, 0.0f, 1.0f, 1), tf::core::ValueError);
+  }
+
+  TEST_F(MathTest, PhiloxDistributionMoments)
+  {
+    const size_t n = 1 << 20;
+    std::vector<float> uniform(n);
+    std::vector<double> normal(n);
+
+    philox_uniform(uniform.data(), n, 1.0f, 3.0f, 42);
+    philox_normal(normal.data(), n, -1.0, 0.5, 42);
+
+    EXPECT_TRUE(std::all_of(uniform.begin(), uniform.end(), [](float v)
+                            { return v >= 1.0f && v < 3.0f; }));
+    EXPECT_NEAR(mean(uniform.begin(), uniform.end()), 2.0, 0.01);
+    EXPECT_NEAR(variance(uniform.begin(), uniform.end()), 1.0 / 3.0, 0.01);
+
+    EXPECT_TRUE(std::all_of(normal.begin(), normal.end(), [](double v)
+                            { return std::isfinite(v); }));
+    EXPECT_NEAR(mean(normal.begin(), normal.end()), -1.0, 0.005);
+    EXPECT_NEAR(stddev(normal.begin(), normal.end()), 0.5, 0.005);
+
+    // Fraction within one standard deviation
+    size_t inside = std::count_if(normal.begin(), normal.end(), [](double v)
+                                  { return std::abs(v + 1.0) < 0.5; });
+    EXPECT_NEAR(static_cast<double>(inside) / n, 0.6827, 0.005);
+  }
+
+  TEST_F(MathTest, RandomGeneratorIsReproducible)
+  {
+    auto &rng = RandomGenerator::instance();
+    std::vector<float> first(1000), second(1000);
+    std::vector<int> ints(1000);
+
+    rng.set_seed(7);
+    rng.fill_normal(first.data(), first.size());
+    const double a = rng.uniform<double>();
+
+    rng.set_seed(7);
+    rng.fill_normal(second.data(), second.size());
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(rng.uniform<double>(), a);
+
+    rng.fill_uniform(ints.data(), ints.size(), -3, 3);
+    EXPECT_TRUE(std::all_of(ints.begin(), ints.end(), [](int v)
+                            { return v >= -3 && v <= 3; }));
+    EXPECT_NE(std::count(ints.begin(), ints.end(), -3), 0);
+    EXPECT_NE(std::count(ints.begin(), ints.end(), 3), 0);
+  }
+
   TEST_F(MathTest, BasicMathOperations)
   {
     EXPECT_EQ(clamp(5.0f, 0.0f, 10.0f), 5.0f);
@@ -119,6 +248,230 @@ namespace test
     EXPECT_FLOAT_EQ(leaky_relu_derivative(1.0f), 1.0f);
   }
 
+  namespace
+  {
+    /**
+     * @brief Distance from a reference value in units in the last place
+     */
+    template <typename T>
+    double ulp_error(T value, long double reference)
+    {
+      const T rounded = static_cast<T>(reference);
+      const T next = std::nextafter(std::fabs(rounded), std::numeric_limits<T>::infinity());
+      const long double ulp = static_cast<long double>(next) - std::fabs(rounded);
+      return static_cast<double>(std::fabs(static_cast<long double>(value) - reference) / ulp);
+    }
+
+    template <typename T>
+    void check_activation_accuracy()
+    {
+      // Dense sweep plus a size that is not a multiple of any vector width
+      const size_t n = 200003;
+      std::vector<T> x(n), y(n), dy(n);
+      for (size_t i = 0; i < n; ++i)
+        x[i] = T(-60) + T(120) * static_cast<T>(i) / static_cast<T>(n);
+      x[0] = T(1e-20);
+      x[1] = T(-3e-5);
+
+      // Results within a few times the smallest normal number may be flushed
+      const long double floor = 8 * static_cast<long double>(std::numeric_limits<T>::min());
+
+      sigmoid_and_derivative(x.data(), y.data(), dy.data(), n);
+      double worst = 0, worst_derivative = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        const long double v = x[i];
+        const long double e = std::exp(-std::fabs(v));
+        const long double s = v < 0 ? e / (1 + e) : 1 / (1 + e);
+        if (s > floor)
+          worst = std::max(worst, ulp_error(y[i], s));
+        if (e / ((1 + e) * (1 + e)) > floor)
+          worst_derivative = std::max(worst_derivative, ulp_error(dy[i], e / ((1 + e) * (1 + e))));
+      }
+      EXPECT_LE(worst, 4.0);
+      EXPECT_LE(worst_derivative, 6.0);
+
+      tanh_and_derivative(x.data(), y.data(), dy.data(), n);
+      worst = worst_derivative = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        const long double v = x[i];
+        const long double e = std::exp(-2 * std::fabs(v));
+        worst = std::max(worst, ulp_error(y[i], std::tanh(v)));
+        if (4 * e / ((1 + e) * (1 + e)) > floor)
+          worst_derivative = std::max(worst_derivative, ulp_error(dy[i], 4 * e / ((1 + e) * (1 + e))));
+      }
+      EXPECT_LE(worst, 4.0);
+      EXPECT_LE(worst_derivative, 6.0);
+
+      // The forward-only versions give the same values
+      std::vector<T> forward(n);
+      tanh(x.data(), forward.data(), n);
+      EXPECT_EQ(forward, y);
+    }
+  } // namespace
+
+  TEST_F(MathTest, ActivationArraysAreAccurate)
+  {
+    check_activation_accuracy<float>();
+    check_activation_accuracy<double>();
+  }
+
+  TEST_F(MathTest, ActivationArraysMatchScalarFunctions)
+  {
+    std::vector<float> x = {-3.0f, -1.0f, -0.25f, 0.0f, 0.5f, 2.0f, 7.0f};
+    std::vector<float> y(x.size()), dy(x.size());
+
+    sigmoid(x.data(), y.data(), x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_NEAR(y[i], sigmoid(x[i]), 1e-6f);
+
+    relu_and_derivative(x.data(), y.data(), dy.data(), x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      EXPECT_EQ(y[i], relu(x[i]));
+      EXPECT_EQ(dy[i], relu_derivative(x[i]));
+    }
+
+    leaky_relu_and_derivative(x.data(), y.data(), dy.data(), x.size(), 0.1f);
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      EXPECT_EQ(y[i], leaky_relu(x[i], 0.1f));
+      EXPECT_EQ(dy[i], leaky_relu_derivative(x[i], 0.1f));
+    }
+
+    // In place
+    std::vector<double> z = {-2.0, -0.5, 0.0, 0.5, 2.0};
+    std::vector<double> expected(z.size());
+    for (size_t i = 0; i < z.size(); ++i)
+      expected[i] = std::tanh(z[i]);
+
+    tanh(z.data(), z.data(), z.size());
+    for (size_t i = 0; i < z.size(); ++i)
+      EXPECT_NEAR(z[i], expected[i], 1e-15);
+  }
+
+  TEST_F(MathTest, ActivationArraysHandleSpecialValues)
+  {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> x = {inf, -inf, std::nanf(""), -0.0f, 200.0f, -200.0f};
+    std::vector<float> y(x.size()), dy(x.size());
+
+    sigmoid_and_derivative(x.data(), y.data(), dy.data(), x.size());
+    EXPECT_EQ(y[0], 1.0f);
+    EXPECT_EQ(y[1], 0.0f);
+    EXPECT_TRUE(std::isnan(y[2]));
+    EXPECT_EQ(y[3], 0.5f);
+    EXPECT_EQ(y[4], 1.0f);
+    EXPECT_EQ(y[5], 0.0f);
+    EXPECT_EQ(dy[0], 0.0f);
+    EXPECT_EQ(dy[3], 0.25f);
+
+    tanh_and_derivative(x.data(), y.data(), dy.data(), x.size());
+    EXPECT_EQ(y[0], 1.0f);
+    EXPECT_EQ(y[1], -1.0f);
+    EXPECT_TRUE(std::isnan(y[2]));
+    EXPECT_EQ(y[3], 0.0f);
+    EXPECT_TRUE(std::signbit(y[3]));
+    EXPECT_EQ(y[5], -1.0f);
+    EXPECT_EQ(dy[1], 0.0f);
+    EXPECT_EQ(dy[3], 1.0f);
+
+    EXPECT_THROW(sigmoid(static_cast<const float *>(nullptr), y.data(), 4), tf::core::ValueError);
+    EXPECT_THROW(tanh_and_derivative(x.data(), y.data(), nullptr, 4), tf::core::ValueError);
+    EXPECT_NO_THROW(relu(static_cast<const float *>(nullptr), nullptr, 0));
+  }
+
+  TEST_F(MathTest, SoftmaxRowsMatchReference)
+  {
+    for (size_t cols : {1u, 7u, 64u, 1000u, 50001u})
+    {
+      const size_t rows = 5, ld = cols + 3;
+      std::vector<double> in(rows * ld, 123.0), out(rows * ld, -1.0), log_out(rows * ld, -1.0);
+      RandomGenerator::instance().fill_normal(in.data(), in.size(), 0.0, 10.0);
+
+      softmax(rows, cols, in.data(), ld, out.data(), ld);
+      log_softmax(rows, cols, in.data(), ld, log_out.data(), ld);
+
+      for (size_t r = 0; r < rows; ++r)
+      {
+        const double *x = in.data() + r * ld;
+        long double row_max = *std::max_element(x, x + cols);
+        long double sum = 0;
+        for (size_t c = 0; c < cols; ++c)
+          sum += std::exp(static_cast<long double>(x[c]) - row_max);
+
+        double total = 0;
+        for (size_t c = 0; c < cols; ++c)
+        {
+          const long double expected = std::exp(x[c] - row_max) / sum;
+          const double value = out[r * ld + c];
+          if (expected > 1e-300)
+            EXPECT_NEAR(value / static_cast<double>(expected), 1.0, 1e-13) << cols;
+          EXPECT_NEAR(log_out[r * ld + c],
+                      static_cast<double>(x[c] - row_max - std::log(sum)), 1e-12) << cols;
+          total += value;
+        }
+        EXPECT_NEAR(total, 1.0, 1e-12);
+
+        // Padding between rows is left alone
+        for (size_t c = cols; c < ld; ++c)
+          EXPECT_EQ(out[r * ld + c], -1.0);
+      }
+    }
+  }
+
+  TEST_F(MathTest, SoftmaxIsStableAndHandlesMasks)
+  {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> x(37);
+    for (size_t i = 0; i < x.size(); ++i)
+      x[i] = 1000.0f + static_cast<float>(i % 5);
+    for (size_t i = 0; i < 20; ++i)
+      x[i] = -inf;
+
+    std::vector<float> y(x.size());
+    softmax(1, x.size(), x.data(), x.size(), y.data(), y.size());
+
+    float total = 0.0f;
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      EXPECT_TRUE(std::isfinite(y[i]));
+      if (i < 20)
+        EXPECT_EQ(y[i], 0.0f);
+      total += y[i];
+    }
+    EXPECT_NEAR(total, 1.0f, 1e-5f);
+
+    // In place, and log-softmax stays finite where softmax would underflow
+    std::vector<float> z = {0.0f, -200.0f, 200.0f};
+    log_softmax(1, z.size(), z.data(), z.size(), z.data(), z.size());
+    EXPECT_NEAR(z[0], -200.0f, 1e-3f);
+    EXPECT_NEAR(z[1], -400.0f, 1e-3f);
+    EXPECT_NEAR(z[2], 0.0f, 1e-6f);
+
+    EXPECT_THROW(softmax(2, 4, x.data(), 3, y.data(), 4), tf::core::ShapeError);
+    EXPECT_THROW(softmax(2, 4, static_cast<const float *>(nullptr), 4, y.data(), 4),
+                 tf::core::ValueError);
+    EXPECT_NO_THROW(softmax(0, 4, static_cast<const float *>(nullptr), 4, nullptr, 4));
+  }
+
+  TEST_F(MathTest, SoftmaxRowsRunInParallel)
+  {
+    const int threads = tf::core::config().num_threads();
+    const size_t rows = 256, cols = 300;
+    std::vector<float> in(rows * cols), serial(rows * cols), parallel(rows * cols);
+    RandomGenerator::instance().fill_normal(in.data(), in.size(), 0.0f, 3.0f);
+
+    tf::core::config().set_num_threads(1);
+    softmax(rows, cols, in.data(), cols, serial.data(), cols);
+    tf::core::config().set_num_threads(4);
+    softmax(rows, cols, in.data(), cols, parallel.data(), cols);
+    tf::core::config().set_num_threads(threads);
+
+    EXPECT_EQ(serial, parallel);
+  }
+
   TEST_F(MathTest, MeanVarianceStddev)
   {
     std::vector<float> data(1000);
@@ -184,15 +537,164 @@ namespace test
     EXPECT_NEAR(corr2, 0.0f, 0.1f);
   }
 
+  TEST_F(MathTest, MomentsMatchTwoPassReference)
+  {
+    // A large offset ruins the naive sum-of-squares formula
+    std::vector<float> data(100003);
+    RandomGenerator::instance().fill_uniform(data.data(), data.size(), 1e4f, 1e4f + 1.0f);
+
+    double reference_mean = 0.0, reference_m2 = 0.0;
+    for (float x : data)
+      reference_mean += x;
+    reference_mean /= static_cast<double>(data.size());
+    for (float x : data)
+      reference_m2 += (x - reference_mean) * (x - reference_mean);
+
+    Moments<float> m = moments(data.data(), data.size());
+    EXPECT_EQ(m.count, data.size());
+    EXPECT_NEAR(m.mean, reference_mean, 1e-3);
+    EXPECT_NEAR(m.m2 / reference_m2, 1.0, 1e-3);
+
+    float v = variance(data.begin(), data.end());
+    EXPECT_NEAR(v * (data.size() - 1) / reference_m2, 1.0, 1e-3);
+
+    // Non-contiguous and integer ranges take the generic path
+    std::vector<int> counts = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    EXPECT_EQ(variance(counts.begin(), counts.end()), 9);
+
+    std::vector<double> values(data.begin(), data.end());
+    Moments<double> d = moments(values.data(), values.size());
+    EXPECT_NEAR(d.m2 / reference_m2, 1.0, 1e-9);
+
+    EXPECT_EQ(moments(static_cast<const float *>(nullptr), 0).count, 0u);
+    EXPECT_THROW(moments(static_cast<const float *>(nullptr), 1), tf::core::ValueError);
+  }
+
+  TEST_F(MathTest, MomentsMergeMatchesSinglePass)
+  {
+    std::vector<double> x(1000), y(1000);
+    RandomGenerator::instance().fill_normal(x.data(), x.size(), 3.0, 2.0);
+    RandomGenerator::instance().fill_normal(y.data(), y.size(), -1.0, 0.5);
+    for (size_t i = 0; i < y.size(); ++i)
+      y[i] += 0.5 * x[i];
+
+    Moments<double> all, left, right;
+    CoMoments<double> pairs, first, second;
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      all.push(x[i]);
+      pairs.push(x[i], y[i]);
+      (i < 317 ? left : right).push(x[i]);
+      (i < 317 ? first : second).push(x[i], y[i]);
+    }
+
+    left.merge(right);
+    first.merge(second);
+    EXPECT_EQ(left.count, all.count);
+    EXPECT_NEAR(left.mean, all.mean, 1e-12);
+    EXPECT_NEAR(left.variance(), all.variance(), 1e-10);
+    EXPECT_NEAR(first.covariance(), pairs.covariance(), 1e-10);
+    EXPECT_NEAR(first.correlation(), pairs.correlation(), 1e-12);
+
+    // Merging an empty sample either way is a no-op
+    Moments<double> empty;
+    empty.merge(all);
+    all.merge(Moments<double>{});
+    EXPECT_EQ(empty.count, all.count);
+    EXPECT_EQ(empty.m2, all.m2);
+
+    CoMoments<double> kernel = comoments(x.data(), y.data(), x.size());
+    EXPECT_NEAR(kernel.covariance(), pairs.covariance(), 1e-10);
+    EXPECT_NEAR(kernel.correlation(), pairs.correlation(), 1e-12);
+    EXPECT_NEAR(kernel.m2_y, pairs.m2_y, 1e-9);
+    EXPECT_NEAR(correlation(x.begin(), x.end(), y.begin(), y.end()), pairs.correlation(), 1e-12);
+  }
+
+  TEST_F(MathTest, AxisMomentsReduceStridedData)
+  {
+    // Row-major [A, B, C] tensor
+    const size_t A = 37, B = 11, C = 13;
+    std::vector<double> data(A * B * C);
+    RandomGenerator::instance().fill_uniform(data.data(), data.size(), -5.0, 5.0);
+
+    auto reference = [&](size_t count, size_t stride, size_t lane, size_t lane_stride)
+    {
+      double sum = 0.0, m2 = 0.0;
+      for (size_t i = 0; i < count; ++i)
+        sum += data[lane * lane_stride + i * stride];
+      const double mean = sum / static_cast<double>(count);
+      for (size_t i = 0; i < count; ++i)
+        m2 += (data[lane * lane_stride + i * stride] - mean) *
+              (data[lane * lane_stride + i * stride] - mean);
+      return std::make_pair(mean, m2);
+    };
+
+    auto check = [&](size_t count, size_t stride, size_t lanes, size_t lane_stride)
+    {
+      std::vector<Moments<double>> out(lanes);
+      axis_moments(count, stride, lanes, lane_stride, data.data(), out.data());
+      for (size_t l = 0; l < lanes; ++l)
+      {
+        auto [mean, m2] = reference(count, stride, l, lane_stride);
+        EXPECT_EQ(out[l].count, count);
+        EXPECT_NEAR(out[l].mean, mean, 1e-12) << count << " " << stride << " " << l;
+        EXPECT_NEAR(out[l].m2, m2, 1e-9) << count << " " << stride << " " << l;
+      }
+    };
+
+    check(A, B * C, B * C, 1); // axis 0: adjacent lanes
+    check(C, 1, A * B, C);     // axis 2: contiguous lanes
+    check(A / 2, 2 * B * C, B * C / 3, 3); // every other row, every third column
+    check(A * B * C, 1, 1, 0); // everything
+    check(A * B, C, 1, 0);     // one strided lane
+
+    std::vector<Moments<double>> out(4);
+    axis_moments(0, 1, 4, 1, data.data(), out.data());
+    EXPECT_EQ(out[3].count, 0u);
+    EXPECT_THROW(axis_moments(1, 1, 4, 1, data.data(), static_cast<Moments<double> *>(nullptr)),
+                 tf::core::ValueError);
+  }
+
+  TEST_F(MathTest, AxisMomentsIndependentOfThreadCount)
+  {
+    // Large enough to be tiled over row chunks and lane blocks
+    const size_t rows = 5000, cols = 601;
+    std::vector<float> data(rows * cols);
+    RandomGenerator::instance().fill_normal(data.data(), data.size(), 100.0f, 1.0f);
+
+    const int threads = tf::core::config().num_threads();
+    std::vector<Moments<float>> serial(cols), parallel(cols);
+
+    tf::core::config().set_num_threads(1);
+    axis_moments(rows, cols, cols, 1, data.data(), serial.data());
+    tf::core::config().set_num_threads(4);
+    axis_moments(rows, cols, cols, 1, data.data(), parallel.data());
+    tf::core::config().set_num_threads(threads);
+
+    for (size_t c = 0; c < cols; ++c)
+    {
+      EXPECT_EQ(serial[c].mean, parallel[c].mean);
+      EXPECT_EQ(serial[c].m2, parallel[c].m2);
+    }
+
+    // Spot-check a column against the one-lane path
+    std::vector<float> column(rows);
+    for (size_t r = 0; r < rows; ++r)
+      column[r] = data[r * cols + 7];
+    Moments<float> expected = moments(column.data(), column.size());
+    EXPECT_NEAR(serial[7].mean, expected.mean, 1e-3f);
+    EXPECT_NEAR(serial[7].variance() / expected.variance(), 1.0f, 1e-3f);
+  }
+
   TEST_F(MathTest, ThreadSafety)
   {
-    std::vector<float> data(1000);
+    std::vector<std::vector<float>> data(10, std::vector<float>(1000));
     std::vector<std::thread> threads;
 
     for (int i = 0; i < 10; ++i)
     {
-      threads.emplace_back([&data]()
-                           { RandomGenerator::instance().fill_uniform(data.data(), data.size(),
+      threads.emplace_back([&data, i]()
+                           { RandomGenerator::instance().fill_uniform(data[i].data(), data[i].size(),
                                                                       0.0f, 1.0f); });
     }
 
@@ -200,6 +702,10 @@ namespace test
     {
       thread.join();
     }
+
+    // Concurrent fills draw disjoint parts of the stream
+    for (int i = 1; i < 10; ++i)
+      EXPECT_NE(data[i], data[0]);
   }
 
 } // namespace test
\ No newline at end of file
@@ -2,6 +2,11 @@
 #include <tf/utils/memory.hpp>
 #include <thread>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 using namespace tf::utils;
 
@@ -100,6 +105,158 @@ namespace test
     EXPECT_EQ(tracker.active_allocations(), 0);
   }
 
+  TEST_F(MemoryTest, MemoryTrackerPeakAndHistogram)
+  {
+    auto &tracker = MemoryTracker::instance();
+    std::array<char, 3> storage{};
+
+    tracker.track_allocation(&storage[0], 100);
+    tracker.track_allocation(&storage[1], 1000);
+    tracker.track_allocation(&storage[2], 5000);
+    EXPECT_EQ(tracker.total_allocated(), 6100u);
+    EXPECT_EQ(tracker.peak_allocated(), 6100u);
+
+    tracker.track_deallocation(&storage[1]);
+    tracker.track_deallocation(&storage[2]);
+    EXPECT_EQ(tracker.total_allocated(), 100u);
+    EXPECT_EQ(tracker.peak_allocated(), 6100u);
+
+    // Untracked pointers are ignored
+    int other = 0;
+    tracker.track_deallocation(&other);
+    EXPECT_EQ(tracker.deallocation_count(), 2u);
+
+    tracker.track_deallocation(&storage[0]);
+    EXPECT_EQ(tracker.total_allocated(), 0u);
+    EXPECT_EQ(tracker.active_allocations(), 0u);
+
+    std::vector<size_t> histogram = tracker.size_histogram();
+    ASSERT_EQ(histogram.size(), tf::utils::detail::TRACKER_HISTOGRAM_BUCKETS);
+    EXPECT_EQ(MemoryTracker::histogram_bucket(0), 0u);
+    EXPECT_EQ(MemoryTracker::histogram_bucket(64), 7u);
+    EXPECT_EQ(histogram[MemoryTracker::histogram_bucket(100)], 1u);
+    EXPECT_EQ(histogram[MemoryTracker::histogram_bucket(1000)], 1u);
+    EXPECT_EQ(histogram[MemoryTracker::histogram_bucket(5000)], 1u);
+
+    tracker.reset_stats();
+    EXPECT_EQ(tracker.peak_allocated(), 0u);
+    EXPECT_EQ(tracker.allocation_count(), 0u);
+  }
+
+  TEST_F(MemoryTest, MemoryTrackerMergesThreadCounters)
+  {
+    auto &tracker = MemoryTracker::instance();
+    const size_t num_threads = 8;
+    const size_t ops_per_thread = 1000;
+    std::vector<char> storage(num_threads * ops_per_thread);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < num_threads; ++t)
+      threads.emplace_back([&, t]
+                           {
+                             char *base = storage.data() + t * ops_per_thread;
+                             for (size_t i = 0; i < ops_per_thread; ++i)
+                               tracker.track_allocation(base + i, 128); });
+
+    for (auto &thread : threads)
+      thread.join();
+    threads.clear();
+
+    // Release half of each block from a different thread than allocated it
+    for (size_t t = 0; t < num_threads; ++t)
+      threads.emplace_back([&, t]
+                           {
+                             char *base = storage.data() + ((t + 1) % num_threads) * ops_per_thread;
+                             for (size_t i = 0; i < ops_per_thread / 2; ++i)
+                               tracker.track_deallocation(base + 2 * i); });
+
+    for (auto &thread : threads)
+      thread.join();
+
+    // The threads have exited, so their counters were folded in
+    EXPECT_EQ(tracker.allocation_count(), num_threads * ops_per_thread);
+    EXPECT_EQ(tracker.deallocation_count(), num_threads * ops_per_thread / 2);
+    EXPECT_EQ(tracker.active_allocations(), num_threads * ops_per_thread / 2);
+    EXPECT_EQ(tracker.total_allocated(), num_threads * ops_per_thread / 2 * 128);
+    EXPECT_GE(tracker.peak_allocated(), tracker.total_allocated());
+    EXPECT_LE(tracker.peak_allocated(), num_threads * ops_per_thread * 128);
+    EXPECT_EQ(tracker.size_histogram()[MemoryTracker::histogram_bucket(128)],
+              num_threads * ops_per_thread);
+  }
+
+  TEST_F(MemoryTest, MemoryTrackerResetWhileAllocating)
+  {
+    auto &tracker = MemoryTracker::instance();
+    const size_t num_threads = 4;
+    const size_t ops_per_thread = 256;
+    std::vector<char> storage(num_threads * ops_per_thread);
+    std::atomic<size_t> completed{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < num_threads; ++t)
+      threads.emplace_back([&, t]
+                           {
+                             char *base = storage.data() + t * ops_per_thread;
+                             while (!stop.load())
+                               for (size_t i = 0; i < ops_per_thread; ++i)
+                               {
+                                 tracker.track_allocation(base + i, 512);
+                                 tracker.track_deallocation(base + i);
+                                 completed.fetch_add(1);
+                               } });
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(250);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      const size_t before = completed.load();
+      tracker.reset_stats();
+
+      // Counts from before the reset must not be written back after it;
+      // each thread may have one counted operation not yet completed
+      const size_t allocations = tracker.allocation_count();
+      const size_t deallocations = tracker.deallocation_count();
+      const size_t after = completed.load();
+      EXPECT_LE(allocations, after - before + num_threads);
+      EXPECT_LE(deallocations, after - before + num_threads);
+    }
+
+    stop.store(true);
+    for (auto &thread : threads)
+      thread.join();
+
+    tracker.reset_stats();
+    EXPECT_EQ(tracker.allocation_count(), 0u);
+    EXPECT_EQ(tracker.total_allocated(), 0u);
+  }
+
+  TEST_F(MemoryTest, MemoryTrackerSampling)
+  {
+    auto &tracker = MemoryTracker::instance();
+    EXPECT_THROW(tracker.set_sample_rate(0), tf::core::ValueError);
+    tracker.set_sample_rate(16);
+
+    const size_t count = 32000;
+    std::vector<char> storage(count);
+    for (size_t i = 0; i < count; ++i)
+      tracker.track_allocation(&storage[i], 64);
+
+    // Every allocation is counted; live data is estimated from samples
+    EXPECT_EQ(tracker.allocation_count(), count);
+    EXPECT_EQ(tracker.size_histogram()[MemoryTracker::histogram_bucket(64)], count);
+    EXPECT_EQ(tracker.active_allocations() % 16, 0u);
+    EXPECT_NEAR(static_cast<double>(tracker.active_allocations()), count, count * 0.2);
+    EXPECT_EQ(tracker.total_allocated(), tracker.active_allocations() * 64);
+
+    for (size_t i = 0; i < count; ++i)
+      tracker.track_deallocation(&storage[i]);
+
+    EXPECT_EQ(tracker.active_allocations(), 0u);
+    EXPECT_EQ(tracker.total_allocated(), 0u);
+
+    tracker.set_sample_rate(1);
+  }
+
   TEST_F(MemoryTest, TrackedPointerBasicOperations)
   {
     {
@@ -132,6 +289,151 @@ namespace test
     EXPECT_EQ(*ptr, 100);
   }
 
+  TEST_F(MemoryTest, MemoryPoolReusesFreedBlocks)
+  {
+    MemoryPool pool;
+
+    void *ptr = pool.allocate(1000);
+    pool.deallocate(ptr);
+
+    // Same size class, same thread: served from the thread cache
+    EXPECT_EQ(pool.allocate(1010), ptr);
+    pool.deallocate(ptr);
+  }
+
+  TEST_F(MemoryTest, MemoryPoolSmallRequestsDoNotConsumeRegions)
+  {
+    MemoryPool pool(1024 * 1024);
+    std::vector<void *> ptrs;
+
+    for (int i = 0; i < 200; ++i)
+      ptrs.push_back(pool.allocate(1024));
+
+    // 200 KB of 1 KB requests fit in the initial 1 MB region
+    EXPECT_EQ(pool.num_blocks(), 1u);
+
+    std::sort(ptrs.begin(), ptrs.end());
+    for (size_t i = 1; i < ptrs.size(); ++i)
+      EXPECT_GE(static_cast<char *>(ptrs[i]) - static_cast<char *>(ptrs[i - 1]), 1024);
+
+    for (void *ptr : ptrs)
+      pool.deallocate(ptr);
+  }
+
+  TEST_F(MemoryTest, MemoryPoolSplitsLargeBlocks)
+  {
+    MemoryPool pool(1024);
+
+    void *big = pool.allocate(4 * 1024 * 1024);
+    pool.deallocate(big);
+
+    // Both halves come out of the freed 4 MB block without growing
+    size_t blocks = pool.num_blocks();
+    void *a = pool.allocate(1024 * 1024);
+    void *b = pool.allocate(1024 * 1024);
+
+    EXPECT_EQ(a, big);
+    EXPECT_NE(b, a);
+    EXPECT_EQ(pool.num_blocks(), blocks);
+
+    pool.deallocate(a);
+    pool.deallocate(b);
+  }
+
+  TEST_F(MemoryTest, MemoryPoolRejectsInvalidRequests)
+  {
+    MemoryPool pool;
+
+    EXPECT_THROW(pool.allocate(64, 3), tf::core::ValueError);
+
+    void *ptr = pool.allocate(64);
+    pool.deallocate(ptr);
+    EXPECT_THROW(pool.deallocate(ptr), tf::core::MemoryError);
+
+    MemoryPool other;
+    void *foreign = other.allocate(64);
+    EXPECT_THROW(pool.deallocate(foreign), tf::core::MemoryError);
+    other.deallocate(foreign);
+
+    EXPECT_NO_THROW(pool.deallocate(nullptr));
+  }
+
+  TEST_F(MemoryTest, MemoryPoolOverAlignedAllocations)
+  {
+    MemoryPool pool;
+
+    for (size_t alignment : {CACHE_LINE_ALIGNMENT, size_t{256}, PAGE_ALIGNMENT, HUGE_PAGE_ALIGNMENT})
+    {
+      for (size_t size : {size_t{1}, size_t{3000}, size_t{300000}})
+      {
+        auto *ptr = static_cast<unsigned char *>(pool.allocate(size, alignment));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0u);
+
+        // The whole requested range is usable
+        std::memset(ptr, 0x5a, size);
+        EXPECT_EQ(ptr[size - 1], 0x5a);
+
+        pool.deallocate(ptr);
+
+        // Freed aligned blocks go back to the pool and are reused
+        void *again = pool.allocate(size, alignment);
+        EXPECT_EQ(again, ptr);
+        pool.deallocate(again);
+      }
+    }
+
+    EXPECT_THROW(pool.allocate(64, 2 * HUGE_PAGE_ALIGNMENT), tf::core::MemoryError);
+
+    void *ptr = pool.allocate(100, PAGE_ALIGNMENT);
+    pool.deallocate(ptr);
+    EXPECT_THROW(pool.deallocate(ptr), tf::core::MemoryError);
+  }
+
+  TEST_F(MemoryTest, MemoryPoolCrossThreadDeallocation)
+  {
+    MemoryPool pool;
+    std::vector<void *> ptrs;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+      void *ptr = pool.allocate(static_cast<size_t>(i % 8 + 1) * 100);
+      std::memset(ptr, 0xab, static_cast<size_t>(i % 8 + 1) * 100);
+      ptrs.push_back(ptr);
+    }
+
+    std::thread freer([&]()
+                      {
+                        for (void *ptr : ptrs)
+                          pool.deallocate(ptr);
+                      });
+    freer.join();
+
+    // Blocks returned by the exited thread are reused here
+    size_t size = pool.total_size();
+    for (int i = 0; i < 1000; ++i)
+      ptrs[i] = pool.allocate(static_cast<size_t>(i % 8 + 1) * 100);
+
+    EXPECT_EQ(pool.total_size(), size);
+
+    for (void *ptr : ptrs)
+      pool.deallocate(ptr);
+  }
+
+  TEST_F(MemoryTest, MemoryPoolOutlivedByThreadCache)
+  {
+    // The main thread caches blocks of the first pool; destroying it must
+    // not leave the cache pointing into freed memory for the next pool.
+    {
+      MemoryPool pool;
+      pool.deallocate(pool.allocate(128));
+    }
+
+    MemoryPool next;
+    void *ptr = next.allocate(128);
+    EXPECT_NE(ptr, nullptr);
+    next.deallocate(ptr);
+  }
+
   TEST_F(MemoryTest, ThreadSafetyMemoryPool)
   {
     MemoryPool pool;
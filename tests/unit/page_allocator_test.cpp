@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <tf/core/common.hpp>
+#include <tf/core/thread_pool.hpp>
+#include <tf/utils/memory.hpp>
+#include <tf/utils/page_allocator.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace tf::utils;
+
+namespace test
+{
+  TEST(PageAllocatorTest, MapsAlignedZeroedPages)
+  {
+    for (PageSize page_size : {PageSize::Default, PageSize::Transparent,
+                               PageSize::Huge2M, PageSize::Huge1G})
+    {
+      AllocationPolicy policy;
+      policy.page_size = page_size;
+
+      PageAllocation pages = allocate_pages(3 * 1024 * 1024 + 5, policy);
+      ASSERT_NE(pages.ptr, nullptr);
+      EXPECT_GE(pages.size, 3u * 1024 * 1024 + 5);
+
+      // Whatever was obtained, the mapping is aligned to its page size
+      size_t page = pages.page_size == PageSize::Default       ? 4096
+                    : pages.page_size == PageSize::Huge1G      ? 1024 * 1024 * 1024
+                                                               : 2 * 1024 * 1024;
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(pages.ptr) % page, 0u);
+      EXPECT_EQ(pages.size % page, 0u);
+
+      auto *bytes = static_cast<unsigned char *>(pages.ptr);
+      EXPECT_EQ(bytes[0], 0);
+      EXPECT_EQ(bytes[pages.size - 1], 0);
+      std::memset(bytes, 0x11, pages.size);
+
+      free_pages(pages);
+    }
+  }
+
+  TEST(PageAllocatorTest, NumaPoliciesDegradeGracefully)
+  {
+    for (NumaPolicy numa : {NumaPolicy::Bind, NumaPolicy::Preferred, NumaPolicy::Interleave})
+    {
+      AllocationPolicy policy;
+      policy.numa = numa;
+      policy.nodes = {0};
+
+      PageAllocation pages = allocate_pages(1 << 20, policy);
+      ASSERT_NE(pages.ptr, nullptr);
+      std::memset(pages.ptr, 1, pages.size);
+      free_pages(pages);
+    }
+  }
+
+  TEST(PageAllocatorTest, NumaTopology)
+  {
+    EXPECT_GE(numa_node_count(), 1);
+    EXPECT_FALSE(numa_node_cpus(0).empty());
+    EXPECT_TRUE(numa_node_cpus(-1).empty());
+  }
+
+  TEST(PageAllocatorTest, PoolAndMemoryUsePolicy)
+  {
+    AllocationPolicy policy;
+    policy.page_size = PageSize::Transparent;
+
+    MemoryPool pool(1024, policy);
+    EXPECT_EQ(pool.total_size() % (2 * 1024 * 1024), 0u);
+
+    void *ptr = pool.allocate(100000);
+    std::memset(ptr, 7, 100000);
+    pool.deallocate(ptr);
+
+    auto data = tf::core::Memory<float>::allocate(1 << 20, policy);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(data.get()) % (2 * 1024 * 1024), 0u);
+    EXPECT_EQ(data[0], 0.0f);
+    EXPECT_EQ(data[(1 << 20) - 1], 0.0f);
+
+    auto strings = tf::core::Memory<std::string>::allocate(3, policy);
+    EXPECT_TRUE(strings[2].empty());
+    strings[2] = "value";
+  }
+
+  TEST(PageAllocatorTest, ThreadPoolAffinity)
+  {
+    auto &pool = tf::core::thread_pool();
+    std::vector<int> cpus = numa_node_cpus(0);
+
+    pool.set_affinity(cpus);
+    EXPECT_EQ(pool.affinity(), cpus);
+
+    std::atomic<size_t> total{0};
+    tf::core::parallel_for(0, 10000, 10, [&](size_t begin, size_t end)
+                           { total.fetch_add(end - begin); });
+    EXPECT_EQ(total.load(), 10000u);
+
+    pool.set_affinity({});
+    EXPECT_TRUE(pool.affinity().empty());
+  }
+} // namespace test
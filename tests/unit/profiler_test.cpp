@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <tf/core/macros.hpp>
+#include <tf/core/profiler.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/blas.hpp>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tf::core;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for the hot-path profiler
+   *
+   * The Profiler and ProfileScope are exercised directly, so the tests run
+   * whether or not the library was built with TF_ENABLE_PROFILING.
+   */
+  class ProfilerTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      Profiler::instance().clear();
+      Profiler::instance().enable();
+    }
+
+    void TearDown() override
+    {
+      Profiler::instance().disable();
+      Profiler::instance().clear();
+    }
+
+    static std::vector<ProfileEvent> named(const char *name)
+    {
+      std::vector<ProfileEvent> found;
+      for (const ProfileEvent &event : Profiler::instance().events())
+        if (std::string(event.name) == name)
+          found.push_back(event);
+      return found;
+    }
+  };
+
+  TEST_F(ProfilerTest, RecordsNestedScopes)
+  {
+    {
+      ProfileScope outer("outer", "op");
+      {
+        ProfileScope inner("inner", "kernel", 1000, 64);
+        inner.add(24, 16);
+        Profiler::record_allocation(256);
+      }
+      Profiler::record_allocation(32);
+    }
+
+    const auto outer = named("outer");
+    const auto inner = named("inner");
+    ASSERT_EQ(outer.size(), 1u);
+    ASSERT_EQ(inner.size(), 1u);
+
+    EXPECT_STREQ(inner[0].category, "kernel");
+    EXPECT_EQ(inner[0].flops, 1024u);
+    EXPECT_EQ(inner[0].bytes, 80u);
+    EXPECT_EQ(inner[0].depth, 1u);
+    EXPECT_EQ(inner[0].allocations, 1u);
+    EXPECT_EQ(inner[0].allocated_bytes, 256u);
+
+    // Allocations of nested scopes count towards the enclosing one
+    EXPECT_EQ(outer[0].depth, 0u);
+    EXPECT_EQ(outer[0].allocations, 2u);
+    EXPECT_EQ(outer[0].allocated_bytes, 288u);
+    EXPECT_LE(outer[0].start_ns, inner[0].start_ns);
+    EXPECT_GE(outer[0].start_ns + outer[0].duration_ns, inner[0].start_ns + inner[0].duration_ns);
+  }
+
+  TEST_F(ProfilerTest, DisabledScopesRecordNothing)
+  {
+    Profiler::instance().disable();
+    {
+      ProfileScope scope("disabled", "op");
+      Profiler::record_allocation(128);
+      // Enabling mid-scope does not record the scope it missed
+      Profiler::instance().enable();
+    }
+    EXPECT_TRUE(named("disabled").empty());
+
+#if !defined(TF_PROFILING)
+    // The macros compile to nothing without TF_PROFILING
+    {
+      TF_PROFILE_SCOPE("macro");
+      TF_PROFILE_KERNEL("macro", 1, 1);
+      TF_PROFILE_ALLOCATION(1);
+    }
+    EXPECT_TRUE(named("macro").empty());
+#else
+    {
+      TF_PROFILE_SCOPE("macro");
+      TF_PROFILE_KERNEL("macro", 1, 1);
+    }
+    EXPECT_EQ(named("macro").size(), 2u);
+#endif
+  }
+
+  TEST_F(ProfilerTest, KeepsTheLatestEventsPerThread)
+  {
+    const size_t saved = Profiler::instance().capacity();
+    Profiler::instance().set_capacity(8);
+
+    // A new thread gets a ring of the new capacity
+    std::thread worker([]
+                       {
+                         for (uint64_t i = 0; i < 20; ++i)
+                           ProfileScope scope("wrapped", "kernel", i); });
+    worker.join();
+    Profiler::instance().set_capacity(saved);
+
+    const auto events = named("wrapped");
+    ASSERT_EQ(events.size(), 8u);
+    for (size_t i = 0; i < events.size(); ++i)
+      EXPECT_EQ(events[i].flops, 12 + i);
+
+    // Rings outlive their threads, and clear() hides what they recorded
+    Profiler::instance().clear();
+    EXPECT_TRUE(named("wrapped").empty());
+    EXPECT_THROW(Profiler::instance().set_capacity(0), ValueError);
+  }
+
+  TEST_F(ProfilerTest, ReclaimsRingsOfExitedThreads)
+  {
+    Profiler &profiler = Profiler::instance();
+    auto record = []
+    { ProfileScope scope("short_lived", "kernel"); };
+
+    // Events of exited threads stay readable until cleared
+    for (int i = 0; i < 4; ++i)
+      std::thread(record).join();
+    EXPECT_EQ(named("short_lived").size(), 4u);
+
+    // clear() then frees their rings, so repeated short-lived threads
+    // never hold more than one at a time
+    profiler.clear();
+    const size_t live = profiler.ring_count();
+    for (int i = 0; i < 32; ++i)
+    {
+      std::thread(record).join();
+      EXPECT_LE(profiler.ring_count(), live + 1);
+      profiler.clear();
+    }
+    EXPECT_EQ(profiler.ring_count(), live);
+
+    // A ring cleared while its thread ran is handed to the next thread
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool cleared = false;
+    std::thread first([&]
+                      {
+                        {
+                          ProfileScope scope("short_lived", "kernel");
+                        }
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&] { return cleared; }); });
+    while (named("short_lived").empty())
+      std::this_thread::yield();
+    const uint32_t first_thread = named("short_lived").front().thread;
+    profiler.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      cleared = true;
+    }
+    cv.notify_one();
+    first.join();
+
+    const size_t before = profiler.ring_count();
+    std::thread(record).join();
+    EXPECT_EQ(profiler.ring_count(), before);
+    const auto events = named("short_lived");
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events.front().thread, first_thread);
+  }
+
+  TEST_F(ProfilerTest, CollectsWhileThreadsRecord)
+  {
+    constexpr int THREADS = 4;
+    constexpr int EVENTS = 2000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; ++t)
+      workers.emplace_back([]
+                           {
+                             for (int i = 0; i < EVENTS; ++i)
+                               ProfileScope scope("concurrent", "kernel", 2, 8); });
+
+    // Snapshots taken concurrently only ever contain complete events
+    for (int i = 0; i < 20; ++i)
+      for (const ProfileEvent &event : named("concurrent"))
+        ASSERT_EQ(event.bytes, 8u);
+
+    for (std::thread &worker : workers)
+      worker.join();
+
+    const auto events = named("concurrent");
+    EXPECT_EQ(events.size(), static_cast<size_t>(THREADS * EVENTS));
+    for (size_t i = 1; i < events.size(); ++i)
+      ASSERT_LE(events[i - 1].start_ns, events[i].start_ns);
+
+    const auto summary = Profiler::instance().summary();
+    ASSERT_FALSE(summary.empty());
+    bool found = false;
+    for (const ProfileSummary &entry : summary)
+      if (std::string(entry.name) == "concurrent")
+      {
+        found = true;
+        EXPECT_EQ(entry.count, static_cast<uint64_t>(THREADS * EVENTS));
+        EXPECT_EQ(entry.flops, static_cast<uint64_t>(2 * THREADS * EVENTS));
+      }
+    EXPECT_TRUE(found);
+  }
+
+  TEST_F(ProfilerTest, WritesChromeTrace)
+  {
+    {
+      ProfileScope scope("quoted \"name\"", "op", 2000000, 4096);
+    }
+
+    std::ostringstream out;
+    Profiler::instance().write_chrome_trace(out);
+    const std::string trace = out.str();
+
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(trace.find("\"name\":\"quoted \\\"name\\\"\",\"cat\":\"op\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"args\":{\"flops\":2000000,\"bytes\":4096"), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"M\""), std::string::npos);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+
+    const std::string path = ::testing::TempDir() + "profiler_test_trace.json";
+    Profiler::instance().write_chrome_trace(path);
+    std::ifstream file(path);
+    const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(written.find("quoted"), trace.find("quoted"));
+    std::remove(path.c_str());
+
+    EXPECT_THROW(Profiler::instance().write_chrome_trace("/nonexistent/dir/trace.json"), IOError);
+  }
+
+#if defined(TF_PROFILING)
+  TEST_F(ProfilerTest, InstrumentsLibraryKernels)
+  {
+    auto A = TensorView<float>::allocate({16, 8});
+    auto B = TensorView<float>::allocate({8, 4});
+    auto C = TensorView<float>::allocate({16, 4});
+    std::fill_n(A.data(), A.num_elements(), 1.0f);
+    std::fill_n(B.data(), B.num_elements(), 1.0f);
+    tf::math::Blas::gemm(1.0f, A, B, 0.0f, C);
+
+    const auto gemm = named("gemm");
+    ASSERT_EQ(gemm.size(), 1u);
+    EXPECT_EQ(gemm[0].flops, 2u * 16 * 8 * 4);
+    EXPECT_EQ(gemm[0].bytes, (16u * 8 + 8 * 4 + 16 * 4) * sizeof(float));
+  }
+#endif
+} // namespace test
@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+#include <tf/math/blas.hpp>
+#include <tf/math/quantize.hpp>
+#include <tf/math/random.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace tf::math;
+using tf::core::Shape;
+using tf::core::TensorView;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for int8 quantization and calibration.
+   */
+  class QuantizeTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      RandomGenerator::instance().set_seed(23);
+    }
+
+    static TensorView<float> random(const Shape &shape, float low, float high)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                               low, high);
+      return view;
+    }
+
+    /**
+     * @brief The documented mapping, one value at a time
+     */
+    static std::int8_t reference(float x, float scale, std::int32_t zero_point)
+    {
+      if (std::isnan(x))
+        return -128;
+      const float level = std::nearbyint(x / scale) + static_cast<float>(zero_point);
+      return static_cast<std::int8_t>(std::clamp(level, -128.0f, 127.0f));
+    }
+
+    /**
+     * @brief Channel of element i of a dense tensor of the given shape
+     */
+    static size_t channel_of(const Shape &shape, size_t axis, size_t i)
+    {
+      size_t inner = 1;
+      for (size_t d = axis + 1; d < shape.rank(); ++d)
+        inner *= static_cast<size_t>(shape[d]);
+      return i / inner % static_cast<size_t>(shape[axis]);
+    }
+  };
+
+  TEST_F(QuantizeTest, PerTensorRoundsToNearestEvenAndSaturates)
+  {
+    // Long enough for every vector width plus a tail
+    const size_t n = 103;
+    auto x = random(Shape({static_cast<tf::core::index_t>(n)}), -80.0f, 80.0f);
+    float *data = x.data();
+    data[0] = 0.25f;  // 0.5 steps: ties to even
+    data[1] = 0.75f;
+    data[2] = -1e30f;
+    data[3] = 1e30f;
+    data[4] = std::numeric_limits<float>::quiet_NaN();
+    data[5] = -0.0f;
+
+    const QuantParams params = QuantParams::per_tensor(0.5f, 3);
+    const TensorView<std::int8_t> q = quantize(x, params);
+    for (size_t i = 0; i < n; ++i)
+      ASSERT_EQ(q.data()[i], reference(data[i], 0.5f, 3)) << "at " << i << ": " << data[i];
+
+    EXPECT_EQ(q.data()[0], 3);
+    EXPECT_EQ(q.data()[1], 5);
+    EXPECT_EQ(q.data()[2], -128);
+    EXPECT_EQ(q.data()[3], 127);
+
+    const TensorView<float> back = dequantize(q, params);
+    for (size_t i = 0; i < n; ++i)
+      ASSERT_EQ(back.data()[i], static_cast<float>(q.data()[i] - 3) * 0.5f);
+  }
+
+  TEST_F(QuantizeTest, PerChannelAlongEveryAxis)
+  {
+    const Shape shape({3, 4, 37});
+    const auto x = random(shape, -4.0f, 4.0f);
+    const size_t count = static_cast<size_t>(x.num_elements());
+
+    for (size_t axis = 0; axis < shape.rank(); ++axis)
+    {
+      const size_t channels = static_cast<size_t>(shape[axis]);
+      QuantParams params;
+      params.axis = axis;
+      params.scale.clear();
+      params.zero_point.clear();
+      for (size_t c = 0; c < channels; ++c)
+      {
+        params.scale.push_back(0.01f + 0.005f * static_cast<float>(c));
+        params.zero_point.push_back(static_cast<std::int32_t>(c % 5) - 2);
+      }
+
+      const TensorView<std::int8_t> q = quantize(x, params);
+      const TensorView<float> back = dequantize(q, params);
+      for (size_t i = 0; i < count; ++i)
+      {
+        const size_t c = channel_of(shape, axis, i);
+        ASSERT_EQ(q.data()[i], reference(x.data()[i], params.scale[c], params.zero_point[c]))
+            << "axis " << axis << " at " << i;
+        ASSERT_EQ(back.data()[i],
+                  static_cast<float>(q.data()[i] - params.zero_point[c]) * params.scale[c]);
+      }
+    }
+
+    // A strided input is read through its strides
+    const TensorView<float> transposed = x.transpose();
+    const TensorView<std::int8_t> q = quantize(transposed, QuantParams::per_tensor(0.1f));
+    const TensorView<float> dense = transposed.contiguous();
+    for (size_t i = 0; i < count; ++i)
+      ASSERT_EQ(q.data()[i], reference(dense.data()[i], 0.1f, 0));
+  }
+
+  TEST_F(QuantizeTest, RejectsInvalidParameters)
+  {
+    const auto x = random(Shape({2, 3}), -1.0f, 1.0f);
+    auto out = TensorView<std::int8_t>::allocate(Shape({2, 3}));
+
+    EXPECT_THROW(quantize(x, QuantParams::per_tensor(0.0f), out), tf::core::ValueError);
+    EXPECT_THROW(quantize(x, QuantParams::per_tensor(std::numeric_limits<float>::infinity()), out),
+                 tf::core::ValueError);
+    EXPECT_THROW(quantize(x, QuantParams::per_tensor(1.0f, 128), out), tf::core::ValueError);
+    EXPECT_THROW(quantize(x, QuantParams{{1.0f, 1.0f}, {0}, 1}, out), tf::core::ValueError);
+
+    // Channels must match the axis, which must exist
+    EXPECT_THROW(quantize(x, QuantParams{{1.0f, 1.0f}, {0, 0}, 1}, out), tf::core::ShapeError);
+    EXPECT_THROW(quantize(x, QuantParams{{1.0f, 1.0f}, {0, 0}, 2}, out), tf::core::ShapeError);
+    EXPECT_NO_THROW(quantize(x, QuantParams{{1.0f, 1.0f}, {0, 0}, 0}, out));
+
+    auto wrong = TensorView<std::int8_t>::allocate(Shape({3, 2}));
+    EXPECT_THROW(quantize(x, QuantParams::per_tensor(1.0f), wrong), tf::core::ShapeError);
+    EXPECT_THROW(quantize(x, QuantParams::per_tensor(1.0f), wrong.transpose()), tf::core::ShapeError);
+  }
+
+  TEST_F(QuantizeTest, CalibratesMinMaxRanges)
+  {
+    // Asymmetric: [-1, 3] spans the 256 levels and 0 is a level
+    auto x = random(Shape({1000}), -1.0f, 3.0f);
+    x.data()[0] = -1.0f;
+    x.data()[1] = 3.0f;
+
+    const QuantParams params = calibrate(x);
+    ASSERT_EQ(params.channels(), 1u);
+    EXPECT_FLOAT_EQ(params.scale[0], 4.0f / 255.0f);
+    EXPECT_EQ(params.zero_point[0], -64);
+
+    const TensorView<float> back = dequantize(quantize(x, params), params);
+    for (size_t i = 0; i < 1000; ++i)
+      ASSERT_NEAR(back.data()[i], x.data()[i], params.scale[0] * 0.5f + 1e-6f);
+
+    // Symmetric, per output channel of a (4, 16) weight matrix
+    auto w = random(Shape({4, 16}), -1.0f, 1.0f);
+    for (size_t c = 0; c < 4; ++c)
+      w.data()[c * 16 + c] = 0.5f * static_cast<float>(c + 1) + 1.0f;
+
+    CalibrationOptions options;
+    options.symmetric = true;
+    options.per_channel = true;
+    options.axis = 0;
+    const QuantParams weights = calibrate(w, options);
+    ASSERT_EQ(weights.channels(), 4u);
+    for (size_t c = 0; c < 4; ++c)
+    {
+      EXPECT_FLOAT_EQ(weights.scale[c], (0.5f * static_cast<float>(c + 1) + 1.0f) / 127.0f);
+      EXPECT_EQ(weights.zero_point[c], 0);
+    }
+
+    // All zeros, or nothing observed, still gives usable parameters
+    auto zeros = TensorView<float>::allocate(Shape({8}));
+    std::fill_n(zeros.data(), 8, 0.0f);
+    EXPECT_EQ(calibrate(zeros).scale[0], 1.0f);
+    EXPECT_EQ(Calibrator().params().scale[0], 1.0f);
+    options.axis = 1;
+    EXPECT_THROW(calibrate(zeros, options), tf::core::ShapeError);
+  }
+
+  TEST_F(QuantizeTest, CalibratorMergesBatchesAndClipsOutliers)
+  {
+    auto a = random(Shape({64, 3}), -1.0f, 1.0f);
+    auto b = random(Shape({80, 3}), -2.0f, 0.5f);
+
+    CalibrationOptions options;
+    options.per_channel = true;
+    options.axis = 1;
+
+    Calibrator calibrator(options);
+    calibrator.observe(a);
+    calibrator.observe(b);
+
+    auto both = TensorView<float>::allocate(Shape({144, 3}));
+    std::copy_n(a.data(), 192, both.data());
+    std::copy_n(b.data(), 240, both.data() + 192);
+    const QuantParams merged = calibrator.params();
+    const QuantParams direct = calibrate(both, options);
+    EXPECT_EQ(merged.axis, 1u);
+    EXPECT_EQ(merged.scale, direct.scale);
+    EXPECT_EQ(merged.zero_point, direct.zero_point);
+
+    EXPECT_THROW(calibrator.observe(random(Shape({4, 2}), 0.0f, 1.0f)), tf::core::ShapeError);
+    calibrator.reset();
+    EXPECT_NO_THROW(calibrator.observe(random(Shape({4, 2}), 0.0f, 1.0f)));
+
+    // One outlier stretches MinMax but not MeanStddev
+    auto x = random(Shape({4096}), -1.0f, 1.0f);
+    x.data()[17] = 1000.0f;
+
+    CalibrationOptions clipped;
+    clipped.method = CalibrationMethod::MeanStddev;
+    clipped.num_stddev = 3.0f;
+    const float wide = calibrate(x).scale[0];
+    const float narrow = calibrate(x, clipped).scale[0];
+    EXPECT_GT(wide, 1000.0f / 255.0f * 0.99f);
+    EXPECT_LT(narrow, wide / 4.0f);
+  }
+
+  /**
+   * @brief Level of one element of a quantized GEMM with a column bias and
+   * ReLU, computed from the definition
+   */
+  std::int8_t reference_requantized(const std::vector<std::int8_t> &A, size_t a_row, size_t a_col,
+                                    const QuantParams &qa, size_t i,
+                                    const std::vector<std::int8_t> &B, size_t b_row, size_t b_col,
+                                    const QuantParams &qb, size_t j, size_t k,
+                                    const QuantParams &qc, const float *bias)
+  {
+    const size_t ca = qa.channels() > 1 ? i : 0;
+    const size_t cb = qb.channels() > 1 ? j : 0;
+    const size_t cc = qc.channels() > 1 ? j : 0;
+
+    std::int64_t sum = 0;
+    for (size_t p = 0; p < k; ++p)
+      sum += static_cast<std::int64_t>(A[i * a_row + p * a_col] - qa.zero_point[ca]) *
+             (B[p * b_row + j * b_col] - qb.zero_point[cb]);
+
+    float value = qa.scale[ca] * qb.scale[cb] * static_cast<float>(sum);
+    if (bias)
+      value = std::max(value + bias[j], 0.0f);
+
+    const float level = std::nearbyint(value / qc.scale[cc]) + static_cast<float>(qc.zero_point[cc]);
+    return static_cast<std::int8_t>(std::clamp(level, -128.0f, 127.0f));
+  }
+
+  TEST_F(QuantizeTest, RequantizingGemmMatchesDefinition)
+  {
+    const BlasOperation ops[] = {BlasOperation::NoTrans, BlasOperation::Trans};
+    struct Size
+    {
+      size_t m, n, k;
+    };
+
+    for (const Size size : {Size{37, 45, 67}, Size{5, 70, 1100}, Size{3, 4, 0}})
+      for (BlasOperation transa : ops)
+        for (BlasOperation transb : ops)
+          for (bool per_channel : {false, true})
+          {
+            const auto [m, n, k] = size;
+            const bool ta = transa != BlasOperation::NoTrans;
+            const bool tb = transb != BlasOperation::NoTrans;
+            const size_t lda = (ta ? m : k) + 1;
+            const size_t ldb = (tb ? k : n) + 2;
+            const size_t ldc = n + 3;
+
+            std::vector<float> values((ta ? k : m) * lda + (tb ? n : k) * ldb + n);
+            RandomGenerator::instance().fill_uniform(values.data(), values.size(), -128.4f, 127.4f);
+            std::vector<std::int8_t> A((ta ? k : m) * lda), B((tb ? n : k) * ldb);
+            for (size_t i = 0; i < A.size(); ++i)
+              A[i] = static_cast<std::int8_t>(std::lround(values[i]));
+            for (size_t i = 0; i < B.size(); ++i)
+              B[i] = static_cast<std::int8_t>(std::lround(values[A.size() + i]));
+
+            // Asymmetric activations; weights and outputs per channel or not,
+            // with zero points so that every correction term is exercised
+            const QuantParams qa = QuantParams::per_tensor(0.02f, 5);
+            QuantParams qb = QuantParams::per_tensor(0.01f, -3);
+            QuantParams qc = QuantParams::per_tensor(0.05f * static_cast<float>(k + 1), -20);
+            if (per_channel)
+            {
+              qb.scale.assign(n, 0.0f);
+              qb.zero_point.assign(n, 0);
+              qc.scale.assign(n, 0.0f);
+              qc.zero_point.assign(n, 0);
+              for (size_t j = 0; j < n; ++j)
+              {
+                qb.scale[j] = 0.005f + 0.0002f * static_cast<float>(j);
+                qb.zero_point[j] = static_cast<std::int32_t>(j % 7) - 3;
+                qc.scale[j] = 0.03f * static_cast<float>(k + 1) * (1.0f + 0.01f * static_cast<float>(j));
+                qc.zero_point[j] = static_cast<std::int32_t>(j % 11) - 5;
+              }
+            }
+
+            std::vector<float> bias(values.end() - static_cast<std::ptrdiff_t>(n), values.end());
+            for (float &b : bias)
+              b *= 0.1f;
+            GemmEpilogue<float> epilogue;
+            epilogue.column_bias = bias.data();
+            epilogue.activation = Activation::Relu;
+
+            std::vector<std::int8_t> C(m * ldc, 99);
+            Blas::gemm(transa, transb, m, n, k, A.data(), lda, qa, B.data(), ldb, qb,
+                       C.data(), ldc, qc, epilogue);
+
+            const size_t a_row = ta ? 1 : lda, a_col = ta ? lda : 1;
+            const size_t b_row = tb ? 1 : ldb, b_col = tb ? ldb : 1;
+            for (size_t i = 0; i < m; ++i)
+            {
+              for (size_t j = 0; j < n; ++j)
+              {
+                // The scales are applied in float, so a value on a rounding
+                // boundary may land one level off
+                const int expected = reference_requantized(A, a_row, a_col, qa, i, B, b_row, b_col,
+                                                           qb, j, k, qc, bias.data());
+                ASSERT_LE(std::abs(C[i * ldc + j] - expected), 1)
+                    << "at (" << i << ", " << j << ") of " << m << " x " << n << " x " << k;
+              }
+              for (size_t j = n; j < ldc; ++j)
+                ASSERT_EQ(C[i * ldc + j], 99);
+            }
+          }
+  }
+
+  TEST_F(QuantizeTest, RequantizingGemmWithoutEpilogueAndChecks)
+  {
+    // Symmetric per-tensor quantization of a small exact product
+    const std::vector<std::int8_t> A{1, 2, 3, 4, 5, 6};    // 2 x 3
+    const std::vector<std::int8_t> B{1, 0, -1, 2, 3, -4};  // 3 x 2
+    std::vector<std::int8_t> C(4, 0);
+    const QuantParams unit = QuantParams::per_tensor(1.0f);
+
+    Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 3, A.data(), 3, unit,
+               B.data(), 2, unit, C.data(), 2, QuantParams::per_tensor(0.5f));
+    EXPECT_EQ(C, (std::vector<std::int8_t>{16, -16, 34, -28}));
+
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 3, A.data(), 3,
+                            QuantParams{{1.0f, 1.0f, 1.0f}, {0, 0, 0}, 0}, B.data(), 2, unit,
+                            C.data(), 2, unit),
+                 tf::core::ShapeError);
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 3, A.data(), 3,
+                            unit, B.data(), 2, QuantParams::per_tensor(-1.0f), C.data(), 2, unit),
+                 tf::core::ValueError);
+    EXPECT_THROW(Blas::gemm(BlasOperation::NoTrans, BlasOperation::NoTrans, 2, 2, 3, A.data(), 2,
+                            unit, B.data(), 2, unit, C.data(), 2, unit),
+                 tf::core::ShapeError);
+  }
+} // namespace test
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+#include <tf/core/tensor_view.hpp>
+#include <tf/math/random.hpp>
+#include <tf/math/utils.hpp>
+#include <tf/ops/tape.hpp>
+#include <tf/utils/arena.hpp>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace tf::ops;
+using tf::core::Shape;
+using tf::core::TensorView;
+using tf::math::Activation;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for reverse-mode differentiation.
+   */
+  class TapeTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      tf::math::RandomGenerator::instance().set_seed(17);
+    }
+
+    static TensorView<float> random(const Shape &shape, float low = -1.0f, float high = 1.0f)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      tf::math::RandomGenerator::instance().fill_uniform(view.data(), static_cast<size_t>(view.num_elements()),
+                                                         low, high);
+      return view;
+    }
+
+    static TensorView<float> zeros(const Shape &shape)
+    {
+      auto view = TensorView<float>::allocate(shape);
+      std::fill_n(view.data(), view.num_elements(), 0.0f);
+      return view;
+    }
+
+    /**
+     * @brief Records a stack of tanh layers, each optionally its own
+     * checkpointed segment, and returns the mean output
+     */
+    static VarId deep(Tape &tape, VarId x, const std::vector<VarId> &weights, bool checkpoint)
+    {
+      VarId h = x;
+      for (VarId w : weights)
+      {
+        if (checkpoint)
+        {
+          CheckpointScope scope(tape);
+          h = tape.activation(Activation::Tanh, tape.matmul(h, w));
+        }
+        else
+        {
+          h = tape.activation(Activation::Tanh, tape.matmul(h, w));
+        }
+      }
+      return tape.mean(h);
+    }
+  };
+
+  TEST_F(TapeTest, GradientsMatchFiniteDifferences)
+  {
+    std::vector<TensorView<float>> params = {
+        random({5, 4}), random({4, 6}), random({6}), random({3, 6}),
+        random({5, 1}), random({5, 2}), random({2, 5}), random({2})};
+
+    // Every operation and transpose combination in one scalar
+    auto build = [&](Tape &tape)
+    {
+      std::vector<VarId> v;
+      for (const auto &p : params)
+        v.push_back(tape.variable(p));
+
+      const VarId h = tape.activation(Activation::Tanh, tape.add(tape.matmul(v[0], v[1]), v[2]));
+      const VarId o = tape.activation(Activation::Sigmoid, tape.add(tape.matmul(h, v[3], false, true), v[4]));
+      const VarId q = tape.multiply(tape.matmul(o, v[5], true, false), v[7]);
+      const VarId r = tape.matmul(o, v[6], true, true);
+      const VarId d = tape.subtract(q, r);
+      const VarId loss = tape.add(tape.mean(tape.multiply(d, d)), tape.sum(tape.multiply(v[2], v[2])));
+      return std::make_pair(v, loss);
+    };
+
+    Tape tape;
+    const auto [vars, loss] = build(tape);
+    tape.backward(loss);
+
+    const float eps = 1e-2f;
+    for (size_t p = 0; p < params.size(); ++p)
+    {
+      const TensorView<float> &gradient = tape.gradient(vars[p]);
+      ASSERT_EQ(gradient.shape(), params[p].shape());
+
+      for (int64_t i = 0; i < params[p].num_elements(); ++i)
+      {
+        float &x = params[p].data()[i];
+        const float saved = x;
+
+        x = saved + eps;
+        Tape plus;
+        const VarId lp = build(plus).second;
+        const float up = plus.value(lp).data()[0];
+
+        x = saved - eps;
+        Tape minus;
+        const VarId lm = build(minus).second;
+        const float down = minus.value(lm).data()[0];
+        x = saved;
+
+        const float numeric = (up - down) / (2 * eps);
+        EXPECT_NEAR(gradient.data()[i], numeric, 2e-3f + 2e-2f * std::fabs(numeric))
+            << "parameter " << p << " element " << i;
+      }
+    }
+  }
+
+  TEST_F(TapeTest, ActivationsUseTheirDerivatives)
+  {
+    const auto x = random({257}, -3.0f, 3.0f);
+
+    for (Activation activation : {Activation::Relu, Activation::LeakyRelu, Activation::Sigmoid, Activation::Tanh})
+    {
+      Tape tape;
+      const VarId in = tape.variable(x);
+      tape.backward(tape.sum(tape.activation(activation, in, 0.1f)));
+
+      const float *g = tape.gradient(in).data();
+      for (int64_t i = 0; i < x.num_elements(); ++i)
+      {
+        const float v = x.data()[i];
+        float expected = 0.0f;
+        switch (activation)
+        {
+        case Activation::Relu:
+          expected = tf::math::relu_derivative(v);
+          break;
+        case Activation::LeakyRelu:
+          expected = tf::math::leaky_relu_derivative(v, 0.1f);
+          break;
+        case Activation::Sigmoid:
+          expected = tf::math::sigmoid_derivative(v);
+          break;
+        default:
+          expected = tf::math::tanh_derivative(v);
+          break;
+        }
+        ASSERT_NEAR(g[i], expected, 1e-6f);
+      }
+    }
+  }
+
+  TEST_F(TapeTest, CheckpointingRecomputesAndSavesMemory)
+  {
+    const auto x = random({16, 32});
+    std::vector<TensorView<float>> weights;
+    for (int layer = 0; layer < 8; ++layer)
+      weights.push_back(random({32, 32}, -0.3f, 0.3f));
+
+    std::vector<std::vector<float>> gradients[2];
+    size_t resident[2];
+    for (int checkpoint = 0; checkpoint < 2; ++checkpoint)
+    {
+      Tape tape;
+      const VarId in = tape.variable(x, false);
+      std::vector<VarId> w;
+      for (const auto &weight : weights)
+        w.push_back(tape.variable(weight));
+
+      const VarId loss = deep(tape, in, w, checkpoint == 1);
+      resident[checkpoint] = tape.resident_bytes();
+      tape.backward(loss);
+
+      for (VarId id : w)
+      {
+        const TensorView<float> &g = tape.gradient(id);
+        gradients[checkpoint].emplace_back(g.data(), g.data() + g.num_elements());
+      }
+
+      // Backward gives the recomputed segments back again
+      EXPECT_EQ(tape.resident_bytes(), resident[checkpoint]);
+      if (checkpoint == 1)
+      {
+        // Reading a released product recomputes it
+        const VarId product = w.back() + 1;
+        ASSERT_EQ(tape.op(product), TapeOp::MatMul);
+        EXPECT_EQ(tape.value(product).shape(), Shape({16, 32}));
+        EXPECT_GT(tape.resident_bytes(), resident[1]);
+      }
+    }
+
+    // A checkpointed layer keeps only what backward() needs from outside
+    // it, its output and saved derivative, instead of its product too
+    const size_t layer = 16 * 32 * sizeof(float);
+    EXPECT_EQ(resident[0], 8 * 3 * layer + sizeof(float));
+    EXPECT_EQ(resident[1], 8 * 2 * layer + sizeof(float));
+    for (size_t i = 0; i < weights.size(); ++i)
+      for (size_t j = 0; j < gradients[0][i].size(); ++j)
+        ASSERT_FLOAT_EQ(gradients[1][i][j], gradients[0][i][j]);
+  }
+
+  TEST_F(TapeTest, AccumulatesIntoCallerBuffers)
+  {
+    const auto w = random({6, 3});
+    const auto b = random({3});
+    const std::vector<TensorView<float>> batches = {random({4, 6}), random({4, 6})};
+
+    auto step = [&](Tape &tape, const TensorView<float> &batch) -> std::pair<VarId, VarId>
+    {
+      const VarId vw = tape.variable(w);
+      const VarId vb = tape.variable(b);
+      const VarId y = tape.activation(Activation::Sigmoid, tape.add(tape.matmul(tape.variable(batch, false), vw), vb));
+      tape.backward(tape.mean(y));
+      return {vw, vb};
+    };
+
+    // Reference: each micro-batch on its own
+    std::vector<float> expected_w(18, 0.0f), expected_b(3, 0.0f);
+    for (const auto &batch : batches)
+    {
+      Tape tape;
+      const auto [vw, vb] = step(tape, batch);
+      for (size_t i = 0; i < 18; ++i)
+        expected_w[i] += tape.gradient(vw).data()[i];
+      for (size_t i = 0; i < 3; ++i)
+        expected_b[i] += tape.gradient(vb).data()[i];
+    }
+
+    auto gw = zeros({6, 3});
+    auto gb = zeros({3});
+    Tape tape;
+    for (const auto &batch : batches)
+    {
+      tape.clear();
+      const VarId vw = tape.variable(w);
+      const VarId vb = tape.variable(b);
+      tape.accumulate_into(vw, gw);
+      tape.accumulate_into(vb, gb);
+      const VarId y = tape.activation(Activation::Sigmoid, tape.add(tape.matmul(tape.variable(batch, false), vw), vb));
+      tape.backward(tape.mean(y));
+      EXPECT_EQ(tape.gradient(vw).data(), gw.data());
+    }
+
+    for (size_t i = 0; i < 18; ++i)
+      EXPECT_NEAR(gw.data()[i], expected_w[i], 1e-6f);
+    for (size_t i = 0; i < 3; ++i)
+      EXPECT_NEAR(gb.data()[i], expected_b[i], 1e-6f);
+  }
+
+  TEST_F(TapeTest, ReusesBuffersAcrossSteps)
+  {
+    const auto x = random({8, 16});
+    std::vector<TensorView<float>> weights = {random({16, 16}), random({16, 16}), random({16, 16})};
+
+    Tape tape;
+    size_t pooled = 0;
+    for (int step = 0; step < 3; ++step)
+    {
+      tape.clear();
+      const VarId in = tape.variable(x, false);
+      std::vector<VarId> w;
+      for (const auto &weight : weights)
+        w.push_back(tape.variable(weight));
+      tape.backward(deep(tape, in, w, step == 2));
+
+      if (step == 0)
+        pooled = tape.pooled_bytes();
+      EXPECT_EQ(tape.pooled_bytes(), pooled);
+    }
+  }
+
+  TEST_F(TapeTest, RejectsInvalidUse)
+  {
+    Tape tape;
+    const VarId a = tape.variable(random({2, 3}));
+    const VarId b = tape.variable(random({2, 3}));
+    const VarId c = tape.add(a, b);
+
+    EXPECT_THROW(tape.matmul(a, b), tf::core::ShapeError);
+    EXPECT_THROW(tape.add(a, tape.variable(random({2}))), tf::core::ShapeError);
+    EXPECT_THROW(tape.activation(Activation::Identity, a), tf::core::ValueError);
+    EXPECT_THROW(tape.sum(100), tf::core::IndexError);
+    EXPECT_THROW(tape.backward(c), tf::core::ShapeError);
+    EXPECT_THROW(tape.accumulate_into(c, zeros({2, 3})), tf::core::IndexError);
+    EXPECT_THROW(tape.accumulate_into(a, zeros({3, 2})), tf::core::ShapeError);
+    EXPECT_THROW(tape.end_checkpoint(), tf::core::ValueError);
+
+    tape.begin_checkpoint();
+    EXPECT_THROW(tape.begin_checkpoint(), tf::core::ValueError);
+    tape.end_checkpoint();
+
+    // Values the loss does not depend on get no gradient
+    const VarId loss = tape.sum(a);
+    tape.backward(loss);
+    EXPECT_EQ(tape.gradient(b).buffer(), nullptr);
+    EXPECT_EQ(tape.gradient(a).num_elements(), 6);
+  }
+
+  TEST_F(TapeTest, BuffersOutliveArenaScopes)
+  {
+    const auto x = random({8, 16});
+    std::vector<TensorView<float>> weights = {random({16, 16}), random({16, 16})};
+
+    Tape tape;
+    std::vector<VarId> w;
+    std::vector<std::vector<float>> expected;
+    {
+      tf::utils::ArenaScope scope;
+      const VarId in = tape.variable(x.transpose().transpose(), false);
+      for (const auto &weight : weights)
+        w.push_back(tape.variable(weight));
+      tape.backward(deep(tape, in, w, false));
+
+      for (VarId id : w)
+      {
+        const TensorView<float> &g = tape.gradient(id);
+        expected.emplace_back(g.data(), g.data() + g.num_elements());
+      }
+    }
+
+    // The rewound arena is handed out again and overwritten
+    {
+      tf::utils::ArenaScope scope;
+      auto scratch = TensorView<float>::allocate({64, 64});
+      std::fill_n(scratch.data(), scratch.num_elements(), 12345.0f);
+    }
+
+    for (size_t i = 0; i < w.size(); ++i)
+      for (size_t j = 0; j < expected[i].size(); ++j)
+        ASSERT_EQ(tape.gradient(w[i]).data()[j], expected[i][j]);
+
+    // Reusing the pooled buffers gives the same gradients
+    tape.clear();
+    const VarId in = tape.variable(x, false);
+    w.clear();
+    for (const auto &weight : weights)
+      w.push_back(tape.variable(weight));
+    tape.backward(deep(tape, in, w, false));
+    for (size_t i = 0; i < w.size(); ++i)
+      for (size_t j = 0; j < expected[i].size(); ++j)
+        ASSERT_FLOAT_EQ(tape.gradient(w[i]).data()[j], expected[i][j]);
+  }
+} // namespace test
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <tf/core/common.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <tf/utils/checkpoint.hpp>
+#include <tf/utils/tensor_stream.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace tf::utils;
+using tf::core::Shape;
+using tf::core::TensorView;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for streaming tests: a checkpoint with 103 rows of
+   * features (row r holding 4 * r .. 4 * r + 3) and labels (r)
+   *
+   */
+  class TensorStreamTest : public ::testing::Test
+  {
+  protected:
+    static constexpr size_t ROWS = 103;
+
+    void SetUp() override
+    {
+      const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+      path = (std::filesystem::temp_directory_path() /
+              (std::string("tf_") + info->name() + "_" + std::to_string(::getpid()) + ".ckpt"))
+                 .string();
+    }
+
+    void TearDown() override
+    {
+      std::filesystem::remove(path);
+    }
+
+    void write(const CompressionOptions &compression = {}) const
+    {
+      auto features = TensorView<float>::allocate({ROWS, 4});
+      auto labels = TensorView<std::int64_t>::allocate({ROWS});
+      for (size_t i = 0; i < ROWS * 4; ++i)
+        features.data()[i] = static_cast<float>(i);
+      for (size_t i = 0; i < ROWS; ++i)
+        labels.data()[i] = static_cast<std::int64_t>(i);
+
+      CheckpointWriter writer;
+      writer.add("features", features, compression);
+      writer.add("labels", labels, compression);
+      writer.add("other", TensorView<float>::allocate({5}));
+      writer.save(path);
+    }
+
+    /**
+     * @brief Streams every batch and checks it holds the expected rows
+     */
+    static void expect_pass(TensorStream &stream, size_t batch_size, size_t batches)
+    {
+      size_t row = 0;
+      size_t count = 0;
+      while (std::optional<StreamBatch> batch = stream.next())
+      {
+        EXPECT_EQ(batch->index(), count);
+        EXPECT_EQ(batch->first_row(), row);
+        EXPECT_EQ(batch->size(), 2u);
+
+        const auto features = batch->get<float>(0);
+        const auto labels = batch->get<std::int64_t>(1);
+        EXPECT_EQ(features.shape(), Shape({static_cast<tf::core::index_t>(batch->rows()), 4}));
+        EXPECT_EQ(labels.shape(), Shape({static_cast<tf::core::index_t>(batch->rows())}));
+        EXPECT_LE(batch->rows(), batch_size);
+
+        for (size_t r = 0; r < batch->rows(); ++r)
+        {
+          ASSERT_EQ(labels.data()[r], static_cast<std::int64_t>(row + r));
+          ASSERT_EQ(features.data()[r * 4 + 3], static_cast<float>((row + r) * 4 + 3));
+        }
+
+        row += batch->rows();
+        ++count;
+      }
+
+      EXPECT_EQ(count, batches);
+      EXPECT_FALSE(stream.next().has_value());
+    }
+
+    std::string path;
+  };
+
+  TEST_F(TensorStreamTest, StreamsBatchesInOrder)
+  {
+    write();
+
+    for (size_t threads : {1, 3})
+      for (size_t buffers : {1, 2, 4})
+      {
+        StreamOptions options;
+        options.batch_size = 10;
+        options.buffers = buffers;
+        options.io_threads = threads;
+
+        TensorStream stream(path, {"features", "labels"}, options);
+        EXPECT_EQ(stream.num_rows(), ROWS);
+        EXPECT_EQ(stream.num_batches(), 11u);
+        EXPECT_EQ(stream.entries()[1].name, "labels");
+        expect_pass(stream, 10, 11);
+      }
+  }
+
+  TEST_F(TensorStreamTest, DropsTheLastPartialBatch)
+  {
+    write();
+
+    StreamOptions options;
+    options.batch_size = 25;
+    options.drop_last = true;
+    TensorStream stream(path, {"features", "labels"}, options);
+    EXPECT_EQ(stream.num_batches(), 4u);
+    expect_pass(stream, 25, 4);
+  }
+
+  TEST_F(TensorStreamTest, ResetRestartsAndReusesBuffers)
+  {
+    write();
+
+    StreamOptions options;
+    options.batch_size = 16;
+    TensorStream stream(path, {"features", "labels"}, options);
+
+    // Leave the pass half-way, with a batch still alive
+    std::optional<StreamBatch> kept = stream.next();
+    ASSERT_TRUE(kept.has_value());
+    const auto labels = kept->get<std::int64_t>(1);
+    stream.next();
+
+    stream.reset();
+    EXPECT_EQ(labels.data()[15], 15);
+    kept.reset();
+
+    expect_pass(stream, 16, 7);
+    stream.reset();
+    expect_pass(stream, 16, 7);
+  }
+
+  TEST_F(TensorStreamTest, HoldingEveryBufferThrows)
+  {
+    write();
+
+    StreamOptions options;
+    options.batch_size = 8;
+    options.buffers = 2;
+    TensorStream stream(path, {"labels"}, options);
+
+    std::optional<StreamBatch> first = stream.next();
+    std::optional<StreamBatch> second = stream.next();
+    ASSERT_TRUE(first && second);
+    EXPECT_THROW(stream.next(), tf::core::ValueError);
+
+    // Releasing one lets the stream continue where it was
+    first.reset();
+    std::optional<StreamBatch> third = stream.next();
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->get<std::int64_t>(0).data()[0], 16);
+  }
+
+  TEST_F(TensorStreamTest, DecompressesBlocksOnTheIoThreads)
+  {
+    for (Compression codec : {Compression::LZ4, Compression::Zstd})
+    {
+      if (!compression_available(codec))
+        continue;
+
+      // Blocks smaller than, larger than and equal to the batches
+      for (size_t block_rows : {3, 10, 40})
+      {
+        write({codec, block_rows, 0});
+
+        for (size_t threads : {1, 2})
+        {
+          StreamOptions options;
+          options.batch_size = 10;
+          options.io_threads = threads;
+          TensorStream stream(path, {"features", "labels"}, options);
+          expect_pass(stream, 10, 11);
+        }
+      }
+    }
+  }
+
+  TEST_F(TensorStreamTest, RejectsInvalidStreams)
+  {
+    write();
+
+    EXPECT_THROW(TensorStream(path, {}), tf::core::ValueError);
+    EXPECT_THROW(TensorStream(path, {"missing"}), tf::core::IndexError);
+    EXPECT_THROW(TensorStream(path, {"features", "other"}), tf::core::ShapeError);
+    EXPECT_THROW(TensorStream(path + ".missing", {"features"}), tf::core::IOError);
+
+    StreamOptions options;
+    options.batch_size = 0;
+    EXPECT_THROW(TensorStream(path, {"features"}, options), tf::core::ValueError);
+    EXPECT_THROW(StreamBatch().get<float>(0), tf::core::IndexError);
+
+    TensorStream stream(path, {"labels"});
+    EXPECT_THROW(stream.next()->get<float>(0), tf::core::TypeError);
+  }
+} // namespace test
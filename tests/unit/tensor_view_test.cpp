@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <tf/core/config.hpp>
+#include <tf/core/tensor_view.hpp>
+#include <numeric>
+#include <vector>
+
+using namespace tf::core;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for tensor view tests.
+   *
+   * Provides a dense (2, 3, 4) tensor holding 0, 1, ..., 23.
+   */
+  class TensorViewTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      tensor = TensorView<int>::allocate(Shape({2, 3, 4}));
+      std::iota(tensor.data(), tensor.data() + 24, 0);
+    }
+
+    static std::vector<int> values(const TensorView<int> &view)
+    {
+      std::vector<int> result(static_cast<size_t>(view.num_elements()));
+      view.copy_to(result.data());
+      return result;
+    }
+
+    TensorView<int> tensor;
+  };
+
+  TEST_F(TensorViewTest, DenseLayout)
+  {
+    EXPECT_EQ(tensor.strides(), (shape_t{12, 4, 1}));
+    EXPECT_TRUE(tensor.is_contiguous());
+    EXPECT_TRUE(tensor.is_inner_contiguous());
+    EXPECT_EQ(tensor(1, 2, 3), 23);
+    EXPECT_EQ(tensor.at({1, 0, 2}), 14);
+
+    EXPECT_THROW(tensor.at({2, 0, 0}), IndexError);
+    EXPECT_THROW(tensor.at({0, 0}), IndexError);
+    EXPECT_THROW(TensorView<int>(tensor.buffer(), Shape({2, 3}), shape_t{1}), ShapeError);
+    EXPECT_THROW(TensorView<int>(tensor.buffer(), Shape({2}), shape_t{-1}), ValueError);
+  }
+
+  TEST_F(TensorViewTest, ViewsShareTheBuffer)
+  {
+    TensorView<int> t = tensor.transpose();
+    EXPECT_EQ(t.shape(), Shape({2, 4, 3}));
+    EXPECT_EQ(t.buffer(), tensor.buffer());
+    EXPECT_FALSE(t.is_contiguous());
+    EXPECT_EQ(t(1, 3, 2), tensor(1, 2, 3));
+
+    // Writes through a view are visible in the original
+    t(0, 1, 2) = -1;
+    EXPECT_EQ(tensor(0, 2, 1), -1);
+
+    TensorView<int> p = tensor.permute({2, 0, 1});
+    EXPECT_EQ(p.shape(), Shape({4, 2, 3}));
+    EXPECT_EQ(p(3, 1, 2), tensor(1, 2, 3));
+    EXPECT_THROW(tensor.permute({0, 0, 1}), ValueError);
+
+    TensorView<int> s = tensor.slice(2, 1, 4, 2);
+    EXPECT_EQ(s.shape(), Shape({2, 3, 2}));
+    EXPECT_EQ(s(1, 1, 1), tensor(1, 1, 3));
+    EXPECT_FALSE(s.is_inner_contiguous());
+    EXPECT_THROW(tensor.slice(2, 1, 5), IndexError);
+    EXPECT_THROW(tensor.slice(2, 0, 4, 0), ValueError);
+
+    TensorView<int> row = tensor.select(0, 1).select(0, 2);
+    EXPECT_EQ(row.shape(), Shape({4}));
+    EXPECT_EQ(values(row), (std::vector<int>{20, 21, 22, 23}));
+  }
+
+  TEST_F(TensorViewTest, BroadcastUsesZeroStrides)
+  {
+    TensorView<int> bias = tensor.select(0, 0).select(0, 1); // (4,): 4 5 6 7
+    TensorView<int> b = bias.broadcast_to(Shape({3, 4}));
+    EXPECT_EQ(b.strides(), (shape_t{0, 1}));
+    EXPECT_EQ(values(b), (std::vector<int>{4, 5, 6, 7, 4, 5, 6, 7, 4, 5, 6, 7}));
+
+    TensorView<int> column = tensor.slice(2, 0, 1).broadcast_to(Shape({2, 3, 2}));
+    EXPECT_EQ(values(column), (std::vector<int>{0, 0, 4, 4, 8, 8, 12, 12, 16, 16, 20, 20}));
+
+    EXPECT_THROW(tensor.broadcast_to(Shape({2, 3, 5})), ShapeError);
+  }
+
+  TEST_F(TensorViewTest, ContiguousCopiesOnlyWhenNeeded)
+  {
+    TensorView<int> same = tensor.contiguous();
+    EXPECT_EQ(same.buffer(), tensor.buffer());
+
+    TensorView<int> t = tensor.transpose().contiguous();
+    EXPECT_NE(t.buffer(), tensor.buffer());
+    EXPECT_TRUE(t.is_contiguous());
+    for (int i = 0; i < 2; ++i)
+      for (int j = 0; j < 4; ++j)
+        for (int k = 0; k < 3; ++k)
+          EXPECT_EQ(t(i, j, k), tensor(i, k, j));
+
+    // Contiguous views reshape in place, others through a copy
+    EXPECT_EQ(tensor.reshape(Shape({6, 4})).buffer(), tensor.buffer());
+    TensorView<int> r = tensor.transpose().reshape(Shape({24}));
+    EXPECT_EQ(r(1), tensor(0, 1, 0));
+    EXPECT_THROW(tensor.reshape(Shape({5, 5})), ShapeError);
+  }
+
+  TEST(TensorViewCopyTest, LargeStridedCopiesMatchElementwise)
+  {
+    const int threads = config().num_threads();
+    config().set_num_threads(4);
+
+    // Large enough to run in parallel through every copy path
+    const index_t rows = 300, cols = 517;
+    auto matrix = TensorView<float>::allocate(Shape({rows, cols}));
+    for (index_t i = 0; i < rows * cols; ++i)
+      matrix.data()[i] = static_cast<float>(i);
+
+    const TensorView<float> views[] = {
+        matrix.transpose(),                              // tiled transpose
+        matrix.slice(1, 3, cols - 2),                    // dense rows
+        matrix.slice(0, 1, rows, 3).slice(1, 0, cols, 2) // strided rows
+    };
+
+    for (const TensorView<float> &view : views)
+    {
+      std::vector<float> out(static_cast<size_t>(view.num_elements()));
+      view.copy_to(out.data());
+
+      size_t n = 0;
+      for (index_t i = 0; i < view.dim(0); ++i)
+        for (index_t j = 0; j < view.dim(1); ++j)
+          ASSERT_EQ(out[n++], view(i, j)) << view.shape().to_string() << " " << i << " " << j;
+    }
+
+    config().set_num_threads(threads);
+  }
+
+  TEST(TensorViewCopyTest, CollapsesContiguousDimensions)
+  {
+    shape_t dims = {2, 1, 3, 4}, strides = {12, 7, 4, 1};
+    detail::collapse_dims(dims, strides);
+    EXPECT_EQ(dims, (shape_t{24}));
+    EXPECT_EQ(strides, (shape_t{1}));
+
+    // A row slice keeps the row stride
+    dims = {5, 3, 4};
+    strides = {24, 4, 1};
+    detail::collapse_dims(dims, strides);
+    EXPECT_EQ(dims, (shape_t{5, 12}));
+    EXPECT_EQ(strides, (shape_t{24, 1}));
+  }
+} // namespace test
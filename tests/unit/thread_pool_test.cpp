@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <tf/core/config.hpp>
+#include <tf/core/thread_pool.hpp>
+#include <tf/math/utils.hpp>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace tf::core;
+
+namespace test
+{
+  /**
+   * @brief Test fixture for the thread pool
+   *
+   */
+  class ThreadPoolTest : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      config().set_num_threads(4);
+    }
+
+    void TearDown() override
+    {
+      config().set_num_threads(4);
+    }
+  };
+
+  TEST_F(ThreadPoolTest, FollowsConfiguredThreadCount)
+  {
+    EXPECT_EQ(thread_pool().num_threads(), 4u);
+
+    config().set_num_threads(2);
+    EXPECT_EQ(thread_pool().num_threads(), 2u);
+
+    config().set_num_threads(1);
+    EXPECT_EQ(thread_pool().num_threads(), 1u);
+  }
+
+  TEST_F(ThreadPoolTest, ParallelForVisitsEveryIndexOnce)
+  {
+    std::vector<std::atomic<int>> hits(10007);
+
+    parallel_for(0, hits.size(), 16, [&](size_t begin, size_t end)
+                 {
+                   EXPECT_LT(begin, end);
+                   for (size_t i = begin; i < end; ++i)
+                     hits[i].fetch_add(1);
+                 });
+
+    for (size_t i = 0; i < hits.size(); ++i)
+      ASSERT_EQ(hits[i].load(), 1) << "at " << i;
+  }
+
+  TEST_F(ThreadPoolTest, RespectsGrainSize)
+  {
+    std::atomic<size_t> chunks{0};
+
+    parallel_for(0, 1000, 400, [&](size_t begin, size_t end)
+                 {
+                   EXPECT_TRUE(end - begin >= 400 || end == 1000);
+                   chunks.fetch_add(1);
+                 });
+
+    EXPECT_LE(chunks.load(), 3u);
+
+    // A range within the grain runs inline as a single chunk
+    chunks = 0;
+    parallel_for(5, 100, 1000, [&](size_t begin, size_t end)
+                 {
+                   EXPECT_EQ(begin, 5u);
+                   EXPECT_EQ(end, 100u);
+                   chunks.fetch_add(1);
+                 });
+    EXPECT_EQ(chunks.load(), 1u);
+  }
+
+  TEST_F(ThreadPoolTest, NestedLoopsComplete)
+  {
+    std::atomic<size_t> total{0};
+
+    parallel_for(0, 64, 1, [&](size_t begin, size_t end)
+                 {
+                   for (size_t i = begin; i < end; ++i)
+                     parallel_for(0, 1000, 10, [&](size_t b, size_t e)
+                                  { total.fetch_add(e - b); });
+                 });
+
+    EXPECT_EQ(total.load(), 64u * 1000u);
+  }
+
+  TEST_F(ThreadPoolTest, InlineLoopsDoNotResizeThePool)
+  {
+    config().set_num_threads(1);
+    ASSERT_EQ(thread_pool().num_threads(), 1u);
+
+    // The single chunk runs inline and still counts as a parallel region,
+    // so a thread count change inside it takes effect only afterwards
+    std::atomic<size_t> total{0};
+    parallel_for(0, 16, 1, [&](size_t begin, size_t end)
+                 {
+                   config().set_num_threads(3);
+                   EXPECT_EQ(thread_pool().num_threads(), 1u);
+                   EXPECT_TRUE(ThreadPool::in_parallel_region());
+
+                   parallel_for(begin, end, 1, [&](size_t b, size_t e)
+                                { total.fetch_add(e - b); }); });
+
+    EXPECT_EQ(total.load(), 16u);
+    EXPECT_FALSE(ThreadPool::in_parallel_region());
+    EXPECT_EQ(thread_pool().num_threads(), 3u);
+  }
+
+  TEST_F(ThreadPoolTest, PropagatesExceptions)
+  {
+    EXPECT_THROW(parallel_for(0, 1000, 1, [](size_t begin, size_t end)
+                              {
+                                if (begin <= 500 && 500 < end)
+                                  throw std::runtime_error("chunk failed");
+                              }),
+                 std::runtime_error);
+
+    // The pool stays usable afterwards
+    std::atomic<size_t> total{0};
+    parallel_for(0, 1000, 1, [&](size_t begin, size_t end)
+                 { total.fetch_add(end - begin); });
+    EXPECT_EQ(total.load(), 1000u);
+  }
+
+  TEST_F(ThreadPoolTest, ParallelReduceMatchesSerial)
+  {
+    std::vector<long long> values(100003);
+    std::iota(values.begin(), values.end(), -50000);
+    long long expected = std::accumulate(values.begin(), values.end(), 0LL);
+
+    long long sum = parallel_reduce(
+        0, values.size(), 64, 0LL,
+        [&](size_t begin, size_t end)
+        { return std::accumulate(values.begin() + begin, values.begin() + end, 0LL); },
+        [](long long a, long long b)
+        { return a + b; });
+
+    EXPECT_EQ(sum, expected);
+    EXPECT_EQ(parallel_reduce(3, 3, 1, 7LL, [](size_t, size_t)
+                              { return 1LL; },
+                              [](long long a, long long b)
+                              { return a + b; }),
+              7LL);
+  }
+
+  TEST_F(ThreadPoolTest, LargeStatisticsReductions)
+  {
+    // Above the reduction grain, so the statistics run in parallel
+    std::vector<double> x(200000), y(200000);
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      x[i] = static_cast<double>(i % 100);
+      y[i] = 2.0 * x[i] + 1.0;
+    }
+
+    EXPECT_NEAR(tf::math::mean(x.begin(), x.end()), 49.5, 1e-9);
+    EXPECT_NEAR(tf::math::variance(x.begin(), x.end()), 833.25 * 200000.0 / 199999.0, 1e-6);
+    EXPECT_NEAR(tf::math::correlation(x.begin(), x.end(), y.begin(), y.end()), 1.0, 1e-12);
+  }
+} // namespace test
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include <tf/core/types.hpp>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 using namespace tf::core;
 
@@ -28,6 +32,85 @@ namespace test
                               bool>::value));
   }
 
+  TEST(TypesTest, ReducedPrecisionTraits)
+  {
+    EXPECT_EQ(std::string(DataTypeTraits<DataType::BFloat16>::name), "bfloat16");
+    EXPECT_TRUE((std::is_same<DataTypeTraits<DataType::BFloat16>::type,
+                              BFloat16>::value));
+
+    EXPECT_EQ(std::string(DataTypeTraits<DataType::Float16>::name), "float16");
+    EXPECT_TRUE((std::is_same<DataTypeTraits<DataType::Float16>::type,
+                              Float16>::value));
+
+    EXPECT_EQ(std::string(DataTypeTraits<DataType::Int8>::name), "int8");
+    EXPECT_TRUE((std::is_same<DataTypeTraits<DataType::Int8>::type,
+                              std::int8_t>::value));
+
+    static_assert(sizeof(BFloat16) == 2 && sizeof(Float16) == 2);
+    static_assert(std::is_trivially_copyable_v<BFloat16> && std::is_trivially_copyable_v<Float16>);
+  }
+
+  TEST(TypesTest, ElementSizesAndTypes)
+  {
+    static_assert(size_of(DataType::Float64) == sizeof(double));
+    static_assert(size_of(DataType::Int32) == sizeof(std::int32_t));
+    static_assert(size_of(DataType::BFloat16) == sizeof(BFloat16));
+    static_assert(size_of(DataType::Bool) == sizeof(bool));
+    static_assert(size_of(DataType::Int8) == 1);
+    EXPECT_EQ(size_of(static_cast<DataType>(100)), 0u);
+
+    static_assert(data_type_of<float>() == DataType::Float32);
+    static_assert(data_type_of<std::int64_t>() == DataType::Int64);
+    static_assert(data_type_of<Float16>() == DataType::Float16);
+    static_assert(data_type_of<std::int8_t>() == DataType::Int8);
+  }
+
+  TEST(TypesTest, BFloat16RoundsToNearestEven)
+  {
+    static_assert(BFloat16(1.0f).bits == 0x3f80);
+    static_assert(static_cast<float>(BFloat16::from_bits(0xc040)) == -3.0f);
+
+    // 1 + 2^-8 is halfway between 1 and 1 + 2^-7: ties go to the even 1
+    EXPECT_EQ(static_cast<float>(BFloat16(1.0f + 0x1p-8f)), 1.0f);
+    EXPECT_EQ(static_cast<float>(BFloat16(1.0f + 3 * 0x1p-8f)), 1.0f + 0x1p-6f);
+    EXPECT_EQ(static_cast<float>(BFloat16(1.0f + 0x1p-8f + 0x1p-20f)), 1.0f + 0x1p-7f);
+
+    EXPECT_TRUE(std::isinf(static_cast<float>(BFloat16(std::numeric_limits<float>::infinity()))));
+    EXPECT_TRUE(std::isinf(static_cast<float>(BFloat16(std::numeric_limits<float>::max()))));
+    EXPECT_TRUE(std::isnan(static_cast<float>(BFloat16(std::numeric_limits<float>::quiet_NaN()))));
+    // A NaN whose payload sits in the dropped bits stays NaN
+    EXPECT_TRUE(std::isnan(static_cast<float>(BFloat16(std::bit_cast<float>(0x7f800001u)))));
+    EXPECT_EQ(BFloat16(-0.0f).bits, 0x8000);
+  }
+
+  TEST(TypesTest, Float16ConvertsEveryValue)
+  {
+    static_assert(Float16(1.0f).bits == 0x3c00);
+    static_assert(static_cast<float>(Float16::from_bits(0x7bff)) == 65504.0f);
+
+    // Every half, subnormals included, widens exactly and rounds back
+    for (std::uint32_t bits = 0; bits <= 0xffff; ++bits)
+    {
+      const Float16 h = Float16::from_bits(static_cast<std::uint16_t>(bits));
+      const float f = h;
+      if (std::isnan(f))
+      {
+        EXPECT_EQ((bits >> 10) & 0x1f, 0x1fu);
+        EXPECT_TRUE(std::isnan(static_cast<float>(Float16(f))));
+        continue;
+      }
+      ASSERT_EQ(Float16(f).bits, bits) << bits;
+    }
+
+    EXPECT_EQ(static_cast<float>(Float16::from_bits(0x0001)), 0x1p-24f);
+    EXPECT_EQ(static_cast<float>(Float16(0x1p-25f)), 0.0f);        // tie to even 0
+    EXPECT_EQ(static_cast<float>(Float16(0x1p-25f * 3)), 0x1p-23f); // tie to even 2
+    EXPECT_EQ(static_cast<float>(Float16(65519.0f)), 65504.0f);
+    EXPECT_TRUE(std::isinf(static_cast<float>(Float16(65520.0f))));
+    EXPECT_EQ(static_cast<float>(Float16(1.0f + 0x1p-11f)), 1.0f);
+    EXPECT_EQ(static_cast<float>(Float16(1.0f + 0x1p-11f + 0x1p-20f)), 1.0f + 0x1p-10f);
+  }
+
   TEST(TypesTest, ShapeType)
   {
     shape_t shape{1, 2, 3};